@@ -4,8 +4,14 @@
 #include "esp_log.h"
 #include "esp_camera.h"
 #include "esp_timer.h"
+#include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "jpeg_dc.h"
+#include "metrics.h"
 #include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
 
 // Configuración de pines del ESP32-CAM
 #define CAM_PIN_PWDN    32 
@@ -29,13 +35,210 @@
 static const char *TAG = "CAMERA_MANAGER";
 
 // Variables privadas del módulo
-static camera_fb_t *current_photo = NULL;
-static SemaphoreHandle_t photo_mutex = NULL;
 static camera_info_t camera_info = {0};
 static QueueHandle_t server_queue = NULL;
+static camera_preroll_config_t preroll_config = CAMERA_PREROLL_DEFAULT_CONFIG();
+static volatile bool preroll_running = false;
+static uint64_t next_preroll_time = 0;
+static TaskHandle_t capture_task_handle = NULL;
+static volatile bool capture_running = false;
+static SemaphoreHandle_t camera_lock = NULL;  // Acceso exclusivo al driver de la cámara
+static rate_control_t rate_ctl;                // Solo lo toca la tarea de captura (con camera_lock)
+static bool rate_control_active = false;
+static rate_control_stats_t rate_stats = {0};  // Copia para lectores de otras tareas
+static portMUX_TYPE rate_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static sensor_profile_state_t profile_state;    // Último estado escrito en el sensor (con camera_lock)
+static sensor_profile_stats_t profile_stats = {0};  // Copia para lectores de otras tareas
+static portMUX_TYPE profile_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static day_night_t day_night;                   // Solo lo toca la tarea día/noche
+static day_night_stats_t day_night_stats = {0}; // Copia para lectores de otras tareas
+static portMUX_TYPE day_night_lock = portMUX_INITIALIZER_UNLOCKED;  // Protege day_night_stats y luma_sample
+static TaskHandle_t day_night_task_handle = NULL;
+static volatile bool day_night_running = false;
+static uint64_t luma_sample_interval_us = 0;    // Fijo mientras el planificador está activo
+static uint64_t next_luma_sample = 0;           // Con camera_lock
+static frame_dedupe_t dedupe;                   // Solo lo toca la tarea de captura (con camera_lock)
+static bool dedupe_active = false;
+static frame_dedupe_stats_t dedupe_stats = {0}; // Copia para lectores de otras tareas
+static portMUX_TYPE dedupe_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static capture_tier_state_t tier_state;         // Solo lo toca la tarea de captura (con camera_lock)
+static bool tier_enabled = false;
+static volatile bool tier_wake = false;         // Actividad pendiente de registrar por la tarea de captura
+static capture_tier_stats_t tier_stats = {0};   // Copia para lectores de otras tareas
+static portMUX_TYPE tier_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static framesize_t init_frame_size;             // Los buffers del driver se dimensionan con esta resolución
 
-// Función privada para enviar eventos al servidor
-static esp_err_t send_server_event(const char* reason, size_t photo_size) {
+// Última luminancia medida por la tarea de captura para el planificador
+static struct {
+    float luma;
+    int64_t time;             // Epoch en segundos
+    uint32_t count;           // Cambia con cada muestra nueva
+} luma_sample = {0};
+
+#define CAPTURE_TASK_STACK      4096
+#define CAPTURE_TASK_PRIORITY   6    // Por encima del servidor web, por debajo del sensor
+#define CAPTURE_MAX_BATCH       8
+#define CAPTURE_RETRIES         3
+#define BURST_MAX_FRAMES        8
+#define BURST_MAX_KEEP          2    // Slots del almacén retenidos durante la ráfaga
+#define WALL_CLOCK_VALID_SEC    1577836800  // 2020-01-01: antes el reloj no está sincronizado
+#define DAY_NIGHT_TASK_STACK    4096
+#define DAY_NIGHT_TASK_PRIORITY 2    // Por debajo del servidor web: decide cada minuto
+
+static size_t frame_slot_size = 0;
+static uint8_t thumb_quality = JPEG_THUMB_DEFAULT_QUALITY;
+
+static void capture_task(void *pvParameters);
+
+// Métricas de /metrics: etapas de la captura y entrega de eventos al servidor web
+#define CAPTURE_STAGE_NAME      "coop_capture_stage_seconds"
+#define CAPTURE_STAGE_HELP      "Duración de cada etapa de la captura en la tarea de la cámara"
+
+static metric_histogram_t stage_sensor = METRIC_HISTOGRAM_INIT(CAPTURE_STAGE_NAME, CAPTURE_STAGE_HELP, "stage=\"sensor\"");
+static metric_histogram_t stage_store = METRIC_HISTOGRAM_INIT(CAPTURE_STAGE_NAME, CAPTURE_STAGE_HELP, "stage=\"store\"");
+static metric_histogram_t stage_burst = METRIC_HISTOGRAM_INIT(CAPTURE_STAGE_NAME, CAPTURE_STAGE_HELP, "stage=\"burst\"");
+static metric_histogram_t take_photo_latency = METRIC_HISTOGRAM_INIT("coop_camera_take_photo_seconds",
+    "Duración de camera_manager_take_photo() (cola, captura y almacén)", NULL);
+static metric_counter_t event_queue_dropped = METRIC_COUNTER_INIT(SERVER_EVENT_DROPPED_METRIC,
+    SERVER_EVENT_DROPPED_HELP, "source=\"camera\"");
+
+static metric_desc_t *camera_metrics[] = {
+    &stage_sensor.desc, &stage_store.desc, &stage_burst.desc, &take_photo_latency.desc,
+    &event_queue_dropped.desc,
+};
+
+// Perfiles del sensor: datos constantes validados en compilación (SENSOR_PROFILE_ENTRY)
+
+// Base aplicada al iniciar: máxima iluminación para el gallinero
+static const sensor_reg_value_t base_entries[] = {
+    SENSOR_PROFILE_ENTRY(BRIGHTNESS, 2),      // Brillo máximo: +2
+    SENSOR_PROFILE_ENTRY(CONTRAST, 2),        // Contraste máximo: +2
+    SENSOR_PROFILE_ENTRY(SATURATION, 1),      // Saturación aumentada: +1
+    SENSOR_PROFILE_ENTRY(WHITEBAL, 1),        // Balance de blancos automático
+    SENSOR_PROFILE_ENTRY(AWB_GAIN, 1),        // Ganancia AWB automática
+    SENSOR_PROFILE_ENTRY(WB_MODE, 0),         // Modo WB automático
+    SENSOR_PROFILE_ENTRY(EXPOSURE_CTRL, 1),   // Control de exposición automático
+    SENSOR_PROFILE_ENTRY(AEC2, 1),            // AEC2 habilitado para mejor exposición
+    SENSOR_PROFILE_ENTRY(AE_LEVEL, 2),        // Nivel AE máximo: +2 (más exposición)
+    SENSOR_PROFILE_ENTRY(AEC_VALUE, 1200),    // Valor AEC máximo: 1200 (máximo tiempo exposición)
+    SENSOR_PROFILE_ENTRY(GAIN_CTRL, 1),       // Control de ganancia automático
+    SENSOR_PROFILE_ENTRY(AGC_GAIN, 30),       // Ganancia AGC máxima: 30
+    SENSOR_PROFILE_ENTRY(GAINCEILING, 6),     // Techo de ganancia máximo (128x)
+    SENSOR_PROFILE_ENTRY(BPC, 0),             // BPC deshabilitado
+    SENSOR_PROFILE_ENTRY(WPC, 1),             // WPC habilitado
+    SENSOR_PROFILE_ENTRY(RAW_GMA, 1),         // Gamma raw habilitado
+    SENSOR_PROFILE_ENTRY(LENC, 1),            // Corrección de lente habilitada
+    SENSOR_PROFILE_ENTRY(HMIRROR, 0),         // Sin espejo horizontal
+    SENSOR_PROFILE_ENTRY(VFLIP, 0),           // Sin volteo vertical
+    SENSOR_PROFILE_ENTRY(DCW, 1),             // DCW habilitado
+    SENSOR_PROFILE_ENTRY(COLORBAR, 0),        // Sin barra de colores
+};
+
+// Configuración moderada para poca luz
+static const sensor_reg_value_t low_light_entries[] = {
+    SENSOR_PROFILE_ENTRY(BRIGHTNESS, 2),      // Brillo máximo
+    SENSOR_PROFILE_ENTRY(CONTRAST, 1),        // Contraste moderado
+    SENSOR_PROFILE_ENTRY(SATURATION, 0),      // Saturación normal
+    SENSOR_PROFILE_ENTRY(AE_LEVEL, 2),        // Exposición máxima
+    SENSOR_PROFILE_ENTRY(AEC_VALUE, 800),     // Tiempo de exposición alto pero no máximo
+    SENSOR_PROFILE_ENTRY(AGC_GAIN, 20),       // Ganancia ISO alta pero no máxima
+    SENSOR_PROFILE_ENTRY(GAINCEILING, 5),     // Techo ganancia alto (64x)
+    SENSOR_PROFILE_ENTRY(AEC2, 1),            // AEC2 habilitado
+    SENSOR_PROFILE_ENTRY(RAW_GMA, 1),         // Gamma RAW habilitado
+    SENSOR_PROFILE_ENTRY(LENC, 1),            // Corrección de lente habilitada
+    SENSOR_PROFILE_ENTRY(BPC, 0),             // BPC deshabilitado
+    SENSOR_PROFILE_ENTRY(WPC, 1),             // WPC habilitado
+    SENSOR_PROFILE_ENTRY(AWB_GAIN, 1),        // AWB gain automático
+    SENSOR_PROFILE_ENTRY(WB_MODE, 0),         // Modo WB automático
+    SENSOR_PROFILE_ENTRY(DCW, 1),             // DCW habilitado
+};
+
+// Configuración CONSERVADORA para luz del día (evitar sobre-exposición)
+static const sensor_reg_value_t daylight_entries[] = {
+    SENSOR_PROFILE_ENTRY(BRIGHTNESS, -1),     // Brillo reducido para evitar saturación
+    SENSOR_PROFILE_ENTRY(CONTRAST, 0),        // Contraste normal
+    SENSOR_PROFILE_ENTRY(SATURATION, -1),     // Saturación reducida para colores naturales
+    SENSOR_PROFILE_ENTRY(AE_LEVEL, -2),       // Exposición REDUCIDA para evitar quemado
+    SENSOR_PROFILE_ENTRY(AEC_VALUE, 150),     // Tiempo de exposición MÁS CORTO
+    SENSOR_PROFILE_ENTRY(AGC_GAIN, 2),        // Ganancia ISO MÁS BAJA
+    SENSOR_PROFILE_ENTRY(GAINCEILING, 1),     // Techo ganancia BAJO (4x)
+    SENSOR_PROFILE_ENTRY(AEC2, 0),            // AEC2 deshabilitado
+    SENSOR_PROFILE_ENTRY(RAW_GMA, 1),         // Gamma RAW habilitado
+    SENSOR_PROFILE_ENTRY(LENC, 1),            // Corrección de lente habilitada
+    SENSOR_PROFILE_ENTRY(BPC, 0),             // BPC deshabilitado
+    SENSOR_PROFILE_ENTRY(WPC, 1),             // WPC habilitado
+    SENSOR_PROFILE_ENTRY(AWB_GAIN, 1),        // AWB gain automático
+    SENSOR_PROFILE_ENTRY(WB_MODE, 0),         // Modo WB automático
+    SENSOR_PROFILE_ENTRY(DCW, 1),             // DCW habilitado
+};
+
+static const sensor_profile_t base_profile = SENSOR_PROFILE_DEFINE("base", base_entries);
+static const sensor_profile_t low_light_profile = SENSOR_PROFILE_DEFINE("nocturno", low_light_entries);
+static const sensor_profile_t daylight_profile = SENSOR_PROFILE_DEFINE("diurno", daylight_entries);
+
+// Traduce un registro del perfil a la función set_* del driver
+static int sensor_reg_write(void *ctx, sensor_reg_t reg, int16_t value) {
+    sensor_t *s = (sensor_t *)ctx;
+    switch (reg) {
+        case SENSOR_REG_BRIGHTNESS:     return s->set_brightness(s, value);
+        case SENSOR_REG_CONTRAST:       return s->set_contrast(s, value);
+        case SENSOR_REG_SATURATION:     return s->set_saturation(s, value);
+        case SENSOR_REG_WHITEBAL:       return s->set_whitebal(s, value);
+        case SENSOR_REG_AWB_GAIN:       return s->set_awb_gain(s, value);
+        case SENSOR_REG_WB_MODE:        return s->set_wb_mode(s, value);
+        case SENSOR_REG_EXPOSURE_CTRL:  return s->set_exposure_ctrl(s, value);
+        case SENSOR_REG_AEC2:           return s->set_aec2(s, value);
+        case SENSOR_REG_AE_LEVEL:       return s->set_ae_level(s, value);
+        case SENSOR_REG_AEC_VALUE:      return s->set_aec_value(s, value);
+        case SENSOR_REG_GAIN_CTRL:      return s->set_gain_ctrl(s, value);
+        case SENSOR_REG_AGC_GAIN:       return s->set_agc_gain(s, value);
+        case SENSOR_REG_GAINCEILING:    return s->set_gainceiling(s, (gainceiling_t)value);
+        case SENSOR_REG_BPC:            return s->set_bpc(s, value);
+        case SENSOR_REG_WPC:            return s->set_wpc(s, value);
+        case SENSOR_REG_RAW_GMA:        return s->set_raw_gma(s, value);
+        case SENSOR_REG_LENC:           return s->set_lenc(s, value);
+        case SENSOR_REG_HMIRROR:        return s->set_hmirror(s, value);
+        case SENSOR_REG_VFLIP:          return s->set_vflip(s, value);
+        case SENSOR_REG_DCW:            return s->set_dcw(s, value);
+        case SENSOR_REG_COLORBAR:       return s->set_colorbar(s, value);
+        default:                        return -1;
+    }
+}
+
+static void publish_profile_stats(void) {
+    portENTER_CRITICAL(&profile_stats_lock);
+    profile_stats = profile_state.stats;
+    portEXIT_CRITICAL(&profile_stats_lock);
+}
+
+// Aplica un perfil entre capturas; solo se escriben los registros que cambian
+static esp_err_t apply_sensor_profile(const sensor_profile_t *profile) {
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) {
+        ESP_LOGE(TAG, "No se pudo obtener el sensor");
+        return ESP_FAIL;
+    }
+    
+    if (camera_lock) {
+        xSemaphoreTake(camera_lock, portMAX_DELAY);
+    }
+    esp_err_t ret = sensor_profile_apply(&profile_state, profile, sensor_reg_write, s);
+    if (camera_lock) {
+        xSemaphoreGive(camera_lock);
+    }
+    publish_profile_stats();
+    
+    ESP_LOGI(TAG, "🎛️ Perfil '%s': %u registros escritos, %zu sin cambios, %lu us",
+             profile->name, profile_state.stats.last_written,
+             profile->count - profile_state.stats.last_written, profile_state.stats.last_switch_us);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "El sensor rechazó algún registro del perfil '%s'", profile->name);
+    }
+    return ret;
+}
+
+// Función privada para enviar eventos al servidor (sin esperar a que haya hueco)
+static esp_err_t send_server_event(camera_capture_reason_t reason, size_t photo_size, uint32_t seq) {
     if (server_queue == NULL) {
         // Cola no configurada, continuar sin enviar
         return ESP_OK;
@@ -44,20 +247,18 @@ static esp_err_t send_server_event(const char* reason, size_t photo_size) {
     server_event_t event = {
         .type = SERVER_EVENT_PHOTO_TAKEN,
         .timestamp = esp_timer_get_time(),
+        .reason = (uint8_t)reason,
         .object_detected = false,  // Este campo lo maneja el sensor
         .sensor_state = -1         // Este campo lo maneja el sensor
     };
     
     // Configurar datos específicos de la foto
     event.photo_data.photo_size = photo_size;
-    if (reason) {
-        strncpy(event.photo_data.reason, reason, sizeof(event.photo_data.reason) - 1);
-        event.photo_data.reason[sizeof(event.photo_data.reason) - 1] = '\0';
-    }
+    event.photo_data.seq = seq;
     
-    BaseType_t result = xQueueSend(server_queue, &event, pdMS_TO_TICKS(100));
-    if (result != pdTRUE) {
-        ESP_LOGW(TAG, "No se pudo enviar evento de foto al servidor web");
+    if (server_events_post(server_queue, &event) != ESP_OK) {
+        metrics_counter_add(&event_queue_dropped, 1);
+        ESP_LOGW(TAG, "Cola del servidor web llena: evento de foto #%lu descartado", seq);
         return ESP_ERR_TIMEOUT;
     }
     
@@ -65,6 +266,22 @@ static esp_err_t send_server_event(const char* reason, size_t photo_size) {
     return ESP_OK;
 }
 
+// Copia al historial (/photos, /photo/{seq}) la foto que se acaba de publicar.
+// Se toma una referencia como cualquier lector: tras el commit el slot es del almacén
+static void record_history(uint32_t seq) {
+    camera_frame_t *published = camera_frame_acquire();
+    
+    if (published != NULL && published->seq == seq) {
+        esp_err_t err = photo_history_append(published);
+        if (err == ESP_ERR_NO_MEM) {
+            ESP_LOGW(TAG, "Foto #%lu fuera del historial: la más antigua se está enviando", seq);
+        } else if (err == ESP_ERR_INVALID_SIZE) {
+            ESP_LOGW(TAG, "Foto #%lu mayor que el historial (%zu bytes)", seq, published->len);
+        }
+    }
+    camera_frame_release(published);
+}
+
 esp_err_t camera_manager_init(void) {
     camera_config_custom_t default_config = CAMERA_DEFAULT_CONFIG();
     return camera_manager_init_with_config(&default_config);
@@ -78,11 +295,27 @@ esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config)
     
     ESP_LOGI(TAG, "Inicializando cámara...");
     
-    // Crear mutex para proteger acceso a foto
-    photo_mutex = xSemaphoreCreateMutex();
-    if (photo_mutex == NULL) {
-        ESP_LOGE(TAG, "Error creando mutex");
-        return ESP_ERR_NO_MEM;
+    // Reservar almacén de frames compartido con los lectores
+    frame_store_config_t store_config = {
+        .slot_count = config->frame_slots,
+        .slot_size = config->frame_slot_size,
+        .thumb_size = config->thumb_slot_size
+    };
+    esp_err_t err = frame_store_init(&store_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error creando almacén de frames");
+        return err;
+    }
+    frame_slot_size = config->frame_slot_size;
+    thumb_quality = config->thumb_quality;
+    
+    // Historial para /photos: sin él solo se pierde la consulta de fotos anteriores
+    photo_history_config_t history_config = {
+        .memory_budget = config->history_budget,
+        .max_entries = config->history_entries
+    };
+    if (photo_history_init(&history_config) != ESP_OK) {
+        ESP_LOGW(TAG, "Historial de fotos no disponible");
     }
     
     // Configuración de la cámara
@@ -112,14 +345,14 @@ esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config)
         .frame_size = config->frame_size,
         .jpeg_quality = config->jpeg_quality,
         .fb_count = config->fb_count,
-        .grab_mode = CAMERA_GRAB_WHEN_EMPTY
+        .grab_mode = config->grab_mode
     };
     
-    esp_err_t err = esp_camera_init(&camera_config);
+    err = esp_camera_init(&camera_config);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "❌ Error inicializando cámara: %s", esp_err_to_name(err));
-        vSemaphoreDelete(photo_mutex);
-        photo_mutex = NULL;
+        photo_history_deinit();
+        frame_store_deinit();
         return err;
     }
     
@@ -128,33 +361,18 @@ esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config)
     if (s == NULL) {
         ESP_LOGE(TAG, "❌ No se pudo obtener el sensor de la cámara");
         esp_camera_deinit();
-        vSemaphoreDelete(photo_mutex);
-        photo_mutex = NULL;
+        photo_history_deinit();
+        frame_store_deinit();
         return ESP_FAIL;
     }
     
-    // Configurar ajustes optimizados para máxima iluminación
-    s->set_brightness(s, 2);     // Brillo máximo: +2
-    s->set_contrast(s, 2);       // Contraste máximo: +2  
-    s->set_saturation(s, 1);     // Saturación aumentada: +1
-    s->set_whitebal(s, 1);       // Balance de blancos automático
-    s->set_awb_gain(s, 1);       // Ganancia AWB automática
-    s->set_wb_mode(s, 0);        // Modo WB automático
-    s->set_exposure_ctrl(s, 1);  // Control de exposición automático
-    s->set_aec2(s, 1);           // AEC2 habilitado para mejor exposición
-    s->set_ae_level(s, 2);       // Nivel AE máximo: +2 (más exposición)
-    s->set_aec_value(s, 1200);   // Valor AEC máximo: 1200 (máximo tiempo exposición)
-    s->set_gain_ctrl(s, 1);      // Control de ganancia automático
-    s->set_agc_gain(s, 30);      // Ganancia AGC máxima: 25
-    s->set_gainceiling(s, (gainceiling_t)6); // Techo de ganancia máximo (128x)
-    s->set_bpc(s, 0);            // BPC deshabilitado
-    s->set_wpc(s, 1);            // WPC habilitado
-    s->set_raw_gma(s, 1);        // Gamma raw habilitado
-    s->set_lenc(s, 1);           // Corrección de lente habilitada
-    s->set_hmirror(s, 0);        // Sin espejo horizontal
-    s->set_vflip(s, 0);          // Sin volteo vertical
-    s->set_dcw(s, 1);            // DCW habilitado
-    s->set_colorbar(s, 0);       // Sin barra de colores
+    // Tras el reset del sensor ningún registro es conocido: el perfil base se escribe completo
+    sensor_profile_state_init(&profile_state);
+    apply_sensor_profile(&base_profile);
+    
+    for (size_t i = 0; i < sizeof(camera_metrics) / sizeof(camera_metrics[0]); i++) {
+        metrics_register(camera_metrics[i]);
+    }
     
     // Inicializar información de la cámara
     camera_info.initialized = true;
@@ -164,6 +382,37 @@ esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config)
     camera_info.photo_count = 0;
     camera_info.last_photo_size = 0;
     camera_info.last_photo_time = 0;
+    init_frame_size = config->frame_size;
+    
+    // Sin modos activos solo se usan max_flush_frames y las estadísticas de cambios de resolución
+    capture_tier_config_t tier_config = CAPTURE_TIER_DEFAULT_CONFIG();
+    capture_tier_init(&tier_state, &tier_config, esp_timer_get_time());
+    tier_enabled = false;
+    
+    // Servicio de captura: única tarea que usa el driver tras la inicialización
+    camera_lock = xSemaphoreCreateMutex();
+    err = camera_lock ? capture_queue_init(config->capture_queue_len) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        capture_running = true;
+        if (xTaskCreate(capture_task, "cam_capture", CAPTURE_TASK_STACK, NULL,
+                        CAPTURE_TASK_PRIORITY, &capture_task_handle) != pdPASS) {
+            capture_running = false;
+            capture_queue_deinit();
+            err = ESP_FAIL;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Error iniciando servicio de captura");
+        if (camera_lock) {
+            vSemaphoreDelete(camera_lock);
+            camera_lock = NULL;
+        }
+        memset(&camera_info, 0, sizeof(camera_info));
+        esp_camera_deinit();
+        photo_history_deinit();
+        frame_store_deinit();
+        return err;
+    }
     
     ESP_LOGI(TAG, "✅ Cámara inicializada correctamente");
     ESP_LOGI(TAG, "📋 Configuración: 1280x720 (720p HD), JPEG calidad %d, %d buffers", 
@@ -172,107 +421,776 @@ esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config)
     return ESP_OK;
 }
 
-esp_err_t camera_manager_take_photo(const char* reason) {
-    if (!camera_info.initialized) {
-        ESP_LOGE(TAG, "Cámara no inicializada");
-        return ESP_ERR_INVALID_STATE;
+static void publish_tier_stats(void) {
+    capture_tier_stats_t copy;
+    capture_tier_get_stats(&tier_state, esp_timer_get_time(), &copy);
+    
+    portENTER_CRITICAL(&tier_stats_lock);
+    tier_stats = copy;
+    portEXIT_CRITICAL(&tier_stats_lock);
+}
+
+static bool flush_get(capture_tier_frame_t *frame) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (fb == NULL) {
+        return false;
+    }
+    frame->buf = fb->buf;
+    frame->len = fb->len;
+    frame->handle = fb;
+    return true;
+}
+
+static void flush_put(capture_tier_frame_t *frame) {
+    esp_camera_fb_return((camera_fb_t *)frame->handle);
+}
+
+// Cambia la resolución y descarta los frames que el driver ya tenía con la anterior
+// (con camera_lock). Con CAMERA_GRAB_LATEST hasta fb_count frames capturados antes de
+// escribir el sensor salen aún con el tamaño viejo, y fb->width/height no lo delata
+// (el driver pone el configurado): se mira el SOF de cada JPEG.
+static void switch_frame_size(framesize_t frame_size) {
+    if (frame_size == camera_info.frame_size) {
+        return;
+    }
+    
+    framesize_t previous = camera_info.frame_size;
+    int64_t start = esp_timer_get_time();
+    if (camera_manager_set_frame_size(frame_size) != ESP_OK) {
+        return;
+    }
+    
+    uint16_t width = resolution[frame_size].width;
+    uint16_t height = resolution[frame_size].height;
+    bool fresh;
+    uint8_t flushed = capture_tier_flush(&tier_state, flush_get, flush_put, width, height, &fresh);
+    
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - start);
+    capture_tier_record_switch(&tier_state, latency, flushed, !fresh);
+    publish_tier_stats();
+    
+    if (fresh) {
+        ESP_LOGI(TAG, "🔀 Resolución %d -> %d (%ux%u) en %lu ms, %u frames anteriores descartados",
+                 previous, frame_size, width, height, latency / 1000, flushed);
+    } else {
+        ESP_LOGW(TAG, "⚠️ Resolución %d -> %d sin frame nuevo, %u frames anteriores descartados (%lu ms)",
+                 previous, frame_size, flushed, latency / 1000);
+    }
+}
+
+// Alimenta el control de tamaño con un frame y aplica su decisión (con camera_lock)
+static void rate_control_feed(size_t size, uint64_t timestamp) {
+    if (!rate_control_active) {
+        return;
+    }
+    
+    rate_control_sample_t sample = {
+        .size = size,
+        .timestamp = timestamp,
+        .quality = (int16_t)camera_info.jpeg_quality,
+        .frame_size = (int16_t)camera_info.frame_size,
+    };
+    rate_control_decision_t decision;
+    rate_control_update(&rate_ctl, &sample, &decision);
+    
+    if (decision.changed) {
+        ESP_LOGI(TAG, "📉 Control de tamaño: calidad %d -> %d, resolución %d -> %d "
+                 "(%zu bytes, presupuesto %lu bytes)", sample.quality, decision.quality,
+                 sample.frame_size, decision.frame_size, size, decision.budget);
+        if (decision.frame_size != sample.frame_size) {
+            switch_frame_size((framesize_t)decision.frame_size);
+        }
+        if (decision.quality != sample.quality) {
+            camera_manager_set_quality(decision.quality);
+        }
+    }
+    
+    portENTER_CRITICAL(&rate_stats_lock);
+    rate_stats = rate_ctl.stats;
+    portEXIT_CRITICAL(&rate_stats_lock);
+}
+
+// Rellena los metadatos del frame en escritura (con camera_lock, antes del commit)
+static void fill_frame_meta(camera_frame_t *frame, const capture_queue_entry_t *entry, uint8_t burst_frames) {
+    camera_frame_meta_t *meta = &frame->meta;
+    struct timeval now;
+    
+    gettimeofday(&now, NULL);
+    meta->wall_time_ms = now.tv_sec >= WALL_CLOCK_VALID_SEC ?
+                         (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000 : 0;
+    meta->profile = profile_state.stats.active;
+    meta->aec_value = (uint16_t)profile_state.values[SENSOR_REG_AEC_VALUE];
+    meta->agc_gain = (uint8_t)profile_state.values[SENSOR_REG_AGC_GAIN];
+    meta->ae_level = (int8_t)profile_state.values[SENSOR_REG_AE_LEVEL];
+    meta->gainceiling = (uint8_t)profile_state.values[SENSOR_REG_GAINCEILING];
+    meta->quality = (uint8_t)camera_info.jpeg_quality;
+    meta->frame_size = (uint8_t)camera_info.frame_size;
+    meta->burst_frames = burst_frames;
+    meta->hash_distance = FRAME_HASH_NONE;
+    
+    if (entry != NULL) {
+        meta->reason = (uint8_t)entry->request.reason;
+        meta->episode_id = entry->request.episode_id;
+        meta->capture_latency_us = frame->timestamp > entry->submit_time ?
+                                   (uint32_t)(frame->timestamp - entry->submit_time) : 0;
+    } else {
+        meta->reason = CAMERA_CAPTURE_REASON_PREROLL;
+    }
+}
+
+// Genera la miniatura 1/8 del frame en escritura a partir de la copia del slot
+static void attach_thumbnail(camera_frame_t *frame, const uint8_t *data) {
+    size_t capacity = 0;
+    uint8_t *thumb = frame_store_thumb_buffer(frame, &capacity);
+    if (thumb == NULL) {
+        return;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = jpeg_thumb_encode(data, frame->len, thumb_quality, thumb, capacity, &frame->thumb_len);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No se pudo generar la miniatura: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGD(TAG, "Miniatura %ux%u: %zu bytes (1/%zu del original) en %lld us",
+             (frame->width + 7) / 8, (frame->height + 7) / 8, frame->thumb_len,
+             frame->len / (frame->thumb_len ? frame->thumb_len : 1), esp_timer_get_time() - start);
+}
+
+// Decodifica el mapa DC de luminancia de un JPEG (el llamador libera *map)
+static esp_err_t decode_luma_map(const uint8_t *jpeg, size_t len, uint8_t **map, jpeg_dc_info_t *info) {
+    esp_err_t ret = jpeg_dc_get_info(jpeg, len, info);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    size_t map_size = (size_t)info->map_width * info->map_height;
+    *map = malloc(map_size);
+    if (*map == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ret = jpeg_dc_luma_map(jpeg, len, *map, map_size, info);
+    if (ret != ESP_OK) {
+        free(*map);
+        *map = NULL;
+    }
+    return ret;
+}
+
+static float map_mean(const uint8_t *map, size_t map_size) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < map_size; i++) {
+        sum += map[i];
+    }
+    return map_size > 0 ? (float)sum / map_size : 0.0f;
+}
+
+// Luminancia media de un JPEG a partir del mapa DC (sin decodificación completa)
+static esp_err_t scene_luma(const uint8_t *jpeg, size_t len, float *luma) {
+    uint8_t *map = NULL;
+    jpeg_dc_info_t info;
+    esp_err_t ret = decode_luma_map(jpeg, len, &map, &info);
+    if (ret == ESP_OK) {
+        *luma = map_mean(map, (size_t)info.map_width * info.map_height);
+        free(map);
+    }
+    return ret;
+}
+
+static void publish_luma_sample(float luma) {
+    int64_t now = time(NULL);
+    
+    portENTER_CRITICAL(&day_night_lock);
+    luma_sample.luma = luma;
+    luma_sample.time = now;
+    luma_sample.count++;
+    portEXIT_CRITICAL(&day_night_lock);
+    
+    ESP_LOGD(TAG, "Luminancia de escena: %lld,%.1f", now, luma);
+}
+
+// Indica si toca muestrear la luminancia para el planificador día/noche
+// (con camera_lock; como mucho una vez por sample_interval_s)
+static bool luma_sample_due(void) {
+    if (!day_night_running) {
+        return false;
+    }
+    
+    uint64_t now = esp_timer_get_time();
+    if (now < next_luma_sample) {
+        return false;
+    }
+    next_luma_sample = now + luma_sample_interval_us;
+    return true;
+}
+
+// Muestrea la luminancia de un frame ya capturado (con camera_lock)
+static void sample_scene_luma(const uint8_t *jpeg, size_t len) {
+    if (!luma_sample_due()) {
+        return;
     }
     
-    ESP_LOGI(TAG, "📸 Tomando foto por: %s", reason ? reason : "razón no especificada");
+    float luma;
+    if (scene_luma(jpeg, len, &luma) == ESP_OK) {
+        publish_luma_sample(luma);
+    }
+}
+
+static void publish_dedupe_stats(void) {
+    portENTER_CRITICAL(&dedupe_stats_lock);
+    dedupe_stats = dedupe.stats;
+    portEXIT_CRITICAL(&dedupe_stats_lock);
+}
+
+// Fija como referencia un frame publicado sin pasar por la decisión (con camera_lock)
+static void dedupe_keep_frame(camera_frame_t *frame) {
+    if (!dedupe_active) {
+        return;
+    }
+    if (dedupe.has_reference) {
+        frame->meta.hash_distance = frame_hash_distance(&frame->meta.phash, &dedupe.reference);
+    }
+    frame_dedupe_keep(&dedupe, &frame->meta.phash, frame->timestamp);
+}
+
+// Calcula el hash perceptual del frame en escritura y decide si es duplicado
+// (con camera_lock, tras fill_frame_meta). El mismo mapa DC sirve de muestra de
+// luminancia al planificador día/noche. Devuelve true si hay que descartarlo.
+static bool hash_stored_frame(camera_frame_t *frame, const uint8_t *data) {
+    if (!dedupe_active) {
+        sample_scene_luma(data, frame->len);
+        return false;
+    }
+    
+    bool luma_due = luma_sample_due();
+    int64_t start = esp_timer_get_time();
+    uint8_t *map = NULL;
+    jpeg_dc_info_t info;
+    esp_err_t ret = decode_luma_map(data, frame->len, &map, &info);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No se pudo calcular el hash perceptual: %s", esp_err_to_name(ret));
+        return false;
+    }
+    frame_hash_map(map, info.map_width, info.map_height, &frame->meta.phash);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (luma_due) {
+        publish_luma_sample(map_mean(map, (size_t)info.map_width * info.map_height));
+    }
+    free(map);
+    
+    dedupe.stats.last_hash_us = elapsed;
+    if (elapsed > dedupe.stats.max_hash_us) {
+        dedupe.stats.max_hash_us = elapsed;
+    }
+    
+    bool duplicate = false;
+    if (frame->meta.reason == CAMERA_CAPTURE_REASON_PERIODIC) {
+        duplicate = frame_dedupe_check(&dedupe, &frame->meta.phash, frame->timestamp, frame->len,
+                                       &frame->meta.hash_distance);
+    } else {
+        dedupe_keep_frame(frame);
+    }
+    frame->meta.duplicate = duplicate;
+    publish_dedupe_stats();
+    
+    ESP_LOGD(TAG, "Hash perceptual %016llx%016llx, distancia %u, %lu us",
+             frame->meta.phash.brighter, frame->meta.phash.darker, frame->meta.hash_distance, elapsed);
+    return duplicate && dedupe.config.drop;
+}
+
+// Captura un frame y lo publica en el almacén (solo desde la tarea de captura)
+static esp_err_t capture_to_store(const capture_queue_entry_t *entry, camera_capture_result_t *result) {
+    const char *reason_name = camera_capture_reason_name(entry->request.reason);
+    
+    ESP_LOGI(TAG, "📸 Tomando foto por: %s", reason_name);
     
     camera_fb_t *new_photo = NULL;
-    int retries = 3;
+    uint64_t sensor_start = esp_timer_get_time();
     
     // Reintentar hasta 3 veces si falla
-    for (int i = 0; i < retries; i++) {
+    for (int i = 0; i < CAPTURE_RETRIES; i++) {
         new_photo = esp_camera_fb_get();
         if (new_photo) {
             ESP_LOGI(TAG, "✅ Foto capturada exitosamente en intento %d", i + 1);
             break;
         }
         
-        ESP_LOGW(TAG, "⚠️ Intento %d/%d falló, reintentando...", i + 1, retries);
+        ESP_LOGW(TAG, "⚠️ Intento %d/%d falló, reintentando...", i + 1, CAPTURE_RETRIES);
         vTaskDelay(pdMS_TO_TICKS(100)); // Esperar 100ms antes del siguiente intento
     }
     
     if (!new_photo) {
-        ESP_LOGE(TAG, "❌ Error capturando foto después de %d intentos", retries);
+        ESP_LOGE(TAG, "❌ Error capturando foto después de %d intentos", CAPTURE_RETRIES);
         return ESP_FAIL;
     }
+    uint64_t store_start = esp_timer_get_time();
+    metrics_histogram_observe(&stage_sensor, (uint32_t)(store_start - sensor_start));
+    
+    // Copiar al almacén y devolver el buffer al driver de inmediato
+    uint8_t *slot_data = NULL;
+    camera_frame_t *frame = frame_store_begin_write(new_photo->len, &slot_data);
+    if (frame == NULL) {
+        ESP_LOGE(TAG, "Sin slot libre para la foto (%zu bytes)", new_photo->len);
+        esp_camera_fb_return(new_photo);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    uint64_t capture_time = esp_timer_get_time();
+    size_t photo_size = new_photo->len;
+    memcpy(slot_data, new_photo->buf, photo_size);
+    frame->timestamp = capture_time;
+    frame->width = new_photo->width;
+    frame->height = new_photo->height;
+    esp_camera_fb_return(new_photo);
+    fill_frame_meta(frame, entry, 0);
+    
+    // Un duplicado se descarta antes de generar la miniatura: la foto vigente sigue siendo la anterior
+    if (hash_stored_frame(frame, slot_data)) {
+        ESP_LOGI(TAG, "🪞 Foto casi idéntica a la anterior descartada (distancia %u, %zu bytes)",
+                 frame->meta.hash_distance, photo_size);
+        frame_store_abort(frame);
+        result->seq = frame_store_latest_seq();
+        result->size = photo_size;
+        result->frame_time = capture_time;
+        result->duplicate = true;
+        rate_control_feed(photo_size, capture_time);
+        return ESP_OK;
+    }
+    attach_thumbnail(frame, slot_data);
     
-    // Proteger acceso concurrente
-    if (xSemaphoreTake(photo_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        // Liberar foto anterior si existe
-        if (current_photo) {
-            esp_camera_fb_return(current_photo);
-            ESP_LOGD(TAG, "Foto anterior liberada");
+    // Tras el commit el slot pertenece al almacén: no tocar frame
+    uint32_t seq = frame_store_commit(frame);
+    record_history(seq);
+    metrics_histogram_observe(&stage_store, (uint32_t)(esp_timer_get_time() - store_start));
+    camera_info.photo_count++;
+    camera_info.last_photo_size = photo_size;
+    camera_info.last_photo_time = capture_time;
+    
+    ESP_LOGI(TAG, "📷 Nueva foto #%lu almacenada - Tamaño: %zu bytes (%.1f KB)", 
+            seq, photo_size, photo_size / 1024.0);
+    
+    result->seq = seq;
+    result->size = photo_size;
+    result->frame_time = capture_time;
+    
+    rate_control_feed(photo_size, capture_time);
+    
+    // Enviar evento al servidor
+    send_server_event(entry->request.reason, photo_size, seq);
+    
+    return ESP_OK;
+}
+
+// Candidato de una ráfaga retenido en un slot del almacén
+typedef struct {
+    camera_frame_t *frame;
+    uint8_t *data;            // Buffer escribible del slot
+    frame_quality_t quality;
+    frame_hash_t hash;
+} burst_candidate_t;
+
+// Captura una ráfaga y publica solo los mejores frames (solo desde la tarea de captura)
+static esp_err_t capture_burst_to_store(const capture_queue_entry_t *entry,
+                                        camera_capture_result_t *result) {
+    const camera_capture_request_t *request = &entry->request;
+    const char *reason_name = camera_capture_reason_name(request->reason);
+    uint8_t frames = request->burst_frames > BURST_MAX_FRAMES ? BURST_MAX_FRAMES : request->burst_frames;
+    uint8_t keep = request->burst_keep == 0 ? 1 : request->burst_keep;
+    if (keep > BURST_MAX_KEEP) {
+        keep = BURST_MAX_KEEP;
+    }
+    
+    burst_candidate_t kept[BURST_MAX_KEEP] = {0};
+    size_t kept_count = 0;
+    uint8_t *luma_map = NULL;
+    size_t map_capacity = 0;
+    uint8_t evaluated = 0;
+    int64_t start = esp_timer_get_time();
+    
+    ESP_LOGI(TAG, "📸 Ráfaga de %d frames por: %s", frames, reason_name);
+    
+    for (uint8_t i = 0; i < frames; i++) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (!fb) {
+            ESP_LOGW(TAG, "⚠️ Frame %d/%d de la ráfaga falló", i + 1, frames);
+            continue;
         }
+        uint64_t capture_time = esp_timer_get_time();
         
-        // Almacenar nueva foto
-        current_photo = new_photo;
+        // El buffer del mapa se reserva con el primer frame y se reutiliza
+        jpeg_dc_info_t info;
+        frame_quality_t quality;
+        frame_hash_t hash = {0};
+        esp_err_t ret = jpeg_dc_get_info(fb->buf, fb->len, &info);
+        if (ret == ESP_OK && (size_t)info.map_width * info.map_height > map_capacity) {
+            free(luma_map);
+            map_capacity = (size_t)info.map_width * info.map_height;
+            luma_map = malloc(map_capacity);
+            if (luma_map == NULL) {
+                map_capacity = 0;
+                ret = ESP_ERR_NO_MEM;
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = frame_analysis_score_jpeg(fb->buf, fb->len, luma_map, map_capacity, &quality);
+        }
+        if (ret == ESP_OK && dedupe_active) {
+            frame_hash_map(luma_map, info.map_width, info.map_height, &hash);   // Mapa ya decodificado
+        }
+        if (ret != ESP_OK || fb->len > frame_slot_size) {
+            esp_camera_fb_return(fb);
+            continue;
+        }
+        evaluated++;
+        if (luma_sample_due()) {
+            publish_luma_sample(quality.mean);   // La puntuación ya calculó la media
+        }
+        ESP_LOGD(TAG, "Frame %d: nitidez=%.3f exposición=%.2f media=%d", i + 1,
+                 quality.sharpness, quality.exposure, quality.mean);
+        
+        // Reservar un slot nuevo mientras haya cupo; si no, reemplazar al peor candidato
+        burst_candidate_t *target = NULL;
+        if (kept_count < keep) {
+            uint8_t *data = NULL;
+            camera_frame_t *frame = frame_store_begin_write(frame_slot_size, &data);
+            if (frame != NULL) {
+                target = &kept[kept_count++];
+                target->frame = frame;
+                target->data = data;
+            } else {
+                keep = kept_count;
+            }
+        }
+        if (target == NULL && kept_count > 0) {
+            burst_candidate_t *worst = &kept[0];
+            for (size_t k = 1; k < kept_count; k++) {
+                if (kept[k].quality.score < worst->quality.score) {
+                    worst = &kept[k];
+                }
+            }
+            if (quality.score > worst->quality.score) {
+                target = worst;
+            }
+        }
+        
+        if (target != NULL) {
+            memcpy(target->data, fb->buf, fb->len);
+            target->frame->len = fb->len;
+            target->frame->timestamp = capture_time;
+            target->frame->width = fb->width;
+            target->frame->height = fb->height;
+            target->quality = quality;
+            target->hash = hash;
+        }
+        esp_camera_fb_return(fb);
+    }
+    free(luma_map);
+    
+    if (kept_count == 0) {
+        ESP_LOGE(TAG, "❌ Ráfaga sin frames válidos");
+        return ESP_FAIL;
+    }
+    
+    // Publicar de menor a mayor puntuación: el mejor queda como frame más reciente
+    if (kept_count == 2 && kept[0].quality.score > kept[1].quality.score) {
+        burst_candidate_t tmp = kept[0];
+        kept[0] = kept[1];
+        kept[1] = tmp;
+    }
+    burst_candidate_t best = kept[kept_count - 1];
+    uint64_t best_time = best.frame->timestamp;
+    size_t best_size = best.frame->len;
+    uint32_t seq = 0;
+    for (size_t k = 0; k < kept_count; k++) {
+        attach_thumbnail(kept[k].frame, kept[k].data);
+        fill_frame_meta(kept[k].frame, entry, evaluated);
+        kept[k].frame->meta.phash = kept[k].hash;
+        dedupe_keep_frame(kept[k].frame);
+        seq = frame_store_commit(kept[k].frame);
+        record_history(seq);
         camera_info.photo_count++;
-        camera_info.last_photo_size = current_photo->len;
-        camera_info.last_photo_time = esp_timer_get_time();
+    }
+    camera_info.last_photo_size = best_size;
+    camera_info.last_photo_time = best_time;
+    if (dedupe_active) {
+        publish_dedupe_stats();
+    }
+    
+    ESP_LOGI(TAG, "🎯 Ráfaga: %d/%d frames evaluados en %lld ms, foto #%lu elegida "
+             "(nitidez=%.3f, exposición=%.2f, %zu bytes)",
+             evaluated, frames, (esp_timer_get_time() - start) / 1000, seq,
+             best.quality.sharpness, best.quality.exposure, best_size);
+    
+    result->seq = seq;
+    result->size = best_size;
+    result->frame_time = best_time;
+    result->frames_evaluated = evaluated;
+    result->score = best.quality.score;
+    
+    rate_control_feed(best_size, best_time);
+    
+    send_server_event(request->reason, best_size, seq);
+    
+    return ESP_OK;
+}
+
+// Notifica el resultado a cada solicitud del lote
+static void complete_requests(const capture_queue_entry_t *entries, size_t count,
+                              const camera_capture_result_t *shared, bool coalesce) {
+    for (size_t i = 0; i < count; i++) {
+        const camera_capture_request_t *request = &entries[i].request;
+        if (request->done_cb == NULL) {
+            continue;
+        }
+        camera_capture_result_t result = *shared;
+        result.reason = request->reason;
+        result.request_time = entries[i].submit_time;
+        result.coalesced = coalesce && i > 0;
+        request->done_cb(&result, request->done_arg);
+    }
+}
+
+// Atiende un lote: aplica la configuración del líder y captura un único frame
+static void serve_batch(const capture_queue_entry_t *batch, size_t count) {
+    const camera_capture_request_t *leader = &batch[0].request;
+    camera_capture_result_t result = {0};
+    
+    if (leader->frame_size != camera_info.frame_size) {
+        switch_frame_size((framesize_t)leader->frame_size);
+    }
+    if (leader->quality != camera_info.jpeg_quality) {
+        camera_manager_set_quality(leader->quality);
+    }
+    
+    if (leader->burst_frames > 1) {
+        uint64_t burst_start = esp_timer_get_time();
+        result.status = capture_burst_to_store(&batch[0], &result);
+        metrics_histogram_observe(&stage_burst, (uint32_t)(esp_timer_get_time() - burst_start));
+    } else {
+        result.status = capture_to_store(&batch[0], &result);
+    }
+    if (count > 1) {
+        ESP_LOGI(TAG, "🔗 %zu solicitudes atendidas con un solo frame", count);
+    }
+    complete_requests(batch, count, &result, true);
+}
+
+// Captura un frame a baja tasa hacia el anillo pre-disparo
+static void capture_preroll_frame(void) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (fb) {
+        uint8_t *data = NULL;
+        camera_frame_t *frame = preroll_ring_begin_write(fb->len, &data);
+        if (frame) {
+            memcpy(data, fb->buf, fb->len);
+            frame->timestamp = esp_timer_get_time();
+            frame->width = fb->width;
+            frame->height = fb->height;
+            fill_frame_meta(frame, NULL, 0);
+            sample_scene_luma(data, frame->len);
+            preroll_ring_commit(frame);
+        }
+        size_t size = fb->len;
+        esp_camera_fb_return(fb);
+        rate_control_feed(size, esp_timer_get_time());
+    }
+}
+
+// Pasa al modo que corresponde a la actividad reciente (con camera_lock, antes de
+// atender solicitudes: las que heredan la resolución usan la del nuevo modo)
+static void update_capture_tier(void) {
+    if (!tier_enabled) {
+        return;
+    }
+    
+    uint64_t now = esp_timer_get_time();
+    if (tier_wake) {
+        tier_wake = false;
+        capture_tier_activity(&tier_state, now);
+    }
+    
+    capture_tier_t target = capture_tier_target(&tier_state, now);
+    if (target == tier_state.stats.tier) {
+        return;
+    }
+    
+    capture_tier_settings_t apply;
+    capture_tier_enter(&tier_state, target, (int8_t)camera_info.jpeg_quality, now, &apply);
+    ESP_LOGI(TAG, "🔭 Modo de captura %s: resolución %d, calidad %d", capture_tier_name(target),
+             apply.frame_size, apply.quality);
+    if (apply.quality != camera_info.jpeg_quality) {
+        camera_manager_set_quality(apply.quality);
+    }
+    switch_frame_size((framesize_t)apply.frame_size);
+    publish_tier_stats();
+}
+
+// Tiempo de espera hasta el próximo plazo, frame pre-disparo o fin del modo activo
+static TickType_t capture_wait_ticks(void) {
+    uint64_t wake = capture_queue_next_deadline();
+    if (preroll_running && (wake == 0 || next_preroll_time < wake)) {
+        wake = next_preroll_time;
+    }
+    uint64_t tier_deadline = tier_enabled ? capture_tier_next_deadline(&tier_state) : 0;
+    if (tier_deadline != 0 && (wake == 0 || tier_deadline < wake)) {
+        wake = tier_deadline;
+    }
+    if (wake == 0) {
+        return portMAX_DELAY;
+    }
+    
+    uint64_t now = esp_timer_get_time();
+    if (wake <= now) {
+        return 0;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((wake - now + 999) / 1000);
+    return ticks > 0 ? ticks : 1;
+}
+
+// Tarea dueña de la cámara: atiende solicitudes por prioridad y la captura pre-disparo
+static void capture_task(void *pvParameters) {
+    capture_queue_entry_t batch[CAPTURE_MAX_BATCH];
+    camera_capture_result_t expired_result = { .status = ESP_ERR_TIMEOUT };
+    size_t count;
+    
+    ESP_LOGI(TAG, "📷 Servicio de captura iniciado");
+    
+    while (capture_running) {
+        ulTaskNotifyTake(pdTRUE, capture_wait_ticks());
         
-        ESP_LOGI(TAG, "📷 Nueva foto #%lu almacenada - Tamaño: %zu bytes (%.1f KB)", 
-                camera_info.photo_count, current_photo->len, current_photo->len / 1024.0);
+        xSemaphoreTake(camera_lock, portMAX_DELAY);
         
-        // Notificar al servidor web (fuera del mutex crítico)
-        size_t photo_size = current_photo->len;
-        xSemaphoreGive(photo_mutex);
+        // Las solicitudes que llegan durante una captura se agrupan en el siguiente lote
+        while (capture_running) {
+            update_capture_tier();
+            while ((count = capture_queue_take_expired(esp_timer_get_time(), batch, CAPTURE_MAX_BATCH)) > 0) {
+                ESP_LOGW(TAG, "⏱️ %zu solicitudes vencidas sin capturar", count);
+                complete_requests(batch, count, &expired_result, false);
+            }
+            
+            count = capture_queue_pop_batch(camera_info.frame_size, camera_info.jpeg_quality,
+                                            batch, CAPTURE_MAX_BATCH);
+            if (count == 0) {
+                break;
+            }
+            serve_batch(batch, count);
+        }
         
-        // Enviar evento al servidor
-        send_server_event(reason, photo_size);
+        uint64_t now = esp_timer_get_time();
+        if (preroll_running && now >= next_preroll_time) {
+            capture_preroll_frame();
+            next_preroll_time += (uint64_t)preroll_config.frame_interval_ms * 1000;
+            if (next_preroll_time <= now) {
+                next_preroll_time = now + (uint64_t)preroll_config.frame_interval_ms * 1000;
+            }
+        }
         
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG, "Error obteniendo mutex");
-        esp_camera_fb_return(new_photo);
-        return ESP_ERR_TIMEOUT;
+        xSemaphoreGive(camera_lock);
+    }
+    
+    // Nadie queda esperando: la cola se cierra bajo su lock antes del último vaciado, así
+    // una solicitud que pasó la comprobación de capture_running o se vacía aquí o se rechaza
+    camera_capture_result_t cancelled = { .status = ESP_ERR_INVALID_STATE };
+    capture_queue_close();
+    while ((count = capture_queue_pop_batch(camera_info.frame_size, camera_info.jpeg_quality,
+                                            batch, CAPTURE_MAX_BATCH)) > 0) {
+        complete_requests(batch, count, &cancelled, false);
     }
+    
+    ESP_LOGI(TAG, "Servicio de captura detenido");
+    capture_task_handle = NULL;
+    vTaskDelete(NULL);
 }
 
-camera_fb_t* camera_manager_get_current_photo(void) {
-    camera_fb_t* photo_copy = NULL;
+esp_err_t camera_manager_capture_async(const camera_capture_request_t *request) {
+    if (request == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!capture_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    if (xSemaphoreTake(photo_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        photo_copy = current_photo;
-        xSemaphoreGive(photo_mutex);
+    esp_err_t ret = capture_queue_push(request, esp_timer_get_time());
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Solicitud de captura rechazada (%s): %s",
+                 camera_capture_reason_name(request->reason), esp_err_to_name(ret));
+        return ret;
     }
     
-    return photo_copy;
+    // Las fotos de un episodio mantienen el modo activo
+    if (request->episode_id != 0) {
+        tier_wake = true;
+    }
+    
+    // La tarea pudo terminar tras aceptar la solicitud: en ese caso ya la cerró al vaciar la cola
+    TaskHandle_t task = capture_task_handle;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+    return ESP_OK;
 }
 
-esp_err_t camera_manager_get_photo_data(uint8_t** buffer, size_t* len) {
-    if (!buffer || !len) {
-        return ESP_ERR_INVALID_ARG;
+// Contexto de una espera síncrona
+typedef struct {
+    SemaphoreHandle_t done;
+    camera_capture_result_t result;
+} capture_waiter_t;
+
+static void capture_waiter_done(const camera_capture_result_t *result, void *arg) {
+    capture_waiter_t *waiter = (capture_waiter_t *)arg;
+    waiter->result = *result;
+    xSemaphoreGive(waiter->done);
+}
+
+esp_err_t camera_manager_capture(camera_capture_reason_t reason, uint32_t timeout_ms,
+                                 camera_capture_result_t *result) {
+    capture_waiter_t waiter = {0};
+    waiter.done = xSemaphoreCreateBinary();
+    if (waiter.done == NULL) {
+        return ESP_ERR_NO_MEM;
     }
     
-    *buffer = NULL;
-    *len = 0;
+    // El plazo garantiza que el callback llegue siempre: la espera no necesita timeout
+    camera_capture_request_t request = CAMERA_CAPTURE_REQUEST_DEFAULT(reason);
+    request.deadline = esp_timer_get_time() + (uint64_t)timeout_ms * 1000;
+    request.done_cb = capture_waiter_done;
+    request.done_arg = &waiter;
     
-    if (xSemaphoreTake(photo_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (current_photo) {
-            *buffer = current_photo->buf;
-            *len = current_photo->len;
-            xSemaphoreGive(photo_mutex);
-            return ESP_OK;
+    esp_err_t ret = camera_manager_capture_async(&request);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(waiter.done, portMAX_DELAY);
+        ret = waiter.result.status;
+        if (result) {
+            *result = waiter.result;
         }
-        xSemaphoreGive(photo_mutex);
     }
     
-    return ESP_ERR_NOT_FOUND;
+    vSemaphoreDelete(waiter.done);
+    return ret;
 }
 
-bool camera_manager_has_photo(void) {
-    bool has_photo = false;
-    
-    if (xSemaphoreTake(photo_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        has_photo = (current_photo != NULL);
-        xSemaphoreGive(photo_mutex);
+esp_err_t camera_manager_take_photo(const char* reason) {
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
     }
     
-    return has_photo;
+    // La razón viaja con la foto (X-Capture-Reason, /photos): "detección inicial" no es manual
+    camera_capture_reason_t capture_reason = camera_capture_reason_from_name(reason);
+    ESP_LOGI(TAG, "📸 Solicitud de foto por: %s", reason ? reason : "razón no especificada");
+    uint64_t start = esp_timer_get_time();
+    esp_err_t ret = camera_manager_capture(capture_reason, 2000, NULL);
+    metrics_histogram_observe(&take_photo_latency, (uint32_t)(esp_timer_get_time() - start));
+    return ret;
+}
+
+capture_queue_stats_t camera_manager_get_capture_stats(void) {
+    return capture_queue_get_stats();
+}
+
+bool camera_manager_has_photo(void) {
+    return frame_store_has_frame();
 }
 
 camera_info_t camera_manager_get_info(void) {
@@ -319,98 +1237,96 @@ esp_err_t camera_manager_set_brightness(int brightness) {
     }
     
     sensor_t *s = esp_camera_sensor_get();
-    if (s) {
-        s->set_brightness(s, brightness);
-        ESP_LOGI(TAG, "💡 Brillo cambiado a: %d", brightness);
-        return ESP_OK;
+    if (!s || camera_lock == NULL) {
+        return ESP_FAIL;
     }
     
-    return ESP_FAIL;
+    // Pasa por el estado de perfiles para que el siguiente cambio de perfil lo tenga en cuenta
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    esp_err_t ret = sensor_profile_set(&profile_state, SENSOR_REG_BRIGHTNESS, (int16_t)brightness,
+                                       sensor_reg_write, s);
+    xSemaphoreGive(camera_lock);
+    publish_profile_stats();
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "💡 Brillo cambiado a: %d", brightness);
+    }
+    return ret;
 }
 
 esp_err_t camera_manager_optimize_for_low_light(void) {
-    sensor_t *s = esp_camera_sensor_get();
-    if (!s) {
-        ESP_LOGE(TAG, "No se pudo obtener el sensor");
-        return ESP_FAIL;
-    }
-    
     ESP_LOGI(TAG, "🌙 Optimizando cámara para condiciones de poca luz...");
     
-    // Configuración moderada para poca luz
-    s->set_brightness(s, 2);        // Brillo máximo
-    s->set_contrast(s, 1);          // Contraste moderado
-    s->set_saturation(s, 0);        // Saturación normal
-    s->set_ae_level(s, 2);          // Exposición máxima
-    s->set_aec_value(s, 800);       // Tiempo de exposición alto pero no máximo
-    s->set_agc_gain(s, 20);         // Ganancia ISO alta pero no máxima
-    s->set_gainceiling(s, (gainceiling_t)5); // Techo ganancia alto (64x)
-    s->set_aec2(s, 1);              // AEC2 habilitado
-    s->set_raw_gma(s, 1);           // Gamma RAW habilitado
-    s->set_lenc(s, 1);              // Corrección de lente habilitada
-    s->set_bpc(s, 0);               // BPC deshabilitado
-    s->set_wpc(s, 1);               // WPC habilitado
-    s->set_awb_gain(s, 1);          // AWB gain automático
-    s->set_wb_mode(s, 0);           // Modo WB automático
-    s->set_dcw(s, 1);               // DCW habilitado
-    
-    ESP_LOGI(TAG, "✅ Optimización NOCTURNA completada");
-    return ESP_OK;
+    esp_err_t ret = apply_sensor_profile(&low_light_profile);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "✅ Optimización NOCTURNA completada");
+    }
+    return ret;
 }
 
 esp_err_t camera_manager_optimize_for_daylight(void) {
-    sensor_t *s = esp_camera_sensor_get();
-    if (!s) {
-        ESP_LOGE(TAG, "No se pudo obtener el sensor");
-        return ESP_FAIL;
-    }
-    
     ESP_LOGI(TAG, "☀️ Optimizando cámara para condiciones DIURNAS...");
     
-    // Configuración CONSERVADORA para luz del día (evitar sobre-exposición)
-    s->set_brightness(s, -8);       // Brillo reducido para evitar saturación
-    s->set_contrast(s, -10);          // Contraste normal
-    s->set_saturation(s, -1);       // Saturación reducida para colores naturales
-    s->set_ae_level(s, -10);         // Exposición REDUCIDA para evitar quemado
-    s->set_aec_value(s, 150);       // Tiempo de exposición MÁS CORTO
-    s->set_agc_gain(s, 2);          // Ganancia ISO MÁS BAJA
-    s->set_gainceiling(s, (gainceiling_t)1); // Techo ganancia BAJO (4x)
-    s->set_aec2(s, 0);              // AEC2 deshabilitado
-    s->set_raw_gma(s, 1);           // Gamma RAW habilitado
-    s->set_lenc(s, 1);              // Corrección de lente habilitada
-    s->set_bpc(s, 0);               // BPC deshabilitado
-    s->set_wpc(s, 1);               // WPC habilitado
-    s->set_awb_gain(s, 1);          // AWB gain automático
-    s->set_wb_mode(s, 0);           // Modo WB automático
-    s->set_dcw(s, 1);               // DCW habilitado
-
-    ESP_LOGI(TAG, "✅ Optimización DIURNA completada");
-    return ESP_OK;
+    esp_err_t ret = apply_sensor_profile(&daylight_profile);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "✅ Optimización DIURNA completada");
+    }
+    return ret;
 }
 
 esp_err_t camera_manager_auto_optimize_lighting(void) {
+    if (!camera_info.initialized || camera_lock == NULL) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
     ESP_LOGI(TAG, "🔍 Detectando condiciones de luz automáticamente...");
     
     // Tomar una foto de prueba para analizar el brillo
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
     camera_fb_t *test_photo = esp_camera_fb_get();
     if (!test_photo) {
+        xSemaphoreGive(camera_lock);
         ESP_LOGW(TAG, "No se pudo tomar foto de prueba, usando configuración nocturna");
         return camera_manager_optimize_for_low_light();
     }
     
-    // Analizar el brillo promedio de la imagen
-    uint32_t brightness_sum = 0;
-    uint32_t pixel_count = test_photo->len / 3; // Aproximación para análisis
+    // Luminancia media de cada bloque 8x8 a partir de los coeficientes DC del JPEG
+    jpeg_dc_info_t info;
+    uint8_t *luma_map = NULL;
+    esp_err_t ret = jpeg_dc_get_info(test_photo->buf, test_photo->len, &info);
+    if (ret == ESP_OK) {
+        size_t map_size = (size_t)info.map_width * info.map_height;
+        luma_map = malloc(map_size);
+        ret = luma_map ? jpeg_dc_luma_map(test_photo->buf, test_photo->len, luma_map, map_size, &info)
+                       : ESP_ERR_NO_MEM;
+    }
+    esp_camera_fb_return(test_photo);
+    xSemaphoreGive(camera_lock);
     
-    // Muestrear cada 100 píxeles para velocidad
-    for (uint32_t i = 0; i < test_photo->len && i < pixel_count * 3; i += 300) {
-        brightness_sum += test_photo->buf[i];
+    if (ret != ESP_OK) {
+        free(luma_map);
+        ESP_LOGW(TAG, "No se pudo analizar la foto de prueba (%s), usando configuración nocturna",
+                 esp_err_to_name(ret));
+        return camera_manager_optimize_for_low_light();
     }
     
-    uint8_t avg_brightness = brightness_sum / (pixel_count / 100);
-    esp_camera_fb_return(test_photo);
+    jpeg_luma_stats_t *stats = malloc(sizeof(jpeg_luma_stats_t));
+    if (stats == NULL) {
+        free(luma_map);
+        return camera_manager_optimize_for_low_light();
+    }
+    jpeg_luma_stats_compute(luma_map, (size_t)info.map_width * info.map_height, stats);
+    free(luma_map);
     
-    ESP_LOGI(TAG, "💡 Brillo promedio detectado: %d/255", avg_brightness);
+    uint8_t avg_brightness = (uint8_t)(stats->mean + 0.5f);
+    ESP_LOGI(TAG, "💡 Brillo promedio detectado: %d/255 (p10=%d, p50=%d, p90=%d, %lu bloques)",
+             avg_brightness,
+             jpeg_luma_stats_percentile(stats, 10),
+             jpeg_luma_stats_percentile(stats, 50),
+             jpeg_luma_stats_percentile(stats, 90),
+             stats->count);
+    free(stats);
     
     // Decidir configuración basada en el brillo
     if (avg_brightness < 80) {  // Umbral moderado para poca luz
@@ -432,6 +1348,476 @@ esp_err_t camera_manager_set_night_mode(bool night_mode) {
     }
 }
 
+esp_err_t camera_manager_preroll_start(const camera_preroll_config_t *config) {
+    if (config == NULL || config->max_frame_size == 0 || config->frame_interval_ms == 0) {
+        ESP_LOGE(TAG, "Configuración pre-disparo inválida");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (preroll_running) {
+        ESP_LOGW(TAG, "Captura pre-disparo ya activa");
+        return ESP_OK;
+    }
+    
+    // El presupuesto de memoria fija el número de entradas del anillo
+    size_t entry_count = config->memory_budget / config->max_frame_size;
+    // El episodio congelado no debe dejar a la captura continua sin ventana para el siguiente
+    size_t needed = preroll_ring_entries_needed(config->preroll_ms, config->frame_interval_ms);
+    if (entry_count < needed) {
+        ESP_LOGE(TAG, "El anillo (%zu frames de %zu bytes) no cubre dos ventanas de %lu ms "
+                 "(%zu frames)", entry_count, config->max_frame_size, config->preroll_ms, needed);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    esp_err_t err = preroll_ring_init(entry_count, config->max_frame_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    
+    // La tarea de captura intercala los frames pre-disparo entre solicitudes
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    preroll_config = *config;
+    next_preroll_time = esp_timer_get_time();
+    preroll_running = true;
+    xSemaphoreGive(camera_lock);
+    xTaskNotifyGive(capture_task_handle);
+    
+    ESP_LOGI(TAG, "⏪ Captura pre-disparo iniciada (cada %lu ms)", preroll_config.frame_interval_ms);
+    return ESP_OK;
+}
+
+esp_err_t camera_manager_preroll_stop(void) {
+    if (!preroll_running) {
+        return ESP_OK;
+    }
+    
+    preroll_running = false;
+    
+    // El anillo espera al frame en curso de la tarea de captura y a los lectores de
+    // /stream; sin camera_lock para no bloquear las fotos mientras tanto
+    esp_err_t err = preroll_ring_deinit();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Anillo pre-disparo en uso: la captura continua sigue activa");
+        preroll_running = true;
+        xTaskNotifyGive(capture_task_handle);
+        return err;
+    }
+    
+    ESP_LOGI(TAG, "Captura pre-disparo detenida");
+    return ESP_OK;
+}
+
+size_t camera_manager_preroll_freeze(uint32_t episode_id, int64_t trigger_time) {
+    if (!preroll_running || trigger_time < 0) {
+        return 0;
+    }
+    
+    // Solo la ventana hasta el flanco: así el episodio cabe en las entradas reservadas
+    uint64_t until = (uint64_t)trigger_time;
+    uint64_t window = (uint64_t)preroll_config.preroll_ms * 1000;
+    uint64_t since = until > window ? until - window : 0;
+    
+    size_t frozen = preroll_ring_freeze(episode_id, since, until);
+    ESP_LOGI(TAG, "⏪ Episodio #%lu: %zu frames pre-disparo congelados", episode_id, frozen);
+    return frozen;
+}
+
+esp_err_t camera_manager_rate_control_start(const rate_control_config_t *config) {
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // El estado del controlador solo cambia entre capturas
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    esp_err_t ret = rate_control_init(&rate_ctl, config);
+    rate_control_active = (ret == ESP_OK);
+    xSemaphoreGive(camera_lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de control de tamaño inválida");
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&rate_stats_lock);
+    memset(&rate_stats, 0, sizeof(rate_stats));
+    portEXIT_CRITICAL(&rate_stats_lock);
+    
+    ESP_LOGI(TAG, "📏 Control de tamaño activo: %lu bytes/frame, %lu bytes/s, calidad %d-%d",
+             config->target_bytes, config->target_bytes_per_sec, config->min_quality, config->max_quality);
+    return ESP_OK;
+}
+
+void camera_manager_rate_control_stop(void) {
+    if (camera_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    rate_control_active = false;
+    xSemaphoreGive(camera_lock);
+}
+
+rate_control_stats_t camera_manager_get_rate_control_stats(void) {
+    rate_control_stats_t copy;
+    
+    portENTER_CRITICAL(&rate_stats_lock);
+    copy = rate_stats;
+    portEXIT_CRITICAL(&rate_stats_lock);
+    
+    return copy;
+}
+
+esp_err_t camera_manager_dedupe_start(const frame_dedupe_config_t *config) {
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    esp_err_t ret = frame_dedupe_init(&dedupe, config);
+    dedupe_active = (ret == ESP_OK);
+    xSemaphoreGive(camera_lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de deduplicación inválida");
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&dedupe_stats_lock);
+    dedupe_stats = dedupe.stats;
+    portEXIT_CRITICAL(&dedupe_stats_lock);
+    
+    ESP_LOGI(TAG, "🪞 Deduplicación activa: umbral %u bits, un frame al menos cada %lu ms, %s",
+             config->threshold, config->max_gap_ms, config->drop ? "descartando" : "marcando");
+    return ESP_OK;
+}
+
+void camera_manager_dedupe_stop(void) {
+    if (camera_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    dedupe_active = false;
+    xSemaphoreGive(camera_lock);
+}
+
+frame_dedupe_stats_t camera_manager_get_dedupe_stats(void) {
+    frame_dedupe_stats_t copy;
+    
+    portENTER_CRITICAL(&dedupe_stats_lock);
+    copy = dedupe_stats;
+    portEXIT_CRITICAL(&dedupe_stats_lock);
+    
+    return copy;
+}
+
+esp_err_t camera_manager_capture_tier_start(const capture_tier_config_t *config) {
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < CAPTURE_TIER_MAX; i++) {
+        if (config->tiers[i].frame_size > (int)init_frame_size) {
+            ESP_LOGE(TAG, "El modo %s (%d) supera la resolución de inicialización (%d)",
+                     capture_tier_name((capture_tier_t)i), config->tiers[i].frame_size, init_frame_size);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    // Empieza en reposo: la primera actividad sube la resolución
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    capture_tier_stats_t previous = tier_state.stats;
+    esp_err_t ret = capture_tier_init(&tier_state, config, esp_timer_get_time());
+    if (ret == ESP_OK) {
+        tier_state.stats.size_switches = previous.size_switches;
+        tier_state.stats.flushed_frames = previous.flushed_frames;
+        tier_state.stats.flush_timeouts = previous.flush_timeouts;
+        tier_state.stats.max_switch_us = previous.max_switch_us;
+        tier_enabled = true;
+        tier_wake = false;
+        const capture_tier_settings_t *idle = &config->tiers[CAPTURE_TIER_IDLE];
+        if (idle->quality != camera_info.jpeg_quality) {
+            camera_manager_set_quality(idle->quality);
+        }
+        switch_frame_size((framesize_t)idle->frame_size);
+        publish_tier_stats();
+    }
+    xSemaphoreGive(camera_lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de modos de captura inválida");
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "🔭 Modos de captura: reposo %d, activo %d, permanencia %lu ms",
+             config->tiers[CAPTURE_TIER_IDLE].frame_size, config->tiers[CAPTURE_TIER_ACTIVE].frame_size,
+             config->hold_ms);
+    
+    // Despertar la tarea de captura para que programe su espera con el nuevo estado
+    if (capture_task_handle != NULL) {
+        xTaskNotifyGive(capture_task_handle);
+    }
+    return ESP_OK;
+}
+
+void camera_manager_capture_tier_stop(void) {
+    if (camera_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    tier_enabled = false;
+    xSemaphoreGive(camera_lock);
+}
+
+void camera_manager_capture_tier_wake(void) {
+    if (!tier_enabled || capture_task_handle == NULL) {
+        return;
+    }
+    tier_wake = true;
+    xTaskNotifyGive(capture_task_handle);
+}
+
+capture_tier_stats_t camera_manager_get_capture_tier_stats(void) {
+    capture_tier_stats_t copy;
+    
+    portENTER_CRITICAL(&tier_stats_lock);
+    copy = tier_stats;
+    portEXIT_CRITICAL(&tier_stats_lock);
+    
+    return copy;
+}
+
+esp_err_t camera_manager_get_frame_meta(uint32_t *seq, camera_frame_meta_t *meta) {
+    if (meta == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    camera_frame_t *frame = camera_frame_acquire();
+    if (frame == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *meta = frame->meta;
+    if (seq != NULL) {
+        *seq = frame->seq;
+    }
+    camera_frame_release(frame);
+    return ESP_OK;
+}
+
+int camera_frame_meta_to_json(const camera_frame_t *frame, char *buf, size_t size) {
+    const camera_frame_meta_t *meta = &frame->meta;
+    
+    return snprintf(buf, size,
+        "{"
+        "\"seq\":%lu,"
+        "\"size\":%u,"
+        "\"width\":%u,"
+        "\"height\":%u,"
+        "\"timestamp_us\":%llu,"
+        "\"wall_time_ms\":%lld,"
+        "\"reason\":\"%s\","
+        "\"reason_id\":%u,"
+        "\"episode_id\":%lu,"
+        "\"capture_latency_us\":%lu,"
+        "\"burst_frames\":%u,"
+        "\"profile\":\"%s\","
+        "\"aec_value\":%u,"
+        "\"agc_gain\":%u,"
+        "\"ae_level\":%d,"
+        "\"gainceiling\":%u,"
+        "\"quality\":%u,"
+        "\"frame_size\":%u,"
+        "\"phash\":\"%016llx%016llx\","
+        "\"hash_distance\":%d,"
+        "\"duplicate\":%s"
+        "}",
+        frame->seq, (unsigned)frame->len, frame->width, frame->height, frame->timestamp,
+        meta->wall_time_ms, camera_capture_reason_name((camera_capture_reason_t)meta->reason),
+        meta->reason, meta->episode_id, meta->capture_latency_us, meta->burst_frames,
+        meta->profile ? meta->profile : "", meta->aec_value, meta->agc_gain, meta->ae_level,
+        meta->gainceiling, meta->quality, meta->frame_size, meta->phash.brighter, meta->phash.darker,
+        meta->hash_distance == FRAME_HASH_NONE ? -1 : meta->hash_distance,
+        meta->duplicate ? "true" : "false");
+}
+
+sensor_profile_stats_t camera_manager_get_profile_stats(void) {
+    sensor_profile_stats_t copy;
+    
+    portENTER_CRITICAL(&profile_stats_lock);
+    copy = profile_stats;
+    portEXIT_CRITICAL(&profile_stats_lock);
+    
+    return copy;
+}
+
+// Sin capturas recientes el planificador toma su propio frame de prueba
+static esp_err_t probe_scene_luma(float *luma) {
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    camera_fb_t *fb = esp_camera_fb_get();
+    esp_err_t ret = fb ? scene_luma(fb->buf, fb->len, luma) : ESP_FAIL;
+    if (fb) {
+        esp_camera_fb_return(fb);
+    }
+    xSemaphoreGive(camera_lock);
+    return ret;
+}
+
+static const char *format_local_time(int64_t epoch, const char *format, char *buf, size_t len) {
+    time_t t = (time_t)epoch;
+    struct tm tm;
+    
+    if (epoch == 0) {
+        snprintf(buf, len, "--");
+        return buf;
+    }
+    localtime_r(&t, &tm);
+    strftime(buf, len, format, &tm);
+    return buf;
+}
+
+static void log_day_night_switch(const day_night_decision_t *decision, int64_t now) {
+    char when[24];
+    char sunrise[8];
+    char sunset[8];
+    
+    ESP_LOGI(TAG, "🌗 %s: modo %s (causa %s, fase %s, luma %.1f, amanecer %s, atardecer %s)",
+             format_local_time(now, "%Y-%m-%d %H:%M:%S", when, sizeof(when)),
+             day_night_mode_name(decision->mode), day_night_cause_name(decision->cause),
+             day_night_phase_name(decision->phase), decision->luma,
+             format_local_time(decision->sunrise, "%H:%M", sunrise, sizeof(sunrise)),
+             format_local_time(decision->sunset, "%H:%M", sunset, sizeof(sunset)));
+}
+
+// Tarea del planificador: recoge la luminancia medida por la tarea de captura,
+// evalúa cada eval_interval_s y aplica el perfil cuando el modo cambia
+static void day_night_task(void *pvParameters) {
+    const day_night_config_t *config = &day_night.config;
+    uint32_t last_count = 0;
+    
+    ESP_LOGI(TAG, "🌗 Planificador día/noche iniciado");
+    
+    while (day_night_running) {
+        int64_t now = time(NULL);
+        float luma;
+        int64_t sample_time;
+        uint32_t count;
+        
+        portENTER_CRITICAL(&day_night_lock);
+        luma = luma_sample.luma;
+        sample_time = luma_sample.time;
+        count = luma_sample.count;
+        portEXIT_CRITICAL(&day_night_lock);
+        
+        if (count != last_count) {
+            day_night_add_luma(&day_night, sample_time, luma);
+            last_count = count;
+        } else if (now - day_night.last_sample >= (int64_t)config->sample_interval_s &&
+                   probe_scene_luma(&luma) == ESP_OK) {
+            day_night_add_luma(&day_night, now, luma);
+        }
+        
+        day_night_decision_t decision;
+        if (day_night_evaluate(&day_night, now, &decision)) {
+            log_day_night_switch(&decision, now);
+            if (decision.mode == DAY_NIGHT_NIGHT) {
+                camera_manager_optimize_for_low_light();
+            } else {
+                camera_manager_optimize_for_daylight();
+            }
+        }
+        
+        portENTER_CRITICAL(&day_night_lock);
+        day_night_stats = day_night.stats;
+        portEXIT_CRITICAL(&day_night_lock);
+        
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(config->eval_interval_s * 1000));
+    }
+    
+    ESP_LOGI(TAG, "Planificador día/noche detenido");
+    day_night_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t camera_manager_day_night_start(const day_night_config_t *config) {
+    if (config == NULL || config->eval_interval_s == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!camera_info.initialized) {
+        ESP_LOGE(TAG, "Cámara no inicializada");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (day_night_task_handle != NULL) {
+        ESP_LOGW(TAG, "Planificador día/noche ya activo");
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = day_night_init(&day_night, config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración día/noche inválida");
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&day_night_lock);
+    memset(&luma_sample, 0, sizeof(luma_sample));
+    day_night_stats = day_night.stats;
+    portEXIT_CRITICAL(&day_night_lock);
+    
+    // La tarea de captura muestrea los frames que ya toma
+    xSemaphoreTake(camera_lock, portMAX_DELAY);
+    luma_sample_interval_us = (uint64_t)config->sample_interval_s * 1000000;
+    next_luma_sample = 0;
+    day_night_running = true;
+    xSemaphoreGive(camera_lock);
+    
+    if (xTaskCreate(day_night_task, "day_night", DAY_NIGHT_TASK_STACK, NULL,
+                    DAY_NIGHT_TASK_PRIORITY, &day_night_task_handle) != pdPASS) {
+        day_night_running = false;
+        ESP_LOGE(TAG, "❌ Error creando la tarea día/noche");
+        return ESP_FAIL;
+    }
+    
+    if (config->use_solar) {
+        ESP_LOGI(TAG, "🌗 Planificador día/noche: luma %d/%d, posición %.3f, %.3f",
+                 config->night_below, config->day_above, config->latitude, config->longitude);
+    } else {
+        ESP_LOGI(TAG, "🌗 Planificador día/noche: luma %d/%d, sin hora solar",
+                 config->night_below, config->day_above);
+    }
+    return ESP_OK;
+}
+
+void camera_manager_day_night_stop(void) {
+    if (day_night_task_handle == NULL) {
+        return;
+    }
+    
+    day_night_running = false;
+    xTaskNotifyGive(day_night_task_handle);
+    for (int i = 0; i < 50 && day_night_task_handle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+}
+
+day_night_stats_t camera_manager_get_day_night_stats(void) {
+    day_night_stats_t copy;
+    
+    portENTER_CRITICAL(&day_night_lock);
+    copy = day_night_stats;
+    portEXIT_CRITICAL(&day_night_lock);
+    
+    return copy;
+}
+
 esp_err_t camera_manager_set_server_queue(QueueHandle_t queue) {
     server_queue = queue;
     ESP_LOGI(TAG, "Cola del servidor web configurada");
@@ -441,17 +1827,40 @@ esp_err_t camera_manager_set_server_queue(QueueHandle_t queue) {
 esp_err_t camera_manager_deinit(void) {
     ESP_LOGI(TAG, "Desinicializando cámara...");
     
-    // Liberar foto actual
-    if (xSemaphoreTake(photo_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (current_photo) {
-            esp_camera_fb_return(current_photo);
-            current_photo = NULL;
+    // El anillo pre-disparo puede seguir con lectores (/stream, /photo/preroll): en ese caso
+    // no se desmonta nada y se devuelve el error
+    esp_err_t err = camera_manager_preroll_stop();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Anillo pre-disparo en uso: la cámara sigue activa");
+        return err;
+    }
+    
+    // Detener captura continua antes de soltar el driver
+    camera_manager_day_night_stop();
+    camera_manager_rate_control_stop();
+    camera_manager_dedupe_stop();
+    camera_manager_capture_tier_stop();
+    
+    // Detener el servicio de captura (cierra las solicitudes pendientes)
+    if (capture_task_handle != NULL) {
+        capture_running = false;
+        xTaskNotifyGive(capture_task_handle);
+        for (int i = 0; i < 50 && capture_task_handle != NULL; i++) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        if (capture_task_handle != NULL) {
+            ESP_LOGE(TAG, "La tarea de captura no terminó");
+            return ESP_ERR_TIMEOUT;
         }
-        xSemaphoreGive(photo_mutex);
+    }
+    capture_queue_deinit();
+    if (camera_lock != NULL) {
+        vSemaphoreDelete(camera_lock);
+        camera_lock = NULL;
     }
     
     // Desinicializar cámara
-    esp_err_t err = esp_camera_deinit();
+    err = esp_camera_deinit();
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Error desinicializando cámara: %s", esp_err_to_name(err));
     }
@@ -459,10 +1868,11 @@ esp_err_t camera_manager_deinit(void) {
     // Limpiar referencias
     server_queue = NULL;
     
-    // Liberar mutex
-    if (photo_mutex) {
-        vSemaphoreDelete(photo_mutex);
-        photo_mutex = NULL;
+    // Liberar historial y almacén de frames
+    esp_err_t history_err = photo_history_deinit();
+    esp_err_t store_err = frame_store_deinit();
+    if (err == ESP_OK) {
+        err = history_err != ESP_OK ? history_err : store_err;
     }
     
     // Reset información
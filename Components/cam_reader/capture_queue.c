@@ -0,0 +1,244 @@
+// capture_queue.c - Responsabilidad única: orden y agrupación de solicitudes de captura
+#include "capture_queue.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "CAPTURE_QUEUE";
+
+typedef struct {
+    capture_queue_entry_t entry;
+    uint32_t order;           // Orden de llegada (desempate FIFO)
+    bool used;
+} capture_slot_t;
+
+// Variables privadas del módulo
+static capture_slot_t *slots = NULL;
+static size_t slot_count = 0;
+static uint32_t next_order = 0;
+static bool closed = false;
+static capture_queue_stats_t stats = {0};
+static portMUX_TYPE queue_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *reason_names[CAMERA_CAPTURE_REASON_MAX] = {
+    [CAMERA_CAPTURE_REASON_MANUAL] = "solicitud manual",
+    [CAMERA_CAPTURE_REASON_DETECTION] = "detección inicial",
+    [CAMERA_CAPTURE_REASON_PERIODIC] = "objeto permanece presente",
+    [CAMERA_CAPTURE_REASON_HTTP] = "solicitud web",
+    [CAMERA_CAPTURE_REASON_PREROLL] = "pre-disparo",
+};
+
+// true si a debe atenderse antes que b
+static bool slot_before(const capture_slot_t *a, const capture_slot_t *b) {
+    const camera_capture_request_t *ra = &a->entry.request;
+    const camera_capture_request_t *rb = &b->entry.request;
+
+    if (ra->priority != rb->priority) {
+        return ra->priority > rb->priority;
+    }
+    if (ra->deadline != rb->deadline) {
+        // Sin plazo (0) va después de cualquier plazo
+        if (ra->deadline == 0 || rb->deadline == 0) {
+            return rb->deadline == 0;
+        }
+        return ra->deadline < rb->deadline;
+    }
+    return (int32_t)(a->order - b->order) < 0;
+}
+
+static int16_t effective_setting(int16_t requested, int16_t current) {
+    return requested == CAMERA_CAPTURE_KEEP_SETTING ? current : requested;
+}
+
+static uint8_t burst_length(const camera_capture_request_t *request) {
+    return request->burst_frames > 1 ? request->burst_frames : 1;
+}
+
+esp_err_t capture_queue_init(size_t capacity) {
+    if (capacity == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (slots != NULL) {
+        ESP_LOGW(TAG, "Cola ya inicializada");
+        return ESP_OK;
+    }
+
+    slots = calloc(capacity, sizeof(capture_slot_t));
+    if (slots == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    slot_count = capacity;
+    next_order = 0;
+    closed = false;
+    memset(&stats, 0, sizeof(stats));
+
+    return ESP_OK;
+}
+
+void capture_queue_deinit(void) {
+    portENTER_CRITICAL(&queue_lock);
+    capture_slot_t *old = slots;
+    slots = NULL;
+    slot_count = 0;
+    stats.pending = 0;
+    portEXIT_CRITICAL(&queue_lock);
+
+    free(old);
+}
+
+void capture_queue_close(void) {
+    portENTER_CRITICAL(&queue_lock);
+    closed = true;
+    portEXIT_CRITICAL(&queue_lock);
+}
+
+esp_err_t capture_queue_push(const camera_capture_request_t *request, uint64_t now) {
+    if (request == NULL || request->reason >= CAMERA_CAPTURE_REASON_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    portENTER_CRITICAL(&queue_lock);
+    if (slots == NULL || closed) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        for (size_t i = 0; i < slot_count; i++) {
+            if (!slots[i].used) {
+                slots[i].entry.request = *request;
+                slots[i].entry.submit_time = now;
+                slots[i].order = next_order++;
+                slots[i].used = true;
+                stats.submitted++;
+                stats.pending++;
+                ret = ESP_OK;
+                break;
+            }
+        }
+        if (ret != ESP_OK) {
+            stats.rejected++;
+        }
+    }
+    portEXIT_CRITICAL(&queue_lock);
+
+    return ret;
+}
+
+size_t capture_queue_take_expired(uint64_t now, capture_queue_entry_t *expired, size_t max_expired) {
+    size_t count = 0;
+
+    if (expired == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&queue_lock);
+    for (size_t i = 0; i < slot_count && count < max_expired; i++) {
+        capture_slot_t *slot = &slots[i];
+        if (slot->used && slot->entry.request.deadline != 0 && slot->entry.request.deadline <= now) {
+            expired[count++] = slot->entry;
+            slot->used = false;
+            stats.expired++;
+            stats.pending--;
+        }
+    }
+    portEXIT_CRITICAL(&queue_lock);
+
+    return count;
+}
+
+size_t capture_queue_pop_batch(int16_t current_frame_size, int8_t current_quality,
+                               capture_queue_entry_t *batch, size_t max_batch) {
+    size_t count = 0;
+
+    if (batch == NULL || max_batch == 0) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&queue_lock);
+    capture_slot_t *leader = NULL;
+    for (size_t i = 0; i < slot_count; i++) {
+        if (slots[i].used && (leader == NULL || slot_before(&slots[i], leader))) {
+            leader = &slots[i];
+        }
+    }
+
+    if (leader != NULL) {
+        int16_t frame_size = effective_setting(leader->entry.request.frame_size, current_frame_size);
+        int16_t quality = effective_setting(leader->entry.request.quality, current_quality);
+        uint8_t burst = burst_length(&leader->entry.request);
+
+        batch[count++] = leader->entry;
+        leader->used = false;
+
+        // Agrupar las solicitudes que aceptan el mismo frame
+        for (size_t i = 0; i < slot_count && count < max_batch; i++) {
+            capture_slot_t *slot = &slots[i];
+            if (!slot->used ||
+                effective_setting(slot->entry.request.frame_size, current_frame_size) != frame_size ||
+                effective_setting(slot->entry.request.quality, current_quality) != quality ||
+                burst_length(&slot->entry.request) > burst) {
+                continue;
+            }
+            batch[count++] = slot->entry;
+            slot->used = false;
+        }
+
+        // El líder define la configuración efectiva de todo el lote
+        batch[0].request.frame_size = frame_size;
+        batch[0].request.quality = (int8_t)quality;
+
+        stats.batches++;
+        stats.coalesced += count - 1;
+        stats.pending -= count;
+    }
+    portEXIT_CRITICAL(&queue_lock);
+
+    return count;
+}
+
+uint64_t capture_queue_next_deadline(void) {
+    uint64_t next = 0;
+
+    portENTER_CRITICAL(&queue_lock);
+    for (size_t i = 0; i < slot_count; i++) {
+        uint64_t deadline = slots[i].entry.request.deadline;
+        if (slots[i].used && deadline != 0 && (next == 0 || deadline < next)) {
+            next = deadline;
+        }
+    }
+    portEXIT_CRITICAL(&queue_lock);
+
+    return next;
+}
+
+capture_queue_stats_t capture_queue_get_stats(void) {
+    capture_queue_stats_t copy;
+
+    portENTER_CRITICAL(&queue_lock);
+    copy = stats;
+    portEXIT_CRITICAL(&queue_lock);
+
+    return copy;
+}
+
+const char* camera_capture_reason_name(camera_capture_reason_t reason) {
+    if (reason >= CAMERA_CAPTURE_REASON_MAX) {
+        return "desconocida";
+    }
+    return reason_names[reason];
+}
+
+camera_capture_reason_t camera_capture_reason_from_name(const char *name) {
+    if (name == NULL) {
+        return CAMERA_CAPTURE_REASON_MANUAL;
+    }
+    // El pre-disparo no pasa por la cola: su nombre no es una razón válida de solicitud
+    for (int reason = 0; reason < CAMERA_CAPTURE_REASON_MAX; reason++) {
+        if (reason != CAMERA_CAPTURE_REASON_PREROLL && strcmp(name, reason_names[reason]) == 0) {
+            return (camera_capture_reason_t)reason;
+        }
+    }
+    return CAMERA_CAPTURE_REASON_MANUAL;
+}
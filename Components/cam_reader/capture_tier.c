@@ -0,0 +1,113 @@
+// capture_tier.c - Responsabilidad única: decidir la resolución según la actividad
+//
+// En reposo la cámara solo alimenta la vista previa, el pre-disparo y el análisis de
+// escena, que no necesitan HD: cada frame VGA mueve un tercio de los bytes por PSRAM y
+// Wi-Fi. La actividad (flanco del sensor o foto de un episodio) pasa a ACTIVE y lo
+// mantiene hold_ms tras la última, así las fotos periódicas del episodio no alternan
+// de resolución. Cada modo recuerda su calidad: el control de tamaño la ajusta para
+// la resolución en uso y al volver no hay que reconverger desde la del otro modo.
+#include "capture_tier.h"
+#include "jpeg_dc.h"
+#include <string.h>
+
+static const char *tier_names[] = { "reposo", "activo" };
+
+esp_err_t capture_tier_init(capture_tier_state_t *state, const capture_tier_config_t *config, uint64_t now) {
+    if (state == NULL || config == NULL || config->hold_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < CAPTURE_TIER_MAX; i++) {
+        const capture_tier_settings_t *tier = &config->tiers[i];
+        if (tier->frame_size < 0 || tier->quality < 10 || tier->quality > 63) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->config = *config;
+    for (int i = 0; i < CAPTURE_TIER_MAX; i++) {
+        state->quality[i] = config->tiers[i].quality;
+    }
+    state->stats.tier = CAPTURE_TIER_IDLE;
+    state->tier_since = now;
+    return ESP_OK;
+}
+
+void capture_tier_activity(capture_tier_state_t *state, uint64_t now) {
+    uint64_t until = now + (uint64_t)state->config.hold_ms * 1000;
+    if (until > state->active_until) {
+        state->active_until = until;
+    }
+}
+
+capture_tier_t capture_tier_target(const capture_tier_state_t *state, uint64_t now) {
+    return now < state->active_until ? CAPTURE_TIER_ACTIVE : CAPTURE_TIER_IDLE;
+}
+
+uint64_t capture_tier_next_deadline(const capture_tier_state_t *state) {
+    return state->stats.tier == CAPTURE_TIER_ACTIVE ? state->active_until : 0;
+}
+
+void capture_tier_enter(capture_tier_state_t *state, capture_tier_t tier, int8_t current_quality,
+                        uint64_t now, capture_tier_settings_t *apply) {
+    capture_tier_t previous = state->stats.tier;
+
+    if (tier != previous) {
+        state->stats.time_us[previous] += now - state->tier_since;
+        state->tier_since = now;
+        state->quality[previous] = current_quality;
+        state->stats.tier = tier;
+        if (tier == CAPTURE_TIER_ACTIVE) {
+            state->stats.switches_up++;
+        } else {
+            state->stats.switches_down++;
+        }
+    }
+
+    apply->frame_size = state->config.tiers[tier].frame_size;
+    apply->quality = state->quality[tier];
+}
+
+void capture_tier_record_switch(capture_tier_state_t *state, uint32_t latency_us, uint8_t flushed,
+                                bool timeout) {
+    state->stats.size_switches++;
+    state->stats.flushed_frames += flushed;
+    state->stats.last_switch_us = latency_us;
+    if (latency_us > state->stats.max_switch_us) {
+        state->stats.max_switch_us = latency_us;
+    }
+    if (timeout) {
+        state->stats.flush_timeouts++;
+    }
+}
+
+uint8_t capture_tier_flush(const capture_tier_state_t *state, capture_tier_get_fn get,
+                           capture_tier_put_fn put, uint16_t width, uint16_t height, bool *fresh) {
+    uint8_t flushed = 0;
+    *fresh = false;
+    while (!*fresh && flushed < state->config.max_flush_frames) {
+        capture_tier_frame_t frame = { 0 };
+        if (!get(&frame)) {
+            break;
+        }
+        jpeg_dc_info_t info;
+        *fresh = jpeg_dc_get_info(frame.buf, frame.len, &info) == ESP_OK &&
+                 info.width == width && info.height == height;
+        put(&frame);
+        if (!*fresh) {
+            flushed++;
+        }
+    }
+    return flushed;
+}
+
+void capture_tier_get_stats(const capture_tier_state_t *state, uint64_t now, capture_tier_stats_t *stats) {
+    *stats = state->stats;
+    if (now > state->tier_since) {
+        stats->time_us[stats->tier] += now - state->tier_since;
+    }
+}
+
+const char* capture_tier_name(capture_tier_t tier) {
+    return tier < CAPTURE_TIER_MAX ? tier_names[tier] : "?";
+}
@@ -0,0 +1,229 @@
+// day_night.c - Responsabilidad única: decidir el perfil día/noche sin oscilaciones
+//
+// La luminancia media de los frames decide dentro de una banda de histéresis
+// (night_below < day_above). La hora solar endurece el umbral contrario a la fase:
+// de día hace falta una escena mucho más oscura para pasar a noche y de noche una
+// linterna no basta para pasar a día. Cerca del amanecer y del atardecer solo
+// decide la luminancia, y sin muestras recientes decide la hora solar.
+#include "day_night.h"
+#include <string.h>
+#include <math.h>
+
+#define WALL_CLOCK_VALID_SEC    1577836800  // 2020-01-01: antes el reloj no está sincronizado
+#define JULIAN_UNIX_EPOCH       2440587.5
+#define JULIAN_2000             2451545.0
+#define DEG_TO_RAD              (M_PI / 180.0)
+
+static const char *mode_names[] = {
+    [DAY_NIGHT_UNKNOWN] = "desconocido",
+    [DAY_NIGHT_DAY] = "día",
+    [DAY_NIGHT_NIGHT] = "noche",
+};
+
+static const char *phase_names[] = {
+    [SOLAR_PHASE_UNKNOWN] = "desconocida",
+    [SOLAR_PHASE_DAY] = "día",
+    [SOLAR_PHASE_TWILIGHT] = "crepúsculo",
+    [SOLAR_PHASE_NIGHT] = "noche",
+};
+
+static const char *cause_names[] = {
+    [DAY_NIGHT_CAUSE_NONE] = "-",
+    [DAY_NIGHT_CAUSE_INITIAL] = "inicial",
+    [DAY_NIGHT_CAUSE_LUMA] = "luminancia",
+    [DAY_NIGHT_CAUSE_SOLAR] = "hora solar",
+};
+
+// Ecuación del amanecer (algoritmo simplificado de la NOAA, precisión de ~1 minuto).
+// Devuelve el coseno del ángulo horario del ocaso; fuera de [-1, 1] no hay amanecer/atardecer.
+static double sun_equation(double latitude, double longitude, int64_t now,
+                           double *transit, double *half_day) {
+    // Día solar local: el que tiene el mediodía solar más cercano a now
+    double julian = now / 86400.0 + JULIAN_UNIX_EPOCH;
+    double n = round(julian - JULIAN_2000 + longitude / 360.0);
+    double mean_solar = n - longitude / 360.0;
+    double anomaly = fmod(357.5291 + 0.98560028 * mean_solar, 360.0);
+    double m = anomaly * DEG_TO_RAD;
+    double center = 1.9148 * sin(m) + 0.02 * sin(2 * m) + 0.0003 * sin(3 * m);
+    double ecliptic = fmod(anomaly + center + 180.0 + 102.9372, 360.0) * DEG_TO_RAD;
+    double declination = asin(sin(ecliptic) * sin(23.4397 * DEG_TO_RAD));
+    double phi = latitude * DEG_TO_RAD;
+
+    *transit = JULIAN_2000 + mean_solar + 0.0053 * sin(m) - 0.0069 * sin(2 * ecliptic);
+    double cos_omega = (sin(-0.833 * DEG_TO_RAD) - sin(phi) * sin(declination)) /
+                       (cos(phi) * cos(declination));
+    *half_day = cos_omega >= -1.0 && cos_omega <= 1.0 ? acos(cos_omega) / DEG_TO_RAD / 360.0 : 0.0;
+    return cos_omega;
+}
+
+static int64_t julian_to_epoch(double julian) {
+    return (int64_t)llround((julian - JULIAN_UNIX_EPOCH) * 86400.0);
+}
+
+esp_err_t day_night_sun_times(float latitude, float longitude, int64_t now,
+                              int64_t *sunrise, int64_t *sunset) {
+    double transit, half_day;
+    double cos_omega = sun_equation(latitude, longitude, now, &transit, &half_day);
+
+    if (cos_omega < -1.0 || cos_omega > 1.0) {
+        *sunrise = 0;
+        *sunset = 0;
+        return ESP_ERR_NOT_FOUND;
+    }
+    *sunrise = julian_to_epoch(transit - half_day);
+    *sunset = julian_to_epoch(transit + half_day);
+    return ESP_OK;
+}
+
+static solar_phase_t solar_phase(const day_night_config_t *config, int64_t now,
+                                 int64_t *sunrise, int64_t *sunset) {
+    *sunrise = 0;
+    *sunset = 0;
+    if (!config->use_solar || now < WALL_CLOCK_VALID_SEC) {
+        return SOLAR_PHASE_UNKNOWN;
+    }
+
+    double transit, half_day;
+    double cos_omega = sun_equation(config->latitude, config->longitude, now, &transit, &half_day);
+    if (cos_omega > 1.0) {
+        return SOLAR_PHASE_NIGHT;   // Noche polar
+    }
+    if (cos_omega < -1.0) {
+        return SOLAR_PHASE_DAY;     // Día polar
+    }
+
+    *sunrise = julian_to_epoch(transit - half_day);
+    *sunset = julian_to_epoch(transit + half_day);
+    int64_t margin = config->twilight_s;
+    if (now < *sunrise - margin || now > *sunset + margin) {
+        return SOLAR_PHASE_NIGHT;
+    }
+    if (now > *sunrise + margin && now < *sunset - margin) {
+        return SOLAR_PHASE_DAY;
+    }
+    return SOLAR_PHASE_TWILIGHT;
+}
+
+esp_err_t day_night_init(day_night_t *dn, const day_night_config_t *config) {
+    if (dn == NULL || config == NULL || config->night_below >= config->day_above ||
+        config->smoothing <= 0.0f || config->smoothing > 1.0f ||
+        config->latitude < -90.0f || config->latitude > 90.0f ||
+        config->longitude < -180.0f || config->longitude > 180.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(dn, 0, sizeof(*dn));
+    dn->config = *config;
+    dn->luma = -1.0f;
+    dn->stats.luma = -1.0f;
+    return ESP_OK;
+}
+
+void day_night_add_luma(day_night_t *dn, int64_t now, float luma) {
+    dn->luma = dn->luma < 0 ? luma : dn->config.smoothing * luma + (1.0f - dn->config.smoothing) * dn->luma;
+    dn->last_sample = now;
+    dn->stats.samples++;
+    dn->stats.luma = dn->luma;
+}
+
+bool day_night_evaluate(day_night_t *dn, int64_t now, day_night_decision_t *decision) {
+    const day_night_config_t *config = &dn->config;
+    day_night_mode_t mode = dn->stats.mode;
+    day_night_mode_t wanted = mode;
+    day_night_cause_t cause = DAY_NIGHT_CAUSE_NONE;
+
+    decision->phase = solar_phase(config, now, &decision->sunrise, &decision->sunset);
+    decision->luma = dn->luma;
+    decision->changed = false;
+    dn->stats.evaluations++;
+    dn->stats.phase = decision->phase;
+
+    bool fresh = dn->luma >= 0 && now - dn->last_sample <= (int64_t)config->luma_stale_s;
+    day_night_mode_t solar_mode = decision->phase == SOLAR_PHASE_DAY ? DAY_NIGHT_DAY :
+                                  decision->phase == SOLAR_PHASE_NIGHT ? DAY_NIGHT_NIGHT : DAY_NIGHT_UNKNOWN;
+
+    if (mode == DAY_NIGHT_UNKNOWN) {
+        // Primera decisión: la fase solar si es clara, si no el centro de la banda
+        if (solar_mode != DAY_NIGHT_UNKNOWN) {
+            wanted = solar_mode;
+        } else if (fresh) {
+            wanted = dn->luma < (config->night_below + config->day_above) / 2.0f ? DAY_NIGHT_NIGHT : DAY_NIGHT_DAY;
+        } else {
+            decision->mode = mode;
+            decision->cause = DAY_NIGHT_CAUSE_NONE;
+            return false;
+        }
+        dn->stats.mode = wanted;
+        dn->stats.last_switch = now;
+        dn->pending_since = 0;
+        decision->changed = true;
+        decision->mode = wanted;
+        decision->cause = DAY_NIGHT_CAUSE_INITIAL;
+        return true;
+    }
+
+    if (fresh) {
+        float night_threshold = config->night_below;
+        float day_threshold = config->day_above;
+        if (decision->phase == SOLAR_PHASE_DAY) {
+            night_threshold -= config->solar_bias;
+        } else if (decision->phase == SOLAR_PHASE_NIGHT) {
+            day_threshold += config->solar_bias;
+        }
+        if (mode == DAY_NIGHT_DAY && dn->luma < night_threshold) {
+            wanted = DAY_NIGHT_NIGHT;
+        } else if (mode == DAY_NIGHT_NIGHT && dn->luma > day_threshold) {
+            wanted = DAY_NIGHT_DAY;
+        }
+        cause = DAY_NIGHT_CAUSE_LUMA;
+    } else if (solar_mode != DAY_NIGHT_UNKNOWN) {
+        wanted = solar_mode;
+        cause = DAY_NIGHT_CAUSE_SOLAR;
+    }
+
+    decision->mode = mode;
+    decision->cause = DAY_NIGHT_CAUSE_NONE;
+    if (wanted == mode) {
+        dn->pending_since = 0;
+        return false;
+    }
+
+    // La condición debe mantenerse confirm_s y el modo actual haber durado min_dwell_s
+    if (dn->pending_since == 0) {
+        dn->pending_since = now;
+    }
+    if (now - dn->pending_since < (int64_t)config->confirm_s) {
+        return false;
+    }
+    if (now - dn->stats.last_switch < (int64_t)config->min_dwell_s) {
+        dn->stats.dwell_blocked++;
+        return false;
+    }
+
+    dn->stats.mode = wanted;
+    dn->stats.last_switch = now;
+    dn->stats.switches++;
+    if (cause == DAY_NIGHT_CAUSE_LUMA) {
+        dn->stats.luma_switches++;
+    } else {
+        dn->stats.solar_switches++;
+    }
+    dn->pending_since = 0;
+
+    decision->changed = true;
+    decision->mode = wanted;
+    decision->cause = cause;
+    return true;
+}
+
+const char* day_night_mode_name(day_night_mode_t mode) {
+    return mode <= DAY_NIGHT_NIGHT ? mode_names[mode] : "?";
+}
+
+const char* day_night_phase_name(solar_phase_t phase) {
+    return phase <= SOLAR_PHASE_NIGHT ? phase_names[phase] : "?";
+}
+
+const char* day_night_cause_name(day_night_cause_t cause) {
+    return cause <= DAY_NIGHT_CAUSE_SOLAR ? cause_names[cause] : "?";
+}
@@ -0,0 +1,93 @@
+// frame_analysis.c - Responsabilidad única: puntuar nitidez y exposición de un frame
+#include "frame_analysis.h"
+#include "jpeg_dc.h"
+#include <string.h>
+
+// Límites de saturación por bloque 8x8
+#define CLIP_LOW    8
+#define CLIP_HIGH   247
+
+void frame_analysis_score_map(const uint8_t *map, uint16_t width, uint16_t height,
+                              frame_quality_t *quality) {
+    frame_analysis_score_map_ac(map, width, height, NULL, quality);
+}
+
+void frame_analysis_score_map_ac(const uint8_t *map, uint16_t width, uint16_t height,
+                                 const jpeg_ac_energy_t *ac, frame_quality_t *quality) {
+    memset(quality, 0, sizeof(*quality));
+
+    size_t count = (size_t)width * height;
+    if (map == NULL || count == 0) {
+        return;
+    }
+
+    uint64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint32_t clipped = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = map[i];
+        sum += v;
+        sum_sq += v * v;
+        if (v < CLIP_LOW || v > CLIP_HIGH) {
+            clipped++;
+        }
+    }
+
+    float mean = (float)sum / count;
+    float variance = (float)sum_sq / count - mean * mean;
+
+    // Laplaciano de 4 vecinos sobre el interior: el desenfoque por movimiento lo reduce
+    // más que a la varianza, así que el cociente no depende de la ganancia del sensor
+    uint64_t lap_sq = 0;
+    if (width >= 3 && height >= 3) {
+        for (uint16_t y = 1; y + 1 < height; y++) {
+            const uint8_t *row = map + (size_t)y * width;
+            for (uint16_t x = 1; x + 1 < width; x++) {
+                int32_t lap = 4 * row[x] - row[x - 1] - row[x + 1] - row[x - width] - row[x + width];
+                lap_sq += (uint64_t)(lap * lap);
+            }
+        }
+        size_t inner = (size_t)(width - 2) * (height - 2);
+        quality->sharpness = ((float)lap_sq / inner) / (variance + 1.0f);
+    }
+
+    // Detalle dentro de los bloques: un desenfoque de pocos píxeles apenas mueve el mapa
+    // pero vacía los AC. Como cociente de varianzas tampoco depende de la ganancia
+    if (ac != NULL && ac->blocks > 0) {
+        quality->detail = ((float)ac->sum / ac->blocks) / (variance + 1.0f);
+        quality->sharpness *= quality->detail;
+    }
+
+    // Exposición: fracción útil de bloques y distancia de la media al objetivo
+    float clipped_fraction = (float)clipped / count;
+    float distance = (mean - FRAME_ANALYSIS_TARGET_LUMA) / FRAME_ANALYSIS_TARGET_LUMA;
+    if (distance < 0) {
+        distance = -distance;
+    }
+    if (distance > 1.0f) {
+        distance = 1.0f;
+    }
+
+    quality->mean = (uint8_t)(mean + 0.5f);
+    quality->clipped = clipped_fraction;
+    quality->exposure = (1.0f - clipped_fraction) * (1.0f - 0.5f * distance);
+    quality->score = quality->sharpness * quality->exposure;
+}
+
+esp_err_t frame_analysis_score_jpeg(const uint8_t *jpeg, size_t len, uint8_t *map_buf,
+                                    size_t map_capacity, frame_quality_t *quality) {
+    if (quality == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_dc_info_t info;
+    jpeg_ac_energy_t ac;
+    esp_err_t ret = jpeg_dc_luma_map_ac(jpeg, len, map_buf, map_capacity, &info, &ac);
+    if (ret != ESP_OK) {
+        memset(quality, 0, sizeof(*quality));
+        return ret;
+    }
+
+    frame_analysis_score_map_ac(map_buf, info.map_width, info.map_height, &ac, quality);
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+// frame_dedupe.c - Responsabilidad única: detectar fotos periódicas casi idénticas
+//
+// Mientras una gallina está echada, las fotos periódicas son casi iguales. El hash
+// de diferencias (dHash) resume la estructura de la escena en 128 bits a partir del
+// mapa DC que ya se decodifica para otros análisis; dos frames con pocos bits
+// distintos son la misma escena aunque cambien el ruido, la compresión o la exposición.
+// A diferencia del dHash clásico, las celdas casi iguales no aportan bits: con una
+// sola comparación por bit, el ruido de ganancia nocturno invertía un tercio del hash.
+#include "frame_dedupe.h"
+#include <string.h>
+
+void frame_hash_map(const uint8_t *map, uint16_t width, uint16_t height, frame_hash_t *hash) {
+    hash->brighter = 0;
+    hash->darker = 0;
+    if (map == NULL || width == 0 || height == 0) {
+        return;
+    }
+
+    // Promedio por celda; mapas más pequeños que la rejilla repiten píxeles
+    uint32_t cells[FRAME_HASH_ROWS][FRAME_HASH_COLS];
+    for (int row = 0; row < FRAME_HASH_ROWS; row++) {
+        uint32_t y0 = (uint32_t)row * height / FRAME_HASH_ROWS;
+        uint32_t y1 = (uint32_t)(row + 1) * height / FRAME_HASH_ROWS;
+        if (y1 <= y0) {
+            y1 = y0 + 1;
+        }
+        for (int col = 0; col < FRAME_HASH_COLS; col++) {
+            uint32_t x0 = (uint32_t)col * width / FRAME_HASH_COLS;
+            uint32_t x1 = (uint32_t)(col + 1) * width / FRAME_HASH_COLS;
+            if (x1 <= x0) {
+                x1 = x0 + 1;
+            }
+            uint32_t sum = 0;
+            for (uint32_t y = y0; y < y1; y++) {
+                const uint8_t *line = map + (size_t)y * width;
+                for (uint32_t x = x0; x < x1; x++) {
+                    sum += line[x];
+                }
+            }
+            // Escala x16 para conservar la fracción del promedio
+            cells[row][col] = sum * 16 / ((y1 - y0) * (x1 - x0));
+        }
+    }
+
+    for (int row = 0; row < FRAME_HASH_ROWS; row++) {
+        for (int col = 0; col < FRAME_HASH_COLS - 1; col++) {
+            uint32_t left = cells[row][col];
+            uint32_t right = cells[row][col + 1];
+            hash->brighter = (hash->brighter << 1) | (left > right + FRAME_HASH_MARGIN_X16);
+            hash->darker = (hash->darker << 1) | (right > left + FRAME_HASH_MARGIN_X16);
+        }
+    }
+}
+
+esp_err_t frame_dedupe_init(frame_dedupe_t *dedupe, const frame_dedupe_config_t *config) {
+    if (dedupe == NULL || config == NULL || config->threshold > FRAME_HASH_MAX_DISTANCE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(dedupe, 0, sizeof(*dedupe));
+    dedupe->config = *config;
+    dedupe->stats.last_distance = FRAME_HASH_NONE;
+    return ESP_OK;
+}
+
+void frame_dedupe_keep(frame_dedupe_t *dedupe, const frame_hash_t *hash, uint64_t timestamp) {
+    dedupe->reference = *hash;
+    dedupe->reference_time = timestamp;
+    dedupe->has_reference = true;
+}
+
+bool frame_dedupe_check(frame_dedupe_t *dedupe, const frame_hash_t *hash, uint64_t timestamp,
+                        size_t size, uint8_t *distance) {
+    uint8_t d = dedupe->has_reference ? frame_hash_distance(hash, &dedupe->reference) : FRAME_HASH_NONE;
+
+    dedupe->stats.hashed++;
+    dedupe->stats.last_distance = d;
+    if (distance != NULL) {
+        *distance = d;
+    }
+
+    if (d != FRAME_HASH_NONE && d < dedupe->config.threshold) {
+        uint64_t max_gap = (uint64_t)dedupe->config.max_gap_ms * 1000;
+        if (max_gap == 0 || timestamp - dedupe->reference_time < max_gap) {
+            dedupe->stats.duplicates++;
+            dedupe->stats.bytes_saved += size;
+            return true;
+        }
+        dedupe->stats.forced++;
+    }
+
+    dedupe->stats.kept++;
+    frame_dedupe_keep(dedupe, hash, timestamp);
+    return false;
+}
@@ -0,0 +1,51 @@
+// frame_refs.c - Responsabilidad única: esperar a que un almacén de frames quede sin referencias
+//
+// frame_store, preroll_ring y photo_history entregan punteros a su memoria con un contador
+// de referencias. Liberarla con lectores vivos (un cliente de /stream enviando un frame)
+// es un uso tras liberar; este cierre común impide nuevas adquisiciones, espera a que las
+// vivas terminen y solo entonces deja liberar. Los logs quedan fuera de la sección crítica.
+#include "frame_refs.h"
+#include "esp_log.h"
+#include "freertos/task.h"
+
+#define FRAME_REFS_POLL_MS      10
+
+static size_t count_busy(portMUX_TYPE *lock, frame_refs_busy_fn busy) {
+    size_t pending;
+
+    portENTER_CRITICAL(lock);
+    pending = busy();
+    portEXIT_CRITICAL(lock);
+
+    return pending;
+}
+
+esp_err_t frame_refs_drain(portMUX_TYPE *lock, bool *closing, frame_refs_busy_fn busy,
+                           uint32_t timeout_ms, const char *tag) {
+    size_t pending;
+    uint32_t waited = 0;
+
+    portENTER_CRITICAL(lock);
+    *closing = true;
+    pending = busy();
+    portEXIT_CRITICAL(lock);
+
+    if (pending > 0) {
+        ESP_LOGI(tag, "Esperando a que se suelten %zu referencias", pending);
+    }
+    while (pending > 0 && waited < timeout_ms) {
+        vTaskDelay(pdMS_TO_TICKS(FRAME_REFS_POLL_MS));
+        waited += FRAME_REFS_POLL_MS;
+        pending = count_busy(lock, busy);
+    }
+
+    if (pending > 0) {
+        portENTER_CRITICAL(lock);
+        *closing = false;
+        portEXIT_CRITICAL(lock);
+        ESP_LOGE(tag, "No se libera: %zu referencias siguen activas tras %lu ms",
+                 pending, timeout_ms);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
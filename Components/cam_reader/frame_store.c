@@ -0,0 +1,286 @@
+// frame_store.c - Responsabilidad única: almacenamiento de frames con referencias
+#include "frame_store.h"
+#include "frame_refs.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "FRAME_STORE";
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_WRITING,
+    SLOT_READY
+} slot_state_t;
+
+typedef struct {
+    camera_frame_t frame;     // Debe ser el primer miembro (handle público)
+    uint8_t *data;
+    size_t capacity;
+    uint8_t *thumb_data;
+    size_t thumb_capacity;
+    uint32_t refcount;
+    slot_state_t state;
+} frame_slot_t;
+
+// Variables privadas del módulo
+static frame_slot_t *slots = NULL;
+static size_t slot_count = 0;
+static frame_slot_t *latest = NULL;
+static uint32_t next_seq = 0;
+static frame_store_stats_t stats = {0};
+static bool closing = false;
+static portMUX_TYPE store_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void *alloc_slot_buffer(size_t size) {
+#if CONFIG_SPIRAM
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    return malloc(size);
+#endif
+}
+
+static void free_slot_table(frame_slot_t *table, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(table[i].data);
+        free(table[i].thumb_data);
+    }
+    free(table);
+}
+
+static void free_slot_buffers(void) {
+    free_slot_table(slots, slot_count);
+    slots = NULL;
+    slot_count = 0;
+}
+
+// Slots con lectores o en escritura (con store_lock tomado)
+static size_t busy_slots(void) {
+    size_t busy = 0;
+
+    for (size_t i = 0; i < slot_count; i++) {
+        if (slots[i].refcount > 0 || slots[i].state == SLOT_WRITING) {
+            busy++;
+        }
+    }
+    return busy;
+}
+
+esp_err_t frame_store_init(const frame_store_config_t *config) {
+    if (config == NULL || config->slot_count < 2 || config->slot_size == 0) {
+        ESP_LOGE(TAG, "Configuración inválida");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (slots != NULL) {
+        ESP_LOGW(TAG, "Almacén ya inicializado");
+        return ESP_OK;
+    }
+
+    slots = calloc(config->slot_count, sizeof(frame_slot_t));
+    if (slots == NULL) {
+        ESP_LOGE(TAG, "Error asignando tabla de slots");
+        return ESP_ERR_NO_MEM;
+    }
+    slot_count = config->slot_count;
+
+    for (size_t i = 0; i < slot_count; i++) {
+        slots[i].data = alloc_slot_buffer(config->slot_size);
+        if (slots[i].data == NULL) {
+            ESP_LOGE(TAG, "Error asignando slot %zu (%zu bytes)", i, config->slot_size);
+            free_slot_buffers();
+            return ESP_ERR_NO_MEM;
+        }
+        slots[i].capacity = config->slot_size;
+        slots[i].frame.buf = slots[i].data;
+
+        if (config->thumb_size > 0) {
+            slots[i].thumb_data = alloc_slot_buffer(config->thumb_size);
+            if (slots[i].thumb_data == NULL) {
+                ESP_LOGE(TAG, "Error asignando miniatura del slot %zu (%zu bytes)", i, config->thumb_size);
+                free_slot_buffers();
+                return ESP_ERR_NO_MEM;
+            }
+            slots[i].thumb_capacity = config->thumb_size;
+            slots[i].frame.thumb = slots[i].thumb_data;
+        }
+        slots[i].state = SLOT_FREE;
+    }
+
+    latest = NULL;
+    next_seq = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    ESP_LOGI(TAG, "Almacén de frames listo: %zu slots de %zu KB (+%zu KB de miniatura)",
+             slot_count, config->slot_size / 1024, config->thumb_size / 1024);
+    return ESP_OK;
+}
+
+esp_err_t frame_store_deinit(void) {
+    if (slots == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = frame_refs_drain(&store_lock, &closing, busy_slots, FRAME_REFS_DRAIN_MS, TAG);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Sin referencias: retirar la tabla bajo el lock y liberarla fuera
+    portENTER_CRITICAL(&store_lock);
+    frame_slot_t *table = slots;
+    size_t count = slot_count;
+    slots = NULL;
+    slot_count = 0;
+    latest = NULL;
+    closing = false;
+    portEXIT_CRITICAL(&store_lock);
+
+    free_slot_table(table, count);
+    return ESP_OK;
+}
+
+camera_frame_t* frame_store_begin_write(size_t len, uint8_t **data) {
+    if (data == NULL) {
+        return NULL;
+    }
+    *data = NULL;
+
+    frame_slot_t *target = NULL;
+
+    portENTER_CRITICAL(&store_lock);
+    if (slots == NULL || closing) {
+        portEXIT_CRITICAL(&store_lock);
+        return NULL;
+    }
+    if (len > slots[0].capacity) {
+        stats.dropped_too_large++;
+        portEXIT_CRITICAL(&store_lock);
+        return NULL;
+    }
+
+    // Reutilizar el slot libre más antiguo que nadie esté leyendo
+    for (size_t i = 0; i < slot_count; i++) {
+        frame_slot_t *slot = &slots[i];
+        if (slot->state == SLOT_WRITING || slot->refcount > 0 || slot == latest) {
+            continue;
+        }
+        if (target == NULL || slot->state == SLOT_FREE ||
+            (target->state == SLOT_READY && slot->frame.seq < target->frame.seq)) {
+            target = slot;
+            if (slot->state == SLOT_FREE) {
+                break;
+            }
+        }
+    }
+
+    if (target != NULL) {
+        target->state = SLOT_WRITING;
+        target->frame.len = len;
+        target->frame.thumb_len = 0;
+        target->frame.seq = 0;
+        memset(&target->frame.meta, 0, sizeof(target->frame.meta));
+    } else {
+        stats.dropped_no_slot++;
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    if (target == NULL) {
+        return NULL;
+    }
+
+    *data = target->data;
+    return &target->frame;
+}
+
+uint8_t* frame_store_thumb_buffer(camera_frame_t *frame, size_t *capacity) {
+    frame_slot_t *slot = (frame_slot_t *)frame;
+
+    if (capacity != NULL) {
+        *capacity = slot != NULL ? slot->thumb_capacity : 0;
+    }
+    return slot != NULL ? slot->thumb_data : NULL;
+}
+
+uint32_t frame_store_commit(camera_frame_t *frame) {
+    frame_slot_t *slot = (frame_slot_t *)frame;
+    uint32_t seq;
+
+    portENTER_CRITICAL(&store_lock);
+    seq = ++next_seq;
+    slot->frame.seq = seq;
+    slot->state = SLOT_READY;
+    latest = slot;
+    stats.published++;
+    portEXIT_CRITICAL(&store_lock);
+
+    return seq;
+}
+
+void frame_store_abort(camera_frame_t *frame) {
+    frame_slot_t *slot = (frame_slot_t *)frame;
+
+    portENTER_CRITICAL(&store_lock);
+    slot->state = SLOT_FREE;
+    slot->frame.len = 0;
+    slot->frame.thumb_len = 0;
+    portEXIT_CRITICAL(&store_lock);
+}
+
+camera_frame_t* camera_frame_acquire(void) {
+    camera_frame_t *frame = NULL;
+
+    portENTER_CRITICAL(&store_lock);
+    if (latest != NULL && !closing) {
+        latest->refcount++;
+        stats.acquires++;
+        frame = &latest->frame;
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    return frame;
+}
+
+void camera_frame_release(camera_frame_t *frame) {
+    if (frame == NULL) {
+        return;
+    }
+
+    frame_slot_t *slot = (frame_slot_t *)frame;
+
+    portENTER_CRITICAL(&store_lock);
+    if (slot->refcount > 0) {
+        slot->refcount--;
+    }
+    portEXIT_CRITICAL(&store_lock);
+}
+
+bool frame_store_has_frame(void) {
+    return frame_store_latest_seq() != 0;
+}
+
+uint32_t frame_store_latest_seq(void) {
+    uint32_t seq = 0;
+
+    portENTER_CRITICAL(&store_lock);
+    if (latest != NULL) {
+        seq = latest->frame.seq;
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    return seq;
+}
+
+frame_store_stats_t frame_store_get_stats(void) {
+    frame_store_stats_t copy;
+
+    portENTER_CRITICAL(&store_lock);
+    copy = stats;
+    copy.slots_in_use = busy_slots();
+    portEXIT_CRITICAL(&store_lock);
+
+    return copy;
+}
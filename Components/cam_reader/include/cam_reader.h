@@ -3,6 +3,17 @@
 
 #include "esp_err.h"
 #include "esp_camera.h"
+#include "frame_store.h"
+#include "photo_history.h"
+#include "preroll_ring.h"
+#include "capture_queue.h"
+#include "frame_analysis.h"
+#include "jpeg_thumb.h"
+#include "rate_control.h"
+#include "sensor_profile.h"
+#include "day_night.h"
+#include "frame_dedupe.h"
+#include "capture_tier.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include <stdint.h>
@@ -29,13 +40,44 @@ typedef struct {
     int jpeg_quality;
     pixformat_t pixel_format;
     int fb_count;
+    camera_grab_mode_t grab_mode; // CAMERA_GRAB_LATEST: el driver entrega siempre el frame más reciente
+    size_t frame_slots;       // Slots del almacén de frames (lectores + escritor)
+    size_t frame_slot_size;   // Capacidad de cada slot en bytes
+    size_t thumb_slot_size;   // Capacidad de la miniatura 1/8 de cada slot (0 = sin miniaturas)
+    uint8_t thumb_quality;    // Calidad JPEG de las miniaturas (1-100)
+    size_t capture_queue_len; // Solicitudes de captura pendientes como máximo
+    size_t history_budget;    // Bytes de PSRAM para el historial de fotos (0 = sin /photos)
+    size_t history_entries;   // Fotos del historial como máximo
 } camera_config_custom_t;
 
 #define CAMERA_DEFAULT_CONFIG() { \
     .frame_size = FRAMESIZE_HD, \
     .jpeg_quality = 12, \
     .pixel_format = PIXFORMAT_JPEG, \
-    .fb_count = 2 \
+    .fb_count = 2, \
+    .grab_mode = CAMERA_GRAB_LATEST, \
+    .frame_slots = 4, \
+    .frame_slot_size = 192 * 1024, \
+    .thumb_slot_size = 16 * 1024, \
+    .thumb_quality = JPEG_THUMB_DEFAULT_QUALITY, \
+    .capture_queue_len = 8, \
+    .history_budget = 1024 * 1024, \
+    .history_entries = 64 \
+}
+
+// Configuración de la captura continua pre-disparo
+typedef struct {
+    size_t memory_budget;         // Memoria total del anillo en bytes (PSRAM)
+    size_t max_frame_size;        // Tamaño máximo de cada frame en bytes (VGA en reposo)
+    uint32_t frame_interval_ms;   // Intervalo entre capturas (tasa baja)
+    uint32_t preroll_ms;          // Segundos previos que se congelan en el episodio
+} camera_preroll_config_t;
+
+#define CAMERA_PREROLL_DEFAULT_CONFIG() { \
+    .memory_budget = 1024 * 1024, \
+    .max_frame_size = 64 * 1024, \
+    .frame_interval_ms = 500, \
+    .preroll_ms = 3000 \
 }
 
 /**
@@ -52,27 +94,44 @@ esp_err_t camera_manager_init(void);
 esp_err_t camera_manager_init_with_config(const camera_config_custom_t *config);
 
 /**
- * @brief Toma una foto y la almacena internamente
- * @param reason Razón por la cual se toma la foto (para logging)
- * @return ESP_OK si exitoso, código de error en caso contrario
+ * @brief Encola una solicitud de captura para la tarea de la cámara (no bloquea)
+ * @note Apto para callbacks de esp_timer. Las solicitudes que llegan durante una
+ *       captura y aceptan la misma resolución y calidad se atienden con un solo frame.
+ *       Con burst_frames > 1 se capturan varios frames seguidos, se puntúan por nitidez
+ *       y exposición y solo se publican los burst_keep mejores (el mejor queda último).
+ *       El callback se invoca siempre: con el frame, al vencer el plazo o al desinicializar.
+ * @param request Solicitud (razón, prioridad, resolución, calidad, plazo y callback)
+ * @return ESP_OK si se encoló, ESP_ERR_NO_MEM si la cola está llena,
+ *         ESP_ERR_INVALID_STATE si la cámara no está inicializada
  */
-esp_err_t camera_manager_take_photo(const char* reason);
+esp_err_t camera_manager_capture_async(const camera_capture_request_t *request);
+
+/**
+ * @brief Solicita una captura y espera el resultado
+ * @warning No llamar desde un callback de captura ni desde el timer de esp_timer
+ * @param reason Razón de la captura
+ * @param timeout_ms Plazo para iniciar la captura en milisegundos
+ * @param result Estructura donde almacenar el resultado (puede ser NULL)
+ * @return ESP_OK si exitoso, ESP_ERR_TIMEOUT si venció el plazo, código de error en caso contrario
+ */
+esp_err_t camera_manager_capture(camera_capture_reason_t reason, uint32_t timeout_ms,
+                                 camera_capture_result_t *result);
 
 /**
- * @brief Obtiene puntero al frame buffer de la foto actual (uso directo)
- * @warning El puntero puede ser NULL si no hay foto
- * @warning No liberar el frame buffer retornado
- * @return Puntero al frame buffer actual o NULL
+ * @brief Toma una foto y la publica en el almacén de frames (bloqueante)
+ * @note Equivale a camera_manager_capture(camera_capture_reason_from_name(reason), 2000, NULL);
+ *       los lectores usan camera_frame_acquire()/camera_frame_release()
+ * @param reason Nombre de la razón ("detección inicial", "solicitud web"...); otro texto o
+ *        NULL se registra como solicitud manual
+ * @return ESP_OK si exitoso, código de error en caso contrario
  */
-camera_fb_t* camera_manager_get_current_photo(void);
+esp_err_t camera_manager_take_photo(const char* reason);
 
 /**
- * @brief Obtiene los datos de la foto actual de forma segura
- * @param buffer Puntero donde almacenar la dirección del buffer
- * @param len Puntero donde almacenar el tamaño del buffer
- * @return ESP_OK si hay foto disponible, ESP_ERR_NOT_FOUND si no hay foto
+ * @brief Obtiene las estadísticas de la cola de solicitudes de captura
+ * @return Estructura con estadísticas
  */
-esp_err_t camera_manager_get_photo_data(uint8_t** buffer, size_t* len);
+capture_queue_stats_t camera_manager_get_capture_stats(void);
 
 /**
  * @brief Verifica si hay una foto disponible
@@ -115,12 +174,14 @@ esp_err_t camera_manager_set_brightness(int brightness);
 
 /**
  * @brief Optimiza automáticamente la cámara para condiciones de poca luz
+ * @note Solo se escriben los registros que difieren del perfil aplicado antes
  * @return ESP_OK si exitoso, código de error en caso contrario
  */
 esp_err_t camera_manager_optimize_for_low_light(void);
 
 /**
  * @brief Optimiza automáticamente la cámara para condiciones de buena luz
+ * @note Solo se escriben los registros que difieren del perfil aplicado antes
  * @return ESP_OK si exitoso, código de error en caso contrario
  */
 esp_err_t camera_manager_optimize_for_daylight(void);
@@ -138,6 +199,154 @@ esp_err_t camera_manager_auto_optimize_lighting(void);
  */
 esp_err_t camera_manager_set_night_mode(bool night_mode);
 
+/**
+ * @brief Inicia la captura continua a baja tasa hacia el anillo pre-disparo
+ * @note Las entradas del anillo se reservan una sola vez al iniciar
+ * @param config Configuración de la captura continua
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_SIZE si memory_budget / max_frame_size no
+ *         llega a preroll_ring_entries_needed(), código de error en caso contrario
+ */
+esp_err_t camera_manager_preroll_start(const camera_preroll_config_t *config);
+
+/**
+ * @brief Detiene la captura continua y libera el anillo pre-disparo
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_STATE si algún lector retiene frames del
+ *         anillo (la captura continua sigue activa)
+ */
+esp_err_t camera_manager_preroll_stop(void);
+
+/**
+ * @brief Congela los preroll_ms de captura continua previos al disparo en un episodio
+ * @note Los frames se leen con preroll_ring_acquire_episode(). La ventana se mide desde
+ *       el flanco y no desde la llamada: no depende de lo que tarde la confirmación
+ * @param episode_id Identificador del episodio de detección (distinto de 0)
+ * @param trigger_time Flanco que inició la detección (esp_timer, microsegundos)
+ * @return Número de frames congelados (0 si la captura continua no está activa)
+ */
+size_t camera_manager_preroll_freeze(uint32_t episode_id, int64_t trigger_time);
+
+/**
+ * @brief Activa el control en lazo cerrado del tamaño JPEG
+ * @note Tras cada frame (fotos y captura pre-disparo) se ajusta la calidad, y si la
+ *       configuración tiene escalones, la resolución, para mantener el presupuesto
+ * @param config Objetivo en bytes por frame o por segundo, límites e histéresis
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t camera_manager_rate_control_start(const rate_control_config_t *config);
+
+/**
+ * @brief Desactiva el control de tamaño (la calidad actual se mantiene)
+ */
+void camera_manager_rate_control_stop(void);
+
+/**
+ * @brief Obtiene las estadísticas del control de tamaño
+ * @return Estructura con estadísticas (a cero si nunca se activó)
+ */
+rate_control_stats_t camera_manager_get_rate_control_stats(void);
+
+/**
+ * @brief Copia los metadatos del frame más reciente
+ * @note Quien ya tiene una referencia del almacén puede leer frame->meta directamente
+ * @param seq Puntero donde almacenar la secuencia del frame (puede ser NULL)
+ * @param meta Estructura donde almacenar los metadatos
+ * @return ESP_OK si exitoso, ESP_ERR_NOT_FOUND si aún no hay frames
+ */
+esp_err_t camera_manager_get_frame_meta(uint32_t *seq, camera_frame_meta_t *meta);
+
+/**
+ * @brief Formatea un frame y sus metadatos como objeto JSON
+ * @param frame Frame con referencia adquirida
+ * @param buf Buffer de salida
+ * @param size Capacidad del buffer
+ * @return Longitud del JSON (como snprintf; >= size si no cabe)
+ */
+int camera_frame_meta_to_json(const camera_frame_t *frame, char *buf, size_t size);
+
+/**
+ * @brief Obtiene las estadísticas de los cambios de perfil del sensor
+ * @note Incluye la duración del último cambio y la máxima, para perfilado
+ * @return Estructura con estadísticas
+ */
+sensor_profile_stats_t camera_manager_get_profile_stats(void);
+
+/**
+ * @brief Inicia el planificador día/noche en segundo plano
+ * @note La luminancia se mide en los frames que ya toma la tarea de captura (como mucho
+ *       uno por sample_interval_s); sin capturas recientes se toma un frame de prueba.
+ *       Iniciar tras sincronizar el reloj para usar la hora solar.
+ * @param config Umbrales, tiempos y posición
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida,
+ *         ESP_ERR_INVALID_STATE si la cámara no está inicializada
+ */
+esp_err_t camera_manager_day_night_start(const day_night_config_t *config);
+
+/**
+ * @brief Detiene el planificador día/noche (el perfil actual se mantiene)
+ */
+void camera_manager_day_night_stop(void);
+
+/**
+ * @brief Obtiene las estadísticas del planificador día/noche
+ * @return Estructura con estadísticas (modo desconocido si nunca se inició)
+ */
+day_night_stats_t camera_manager_get_day_night_stats(void);
+
+/**
+ * @brief Activa la deduplicación de fotos periódicas por hash perceptual
+ * @note Cada foto guarda su hash en meta.phash. Las periódicas casi idénticas a la
+ *       última conservada se descartan antes del commit (o se publican marcadas si
+ *       drop = false); las de detección, HTTP o ráfaga siempre se publican.
+ * @param config Umbral, intervalo máximo entre frames conservados y modo
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida,
+ *         ESP_ERR_INVALID_STATE si la cámara no está inicializada
+ */
+esp_err_t camera_manager_dedupe_start(const frame_dedupe_config_t *config);
+
+/**
+ * @brief Desactiva la deduplicación (todas las fotos se publican)
+ */
+void camera_manager_dedupe_stop(void);
+
+/**
+ * @brief Obtiene las estadísticas de la deduplicación
+ * @return Estructura con estadísticas (a cero si nunca se activó)
+ */
+frame_dedupe_stats_t camera_manager_get_dedupe_stats(void);
+
+/**
+ * @brief Activa los modos de captura: resolución baja en reposo y alta en los episodios
+ * @note Empieza en reposo. Las solicitudes con episode_id y camera_manager_capture_tier_wake()
+ *       pasan a activo antes de capturar; se vuelve a reposo hold_ms después de la última
+ *       actividad. Cada cambio descarta los frames del driver con la resolución anterior.
+ *       Los buffers del driver se dimensionan al inicializar: ningún modo puede superar
+ *       la resolución de camera_config_custom_t.frame_size.
+ * @param config Resolución y calidad de cada modo, permanencia y frames a descartar
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida,
+ *         ESP_ERR_INVALID_STATE si la cámara no está inicializada
+ */
+esp_err_t camera_manager_capture_tier_start(const capture_tier_config_t *config);
+
+/**
+ * @brief Desactiva los modos de captura (la resolución actual se mantiene)
+ */
+void camera_manager_capture_tier_stop(void);
+
+/**
+ * @brief Registra actividad y pasa al modo activo sin esperar a una solicitud
+ * @note Pensado para el primer flanco del sensor: el cambio de resolución ocurre mientras
+ *       se confirma la detección y la ráfaga ya sale en alta resolución. Seguro desde
+ *       cualquier tarea; no hace nada si los modos no están activos.
+ */
+void camera_manager_capture_tier_wake(void);
+
+/**
+ * @brief Obtiene las estadísticas de los modos y de los cambios de resolución
+ * @note Incluye la latencia del último cambio y la máxima, y el tiempo en cada modo
+ * @return Estructura con estadísticas
+ */
+capture_tier_stats_t camera_manager_get_capture_tier_stats(void);
+
 /**
  * @brief Configura la cola del servidor web para notificaciones
  * @param queue Handle de la cola del servidor web
@@ -147,7 +356,10 @@ esp_err_t camera_manager_set_server_queue(QueueHandle_t queue);
 
 /**
  * @brief Desinicializa el componente de cámara y libera recursos
- * @return ESP_OK si exitoso, código de error en caso contrario
+ * @note Las solicitudes pendientes terminan con ESP_ERR_INVALID_STATE y las que llegan
+ *       durante el cierre se rechazan: ninguna espera de camera_manager_capture() queda colgada
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_STATE si algún lector retiene frames del
+ *         anillo pre-disparo (no se desmonta nada), código de error en caso contrario
  */
 esp_err_t camera_manager_deinit(void);
 
@@ -0,0 +1,180 @@
+// capture_queue.h - Cola priorizada de solicitudes de captura
+#ifndef CAPTURE_QUEUE_H
+#define CAPTURE_QUEUE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Valor de resolución/calidad que conserva la configuración actual del sensor
+#define CAMERA_CAPTURE_KEEP_SETTING  (-1)
+
+// Razón de la captura
+typedef enum {
+    CAMERA_CAPTURE_REASON_MANUAL = 0,   // Solicitud explícita (pruebas, API)
+    CAMERA_CAPTURE_REASON_DETECTION,    // Detección inicial del sensor
+    CAMERA_CAPTURE_REASON_PERIODIC,     // Objeto permanece presente
+    CAMERA_CAPTURE_REASON_HTTP,         // Solicitud desde el servidor web
+    CAMERA_CAPTURE_REASON_PREROLL,      // Captura continua pre-disparo (no pasa por la cola)
+    CAMERA_CAPTURE_REASON_MAX
+} camera_capture_reason_t;
+
+// Prioridad de la solicitud (mayor valor = se atiende antes)
+typedef enum {
+    CAMERA_CAPTURE_PRIORITY_LOW = 0,
+    CAMERA_CAPTURE_PRIORITY_NORMAL,
+    CAMERA_CAPTURE_PRIORITY_HIGH
+} camera_capture_priority_t;
+
+// Resultado entregado a quien solicitó la captura
+typedef struct {
+    esp_err_t status;                 // ESP_OK, ESP_ERR_TIMEOUT si venció el plazo sin capturar
+    camera_capture_reason_t reason;   // Razón de la solicitud atendida
+    uint32_t seq;                     // Secuencia del frame en el almacén (0 si falló)
+    size_t size;                      // Tamaño del JPEG en bytes
+    uint64_t request_time;            // Instante de la solicitud (esp_timer, microsegundos)
+    uint64_t frame_time;              // Instante de captura del frame
+    bool coalesced;                   // Atendida con el frame de otra solicitud
+    bool duplicate;                   // Foto periódica casi idéntica descartada (seq = último frame conservado)
+    uint8_t frames_evaluated;         // Frames puntuados en modo ráfaga (0 = captura simple)
+    float score;                      // Puntuación del frame elegido (ver frame_analysis.h)
+} camera_capture_result_t;
+
+/**
+ * @brief Callback de finalización (se ejecuta en la tarea de captura: debe ser breve)
+ * @param result Resultado de la captura (válido solo durante la llamada)
+ * @param arg Argumento del usuario
+ */
+typedef void (*camera_capture_done_cb_t)(const camera_capture_result_t *result, void *arg);
+
+// Solicitud de captura
+typedef struct {
+    camera_capture_reason_t reason;
+    camera_capture_priority_t priority;
+    int16_t frame_size;               // framesize_t o CAMERA_CAPTURE_KEEP_SETTING
+    int8_t quality;                   // Calidad JPEG (10-63) o CAMERA_CAPTURE_KEEP_SETTING
+    uint64_t deadline;                // Instante límite para iniciar la captura (0 = sin límite)
+    uint8_t burst_frames;             // Frames a evaluar en ráfaga (0 o 1 = captura simple)
+    uint8_t burst_keep;               // Mejores frames de la ráfaga que se publican (1-2)
+    uint32_t episode_id;              // Episodio de detección al que pertenece (0 = ninguno)
+    camera_capture_done_cb_t done_cb; // Callback de finalización (puede ser NULL)
+    void *done_arg;                   // Argumento del callback
+} camera_capture_request_t;
+
+#define CAMERA_CAPTURE_REQUEST_DEFAULT(r) { \
+    .reason = (r), \
+    .priority = CAMERA_CAPTURE_PRIORITY_NORMAL, \
+    .frame_size = CAMERA_CAPTURE_KEEP_SETTING, \
+    .quality = CAMERA_CAPTURE_KEEP_SETTING, \
+    .deadline = 0, \
+    .burst_frames = 1, \
+    .burst_keep = 1, \
+    .episode_id = 0, \
+    .done_cb = NULL, \
+    .done_arg = NULL \
+}
+
+// Solicitud encolada
+typedef struct {
+    camera_capture_request_t request;
+    uint64_t submit_time;             // Instante en que se encoló
+} capture_queue_entry_t;
+
+// Estadísticas de la cola
+typedef struct {
+    uint32_t submitted;               // Solicitudes aceptadas
+    uint32_t rejected;                // Solicitudes rechazadas por cola llena
+    uint32_t coalesced;               // Solicitudes atendidas con el frame de otra
+    uint32_t expired;                 // Solicitudes vencidas antes de capturar
+    uint32_t batches;                 // Capturas despachadas
+    uint32_t pending;                 // Solicitudes en espera
+} capture_queue_stats_t;
+
+/**
+ * @brief Reserva la cola de solicitudes
+ * @param capacity Número máximo de solicitudes pendientes
+ * @return ESP_OK si exitoso, ESP_ERR_NO_MEM si no hay memoria
+ */
+esp_err_t capture_queue_init(size_t capacity);
+
+/**
+ * @brief Libera la cola (las solicitudes pendientes se descartan sin notificar)
+ */
+void capture_queue_deinit(void);
+
+/**
+ * @brief Cierra la cola: a partir de aquí capture_queue_push() rechaza las solicitudes
+ * @note Tras cerrarla, vaciarla con capture_queue_pop_batch() alcanza a todas las
+ *       aceptadas: ninguna puede entrar después del último vaciado
+ */
+void capture_queue_close(void);
+
+/**
+ * @brief Encola una solicitud (no bloquea; apto para callbacks de esp_timer)
+ * @param request Solicitud de captura
+ * @param now Instante actual (esp_timer, microsegundos)
+ * @return ESP_OK si exitoso, ESP_ERR_NO_MEM si la cola está llena,
+ *         ESP_ERR_INVALID_STATE si la cola no está inicializada o está cerrada
+ */
+esp_err_t capture_queue_push(const camera_capture_request_t *request, uint64_t now);
+
+/**
+ * @brief Extrae las solicitudes cuyo plazo venció
+ * @param now Instante actual
+ * @param expired Arreglo donde almacenar las solicitudes vencidas
+ * @param max_expired Capacidad del arreglo
+ * @return Número de solicitudes extraídas
+ */
+size_t capture_queue_take_expired(uint64_t now, capture_queue_entry_t *expired, size_t max_expired);
+
+/**
+ * @brief Extrae la solicitud más prioritaria y todas las compatibles con ella
+ * @note Orden: prioridad, plazo más cercano y orden de llegada. Las solicitudes con
+ *       la misma resolución y calidad efectivas se atienden con un único frame, salvo
+ *       las que piden una ráfaga más larga que la del líder.
+ * @param current_frame_size Resolución actual (resuelve CAMERA_CAPTURE_KEEP_SETTING)
+ * @param current_quality Calidad actual (resuelve CAMERA_CAPTURE_KEEP_SETTING)
+ * @param batch Arreglo de salida; batch[0] es la solicitud líder, con la resolución
+ *              y calidad efectivas del lote ya resueltas
+ * @param max_batch Capacidad del arreglo
+ * @return Número de solicitudes extraídas (0 si la cola está vacía)
+ */
+size_t capture_queue_pop_batch(int16_t current_frame_size, int8_t current_quality,
+                               capture_queue_entry_t *batch, size_t max_batch);
+
+/**
+ * @brief Plazo más cercano entre las solicitudes pendientes
+ * @return Instante límite o 0 si ninguna tiene plazo
+ */
+uint64_t capture_queue_next_deadline(void);
+
+/**
+ * @brief Obtiene las estadísticas de la cola
+ * @return Estructura con estadísticas
+ */
+capture_queue_stats_t capture_queue_get_stats(void);
+
+/**
+ * @brief Nombre legible de una razón de captura
+ * @param reason Razón de captura
+ * @return Cadena constante
+ */
+const char* camera_capture_reason_name(camera_capture_reason_t reason);
+
+/**
+ * @brief Razón de captura a partir de su nombre legible (inversa de camera_capture_reason_name())
+ * @param name Nombre, p. ej. "detección inicial" (NULL se admite)
+ * @return Razón correspondiente, CAMERA_CAPTURE_REASON_MANUAL si no coincide con ninguna
+ */
+camera_capture_reason_t camera_capture_reason_from_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_QUEUE_H
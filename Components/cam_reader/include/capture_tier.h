@@ -0,0 +1,166 @@
+// capture_tier.h - Modos de captura: resolución baja en reposo y alta durante la detección
+#ifndef CAPTURE_TIER_H
+#define CAPTURE_TIER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modo de captura
+typedef enum {
+    CAPTURE_TIER_IDLE = 0,        // Sin actividad: vista previa y análisis a baja resolución
+    CAPTURE_TIER_ACTIVE,          // Episodio de detección: detalle completo
+    CAPTURE_TIER_MAX
+} capture_tier_t;
+
+// Ajustes del sensor en cada modo
+typedef struct {
+    int16_t frame_size;           // Valor de framesize_t
+    int8_t quality;               // Calidad JPEG inicial (10-63); después se recuerda la última usada
+} capture_tier_settings_t;
+
+// Configuración de los modos
+typedef struct {
+    capture_tier_settings_t tiers[CAPTURE_TIER_MAX];
+    uint32_t hold_ms;             // Permanencia en ACTIVE tras la última actividad
+    uint8_t max_flush_frames;     // Frames descartados como máximo esperando la nueva resolución
+} capture_tier_config_t;
+
+#define CAPTURE_TIER_DEFAULT_CONFIG() { \
+    .tiers = { \
+        [CAPTURE_TIER_IDLE] = { .frame_size = 8, .quality = 12 },     /* FRAMESIZE_VGA */ \
+        [CAPTURE_TIER_ACTIVE] = { .frame_size = 11, .quality = 12 },  /* FRAMESIZE_HD */ \
+    }, \
+    .hold_ms = 10000, \
+    .max_flush_frames = 4 \
+}
+
+// Estadísticas de los modos y de los cambios de resolución
+typedef struct {
+    capture_tier_t tier;          // Modo actual
+    uint32_t switches_up;         // Cambios a ACTIVE
+    uint32_t switches_down;       // Cambios a IDLE
+    uint32_t size_switches;       // Cambios de resolución (modos, solicitudes y control de tamaño)
+    uint32_t flushed_frames;      // Frames con la resolución anterior descartados
+    uint32_t flush_timeouts;      // Cambios sin frame nuevo tras max_flush_frames
+    uint32_t last_switch_us;      // Desde la escritura en el sensor hasta el primer frame nuevo
+    uint32_t max_switch_us;
+    uint64_t time_us[CAPTURE_TIER_MAX];  // Tiempo acumulado en cada modo
+} capture_tier_stats_t;
+
+// Frame pedido al driver mientras se descartan los de la resolución anterior
+typedef struct {
+    const uint8_t *buf;           // JPEG
+    size_t len;
+    void *handle;                 // Lo que hay que devolver al driver
+} capture_tier_frame_t;
+
+// Pide el siguiente frame al driver (false si no llega ninguno)
+typedef bool (*capture_tier_get_fn)(capture_tier_frame_t *frame);
+// Devuelve un frame al driver
+typedef void (*capture_tier_put_fn)(capture_tier_frame_t *frame);
+
+// Estado de los modos (lo posee la tarea de captura; sin bloqueos internos)
+typedef struct {
+    capture_tier_config_t config;
+    capture_tier_stats_t stats;
+    int8_t quality[CAPTURE_TIER_MAX];    // Última calidad usada en cada modo
+    uint64_t active_until;        // Fin de la permanencia en ACTIVE (0 = sin actividad)
+    uint64_t tier_since;          // Entrada en el modo actual (microsegundos)
+} capture_tier_state_t;
+
+/**
+ * @brief Inicializa los modos en IDLE
+ * @param state Estado
+ * @param config Configuración
+ * @param now Momento actual (microsegundos)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t capture_tier_init(capture_tier_state_t *state, const capture_tier_config_t *config, uint64_t now);
+
+/**
+ * @brief Registra actividad (flanco del sensor, foto del episodio): mantiene ACTIVE hold_ms más
+ * @param state Estado
+ * @param now Momento actual (microsegundos)
+ */
+void capture_tier_activity(capture_tier_state_t *state, uint64_t now);
+
+/**
+ * @brief Modo que corresponde al momento actual
+ * @param state Estado
+ * @param now Momento actual (microsegundos)
+ * @return CAPTURE_TIER_ACTIVE mientras dure la permanencia, CAPTURE_TIER_IDLE después
+ */
+capture_tier_t capture_tier_target(const capture_tier_state_t *state, uint64_t now);
+
+/**
+ * @brief Próximo instante en que el modo puede cambiar sin actividad nueva
+ * @param state Estado
+ * @return Fin de la permanencia en ACTIVE, 0 si no hay nada pendiente
+ */
+uint64_t capture_tier_next_deadline(const capture_tier_state_t *state);
+
+/**
+ * @brief Entra en un modo y devuelve los ajustes que hay que aplicar al sensor
+ * @note Guarda la calidad del modo que se abandona (la ajusta el control de tamaño) y
+ *       devuelve la última usada en el nuevo: cada resolución conserva su propia calidad
+ * @param state Estado
+ * @param tier Modo al que se entra
+ * @param current_quality Calidad en vigor al salir del modo actual
+ * @param now Momento actual (microsegundos)
+ * @param apply Estructura donde almacenar resolución y calidad del nuevo modo
+ */
+void capture_tier_enter(capture_tier_state_t *state, capture_tier_t tier, int8_t current_quality,
+                        uint64_t now, capture_tier_settings_t *apply);
+
+/**
+ * @brief Registra un cambio de resolución ya aplicado
+ * @param state Estado
+ * @param latency_us Desde la escritura en el sensor hasta el primer frame con la nueva resolución
+ * @param flushed Frames con la resolución anterior descartados
+ * @param timeout true si se agotó max_flush_frames sin ver la nueva resolución
+ */
+void capture_tier_record_switch(capture_tier_state_t *state, uint32_t latency_us, uint8_t flushed,
+                                bool timeout);
+
+/**
+ * @brief Descarta frames hasta ver uno con la nueva resolución
+ * @note El driver rellena el ancho y alto del frame con el tamaño configurado, no con el
+ *       capturado: se comparan las dimensiones del SOF del propio JPEG. Un frame cuya
+ *       cabecera no se puede leer cuenta como descartado
+ * @param state Estado (aporta max_flush_frames)
+ * @param get Pide el siguiente frame
+ * @param put Devuelve un frame
+ * @param width Ancho esperado
+ * @param height Alto esperado
+ * @param fresh Se pone a true si llegó un frame con la nueva resolución
+ * @return Frames con otra resolución descartados
+ */
+uint8_t capture_tier_flush(const capture_tier_state_t *state, capture_tier_get_fn get,
+                           capture_tier_put_fn put, uint16_t width, uint16_t height, bool *fresh);
+
+/**
+ * @brief Copia las estadísticas incluyendo el tiempo en curso del modo actual
+ * @param state Estado
+ * @param now Momento actual (microsegundos)
+ * @param stats Estructura donde almacenar las estadísticas
+ */
+void capture_tier_get_stats(const capture_tier_state_t *state, uint64_t now, capture_tier_stats_t *stats);
+
+/**
+ * @brief Nombre legible de un modo
+ * @param tier Modo
+ * @return Cadena estática ("reposo", "activo")
+ */
+const char* capture_tier_name(capture_tier_t tier);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_TIER_H
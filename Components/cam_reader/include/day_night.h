@@ -0,0 +1,169 @@
+// day_night.h - Decisión día/noche con histéresis a partir de luminancia y hora solar
+#ifndef DAY_NIGHT_H
+#define DAY_NIGHT_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modo de iluminación decidido
+typedef enum {
+    DAY_NIGHT_UNKNOWN = 0,    // Aún sin decisión
+    DAY_NIGHT_DAY,
+    DAY_NIGHT_NIGHT
+} day_night_mode_t;
+
+// Fase solar en la posición configurada
+typedef enum {
+    SOLAR_PHASE_UNKNOWN = 0,  // Sin posición o reloj sin sincronizar
+    SOLAR_PHASE_DAY,
+    SOLAR_PHASE_TWILIGHT,     // Alrededor del amanecer o del atardecer
+    SOLAR_PHASE_NIGHT
+} solar_phase_t;
+
+// Motivo de un cambio de modo
+typedef enum {
+    DAY_NIGHT_CAUSE_NONE = 0,
+    DAY_NIGHT_CAUSE_INITIAL,  // Primera decisión tras arrancar
+    DAY_NIGHT_CAUSE_LUMA,     // Luminancia fuera de la banda de histéresis
+    DAY_NIGHT_CAUSE_SOLAR     // Sin muestras recientes: manda la hora solar
+} day_night_cause_t;
+
+// Configuración del planificador
+typedef struct {
+    float latitude;               // Grados, norte positivo
+    float longitude;              // Grados, este positivo
+    bool use_solar;               // false = solo luminancia
+    uint8_t night_below;          // Luma media (0-255) por debajo de la cual se pasa a noche
+    uint8_t day_above;            // Luma media por encima de la cual se pasa a día
+    uint8_t solar_bias;           // Endurece el umbral contrario a la fase solar (día: noche más difícil)
+    float smoothing;              // Peso de la muestra nueva en la media móvil (0-1]
+    uint32_t confirm_s;           // Tiempo que la condición debe mantenerse antes de cambiar
+    uint32_t min_dwell_s;         // Tiempo mínimo en un modo entre cambios
+    uint32_t twilight_s;          // Ventana a cada lado de amanecer/atardecer sin sesgo solar
+    uint32_t luma_stale_s;        // Sin muestras durante este tiempo decide la hora solar
+    uint32_t sample_interval_s;   // Intervalo mínimo entre muestras de luminancia
+    uint32_t eval_interval_s;     // Intervalo entre evaluaciones
+} day_night_config_t;
+
+#define DAY_NIGHT_DEFAULT_CONFIG() { \
+    .latitude = 0.0f, \
+    .longitude = 0.0f, \
+    .use_solar = false, \
+    .night_below = 60, \
+    .day_above = 90, \
+    .solar_bias = 30, \
+    .smoothing = 0.3f, \
+    .confirm_s = 600, \
+    .min_dwell_s = 1800, \
+    .twilight_s = 2700, \
+    .luma_stale_s = 900, \
+    .sample_interval_s = 60, \
+    .eval_interval_s = 60 \
+}
+
+// Resultado de una evaluación
+typedef struct {
+    bool changed;                 // true si hay que aplicar el perfil de mode
+    day_night_mode_t mode;
+    day_night_cause_t cause;
+    solar_phase_t phase;
+    float luma;                   // Media móvil (negativa si no hay muestras)
+    int64_t sunrise;              // Amanecer del día solar en curso (epoch; 0 si desconocido)
+    int64_t sunset;               // Atardecer del día solar en curso
+} day_night_decision_t;
+
+// Estadísticas del planificador
+typedef struct {
+    uint32_t samples;             // Muestras de luminancia recibidas
+    uint32_t evaluations;
+    uint32_t switches;            // Cambios de modo (sin contar la decisión inicial)
+    uint32_t luma_switches;
+    uint32_t solar_switches;
+    uint32_t dwell_blocked;       // Evaluaciones con cambio confirmado retenido por min_dwell_s
+    int64_t last_switch;          // Momento del último cambio (epoch)
+    day_night_mode_t mode;
+    solar_phase_t phase;
+    float luma;
+} day_night_stats_t;
+
+// Estado del planificador (lo posee una sola tarea; sin bloqueos internos)
+typedef struct {
+    day_night_config_t config;
+    day_night_stats_t stats;
+    float luma;                   // Media móvil (negativa = sin muestras)
+    int64_t last_sample;
+    int64_t pending_since;        // Inicio de la condición de cambio (0 = ninguna)
+} day_night_t;
+
+/**
+ * @brief Inicializa el planificador
+ * @param dn Estado del planificador
+ * @param config Umbrales, tiempos y posición
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t day_night_init(day_night_t *dn, const day_night_config_t *config);
+
+/**
+ * @brief Añade una muestra de luminancia media de la escena
+ * @param dn Estado del planificador
+ * @param now Momento de la muestra (epoch en segundos)
+ * @param luma Luminancia media del frame (0-255)
+ */
+void day_night_add_luma(day_night_t *dn, int64_t now, float luma);
+
+/**
+ * @brief Evalúa si hay que cambiar de modo
+ * @note Un cambio exige que la condición se mantenga confirm_s y que hayan pasado
+ *       min_dwell_s desde el anterior
+ * @param dn Estado del planificador
+ * @param now Momento actual (epoch en segundos)
+ * @param decision Estructura donde almacenar la decisión
+ * @return true si el modo cambió
+ */
+bool day_night_evaluate(day_night_t *dn, int64_t now, day_night_decision_t *decision);
+
+/**
+ * @brief Calcula amanecer y atardecer del día solar que contiene now
+ * @param latitude Grados, norte positivo
+ * @param longitude Grados, este positivo
+ * @param now Momento de referencia (epoch en segundos)
+ * @param sunrise Puntero donde almacenar el amanecer (epoch)
+ * @param sunset Puntero donde almacenar el atardecer (epoch)
+ * @return ESP_OK si exitoso, ESP_ERR_NOT_FOUND si ese día el sol no sale o no se pone
+ *         (noche o día polar; sunrise y sunset quedan a 0)
+ */
+esp_err_t day_night_sun_times(float latitude, float longitude, int64_t now,
+                              int64_t *sunrise, int64_t *sunset);
+
+/**
+ * @brief Nombre legible de un modo (para logs)
+ * @param mode Modo
+ * @return Nombre del modo
+ */
+const char* day_night_mode_name(day_night_mode_t mode);
+
+/**
+ * @brief Nombre legible de una fase solar (para logs)
+ * @param phase Fase
+ * @return Nombre de la fase
+ */
+const char* day_night_phase_name(solar_phase_t phase);
+
+/**
+ * @brief Nombre legible del motivo de un cambio (para logs)
+ * @param cause Motivo
+ * @return Nombre del motivo
+ */
+const char* day_night_cause_name(day_night_cause_t cause);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DAY_NIGHT_H
@@ -0,0 +1,67 @@
+// frame_analysis.h - Puntuación de nitidez y exposición sobre el mapa de luminancia
+#ifndef FRAME_ANALYSIS_H
+#define FRAME_ANALYSIS_H
+
+#include "esp_err.h"
+#include "jpeg_dc.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Luminancia media objetivo para la puntuación de exposición
+#define FRAME_ANALYSIS_TARGET_LUMA   118
+
+// Calidad estimada de un frame
+typedef struct {
+    float sharpness;          // Laplaciano normalizado por la varianza, por detail si hay AC (mayor = más nítido)
+    float detail;             // Varianza dentro de los bloques (AC) / varianza del mapa (0 sin AC)
+    float exposure;           // 0-1: penaliza píxeles saturados y media lejos del objetivo
+    float score;              // sharpness * exposure (solo comparable dentro de una ráfaga)
+    uint8_t mean;             // Luminancia media
+    float clipped;            // Fracción de bloques saturados (< 8 o > 247)
+} frame_quality_t;
+
+/**
+ * @brief Puntúa un mapa de luminancia (por ejemplo, el mapa DC a escala 1/8)
+ * @note Coste lineal en el tamaño del mapa; sin memoria dinámica
+ * @param map Mapa de luminancia fila a fila
+ * @param width Ancho del mapa
+ * @param height Alto del mapa
+ * @param quality Estructura donde almacenar la puntuación
+ */
+void frame_analysis_score_map(const uint8_t *map, uint16_t width, uint16_t height,
+                              frame_quality_t *quality);
+
+/**
+ * @brief Puntúa un mapa de luminancia junto con la energía AC de sus bloques
+ * @note El mapa 1/8 no ve desenfoques menores que un bloque (8 px): la energía AC sí.
+ *       sharpness = laplaciano del mapa * detail, ambos independientes de la ganancia
+ * @param map Mapa de luminancia fila a fila
+ * @param width Ancho del mapa
+ * @param height Alto del mapa
+ * @param ac Energía AC de jpeg_dc_luma_map_ac() (NULL o sin bloques = solo el mapa)
+ * @param quality Estructura donde almacenar la puntuación
+ */
+void frame_analysis_score_map_ac(const uint8_t *map, uint16_t width, uint16_t height,
+                                 const jpeg_ac_energy_t *ac, frame_quality_t *quality);
+
+/**
+ * @brief Puntúa un JPEG baseline a partir de su mapa DC de luminancia y su energía AC
+ * @param jpeg Datos JPEG
+ * @param len Tamaño de los datos
+ * @param map_buf Buffer de trabajo para el mapa (map_width * map_height bytes)
+ * @param map_capacity Capacidad del buffer de trabajo
+ * @param quality Estructura donde almacenar la puntuación
+ * @return ESP_OK si exitoso, código de error de jpeg_dc_luma_map_ac() en caso contrario
+ */
+esp_err_t frame_analysis_score_jpeg(const uint8_t *jpeg, size_t len, uint8_t *map_buf,
+                                    size_t map_capacity, frame_quality_t *quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_ANALYSIS_H
@@ -0,0 +1,119 @@
+// frame_dedupe.h - Hash perceptual de frames y descarte de fotos casi idénticas
+#ifndef FRAME_DEDUPE_H
+#define FRAME_DEDUPE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rejilla del hash de diferencias: 9x8 celdas dan 8x8 = 64 comparaciones
+#define FRAME_HASH_COLS         9
+#define FRAME_HASH_ROWS         8
+#define FRAME_HASH_MARGIN_X16   24      // Zona muerta de 1.5 niveles de luma entre celdas vecinas
+#define FRAME_HASH_MAX_DISTANCE 128
+#define FRAME_HASH_NONE         0xFF    // Distancia sin frame de referencia
+
+// Hash perceptual: cada comparación es "más clara", "más oscura" o "igual" (ningún bit).
+// La zona muerta evita que el ruido invierta las comparaciones en paredes lisas.
+typedef struct {
+    uint64_t brighter;        // La celda supera a su vecina derecha en más del margen
+    uint64_t darker;          // La vecina derecha supera a la celda en más del margen
+} frame_hash_t;
+
+// Configuración de la deduplicación
+typedef struct {
+    uint8_t threshold;            // Distancia de Hamming (0-128) por debajo de la cual el frame es duplicado
+    uint32_t max_gap_ms;          // Se conserva al menos un frame cada max_gap_ms aunque sea duplicado (0 = nunca)
+    bool drop;                    // true = descartar duplicados; false = publicarlos marcados
+} frame_dedupe_config_t;
+
+#define FRAME_DEDUPE_DEFAULT_CONFIG() { \
+    .threshold = 8, \
+    .max_gap_ms = 60000, \
+    .drop = true \
+}
+
+// Estadísticas de la deduplicación
+typedef struct {
+    uint32_t hashed;              // Frames evaluados
+    uint32_t kept;                // Frames conservados (incluye los forzados por max_gap_ms)
+    uint32_t duplicates;          // Frames duplicados (descartados o marcados)
+    uint32_t forced;              // Duplicados conservados por max_gap_ms
+    uint64_t bytes_saved;         // Bytes de los duplicados
+    uint8_t last_distance;        // Distancia del último frame evaluado (FRAME_HASH_NONE sin referencia)
+    uint32_t last_hash_us;        // Duración del último mapa DC + hash
+    uint32_t max_hash_us;
+} frame_dedupe_stats_t;
+
+// Estado de la deduplicación (lo posee una sola tarea; sin bloqueos internos)
+typedef struct {
+    frame_dedupe_config_t config;
+    frame_dedupe_stats_t stats;
+    frame_hash_t reference;       // Hash del último frame conservado
+    uint64_t reference_time;      // Momento del último frame conservado (microsegundos)
+    bool has_reference;
+} frame_dedupe_t;
+
+/**
+ * @brief Calcula el hash de diferencias de un mapa de luminancia (p. ej. el mapa DC 1/8)
+ * @note Reduce el mapa a 9x8 celdas promediadas y compara cada celda con su vecina
+ *       derecha: insensible a cambios uniformes de brillo, ruido y compresión
+ * @param map Mapa de luminancia fila a fila
+ * @param width Ancho del mapa
+ * @param height Alto del mapa
+ * @param hash Estructura donde almacenar el hash (a cero si el mapa está vacío)
+ */
+void frame_hash_map(const uint8_t *map, uint16_t width, uint16_t height, frame_hash_t *hash);
+
+/**
+ * @brief Distancia de Hamming entre dos hashes
+ * @note Una comparación que pasa de "más clara" a "más oscura" cuenta 2
+ * @param a Primer hash
+ * @param b Segundo hash
+ * @return Bits distintos (0-128)
+ */
+static inline uint8_t frame_hash_distance(const frame_hash_t *a, const frame_hash_t *b) {
+    return (uint8_t)(__builtin_popcountll(a->brighter ^ b->brighter) +
+                     __builtin_popcountll(a->darker ^ b->darker));
+}
+
+/**
+ * @brief Inicializa la deduplicación sin frame de referencia
+ * @param dedupe Estado
+ * @param config Configuración
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t frame_dedupe_init(frame_dedupe_t *dedupe, const frame_dedupe_config_t *config);
+
+/**
+ * @brief Decide si un frame es un duplicado del último conservado
+ * @note Un frame conservado pasa a ser la referencia; un duplicado no la mueve, así una
+ *       deriva lenta acaba superando el umbral
+ * @param dedupe Estado
+ * @param hash Hash del frame
+ * @param timestamp Momento de captura (microsegundos)
+ * @param size Tamaño del frame en bytes (para bytes_saved)
+ * @param distance Puntero donde almacenar la distancia a la referencia (puede ser NULL)
+ * @return true si el frame es duplicado
+ */
+bool frame_dedupe_check(frame_dedupe_t *dedupe, const frame_hash_t *hash, uint64_t timestamp,
+                        size_t size, uint8_t *distance);
+
+/**
+ * @brief Fija un frame conservado por otra vía (detección, ráfaga) como referencia
+ * @param dedupe Estado
+ * @param hash Hash del frame
+ * @param timestamp Momento de captura (microsegundos)
+ */
+void frame_dedupe_keep(frame_dedupe_t *dedupe, const frame_hash_t *hash, uint64_t timestamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_DEDUPE_H
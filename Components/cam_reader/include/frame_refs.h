@@ -0,0 +1,43 @@
+// frame_refs.h - Cierre de almacenes de frames con referencias (frame_store, preroll, historial)
+#ifndef FRAME_REFS_H
+#define FRAME_REFS_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tiempo máximo que un deinit espera a que los lectores suelten sus frames
+#define FRAME_REFS_DRAIN_MS     2000
+
+/**
+ * @brief Cuenta referencias vivas (lectores y escrituras en curso)
+ * @note Se llama con el lock del almacén tomado: no debe bloquear ni registrar
+ */
+typedef size_t (*frame_refs_busy_fn)(void);
+
+/**
+ * @brief Cierra un almacén y espera a que no queden referencias
+ * @note Con ESP_OK el almacén queda cerrado (*closing = true): el llamante retira sus
+ *       punteros bajo el lock, pone *closing a false y libera la memoria fuera del lock.
+ *       Mientras está cerrado, las funciones de adquisición y escritura deben devolver NULL
+ * @param lock Lock del almacén
+ * @param closing Bandera de cierre del almacén (protegida por lock)
+ * @param busy Contador de referencias vivas
+ * @param timeout_ms Espera máxima
+ * @param tag Etiqueta de log del almacén
+ * @return ESP_OK si no quedan referencias, ESP_ERR_INVALID_STATE si alguna sigue viva
+ *         tras timeout_ms (el almacén vuelve a abrirse intacto)
+ */
+esp_err_t frame_refs_drain(portMUX_TYPE *lock, bool *closing, frame_refs_busy_fn busy,
+                           uint32_t timeout_ms, const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_REFS_H
@@ -0,0 +1,149 @@
+// frame_store.h - Almacén de frames con conteo de referencias
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include "esp_err.h"
+#include "frame_dedupe.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Metadatos de captura guardados junto a cada frame (tamaño fijo, sin memoria dinámica)
+typedef struct {
+    int64_t wall_time_ms;         // Hora real de captura (epoch en ms; 0 si el reloj no está sincronizado)
+    const char *profile;          // Perfil del sensor en vigor (cadena estática; NULL si ninguno)
+    uint32_t episode_id;          // Episodio de detección (0 = ninguno)
+    uint32_t capture_latency_us;  // Desde que se solicitó la captura hasta el frame
+    uint16_t aec_value;           // Exposición programada en el sensor
+    uint8_t agc_gain;             // Ganancia programada
+    int8_t ae_level;              // Nivel AE programado
+    uint8_t gainceiling;          // Techo de ganancia programado
+    uint8_t reason;               // camera_capture_reason_t
+    uint8_t quality;              // Calidad JPEG
+    uint8_t frame_size;           // framesize_t
+    uint8_t burst_frames;         // Frames evaluados en ráfaga (0 = captura simple)
+    uint8_t hash_distance;        // Distancia al último frame conservado (FRAME_HASH_NONE = sin referencia)
+    bool duplicate;               // Casi idéntico al anterior (publicado porque drop = false)
+    frame_hash_t phash;           // Hash perceptual (a cero si no se calculó, p. ej. pre-disparo)
+} camera_frame_meta_t;
+
+// Frame publicado en el almacén (solo lectura para los consumidores)
+typedef struct {
+    const uint8_t *buf;       // Datos JPEG
+    size_t len;               // Tamaño en bytes
+    uint32_t seq;             // Número de secuencia (1, 2, 3...)
+    uint64_t timestamp;       // Momento de captura (esp_timer, microsegundos)
+    uint16_t width;
+    uint16_t height;
+    const uint8_t *thumb;     // Miniatura JPEG a escala 1/8 (NULL si el almacén no tiene miniaturas)
+    size_t thumb_len;         // Tamaño de la miniatura (0 = no generada)
+    camera_frame_meta_t meta; // Contexto de la captura (lo escribe el productor antes del commit)
+} camera_frame_t;
+
+// Configuración del almacén
+typedef struct {
+    size_t slot_count;        // Número de slots (frames simultáneos)
+    size_t slot_size;         // Capacidad de cada slot en bytes
+    size_t thumb_size;        // Capacidad de la miniatura de cada slot (0 = sin miniaturas)
+} frame_store_config_t;
+
+#define FRAME_STORE_DEFAULT_CONFIG() { \
+    .slot_count = 4, \
+    .slot_size = 192 * 1024, \
+    .thumb_size = 16 * 1024 \
+}
+
+// Estadísticas del almacén
+typedef struct {
+    uint32_t published;        // Frames publicados
+    uint32_t dropped_no_slot;  // Escrituras rechazadas por no haber slot libre
+    uint32_t dropped_too_large;// Escrituras rechazadas por exceder slot_size
+    uint32_t slots_in_use;     // Slots con lectores activos o en escritura
+    uint32_t acquires;         // Total de adquisiciones de lectores
+} frame_store_stats_t;
+
+/**
+ * @brief Reserva los slots del almacén (en PSRAM si está disponible)
+ * @param config Configuración del almacén
+ * @return ESP_OK si exitoso, ESP_ERR_NO_MEM si no hay memoria
+ */
+esp_err_t frame_store_init(const frame_store_config_t *config);
+
+/**
+ * @brief Libera los slots del almacén
+ * @note Deja de entregar frames y espera hasta FRAME_REFS_DRAIN_MS a que los lectores
+ *       suelten los suyos; si alguno sigue vivo no libera nada
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_STATE si quedan frames adquiridos
+ */
+esp_err_t frame_store_deinit(void);
+
+/**
+ * @brief Reserva un slot libre para escribir un nuevo frame (productor)
+ * @param len Tamaño de los datos a escribir
+ * @param data Puntero donde almacenar la dirección del buffer escribible
+ * @return Handle del frame en escritura o NULL si no hay slot disponible
+ */
+camera_frame_t* frame_store_begin_write(size_t len, uint8_t **data);
+
+/**
+ * @brief Obtiene el buffer de miniatura de un frame en escritura (productor)
+ * @note El productor escribe la miniatura y su tamaño en frame->thumb_len antes del commit
+ * @param frame Handle obtenido con frame_store_begin_write()
+ * @param capacity Puntero donde almacenar la capacidad del buffer
+ * @return Buffer escribible o NULL si el almacén no tiene miniaturas
+ */
+uint8_t* frame_store_thumb_buffer(camera_frame_t *frame, size_t *capacity);
+
+/**
+ * @brief Publica un frame escrito como el más reciente y le asigna secuencia
+ * @param frame Handle obtenido con frame_store_begin_write()
+ * @return Número de secuencia asignado
+ */
+uint32_t frame_store_commit(camera_frame_t *frame);
+
+/**
+ * @brief Descarta un frame en escritura sin publicarlo
+ * @param frame Handle obtenido con frame_store_begin_write()
+ */
+void frame_store_abort(camera_frame_t *frame);
+
+/**
+ * @brief Adquiere una referencia al frame más reciente
+ * @note El frame no se reutiliza hasta que se llame a camera_frame_release()
+ * @return Handle del frame o NULL si no hay ninguno publicado
+ */
+camera_frame_t* camera_frame_acquire(void);
+
+/**
+ * @brief Libera una referencia obtenida con camera_frame_acquire()
+ * @param frame Handle del frame (NULL se ignora)
+ */
+void camera_frame_release(camera_frame_t *frame);
+
+/**
+ * @brief Verifica si hay al menos un frame publicado
+ * @return true si hay frame, false en caso contrario
+ */
+bool frame_store_has_frame(void);
+
+/**
+ * @brief Obtiene la secuencia del frame más reciente
+ * @return Número de secuencia o 0 si no hay frames
+ */
+uint32_t frame_store_latest_seq(void);
+
+/**
+ * @brief Obtiene las estadísticas del almacén
+ * @return Estructura con estadísticas
+ */
+frame_store_stats_t frame_store_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_STORE_H
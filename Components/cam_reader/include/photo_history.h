@@ -0,0 +1,135 @@
+// photo_history.h - Historial acotado de fotos publicadas, consultable por secuencia
+#ifndef PHOTO_HISTORY_H
+#define PHOTO_HISTORY_H
+
+#include "esp_err.h"
+#include "frame_store.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHOTO_HISTORY_LIST_MAX  50      // Entradas por consulta del índice como máximo
+
+// Configuración del historial
+typedef struct {
+    size_t memory_budget;     // Bytes del anillo de datos JPEG (PSRAM; 0 = sin historial)
+    size_t max_entries;       // Fotos indexadas como máximo
+} photo_history_config_t;
+
+#define PHOTO_HISTORY_DEFAULT_CONFIG() { \
+    .memory_budget = 1024 * 1024, \
+    .max_entries = 64 \
+}
+
+// Entrada del índice: lo que un cliente necesita para decidir si descarga la foto
+typedef struct {
+    uint32_t seq;             // Secuencia del almacén de frames
+    uint64_t timestamp;       // Momento de captura (esp_timer, microsegundos)
+    int64_t wall_time_ms;     // Hora real de captura (0 si el reloj no está sincronizado)
+    uint32_t len;             // Tamaño del JPEG en bytes
+    uint32_t episode_id;      // Episodio de detección (0 = ninguno)
+    uint16_t width;
+    uint16_t height;
+    uint8_t reason;           // camera_capture_reason_t
+} photo_history_info_t;
+
+// Página del índice devuelta por photo_history_list()
+typedef struct {
+    photo_history_info_t entries[PHOTO_HISTORY_LIST_MAX];
+    size_t count;
+    uint32_t since;           // Secuencia pedida
+    uint32_t oldest_seq;      // Más antigua retenida (un since menor indica fotos perdidas)
+    uint32_t latest_seq;      // Más reciente retenida
+    bool more;                // Quedan fotos posteriores a la última entrada
+} photo_history_page_t;
+
+// Estadísticas del historial
+typedef struct {
+    uint32_t stored;           // Fotos copiadas al historial
+    uint32_t evicted;          // Fotos expulsadas para dejar sitio
+    uint32_t dropped_busy;     // Copias rechazadas porque la foto a expulsar se está enviando
+    uint32_t dropped_too_large;// Copias rechazadas por exceder memory_budget
+    uint32_t lookups;          // Búsquedas por secuencia
+    uint32_t misses;           // Búsquedas de una secuencia que ya no está (o nunca estuvo)
+    uint32_t count;            // Fotos en el historial
+    uint32_t oldest_seq;       // 0 si está vacío
+    uint32_t latest_seq;       // 0 si está vacío
+    size_t bytes_used;         // Bytes JPEG retenidos
+    size_t memory_budget;
+} photo_history_stats_t;
+
+/**
+ * @brief Reserva el anillo de datos y el índice (en PSRAM si está disponible)
+ * @param config Configuración del historial (memory_budget = 0 lo deja desactivado)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG o ESP_ERR_NO_MEM
+ */
+esp_err_t photo_history_init(const photo_history_config_t *config);
+
+/**
+ * @brief Libera el historial
+ * @note Deja de entregar fotos y espera hasta FRAME_REFS_DRAIN_MS a que los lectores
+ *       suelten las suyas; si alguno sigue vivo no libera nada
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_STATE si quedan fotos adquiridas
+ */
+esp_err_t photo_history_deinit(void);
+
+/**
+ * @brief Copia una foto publicada al historial, expulsando las más antiguas si no cabe
+ * @note Un único productor (la tarea de captura): la copia se hace fuera del cerrojo.
+ *       Las secuencias deben llegar en orden creciente
+ * @param frame Frame publicado (con secuencia asignada)
+ * @return ESP_OK si se guardó, ESP_ERR_INVALID_STATE sin historial o con una secuencia
+ *         que no es mayor que la última, ESP_ERR_INVALID_SIZE si excede memory_budget,
+ *         ESP_ERR_NO_MEM si la foto a expulsar se está enviando
+ */
+esp_err_t photo_history_append(const camera_frame_t *frame);
+
+/**
+ * @brief Copia la parte del índice posterior a una secuencia, de más antigua a más reciente
+ * @note Búsqueda binaria sobre la secuencia: O(log n) más la copia de las entradas
+ * @param since Devolver las fotos con seq > since (0 = desde la más antigua)
+ * @param limit Entradas como máximo (se recorta a PHOTO_HISTORY_LIST_MAX)
+ * @param page Página de salida
+ * @return Entradas copiadas
+ */
+size_t photo_history_list(uint32_t since, size_t limit, photo_history_page_t *page);
+
+/**
+ * @brief Adquiere una referencia a la foto con una secuencia concreta
+ * @note La foto no se expulsa hasta que se llame a photo_history_release()
+ * @param seq Secuencia buscada (búsqueda binaria)
+ * @return Handle del frame (sin miniatura) o NULL si no está en el historial
+ */
+camera_frame_t* photo_history_acquire(uint32_t seq);
+
+/**
+ * @brief Libera una referencia obtenida con photo_history_acquire()
+ * @param frame Handle del frame (NULL se ignora)
+ */
+void photo_history_release(camera_frame_t *frame);
+
+/**
+ * @brief Obtiene las estadísticas del historial
+ * @return Estructura con estadísticas
+ */
+photo_history_stats_t photo_history_get_stats(void);
+
+/**
+ * @brief Escribe una página del índice como JSON compacto para /photos
+ * @note "next" es la secuencia que el cliente envía como since en la siguiente consulta
+ * @param page Página obtenida con photo_history_list()
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita (como snprintf: >= size indica truncado)
+ */
+int photo_history_page_json(const photo_history_page_t *page, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHOTO_HISTORY_H
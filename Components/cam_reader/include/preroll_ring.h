@@ -0,0 +1,127 @@
+// preroll_ring.h - Anillo de frames previos al disparo del sensor
+#ifndef PREROLL_RING_H
+#define PREROLL_RING_H
+
+#include "esp_err.h"
+#include "frame_store.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREROLL_EPISODE_MAX     32      // Frames de un episodio que se consultan a la vez como máximo
+
+// Estadísticas del anillo
+typedef struct {
+    uint32_t captured;        // Frames escritos en el anillo
+    uint32_t dropped;         // Frames descartados (sin entrada libre o muy grandes)
+    uint32_t frozen;          // Frames congelados en el episodio actual
+    uint32_t frozen_episode;  // Episodio congelado actualmente (0 = ninguno)
+    size_t entry_count;       // Entradas reservadas
+} preroll_ring_stats_t;
+
+/**
+ * @brief Entradas que necesita el anillo para una ventana de pre-disparo
+ * @note El episodio congelado retiene hasta una ventana entera hasta el siguiente disparo;
+ *       encima debe caber otra ventana en vivo más la entrada en escritura y la que
+ *       retiene /stream, o el episodio siguiente se queda con uno o dos frames previos
+ * @param preroll_ms Ventana que se congela en cada episodio
+ * @param frame_interval_ms Intervalo de la captura continua
+ * @return Número mínimo de entradas (0 si frame_interval_ms es 0)
+ */
+size_t preroll_ring_entries_needed(uint32_t preroll_ms, uint32_t frame_interval_ms);
+
+/**
+ * @brief Reserva las entradas del anillo una sola vez (en PSRAM si está disponible)
+ * @param entry_count Número de entradas
+ * @param entry_size Capacidad de cada entrada en bytes
+ * @return ESP_OK si exitoso, ESP_ERR_NO_MEM si no hay memoria
+ */
+esp_err_t preroll_ring_init(size_t entry_count, size_t entry_size);
+
+/**
+ * @brief Libera las entradas del anillo
+ * @note Deja de entregar frames y espera hasta FRAME_REFS_DRAIN_MS a que los lectores
+ *       suelten los suyos; si alguno sigue vivo no libera nada
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_STATE si quedan frames adquiridos
+ */
+esp_err_t preroll_ring_deinit(void);
+
+/**
+ * @brief Reserva la entrada más antigua reutilizable (no congelada ni en lectura)
+ * @param len Tamaño de los datos a escribir
+ * @param data Puntero donde almacenar la dirección del buffer escribible
+ * @return Handle de la entrada o NULL si no hay entrada disponible
+ */
+camera_frame_t* preroll_ring_begin_write(size_t len, uint8_t **data);
+
+/**
+ * @brief Marca como válida una entrada escrita
+ * @param frame Handle obtenido con preroll_ring_begin_write()
+ */
+void preroll_ring_commit(camera_frame_t *frame);
+
+/**
+ * @brief Descarta una entrada en escritura
+ * @param frame Handle obtenido con preroll_ring_begin_write()
+ */
+void preroll_ring_abort(camera_frame_t *frame);
+
+/**
+ * @brief Congela los frames capturados en un intervalo en un episodio
+ * @note Descongela el episodio anterior; sus entradas se reciclan al liberarse.
+ *       El episodio congelado se sirve en /photo/preroll hasta el siguiente
+ * @param episode_id Identificador del episodio (distinto de 0)
+ * @param since Instante mínimo de captura (esp_timer, microsegundos)
+ * @param until Instante máximo de captura, incluido
+ * @return Número de frames congelados
+ */
+size_t preroll_ring_freeze(uint32_t episode_id, uint64_t since, uint64_t until);
+
+/**
+ * @brief Adquiere referencias a los frames de un episodio en orden cronológico
+ * @param episode_id Identificador del episodio
+ * @param frames Arreglo donde almacenar los handles
+ * @param max_frames Capacidad del arreglo
+ * @return Número de frames adquiridos (liberar cada uno con preroll_ring_release())
+ */
+size_t preroll_ring_acquire_episode(uint32_t episode_id, camera_frame_t **frames, size_t max_frames);
+
+/**
+ * @brief Adquiere una referencia al frame más reciente del anillo (vista en vivo)
+ * @return Handle del frame o NULL si el anillo está vacío (liberar con preroll_ring_release())
+ */
+camera_frame_t* preroll_ring_acquire_latest(void);
+
+/**
+ * @brief Libera una referencia obtenida con preroll_ring_acquire_episode() o preroll_ring_acquire_latest()
+ * @param frame Handle del frame (NULL se ignora)
+ */
+void preroll_ring_release(camera_frame_t *frame);
+
+/**
+ * @brief Escribe el índice de un episodio como JSON compacto para /photo/preroll
+ * @note "index" es la posición del frame en orden cronológico (?index= en /photo/preroll)
+ * @param episode_id Identificador del episodio
+ * @param frames Frames obtenidos con preroll_ring_acquire_episode()
+ * @param count Número de frames
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita (como snprintf: >= size indica truncado)
+ */
+int preroll_ring_episode_json(uint32_t episode_id, camera_frame_t *const *frames, size_t count,
+                              char *buf, size_t size);
+
+/**
+ * @brief Obtiene las estadísticas del anillo
+ * @return Estructura con estadísticas
+ */
+preroll_ring_stats_t preroll_ring_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PREROLL_RING_H
@@ -0,0 +1,116 @@
+// rate_control.h - Control en lazo cerrado del tamaño JPEG por frame
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RATE_CONTROL_MAX_STEPS  4
+
+// Escalón de resolución permitido (de menor a mayor número de píxeles)
+typedef struct {
+    int16_t frame_size;       // Valor de framesize_t
+    uint32_t pixels;          // Ancho x alto, para estimar el tamaño tras el cambio
+} rate_control_step_t;
+
+// Configuración del controlador
+typedef struct {
+    uint32_t target_bytes;        // Bytes por frame objetivo (0 = sin objetivo por frame)
+    uint32_t target_bytes_per_sec;// Bytes por segundo objetivo, repartido según el intervalo medido
+                                  // (0 = sin objetivo por segundo; con ambos manda el menor)
+    uint32_t max_frame_bytes;     // Límite duro: por encima se corrige sin esperar (0 = sin límite)
+    uint8_t min_quality;          // Mejor calidad permitida (10-63, menor = más bytes)
+    uint8_t max_quality;          // Peor calidad permitida
+    uint8_t max_step;             // Cambio máximo de calidad por ajuste
+    uint8_t deadband_pct;         // Histéresis: sin ajustes mientras el error esté dentro de ±deadband
+    uint8_t settle_frames;        // Frames ignorados tras un cambio (buffers con la configuración anterior)
+    float gain;                   // Unidades de calidad por unidad de error logarítmico
+    float smoothing;              // Peso del frame nuevo en la media móvil (0-1]
+    uint8_t step_count;           // Escalones de resolución (0 = solo calidad)
+    rate_control_step_t steps[RATE_CONTROL_MAX_STEPS];
+} rate_control_config_t;
+
+#define RATE_CONTROL_DEFAULT_CONFIG() { \
+    .target_bytes = 48 * 1024, \
+    .target_bytes_per_sec = 0, \
+    .max_frame_bytes = 120 * 1024, \
+    .min_quality = 10, \
+    .max_quality = 40, \
+    .max_step = 6, \
+    .deadband_pct = 15, \
+    .settle_frames = 1, \
+    .gain = 14.0f, \
+    .smoothing = 0.5f, \
+    .step_count = 0 \
+}
+
+// Entrada del controlador: un frame capturado
+typedef struct {
+    size_t size;              // Bytes del JPEG
+    uint64_t timestamp;       // Momento de captura (microsegundos)
+    int16_t quality;          // Calidad con la que se capturó
+    int16_t frame_size;       // Resolución con la que se capturó
+} rate_control_sample_t;
+
+// Decisión tras cada frame
+typedef struct {
+    bool changed;             // true si hay que aplicar quality/frame_size
+    int16_t quality;
+    int16_t frame_size;
+    uint32_t budget;          // Presupuesto de bytes para este frame
+} rate_control_decision_t;
+
+// Estadísticas del controlador
+typedef struct {
+    uint32_t frames;              // Frames evaluados (sin contar los de asentamiento)
+    uint32_t over_budget;         // Frames por encima de budget * (1 + deadband)
+    uint32_t hard_limit_hits;     // Frames por encima de max_frame_bytes
+    uint32_t quality_changes;
+    uint32_t frame_size_changes;
+    uint32_t budget;              // Último presupuesto por frame
+    uint32_t average_size;        // Media móvil del tamaño
+    int16_t quality;              // Calidad actual
+    int16_t frame_size;           // Resolución actual
+} rate_control_stats_t;
+
+// Estado del controlador (lo posee quien captura; sin bloqueos internos)
+typedef struct {
+    rate_control_config_t config;
+    rate_control_stats_t stats;
+    float average;                // Media móvil (0 = sin muestras desde el último cambio)
+    float interval_us;            // Intervalo medio entre frames
+    uint64_t last_timestamp;
+    uint8_t settle_left;
+    bool synced;                  // true tras el primer frame (calidad/resolución conocidas)
+} rate_control_t;
+
+/**
+ * @brief Inicializa el controlador
+ * @param rc Estado del controlador
+ * @param config Configuración (objetivo, límites de calidad, histéresis, escalones)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t rate_control_init(rate_control_t *rc, const rate_control_config_t *config);
+
+/**
+ * @brief Procesa el tamaño de un frame y decide la siguiente calidad/resolución
+ * @note Si el frame se capturó con otra configuración (cambio externo) el controlador
+ *       la adopta y vuelve a medir antes de ajustar
+ * @param rc Estado del controlador
+ * @param sample Frame capturado
+ * @param decision Estructura donde almacenar la decisión
+ */
+void rate_control_update(rate_control_t *rc, const rate_control_sample_t *sample,
+                         rate_control_decision_t *decision);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RATE_CONTROL_H
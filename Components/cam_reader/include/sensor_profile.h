@@ -0,0 +1,205 @@
+// sensor_profile.h - Perfiles declarativos de registros del sensor aplicados por diferencias
+#ifndef SENSOR_PROFILE_H
+#define SENSOR_PROFILE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ajustes del sensor que puede fijar un perfil (uno por función set_* del driver)
+typedef enum {
+    SENSOR_REG_BRIGHTNESS = 0,
+    SENSOR_REG_CONTRAST,
+    SENSOR_REG_SATURATION,
+    SENSOR_REG_WHITEBAL,
+    SENSOR_REG_AWB_GAIN,
+    SENSOR_REG_WB_MODE,
+    SENSOR_REG_EXPOSURE_CTRL,
+    SENSOR_REG_AEC2,
+    SENSOR_REG_AE_LEVEL,
+    SENSOR_REG_AEC_VALUE,
+    SENSOR_REG_GAIN_CTRL,
+    SENSOR_REG_AGC_GAIN,
+    SENSOR_REG_GAINCEILING,
+    SENSOR_REG_BPC,
+    SENSOR_REG_WPC,
+    SENSOR_REG_RAW_GMA,
+    SENSOR_REG_LENC,
+    SENSOR_REG_HMIRROR,
+    SENSOR_REG_VFLIP,
+    SENSOR_REG_DCW,
+    SENSOR_REG_COLORBAR,
+    SENSOR_REG_COUNT
+} sensor_reg_t;
+
+// Rangos válidos del OV2640 (los mismos que aceptan las funciones set_* del driver)
+#define SENSOR_REG_BRIGHTNESS_MIN       -2
+#define SENSOR_REG_BRIGHTNESS_MAX       2
+#define SENSOR_REG_CONTRAST_MIN         -2
+#define SENSOR_REG_CONTRAST_MAX         2
+#define SENSOR_REG_SATURATION_MIN       -2
+#define SENSOR_REG_SATURATION_MAX       2
+#define SENSOR_REG_WHITEBAL_MIN         0
+#define SENSOR_REG_WHITEBAL_MAX         1
+#define SENSOR_REG_AWB_GAIN_MIN         0
+#define SENSOR_REG_AWB_GAIN_MAX         1
+#define SENSOR_REG_WB_MODE_MIN          0
+#define SENSOR_REG_WB_MODE_MAX          4
+#define SENSOR_REG_EXPOSURE_CTRL_MIN    0
+#define SENSOR_REG_EXPOSURE_CTRL_MAX    1
+#define SENSOR_REG_AEC2_MIN             0
+#define SENSOR_REG_AEC2_MAX             1
+#define SENSOR_REG_AE_LEVEL_MIN         -2
+#define SENSOR_REG_AE_LEVEL_MAX         2
+#define SENSOR_REG_AEC_VALUE_MIN        0
+#define SENSOR_REG_AEC_VALUE_MAX        1200
+#define SENSOR_REG_GAIN_CTRL_MIN        0
+#define SENSOR_REG_GAIN_CTRL_MAX        1
+#define SENSOR_REG_AGC_GAIN_MIN         0
+#define SENSOR_REG_AGC_GAIN_MAX         30
+#define SENSOR_REG_GAINCEILING_MIN      0
+#define SENSOR_REG_GAINCEILING_MAX      6
+#define SENSOR_REG_BPC_MIN              0
+#define SENSOR_REG_BPC_MAX              1
+#define SENSOR_REG_WPC_MIN              0
+#define SENSOR_REG_WPC_MAX              1
+#define SENSOR_REG_RAW_GMA_MIN          0
+#define SENSOR_REG_RAW_GMA_MAX          1
+#define SENSOR_REG_LENC_MIN             0
+#define SENSOR_REG_LENC_MAX             1
+#define SENSOR_REG_HMIRROR_MIN          0
+#define SENSOR_REG_HMIRROR_MAX          1
+#define SENSOR_REG_VFLIP_MIN            0
+#define SENSOR_REG_VFLIP_MAX            1
+#define SENSOR_REG_DCW_MIN              0
+#define SENSOR_REG_DCW_MAX              1
+#define SENSOR_REG_COLORBAR_MIN         0
+#define SENSOR_REG_COLORBAR_MAX         1
+
+// Par registro-valor de un perfil
+typedef struct {
+    uint8_t reg;              // sensor_reg_t
+    int16_t value;
+} sensor_reg_value_t;
+
+/**
+ * Entrada de perfil validada en compilación: un valor fuera de rango produce un
+ * array de tamaño negativo y el perfil no compila.
+ *   SENSOR_PROFILE_ENTRY(BRIGHTNESS, -1)
+ */
+#define SENSOR_PROFILE_ENTRY(name, v) { \
+    .reg = SENSOR_REG_##name, \
+    .value = (int16_t)((v) + 0 * (int)sizeof(char[((v) >= SENSOR_REG_##name##_MIN && \
+                                                   (v) <= SENSOR_REG_##name##_MAX) ? 1 : -1])) \
+}
+
+// Perfil: lista constante de ajustes; los registros que no aparecen no se tocan
+typedef struct {
+    const char *name;
+    const sensor_reg_value_t *entries;
+    size_t count;
+} sensor_profile_t;
+
+#define SENSOR_PROFILE_DEFINE(profile_name, table) { \
+    .name = (profile_name), \
+    .entries = (table), \
+    .count = sizeof(table) / sizeof((table)[0]) \
+}
+
+// Estadísticas de cambios de perfil
+typedef struct {
+    uint32_t switches;            // Perfiles aplicados
+    uint32_t registers_written;   // Escrituras SCCB realizadas
+    uint32_t registers_skipped;   // Escrituras evitadas porque el valor ya estaba aplicado
+    uint32_t write_errors;        // Escrituras rechazadas por el sensor
+    uint32_t last_switch_us;      // Duración del último cambio de perfil
+    uint32_t max_switch_us;       // Duración máxima de un cambio de perfil
+    uint8_t last_written;         // Registros escritos en el último cambio
+    const char *active;           // Último perfil aplicado (NULL si ninguno)
+} sensor_profile_stats_t;
+
+// Último estado aplicado al sensor (lo posee quien escribe en el sensor; sin bloqueos internos)
+typedef struct {
+    int16_t values[SENSOR_REG_COUNT];
+    uint32_t known;               // Bit por registro con valor conocido
+    sensor_profile_stats_t stats;
+} sensor_profile_state_t;
+
+/**
+ * @brief Escribe un registro en el sensor
+ * @param ctx Contexto del escritor (p. ej. sensor_t *)
+ * @param reg Registro a escribir
+ * @param value Valor ya validado
+ * @return 0 si el sensor aceptó el valor, distinto de 0 en caso contrario
+ */
+typedef int (*sensor_reg_writer_t)(void *ctx, sensor_reg_t reg, int16_t value);
+
+/**
+ * @brief Inicializa el estado con todos los registros desconocidos
+ * @note Llamar también tras un reset del sensor: el primer perfil se escribe completo
+ * @param state Estado a inicializar
+ */
+void sensor_profile_state_init(sensor_profile_state_t *state);
+
+/**
+ * @brief Comprueba en tiempo de carga que todos los valores del perfil estén en rango
+ * @param profile Perfil a validar (p. ej. construido en tiempo de ejecución)
+ * @return ESP_OK si es válido, ESP_ERR_INVALID_ARG si hay valores fuera de rango o registros repetidos
+ */
+esp_err_t sensor_profile_validate(const sensor_profile_t *profile);
+
+/**
+ * @brief Calcula los registros del perfil que difieren del estado aplicado
+ * @param state Último estado aplicado
+ * @param profile Perfil destino
+ * @param out Array donde almacenar las escrituras necesarias (puede ser NULL para solo contar)
+ * @param capacity Capacidad de out
+ * @return Número de escrituras necesarias
+ */
+size_t sensor_profile_diff(const sensor_profile_state_t *state, const sensor_profile_t *profile,
+                           sensor_reg_value_t *out, size_t capacity);
+
+/**
+ * @brief Aplica un perfil escribiendo solo los registros que cambian
+ * @note Un registro que el sensor rechaza queda como desconocido y se reintenta en el
+ *       siguiente cambio de perfil
+ * @param state Último estado aplicado (se actualiza)
+ * @param profile Perfil destino
+ * @param writer Función que escribe un registro en el sensor
+ * @param ctx Contexto para writer
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si el perfil es inválido,
+ *         ESP_FAIL si alguna escritura falló
+ */
+esp_err_t sensor_profile_apply(sensor_profile_state_t *state, const sensor_profile_t *profile,
+                               sensor_reg_writer_t writer, void *ctx);
+
+/**
+ * @brief Escribe un único registro si difiere del estado aplicado
+ * @param state Último estado aplicado (se actualiza)
+ * @param reg Registro
+ * @param value Valor
+ * @param writer Función que escribe un registro en el sensor
+ * @param ctx Contexto para writer
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si el valor está fuera de rango,
+ *         ESP_FAIL si el sensor lo rechazó
+ */
+esp_err_t sensor_profile_set(sensor_profile_state_t *state, sensor_reg_t reg, int16_t value,
+                             sensor_reg_writer_t writer, void *ctx);
+
+/**
+ * @brief Nombre legible de un registro (para logs)
+ * @param reg Registro
+ * @return Nombre del registro
+ */
+const char* sensor_profile_reg_name(sensor_reg_t reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_PROFILE_H
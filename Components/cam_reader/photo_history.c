@@ -0,0 +1,337 @@
+// photo_history.c - Responsabilidad única: historial acotado de fotos indexado por secuencia
+//
+// Los JPEG se copian uno tras otro en un anillo de bytes de tamaño fijo (una foto HD de
+// 60 KB no ocupa un slot de 192 KB) y el índice es un anillo de entradas en orden de
+// secuencia: buscar una secuencia es una búsqueda binaria sobre él. Cuando una foto nueva
+// no cabe se expulsan las más antiguas, salvo que alguna se esté enviando a un cliente.
+#include "photo_history.h"
+#include "capture_queue.h"
+#include "frame_refs.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "PHOTO_HISTORY";
+
+typedef struct {
+    camera_frame_t frame;     // Debe ser el primer miembro (handle público)
+    size_t offset;            // Posición de los datos en el anillo
+    uint32_t refcount;
+    bool ready;               // false mientras el productor copia los datos
+} history_entry_t;
+
+// Variables privadas del módulo
+static history_entry_t *entries = NULL;
+static size_t max_entries = 0;
+static size_t head = 0;           // Entrada más antigua
+static size_t count = 0;
+static uint8_t *data = NULL;
+static size_t capacity = 0;
+static size_t tail = 0;           // Fin de los datos de la entrada más reciente
+static photo_history_stats_t stats = {0};
+static bool closing = false;
+static portMUX_TYPE history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Entrada i-ésima en orden de secuencia (0 = la más antigua)
+static inline history_entry_t *entry_at(size_t i) {
+    return &entries[(head + i) % max_entries];
+}
+
+// Entradas visibles para los lectores: la más reciente no lo es mientras se copia
+static size_t ready_count(void) {
+    if (count > 0 && !entry_at(count - 1)->ready) {
+        return count - 1;
+    }
+    return count;
+}
+
+// Fotos con lectores o en copia (con history_lock tomado)
+static size_t busy_entries(void) {
+    size_t busy = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (entry_at(i)->refcount > 0 || !entry_at(i)->ready) {
+            busy++;
+        }
+    }
+    return busy;
+}
+
+// Primera entrada con seq >= objetivo (búsqueda binaria; el índice está ordenado)
+static size_t lower_bound(uint32_t seq, size_t n) {
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entry_at(mid)->frame.seq < seq) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+esp_err_t photo_history_init(const photo_history_config_t *config) {
+    if (config == NULL || (config->memory_budget > 0 && config->max_entries < 2)) {
+        ESP_LOGE(TAG, "Configuración inválida");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (data != NULL) {
+        ESP_LOGW(TAG, "Historial ya inicializado");
+        return ESP_OK;
+    }
+    if (config->memory_budget == 0) {
+        ESP_LOGI(TAG, "Historial de fotos desactivado");
+        return ESP_OK;
+    }
+
+    entries = calloc(config->max_entries, sizeof(history_entry_t));
+#if CONFIG_SPIRAM
+    data = heap_caps_malloc(config->memory_budget, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    data = malloc(config->memory_budget);
+#endif
+    if (entries == NULL || data == NULL) {
+        ESP_LOGE(TAG, "Error asignando historial (%zu bytes)", config->memory_budget);
+        free(entries);
+        free(data);
+        entries = NULL;
+        data = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    max_entries = config->max_entries;
+    capacity = config->memory_budget;
+    head = 0;
+    count = 0;
+    tail = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.memory_budget = capacity;
+
+    ESP_LOGI(TAG, "Historial de fotos listo: %zu KB para %zu fotos como máximo",
+             capacity / 1024, max_entries);
+    return ESP_OK;
+}
+
+esp_err_t photo_history_deinit(void) {
+    if (data == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = frame_refs_drain(&history_lock, &closing, busy_entries, FRAME_REFS_DRAIN_MS, TAG);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Sin referencias: retirar el índice y los datos bajo el lock y liberarlos fuera
+    portENTER_CRITICAL(&history_lock);
+    history_entry_t *old_entries = entries;
+    uint8_t *old_data = data;
+    entries = NULL;
+    data = NULL;
+    count = 0;
+    max_entries = 0;
+    capacity = 0;
+    closing = false;
+    portEXIT_CRITICAL(&history_lock);
+
+    free(old_entries);
+    free(old_data);
+    return ESP_OK;
+}
+
+esp_err_t photo_history_append(const camera_frame_t *frame) {
+    if (frame == NULL || frame->buf == NULL || frame->len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t len = frame->len;
+
+    portENTER_CRITICAL(&history_lock);
+    if (data == NULL || closing) {
+        portEXIT_CRITICAL(&history_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len > capacity) {
+        stats.dropped_too_large++;
+        portEXIT_CRITICAL(&history_lock);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (count > 0 && entry_at(count - 1)->frame.seq >= frame->seq) {
+        portEXIT_CRITICAL(&history_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Decidir cuántas de las más antiguas hay que expulsar antes de tocar nada: si alguna
+    // se está enviando la foto nueva se descarta y el historial queda como estaba
+    size_t evict = (count == max_entries) ? 1 : 0;
+    size_t offset = 0;
+    while (evict < count) {
+        const history_entry_t *oldest = entry_at(evict);
+        if (tail > oldest->offset) {
+            // Datos contiguos [oldest, tail): hueco al final o, si no cabe, al principio
+            if (tail + len <= capacity) {
+                offset = tail;
+                break;
+            }
+            if (len <= oldest->offset) {
+                offset = 0;
+                break;
+            }
+        } else if (tail + len <= oldest->offset) {
+            // Datos que dan la vuelta: el único hueco está entre tail y la más antigua
+            offset = tail;
+            break;
+        }
+        evict++;
+    }
+    for (size_t i = 0; i < evict; i++) {
+        if (entry_at(i)->refcount > 0) {
+            stats.dropped_busy++;
+            portEXIT_CRITICAL(&history_lock);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    for (size_t i = 0; i < evict; i++) {
+        stats.bytes_used -= entry_at(i)->frame.len;
+    }
+    head = (head + evict) % max_entries;
+    count -= evict;
+    stats.evicted += evict;
+    if (count == 0) {
+        offset = 0;
+    }
+
+    // La entrada queda indexada pero invisible hasta terminar la copia
+    history_entry_t *entry = entry_at(count);
+    entry->frame = *frame;
+    entry->frame.buf = data + offset;
+    entry->frame.thumb = NULL;
+    entry->frame.thumb_len = 0;
+    entry->offset = offset;
+    entry->refcount = 0;
+    entry->ready = false;
+    count++;
+    tail = offset + len;
+    stats.bytes_used += len;
+    portEXIT_CRITICAL(&history_lock);
+
+    // Copia fuera del cerrojo: ningún lector ve esta zona hasta que ready = true
+    memcpy(data + offset, frame->buf, len);
+
+    portENTER_CRITICAL(&history_lock);
+    entry->ready = true;
+    stats.stored++;
+    portEXIT_CRITICAL(&history_lock);
+    return ESP_OK;
+}
+
+size_t photo_history_list(uint32_t since, size_t limit, photo_history_page_t *page) {
+    if (page == NULL) {
+        return 0;
+    }
+    memset(page, 0, sizeof(*page));
+    page->since = since;
+    if (limit > PHOTO_HISTORY_LIST_MAX) {
+        limit = PHOTO_HISTORY_LIST_MAX;
+    }
+
+    portENTER_CRITICAL(&history_lock);
+    size_t n = ready_count();
+    if (n > 0) {
+        page->oldest_seq = entry_at(0)->frame.seq;
+        page->latest_seq = entry_at(n - 1)->frame.seq;
+    }
+    size_t first = (since == UINT32_MAX) ? n : lower_bound(since + 1, n);
+    for (size_t i = first; i < n && page->count < limit; i++) {
+        const camera_frame_t *frame = &entry_at(i)->frame;
+        photo_history_info_t *info = &page->entries[page->count++];
+        info->seq = frame->seq;
+        info->timestamp = frame->timestamp;
+        info->wall_time_ms = frame->meta.wall_time_ms;
+        info->len = frame->len;
+        info->episode_id = frame->meta.episode_id;
+        info->width = frame->width;
+        info->height = frame->height;
+        info->reason = frame->meta.reason;
+    }
+    page->more = first + page->count < n;
+    portEXIT_CRITICAL(&history_lock);
+
+    return page->count;
+}
+
+camera_frame_t* photo_history_acquire(uint32_t seq) {
+    camera_frame_t *frame = NULL;
+
+    portENTER_CRITICAL(&history_lock);
+    stats.lookups++;
+    size_t n = closing ? 0 : ready_count();
+    size_t i = lower_bound(seq, n);
+    if (i < n && entry_at(i)->frame.seq == seq) {
+        history_entry_t *entry = entry_at(i);
+        entry->refcount++;
+        frame = &entry->frame;
+    } else {
+        stats.misses++;
+    }
+    portEXIT_CRITICAL(&history_lock);
+
+    return frame;
+}
+
+void photo_history_release(camera_frame_t *frame) {
+    if (frame == NULL) {
+        return;
+    }
+
+    history_entry_t *entry = (history_entry_t *)frame;
+    portENTER_CRITICAL(&history_lock);
+    if (entry->refcount > 0) {
+        entry->refcount--;
+    }
+    portEXIT_CRITICAL(&history_lock);
+}
+
+photo_history_stats_t photo_history_get_stats(void) {
+    portENTER_CRITICAL(&history_lock);
+    photo_history_stats_t current = stats;
+    size_t n = ready_count();
+    current.count = n;
+    if (n > 0) {
+        current.oldest_seq = entry_at(0)->frame.seq;
+        current.latest_seq = entry_at(n - 1)->frame.seq;
+    }
+    portEXIT_CRITICAL(&history_lock);
+    return current;
+}
+
+int photo_history_page_json(const photo_history_page_t *page, char *buf, size_t size) {
+    uint32_t next = page->count > 0 ? page->entries[page->count - 1].seq : page->since;
+    int len = snprintf(buf, size,
+        "{\"since\":%lu,\"oldest\":%lu,\"latest\":%lu,\"next\":%lu,\"more\":%s,\"photos\":[",
+        (unsigned long)page->since, (unsigned long)page->oldest_seq,
+        (unsigned long)page->latest_seq, (unsigned long)next, page->more ? "true" : "false");
+
+    for (size_t i = 0; i < page->count && len < (int)size; i++) {
+        const photo_history_info_t *info = &page->entries[i];
+        len += snprintf(buf + len, size - len,
+            "%s{\"seq\":%lu,\"ts\":%llu,\"time\":%lld,\"reason\":\"%s\",\"size\":%lu,"
+            "\"w\":%u,\"h\":%u,\"episode\":%lu}",
+            i > 0 ? "," : "", (unsigned long)info->seq, (unsigned long long)info->timestamp,
+            (long long)info->wall_time_ms,
+            camera_capture_reason_name((camera_capture_reason_t)info->reason),
+            (unsigned long)info->len, info->width, info->height, (unsigned long)info->episode_id);
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+    return len;
+}
@@ -0,0 +1,321 @@
+// preroll_ring.c - Responsabilidad única: anillo de frames previos a la detección
+#include "preroll_ring.h"
+#include "frame_refs.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "PREROLL_RING";
+
+typedef struct {
+    camera_frame_t frame;     // Debe ser el primer miembro (handle público)
+    uint8_t *data;
+    size_t capacity;
+    uint32_t refcount;
+    uint32_t episode;         // 0 = no congelado
+    bool writing;
+    bool valid;
+} preroll_entry_t;
+
+// Variables privadas del módulo
+static preroll_entry_t *entries = NULL;
+static size_t entry_count = 0;
+static uint32_t next_seq = 0;
+static preroll_ring_stats_t stats = {0};
+static bool closing = false;
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void free_entry_table(preroll_entry_t *table, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(table[i].data);
+    }
+    free(table);
+}
+
+static void free_entries(void) {
+    free_entry_table(entries, entry_count);
+    entries = NULL;
+    entry_count = 0;
+}
+
+// Entradas con lectores o en escritura (con ring_lock tomado)
+static size_t busy_entries(void) {
+    size_t busy = 0;
+
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entries[i].refcount > 0 || entries[i].writing) {
+            busy++;
+        }
+    }
+    return busy;
+}
+
+size_t preroll_ring_entries_needed(uint32_t preroll_ms, uint32_t frame_interval_ms) {
+    if (frame_interval_ms == 0) {
+        return 0;
+    }
+
+    size_t window = preroll_ms / frame_interval_ms + 1;
+    return 2 * window + 2;
+}
+
+esp_err_t preroll_ring_init(size_t count, size_t entry_size) {
+    if (count < 2 || entry_size == 0) {
+        ESP_LOGE(TAG, "Configuración inválida: %zu entradas de %zu bytes", count, entry_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (entries != NULL) {
+        ESP_LOGW(TAG, "Anillo ya inicializado");
+        return ESP_OK;
+    }
+
+    entries = calloc(count, sizeof(preroll_entry_t));
+    if (entries == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry_count = count;
+
+    // Todas las entradas se reservan aquí: el anillo nunca asigna memoria por frame
+    for (size_t i = 0; i < entry_count; i++) {
+#if CONFIG_SPIRAM
+        entries[i].data = heap_caps_malloc(entry_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+        entries[i].data = malloc(entry_size);
+#endif
+        if (entries[i].data == NULL) {
+            ESP_LOGE(TAG, "Error asignando entrada %zu (%zu bytes)", i, entry_size);
+            free_entries();
+            return ESP_ERR_NO_MEM;
+        }
+        entries[i].capacity = entry_size;
+        entries[i].frame.buf = entries[i].data;
+    }
+
+    next_seq = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.entry_count = entry_count;
+
+    ESP_LOGI(TAG, "Anillo pre-disparo listo: %zu entradas de %zu KB",
+             entry_count, entry_size / 1024);
+    return ESP_OK;
+}
+
+esp_err_t preroll_ring_deinit(void) {
+    if (entries == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = frame_refs_drain(&ring_lock, &closing, busy_entries, FRAME_REFS_DRAIN_MS, TAG);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Sin referencias: retirar las entradas bajo el lock y liberarlas fuera
+    portENTER_CRITICAL(&ring_lock);
+    preroll_entry_t *table = entries;
+    size_t count = entry_count;
+    entries = NULL;
+    entry_count = 0;
+    closing = false;
+    portEXIT_CRITICAL(&ring_lock);
+
+    free_entry_table(table, count);
+    return ESP_OK;
+}
+
+camera_frame_t* preroll_ring_begin_write(size_t len, uint8_t **data) {
+    if (data == NULL) {
+        return NULL;
+    }
+    *data = NULL;
+
+    preroll_entry_t *target = NULL;
+
+    portENTER_CRITICAL(&ring_lock);
+    if (entries == NULL || closing) {
+        portEXIT_CRITICAL(&ring_lock);
+        return NULL;
+    }
+    if (len <= entries[0].capacity) {
+        // Reciclar la entrada válida más antigua o la primera vacía
+        for (size_t i = 0; i < entry_count; i++) {
+            preroll_entry_t *entry = &entries[i];
+            if (entry->writing || entry->refcount > 0 || entry->episode != 0) {
+                continue;
+            }
+            if (!entry->valid) {
+                target = entry;
+                break;
+            }
+            if (target == NULL || entry->frame.seq < target->frame.seq) {
+                target = entry;
+            }
+        }
+    }
+
+    if (target != NULL) {
+        target->writing = true;
+        target->valid = false;
+        target->frame.len = len;
+        memset(&target->frame.meta, 0, sizeof(target->frame.meta));
+    } else {
+        stats.dropped++;
+    }
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (target == NULL) {
+        return NULL;
+    }
+
+    *data = target->data;
+    return &target->frame;
+}
+
+void preroll_ring_commit(camera_frame_t *frame) {
+    preroll_entry_t *entry = (preroll_entry_t *)frame;
+
+    portENTER_CRITICAL(&ring_lock);
+    entry->frame.seq = ++next_seq;
+    entry->writing = false;
+    entry->valid = true;
+    stats.captured++;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+void preroll_ring_abort(camera_frame_t *frame) {
+    preroll_entry_t *entry = (preroll_entry_t *)frame;
+
+    portENTER_CRITICAL(&ring_lock);
+    entry->writing = false;
+    entry->valid = false;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+size_t preroll_ring_freeze(uint32_t episode_id, uint64_t since, uint64_t until) {
+    size_t frozen = 0;
+
+    if (episode_id == 0) {
+        return 0;
+    }
+
+    // entries se comprueba bajo el lock: preroll_ring_deinit() lo retira con él tomado
+    portENTER_CRITICAL(&ring_lock);
+    if (entries == NULL || closing) {
+        portEXIT_CRITICAL(&ring_lock);
+        return 0;
+    }
+    for (size_t i = 0; i < entry_count; i++) {
+        preroll_entry_t *entry = &entries[i];
+
+        // Descongelar el episodio anterior
+        entry->episode = 0;
+        entry->frame.meta.episode_id = 0;
+
+        // El episodio viaja en los metadatos (X-Episode-Id de /photo/preroll)
+        if (entry->valid && entry->frame.timestamp >= since && entry->frame.timestamp <= until) {
+            entry->episode = episode_id;
+            entry->frame.meta.episode_id = episode_id;
+            frozen++;
+        }
+    }
+    stats.frozen = frozen;
+    stats.frozen_episode = episode_id;
+    portEXIT_CRITICAL(&ring_lock);
+
+    return frozen;
+}
+
+size_t preroll_ring_acquire_episode(uint32_t episode_id, camera_frame_t **frames, size_t max_frames) {
+    size_t count = 0;
+
+    if (episode_id == 0 || frames == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&ring_lock);
+    for (size_t i = 0; !closing && i < entry_count && count < max_frames; i++) {
+        preroll_entry_t *entry = &entries[i];
+        if (entry->episode != episode_id) {
+            continue;
+        }
+        entry->refcount++;
+
+        // Inserción ordenada por secuencia (pocas entradas)
+        size_t pos = count++;
+        while (pos > 0 && frames[pos - 1]->seq > entry->frame.seq) {
+            frames[pos] = frames[pos - 1];
+            pos--;
+        }
+        frames[pos] = &entry->frame;
+    }
+    portEXIT_CRITICAL(&ring_lock);
+
+    return count;
+}
+
+camera_frame_t* preroll_ring_acquire_latest(void) {
+    preroll_entry_t *latest = NULL;
+
+    portENTER_CRITICAL(&ring_lock);
+    for (size_t i = 0; !closing && i < entry_count; i++) {
+        preroll_entry_t *entry = &entries[i];
+        if (entry->valid && (latest == NULL || entry->frame.seq > latest->frame.seq)) {
+            latest = entry;
+        }
+    }
+    if (latest != NULL) {
+        latest->refcount++;
+    }
+    portEXIT_CRITICAL(&ring_lock);
+
+    return latest ? &latest->frame : NULL;
+}
+
+void preroll_ring_release(camera_frame_t *frame) {
+    if (frame == NULL) {
+        return;
+    }
+
+    preroll_entry_t *entry = (preroll_entry_t *)frame;
+
+    portENTER_CRITICAL(&ring_lock);
+    if (entry->refcount > 0) {
+        entry->refcount--;
+    }
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+preroll_ring_stats_t preroll_ring_get_stats(void) {
+    preroll_ring_stats_t copy;
+
+    portENTER_CRITICAL(&ring_lock);
+    copy = stats;
+    portEXIT_CRITICAL(&ring_lock);
+
+    return copy;
+}
+
+int preroll_ring_episode_json(uint32_t episode_id, camera_frame_t *const *frames, size_t count,
+                              char *buf, size_t size) {
+    int len = snprintf(buf, size, "{\"episode\":%lu,\"count\":%u,\"frames\":[",
+                       (unsigned long)episode_id, (unsigned)count);
+
+    for (size_t i = 0; i < count && len < (int)size; i++) {
+        const camera_frame_t *frame = frames[i];
+        len += snprintf(buf + len, size - len,
+            "%s{\"index\":%u,\"seq\":%lu,\"ts\":%llu,\"time\":%lld,\"size\":%lu,"
+            "\"w\":%u,\"h\":%u}",
+            i > 0 ? "," : "", (unsigned)i, (unsigned long)frame->seq,
+            (unsigned long long)frame->timestamp, (long long)frame->meta.wall_time_ms,
+            (unsigned long)frame->len, frame->width, frame->height);
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+    return len;
+}
@@ -0,0 +1,158 @@
+// rate_control.c - Responsabilidad única: mantener el tamaño JPEG dentro de un presupuesto
+//
+// El tamaño de un JPEG cae de forma aproximadamente exponencial con la calidad del
+// OV2640, así que el error se mide en escala logarítmica (log(media / presupuesto))
+// y se convierte en pasos de calidad con una ganancia fija. Dentro de la banda
+// muerta no se toca nada; tras cada cambio se descartan los frames que aún salen
+// con la configuración anterior y la media vuelve a empezar.
+#include "rate_control.h"
+#include <string.h>
+#include <math.h>
+
+#define INTERVAL_SMOOTHING  0.25f
+
+static int find_step(const rate_control_config_t *config, int16_t frame_size) {
+    for (int i = 0; i < config->step_count; i++) {
+        if (config->steps[i].frame_size == frame_size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t frame_budget(const rate_control_t *rc) {
+    uint32_t budget = rc->config.target_bytes;
+
+    if (rc->config.target_bytes_per_sec > 0 && rc->interval_us > 0) {
+        uint32_t per_frame = (uint32_t)(rc->config.target_bytes_per_sec * (rc->interval_us / 1000000.0f));
+        if (budget == 0 || per_frame < budget) {
+            budget = per_frame;
+        }
+    }
+    return budget;
+}
+
+esp_err_t rate_control_init(rate_control_t *rc, const rate_control_config_t *config) {
+    if (rc == NULL || config == NULL ||
+        (config->target_bytes == 0 && config->target_bytes_per_sec == 0) ||
+        config->min_quality > config->max_quality || config->max_step == 0 ||
+        config->gain <= 0.0f || config->smoothing <= 0.0f || config->smoothing > 1.0f ||
+        config->step_count > RATE_CONTROL_MAX_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < config->step_count; i++) {
+        if (config->steps[i].pixels == 0 || (i > 0 && config->steps[i].pixels <= config->steps[i - 1].pixels)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memset(rc, 0, sizeof(*rc));
+    rc->config = *config;
+    return ESP_OK;
+}
+
+void rate_control_update(rate_control_t *rc, const rate_control_sample_t *sample,
+                         rate_control_decision_t *decision) {
+    const rate_control_config_t *config = &rc->config;
+
+    decision->changed = false;
+    decision->quality = sample->quality;
+    decision->frame_size = sample->frame_size;
+
+    if (rc->last_timestamp != 0 && sample->timestamp > rc->last_timestamp) {
+        float dt = (float)(sample->timestamp - rc->last_timestamp);
+        rc->interval_us = rc->interval_us == 0 ? dt :
+                          INTERVAL_SMOOTHING * dt + (1.0f - INTERVAL_SMOOTHING) * rc->interval_us;
+    }
+    rc->last_timestamp = sample->timestamp;
+
+    // Configuración cambiada desde fuera: adoptarla y medir de nuevo
+    if (!rc->synced || sample->quality != rc->stats.quality || sample->frame_size != rc->stats.frame_size) {
+        rc->stats.quality = sample->quality;
+        rc->stats.frame_size = sample->frame_size;
+        rc->average = 0;
+        rc->settle_left = 0;
+        rc->synced = true;
+    }
+
+    uint32_t budget = frame_budget(rc);
+    decision->budget = budget;
+    if (rc->settle_left > 0) {
+        rc->settle_left--;
+        return;
+    }
+
+    float size = (float)sample->size;
+    rc->average = rc->average == 0 ? size : config->smoothing * size + (1.0f - config->smoothing) * rc->average;
+    rc->stats.frames++;
+    rc->stats.budget = budget;
+    rc->stats.average_size = (uint32_t)rc->average;
+
+    if (budget == 0 || sample->size == 0) {
+        return;     // Objetivo por segundo sin intervalo medido todavía
+    }
+
+    float band = logf(1.0f + config->deadband_pct / 100.0f);
+    float error = logf(rc->average / budget);
+    bool hard_limit = config->max_frame_bytes > 0 && sample->size > config->max_frame_bytes;
+    if (logf(size / budget) > band) {
+        rc->stats.over_budget++;
+    }
+    if (hard_limit) {
+        rc->stats.hard_limit_hits++;
+    } else if (fabsf(error) <= band) {
+        return;
+    }
+
+    // Calidad mayor = menos bytes: error positivo sube la calidad numérica
+    int step = hard_limit ? config->max_step : (int)lroundf(error * config->gain);
+    if (step == 0) {
+        step = error > 0 ? 1 : -1;
+    }
+    if (step > config->max_step) {
+        step = config->max_step;
+    } else if (step < -config->max_step) {
+        step = -config->max_step;
+    }
+
+    int quality = rc->stats.quality + step;
+    if (quality < config->min_quality) {
+        quality = config->min_quality;
+    } else if (quality > config->max_quality) {
+        quality = config->max_quality;
+    }
+
+    int16_t frame_size = rc->stats.frame_size;
+    if (quality == rc->stats.quality) {
+        // Calidad saturada: recurrir a la escalera de resoluciones
+        int index = find_step(config, frame_size);
+        if (index > 0 && step > 0 && quality >= config->max_quality) {
+            frame_size = config->steps[index - 1].frame_size;
+        } else if (index >= 0 && index + 1 < config->step_count && step < 0 && quality <= config->min_quality) {
+            // Subir solo si la estimación por píxeles cabe en el presupuesto
+            float predicted = rc->average * config->steps[index + 1].pixels / config->steps[index].pixels;
+            if (logf(predicted / budget) <= band) {
+                frame_size = config->steps[index + 1].frame_size;
+            }
+        }
+    }
+
+    if (quality == rc->stats.quality && frame_size == rc->stats.frame_size) {
+        return;
+    }
+
+    if (quality != rc->stats.quality) {
+        rc->stats.quality_changes++;
+    }
+    if (frame_size != rc->stats.frame_size) {
+        rc->stats.frame_size_changes++;
+    }
+    rc->stats.quality = (int16_t)quality;
+    rc->stats.frame_size = frame_size;
+    rc->average = 0;
+    rc->settle_left = config->settle_frames;
+
+    decision->changed = true;
+    decision->quality = (int16_t)quality;
+    decision->frame_size = frame_size;
+}
@@ -0,0 +1,144 @@
+// sensor_profile.c - Responsabilidad única: aplicar perfiles del sensor escribiendo solo las diferencias
+//
+// Cada set_* del driver es una transacción SCCB (I2C) de varios bytes; aplicar un
+// perfil completo de 15-20 ajustes bloquea el sensor varios milisegundos y puede
+// perder frames. Se recuerda el último valor escrito de cada registro y un cambio
+// de perfil solo escribe los que difieren.
+#include "sensor_profile.h"
+#include "esp_timer.h"
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    int16_t min;
+    int16_t max;
+} reg_range_t;
+
+#define REG_RANGE(reg, label) [SENSOR_REG_##reg] = { label, SENSOR_REG_##reg##_MIN, SENSOR_REG_##reg##_MAX }
+
+static const reg_range_t reg_ranges[SENSOR_REG_COUNT] = {
+    REG_RANGE(BRIGHTNESS, "brightness"),
+    REG_RANGE(CONTRAST, "contrast"),
+    REG_RANGE(SATURATION, "saturation"),
+    REG_RANGE(WHITEBAL, "whitebal"),
+    REG_RANGE(AWB_GAIN, "awb_gain"),
+    REG_RANGE(WB_MODE, "wb_mode"),
+    REG_RANGE(EXPOSURE_CTRL, "exposure_ctrl"),
+    REG_RANGE(AEC2, "aec2"),
+    REG_RANGE(AE_LEVEL, "ae_level"),
+    REG_RANGE(AEC_VALUE, "aec_value"),
+    REG_RANGE(GAIN_CTRL, "gain_ctrl"),
+    REG_RANGE(AGC_GAIN, "agc_gain"),
+    REG_RANGE(GAINCEILING, "gainceiling"),
+    REG_RANGE(BPC, "bpc"),
+    REG_RANGE(WPC, "wpc"),
+    REG_RANGE(RAW_GMA, "raw_gma"),
+    REG_RANGE(LENC, "lenc"),
+    REG_RANGE(HMIRROR, "hmirror"),
+    REG_RANGE(VFLIP, "vflip"),
+    REG_RANGE(DCW, "dcw"),
+    REG_RANGE(COLORBAR, "colorbar"),
+};
+
+_Static_assert(SENSOR_REG_COUNT <= 32, "El estado usa una máscara de 32 bits");
+
+static bool value_valid(uint8_t reg, int16_t value) {
+    return reg < SENSOR_REG_COUNT && value >= reg_ranges[reg].min && value <= reg_ranges[reg].max;
+}
+
+static bool value_applied(const sensor_profile_state_t *state, uint8_t reg, int16_t value) {
+    return (state->known & (1u << reg)) && state->values[reg] == value;
+}
+
+// Escribe un registro y actualiza el estado; un fallo deja el registro como desconocido
+static bool write_reg(sensor_profile_state_t *state, uint8_t reg, int16_t value,
+                      sensor_reg_writer_t writer, void *ctx) {
+    if (writer(ctx, (sensor_reg_t)reg, value) != 0) {
+        state->known &= ~(1u << reg);
+        state->stats.write_errors++;
+        return false;
+    }
+    state->values[reg] = value;
+    state->known |= 1u << reg;
+    state->stats.registers_written++;
+    return true;
+}
+
+void sensor_profile_state_init(sensor_profile_state_t *state) {
+    memset(state, 0, sizeof(*state));
+}
+
+esp_err_t sensor_profile_validate(const sensor_profile_t *profile) {
+    if (profile == NULL || (profile->entries == NULL && profile->count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t seen = 0;
+    for (size_t i = 0; i < profile->count; i++) {
+        const sensor_reg_value_t *entry = &profile->entries[i];
+        if (!value_valid(entry->reg, entry->value) || (seen & (1u << entry->reg))) {
+            return ESP_ERR_INVALID_ARG;     // Fuera de rango o registro repetido
+        }
+        seen |= 1u << entry->reg;
+    }
+    return ESP_OK;
+}
+
+size_t sensor_profile_diff(const sensor_profile_state_t *state, const sensor_profile_t *profile,
+                           sensor_reg_value_t *out, size_t capacity) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < profile->count; i++) {
+        const sensor_reg_value_t *entry = &profile->entries[i];
+        if (value_applied(state, entry->reg, entry->value)) {
+            continue;
+        }
+        if (out != NULL && count < capacity) {
+            out[count] = *entry;
+        }
+        count++;
+    }
+    return count;
+}
+
+esp_err_t sensor_profile_apply(sensor_profile_state_t *state, const sensor_profile_t *profile,
+                               sensor_reg_writer_t writer, void *ctx) {
+    if (state == NULL || writer == NULL || sensor_profile_validate(profile) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sensor_reg_value_t writes[SENSOR_REG_COUNT];
+    size_t count = sensor_profile_diff(state, profile, writes, SENSOR_REG_COUNT);
+
+    int64_t start = esp_timer_get_time();
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        ok &= write_reg(state, writes[i].reg, writes[i].value, writer, ctx);
+    }
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+    state->stats.switches++;
+    state->stats.registers_skipped += profile->count - count;
+    state->stats.last_written = (uint8_t)count;
+    state->stats.last_switch_us = elapsed;
+    if (elapsed > state->stats.max_switch_us) {
+        state->stats.max_switch_us = elapsed;
+    }
+    state->stats.active = profile->name;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t sensor_profile_set(sensor_profile_state_t *state, sensor_reg_t reg, int16_t value,
+                             sensor_reg_writer_t writer, void *ctx) {
+    if (state == NULL || writer == NULL || !value_valid(reg, value)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (value_applied(state, reg, value)) {
+        state->stats.registers_skipped++;
+        return ESP_OK;
+    }
+    return write_reg(state, reg, value, writer, ctx) ? ESP_OK : ESP_FAIL;
+}
+
+const char* sensor_profile_reg_name(sensor_reg_t reg) {
+    return reg < SENSOR_REG_COUNT ? reg_ranges[reg].name : "?";
+}
@@ -0,0 +1,97 @@
+// jpeg_dc.h - Decodificador parcial JPEG (solo coeficientes DC)
+#ifndef JPEG_DC_H
+#define JPEG_DC_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Información de la imagen y del mapa de luminancia a escala 1/8
+typedef struct {
+    uint16_t width;           // Ancho de la imagen en píxeles
+    uint16_t height;          // Alto de la imagen en píxeles
+    uint16_t map_width;       // Ancho del mapa (ceil(width / 8))
+    uint16_t map_height;      // Alto del mapa (ceil(height / 8))
+    uint8_t components;       // Componentes de color (1 = gris, 3 = YCbCr)
+    uint8_t h_samp;           // Submuestreo horizontal de luminancia
+    uint8_t v_samp;           // Submuestreo vertical de luminancia
+    uint16_t restart_interval;// Intervalo de reinicio (0 = sin marcadores RST)
+} jpeg_dc_info_t;
+
+// Estadísticas de luminancia calculadas sobre el mapa
+typedef struct {
+    uint32_t histogram[256];  // Histograma de luminancia por bloque 8x8
+    uint32_t count;           // Número de bloques
+    float mean;               // Luminancia media (0-255)
+} jpeg_luma_stats_t;
+
+// Detalle dentro de los bloques 8x8 de luminancia, a partir de sus coeficientes AC
+typedef struct {
+    uint64_t sum;             // Suma de la varianza interna de cada bloque (píxeles², descuantizada)
+    uint32_t blocks;          // Bloques sumados
+} jpeg_ac_energy_t;
+
+/**
+ * @brief Lee las dimensiones y el submuestreo sin decodificar datos
+ * @param jpeg Datos JPEG
+ * @param len Tamaño de los datos
+ * @param info Estructura donde almacenar la información
+ * @return ESP_OK si exitoso, ESP_ERR_NOT_SUPPORTED si no es JPEG baseline
+ */
+esp_err_t jpeg_dc_get_info(const uint8_t *jpeg, size_t len, jpeg_dc_info_t *info);
+
+/**
+ * @brief Genera el mapa de luminancia exacto a escala 1/8 (media de cada bloque 8x8)
+ * @note Solo decodifica Huffman; no hay IDCT ni decodificación de color
+ * @param jpeg Datos JPEG baseline
+ * @param len Tamaño de los datos
+ * @param map Buffer de salida (map_width * map_height bytes, fila a fila)
+ * @param map_capacity Capacidad del buffer de salida
+ * @param info Información de la imagen (puede ser NULL)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_SIZE si el buffer es pequeño,
+ *         ESP_ERR_NOT_SUPPORTED si el JPEG no es baseline, ESP_FAIL si está corrupto
+ */
+esp_err_t jpeg_dc_luma_map(const uint8_t *jpeg, size_t len, uint8_t *map, size_t map_capacity,
+                           jpeg_dc_info_t *info);
+
+/**
+ * @brief Como jpeg_dc_luma_map() y además acumula la energía AC de cada bloque de luminancia
+ * @note Los AC que el mapa DC salta se descuantizan con su tabla: la varianza interna de un
+ *       bloque es la suma de sus AC al cuadrado / 64, así que detecta desenfoques menores que
+ *       el bloque, invisibles en el mapa 1/8. Algo más lento que jpeg_dc_luma_map()
+ * @param jpeg Datos JPEG baseline
+ * @param len Tamaño de los datos
+ * @param map Buffer de salida (map_width * map_height bytes, fila a fila)
+ * @param map_capacity Capacidad del buffer de salida
+ * @param info Información de la imagen (puede ser NULL)
+ * @param ac Estructura donde almacenar la energía AC
+ * @return Los mismos códigos que jpeg_dc_luma_map()
+ */
+esp_err_t jpeg_dc_luma_map_ac(const uint8_t *jpeg, size_t len, uint8_t *map, size_t map_capacity,
+                              jpeg_dc_info_t *info, jpeg_ac_energy_t *ac);
+
+/**
+ * @brief Calcula histograma y media de un mapa de luminancia
+ * @param map Mapa de luminancia
+ * @param count Número de elementos del mapa
+ * @param stats Estructura donde almacenar las estadísticas
+ */
+void jpeg_luma_stats_compute(const uint8_t *map, size_t count, jpeg_luma_stats_t *stats);
+
+/**
+ * @brief Obtiene un percentil de luminancia a partir del histograma
+ * @param stats Estadísticas calculadas con jpeg_luma_stats_compute()
+ * @param percentile Percentil (0-100)
+ * @return Nivel de luminancia del percentil (0-255)
+ */
+uint8_t jpeg_luma_stats_percentile(const jpeg_luma_stats_t *stats, uint8_t percentile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JPEG_DC_H
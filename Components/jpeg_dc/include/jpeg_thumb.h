@@ -0,0 +1,36 @@
+// jpeg_thumb.h - Miniaturas JPEG a escala 1/8 en el dominio DCT
+#ifndef JPEG_THUMB_H
+#define JPEG_THUMB_H
+
+#include "jpeg_dc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JPEG_THUMB_DEFAULT_QUALITY  50   // Tablas de referencia: ~20x menos que un frame HD
+
+/**
+ * @brief Genera una miniatura JPEG baseline a escala 1/8 a partir de un JPEG
+ * @note Cada bloque 8x8 del original se convierte en un píxel de la miniatura usando
+ *       su coeficiente DC (media exacta del bloque), sin IDCT ni conversión de color.
+ *       Solo se vuelve a codificar la imagen reducida (ancho y alto = map_width x map_height),
+ *       conservando el submuestreo del original, con tablas Huffman óptimas (dos pasadas).
+ * @param jpeg Datos JPEG baseline
+ * @param len Tamaño de los datos
+ * @param quality Calidad de la miniatura (1-100, escala IJG)
+ * @param out Buffer de salida
+ * @param out_capacity Capacidad del buffer de salida
+ * @param out_len Tamaño de la miniatura generada
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_SIZE si la miniatura no cabe en el buffer,
+ *         ESP_ERR_NOT_SUPPORTED si el JPEG no es baseline o su submuestreo no es
+ *         4:4:4, 4:2:2 o 4:2:0, ESP_FAIL si está corrupto
+ */
+esp_err_t jpeg_thumb_encode(const uint8_t *jpeg, size_t len, uint8_t quality,
+                            uint8_t *out, size_t out_capacity, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JPEG_THUMB_H
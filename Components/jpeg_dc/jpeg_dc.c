@@ -0,0 +1,780 @@
+// jpeg_dc.c - Responsabilidad única: decodificación parcial JPEG (coeficientes DC)
+//
+// Cada bloque 8x8 se reduce a su coeficiente DC: media = 128 + DC * Q[0] / 8.
+// Los coeficientes AC se recorren en el flujo Huffman para saltarlos, pero no
+// se transforman, por lo que no hay IDCT ni conversión de color. Si el plano lo
+// pide se descuantizan solo para sumar su energía (varianza interna del bloque).
+#include "jpeg_dc.h"
+#include "jpeg_dc_private.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define FAST_BITS       9
+#define MARKER_NONE     0xFF
+
+#define M_SOI   0xD8
+#define M_EOI   0xD9
+#define M_SOF0  0xC0
+#define M_SOF1  0xC1
+#define M_SOF2  0xC2
+#define M_DHT   0xC4
+#define M_SOS   0xDA
+#define M_DQT   0xDB
+#define M_DRI   0xDD
+#define M_RST0  0xD0
+#define M_RST7  0xD7
+
+typedef struct {
+    uint8_t fast_len[1 << FAST_BITS];   // 0 = código más largo que FAST_BITS
+    uint8_t fast_sym[1 << FAST_BITS];
+    uint8_t values[256];
+    uint32_t maxcode[18];
+    int delta[17];
+    bool present;
+} huff_table_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t h;
+    uint8_t v;
+    uint8_t tq;
+    uint8_t td;
+    uint8_t ta;
+    int pred;
+    uint16_t blocks_w;        // Bloques con datos de imagen
+    uint16_t blocks_h;
+} jpeg_comp_t;
+
+struct jpeg_dc_ctx {
+    const uint8_t *data;
+    const uint8_t *end;
+    const uint8_t *ptr;
+
+    uint32_t code_buffer;
+    int code_bits;
+    uint8_t marker;
+    bool nomore;
+
+    huff_table_t dc_tables[4];
+    huff_table_t ac_tables[4];
+    uint16_t qt[4][64];       // Tablas de cuantización en orden zigzag
+
+    jpeg_comp_t comps[4];
+    int comp_count;
+    int hmax;
+    int vmax;
+    int mcus_x;
+    int mcus_y;
+    uint16_t width;
+    uint16_t height;
+    uint16_t restart_interval;
+    bool frame_seen;
+};
+
+static const uint32_t bmask[17] = {
+    0, 1, 3, 7, 15, 31, 63, 127, 255, 511, 1023, 2047, 4095, 8191, 16383, 32767, 65535
+};
+
+static inline int read_u8(jpeg_dc_ctx_t *ctx) {
+    if (ctx->ptr >= ctx->end) {
+        return -1;
+    }
+    return *ctx->ptr++;
+}
+
+static inline int read_u16(jpeg_dc_ctx_t *ctx) {
+    if (ctx->end - ctx->ptr < 2) {
+        return -1;
+    }
+    int v = (ctx->ptr[0] << 8) | ctx->ptr[1];
+    ctx->ptr += 2;
+    return v;
+}
+
+static bool build_huffman(huff_table_t *h, const uint8_t *counts) {
+    uint8_t size[257];
+    uint16_t code[256];
+    int k = 0;
+
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < counts[i]; j++) {
+            if (k >= 256) {
+                return false;
+            }
+            size[k++] = (uint8_t)(i + 1);
+        }
+    }
+    size[k] = 0;
+
+    // Códigos canónicos y límites por longitud
+    uint32_t c = 0;
+    k = 0;
+    for (int j = 1; j <= 16; j++) {
+        h->delta[j] = k - (int)c;
+        if (size[k] == j) {
+            while (size[k] == j) {
+                code[k++] = (uint16_t)c++;
+            }
+            if (c - 1 >= (1u << j)) {
+                return false;
+            }
+        }
+        h->maxcode[j] = c << (16 - j);
+        c <<= 1;
+    }
+    h->maxcode[17] = 0xFFFFFFFF;
+
+    // Tabla rápida para códigos cortos
+    memset(h->fast_len, 0, sizeof(h->fast_len));
+    for (int i = 0; i < k; i++) {
+        int s = size[i];
+        if (s <= FAST_BITS) {
+            int base = code[i] << (FAST_BITS - s);
+            int n = 1 << (FAST_BITS - s);
+            for (int j = 0; j < n; j++) {
+                h->fast_len[base + j] = (uint8_t)s;
+                h->fast_sym[base + j] = h->values[i];
+            }
+        }
+    }
+
+    h->present = true;
+    return true;
+}
+
+// Rellena el buffer de bits; tras un marcador se rellena con ceros
+static void grow_buffer(jpeg_dc_ctx_t *ctx) {
+    while (ctx->code_bits <= 24) {
+        int b = 0;
+        if (!ctx->nomore) {
+            b = read_u8(ctx);
+            if (b < 0) {
+                ctx->nomore = true;
+                b = 0;
+            } else if (b == 0xFF) {
+                int c = read_u8(ctx);
+                while (c == 0xFF) {
+                    c = read_u8(ctx);
+                }
+                if (c != 0) {
+                    ctx->marker = (c < 0) ? M_EOI : (uint8_t)c;
+                    ctx->nomore = true;
+                    b = 0;
+                }
+            }
+        }
+        ctx->code_buffer |= (uint32_t)b << (24 - ctx->code_bits);
+        ctx->code_bits += 8;
+    }
+}
+
+static inline int huff_decode(jpeg_dc_ctx_t *ctx, const huff_table_t *h) {
+    if (ctx->code_bits < 16) {
+        grow_buffer(ctx);
+    }
+
+    uint32_t c = ctx->code_buffer >> (32 - FAST_BITS);
+    int len = h->fast_len[c];
+    if (len) {
+        ctx->code_buffer <<= len;
+        ctx->code_bits -= len;
+        return h->fast_sym[c];
+    }
+
+    uint32_t temp = ctx->code_buffer >> 16;
+    int k;
+    for (k = FAST_BITS + 1; ; k++) {
+        if (temp < h->maxcode[k]) {
+            break;
+        }
+    }
+    if (k == 17) {
+        return -1;
+    }
+
+    int idx = (int)((ctx->code_buffer >> (32 - k)) & bmask[k]) + h->delta[k];
+    if (idx < 0 || idx > 255) {
+        return -1;
+    }
+    ctx->code_buffer <<= k;
+    ctx->code_bits -= k;
+    return h->values[idx];
+}
+
+static inline int receive_extend(jpeg_dc_ctx_t *ctx, int n) {
+    if (n == 0) {
+        return 0;
+    }
+    if (ctx->code_bits < n) {
+        grow_buffer(ctx);
+    }
+    int v = (int)(ctx->code_buffer >> (32 - n));
+    ctx->code_buffer <<= n;
+    ctx->code_bits -= n;
+    if (v < (1 << (n - 1))) {
+        v += (int)(~0u << n) + 1;
+    }
+    return v;
+}
+
+static inline void skip_bits(jpeg_dc_ctx_t *ctx, int n) {
+    if (ctx->code_bits < n) {
+        grow_buffer(ctx);
+    }
+    ctx->code_buffer <<= n;
+    ctx->code_bits -= n;
+}
+
+static void reset_entropy(jpeg_dc_ctx_t *ctx) {
+    ctx->code_buffer = 0;
+    ctx->code_bits = 0;
+    ctx->nomore = false;
+    ctx->marker = MARKER_NONE;
+    for (int i = 0; i < ctx->comp_count; i++) {
+        ctx->comps[i].pred = 0;
+    }
+}
+
+// Avanza hasta el siguiente marcador RST tras un intervalo de reinicio
+static bool consume_restart(jpeg_dc_ctx_t *ctx) {
+    if (ctx->marker == MARKER_NONE) {
+        while (ctx->ptr < ctx->end) {
+            if (ctx->ptr[0] == 0xFF && ctx->ptr + 1 < ctx->end &&
+                ctx->ptr[1] != 0x00 && ctx->ptr[1] != 0xFF) {
+                ctx->marker = ctx->ptr[1];
+                ctx->ptr += 2;
+                break;
+            }
+            ctx->ptr++;
+        }
+    }
+    if (ctx->marker < M_RST0 || ctx->marker > M_RST7) {
+        return false;
+    }
+    reset_entropy(ctx);
+    return true;
+}
+
+// Decodifica un bloque: devuelve el DC acumulado y salta los AC. Con ac_sq != NULL
+// suma además el cuadrado de cada AC descuantizado (Parseval: 64 * varianza del bloque)
+static inline bool decode_block(jpeg_dc_ctx_t *ctx, jpeg_comp_t *comp, int *dc, uint64_t *ac_sq) {
+    const huff_table_t *hdc = &ctx->dc_tables[comp->td];
+    const huff_table_t *hac = &ctx->ac_tables[comp->ta];
+
+    int t = huff_decode(ctx, hdc);
+    if (t < 0 || t > 11) {
+        return false;
+    }
+    comp->pred += receive_extend(ctx, t);
+    *dc = comp->pred;
+
+    for (int k = 1; k < 64; ) {
+        int rs = huff_decode(ctx, hac);
+        if (rs < 0) {
+            return false;
+        }
+        int r = rs >> 4;
+        int s = rs & 15;
+        if (s == 0) {
+            if (r != 15) {
+                break;          // EOB
+            }
+            k += 16;            // ZRL
+        } else if (ac_sq == NULL) {
+            skip_bits(ctx, s);
+            k += r + 1;
+        } else {
+            k += r;
+            if (k > 63) {
+                return false;
+            }
+            int64_t coef = (int64_t)receive_extend(ctx, s) * ctx->qt[comp->tq][k];
+            *ac_sq += (uint64_t)(coef * coef);
+            k++;
+        }
+    }
+    return true;
+}
+
+static inline void store_dc(const jpeg_dc_ctx_t *ctx, const jpeg_comp_t *comp, const jpeg_dc_plane_t *plane,
+                            int bx, int by, int dc) {
+    if (plane == NULL || plane->data == NULL || bx >= plane->width || by >= plane->height) {
+        return;
+    }
+    // Media del bloque: DC descuantizado / 8 (redondeo como la IDCT 1x1) + nivel
+    int value = 128 + ((dc * ctx->qt[comp->tq][0] + 4) >> 3);
+    if (value < 0) {
+        value = 0;
+    } else if (value > 255) {
+        value = 255;
+    }
+    plane->data[by * plane->stride + bx] = (uint8_t)value;
+}
+
+// Suma la varianza interna de un bloque con datos de imagen
+static inline void store_ac(const jpeg_dc_plane_t *plane, int bx, int by, uint64_t ac_sq) {
+    if (plane == NULL || plane->ac == NULL || bx >= plane->width || by >= plane->height) {
+        return;
+    }
+    plane->ac->sum += ac_sq / 64;
+    plane->ac->blocks++;
+}
+
+static esp_err_t decode_scan(jpeg_dc_ctx_t *ctx, int *scan_comps, int ns, const jpeg_dc_plane_t *planes) {
+    reset_entropy(ctx);
+    int restarts_left = ctx->restart_interval;
+    int dc;
+    uint64_t ac_sq;
+
+    if (ns == 1) {
+        // Escaneo no intercalado: bloques del componente en orden raster
+        jpeg_comp_t *comp = &ctx->comps[scan_comps[0]];
+        const jpeg_dc_plane_t *plane = &planes[scan_comps[0]];
+        for (int by = 0; by < comp->blocks_h; by++) {
+            for (int bx = 0; bx < comp->blocks_w; bx++) {
+                ac_sq = 0;
+                if (!decode_block(ctx, comp, &dc, plane != NULL && plane->ac ? &ac_sq : NULL)) {
+                    return ESP_FAIL;
+                }
+                store_dc(ctx, comp, plane, bx, by, dc);
+                store_ac(plane, bx, by, ac_sq);
+                if (ctx->restart_interval && --restarts_left == 0) {
+                    if (!consume_restart(ctx) && (bx + 1 < comp->blocks_w || by + 1 < comp->blocks_h)) {
+                        return ESP_FAIL;
+                    }
+                    restarts_left = ctx->restart_interval;
+                }
+            }
+        }
+        return ESP_OK;
+    }
+
+    // Escaneo intercalado: MCUs con h x v bloques por componente
+    for (int my = 0; my < ctx->mcus_y; my++) {
+        for (int mx = 0; mx < ctx->mcus_x; mx++) {
+            for (int n = 0; n < ns; n++) {
+                jpeg_comp_t *comp = &ctx->comps[scan_comps[n]];
+                const jpeg_dc_plane_t *plane = &planes[scan_comps[n]];
+                for (int y = 0; y < comp->v; y++) {
+                    for (int x = 0; x < comp->h; x++) {
+                        ac_sq = 0;
+                        if (!decode_block(ctx, comp, &dc, plane != NULL && plane->ac ? &ac_sq : NULL)) {
+                            return ESP_FAIL;
+                        }
+                        store_dc(ctx, comp, plane, mx * comp->h + x, my * comp->v + y, dc);
+                        store_ac(plane, mx * comp->h + x, my * comp->v + y, ac_sq);
+                    }
+                }
+            }
+            if (ctx->restart_interval && --restarts_left == 0) {
+                if (!consume_restart(ctx) && (mx + 1 < ctx->mcus_x || my + 1 < ctx->mcus_y)) {
+                    return ESP_FAIL;
+                }
+                restarts_left = ctx->restart_interval;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_sof(jpeg_dc_ctx_t *ctx, int seg_len) {
+    if (seg_len < 8) {
+        return ESP_FAIL;
+    }
+    int precision = read_u8(ctx);
+    int height = read_u16(ctx);
+    int width = read_u16(ctx);
+    int nf = read_u8(ctx);
+    if (precision != 8) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (width <= 0 || height <= 0 || (nf != 1 && nf != 3) || seg_len != 8 + 3 * nf) {
+        return ESP_FAIL;
+    }
+
+    ctx->width = (uint16_t)width;
+    ctx->height = (uint16_t)height;
+    ctx->comp_count = nf;
+    ctx->hmax = 1;
+    ctx->vmax = 1;
+    for (int i = 0; i < nf; i++) {
+        jpeg_comp_t *comp = &ctx->comps[i];
+        comp->id = (uint8_t)read_u8(ctx);
+        int hv = read_u8(ctx);
+        comp->h = (uint8_t)(hv >> 4);
+        comp->v = (uint8_t)(hv & 15);
+        comp->tq = (uint8_t)read_u8(ctx);
+        if (comp->h < 1 || comp->h > 4 || comp->v < 1 || comp->v > 4 || comp->tq > 3) {
+            return ESP_FAIL;
+        }
+        if (comp->h > ctx->hmax) ctx->hmax = comp->h;
+        if (comp->v > ctx->vmax) ctx->vmax = comp->v;
+    }
+
+    ctx->mcus_x = (width + 8 * ctx->hmax - 1) / (8 * ctx->hmax);
+    ctx->mcus_y = (height + 8 * ctx->vmax - 1) / (8 * ctx->vmax);
+    if (nf == 1) {
+        // En escala de grises el MCU es un único bloque
+        ctx->comps[0].h = ctx->comps[0].v = 1;
+        ctx->hmax = ctx->vmax = 1;
+        ctx->mcus_x = (width + 7) / 8;
+        ctx->mcus_y = (height + 7) / 8;
+    }
+    for (int i = 0; i < nf; i++) {
+        jpeg_comp_t *comp = &ctx->comps[i];
+        int cw = (width * comp->h + ctx->hmax - 1) / ctx->hmax;
+        int ch = (height * comp->v + ctx->vmax - 1) / ctx->vmax;
+        comp->blocks_w = (uint16_t)((cw + 7) / 8);
+        comp->blocks_h = (uint16_t)((ch + 7) / 8);
+    }
+
+    ctx->frame_seen = true;
+    return ESP_OK;
+}
+
+static esp_err_t parse_dht(jpeg_dc_ctx_t *ctx, int seg_len) {
+    const uint8_t *seg_end = ctx->ptr + seg_len - 2;
+    while (ctx->ptr < seg_end) {
+        int tcth = read_u8(ctx);
+        int tc = tcth >> 4;
+        int th = tcth & 15;
+        if (tc > 1 || th > 3 || seg_end - ctx->ptr < 16) {
+            return ESP_FAIL;
+        }
+        uint8_t counts[16];
+        int total = 0;
+        for (int i = 0; i < 16; i++) {
+            counts[i] = ctx->ptr[i];
+            total += counts[i];
+        }
+        ctx->ptr += 16;
+        if (total > 256 || seg_end - ctx->ptr < total) {
+            return ESP_FAIL;
+        }
+        huff_table_t *h = tc == 0 ? &ctx->dc_tables[th] : &ctx->ac_tables[th];
+        memcpy(h->values, ctx->ptr, total);
+        ctx->ptr += total;
+        if (!build_huffman(h, counts)) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_dqt(jpeg_dc_ctx_t *ctx, int seg_len) {
+    const uint8_t *seg_end = ctx->ptr + seg_len - 2;
+    while (ctx->ptr < seg_end) {
+        int pqtq = read_u8(ctx);
+        int pq = pqtq >> 4;
+        int tq = pqtq & 15;
+        int entry = pq ? 2 : 1;
+        if (tq > 3 || seg_end - ctx->ptr < 64 * entry) {
+            return ESP_FAIL;
+        }
+        // El DC da el mapa; los AC solo se usan para la energía de detalle
+        for (int k = 0; k < 64; k++) {
+            ctx->qt[tq][k] = pq ? (uint16_t)((ctx->ptr[0] << 8) | ctx->ptr[1]) : ctx->ptr[0];
+            ctx->ptr += entry;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_sos(jpeg_dc_ctx_t *ctx, int seg_len, int *scan_comps, int *ns_out) {
+    int ns = read_u8(ctx);
+    if (!ctx->frame_seen || ns < 1 || ns > ctx->comp_count || seg_len != 6 + 2 * ns) {
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < ns; i++) {
+        int id = read_u8(ctx);
+        int tdta = read_u8(ctx);
+        int which = -1;
+        for (int c = 0; c < ctx->comp_count; c++) {
+            if (ctx->comps[c].id == id) {
+                which = c;
+                break;
+            }
+        }
+        if (which < 0) {
+            return ESP_FAIL;
+        }
+        jpeg_comp_t *comp = &ctx->comps[which];
+        comp->td = (uint8_t)(tdta >> 4);
+        comp->ta = (uint8_t)(tdta & 15);
+        if (comp->td > 3 || comp->ta > 3 ||
+            !ctx->dc_tables[comp->td].present || !ctx->ac_tables[comp->ta].present) {
+            return ESP_FAIL;
+        }
+        scan_comps[i] = which;
+    }
+    int ss = read_u8(ctx);
+    int se = read_u8(ctx);
+    int ahal = read_u8(ctx);
+    if (ss != 0 || se != 63 || ahal != 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    *ns_out = ns;
+    return ESP_OK;
+}
+
+// Busca el siguiente marcador tras los datos de entropía de un escaneo
+static int next_marker(jpeg_dc_ctx_t *ctx) {
+    if (ctx->marker != MARKER_NONE) {
+        int m = ctx->marker;
+        ctx->marker = MARKER_NONE;
+        return m;
+    }
+    while (ctx->ptr + 1 < ctx->end) {
+        if (ctx->ptr[0] == 0xFF && ctx->ptr[1] != 0x00 && ctx->ptr[1] != 0xFF &&
+            (ctx->ptr[1] < M_RST0 || ctx->ptr[1] > M_RST7)) {
+            int m = ctx->ptr[1];
+            ctx->ptr += 2;
+            return m;
+        }
+        ctx->ptr++;
+    }
+    return -1;
+}
+
+static esp_err_t run_decoder(jpeg_dc_ctx_t *ctx, const uint8_t *jpeg, size_t len,
+                             const jpeg_dc_plane_t *planes, bool headers_only) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->data = jpeg;
+    ctx->ptr = jpeg;
+    ctx->end = jpeg + len;
+    ctx->marker = MARKER_NONE;
+
+    if (read_u8(ctx) != 0xFF || read_u8(ctx) != M_SOI) {
+        return ESP_FAIL;
+    }
+
+    bool scanned = false;
+    int m = -1;
+    for (;;) {
+        // Leer siguiente marcador (saltando bytes de relleno 0xFF)
+        if (m < 0) {
+            int b = read_u8(ctx);
+            if (b != 0xFF) {
+                return scanned ? ESP_OK : ESP_FAIL;
+            }
+            do {
+                b = read_u8(ctx);
+            } while (b == 0xFF);
+            if (b < 0) {
+                return scanned ? ESP_OK : ESP_FAIL;
+            }
+            m = b;
+        }
+
+        if (m == M_EOI) {
+            return scanned ? ESP_OK : ESP_FAIL;
+        }
+
+        int seg_len = read_u16(ctx);
+        if (seg_len < 2 || ctx->end - ctx->ptr < seg_len - 2) {
+            return ESP_FAIL;
+        }
+        const uint8_t *seg_start = ctx->ptr;
+        esp_err_t err = ESP_OK;
+
+        switch (m) {
+            case M_SOF0:
+            case M_SOF1:
+                err = parse_sof(ctx, seg_len);
+                if (err == ESP_OK && headers_only) {
+                    return ESP_OK;
+                }
+                break;
+            case M_DHT:
+                err = parse_dht(ctx, seg_len);
+                break;
+            case M_DQT:
+                err = parse_dqt(ctx, seg_len);
+                break;
+            case M_DRI:
+                ctx->restart_interval = (uint16_t)read_u16(ctx);
+                break;
+            case M_SOS: {
+                int scan_comps[4];
+                int ns = 0;
+                err = parse_sos(ctx, seg_len, scan_comps, &ns);
+                if (err == ESP_OK) {
+                    err = decode_scan(ctx, scan_comps, ns, planes);
+                }
+                if (err != ESP_OK) {
+                    return err;
+                }
+                scanned = true;
+                m = next_marker(ctx);
+                continue;
+            }
+            default:
+                // SOF2+ (progresivo, aritmético, sin pérdida) no soportado
+                if (m >= 0xC2 && m <= 0xCF && m != M_DHT && m != 0xC8 && m != 0xCC) {
+                    return ESP_ERR_NOT_SUPPORTED;
+                }
+                break;
+        }
+
+        if (err != ESP_OK) {
+            return err;
+        }
+        ctx->ptr = seg_start + seg_len - 2;
+        m = -1;
+    }
+}
+
+static void fill_info(const jpeg_dc_ctx_t *ctx, jpeg_dc_info_t *info) {
+    if (info == NULL) {
+        return;
+    }
+    info->width = ctx->width;
+    info->height = ctx->height;
+    info->map_width = (uint16_t)((ctx->width + 7) / 8);
+    info->map_height = (uint16_t)((ctx->height + 7) / 8);
+    info->components = (uint8_t)ctx->comp_count;
+    info->h_samp = ctx->comps[0].h;
+    info->v_samp = ctx->comps[0].v;
+    info->restart_interval = ctx->restart_interval;
+}
+
+jpeg_dc_ctx_t* jpeg_dc_ctx_create(void) {
+    return malloc(sizeof(jpeg_dc_ctx_t));
+}
+
+void jpeg_dc_ctx_destroy(jpeg_dc_ctx_t *ctx) {
+    free(ctx);
+}
+
+esp_err_t jpeg_dc_decode_planes(jpeg_dc_ctx_t *ctx, const uint8_t *jpeg, size_t len,
+                                const jpeg_dc_plane_t planes[3], jpeg_dc_info_t *info) {
+    if (ctx == NULL || jpeg == NULL || planes == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    jpeg_dc_plane_t all[4] = { planes[0], planes[1], planes[2], { 0 } };
+    esp_err_t err = run_decoder(ctx, jpeg, len, all, false);
+    if (err == ESP_OK) {
+        fill_info(ctx, info);
+    }
+    return err;
+}
+
+esp_err_t jpeg_dc_read_headers(jpeg_dc_ctx_t *ctx, const uint8_t *jpeg, size_t len, jpeg_dc_info_t *info) {
+    if (ctx == NULL || jpeg == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = run_decoder(ctx, jpeg, len, NULL, true);
+    if (err == ESP_OK && !ctx->frame_seen) {
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        fill_info(ctx, info);
+    }
+    return err;
+}
+
+esp_err_t jpeg_dc_get_component(const jpeg_dc_ctx_t *ctx, int index, jpeg_dc_component_t *comp) {
+    if (ctx == NULL || comp == NULL || !ctx->frame_seen || index < 0 || index >= ctx->comp_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    comp->h = ctx->comps[index].h;
+    comp->v = ctx->comps[index].v;
+    comp->blocks_w = ctx->comps[index].blocks_w;
+    comp->blocks_h = ctx->comps[index].blocks_h;
+    return ESP_OK;
+}
+
+esp_err_t jpeg_dc_get_info(const uint8_t *jpeg, size_t len, jpeg_dc_info_t *info) {
+    if (jpeg == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_dc_ctx_t *ctx = jpeg_dc_ctx_create();
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = jpeg_dc_read_headers(ctx, jpeg, len, info);
+    jpeg_dc_ctx_destroy(ctx);
+    return err;
+}
+
+esp_err_t jpeg_dc_luma_map(const uint8_t *jpeg, size_t len, uint8_t *map, size_t map_capacity,
+                           jpeg_dc_info_t *info) {
+    return jpeg_dc_luma_map_ac(jpeg, len, map, map_capacity, info, NULL);
+}
+
+esp_err_t jpeg_dc_luma_map_ac(const uint8_t *jpeg, size_t len, uint8_t *map, size_t map_capacity,
+                              jpeg_dc_info_t *info, jpeg_ac_energy_t *ac) {
+    if (jpeg == NULL || map == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ac != NULL) {
+        memset(ac, 0, sizeof(*ac));
+    }
+
+    jpeg_dc_ctx_t *ctx = jpeg_dc_ctx_create();
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    jpeg_dc_info_t local;
+    esp_err_t err = jpeg_dc_read_headers(ctx, jpeg, len, &local);
+    if (err == ESP_OK && (size_t)local.map_width * local.map_height > map_capacity) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err == ESP_OK) {
+        jpeg_dc_plane_t planes[3] = {
+            { .data = map, .width = local.map_width, .height = local.map_height, .stride = local.map_width,
+              .ac = ac },
+            { 0 },
+            { 0 }
+        };
+        err = jpeg_dc_decode_planes(ctx, jpeg, len, planes, info);
+    }
+
+    jpeg_dc_ctx_destroy(ctx);
+    return err;
+}
+
+void jpeg_luma_stats_compute(const uint8_t *map, size_t count, jpeg_luma_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (map == NULL || count == 0) {
+        return;
+    }
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        stats->histogram[map[i]]++;
+        sum += map[i];
+    }
+    stats->count = (uint32_t)count;
+    stats->mean = (float)sum / (float)count;
+}
+
+uint8_t jpeg_luma_stats_percentile(const jpeg_luma_stats_t *stats, uint8_t percentile) {
+    if (stats == NULL || stats->count == 0) {
+        return 0;
+    }
+    if (percentile > 100) {
+        percentile = 100;
+    }
+
+    // Primer nivel cuyo acumulado alcanza el percentil pedido
+    uint64_t target = ((uint64_t)stats->count * percentile + 99) / 100;
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t acc = 0;
+    for (int level = 0; level < 256; level++) {
+        acc += stats->histogram[level];
+        if (acc >= target) {
+            return (uint8_t)level;
+        }
+    }
+    return 255;
+}
@@ -0,0 +1,69 @@
+// jpeg_dc_private.h - Interfaz interna del decodificador DC (uso dentro del componente)
+#ifndef JPEG_DC_PRIVATE_H
+#define JPEG_DC_PRIVATE_H
+
+#include "jpeg_dc.h"
+
+typedef struct jpeg_dc_ctx jpeg_dc_ctx_t;
+
+// Plano de salida con la media de cada bloque 8x8 de un componente
+typedef struct {
+    uint8_t *data;            // NULL = no almacenar este componente
+    uint16_t width;           // Bloques por fila
+    uint16_t height;          // Filas de bloques
+    size_t stride;            // Bytes por fila del buffer
+    jpeg_ac_energy_t *ac;     // NULL = los AC se saltan sin descuantizar
+} jpeg_dc_plane_t;
+
+// Geometría de un componente según el SOF
+typedef struct {
+    uint8_t h;                // Factor de muestreo horizontal
+    uint8_t v;                // Factor de muestreo vertical
+    uint16_t blocks_w;        // Bloques con datos de imagen por fila
+    uint16_t blocks_h;        // Filas de bloques con datos de imagen
+} jpeg_dc_component_t;
+
+/**
+ * @brief Reserva un contexto de decodificación (tablas Huffman, ~11 KB)
+ * @return Contexto o NULL si no hay memoria
+ */
+jpeg_dc_ctx_t* jpeg_dc_ctx_create(void);
+
+/**
+ * @brief Libera un contexto de decodificación
+ * @param ctx Contexto (NULL se ignora)
+ */
+void jpeg_dc_ctx_destroy(jpeg_dc_ctx_t *ctx);
+
+/**
+ * @brief Lee las cabeceras hasta el SOF sin decodificar datos
+ * @param ctx Contexto de decodificación
+ * @param jpeg Datos JPEG
+ * @param len Tamaño de los datos
+ * @param info Información de la imagen (puede ser NULL)
+ * @return ESP_OK si exitoso, ESP_ERR_NOT_SUPPORTED si no es JPEG baseline
+ */
+esp_err_t jpeg_dc_read_headers(jpeg_dc_ctx_t *ctx, const uint8_t *jpeg, size_t len, jpeg_dc_info_t *info);
+
+/**
+ * @brief Obtiene la geometría de un componente tras jpeg_dc_read_headers()
+ * @param ctx Contexto con las cabeceras leídas
+ * @param index Índice del componente (orden del SOF)
+ * @param comp Estructura donde almacenar la geometría
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si el componente no existe
+ */
+esp_err_t jpeg_dc_get_component(const jpeg_dc_ctx_t *ctx, int index, jpeg_dc_component_t *comp);
+
+/**
+ * @brief Decodifica los DC de cada componente (Y, Cb, Cr) en sus planos
+ * @param ctx Contexto de decodificación
+ * @param jpeg Datos JPEG baseline
+ * @param len Tamaño de los datos
+ * @param planes Planos de salida por componente (en orden del SOF)
+ * @param info Información de la imagen (puede ser NULL)
+ * @return ESP_OK si exitoso, código de error en caso contrario
+ */
+esp_err_t jpeg_dc_decode_planes(jpeg_dc_ctx_t *ctx, const uint8_t *jpeg, size_t len,
+                                const jpeg_dc_plane_t planes[3], jpeg_dc_info_t *info);
+
+#endif // JPEG_DC_PRIVATE_H
@@ -0,0 +1,562 @@
+// jpeg_thumb.c - Responsabilidad única: miniaturas JPEG a partir de los DC del original
+//
+// Escalar 1/8 en el dominio DCT equivale a quedarse con el coeficiente DC de cada
+// bloque: el decodificador DC entrega esos planos (Y, Cb, Cr) ya reducidos y aquí
+// solo se codifica la imagen pequeña con un codificador baseline mínimo
+// (DCT flotante AAN). En una miniatura de 160x90 las cuatro tablas Huffman estándar
+// del Anexo K ocupan casi tanto como los datos: se codifica en dos pasadas, la primera
+// solo cuenta símbolos y las tablas óptimas (Anexo K.2) se escriben con los que se usan.
+#include "jpeg_thumb.h"
+#include "jpeg_dc_private.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define THUMB_MAX_COMPONENTS    3
+
+// Orden zigzag -> posición natural en el bloque
+static const uint8_t zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Tablas de cuantización de referencia (orden natural)
+static const uint8_t std_luma_quant[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+static const uint8_t std_chroma_quant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// Factores de escala de la DCT AAN: cos(k*pi/16) * sqrt(2), con 1 para k = 0
+static const float aan_scale[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+typedef struct {
+    uint16_t code[256];
+    uint8_t size[256];
+} huff_code_t;
+
+// Tabla Huffman generada a partir de las frecuencias de la primera pasada
+typedef struct {
+    uint32_t freq[257];       // El símbolo 256 reserva el código de solo unos
+    uint8_t bits[16];         // Códigos por longitud (1-16)
+    uint8_t values[256];
+} huff_spec_t;
+
+// Índices de las tablas: DC y AC de luminancia, DC y AC de crominancia
+#define HUFF_DC(table)  ((table) * 2)
+#define HUFF_AC(table)  ((table) * 2 + 1)
+#define HUFF_TABLES     4
+
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t pos;
+    uint32_t acc;
+    int bits;
+    bool overflow;
+} bit_writer_t;
+
+typedef struct {
+    jpeg_dc_plane_t plane;    // Medias de bloque del original = píxeles de la miniatura
+    uint8_t h;
+    uint8_t v;
+    uint8_t table;            // 0 = luminancia, 1 = crominancia
+    int pred;
+} thumb_comp_t;
+
+// Estado de trabajo en el heap (la tarea de captura tiene poca pila)
+typedef struct {
+    huff_code_t codes[HUFF_TABLES];
+    huff_spec_t specs[HUFF_TABLES];
+    bool counting;            // Primera pasada: solo se cuentan los símbolos
+    uint8_t quant[2][64];     // Orden natural
+    float divisors[2][64];    // 1 / (Q * escala AAN), orden natural
+    thumb_comp_t comps[THUMB_MAX_COMPONENTS];
+    int comp_count;
+    uint8_t *plane_buf;
+} thumb_work_t;
+
+static void build_codes(huff_code_t *table, const uint8_t *bits, const uint8_t *values) {
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < bits[len - 1]; i++) {
+            table->code[values[k]] = code++;
+            table->size[values[k]] = (uint8_t)len;
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+// Longitudes de código óptimas limitadas a 16 bits (Anexo K.2, como jpeg_gen_optimal_table)
+static void build_spec(huff_spec_t *spec) {
+    int codesize[257] = { 0 };
+    int others[257];
+    uint8_t bits[33] = { 0 };
+
+    for (int i = 0; i < 257; i++) {
+        others[i] = -1;
+    }
+    spec->freq[256] = 1;
+
+    for (;;) {
+        // Las dos frecuencias menores (en empate, el símbolo mayor)
+        int c1 = -1;
+        int c2 = -1;
+        uint32_t v = UINT32_MAX;
+        for (int i = 0; i <= 256; i++) {
+            if (spec->freq[i] && spec->freq[i] <= v) {
+                v = spec->freq[i];
+                c1 = i;
+            }
+        }
+        v = UINT32_MAX;
+        for (int i = 0; i <= 256; i++) {
+            if (spec->freq[i] && spec->freq[i] <= v && i != c1) {
+                v = spec->freq[i];
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+
+        spec->freq[c1] += spec->freq[c2];
+        spec->freq[c2] = 0;
+        codesize[c1]++;
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            codesize[c1]++;
+        }
+        others[c1] = c2;
+        codesize[c2]++;
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            codesize[c2]++;
+        }
+    }
+
+    for (int i = 0; i <= 256; i++) {
+        if (codesize[i]) {
+            bits[codesize[i]]++;
+        }
+    }
+    // Los códigos de más de 16 bits se reparten entre ramas más cortas
+    for (int i = 32; i > 16; i--) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) {
+                j--;
+            }
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+    // Se retira el código reservado (el más largo)
+    int longest = 16;
+    while (bits[longest] == 0) {
+        longest--;
+    }
+    bits[longest]--;
+
+    memcpy(spec->bits, &bits[1], 16);
+    int k = 0;
+    for (int len = 1; len <= 32; len++) {
+        for (int i = 0; i < 256; i++) {
+            if (codesize[i] == len) {
+                spec->values[k++] = (uint8_t)i;
+            }
+        }
+    }
+}
+
+static void build_quant(thumb_work_t *work, uint8_t quality) {
+    if (quality < 1) {
+        quality = 1;
+    } else if (quality > 100) {
+        quality = 100;
+    }
+    // Escala IJG: 50 = tablas de referencia
+    int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+
+    for (int t = 0; t < 2; t++) {
+        const uint8_t *base = t == 0 ? std_luma_quant : std_chroma_quant;
+        for (int i = 0; i < 64; i++) {
+            int q = (base[i] * scale + 50) / 100;
+            if (q < 1) {
+                q = 1;
+            } else if (q > 255) {
+                q = 255;
+            }
+            work->quant[t][i] = (uint8_t)q;
+            work->divisors[t][i] = 1.0f / (q * aan_scale[i >> 3] * aan_scale[i & 7] * 8.0f);
+        }
+    }
+}
+
+static inline void put_byte(bit_writer_t *w, uint8_t b) {
+    if (w->pos < w->capacity) {
+        w->buf[w->pos++] = b;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_u16(bit_writer_t *w, uint16_t value) {
+    put_byte(w, (uint8_t)(value >> 8));
+    put_byte(w, (uint8_t)value);
+}
+
+static inline void put_bits(bit_writer_t *w, uint32_t code, int size) {
+    if (size == 0) {
+        return;
+    }
+    w->acc = (w->acc << size) | (code & ((1u << size) - 1));
+    w->bits += size;
+    while (w->bits >= 8) {
+        uint8_t b = (uint8_t)(w->acc >> (w->bits - 8));
+        put_byte(w, b);
+        if (b == 0xFF) {
+            put_byte(w, 0x00);    // Byte stuffing
+        }
+        w->bits -= 8;
+    }
+}
+
+static void flush_bits(bit_writer_t *w) {
+    if (w->bits > 0) {
+        put_bits(w, 0x7F, 8 - w->bits);   // Relleno con unos
+    }
+}
+
+// DCT directa 8x8 (AAN flotante); la salida queda escalada por aan_scale[u] * aan_scale[v] * 8
+static void fdct_float(float *d) {
+    for (int pass = 0; pass < 2; pass++) {
+        int step = pass == 0 ? 1 : 8;     // Filas y luego columnas
+        int next = pass == 0 ? 8 : 1;
+        for (int i = 0; i < 8; i++) {
+            float *p = d + i * next;
+            float tmp0 = p[0 * step] + p[7 * step];
+            float tmp7 = p[0 * step] - p[7 * step];
+            float tmp1 = p[1 * step] + p[6 * step];
+            float tmp6 = p[1 * step] - p[6 * step];
+            float tmp2 = p[2 * step] + p[5 * step];
+            float tmp5 = p[2 * step] - p[5 * step];
+            float tmp3 = p[3 * step] + p[4 * step];
+            float tmp4 = p[3 * step] - p[4 * step];
+
+            float tmp10 = tmp0 + tmp3;
+            float tmp13 = tmp0 - tmp3;
+            float tmp11 = tmp1 + tmp2;
+            float tmp12 = tmp1 - tmp2;
+
+            p[0 * step] = tmp10 + tmp11;
+            p[4 * step] = tmp10 - tmp11;
+            float z1 = (tmp12 + tmp13) * 0.707106781f;
+            p[2 * step] = tmp13 + z1;
+            p[6 * step] = tmp13 - z1;
+
+            tmp10 = tmp4 + tmp5;
+            tmp11 = tmp5 + tmp6;
+            tmp12 = tmp6 + tmp7;
+            float z5 = (tmp10 - tmp12) * 0.382683433f;
+            float z2 = 0.541196100f * tmp10 + z5;
+            float z4 = 1.306562965f * tmp12 + z5;
+            float z3 = tmp11 * 0.707106781f;
+            float z11 = tmp7 + z3;
+            float z13 = tmp7 - z3;
+
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[1 * step] = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+// Escribe un símbolo o, en la primera pasada, solo lo cuenta
+static inline void put_symbol(thumb_work_t *work, bit_writer_t *w, int table, int symbol) {
+    if (work->counting) {
+        work->specs[table].freq[symbol]++;
+    } else {
+        put_bits(w, work->codes[table].code[symbol], work->codes[table].size[symbol]);
+    }
+}
+
+static inline void put_value(thumb_work_t *work, bit_writer_t *w, int table, int symbol_run, int value) {
+    int magnitude = value < 0 ? -value : value;
+    int size = 0;
+    while (magnitude) {
+        size++;
+        magnitude >>= 1;
+    }
+    put_symbol(work, w, table, (symbol_run << 4) | size);
+    if (work->counting) {
+        return;
+    }
+    // Los negativos se codifican en complemento a uno
+    put_bits(w, (uint32_t)(value < 0 ? value - 1 : value), size);
+}
+
+// Codifica el bloque 8x8 con esquina en (x0, y0) del plano, replicando bordes
+static void encode_block(thumb_work_t *work, bit_writer_t *w, thumb_comp_t *comp, int x0, int y0) {
+    const jpeg_dc_plane_t *plane = &comp->plane;
+    float block[64];
+    int coef[64];
+
+    for (int y = 0; y < 8; y++) {
+        int sy = y0 + y < plane->height ? y0 + y : plane->height - 1;
+        const uint8_t *row = plane->data + (size_t)sy * plane->stride;
+        for (int x = 0; x < 8; x++) {
+            int sx = x0 + x < plane->width ? x0 + x : plane->width - 1;
+            block[y * 8 + x] = (float)row[sx] - 128.0f;
+        }
+    }
+
+    fdct_float(block);
+
+    const float *divisors = work->divisors[comp->table];
+    for (int k = 0; k < 64; k++) {
+        float v = block[zigzag[k]] * divisors[zigzag[k]];
+        coef[k] = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+
+    int dc = HUFF_DC(comp->table);
+    int ac = HUFF_AC(comp->table);
+
+    int diff = coef[0] - comp->pred;
+    comp->pred = coef[0];
+    put_value(work, w, dc, 0, diff);
+
+    int run = 0;
+    for (int k = 1; k < 64; k++) {
+        if (coef[k] == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            put_symbol(work, w, ac, 0xF0);                  // ZRL
+            run -= 16;
+        }
+        put_value(work, w, ac, run, coef[k]);
+        run = 0;
+    }
+    if (run > 0) {
+        put_symbol(work, w, ac, 0x00);                      // EOB
+    }
+}
+
+static void write_dht(bit_writer_t *w, int class_id, const uint8_t *bits, const uint8_t *values) {
+    int count = 0;
+    for (int i = 0; i < 16; i++) {
+        count += bits[i];
+    }
+    put_u16(w, 0xFFC4);
+    put_u16(w, (uint16_t)(2 + 1 + 16 + count));
+    put_byte(w, (uint8_t)class_id);
+    for (int i = 0; i < 16; i++) {
+        put_byte(w, bits[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        put_byte(w, values[i]);
+    }
+}
+
+static void write_headers(const thumb_work_t *work, bit_writer_t *w, uint16_t width, uint16_t height) {
+    int tables = work->comp_count > 1 ? 2 : 1;
+
+    put_u16(w, 0xFFD8);                               // SOI
+
+    static const uint8_t jfif[] = { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+    put_u16(w, 0xFFE0);                               // APP0 (JFIF)
+    put_u16(w, (uint16_t)(2 + sizeof(jfif)));
+    for (size_t i = 0; i < sizeof(jfif); i++) {
+        put_byte(w, jfif[i]);
+    }
+
+    put_u16(w, 0xFFDB);                               // DQT
+    put_u16(w, (uint16_t)(2 + 65 * tables));
+    for (int t = 0; t < tables; t++) {
+        put_byte(w, (uint8_t)t);
+        for (int k = 0; k < 64; k++) {
+            put_byte(w, work->quant[t][zigzag[k]]);
+        }
+    }
+
+    put_u16(w, 0xFFC0);                               // SOF0
+    put_u16(w, (uint16_t)(8 + 3 * work->comp_count));
+    put_byte(w, 8);
+    put_u16(w, height);
+    put_u16(w, width);
+    put_byte(w, (uint8_t)work->comp_count);
+    for (int i = 0; i < work->comp_count; i++) {
+        put_byte(w, (uint8_t)(i + 1));
+        put_byte(w, (uint8_t)((work->comps[i].h << 4) | work->comps[i].v));
+        put_byte(w, work->comps[i].table);
+    }
+
+    for (int t = 0; t < tables; t++) {
+        write_dht(w, 0x00 | t, work->specs[HUFF_DC(t)].bits, work->specs[HUFF_DC(t)].values);
+        write_dht(w, 0x10 | t, work->specs[HUFF_AC(t)].bits, work->specs[HUFF_AC(t)].values);
+    }
+
+    put_u16(w, 0xFFDA);                               // SOS
+    put_u16(w, (uint16_t)(6 + 2 * work->comp_count));
+    put_byte(w, (uint8_t)work->comp_count);
+    for (int i = 0; i < work->comp_count; i++) {
+        put_byte(w, (uint8_t)(i + 1));
+        put_byte(w, (uint8_t)((work->comps[i].table << 4) | work->comps[i].table));
+    }
+    put_byte(w, 0);
+    put_byte(w, 63);
+    put_byte(w, 0);
+}
+
+// Lee las cabeceras, valida el submuestreo y decodifica los planos DC
+static esp_err_t decode_dc_planes(thumb_work_t *work, const uint8_t *jpeg, size_t len, jpeg_dc_info_t *info) {
+    jpeg_dc_ctx_t *ctx = jpeg_dc_ctx_create();
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = jpeg_dc_read_headers(ctx, jpeg, len, info);
+    jpeg_dc_component_t geometry[THUMB_MAX_COMPONENTS];
+    size_t total = 0;
+
+    if (err == ESP_OK) {
+        work->comp_count = info->components;
+        for (int i = 0; i < work->comp_count && err == ESP_OK; i++) {
+            err = jpeg_dc_get_component(ctx, i, &geometry[i]);
+            total += (size_t)geometry[i].blocks_w * geometry[i].blocks_h;
+        }
+    }
+    if (err == ESP_OK && work->comp_count == 3) {
+        // La miniatura hereda el submuestreo: el croma debe ser 1x1 y la luminancia hasta 2x2
+        if (geometry[0].h > 2 || geometry[0].v > 2 ||
+            geometry[1].h != 1 || geometry[1].v != 1 || geometry[2].h != 1 || geometry[2].v != 1) {
+            err = ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+    if (err == ESP_OK) {
+        work->plane_buf = malloc(total);
+        if (work->plane_buf == NULL) {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    if (err == ESP_OK) {
+        jpeg_dc_plane_t planes[THUMB_MAX_COMPONENTS] = { { 0 } };
+        uint8_t *next = work->plane_buf;
+        for (int i = 0; i < work->comp_count; i++) {
+            planes[i].data = next;
+            planes[i].width = geometry[i].blocks_w;
+            planes[i].height = geometry[i].blocks_h;
+            planes[i].stride = geometry[i].blocks_w;
+            next += (size_t)geometry[i].blocks_w * geometry[i].blocks_h;
+
+            work->comps[i].plane = planes[i];
+            work->comps[i].h = geometry[i].h;
+            work->comps[i].v = geometry[i].v;
+            work->comps[i].table = i == 0 ? 0 : 1;
+            work->comps[i].pred = 0;
+        }
+        err = jpeg_dc_decode_planes(ctx, jpeg, len, planes, NULL);
+    }
+
+    jpeg_dc_ctx_destroy(ctx);
+    return err;
+}
+
+// Codifica todos los MCUs (intercalados, con el mismo submuestreo que el original)
+static void encode_scan(thumb_work_t *work, bit_writer_t *w, const jpeg_dc_info_t *info) {
+    int hmax = work->comps[0].h;
+    int vmax = work->comps[0].v;
+    int mcus_x = (info->map_width + 8 * hmax - 1) / (8 * hmax);
+    int mcus_y = (info->map_height + 8 * vmax - 1) / (8 * vmax);
+
+    for (int i = 0; i < work->comp_count; i++) {
+        work->comps[i].pred = 0;
+    }
+    for (int my = 0; my < mcus_y && (w == NULL || !w->overflow); my++) {
+        for (int mx = 0; mx < mcus_x; mx++) {
+            for (int i = 0; i < work->comp_count; i++) {
+                thumb_comp_t *comp = &work->comps[i];
+                for (int y = 0; y < comp->v; y++) {
+                    for (int x = 0; x < comp->h; x++) {
+                        encode_block(work, w, comp, (mx * comp->h + x) * 8, (my * comp->v + y) * 8);
+                    }
+                }
+            }
+        }
+    }
+}
+
+esp_err_t jpeg_thumb_encode(const uint8_t *jpeg, size_t len, uint8_t quality,
+                            uint8_t *out, size_t out_capacity, size_t *out_len) {
+    if (jpeg == NULL || out == NULL || out_len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_len = 0;
+
+    thumb_work_t *work = calloc(1, sizeof(thumb_work_t));
+    if (work == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    jpeg_dc_info_t info;
+    esp_err_t err = decode_dc_planes(work, jpeg, len, &info);
+    if (err != ESP_OK) {
+        free(work->plane_buf);
+        free(work);
+        return err;
+    }
+
+    build_quant(work, quality);
+
+    // Primera pasada: frecuencias de símbolos para las tablas óptimas
+    work->counting = true;
+    encode_scan(work, NULL, &info);
+    work->counting = false;
+    for (int t = 0; t < HUFF_TABLES; t++) {
+        build_spec(&work->specs[t]);
+        build_codes(&work->codes[t], work->specs[t].bits, work->specs[t].values);
+    }
+
+    bit_writer_t writer = { .buf = out, .capacity = out_capacity };
+    write_headers(work, &writer, info.map_width, info.map_height);
+    encode_scan(work, &writer, &info);
+    flush_bits(&writer);
+    put_u16(&writer, 0xFFD9);                         // EOI
+
+    free(work->plane_buf);
+    free(work);
+
+    if (writer.overflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = writer.pos;
+    return ESP_OK;
+}
@@ -0,0 +1,148 @@
+// metrics.h - Registro de métricas (contadores, indicadores e histogramas) para /metrics
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_MAX             40      // Métricas registradas como máximo (todas las series)
+#define METRICS_HIST_BUCKETS    20      // 64 us, 128 us ... 16.8 s y +Inf
+#define METRICS_HIST_MIN_US     64      // Límite superior del primer cubo
+#define METRICS_EXPORT_CHUNK    1024    // Bloque de texto por llamada a metrics_write_fn_t
+#define METRICS_PROMETHEUS_CONTENT_TYPE "text/plain; version=0.0.4"
+
+// Tipo de métrica (TYPE de Prometheus)
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+} metric_type_t;
+
+// Descripción común: primer miembro de cada métrica
+typedef struct {
+    const char *name;             // Nombre Prometheus (las series de un nombre se exportan juntas)
+    const char *help;
+    const char *labels;           // Etiquetas fijas sin llaves (handler="photo") o NULL
+    metric_type_t type;
+} metric_desc_t;
+
+// Copia de cada núcleo: solo la escribe ese núcleo, con interrupciones enmascaradas.
+// seq impar = escritura en curso (el lector del otro núcleo reintenta)
+typedef struct {
+    volatile uint32_t seq;
+    uint64_t value;
+} metric_counter_slot_t;
+
+typedef struct {
+    metric_desc_t desc;
+    metric_counter_slot_t slots[portNUM_PROCESSORS];
+} metric_counter_t;
+
+// Indicador: un solo valor que se sobrescribe (lectura y escritura atómicas de 32 bits)
+typedef struct {
+    metric_desc_t desc;
+    volatile int32_t value;
+} metric_gauge_t;
+
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t buckets[METRICS_HIST_BUCKETS];   // Muestras en cada cubo (no acumuladas)
+} metric_histogram_slot_t;
+
+typedef struct {
+    metric_desc_t desc;
+    metric_histogram_slot_t slots[portNUM_PROCESSORS];
+} metric_histogram_t;
+
+// Definición estática en el módulo que mide (el almacenamiento es del módulo)
+#define METRIC_COUNTER_INIT(n, h, l)    { .desc = { .name = (n), .help = (h), .labels = (l), .type = METRIC_COUNTER } }
+#define METRIC_GAUGE_INIT(n, h, l)      { .desc = { .name = (n), .help = (h), .labels = (l), .type = METRIC_GAUGE } }
+#define METRIC_HISTOGRAM_INIT(n, h, l)  { .desc = { .name = (n), .help = (h), .labels = (l), .type = METRIC_HISTOGRAM } }
+
+// Totales de un histograma sumando todos los núcleos
+typedef struct {
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+} metric_histogram_snapshot_t;
+
+// Destino del texto exportado (p. ej. httpd_resp_send_chunk)
+typedef esp_err_t (*metrics_write_fn_t)(const char *text, size_t len, void *arg);
+
+/**
+ * @brief Añade una métrica al registro exportado por /metrics
+ * @note Registrar la misma métrica dos veces no tiene efecto
+ * @param desc Miembro desc de un metric_counter_t, metric_gauge_t o metric_histogram_t
+ *             con duración estática
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si falta el nombre,
+ *         ESP_ERR_NO_MEM si ya hay METRICS_MAX métricas
+ */
+esp_err_t metrics_register(metric_desc_t *desc);
+
+/**
+ * @brief Suma a un contador
+ * @note Sin bloqueos: solo toca la copia del núcleo actual (apta para ISR)
+ * @param counter Contador
+ * @param n Incremento
+ */
+void metrics_counter_add(metric_counter_t *counter, uint32_t n);
+
+/**
+ * @brief Fija el valor de un indicador
+ * @param gauge Indicador
+ * @param value Valor
+ */
+void metrics_gauge_set(metric_gauge_t *gauge, int32_t value);
+
+/**
+ * @brief Registra una muestra en un histograma de latencias
+ * @note Sin bloqueos: solo toca la copia del núcleo actual (apta para ISR)
+ * @param hist Histograma
+ * @param us Duración en microsegundos
+ */
+void metrics_histogram_observe(metric_histogram_t *hist, uint32_t us);
+
+/**
+ * @brief Límite superior de un cubo de histograma
+ * @param bucket Índice del cubo (0..METRICS_HIST_BUCKETS-1)
+ * @return Microsegundos, UINT32_MAX para el último cubo (+Inf)
+ */
+uint32_t metrics_histogram_bucket_le(int bucket);
+
+/**
+ * @brief Valor de un contador sumando todos los núcleos
+ * @param counter Contador
+ * @return Valor acumulado
+ */
+uint64_t metrics_counter_read(const metric_counter_t *counter);
+
+/**
+ * @brief Totales de un histograma sumando todos los núcleos
+ * @param hist Histograma
+ * @param snapshot Estructura donde almacenar los totales
+ */
+void metrics_histogram_read(const metric_histogram_t *hist, metric_histogram_snapshot_t *snapshot);
+
+/**
+ * @brief Exporta el registro en formato de texto de Prometheus (0.0.4)
+ * @note El texto se acumula en bloques de hasta METRICS_EXPORT_CHUNK bytes antes de
+ *       llamar a write (en la pila del llamador: nunca reserva memoria)
+ * @param write Destino del texto
+ * @param arg Argumento para write
+ * @return ESP_OK si exitoso, o el primer error devuelto por write
+ */
+esp_err_t metrics_export_prometheus(metrics_write_fn_t write, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
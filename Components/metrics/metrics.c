@@ -0,0 +1,259 @@
+// metrics.c - Responsabilidad única: acumular métricas sin bloqueos y exportarlas para Prometheus
+//
+// Cada métrica guarda una copia por núcleo. Quien registra una muestra solo escribe la
+// copia de su núcleo con las interrupciones enmascaradas: nadie más puede tocarla a la
+// vez y no hace falta ningún spinlock (unas decenas de ciclos por muestra). El lector
+// suma las copias; un contador de secuencia por copia le indica si la leyó a mitad de
+// una escritura del otro núcleo y debe repetir.
+#include "metrics.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static metric_desc_t *registry[METRICS_MAX];
+static size_t registry_count = 0;
+static portMUX_TYPE registry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Texto pendiente de enviar en bloques de METRICS_EXPORT_CHUNK
+typedef struct {
+    char buf[METRICS_EXPORT_CHUNK];
+    size_t len;
+    metrics_write_fn_t write;
+    void *arg;
+    esp_err_t err;
+} export_buffer_t;
+
+esp_err_t metrics_register(metric_desc_t *desc) {
+    if (desc == NULL || desc->name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&registry_lock);
+    bool present = false;
+    for (size_t i = 0; i < registry_count; i++) {
+        if (registry[i] == desc) {
+            present = true;
+            break;
+        }
+    }
+    if (!present) {
+        if (registry_count < METRICS_MAX) {
+            registry[registry_count++] = desc;
+        } else {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    portEXIT_CRITICAL(&registry_lock);
+    return ret;
+}
+
+void metrics_counter_add(metric_counter_t *counter, uint32_t n) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    metric_counter_slot_t *slot = &counter->slots[xPortGetCoreID()];
+
+    slot->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->value += n;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->seq++;
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+void metrics_gauge_set(metric_gauge_t *gauge, int32_t value) {
+    gauge->value = value;
+}
+
+// Cubo de una muestra: (64·2^(i-1), 64·2^i] con una sola instrucción de conteo de ceros
+static inline int bucket_of(uint32_t us) {
+    uint32_t scaled = (us - (us > 0)) / METRICS_HIST_MIN_US;
+    int bucket = scaled ? 32 - __builtin_clz(scaled) : 0;
+    return bucket < METRICS_HIST_BUCKETS ? bucket : METRICS_HIST_BUCKETS - 1;
+}
+
+void metrics_histogram_observe(metric_histogram_t *hist, uint32_t us) {
+    int bucket = bucket_of(us);
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    metric_histogram_slot_t *slot = &hist->slots[xPortGetCoreID()];
+
+    slot->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->buckets[bucket]++;
+    slot->count++;
+    slot->sum_us += us;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->seq++;
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+uint32_t metrics_histogram_bucket_le(int bucket) {
+    if (bucket >= METRICS_HIST_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)METRICS_HIST_MIN_US << bucket;
+}
+
+uint64_t metrics_counter_read(const metric_counter_t *counter) {
+    uint64_t total = 0;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const metric_counter_slot_t *slot = &counter->slots[core];
+        uint32_t seq;
+        uint64_t value;
+        do {
+            seq = slot->seq;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            value = slot->value;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while ((seq & 1) || seq != slot->seq);
+        total += value;
+    }
+    return total;
+}
+
+void metrics_histogram_read(const metric_histogram_t *hist, metric_histogram_snapshot_t *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const metric_histogram_slot_t *slot = &hist->slots[core];
+        metric_histogram_slot_t copy;
+        uint32_t seq;
+        do {
+            seq = slot->seq;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            memcpy(&copy, (const void *)slot, sizeof(copy));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while ((seq & 1) || seq != slot->seq);
+
+        snapshot->count += copy.count;
+        snapshot->sum_us += copy.sum_us;
+        for (int i = 0; i < METRICS_HIST_BUCKETS; i++) {
+            snapshot->buckets[i] += copy.buckets[i];
+        }
+    }
+}
+
+static void export_flush(export_buffer_t *out) {
+    if (out->len > 0 && out->err == ESP_OK) {
+        out->err = out->write(out->buf, out->len, out->arg);
+    }
+    out->len = 0;
+}
+
+static void export_line(export_buffer_t *out, const char *fmt, ...) {
+    char line[224];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    if (len >= (int)sizeof(line)) {
+        // Línea truncada: se cierra igualmente para no corromper la siguiente
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+
+    if (out->len + len > sizeof(out->buf)) {
+        export_flush(out);
+    }
+    memcpy(out->buf + out->len, line, len);
+    out->len += len;
+}
+
+// Series de una métrica: "{etiquetas}" o vacío
+static const char* label_block(const metric_desc_t *desc, char *buf, size_t size) {
+    if (desc->labels == NULL || desc->labels[0] == '\0') {
+        return "";
+    }
+    snprintf(buf, size, "{%s}", desc->labels);
+    return buf;
+}
+
+static void export_series(export_buffer_t *out, const metric_desc_t *desc) {
+    char labels[96];
+
+    switch (desc->type) {
+        case METRIC_COUNTER: {
+            const metric_counter_t *counter = (const metric_counter_t *)desc;
+            export_line(out, "%s%s %llu\n", desc->name, label_block(desc, labels, sizeof(labels)),
+                        (unsigned long long)metrics_counter_read(counter));
+            break;
+        }
+        case METRIC_GAUGE: {
+            const metric_gauge_t *gauge = (const metric_gauge_t *)desc;
+            export_line(out, "%s%s %ld\n", desc->name, label_block(desc, labels, sizeof(labels)),
+                        (long)gauge->value);
+            break;
+        }
+        case METRIC_HISTOGRAM: {
+            metric_histogram_snapshot_t snapshot;
+            metrics_histogram_read((const metric_histogram_t *)desc, &snapshot);
+            const char *series = label_block(desc, labels, sizeof(labels));
+            const char *extra = series[0] ? desc->labels : "";
+            const char *sep = series[0] ? "," : "";
+
+            // Los cubos de Prometheus son acumulados; el límite va en segundos
+            uint32_t cumulative = 0;
+            for (int i = 0; i < METRICS_HIST_BUCKETS; i++) {
+                cumulative += snapshot.buckets[i];
+                uint32_t le = metrics_histogram_bucket_le(i);
+                if (le == UINT32_MAX) {
+                    export_line(out, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", desc->name, extra, sep,
+                                (unsigned long)cumulative);
+                } else {
+                    export_line(out, "%s_bucket{%s%sle=\"%lu.%06lu\"} %lu\n", desc->name, extra, sep,
+                                (unsigned long)(le / 1000000), (unsigned long)(le % 1000000),
+                                (unsigned long)cumulative);
+                }
+            }
+            export_line(out, "%s_sum%s %llu.%06llu\n", desc->name, series,
+                        (unsigned long long)(snapshot.sum_us / 1000000),
+                        (unsigned long long)(snapshot.sum_us % 1000000));
+            export_line(out, "%s_count%s %lu\n", desc->name, series,
+                        (unsigned long)snapshot.count);
+            break;
+        }
+    }
+}
+
+esp_err_t metrics_export_prometheus(metrics_write_fn_t write, void *arg) {
+    static const char *type_names[] = { "counter", "gauge", "histogram" };
+    export_buffer_t out = { .len = 0, .write = write, .arg = arg, .err = ESP_OK };
+
+    // El registro solo crece: basta con leer cuántas hay
+    portENTER_CRITICAL(&registry_lock);
+    size_t count = registry_count;
+    portEXIT_CRITICAL(&registry_lock);
+
+    for (size_t i = 0; i < count && out.err == ESP_OK; i++) {
+        const metric_desc_t *desc = registry[i];
+
+        // Cada familia una sola vez, con todas sus series juntas
+        bool exported = false;
+        for (size_t j = 0; j < i; j++) {
+            if (strcmp(registry[j]->name, desc->name) == 0) {
+                exported = true;
+                break;
+            }
+        }
+        if (exported) {
+            continue;
+        }
+
+        export_line(&out, "# HELP %s %s\n", desc->name, desc->help ? desc->help : "");
+        export_line(&out, "# TYPE %s %s\n", desc->name, type_names[desc->type]);
+        for (size_t k = i; k < count; k++) {
+            if (strcmp(registry[k]->name, desc->name) == 0) {
+                export_series(&out, registry[k]);
+            }
+        }
+    }
+
+    export_flush(&out);
+    return out.err;
+}
@@ -0,0 +1,126 @@
+// e18_debounce.c - Responsabilidad única: convertir flancos con marca de tiempo en detecciones
+//
+// Antes la tarea dormía 50 ms tras cada flanco y 1 s más para confirmar, y leía el pin al
+// despertar: los flancos de ese segundo se quedaban en la cola y se procesaban después,
+// cuando ya no decían nada del pin. Aquí las ventanas se calculan con las marcas que toma
+// la ISR: un nivel es estable si nadie lo cambia en debounce_ms desde su flanco, y la
+// detección se confirma si el objeto sigue estable confirm_ms más. Sin relojes propios ni
+// esperas: quien lo usa avanza el tiempo y programa un timer para el próximo plazo.
+#include "e18_debounce.h"
+#include <string.h>
+
+static const char *event_names[] = { "ninguno", "objeto", "confirmada", "falsa alarma", "retirado" };
+
+esp_err_t e18_debounce_init(e18_debounce_t *state, const e18_debounce_config_t *config,
+                            uint8_t level, int64_t now) {
+    if (state == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->debounce_us = (int64_t)config->debounce_ms * 1000;
+    state->confirm_us = (int64_t)config->confirm_ms * 1000;
+    state->raw_level = level == E18_LEVEL_OBJECT ? E18_LEVEL_OBJECT : E18_LEVEL_CLEAR;
+    // El punto de partida es "sin objeto": un objeto ya presente cuenta como flanco en now
+    state->stable_level = E18_LEVEL_CLEAR;
+    state->raw_since = now;
+    state->now = now;
+    state->phase = E18_PHASE_CLEAR;
+    return ESP_OK;
+}
+
+// Instante en que raw_level pasa a estable (0 = ya lo es)
+static int64_t stable_deadline(const e18_debounce_t *state) {
+    return state->raw_level != state->stable_level ? state->raw_since + state->debounce_us : 0;
+}
+
+// Instante de la confirmación (0 = no hay ninguna en curso)
+static int64_t confirm_deadline(const e18_debounce_t *state) {
+    return state->phase == E18_PHASE_CONFIRMING ?
+           state->onset + state->debounce_us + state->confirm_us : 0;
+}
+
+e18_debounce_event_t e18_debounce_advance(e18_debounce_t *state, int64_t now, int64_t *at) {
+    int64_t stable_at = stable_deadline(state);
+    int64_t confirm_at = confirm_deadline(state);
+    e18_debounce_event_t event = E18_DEBOUNCE_NONE;
+    int64_t event_at = 0;
+
+    // El plazo más temprano primero; si coinciden, gana el cambio de nivel
+    if (stable_at != 0 && stable_at <= now && (confirm_at == 0 || stable_at <= confirm_at)) {
+        state->stable_level = state->raw_level;
+        event_at = stable_at;
+        if (state->stable_level == E18_LEVEL_OBJECT) {
+            state->phase = E18_PHASE_CONFIRMING;
+            state->onset = state->raw_since;
+            state->stats.onsets++;
+            event = E18_DEBOUNCE_ONSET;
+        } else if (state->phase == E18_PHASE_CONFIRMING) {
+            state->phase = E18_PHASE_CLEAR;
+            state->stats.false_alarms++;
+            event = E18_DEBOUNCE_FALSE_ALARM;
+        } else {
+            state->phase = E18_PHASE_CLEAR;
+            state->stats.released++;
+            event = E18_DEBOUNCE_RELEASED;
+        }
+    } else if (confirm_at != 0 && confirm_at <= now) {
+        state->phase = E18_PHASE_PRESENT;
+        state->stats.confirmed++;
+        event = E18_DEBOUNCE_CONFIRMED;
+        event_at = confirm_at;
+    }
+
+    if (event != E18_DEBOUNCE_NONE) {
+        state->now = event_at;
+        if (at != NULL) {
+            *at = event_at;
+        }
+    } else if (now > state->now) {
+        state->now = now;
+    }
+    return event;
+}
+
+void e18_debounce_edge(e18_debounce_t *state, const e18_edge_t *edge) {
+    int64_t timestamp = edge->timestamp;
+    uint8_t level = edge->level == E18_LEVEL_OBJECT ? E18_LEVEL_OBJECT : E18_LEVEL_CLEAR;
+
+    state->stats.edges++;
+    if (timestamp < state->now) {
+        state->stats.late_edges++;
+        timestamp = state->now;
+    }
+    state->now = timestamp;
+
+    // Dos flancos seguidos pueden leer el mismo nivel si el pin rebota dentro de la ISR
+    if (level == state->raw_level) {
+        return;
+    }
+    if (state->raw_level != state->stable_level) {
+        // Vuelve al nivel estable antes de debounce_ms: el cambio pendiente era un rebote
+        state->stats.glitches++;
+    }
+    state->raw_level = level;
+    state->raw_since = timestamp;
+}
+
+int64_t e18_debounce_next_deadline(const e18_debounce_t *state) {
+    int64_t stable_at = stable_deadline(state);
+    int64_t confirm_at = confirm_deadline(state);
+
+    if (stable_at == 0) {
+        return confirm_at;
+    }
+    if (confirm_at == 0) {
+        return stable_at;
+    }
+    return stable_at < confirm_at ? stable_at : confirm_at;
+}
+
+const char* e18_debounce_event_name(e18_debounce_event_t event) {
+    if (event > E18_DEBOUNCE_RELEASED) {
+        return "desconocido";
+    }
+    return event_names[event];
+}
@@ -0,0 +1,124 @@
+// e18_debounce.h - Antirrebote y confirmación del E18-D80NK a partir de flancos con marca de tiempo
+#ifndef E18_DEBOUNCE_H
+#define E18_DEBOUNCE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Nivel del pin (salida NPN con pull-up: 0 = objeto, 1 = sin objeto)
+#define E18_LEVEL_OBJECT    0
+#define E18_LEVEL_CLEAR     1
+
+// Flanco capturado en la ISR
+typedef struct {
+    int64_t timestamp;            // esp_timer_get_time() en el momento del flanco
+    uint8_t level;                // Nivel del pin tras el flanco
+} e18_edge_t;
+
+// Configuración de las ventanas
+typedef struct {
+    uint32_t debounce_ms;         // Tiempo que un nivel debe mantenerse para darlo por estable
+    uint32_t confirm_ms;          // Presencia estable necesaria para confirmar la detección
+} e18_debounce_config_t;
+
+// Los mismos tiempos que antes: 50 ms de antirrebote y 1 s de confirmación
+#define E18_DEBOUNCE_DEFAULT_CONFIG() { \
+    .debounce_ms = 50, \
+    .confirm_ms = 1000 \
+}
+
+// Fase del detector
+typedef enum {
+    E18_PHASE_CLEAR = 0,          // Sin objeto
+    E18_PHASE_CONFIRMING,         // Objeto estable, esperando confirm_ms
+    E18_PHASE_PRESENT             // Detección confirmada
+} e18_phase_t;
+
+// Resultado de avanzar el detector
+typedef enum {
+    E18_DEBOUNCE_NONE = 0,
+    E18_DEBOUNCE_ONSET,           // Objeto estable: empieza la confirmación
+    E18_DEBOUNCE_CONFIRMED,       // Objeto presente durante confirm_ms: detección
+    E18_DEBOUNCE_FALSE_ALARM,     // Se fue antes de confirmarse
+    E18_DEBOUNCE_RELEASED         // Fin de una detección confirmada
+} e18_debounce_event_t;
+
+// Estadísticas del detector
+typedef struct {
+    uint32_t edges;               // Flancos recibidos
+    uint32_t glitches;            // Cambios anulados antes de debounce_ms (rebotes)
+    uint32_t onsets;
+    uint32_t confirmed;
+    uint32_t false_alarms;
+    uint32_t released;
+    uint32_t late_edges;          // Flancos con marca anterior al último procesado
+} e18_debounce_stats_t;
+
+// Estado del detector (lo posee la tarea de detección; sin bloqueos internos)
+typedef struct {
+    int64_t debounce_us;
+    int64_t confirm_us;
+    uint8_t raw_level;            // Nivel tras el último flanco
+    uint8_t stable_level;         // Nivel tras el antirrebote
+    int64_t raw_since;            // Marca del último cambio de raw_level
+    int64_t onset;                // Flanco que inició la presencia en confirmación o confirmada
+    int64_t now;                  // Último instante procesado
+    e18_phase_t phase;
+    e18_debounce_stats_t stats;
+} e18_debounce_t;
+
+/**
+ * @brief Inicializa el detector con el nivel actual del pin
+ * @note Con el objeto ya delante al arrancar se comporta como un flanco en now
+ * @param state Estado
+ * @param config Configuración
+ * @param level Nivel actual del pin
+ * @param now Momento actual (microsegundos)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida
+ */
+esp_err_t e18_debounce_init(e18_debounce_t *state, const e18_debounce_config_t *config,
+                            uint8_t level, int64_t now);
+
+/**
+ * @brief Avanza el detector hasta now y devuelve el primer evento pendiente
+ * @note Llamar en bucle hasta E18_DEBOUNCE_NONE: cada llamada devuelve un solo evento,
+ *       en orden de tiempo. Antes de cada flanco hay que avanzar hasta su marca
+ * @param state Estado
+ * @param now Momento actual (microsegundos)
+ * @param at Donde almacenar el instante en que ocurrió el evento (puede ser NULL)
+ * @return Evento, o E18_DEBOUNCE_NONE si no hay nada hasta now
+ */
+e18_debounce_event_t e18_debounce_advance(e18_debounce_t *state, int64_t now, int64_t *at);
+
+/**
+ * @brief Registra un flanco; sus efectos aparecen en e18_debounce_advance()
+ * @note Un flanco con marca anterior al último instante procesado se toma en ese instante
+ * @param state Estado
+ * @param edge Flanco
+ */
+void e18_debounce_edge(e18_debounce_t *state, const e18_edge_t *edge);
+
+/**
+ * @brief Próximo instante en que el detector puede generar un evento sin flancos nuevos
+ * @param state Estado
+ * @return Instante en microsegundos, 0 si no hay nada pendiente
+ */
+int64_t e18_debounce_next_deadline(const e18_debounce_t *state);
+
+/**
+ * @brief Nombre legible de un evento
+ * @param event Evento
+ * @return Cadena estática
+ */
+const char* e18_debounce_event_name(e18_debounce_event_t event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // E18_DEBOUNCE_H
@@ -17,6 +17,8 @@ typedef struct {
     gpio_pullup_t pull_up_en;         // Pull-up habilitado
     gpio_pulldown_t pull_down_en;     // Pull-down deshabilitado
     gpio_int_type_t intr_type;        // Tipo de interrupción
+    uint32_t debounce_ms;             // Estabilidad mínima de un nivel (antirrebote)
+    uint32_t confirm_ms;              // Presencia estable antes de confirmar la detección
 } sensor_e18_config_t;
 
 // Estructura de estadísticas del sensor
@@ -24,6 +26,9 @@ typedef struct {
     uint32_t detection_count;         // Contador de detecciones
     bool object_detected;             // Estado actual (objeto detectado)
     int64_t last_detection_time;      // Tiempo de última detección (microsegundos)
+    uint32_t false_alarm_count;       // Objetos que se fueron antes de confirmarse
+    uint32_t glitch_count;            // Cambios del pin anulados por el antirrebote
+    uint32_t dropped_edges;           // Flancos perdidos con la cola de la ISR llena
 } sensor_statistics_t;
 
 // Configuración por defecto
@@ -31,7 +36,9 @@ typedef struct {
     .pin = GPIO_NUM_13, \
     .pull_up_en = GPIO_PULLUP_ENABLE, \
     .pull_down_en = GPIO_PULLDOWN_DISABLE, \
-    .intr_type = GPIO_INTR_ANYEDGE \
+    .intr_type = GPIO_INTR_ANYEDGE, \
+    .debounce_ms = 50, \
+    .confirm_ms = 1000 \
 }
 
 /**
@@ -92,6 +99,9 @@ typedef void (*motion_detected_callback_t)(void);
 
 /**
  * @brief Configurar callback para cuando se confirma detección
+ * @note Se llama desde una tarea propia, después de congelar el pre-disparo y pedir la
+ *       ráfaga; puede bloquear (envío HTTPS) sin retrasar la detección. Las detecciones
+ *       confirmadas mientras está en curso se avisan una sola vez al terminar
  * @param callback Función a llamar cuando se detecta movimiento confirmado
  * @return ESP_OK si exitoso
  */
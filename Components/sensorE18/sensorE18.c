@@ -2,15 +2,24 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "sensorE18.h"
+#include "e18_debounce.h"
 #include "cam_reader.h"
 #include <inttypes.h>
 #include "web_server.h"
+#include "metrics.h"
+#include "seqlock.h"
 
-#define DEBOUNCE_TIME_MS 50
+#define SENSOR_EVENT_QUEUE_LEN 32           // Flancos en espera (16 bytes cada uno)
+#define EDGE_TIMER_EXPIRED 0xFF             // Nivel ficticio: venció el plazo del antirrebote
 #define PERIODIC_PHOTO_INTERVAL_US 2000000  // 2 segundos en microsegundos
+#define DETECTION_PHOTO_DEADLINE_US 1000000  // Plazo para la foto de detección
+#define DETECTION_BURST_FRAMES 5             // Frames evaluados para elegir la foto más nítida
+#define NOTIFY_TASK_STACK 8192               // El callback envía el aviso por HTTPS
 
 static const char* TAG = "E18-D80NK";
 
@@ -18,47 +27,76 @@ static const char* TAG = "E18-D80NK";
 static QueueHandle_t sensor_event_queue = NULL;
 static QueueHandle_t server_queue = NULL;
 static sensor_e18_config_t current_config = SENSOR_E18_DEFAULT_CONFIG;
-static sensor_statistics_t sensor_stats = {0};
+static sensor_statistics_t sensor_stats = {0};   // Solo la escribe la tarea de detección
+static seqlock_t stats_lock = SEQLOCK_INIT();     // Lectores de otras tareas (timer, /status)
 static esp_timer_handle_t periodic_photo_timer = NULL;
+static esp_timer_handle_t debounce_timer = NULL;  // Próximo plazo del antirrebote
+static e18_debounce_t debounce;                    // Solo la usa la tarea de detección
+static volatile uint32_t isr_dropped_edges = 0;    // Flancos que no cupieron en la cola
 static int simulated_pin_state = 1; // Variable para simular estado del pin (1=sin objeto, 0=objeto)
 static motion_detected_callback_t motion_callback = NULL;
+static TaskHandle_t notify_task_handle = NULL;     // Ejecuta motion_callback fuera de la detección
+
+// Entrega de eventos al servidor web, para /metrics
+static metric_counter_t event_queue_dropped = METRIC_COUNTER_INIT(SERVER_EVENT_DROPPED_METRIC,
+    SERVER_EVENT_DROPPED_HELP, "source=\"sensor\"");
 
 // Prototipos de funciones privadas
-static esp_err_t send_server_event(server_event_type_t type, const char* reason);
+static esp_err_t send_server_event(server_event_type_t type);
 
 // Función de interrupción
 static void IRAM_ATTR gpio_isr_handler(void* arg) {
     uint32_t gpio_num = (uint32_t) arg;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     
-    // Contador de interrupciones (solo incrementar, no logs en ISR)
-    static uint32_t isr_count = 0;
-    isr_count++;
+    // Marca y nivel en el momento del flanco: la tarea puede atenderlo más tarde
+    e18_edge_t edge = {
+        .timestamp = esp_timer_get_time(),
+        .level = (uint8_t)gpio_ll_get_level(&GPIO, gpio_num)
+    };
     
-    xQueueSendFromISR(sensor_event_queue, &gpio_num, &xHigherPriorityTaskWoken);
+    if (xQueueSendFromISR(sensor_event_queue, &edge, &xHigherPriorityTaskWoken) != pdTRUE) {
+        isr_dropped_edges++;
+    }
     
     if (xHigherPriorityTaskWoken) {
         portYIELD_FROM_ISR();
     }
 }
 
+// Callback del timer del antirrebote: despierta a la tarea en el plazo exacto
+static void debounce_timer_callback(void* arg) {
+    e18_edge_t expired = {
+        .timestamp = esp_timer_get_time(),
+        .level = EDGE_TIMER_EXPIRED
+    };
+    
+    // Con la cola llena no hace falta: la tarea ya tiene flancos y reprograma el timer
+    xQueueSend(sensor_event_queue, &expired, 0);
+}
+
 // Callback del timer para fotos periódicas
 static void periodic_photo_callback(void* arg) {
     // Solo tomar foto si el objeto sigue detectado (leer pin real)
     int sensor_state = gpio_get_level(current_config.pin);
+    sensor_statistics_t stats = sensor_e18_get_statistics();
     
     // Lógica: 0 = objeto detectado
-    if (sensor_state == 0 && sensor_stats.object_detected) {
+    if (sensor_state == 0 && stats.object_detected) {
         ESP_LOGI(TAG, "📸 Foto periódica - objeto permanece presente");
-        camera_manager_take_photo("objeto permanece presente");
         
-        // Notificar foto al servidor
-        send_server_event(SERVER_EVENT_PHOTO_TAKEN, "objeto permanece presente");
+        // Solo encolar: la captura ocurre en la tarea de la cámara y no bloquea el timer.
+        // Una foto periódica que no empieza antes de la siguiente ya no aporta nada.
+        camera_capture_request_t request = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_PERIODIC);
+        request.priority = CAMERA_CAPTURE_PRIORITY_LOW;
+        request.deadline = esp_timer_get_time() + PERIODIC_PHOTO_INTERVAL_US;
+        request.episode_id = stats.detection_count;
+        camera_manager_capture_async(&request);
     }
 }
 
-// Función para enviar eventos al servidor
-static esp_err_t send_server_event(server_event_type_t type, const char* reason) {
+// Función para enviar eventos al servidor (sin esperar: una ráfaga no frena la detección)
+static esp_err_t send_server_event(server_event_type_t type) {
     if (server_queue == NULL) {
         // Cola no configurada, continuar sin enviar
         return ESP_OK;
@@ -70,25 +108,11 @@ static esp_err_t send_server_event(server_event_type_t type, const char* reason)
         .object_detected = sensor_stats.object_detected,
         .sensor_state = gpio_get_level(current_config.pin)
     };
+    event.detection_data.detection_count = sensor_stats.detection_count;
     
-    switch (type) {
-        case SERVER_EVENT_DETECTION_STARTED:
-        case SERVER_EVENT_DETECTION_ENDED:
-            event.detection_data.detection_count = sensor_stats.detection_count;
-            break;
-            
-        case SERVER_EVENT_PHOTO_TAKEN:
-            // Los datos de la foto los maneja el componente de cámara
-            if (reason) {
-                strncpy(event.photo_data.reason, reason, sizeof(event.photo_data.reason) - 1);
-                event.photo_data.reason[sizeof(event.photo_data.reason) - 1] = '\0';
-            }
-            break;
-    }
-    
-    BaseType_t result = xQueueSend(server_queue, &event, pdMS_TO_TICKS(100));
-    if (result != pdTRUE) {
-        ESP_LOGW(TAG, "No se pudo enviar evento al servidor web");
+    if (server_events_post(server_queue, &event) != ESP_OK) {
+        metrics_counter_add(&event_queue_dropped, 1);
+        ESP_LOGW(TAG, "Cola del servidor web llena: evento descartado");
         return ESP_ERR_TIMEOUT;
     }
     
@@ -103,90 +127,169 @@ esp_err_t sensor_e18_set_server_queue(QueueHandle_t queue) {
     return ESP_OK;
 }
 
-// Tarea de detección para enviar eventos
+// Detección confirmada: estadísticas, avisos, ráfaga y fotos periódicas
+static void confirm_detection(int64_t detection_time) {
+    seqlock_write_begin(&stats_lock);
+    sensor_stats.object_detected = true;
+    sensor_stats.detection_count++;
+    sensor_stats.last_detection_time = detection_time;
+    sensor_stats.glitch_count = debounce.stats.glitches;
+    seqlock_write_end(&stats_lock);
+    
+    ESP_LOGI(TAG, "✅ MOVIMIENTO CONFIRMADO #%" PRIu32 " (%" PRId64 " ms desde el flanco, atendido con %" PRId64 " us de retraso)",
+             sensor_stats.detection_count, (detection_time - debounce.onset) / 1000,
+             esp_timer_get_time() - detection_time);
+    
+    // Conservar los frames previos al flanco (llegada de la gallina); la ventana se mide
+    // desde el flanco, no desde ahora
+    camera_manager_preroll_freeze(sensor_stats.detection_count, debounce.onset);
+    
+    // Solicitar ráfaga inmediata: se publica el frame más nítido (la cámara notifica al servidor)
+    camera_capture_request_t request = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_DETECTION);
+    request.priority = CAMERA_CAPTURE_PRIORITY_HIGH;
+    request.deadline = esp_timer_get_time() + DETECTION_PHOTO_DEADLINE_US;
+    request.burst_frames = DETECTION_BURST_FRAMES;
+    request.episode_id = sensor_stats.detection_count;
+    camera_manager_capture_async(&request);
+    
+    // Enviar evento al servidor
+    send_server_event(SERVER_EVENT_DETECTION_STARTED);
+    
+    // Iniciar timer para fotos periódicas
+    if (periodic_photo_timer == NULL) {
+        esp_timer_create_args_t timer_args = {
+            .callback = periodic_photo_callback,
+            .name = "periodic_photo_timer"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &periodic_photo_timer));
+    }
+    
+    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_photo_timer, PERIODIC_PHOTO_INTERVAL_US));
+    ESP_LOGI(TAG, "⏰ Timer de fotos periódicas iniciado");
+    
+    // Avisar (WhatsApp) desde su propia tarea: el envío puede tardar segundos y la
+    // detección debe seguir vaciando la cola de flancos mientras tanto
+    if (notify_task_handle != NULL) {
+        xTaskNotifyGive(notify_task_handle);
+    }
+}
+
+static void handle_debounce_event(e18_debounce_event_t event, int64_t at) {
+    switch (event) {
+    case E18_DEBOUNCE_ONSET:
+        ESP_LOGI(TAG, "🔍 Objeto detectado, confirmando en %" PRIu32 " ms...", current_config.confirm_ms);
+        // Subir la resolución mientras se confirma: la ráfaga ya sale en HD
+        camera_manager_capture_tier_wake();
+        break;
+        
+    case E18_DEBOUNCE_CONFIRMED:
+        confirm_detection(at);
+        break;
+        
+    case E18_DEBOUNCE_FALSE_ALARM:
+        seqlock_write_begin(&stats_lock);
+        sensor_stats.false_alarm_count = debounce.stats.false_alarms;
+        sensor_stats.glitch_count = debounce.stats.glitches;
+        seqlock_write_end(&stats_lock);
+        ESP_LOGI(TAG, "❌ Falsa alarma - objeto retirado antes de %" PRIu32 " ms", current_config.confirm_ms);
+        break;
+        
+    case E18_DEBOUNCE_RELEASED:
+        seqlock_write_begin(&stats_lock);
+        sensor_stats.object_detected = false;
+        sensor_stats.glitch_count = debounce.stats.glitches;
+        seqlock_write_end(&stats_lock);
+        ESP_LOGI(TAG, "❌ Objeto retirado - Total: %" PRIu32, sensor_stats.detection_count);
+        
+        // Enviar evento al servidor
+        send_server_event(SERVER_EVENT_DETECTION_ENDED);
+        
+        // Detener timer de fotos periódicas
+        if (periodic_photo_timer != NULL) {
+            esp_timer_stop(periodic_photo_timer);
+            ESP_LOGI(TAG, "⏰ Timer de fotos detenido");
+        }
+        break;
+        
+    default:
+        break;
+    }
+}
+
+// Resuelve en orden los plazos vencidos hasta now
+static void process_debounce_until(int64_t now) {
+    e18_debounce_event_t event;
+    int64_t at;
+    
+    while ((event = e18_debounce_advance(&debounce, now, &at)) != E18_DEBOUNCE_NONE) {
+        handle_debounce_event(event, at);
+    }
+}
+
+// Programa el timer en el próximo plazo (o lo para si no hay ninguno)
+static void schedule_debounce_timer(void) {
+    int64_t deadline = e18_debounce_next_deadline(&debounce);
+    
+    esp_timer_stop(debounce_timer);
+    if (deadline != 0) {
+        int64_t delay = deadline - esp_timer_get_time();
+        esp_timer_start_once(debounce_timer, delay > 0 ? (uint64_t)delay : 1);
+    }
+}
+
+// Tarea de avisos: llama a motion_callback por cada detección confirmada
+static void sensor_notify_task(void *pvParameter) {
+    while (1) {
+        // Las detecciones confirmadas durante un envío se avisan una sola vez
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (pending > 1) {
+            ESP_LOGI(TAG, "%" PRIu32 " detecciones durante el aviso anterior: un solo aviso", pending);
+        }
+        
+        motion_detected_callback_t callback = motion_callback;
+        if (callback != NULL) {
+            callback();
+        }
+    }
+}
+
+// Tarea de detección: aplica flancos y plazos en orden de tiempo, sin dormir nunca
 static void sensor_detection_task(void *pvParameter) {
-    uint32_t io_num;
+    e18_edge_t edge;
+    uint32_t dropped_seen = 0;
     
     ESP_LOGI(TAG, "🔥 Tarea de detección iniciada - Esperando eventos...");
+    schedule_debounce_timer();
     
     while(1) {
-        if(xQueueReceive(sensor_event_queue, &io_num, portMAX_DELAY)) {
-            ESP_LOGI(TAG, "🚨 EVENTO RECIBIDO en GPIO %" PRIu32, io_num);
-            
-            // Debouncing
-            vTaskDelay(pdMS_TO_TICKS(DEBOUNCE_TIME_MS));
-            
-            // Leer estado real del pin GPIO
-            int sensor_state = gpio_get_level(current_config.pin);
-            
-            ESP_LOGI(TAG, "📡 Estado GPIO: %d (0=objeto detectado, 1=sin objeto)", sensor_state);
-            
-            // Lógica corregida: 0 = objeto detectado, 1 = sin objeto
-            if (sensor_state == 0) {
-                // OBJETO DETECTADO
-                if (!sensor_stats.object_detected) {
-                    ESP_LOGI(TAG, "🔍 Objeto detectado, esperando 1s para confirmación...");
-                    
-                    // Esperar 1 segundo para confirmación
-                    vTaskDelay(pdMS_TO_TICKS(1000));
-                    
-                    // Re-verificar después de 1 segundo
-                    int confirmed_state = gpio_get_level(current_config.pin);
-                    if (confirmed_state == 0) {
-                        // Confirmado: objeto sigue presente después de 1s
-                        sensor_stats.object_detected = true;
-                        sensor_stats.detection_count++;
-                        sensor_stats.last_detection_time = esp_timer_get_time();
-                        
-                        ESP_LOGI(TAG, "✅ MOVIMIENTO CONFIRMADO #%" PRIu32, sensor_stats.detection_count);
-                        
-                        // Llamar callback si está configurado (para WhatsApp)
-                        if (motion_callback != NULL) {
-                            motion_callback();
-                        }
-                        
-                        // Enviar evento al servidor
-                        send_server_event(SERVER_EVENT_DETECTION_STARTED, NULL);
-                        
-                        // Tomar foto inmediata
-                        camera_manager_take_photo("detección inicial");
-                        
-                        // Notificar foto al servidor
-                        send_server_event(SERVER_EVENT_PHOTO_TAKEN, "detección inicial");
-                        
-                        // Iniciar timer para fotos periódicas
-                        if (periodic_photo_timer == NULL) {
-                            esp_timer_create_args_t timer_args = {
-                                .callback = periodic_photo_callback,
-                                .name = "periodic_photo_timer"
-                            };
-                            ESP_ERROR_CHECK(esp_timer_create(&timer_args, &periodic_photo_timer));
-                        }
-                        
-                        ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_photo_timer, PERIODIC_PHOTO_INTERVAL_US));
-                        ESP_LOGI(TAG, "⏰ Timer de fotos periódicas iniciado");
-                    } else {
-                        ESP_LOGI(TAG, "❌ Falsa alarma - objeto no confirmado tras 1s");
-                    }
-                }
-                
-            } else {
-                // OBJETO NO DETECTADO (sensor_state == 1)
-                if (sensor_stats.object_detected) {
-                    sensor_stats.object_detected = false;
-                    ESP_LOGI(TAG, "❌ Objeto retirado - Total: %" PRIu32, sensor_stats.detection_count);
-                    
-                    // Enviar evento al servidor
-                    send_server_event(SERVER_EVENT_DETECTION_ENDED, NULL);
-                    
-                    // Detener timer de fotos periódicas
-                    if (periodic_photo_timer != NULL) {
-                        esp_timer_stop(periodic_photo_timer);
-                        ESP_LOGI(TAG, "⏰ Timer de fotos detenido");
-                    }
-                }
-            }
+        if (xQueueReceive(sensor_event_queue, &edge, portMAX_DELAY) != pdTRUE) {
+            continue;
         }
+        
+        // Lo que venció antes del flanco se resuelve antes que el flanco
+        process_debounce_until(edge.timestamp);
+        if (edge.level != EDGE_TIMER_EXPIRED) {
+            ESP_LOGD(TAG, "Flanco en GPIO %d: nivel %u", current_config.pin, edge.level);
+            e18_debounce_edge(&debounce, &edge);
+        }
+        
+        // Flancos perdidos con la cola llena: el nivel actual del pin los sustituye
+        uint32_t dropped = isr_dropped_edges;
+        if (dropped != dropped_seen) {
+            ESP_LOGW(TAG, "Cola del sensor llena: %" PRIu32 " flancos perdidos", dropped - dropped_seen);
+            dropped_seen = dropped;
+            e18_edge_t resync = {
+                .timestamp = esp_timer_get_time(),
+                .level = (uint8_t)gpio_get_level(current_config.pin)
+            };
+            process_debounce_until(resync.timestamp);
+            e18_debounce_edge(&debounce, &resync);
+            seqlock_write_begin(&stats_lock);
+            sensor_stats.dropped_edges = dropped;
+            seqlock_write_end(&stats_lock);
+        }
+        
+        schedule_debounce_timer();
     }
 }
 
@@ -203,18 +306,28 @@ esp_err_t sensor_e18_init_with_config(const sensor_e18_config_t *config) {
     
     // Copiar configuración
     current_config = *config;
+    metrics_register(&event_queue_dropped.desc);
     
     ESP_LOGI(TAG, "Inicializando sensor E18-D80NK en GPIO %d", current_config.pin);
     
     // Crear cola de eventos
     if (sensor_event_queue == NULL) {
-        sensor_event_queue = xQueueCreate(10, sizeof(uint32_t));
+        sensor_event_queue = xQueueCreate(SENSOR_EVENT_QUEUE_LEN, sizeof(e18_edge_t));
         if (sensor_event_queue == NULL) {
             ESP_LOGE(TAG, "Error creando cola");
             return ESP_ERR_NO_MEM;
         }
     }
     
+    // Timer de los plazos del antirrebote (la tarea lo reprograma tras cada flanco)
+    if (debounce_timer == NULL) {
+        esp_timer_create_args_t timer_args = {
+            .callback = debounce_timer_callback,
+            .name = "e18_debounce"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &debounce_timer));
+    }
+    
     // Configurar GPIO
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << current_config.pin),
@@ -231,11 +344,18 @@ esp_err_t sensor_e18_init_with_config(const sensor_e18_config_t *config) {
     
     // Test inicial del sensor con debug extendido
     int initial_state = gpio_get_level(current_config.pin);
+    e18_debounce_config_t debounce_config = {
+        .debounce_ms = current_config.debounce_ms,
+        .confirm_ms = current_config.confirm_ms
+    };
+    e18_debounce_init(&debounce, &debounce_config, (uint8_t)initial_state, esp_timer_get_time());
     ESP_LOGI(TAG, "🔍 DIAGNÓSTICO INICIAL DEL SENSOR E18-D80NK:");
     ESP_LOGI(TAG, "   - Pin GPIO: %d", current_config.pin);
     ESP_LOGI(TAG, "   - Estado raw del pin: %d", initial_state);
     ESP_LOGI(TAG, "   - Pull-up: %s", current_config.pull_up_en ? "HABILITADO" : "DESHABILITADO");
     ESP_LOGI(TAG, "   - Interpretación: %s", initial_state == 0 ? "OBJETO DETECTADO" : "SIN OBJETO");
+    ESP_LOGI(TAG, "   - Antirrebote: %" PRIu32 " ms, confirmación: %" PRIu32 " ms",
+             current_config.debounce_ms, current_config.confirm_ms);
     ESP_LOGI(TAG, "🔍 ===================================");
     
     ESP_LOGI(TAG, "Sensor E18-D80NK inicializado correctamente en GPIO %d", current_config.pin);
@@ -243,6 +363,14 @@ esp_err_t sensor_e18_init_with_config(const sensor_e18_config_t *config) {
 }
 
 esp_err_t sensor_e18_start_detection_task(void) {
+    // Prioridad menor que la detección: el aviso nunca la adelanta
+    if (notify_task_handle == NULL &&
+        xTaskCreate(sensor_notify_task, "sensor_notify", NOTIFY_TASK_STACK, NULL, 5,
+                    &notify_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de avisos");
+        return ESP_FAIL;
+    }
+    
     BaseType_t result = xTaskCreate(
         sensor_detection_task, 
         "sensor_detection", 
@@ -262,7 +390,11 @@ esp_err_t sensor_e18_start_detection_task(void) {
 }
 
 sensor_statistics_t sensor_e18_get_statistics(void) {
-    return sensor_stats;
+    sensor_statistics_t stats;
+    
+    // Sin bloqueo: si coincide con una detección se repite la copia
+    seqlock_read(&stats_lock, &stats, &sensor_stats, sizeof(stats));
+    return stats;
 }
 
 int sensor_e18_read_state(void) {
@@ -281,6 +413,11 @@ esp_err_t sensor_e18_deinit(void) {
         esp_timer_delete(periodic_photo_timer);
         periodic_photo_timer = NULL;
     }
+    if (debounce_timer != NULL) {
+        esp_timer_stop(debounce_timer);
+        esp_timer_delete(debounce_timer);
+        debounce_timer = NULL;
+    }
     
     // Remover handler de interrupción
     if (current_config.pin >= 0) {
@@ -294,7 +431,8 @@ esp_err_t sensor_e18_deinit(void) {
     }
     
     // Reset estadísticas
-    memset(&sensor_stats, 0, sizeof(sensor_stats));
+    sensor_statistics_t empty_stats = {0};
+    seqlock_write(&stats_lock, &sensor_stats, &empty_stats, sizeof(empty_stats));
     
     ESP_LOGI(TAG, "Sensor desinicializado");
     return ESP_OK;
@@ -314,9 +452,12 @@ esp_err_t sensor_e18_simulate_detection(bool simulate_detection) {
              simulate_detection ? "DETECCIÓN DE OBJETO" : "RETIRO DE OBJETO",
              simulated_pin_state);
     
-    // Simular evento enviando el GPIO a la cola
-    uint32_t gpio_num = current_config.pin;
-    BaseType_t result = xQueueSend(sensor_event_queue, &gpio_num, pdMS_TO_TICKS(100));
+    // Simular el flanco que enviaría la ISR con el nivel simulado
+    e18_edge_t edge = {
+        .timestamp = esp_timer_get_time(),
+        .level = (uint8_t)simulated_pin_state
+    };
+    BaseType_t result = xQueueSend(sensor_event_queue, &edge, pdMS_TO_TICKS(100));
     
     if (result != pdTRUE) {
         ESP_LOGE(TAG, "Error enviando evento simulado a la cola");
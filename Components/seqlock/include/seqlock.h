@@ -0,0 +1,96 @@
+// seqlock.h - Instantáneas versionadas: los lectores nunca bloquean ni ven datos a medias
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Protege una estructura compartida escrita por pocas tareas y leída por muchas.
+// El escritor incrementa seq antes y después de modificarla (impar = escritura en curso);
+// el lector copia la estructura y repite si seq era impar o cambió durante la copia.
+// El escritor entra en una sección crítica: dos escritores no se mezclan y ningún lector
+// del mismo núcleo puede interrumpirle a mitad (esperaría a un seq que nunca avanza)
+typedef struct {
+    volatile uint32_t seq;
+    portMUX_TYPE writer;
+} seqlock_t;
+
+#define SEQLOCK_INIT() { .seq = 0, .writer = portMUX_INITIALIZER_UNLOCKED }
+
+/**
+ * @brief Empieza a modificar la estructura protegida en su sitio
+ * @warning Sección crítica: solo asignaciones, sin logs ni llamadas que bloqueen
+ * @param lock Seqlock de la estructura
+ */
+static inline void seqlock_write_begin(seqlock_t *lock) {
+    portENTER_CRITICAL(&lock->writer);
+    lock->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publica las modificaciones empezadas con seqlock_write_begin()
+ * @param lock Seqlock de la estructura
+ */
+static inline void seqlock_write_end(seqlock_t *lock) {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    lock->seq++;
+    portEXIT_CRITICAL(&lock->writer);
+}
+
+/**
+ * @brief Empieza una lectura (espera mientras otro núcleo termina de escribir)
+ * @param lock Seqlock de la estructura
+ * @return Versión leída, para seqlock_read_retry()
+ */
+static inline uint32_t seqlock_read_begin(const seqlock_t *lock) {
+    uint32_t seq;
+    while ((seq = lock->seq) & 1) {
+        // Escritura en curso en el otro núcleo: dura lo que una copia de la estructura
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return seq;
+}
+
+/**
+ * @brief Comprueba si lo leído desde seqlock_read_begin() es coherente
+ * @param lock Seqlock de la estructura
+ * @param seq Versión devuelta por seqlock_read_begin()
+ * @return true si hubo una escritura entretanto y hay que repetir la lectura
+ */
+static inline bool seqlock_read_retry(const seqlock_t *lock, uint32_t seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return lock->seq != seq;
+}
+
+/**
+ * @brief Sustituye la estructura protegida por un valor completo
+ * @param lock Seqlock de la estructura
+ * @param shared Estructura protegida
+ * @param value Valor nuevo
+ * @param size Tamaño de la estructura
+ */
+void seqlock_write(seqlock_t *lock, void *shared, const void *value, size_t size);
+
+/**
+ * @brief Copia una instantánea coherente de la estructura protegida
+ * @note Nunca bloquea al escritor: si la copia coincide con una escritura se repite
+ * @param lock Seqlock de la estructura
+ * @param out Destino de la copia
+ * @param shared Estructura protegida
+ * @param size Tamaño de la estructura
+ * @return Lecturas repetidas por coincidir con una escritura (0 casi siempre)
+ */
+uint32_t seqlock_read(const seqlock_t *lock, void *out, const void *shared, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEQLOCK_H
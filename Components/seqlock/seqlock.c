@@ -0,0 +1,22 @@
+// seqlock.c - Responsabilidad única: copiar estructuras completas protegidas por un seqlock
+#include "seqlock.h"
+#include <string.h>
+
+void seqlock_write(seqlock_t *lock, void *shared, const void *value, size_t size) {
+    seqlock_write_begin(lock);
+    memcpy(shared, value, size);
+    seqlock_write_end(lock);
+}
+
+uint32_t seqlock_read(const seqlock_t *lock, void *out, const void *shared, size_t size) {
+    uint32_t retries = 0;
+
+    for (;;) {
+        uint32_t seq = seqlock_read_begin(lock);
+        memcpy(out, shared, size);
+        if (!seqlock_read_retry(lock, seq)) {
+            return retries;
+        }
+        retries++;
+    }
+}
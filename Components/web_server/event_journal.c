@@ -0,0 +1,182 @@
+// event_journal.c - Responsabilidad única: diario acotado de eventos del servidor
+//
+// Anillo de registros server_event_t de tamaño fijo reservado una sola vez. Los ids son
+// consecutivos, así que el evento con id k está siempre en la posición (k - 1) % capacidad
+// mientras no se haya sobrescrito: anotar y localizar el principio de un rango son O(1).
+#include "event_journal.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "EVENT_JOURNAL";
+
+_Static_assert(sizeof(event_journal_bin_header_t) == 24, "Cabecera binaria de 24 bytes");
+
+// Variables privadas del módulo
+static server_event_t *records = NULL;
+static size_t capacity = 0;
+static uint32_t latest_id = 0;
+static size_t count = 0;
+static event_journal_stats_t stats = {0};
+static portMUX_TYPE journal_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t event_journal_init(const event_journal_config_t *config) {
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Configuración inválida");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (records != NULL) {
+        ESP_LOGW(TAG, "Diario ya inicializado");
+        return ESP_OK;
+    }
+    if (config->capacity == 0) {
+        ESP_LOGI(TAG, "Diario de eventos desactivado");
+        return ESP_OK;
+    }
+
+#if CONFIG_SPIRAM
+    server_event_t *ring = heap_caps_calloc(config->capacity, sizeof(server_event_t),
+                                            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    server_event_t *ring = calloc(config->capacity, sizeof(server_event_t));
+#endif
+    if (ring == NULL) {
+        ESP_LOGE(TAG, "Error asignando diario (%zu eventos)", config->capacity);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&journal_lock);
+    records = ring;
+    capacity = config->capacity;
+    latest_id = 0;
+    count = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.capacity = capacity;
+    portEXIT_CRITICAL(&journal_lock);
+
+    ESP_LOGI(TAG, "Diario de eventos listo: %zu eventos (%zu bytes)",
+             capacity, capacity * sizeof(server_event_t));
+    return ESP_OK;
+}
+
+void event_journal_deinit(void) {
+    portENTER_CRITICAL(&journal_lock);
+    server_event_t *ring = records;
+    records = NULL;
+    capacity = 0;
+    count = 0;
+    stats.capacity = 0;
+    portEXIT_CRITICAL(&journal_lock);
+
+    free(ring);
+}
+
+uint32_t event_journal_append(server_event_t *event) {
+    uint32_t id = 0;
+
+    portENTER_CRITICAL(&journal_lock);
+    if (records != NULL) {
+        id = ++latest_id;
+        event->id = id;
+        records[(id - 1) % capacity] = *event;
+        if (count < capacity) {
+            count++;
+        } else {
+            stats.overwritten++;
+        }
+        stats.appended++;
+    }
+    portEXIT_CRITICAL(&journal_lock);
+
+    return id;
+}
+
+size_t event_journal_read(uint32_t after, size_t limit, event_journal_page_t *page) {
+    if (page == NULL) {
+        return 0;
+    }
+    page->count = 0;
+    page->after = after;
+    page->oldest_id = 0;
+    page->latest_id = 0;
+    page->lost = 0;
+    page->more = false;
+    if (limit > EVENT_JOURNAL_QUERY_MAX) {
+        limit = EVENT_JOURNAL_QUERY_MAX;
+    }
+
+    portENTER_CRITICAL(&journal_lock);
+    stats.reads++;
+    if (count > 0) {
+        uint32_t oldest = latest_id - (uint32_t)count + 1;
+        page->oldest_id = oldest;
+        page->latest_id = latest_id;
+
+        // Un cliente que se quedó atrás empieza por el más antiguo y sabe cuántos perdió
+        if (after < latest_id) {
+            uint32_t first = (after < oldest) ? oldest : after + 1;
+            page->lost = (after + 1 < oldest) ? oldest - after - 1 : 0;
+            for (uint32_t id = first; id <= latest_id && page->count < limit; id++) {
+                page->events[page->count++] = records[(id - 1) % capacity];
+            }
+            page->more = first + page->count <= latest_id;
+        }
+    }
+    portEXIT_CRITICAL(&journal_lock);
+
+    return page->count;
+}
+
+event_journal_stats_t event_journal_get_stats(void) {
+    portENTER_CRITICAL(&journal_lock);
+    event_journal_stats_t current = stats;
+    current.count = count;
+    current.latest_id = count > 0 ? latest_id : 0;
+    current.oldest_id = count > 0 ? latest_id - (uint32_t)count + 1 : 0;
+    portEXIT_CRITICAL(&journal_lock);
+    return current;
+}
+
+int event_journal_page_json(const event_journal_page_t *page, char *buf, size_t size) {
+    uint32_t next = page->count > 0 ? page->events[page->count - 1].id : page->after;
+    char data[160];
+    int len = snprintf(buf, size,
+        "{\"after\":%lu,\"oldest\":%lu,\"latest\":%lu,\"next\":%lu,\"more\":%s,\"lost\":%lu,\"events\":[",
+        (unsigned long)page->after, (unsigned long)page->oldest_id, (unsigned long)page->latest_id,
+        (unsigned long)next, page->more ? "true" : "false", (unsigned long)page->lost);
+
+    for (size_t i = 0; i < page->count && len < (int)size; i++) {
+        const char *name = server_event_json(&page->events[i], data, sizeof(data));
+        len += snprintf(buf + len, size - len, "%s{\"event\":\"%s\",\"data\":%s}",
+                        i > 0 ? "," : "", name != NULL ? name : "unknown", name != NULL ? data : "{}");
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+    return len;
+}
+
+size_t event_journal_page_binary(const event_journal_page_t *page, uint8_t *buf, size_t size) {
+    size_t total = sizeof(event_journal_bin_header_t) + page->count * sizeof(server_event_t);
+    if (total > size) {
+        return 0;
+    }
+
+    event_journal_bin_header_t header = {
+        .record_size = sizeof(server_event_t),
+        .count = (uint16_t)page->count,
+        .oldest_id = page->oldest_id,
+        .latest_id = page->latest_id,
+        .lost = page->lost,
+        .more = page->more ? 1 : 0
+    };
+    memcpy(header.magic, EVENT_JOURNAL_BIN_MAGIC, sizeof(header.magic));
+    memcpy(buf, &header, sizeof(header));
+    memcpy(buf + sizeof(header), page->events, page->count * sizeof(server_event_t));
+    return total;
+}
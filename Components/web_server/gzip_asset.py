@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+# gzip_asset.py - Comprime un fichero de la interfaz web para incrustarlo en flash
+#
+# Uso: gzip_asset.py entrada salida directorio_www
+#
+# Sustituye {{hash:nombre}} por los 8 primeros dígitos del SHA-256 de www/nombre: la
+# página pide /app.js?v=<hash> y el navegador puede guardar los recursos sin revalidar,
+# porque cualquier cambio de contenido cambia la URL. Salida reproducible (mtime = 0).
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+src, dst, www = sys.argv[1:4]
+
+with open(src, 'rb') as f:
+    data = f.read()
+
+
+def asset_hash(match):
+    with open(os.path.join(www, match.group(1).decode()), 'rb') as f:
+        return hashlib.sha256(f.read()).hexdigest()[:8].encode()
+
+
+data = re.sub(rb'\{\{hash:([\w.-]+)\}\}', asset_hash, data)
+
+with open(dst, 'wb') as f:
+    f.write(gzip.compress(data, compresslevel=9, mtime=0))
@@ -0,0 +1,87 @@
+// http_cache.c - Responsabilidad única: validadores de caché HTTP
+//
+// La foto cambia como mucho una vez por captura y cada frame ya tiene un número de
+// secuencia: basta para un ETag fuerte sin leer ni hashear el JPEG. Con él, la recarga
+// de un navegador que ya tiene la foto cuesta una respuesta 304 sin cuerpo.
+#include "http_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+int http_etag_format(char *buf, size_t size, uint32_t epoch, uint32_t seq, char variant) {
+    if (variant != '\0') {
+        return snprintf(buf, size, "\"%08lx-%lu%c\"", (unsigned long)epoch, (unsigned long)seq, variant);
+    }
+    return snprintf(buf, size, "\"%08lx-%lu\"", (unsigned long)epoch, (unsigned long)seq);
+}
+
+int http_etag_format_hash(char *buf, size_t size, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return snprintf(buf, size, "\"%08lx\"", (unsigned long)hash);
+}
+
+bool http_etag_matches(const char *if_none_match, const char *etag) {
+    if (if_none_match == NULL || etag == NULL) {
+        return false;
+    }
+
+    size_t etag_len = strlen(etag);
+    const char *p = if_none_match;
+
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (*p == '*') {
+            return true;
+        }
+        if (p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+
+        // Etiqueta entre comillas; las comas dentro de ella no separan la lista
+        const char *start = p;
+        if (*p == '"') {
+            p++;
+            while (*p != '\0' && *p != '"') {
+                p++;
+            }
+            if (*p == '"') {
+                p++;
+            }
+        }
+        while (*p != '\0' && *p != ',' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+
+        if ((size_t)(p - start) == etag_len && strncmp(start, etag, etag_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int http_date_format(char *buf, size_t size, int64_t epoch_ms) {
+    static const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    struct tm tm;
+    time_t seconds = (time_t)(epoch_ms / 1000);
+
+    if (epoch_ms <= 0 || gmtime_r(&seconds, &tm) == NULL) {
+        return 0;
+    }
+
+    // Sin strftime: sus nombres dependen del locale y HTTP exige los ingleses
+    return snprintf(buf, size, "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                    days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900,
+                    tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
@@ -0,0 +1,208 @@
+// http_workers.c - Responsabilidad única: ejecutar handlers HTTP lentos fuera de la tarea de httpd
+//
+// esp_http_server atiende todos los sockets desde una sola tarea: mientras envía 100 KB a
+// un móvil con mala cobertura, /status y la página esperan. Los handlers con cuerpos
+// grandes se pasan aquí con httpd_req_async_handler_begin(): la tarea de httpd vuelve a
+// su bucle en cuanto encola y el envío bloqueante ocurre en una tarea del pool.
+#include "http_workers.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "HTTP_WORKERS";
+
+// Petición encolada
+typedef struct {
+    httpd_req_t *req;             // Copia asíncrona (NULL = orden de terminar)
+    http_work_fn_t fn;
+    uint64_t queued_at;
+} http_work_item_t;
+
+static QueueHandle_t work_queue = NULL;
+static http_workers_stats_t workers_stats = {0};
+static portMUX_TYPE workers_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Las mismas esperas y rechazos, para /metrics
+static metric_histogram_t wait_metric = METRIC_HISTOGRAM_INIT("coop_http_worker_wait_seconds",
+    "Espera de una petición en la cola del pool HTTP", NULL);
+static metric_counter_t rejected_metric = METRIC_COUNTER_INIT("coop_http_worker_rejected_total",
+    "Peticiones rechazadas con 503 por la cola del pool llena", NULL);
+
+static void worker_task(void *pvParameters) {
+    http_work_item_t item;
+
+    while (xQueueReceive(work_queue, &item, portMAX_DELAY) == pdTRUE) {
+        if (item.req == NULL) {
+            break;
+        }
+
+        uint64_t start = esp_timer_get_time();
+        metrics_histogram_observe(&wait_metric, (uint32_t)(start - item.queued_at));
+        portENTER_CRITICAL(&workers_lock);
+        workers_stats.busy++;
+        workers_stats.queued--;
+        latency_hist_record(&workers_stats.wait, (uint32_t)(start - item.queued_at));
+        portEXIT_CRITICAL(&workers_lock);
+
+        esp_err_t ret = item.fn(item.req);
+        httpd_req_async_handler_complete(item.req);
+
+        uint32_t service_us = (uint32_t)(esp_timer_get_time() - start);
+        portENTER_CRITICAL(&workers_lock);
+        workers_stats.busy--;
+        workers_stats.completed++;
+        if (ret != ESP_OK) {
+            workers_stats.failed++;
+        }
+        latency_hist_record(&workers_stats.service, service_us);
+        portEXIT_CRITICAL(&workers_lock);
+    }
+
+    portENTER_CRITICAL(&workers_lock);
+    workers_stats.workers--;
+    portEXIT_CRITICAL(&workers_lock);
+    vTaskDelete(NULL);
+}
+
+esp_err_t http_workers_start(const http_workers_config_t *config) {
+    if (config == NULL || config->worker_count > HTTP_WORKERS_MAX ||
+        (config->worker_count > 0 && config->queue_depth == 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (work_queue != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(&workers_stats, 0, sizeof(workers_stats));
+    metrics_register(&wait_metric.desc);
+    metrics_register(&rejected_metric.desc);
+    if (config->worker_count == 0) {
+        ESP_LOGI(TAG, "Pool desactivado: handlers en la tarea de httpd");
+        return ESP_OK;
+    }
+
+    work_queue = xQueueCreate(config->queue_depth, sizeof(http_work_item_t));
+    if (work_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t core = config->core_id < 0 ? tskNO_AFFINITY : config->core_id;
+    for (int i = 0; i < config->worker_count; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "http_worker%d", i);
+        if (xTaskCreatePinnedToCore(worker_task, name, config->stack_size, NULL,
+                                    config->priority, NULL, core) != pdPASS) {
+            ESP_LOGE(TAG, "Error creando %s", name);
+            http_workers_stop(1000);
+            return ESP_ERR_NO_MEM;
+        }
+        portENTER_CRITICAL(&workers_lock);
+        workers_stats.workers++;
+        portEXIT_CRITICAL(&workers_lock);
+    }
+
+    ESP_LOGI(TAG, "🧵 Pool HTTP: %u tareas, cola de %u, núcleo %d",
+             config->worker_count, config->queue_depth, config->core_id);
+    return ESP_OK;
+}
+
+esp_err_t http_workers_stop(uint32_t timeout_ms) {
+    if (work_queue == NULL) {
+        return ESP_OK;
+    }
+
+    // Las órdenes de terminar van detrás de lo pendiente: toda petición encolada se
+    // completa (si no, httpd no liberaría su sesión)
+    http_work_item_t stop = { 0 };
+    portENTER_CRITICAL(&workers_lock);
+    uint8_t workers = workers_stats.workers;
+    portEXIT_CRITICAL(&workers_lock);
+    for (int i = 0; i < workers; i++) {
+        xQueueSend(work_queue, &stop, pdMS_TO_TICKS(timeout_ms));
+    }
+
+    uint32_t waited_ms = 0;
+    while (waited_ms < timeout_ms) {
+        portENTER_CRITICAL(&workers_lock);
+        workers = workers_stats.workers;
+        portEXIT_CRITICAL(&workers_lock);
+        if (workers == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+        waited_ms += 20;
+    }
+    if (workers > 0) {
+        ESP_LOGW(TAG, "%u tareas del pool siguen ocupadas", workers);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    vQueueDelete(work_queue);
+    work_queue = NULL;
+    return ESP_OK;
+}
+
+esp_err_t http_workers_submit(httpd_req_t *req, http_work_fn_t fn) {
+    if (work_queue == NULL) {
+        return fn(req);
+    }
+
+    // httpd es el único productor: si ahora hay hueco, lo seguirá habiendo al encolar
+    if (uxQueueSpacesAvailable(work_queue) == 0) {
+        portENTER_CRITICAL(&workers_lock);
+        workers_stats.rejected++;
+        portEXIT_CRITICAL(&workers_lock);
+        metrics_counter_add(&rejected_metric, 1);
+
+        const char* busy_msg = "Servidor ocupado, reintentar en unos segundos";
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "2");
+        return httpd_resp_send(req, busy_msg, strlen(busy_msg));
+    }
+
+    http_work_item_t item = { .fn = fn, .queued_at = esp_timer_get_time() };
+    if (httpd_req_async_handler_begin(req, &item.req) != ESP_OK) {
+        ESP_LOGE(TAG, "Error preparando petición asíncrona");
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&workers_lock);
+    workers_stats.submitted++;
+    workers_stats.queued++;
+    if (workers_stats.queued > workers_stats.max_queued) {
+        workers_stats.max_queued = workers_stats.queued;
+    }
+    portEXIT_CRITICAL(&workers_lock);
+
+    xQueueSend(work_queue, &item, 0);
+    return ESP_OK;
+}
+
+void http_workers_get_stats(http_workers_stats_t *stats) {
+    portENTER_CRITICAL(&workers_lock);
+    *stats = workers_stats;
+    portEXIT_CRITICAL(&workers_lock);
+}
+
+int http_workers_stats_json(const http_workers_stats_t *stats, char *buf, size_t size) {
+    return snprintf(buf, size,
+        "{\"workers\":%u,\"busy\":%u,\"queued\":%u,\"max_queued\":%u,"
+        "\"submitted\":%lu,\"rejected\":%lu,\"completed\":%lu,\"failed\":%lu,"
+        "\"wait_p50_us\":%lu,\"wait_p99_us\":%lu,\"wait_max_us\":%lu,"
+        "\"service_p50_us\":%lu,\"service_p99_us\":%lu,\"service_max_us\":%lu}",
+        stats->workers, stats->busy, stats->queued, stats->max_queued,
+        (unsigned long)stats->submitted, (unsigned long)stats->rejected,
+        (unsigned long)stats->completed, (unsigned long)stats->failed,
+        (unsigned long)latency_hist_percentile(&stats->wait, 50),
+        (unsigned long)latency_hist_percentile(&stats->wait, 99),
+        (unsigned long)stats->wait.max_us,
+        (unsigned long)latency_hist_percentile(&stats->service, 50),
+        (unsigned long)latency_hist_percentile(&stats->service, 99),
+        (unsigned long)stats->service.max_us);
+}
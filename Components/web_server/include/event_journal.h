@@ -0,0 +1,127 @@
+// event_journal.h - Diario acotado de eventos del servidor con ids monotónicos (/events/history)
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include "esp_err.h"
+#include "server_events.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_JOURNAL_QUERY_MAX     64      // Eventos por consulta como máximo
+#define EVENT_JOURNAL_BIN_MAGIC     "EVJ1"
+#define EVENT_JOURNAL_CONTENT_TYPE_BIN  "application/octet-stream"
+
+// Configuración del diario
+typedef struct {
+    size_t capacity;          // Eventos retenidos (24 bytes cada uno; 0 = sin diario)
+} event_journal_config_t;
+
+#define EVENT_JOURNAL_DEFAULT_CONFIG() { \
+    .capacity = 512 \
+}
+
+// Página del diario devuelta por event_journal_read()
+typedef struct {
+    server_event_t events[EVENT_JOURNAL_QUERY_MAX];
+    size_t count;
+    uint32_t after;           // Id pedido
+    uint32_t oldest_id;       // Más antiguo retenido (0 si está vacío)
+    uint32_t latest_id;       // Más reciente (0 si está vacío)
+    uint32_t lost;            // Eventos posteriores a after que ya se sobrescribieron
+    bool more;                // Quedan eventos posteriores al último de la página
+} event_journal_page_t;
+
+// Cabecera del formato binario (little-endian, como la memoria del ESP32): le siguen
+// count registros de record_size bytes con la disposición de server_event_t:
+//   u64 timestamp, u32 id, u8 type, u8 reason, i8 sensor_state, u8 object_detected,
+//   u32 detection_count | seq, u32 photo_size
+typedef struct __attribute__((packed)) {
+    char magic[4];            // EVENT_JOURNAL_BIN_MAGIC
+    uint16_t record_size;     // sizeof(server_event_t)
+    uint16_t count;
+    uint32_t oldest_id;
+    uint32_t latest_id;
+    uint32_t lost;
+    uint8_t more;
+    uint8_t reserved[3];
+} event_journal_bin_header_t;
+
+// Estadísticas del diario
+typedef struct {
+    uint32_t appended;        // Eventos anotados (también es el último id)
+    uint32_t overwritten;     // Eventos sobrescritos por otros más nuevos
+    uint32_t count;           // Eventos retenidos
+    uint32_t oldest_id;       // 0 si está vacío
+    uint32_t latest_id;       // 0 si está vacío
+    uint32_t reads;           // Consultas atendidas
+    size_t capacity;
+} event_journal_stats_t;
+
+/**
+ * @brief Reserva el anillo del diario (en PSRAM si está disponible)
+ * @note Es la única reserva: anotar nunca asigna memoria
+ * @param config Configuración del diario (capacity = 0 lo deja desactivado)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG o ESP_ERR_NO_MEM
+ */
+esp_err_t event_journal_init(const event_journal_config_t *config);
+
+/**
+ * @brief Libera el diario
+ */
+void event_journal_deinit(void);
+
+/**
+ * @brief Anota un evento y le asigna el siguiente id
+ * @note O(1), sin reservas y seguro desde cualquier tarea (sección crítica corta).
+ *       Con el diario lleno sobrescribe el más antiguo
+ * @param event Evento a anotar; se le escribe el id asignado
+ * @return Id asignado (1, 2, 3...) o 0 sin diario
+ */
+uint32_t event_journal_append(server_event_t *event);
+
+/**
+ * @brief Copia los eventos posteriores a un id, de más antiguo a más reciente
+ * @note Los ids son consecutivos: localizar el primero es O(1)
+ * @param after Devolver los eventos con id > after (0 = desde el más antiguo)
+ * @param limit Eventos como máximo (se recorta a EVENT_JOURNAL_QUERY_MAX)
+ * @param page Página de salida
+ * @return Eventos copiados
+ */
+size_t event_journal_read(uint32_t after, size_t limit, event_journal_page_t *page);
+
+/**
+ * @brief Obtiene las estadísticas del diario
+ * @return Estructura con estadísticas
+ */
+event_journal_stats_t event_journal_get_stats(void);
+
+/**
+ * @brief Escribe una página como JSON compacto para /events/history
+ * @note "next" es el id que el cliente envía como after en la siguiente consulta; cada
+ *       evento lleva el nombre y los datos que /events envía en vivo
+ * @param page Página obtenida con event_journal_read()
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita (como snprintf: >= size indica truncado)
+ */
+int event_journal_page_json(const event_journal_page_t *page, char *buf, size_t size);
+
+/**
+ * @brief Escribe una página en el formato binario (cabecera y registros)
+ * @param page Página obtenida con event_journal_read()
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Bytes escritos o 0 si no cabe
+ */
+size_t event_journal_page_binary(const event_journal_page_t *page, uint8_t *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_JOURNAL_H
@@ -0,0 +1,62 @@
+// http_cache.h - Validadores HTTP (ETag, Last-Modified) para peticiones condicionales
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_ETAG_MAX_LEN       32      // "epoch-seqvariante" con comillas y terminador
+#define HTTP_DATE_LEN           30      // "Sun, 06 Nov 1994 08:49:37 GMT" y terminador
+
+/**
+ * @brief Construye un ETag fuerte a partir del número de secuencia del frame
+ * @note El epoch (aleatorio por arranque) evita que un seq repetido tras un reinicio
+ *       valide la copia de un frame distinto en la caché del navegador
+ * @param buf Buffer de salida (HTTP_ETAG_MAX_LEN bytes)
+ * @param size Tamaño del buffer
+ * @param epoch Identificador del arranque
+ * @param seq Número de secuencia del frame
+ * @param variant Sufijo de la representación ('\0' = foto, 't' = miniatura...)
+ * @return Longitud escrita (como snprintf)
+ */
+int http_etag_format(char *buf, size_t size, uint32_t epoch, uint32_t seq, char variant);
+
+/**
+ * @brief Construye un ETag fuerte a partir del contenido (FNV-1a de 32 bits)
+ * @param buf Buffer de salida (HTTP_ETAG_MAX_LEN bytes)
+ * @param size Tamaño del buffer
+ * @param data Contenido de la representación
+ * @param len Tamaño del contenido
+ * @return Longitud escrita (como snprintf)
+ */
+int http_etag_format_hash(char *buf, size_t size, const void *data, size_t len);
+
+/**
+ * @brief Compara un ETag con el valor de If-None-Match
+ * @note Acepta listas separadas por comas, "*" y la comparación débil de RFC 9110
+ *       (un W/ en la petición no impide la coincidencia)
+ * @param if_none_match Valor de la cabecera (NULL = ausente)
+ * @param etag ETag actual entre comillas
+ * @return true si el cliente ya tiene esa representación (responder 304)
+ */
+bool http_etag_matches(const char *if_none_match, const char *etag);
+
+/**
+ * @brief Formatea una fecha HTTP (IMF-fixdate, siempre en GMT)
+ * @param buf Buffer de salida (HTTP_DATE_LEN bytes)
+ * @param size Tamaño del buffer
+ * @param epoch_ms Milisegundos desde 1970
+ * @return Longitud escrita, 0 si epoch_ms no es válido
+ */
+int http_date_format(char *buf, size_t size, int64_t epoch_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_CACHE_H
@@ -0,0 +1,95 @@
+// http_workers.h - Pool de tareas para respuestas HTTP largas (API asíncrona de httpd)
+#ifndef HTTP_WORKERS_H
+#define HTTP_WORKERS_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "latency_hist.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_WORKERS_MAX        4       // Tareas del pool como máximo
+
+// Handler que se ejecuta en una tarea del pool con la petición asíncrona
+typedef esp_err_t (*http_work_fn_t)(httpd_req_t *req);
+
+// Configuración del pool
+typedef struct {
+    uint8_t worker_count;         // Tareas (0 = los handlers se ejecutan en la tarea de httpd)
+    uint8_t queue_depth;          // Peticiones en espera antes de responder 503
+    int8_t core_id;               // Núcleo de las tareas (-1 = sin afinidad)
+    uint8_t priority;             // Prioridad FreeRTOS de las tareas
+    uint16_t stack_size;          // Pila de cada tarea en bytes
+} http_workers_config_t;
+
+#define HTTP_WORKERS_DEFAULT_CONFIG() { \
+    .worker_count = 2, \
+    .queue_depth = 8, \
+    .core_id = -1, \
+    .priority = 5, \
+    .stack_size = 4096 \
+}
+
+// Métricas del pool
+typedef struct {
+    uint8_t workers;              // Tareas en marcha
+    uint8_t busy;                 // Tareas ejecutando un handler
+    uint8_t queued;               // Peticiones en espera
+    uint8_t max_queued;           // Máximo de peticiones en espera observado
+    uint32_t submitted;           // Peticiones encoladas
+    uint32_t rejected;            // Rechazadas con la cola llena
+    uint32_t completed;           // Handlers terminados
+    uint32_t failed;              // Handlers que devolvieron error
+    latency_hist_t wait;          // Desde el encolado hasta que una tarea la toma
+    latency_hist_t service;       // Ejecución del handler (envío incluido)
+} http_workers_stats_t;
+
+/**
+ * @brief Crea la cola y las tareas del pool
+ * @param config Configuración
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si la configuración es inválida,
+ *         ESP_ERR_NO_MEM si no se pudo crear la cola o alguna tarea
+ */
+esp_err_t http_workers_start(const http_workers_config_t *config);
+
+/**
+ * @brief Detiene el pool tras atender las peticiones en cola
+ * @param timeout_ms Espera máxima a que terminen los handlers en curso
+ * @return ESP_OK si todas las tareas terminaron, ESP_ERR_TIMEOUT si no
+ */
+esp_err_t http_workers_stop(uint32_t timeout_ms);
+
+/**
+ * @brief Atiende una petición en el pool y libera la tarea de httpd
+ * @note Sin pool (worker_count = 0) el handler se ejecuta directamente. Con la cola
+ *       llena responde 503 con Retry-After y devuelve ESP_OK (la petición está atendida)
+ * @param req Petición recibida por el handler de httpd
+ * @param fn Handler que enviará la respuesta
+ * @return Resultado de httpd para la petición original
+ */
+esp_err_t http_workers_submit(httpd_req_t *req, http_work_fn_t fn);
+
+/**
+ * @brief Copia las métricas del pool
+ * @param stats Estructura donde almacenar las métricas
+ */
+void http_workers_get_stats(http_workers_stats_t *stats);
+
+/**
+ * @brief Serializa las métricas del pool como JSON
+ * @param stats Métricas obtenidas con http_workers_get_stats()
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita, o la necesaria si no cabe (como snprintf)
+ */
+int http_workers_stats_json(const http_workers_stats_t *stats, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_WORKERS_H
@@ -0,0 +1,51 @@
+// latency_hist.h - Histograma de latencias en cubos de potencias de dos
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_HIST_BUCKETS    16      // 64 us, 128 us ... 1 s y el resto
+#define LATENCY_HIST_MIN_US     64      // Límite superior del primer cubo
+
+// Histograma acumulado (sin bloqueos internos: el llamador lo protege)
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];  // Muestras en cada cubo (no acumuladas)
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t last_us;
+} latency_hist_t;
+
+/**
+ * @brief Añade una muestra
+ * @param hist Histograma
+ * @param us Latencia en microsegundos
+ */
+void latency_hist_record(latency_hist_t *hist, uint32_t us);
+
+/**
+ * @brief Límite superior de un cubo
+ * @param bucket Índice del cubo (0..LATENCY_HIST_BUCKETS-1)
+ * @return Microsegundos, UINT32_MAX para el último cubo (sin límite)
+ */
+uint32_t latency_hist_bucket_le(int bucket);
+
+/**
+ * @brief Percentil aproximado por el límite superior de su cubo
+ * @note Nunca devuelve más que el máximo observado: en el último cubo y en cubos
+ *       poco poblados el máximo es una cota más ajustada
+ * @param hist Histograma
+ * @param percent Percentil (1-100)
+ * @return Microsegundos, 0 sin muestras
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_HIST_H
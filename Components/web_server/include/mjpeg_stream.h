@@ -0,0 +1,136 @@
+// mjpeg_stream.h - Registro de clientes del stream MJPEG (multipart/x-mixed-replace)
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MJPEG_STREAM_BOUNDARY       "coopframe"
+#define MJPEG_STREAM_CONTENT_TYPE   "multipart/x-mixed-replace;boundary=" MJPEG_STREAM_BOUNDARY
+#ifndef MJPEG_STREAM_MAX_CLIENTS
+#define MJPEG_STREAM_MAX_CLIENTS    8       // Capacidad del registro (config.max_clients <= este valor)
+#endif
+#define MJPEG_STREAM_MAX_FPS        30
+#define MJPEG_STREAM_PART_HEADER_MAX 128    // Tamaño suficiente para mjpeg_stream_part_header()
+
+// Configuración del stream
+typedef struct {
+    uint8_t max_clients;          // Clientes simultáneos (cada uno ocupa un socket y una tarea)
+    uint8_t fps;                  // Frames por segundo como máximo por cliente
+} mjpeg_stream_config_t;
+
+#define MJPEG_STREAM_DEFAULT_CONFIG() { \
+    .max_clients = 3, \
+    .fps = 5 \
+}
+
+// Contadores de un cliente
+typedef struct {
+    uint32_t sent;                // Frames enviados completos
+    uint32_t dropped;             // Frames perdidos porque el cliente tardaba en recibir el anterior
+    uint32_t skipped;             // Frames omitidos por el límite de fps
+    uint64_t bytes;               // Bytes JPEG enviados
+    uint32_t last_send_us;        // Duración del último envío
+    uint32_t max_send_us;
+} mjpeg_client_stats_t;
+
+// Cliente conectado
+typedef struct {
+    bool in_use;
+    uint32_t id;                  // Identificador creciente (1, 2, 3...)
+    uint64_t connected_at;        // Momento de conexión (microsegundos)
+    uint32_t last_published;      // Contador de frames publicados al adquirir el último enviado
+    mjpeg_client_stats_t stats;
+} mjpeg_client_t;
+
+// Registro de clientes (sin bloqueos internos: el llamador lo protege)
+typedef struct {
+    mjpeg_stream_config_t config;
+    mjpeg_client_t clients[MJPEG_STREAM_MAX_CLIENTS];
+    uint8_t active;               // Clientes conectados
+    uint32_t total;               // Conexiones aceptadas desde el inicio
+    uint32_t rejected;            // Conexiones rechazadas por max_clients
+} mjpeg_stream_t;
+
+/**
+ * @brief Inicializa el registro vacío
+ * @param stream Registro
+ * @param config Configuración
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si max_clients o fps están fuera de rango
+ */
+esp_err_t mjpeg_stream_init(mjpeg_stream_t *stream, const mjpeg_stream_config_t *config);
+
+/**
+ * @brief Periodo entre frames de un cliente
+ * @param stream Registro
+ * @return Microsegundos entre frames según config.fps
+ */
+uint32_t mjpeg_stream_period_us(const mjpeg_stream_t *stream);
+
+/**
+ * @brief Reserva un hueco para un cliente nuevo
+ * @param stream Registro
+ * @param now Momento actual (microsegundos)
+ * @return Cliente o NULL si ya hay max_clients conectados (cuenta como rechazo)
+ */
+mjpeg_client_t* mjpeg_stream_claim(mjpeg_stream_t *stream, uint64_t now);
+
+/**
+ * @brief Libera el hueco de un cliente desconectado
+ * @param stream Registro
+ * @param client Cliente obtenido con mjpeg_stream_claim()
+ */
+void mjpeg_stream_release(mjpeg_stream_t *stream, mjpeg_client_t *client);
+
+/**
+ * @brief Indica si hay un frame más reciente que el último enviado al cliente
+ * @param client Cliente
+ * @param published Contador de frames publicados por la fuente
+ * @return true si published avanzó desde el último envío
+ */
+bool mjpeg_client_has_new(const mjpeg_client_t *client, uint32_t published);
+
+/**
+ * @brief Registra un frame enviado y clasifica los que el cliente no llegó a ver
+ * @note Los frames publicados entre dos envíos se cuentan como dropped si el envío
+ *       anterior duró más que el periodo (cliente lento) y como skipped si no (fps)
+ * @param client Cliente
+ * @param published Contador de frames publicados al adquirir el frame enviado
+ * @param period_us Periodo entre frames (mjpeg_stream_period_us())
+ * @param bytes Bytes JPEG enviados
+ * @param send_us Duración del envío
+ */
+void mjpeg_client_account(mjpeg_client_t *client, uint32_t published, uint32_t period_us,
+                          size_t bytes, uint32_t send_us);
+
+/**
+ * @brief Cabecera de una parte del multipart (delimitador incluido)
+ * @param buf Buffer de salida (MJPEG_STREAM_PART_HEADER_MAX bytes bastan)
+ * @param size Tamaño del buffer
+ * @param len Tamaño del JPEG
+ * @param timestamp Momento de captura (microsegundos)
+ * @param seq Número de secuencia del frame
+ * @return Longitud escrita, o la necesaria si no cabe (como snprintf)
+ */
+int mjpeg_stream_part_header(char *buf, size_t size, size_t len, uint64_t timestamp, uint32_t seq);
+
+/**
+ * @brief Serializa el registro y los contadores por cliente como JSON
+ * @param stream Registro
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita, o la necesaria si no cabe (como snprintf)
+ */
+int mjpeg_stream_stats_json(const mjpeg_stream_t *stream, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJPEG_STREAM_H
@@ -0,0 +1,143 @@
+// rate_limit.h - Admisión por cliente: cubetas de tokens por dirección IP para fotos y /stream
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RATE_LIMIT_MAX_CLIENTS
+#define RATE_LIMIT_MAX_CLIENTS      16      // Direcciones seguidas (la menos reciente se reutiliza)
+#endif
+#define RATE_LIMIT_ADDR_LEN         16      // IPv6; las IPv4 se guardan como ::ffff:a.b.c.d
+#define RATE_LIMIT_MAX_BURST        60
+
+// Rutas con cubeta propia
+typedef enum {
+    RATE_LIMIT_PHOTO,             // /photo, /photo/thumb y /photo/preroll
+    RATE_LIMIT_STREAM,            // Conexiones nuevas a /stream
+    RATE_LIMIT_HISTORY,           // /photo/{seq}: un cliente que se pone al día lee muchas seguidas
+    RATE_LIMIT_CLASS_COUNT
+} rate_limit_class_t;
+
+// Cubeta de una ruta
+typedef struct {
+    uint8_t burst;                // Peticiones seguidas admitidas con la cubeta llena
+    uint16_t per_minute;          // Ritmo sostenido de recarga (0 = sin límite)
+} rate_limit_bucket_config_t;
+
+// Configuración del limitador
+typedef struct {
+    rate_limit_bucket_config_t classes[RATE_LIMIT_CLASS_COUNT];
+} rate_limit_config_t;
+
+// Tres pestañas sondeando /photo cada 3 s caben de sobra; un bucle de recargas no.
+// El historial admite ponerse al día a 5 fotos por segundo tras una ráfaga de 60
+#define RATE_LIMIT_DEFAULT_CONFIG() { \
+    .classes = { \
+        [RATE_LIMIT_PHOTO] = { .burst = 10, .per_minute = 60 }, \
+        [RATE_LIMIT_STREAM] = { .burst = 4, .per_minute = 6 }, \
+        [RATE_LIMIT_HISTORY] = { .burst = 60, .per_minute = 300 } \
+    } \
+}
+
+// Cliente seguido: una cubeta por ruta, en milésimas de token
+typedef struct {
+    bool in_use;
+    uint8_t addr[RATE_LIMIT_ADDR_LEN];
+    uint64_t last_seen;                           // Última petición (microsegundos)
+    uint32_t tokens[RATE_LIMIT_CLASS_COUNT];
+    uint64_t refilled_at[RATE_LIMIT_CLASS_COUNT];
+} rate_limit_client_t;
+
+// Contadores por ruta
+typedef struct {
+    uint32_t allowed;
+    uint32_t rejected;
+    uint32_t refunded;            // Tokens devueltos por respuestas 304 sin cuerpo
+} rate_limit_class_stats_t;
+
+// Limitador (sin bloqueos internos: el llamador lo protege)
+typedef struct {
+    rate_limit_config_t config;
+    rate_limit_client_t clients[RATE_LIMIT_MAX_CLIENTS];
+    uint8_t active;                               // Direcciones seguidas
+    uint32_t evicted;                             // Direcciones olvidadas para hacer sitio
+    rate_limit_class_stats_t stats[RATE_LIMIT_CLASS_COUNT];
+} rate_limit_t;
+
+// Contadores del limitador sin la tabla de clientes (copia breve bajo el lock del llamador)
+typedef struct {
+    rate_limit_config_t config;
+    uint8_t active;
+    uint32_t evicted;
+    rate_limit_class_stats_t classes[RATE_LIMIT_CLASS_COUNT];
+} rate_limit_stats_t;
+
+/**
+ * @brief Inicializa el limitador sin clientes
+ * @param limiter Limitador
+ * @param config Configuración
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si una ruta limitada no admite ráfaga
+ *         o la ráfaga supera RATE_LIMIT_MAX_BURST
+ */
+esp_err_t rate_limit_init(rate_limit_t *limiter, const rate_limit_config_t *config);
+
+/**
+ * @brief Decide si se admite una petición y consume su token
+ * @note O(RATE_LIMIT_MAX_CLIENTS) sin reservas. Una dirección nueva empieza con las
+ *       cubetas llenas; sin hueco se olvida la que lleva más tiempo sin pedir nada
+ * @param limiter Limitador
+ * @param addr Dirección del cliente (RATE_LIMIT_ADDR_LEN bytes)
+ * @param cls Ruta pedida
+ * @param now Momento actual (microsegundos)
+ * @param retry_after_s Salida opcional: segundos hasta el siguiente token si se rechaza
+ * @return true si se admite, false si la cubeta está vacía
+ */
+bool rate_limit_allow(rate_limit_t *limiter, const uint8_t *addr, rate_limit_class_t cls,
+                      uint64_t now, uint32_t *retry_after_s);
+
+/**
+ * @brief Devuelve el token de una petición admitida que no envió cuerpo (304)
+ * @note Una revalidación que acierta no cuenta contra el ritmo del cliente. No hace nada
+ *       si la dirección ya no está en la tabla; la cubeta nunca pasa de burst
+ * @param limiter Limitador
+ * @param addr Dirección del cliente (RATE_LIMIT_ADDR_LEN bytes)
+ * @param cls Ruta pedida
+ */
+void rate_limit_refund(rate_limit_t *limiter, const uint8_t *addr, rate_limit_class_t cls);
+
+/**
+ * @brief Nombre de una ruta para /status y /metrics
+ * @param cls Ruta
+ * @return "photo", "stream", "history" o "unknown"
+ */
+const char* rate_limit_class_name(rate_limit_class_t cls);
+
+/**
+ * @brief Copia los contadores del limitador
+ * @note Solo copia: el llamador la hace con su lock tomado y formatea después
+ * @param limiter Limitador
+ * @param stats Copia de salida
+ */
+void rate_limit_get_stats(const rate_limit_t *limiter, rate_limit_stats_t *stats);
+
+/**
+ * @brief Escribe los contadores del limitador como JSON para /status
+ * @param stats Copia obtenida con rate_limit_get_stats()
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita, o la necesaria si no cabe (como snprintf)
+ */
+int rate_limit_stats_json(const rate_limit_stats_t *stats, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RATE_LIMIT_H
@@ -0,0 +1,130 @@
+// server_events.h - Eventos que sensor y cámara envían al servidor web, en registros compactos
+#ifndef SERVER_EVENTS_H
+#define SERVER_EVENTS_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SERVER_EVENT_QUEUE_DEPTH    32      // Eventos en cola antes de descartar (24 bytes cada uno)
+#define SERVER_EVENTS_BATCH_MAX     16      // Eventos aplicados por cada vaciado de la cola
+
+// Tipos de eventos que el servidor puede recibir
+typedef enum {
+    SERVER_EVENT_DETECTION_STARTED,
+    SERVER_EVENT_DETECTION_ENDED,
+    SERVER_EVENT_PHOTO_TAKEN
+} server_event_type_t;
+
+// Mensaje de la cola del servidor: tamaño fijo, sin cadenas (la razón de la foto viaja
+// como camera_capture_reason_t y se traduce a texto solo al serializar para /events)
+typedef struct {
+    uint64_t timestamp;           // Momento del evento en origen (esp_timer, microsegundos)
+    uint32_t id;                  // Id del diario (lo asigna server_events_post(); 0 = sin diario)
+    uint8_t type;                 // server_event_type_t
+    uint8_t reason;               // camera_capture_reason_t (SERVER_EVENT_PHOTO_TAKEN)
+    int8_t sensor_state;          // Nivel del pin del sensor (-1 = no viene del sensor)
+    bool object_detected;
+
+    // Datos específicos según el tipo de evento
+    union {
+        struct {
+            uint32_t detection_count;
+        } detection_data;
+
+        struct {
+            uint32_t seq;             // Secuencia en el almacén (/photo/{seq})
+            uint32_t photo_size;
+        } photo_data;
+    };
+} server_event_t;
+
+_Static_assert(sizeof(server_event_t) == 24, "server_event_t debe seguir siendo un registro compacto");
+
+// Métrica común de quienes envían eventos a la cola del servidor (etiqueta source)
+#define SERVER_EVENT_DROPPED_METRIC     "coop_server_event_dropped_total"
+#define SERVER_EVENT_DROPPED_HELP       "Eventos descartados sin esperar con la cola del servidor web llena"
+
+// Estado interno del servidor (cache)
+typedef struct {
+    bool initialized;
+    uint32_t total_detections;
+    bool object_currently_detected;
+    int current_sensor_state;
+    bool has_photo_available;
+    uint64_t last_update_time;
+} server_state_t;
+
+// Contadores de la cola del servidor
+typedef struct {
+    uint32_t posted;              // Eventos encolados
+    uint32_t dropped;             // Eventos descartados con la cola llena (todas las fuentes)
+    uint32_t processed;           // Eventos aplicados por la tarea del servidor
+    uint32_t batches;             // Vaciados con al menos un evento
+    uint32_t max_batch;           // Mayor número de eventos de un vaciado
+} server_events_stats_t;
+
+/**
+ * @brief Anota un evento en el diario y lo encola sin esperar nunca
+ * @note Seguro desde cualquier tarea o timer. Con la cola llena el evento se descarta y
+ *       se cuenta en dropped: una ráfaga de detecciones no puede frenar a la tarea del
+ *       sensor. Aun así queda en el diario (/events/history), aunque no llegue al estado
+ *       ni a /events
+ * @param queue Cola del servidor (web_server_get_event_queue())
+ * @param event Evento a copiar en la cola
+ * @return ESP_OK, ESP_ERR_INVALID_ARG sin cola o ESP_ERR_TIMEOUT si estaba llena
+ */
+esp_err_t server_events_post(QueueHandle_t queue, const server_event_t *event);
+
+/**
+ * @brief Espera el primer evento y vacía a continuación todos los pendientes
+ * @param queue Cola del servidor
+ * @param batch Destino de los eventos
+ * @param max Capacidad de batch
+ * @param wait Espera máxima del primer evento
+ * @return Eventos copiados (0 si no llegó ninguno)
+ */
+size_t server_events_drain(QueueHandle_t queue, server_event_t *batch, size_t max, TickType_t wait);
+
+/**
+ * @brief Aplica un lote de eventos al estado en orden de llegada
+ * @note Pensado para aplicarse sobre una copia que luego se publica de una vez
+ * @param state Estado a actualizar
+ * @param events Eventos del lote
+ * @param count Número de eventos
+ * @return Eventos de tipo desconocido ignorados
+ */
+size_t server_events_apply(server_state_t *state, const server_event_t *events, size_t count);
+
+/**
+ * @brief Serializa un evento como JSON compacto para /events
+ * @param event Evento a serializar
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Nombre del evento SSE o NULL si el tipo es desconocido
+ */
+const char* server_event_json(const server_event_t *event, char *buf, size_t size);
+
+/**
+ * @brief Obtiene los contadores de la cola del servidor
+ * @return Estructura con estadísticas
+ */
+server_events_stats_t server_events_get_stats(void);
+
+/**
+ * @brief Reinicia los contadores de la cola del servidor
+ */
+void server_events_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVER_EVENTS_H
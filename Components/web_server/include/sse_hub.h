@@ -0,0 +1,129 @@
+// sse_hub.h - Reparto de eventos a los clientes de /events (Server-Sent Events)
+#ifndef SSE_HUB_H
+#define SSE_HUB_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SSE_CONTENT_TYPE        "text/event-stream"
+#ifndef SSE_HUB_MAX_CLIENTS
+#define SSE_HUB_MAX_CLIENTS     4       // Capacidad del registro (config.max_clients <= este valor)
+#endif
+#define SSE_HUB_BACKLOG         8       // Eventos pendientes por cliente antes de descartar
+#define SSE_EVENT_MAX_LEN       192     // Evento SSE completo (id, event, data y línea en blanco)
+
+// Configuración del reparto
+typedef struct {
+    uint8_t max_clients;          // Clientes simultáneos (cada uno ocupa un socket y una tarea)
+} sse_hub_config_t;
+
+#define SSE_HUB_DEFAULT_CONFIG() { \
+    .max_clients = 3 \
+}
+
+// Evento ya serializado en formato SSE
+typedef struct {
+    uint64_t timestamp;           // Momento del evento en origen (microsegundos)
+    uint16_t len;
+    char text[SSE_EVENT_MAX_LEN];
+} sse_entry_t;
+
+// Contadores de un cliente
+typedef struct {
+    uint32_t sent;                // Eventos enviados
+    uint32_t dropped;             // Eventos descartados con el backlog lleno (los más antiguos)
+    uint32_t last_latency_us;     // Desde el evento en origen hasta terminar su envío
+    uint32_t max_latency_us;
+} sse_client_stats_t;
+
+// Cliente conectado: cola circular de eventos pendientes
+typedef struct {
+    bool in_use;
+    uint32_t id;                  // Identificador creciente (1, 2, 3...)
+    void *owner;                  // Dato del llamador (la tarea que atiende al cliente)
+    uint8_t head;                 // Siguiente evento a enviar
+    uint8_t count;                // Eventos pendientes
+    sse_entry_t backlog[SSE_HUB_BACKLOG];
+    sse_client_stats_t stats;
+} sse_client_t;
+
+// Registro de clientes (sin bloqueos internos: el llamador lo protege)
+typedef struct {
+    sse_hub_config_t config;
+    sse_client_t clients[SSE_HUB_MAX_CLIENTS];
+    uint8_t active;               // Clientes conectados
+    uint32_t total;               // Conexiones aceptadas desde el inicio
+    uint32_t rejected;            // Conexiones rechazadas por max_clients
+    uint32_t published;           // Eventos publicados (también es el último id SSE)
+    uint32_t oversized;           // Eventos que no cabían en SSE_EVENT_MAX_LEN
+} sse_hub_t;
+
+/**
+ * @brief Inicializa el registro vacío
+ * @param hub Registro
+ * @param config Configuración
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG si max_clients está fuera de rango
+ */
+esp_err_t sse_hub_init(sse_hub_t *hub, const sse_hub_config_t *config);
+
+/**
+ * @brief Reserva un hueco para un cliente nuevo
+ * @param hub Registro
+ * @return Cliente o NULL si ya hay max_clients conectados (cuenta como rechazo)
+ */
+sse_client_t* sse_hub_claim(sse_hub_t *hub);
+
+/**
+ * @brief Libera el hueco de un cliente desconectado (descarta sus pendientes)
+ * @param hub Registro
+ * @param client Cliente obtenido con sse_hub_claim()
+ */
+void sse_hub_release(sse_hub_t *hub, sse_client_t *client);
+
+/**
+ * @brief Serializa un evento y lo encola en todos los clientes conectados
+ * @note Con el backlog de un cliente lleno se descarta su evento más antiguo: el
+ *       cliente lento pierde historia, nunca el estado más reciente
+ * @param hub Registro
+ * @param event Nombre del evento (campo "event:")
+ * @param data JSON de una sola línea (campo "data:")
+ * @param timestamp Momento del evento en origen (microsegundos)
+ * @return Id SSE asignado, 0 si el evento no cabe en SSE_EVENT_MAX_LEN
+ */
+uint32_t sse_hub_publish(sse_hub_t *hub, const char *event, const char *data, uint64_t timestamp);
+
+/**
+ * @brief Extrae el evento pendiente más antiguo de un cliente
+ * @param client Cliente
+ * @param entry Estructura donde copiar el evento (se envía fuera del bloqueo)
+ * @return true si había un evento pendiente
+ */
+bool sse_client_pop(sse_client_t *client, sse_entry_t *entry);
+
+/**
+ * @brief Registra un evento enviado
+ * @param client Cliente
+ * @param latency_us Desde el evento en origen hasta terminar su envío
+ */
+void sse_client_account(sse_client_t *client, uint32_t latency_us);
+
+/**
+ * @brief Serializa el registro y los contadores por cliente como JSON
+ * @param hub Registro
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @return Longitud escrita, o la necesaria si no cabe (como snprintf)
+ */
+int sse_hub_stats_json(const sse_hub_t *hub, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SSE_HUB_H
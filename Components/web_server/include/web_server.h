@@ -3,6 +3,11 @@
 
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "mjpeg_stream.h"
+#include "sse_hub.h"
+#include "http_workers.h"
+#include "rate_limit.h"
+#include "server_events.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include <stdint.h>
@@ -12,58 +17,45 @@
 extern "C" {
 #endif
 
-// Tipos de eventos que el servidor puede recibir
-typedef enum {
-    SERVER_EVENT_DETECTION_STARTED,
-    SERVER_EVENT_DETECTION_ENDED,
-    SERVER_EVENT_PHOTO_TAKEN
-} server_event_type_t;
-
-// Estructura de mensaje para la cola del servidor
-typedef struct {
-    server_event_type_t type;
-    uint64_t timestamp;
-    
-    // Estados del sensor (siempre presentes cuando viene del sensor)
-    bool object_detected;
-    int sensor_state;
-    
-    // Datos específicos según el tipo de evento
-    union {
-        struct {
-            uint32_t detection_count;
-        } detection_data;
-        
-        struct {
-            size_t photo_size;
-            char reason[32];
-        } photo_data;
-    };
-} server_event_t;
-
-// Estado interno del servidor (cache)
-typedef struct {
-    bool initialized;
-    uint32_t total_detections;
-    bool object_currently_detected;
-    int current_sensor_state;
-    bool has_photo_available;
-    uint64_t last_update_time;
-} server_state_t;
-
 // Configuración del servidor
 typedef struct {
     uint16_t port;
     size_t max_uri_handlers;
     size_t max_resp_headers;
     bool enable_cors;
+    uint8_t stream_max_clients;   // Clientes simultáneos de /stream (1-MJPEG_STREAM_MAX_CLIENTS)
+    uint8_t stream_fps;           // Frames por segundo como máximo por cliente de /stream
+    uint8_t events_max_clients;   // Clientes simultáneos de /events (1-SSE_HUB_MAX_CLIENTS)
+    uint8_t worker_count;         // Tareas que envían /photo y /photo/thumb (0-HTTP_WORKERS_MAX, 0 = en httpd)
+    uint8_t worker_queue_depth;   // Envíos en espera antes de responder 503
+    int8_t worker_core;           // Núcleo de esas tareas (-1 = sin afinidad)
+    uint16_t journal_capacity;    // Eventos retenidos para /events/history (24 bytes cada uno; 0 = sin diario)
+    uint8_t photo_burst;          // Fotos seguidas por dirección IP (/photo, /photo/thumb, /photo/preroll)
+    uint16_t photo_per_minute;    // Fotos por minuto sostenidas por dirección IP (0 = sin límite)
+    uint8_t stream_burst;         // Conexiones seguidas a /stream por dirección IP
+    uint16_t stream_per_minute;   // Conexiones por minuto a /stream por dirección IP (0 = sin límite)
+    uint8_t history_burst;        // Lecturas seguidas de /photo/{seq} por dirección IP
+    uint16_t history_per_minute;  // Lecturas por minuto de /photo/{seq} por dirección IP (0 = sin límite)
 } server_config_t;
 
 #define SERVER_DEFAULT_CONFIG() { \
     .port = 80, \
-    .max_uri_handlers = 8, \
-    .max_resp_headers = 8, \
-    .enable_cors = false \
+    .max_uri_handlers = 16, \
+    .max_resp_headers = 12, \
+    .enable_cors = false, \
+    .stream_max_clients = 3, \
+    .stream_fps = 5, \
+    .events_max_clients = 3, \
+    .worker_count = 2, \
+    .worker_queue_depth = 8, \
+    .worker_core = -1, \
+    .journal_capacity = 512, \
+    .photo_burst = 10, \
+    .photo_per_minute = 60, \
+    .stream_burst = 4, \
+    .stream_per_minute = 6, \
+    .history_burst = 60, \
+    .history_per_minute = 300 \
 }
 
 /**
@@ -115,6 +107,20 @@ server_state_t web_server_get_state(void);
  */
 bool web_server_is_running(void);
 
+/**
+ * @brief Copia el registro de clientes de /stream con sus contadores
+ * @param stream Estructura donde almacenar la copia
+ */
+void web_server_get_stream_stats(mjpeg_stream_t *stream);
+
+/**
+ * @brief Copia los contadores de los clientes conectados a /events
+ * @param stats Array donde almacenar los contadores
+ * @param max_clients Capacidad del array
+ * @return Número de clientes copiados
+ */
+uint8_t web_server_get_events_stats(sse_client_stats_t *stats, uint8_t max_clients);
+
 esp_err_t sensor_e18_set_server_queue(QueueHandle_t queue);
 #ifdef __cplusplus
 }
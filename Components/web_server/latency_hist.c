@@ -0,0 +1,47 @@
+// latency_hist.c - Responsabilidad única: acumular latencias con memoria y coste fijos
+//
+// Con cubos de potencias de dos el error de un percentil es como mucho el doble del valor
+// real, suficiente para distinguir 1 ms de 100 ms, y registrar una muestra es un recorrido
+// de 16 comparaciones sin asignar memoria.
+#include "latency_hist.h"
+
+void latency_hist_record(latency_hist_t *hist, uint32_t us) {
+    int bucket = 0;
+    while (bucket < LATENCY_HIST_BUCKETS - 1 && us > latency_hist_bucket_le(bucket)) {
+        bucket++;
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_us += us;
+    hist->last_us = us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+uint32_t latency_hist_bucket_le(int bucket) {
+    if (bucket >= LATENCY_HIST_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)LATENCY_HIST_MIN_US << bucket;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent) {
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    // Muestras que deben quedar por debajo del percentil (redondeando hacia arriba)
+    uint64_t rank = ((uint64_t)hist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int bucket = 0; bucket < LATENCY_HIST_BUCKETS; bucket++) {
+        seen += hist->buckets[bucket];
+        if (seen >= rank) {
+            uint32_t le = latency_hist_bucket_le(bucket);
+            return le < hist->max_us ? le : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
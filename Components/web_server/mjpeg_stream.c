@@ -0,0 +1,120 @@
+// mjpeg_stream.c - Responsabilidad única: registro y contabilidad de clientes del stream MJPEG
+//
+// Cada cliente no tiene cola: en cada periodo toma el frame más reciente de la fuente y
+// lo envía entero. Un cliente lento solo retrasa su propio bucle, y al terminar salta
+// directamente al último frame; los intermedios nunca se copian ni se retienen. Como
+// no hay cola, los frames perdidos se deducen del contador de frames publicados.
+#include "mjpeg_stream.h"
+#include <stdio.h>
+#include <string.h>
+
+esp_err_t mjpeg_stream_init(mjpeg_stream_t *stream, const mjpeg_stream_config_t *config) {
+    if (stream == NULL || config == NULL ||
+        config->max_clients == 0 || config->max_clients > MJPEG_STREAM_MAX_CLIENTS ||
+        config->fps == 0 || config->fps > MJPEG_STREAM_MAX_FPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    stream->config = *config;
+    return ESP_OK;
+}
+
+uint32_t mjpeg_stream_period_us(const mjpeg_stream_t *stream) {
+    return 1000000 / stream->config.fps;
+}
+
+mjpeg_client_t* mjpeg_stream_claim(mjpeg_stream_t *stream, uint64_t now) {
+    if (stream->active >= stream->config.max_clients) {
+        stream->rejected++;
+        return NULL;
+    }
+
+    for (int i = 0; i < MJPEG_STREAM_MAX_CLIENTS; i++) {
+        mjpeg_client_t *client = &stream->clients[i];
+        if (!client->in_use) {
+            memset(client, 0, sizeof(*client));
+            client->in_use = true;
+            client->id = ++stream->total;
+            client->connected_at = now;
+            stream->active++;
+            return client;
+        }
+    }
+
+    stream->rejected++;
+    return NULL;
+}
+
+void mjpeg_stream_release(mjpeg_stream_t *stream, mjpeg_client_t *client) {
+    if (client == NULL || !client->in_use) {
+        return;
+    }
+    client->in_use = false;
+    stream->active--;
+}
+
+bool mjpeg_client_has_new(const mjpeg_client_t *client, uint32_t published) {
+    return published != client->last_published;
+}
+
+void mjpeg_client_account(mjpeg_client_t *client, uint32_t published, uint32_t period_us,
+                          size_t bytes, uint32_t send_us) {
+    mjpeg_client_stats_t *stats = &client->stats;
+
+    // El primer frame no tiene anterior con el que comparar
+    if (stats->sent > 0 && published - client->last_published > 1) {
+        uint32_t missed = published - client->last_published - 1;
+        if (stats->last_send_us > period_us) {
+            stats->dropped += missed;
+        } else {
+            stats->skipped += missed;
+        }
+    }
+
+    client->last_published = published;
+    stats->sent++;
+    stats->bytes += bytes;
+    stats->last_send_us = send_us;
+    if (send_us > stats->max_send_us) {
+        stats->max_send_us = send_us;
+    }
+}
+
+int mjpeg_stream_part_header(char *buf, size_t size, size_t len, uint64_t timestamp, uint32_t seq) {
+    return snprintf(buf, size,
+        "--" MJPEG_STREAM_BOUNDARY "\r\n"
+        "Content-Type: image/jpeg\r\n"
+        "Content-Length: %u\r\n"
+        "X-Timestamp: %llu\r\n"
+        "X-Frame-Seq: %lu\r\n"
+        "\r\n",
+        (unsigned)len, (unsigned long long)timestamp, (unsigned long)seq);
+}
+
+int mjpeg_stream_stats_json(const mjpeg_stream_t *stream, char *buf, size_t size) {
+    int len = snprintf(buf, size,
+        "{\"clients\":%u,\"max_clients\":%u,\"fps\":%u,\"total\":%lu,\"rejected\":%lu,\"per_client\":[",
+        stream->active, stream->config.max_clients, stream->config.fps,
+        (unsigned long)stream->total, (unsigned long)stream->rejected);
+    bool first = true;
+
+    for (int i = 0; i < MJPEG_STREAM_MAX_CLIENTS; i++) {
+        const mjpeg_client_t *client = &stream->clients[i];
+        if (!client->in_use) {
+            continue;
+        }
+        const mjpeg_client_stats_t *stats = &client->stats;
+        len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0,
+            "%s{\"id\":%lu,\"sent\":%lu,\"dropped\":%lu,\"skipped\":%lu,\"bytes\":%llu,"
+            "\"last_send_us\":%lu,\"max_send_us\":%lu}",
+            first ? "" : ",", (unsigned long)client->id, (unsigned long)stats->sent,
+            (unsigned long)stats->dropped, (unsigned long)stats->skipped,
+            (unsigned long long)stats->bytes, (unsigned long)stats->last_send_us,
+            (unsigned long)stats->max_send_us);
+        first = false;
+    }
+
+    len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0, "]}");
+    return len;
+}
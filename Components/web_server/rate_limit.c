@@ -0,0 +1,184 @@
+// rate_limit.c - Responsabilidad única: cubetas de tokens por cliente para la admisión HTTP
+//
+// Cada dirección tiene una cubeta por ruta que se recarga de forma continua según el
+// tiempo transcurrido (no hay temporizador: la recarga se calcula al consultar). Los
+// tokens se cuentan en milésimas para que ritmos de pocas peticiones por minuto no se
+// pierdan por redondeo. La tabla es fija: una dirección nueva reutiliza el hueco de la
+// que lleva más tiempo sin pedir nada.
+#include "rate_limit.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TOKEN               1000ULL         // Milésimas de token por petición
+#define US_PER_MINUTE       60000000ULL
+
+static const char *class_names[RATE_LIMIT_CLASS_COUNT] = {
+    [RATE_LIMIT_PHOTO] = "photo",
+    [RATE_LIMIT_STREAM] = "stream",
+    [RATE_LIMIT_HISTORY] = "history",
+};
+
+esp_err_t rate_limit_init(rate_limit_t *limiter, const rate_limit_config_t *config) {
+    if (limiter == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < RATE_LIMIT_CLASS_COUNT; i++) {
+        const rate_limit_bucket_config_t *bucket = &config->classes[i];
+        if ((bucket->per_minute > 0 && bucket->burst == 0) || bucket->burst > RATE_LIMIT_MAX_BURST) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memset(limiter, 0, sizeof(*limiter));
+    limiter->config = *config;
+    return ESP_OK;
+}
+
+// Busca la dirección; si no está, ocupa un hueco libre o el del cliente menos reciente
+static rate_limit_client_t* find_or_claim(rate_limit_t *limiter, const uint8_t *addr, uint64_t now) {
+    rate_limit_client_t *free_slot = NULL;
+    rate_limit_client_t *oldest = NULL;
+
+    for (int i = 0; i < RATE_LIMIT_MAX_CLIENTS; i++) {
+        rate_limit_client_t *client = &limiter->clients[i];
+        if (!client->in_use) {
+            if (free_slot == NULL) {
+                free_slot = client;
+            }
+            continue;
+        }
+        if (memcmp(client->addr, addr, RATE_LIMIT_ADDR_LEN) == 0) {
+            return client;
+        }
+        if (oldest == NULL || client->last_seen < oldest->last_seen) {
+            oldest = client;
+        }
+    }
+
+    rate_limit_client_t *client = free_slot;
+    if (client == NULL) {
+        client = oldest;
+        limiter->evicted++;
+    } else {
+        limiter->active++;
+    }
+
+    // Cubetas llenas: una dirección nueva (u olvidada) no arrastra deuda
+    client->in_use = true;
+    memcpy(client->addr, addr, RATE_LIMIT_ADDR_LEN);
+    for (int i = 0; i < RATE_LIMIT_CLASS_COUNT; i++) {
+        client->tokens[i] = limiter->config.classes[i].burst * TOKEN;
+        client->refilled_at[i] = now;
+    }
+    return client;
+}
+
+// Recarga continua: solo se descuenta el tiempo convertido en tokens enteros (milésimas),
+// así el resto no se pierde aunque se consulte muy a menudo
+static void refill(rate_limit_client_t *client, int cls, const rate_limit_bucket_config_t *bucket, uint64_t now) {
+    uint64_t capacity = bucket->burst * TOKEN;
+
+    if (now <= client->refilled_at[cls]) {
+        return;
+    }
+    if (client->tokens[cls] >= capacity) {
+        client->refilled_at[cls] = now;
+        return;
+    }
+
+    // Pasados RATE_LIMIT_MAX_BURST minutos cualquier cubeta está llena (y el cálculo no desborda)
+    uint64_t elapsed = now - client->refilled_at[cls];
+    if (elapsed >= RATE_LIMIT_MAX_BURST * US_PER_MINUTE) {
+        client->tokens[cls] = capacity;
+        client->refilled_at[cls] = now;
+        return;
+    }
+    uint64_t gained = elapsed * bucket->per_minute * TOKEN / US_PER_MINUTE;
+    if (client->tokens[cls] + gained >= capacity) {
+        client->tokens[cls] = capacity;
+        client->refilled_at[cls] = now;
+    } else {
+        client->tokens[cls] += gained;
+        client->refilled_at[cls] += gained * US_PER_MINUTE / (bucket->per_minute * TOKEN);
+    }
+}
+
+bool rate_limit_allow(rate_limit_t *limiter, const uint8_t *addr, rate_limit_class_t cls,
+                      uint64_t now, uint32_t *retry_after_s) {
+    if (cls >= RATE_LIMIT_CLASS_COUNT) {
+        return true;
+    }
+    const rate_limit_bucket_config_t *bucket = &limiter->config.classes[cls];
+    rate_limit_class_stats_t *stats = &limiter->stats[cls];
+
+    if (bucket->per_minute == 0) {
+        stats->allowed++;
+        return true;
+    }
+
+    rate_limit_client_t *client = find_or_claim(limiter, addr, now);
+    client->last_seen = now;
+    refill(client, cls, bucket, now);
+
+    if (client->tokens[cls] >= TOKEN) {
+        client->tokens[cls] -= TOKEN;
+        stats->allowed++;
+        return true;
+    }
+
+    stats->rejected++;
+    if (retry_after_s != NULL) {
+        // Lo que falta para un token entero, descontando lo ya transcurrido desde la recarga
+        uint64_t missing_us = (TOKEN - client->tokens[cls]) * US_PER_MINUTE / (bucket->per_minute * TOKEN);
+        uint64_t waited_us = now - client->refilled_at[cls];
+        uint64_t wait_us = missing_us > waited_us ? missing_us - waited_us : 0;
+        uint32_t seconds = (uint32_t)((wait_us + 999999) / 1000000);
+        *retry_after_s = seconds > 0 ? seconds : 1;
+    }
+    return false;
+}
+
+void rate_limit_refund(rate_limit_t *limiter, const uint8_t *addr, rate_limit_class_t cls) {
+    if (cls >= RATE_LIMIT_CLASS_COUNT || limiter->config.classes[cls].per_minute == 0) {
+        return;
+    }
+
+    uint64_t capacity = limiter->config.classes[cls].burst * TOKEN;
+    for (int i = 0; i < RATE_LIMIT_MAX_CLIENTS; i++) {
+        rate_limit_client_t *client = &limiter->clients[i];
+        if (client->in_use && memcmp(client->addr, addr, RATE_LIMIT_ADDR_LEN) == 0) {
+            client->tokens[cls] = client->tokens[cls] + TOKEN < capacity ?
+                                  client->tokens[cls] + TOKEN : capacity;
+            limiter->stats[cls].refunded++;
+            return;
+        }
+    }
+}
+
+const char* rate_limit_class_name(rate_limit_class_t cls) {
+    return cls < RATE_LIMIT_CLASS_COUNT ? class_names[cls] : "unknown";
+}
+
+void rate_limit_get_stats(const rate_limit_t *limiter, rate_limit_stats_t *stats) {
+    stats->config = limiter->config;
+    stats->active = limiter->active;
+    stats->evicted = limiter->evicted;
+    memcpy(stats->classes, limiter->stats, sizeof(stats->classes));
+}
+
+int rate_limit_stats_json(const rate_limit_stats_t *stats, char *buf, size_t size) {
+    int len = snprintf(buf, size, "{\"clients\":%u,\"evicted\":%lu",
+                       stats->active, (unsigned long)stats->evicted);
+
+    for (int i = 0; i < RATE_LIMIT_CLASS_COUNT; i++) {
+        const rate_limit_bucket_config_t *bucket = &stats->config.classes[i];
+        len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0,
+            ",\"%s\":{\"burst\":%u,\"per_minute\":%u,\"allowed\":%lu,\"rejected\":%lu,\"refunded\":%lu}",
+            class_names[i], bucket->burst, bucket->per_minute,
+            (unsigned long)stats->classes[i].allowed, (unsigned long)stats->classes[i].rejected,
+            (unsigned long)stats->classes[i].refunded);
+    }
+
+    len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0, "}");
+    return len;
+}
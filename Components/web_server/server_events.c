@@ -0,0 +1,133 @@
+// server_events.c - Responsabilidad única: transporte de eventos al servidor web en lotes
+//
+// Los productores (tarea del sensor, timer de fotos periódicas, tarea de la cámara) nunca
+// esperan: con la cola llena el evento se descarta y se cuenta. La tarea del servidor
+// espera el primero y se lleva todos los pendientes, de modo que el estado se publica y
+// los clientes de /events se notifican una vez por lote y no una vez por evento.
+// Antes de encolar, cada evento se anota en el diario (/events/history) y recibe su id.
+#include "server_events.h"
+#include "event_journal.h"
+#include "capture_queue.h"
+#include <stdio.h>
+#include <string.h>
+
+// Variables privadas del módulo
+static server_events_stats_t stats = {0};
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t server_events_post(QueueHandle_t queue, const server_event_t *event) {
+    if (queue == NULL || event == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // El diario asigna el id: la cola y /events llevan el mismo que /events/history
+    server_event_t record = *event;
+    event_journal_append(&record);
+    BaseType_t result = xQueueSend(queue, &record, 0);
+
+    portENTER_CRITICAL(&stats_lock);
+    if (result == pdTRUE) {
+        stats.posted++;
+    } else {
+        stats.dropped++;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    return result == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+size_t server_events_drain(QueueHandle_t queue, server_event_t *batch, size_t max, TickType_t wait) {
+    if (queue == NULL || batch == NULL || max == 0) {
+        return 0;
+    }
+    if (xQueueReceive(queue, &batch[0], wait) != pdTRUE) {
+        return 0;
+    }
+
+    // Lo que llegó mientras tanto se recoge sin volver a bloquear
+    size_t count = 1;
+    while (count < max && xQueueReceive(queue, &batch[count], 0) == pdTRUE) {
+        count++;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.processed += count;
+    stats.batches++;
+    if (count > stats.max_batch) {
+        stats.max_batch = count;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    return count;
+}
+
+size_t server_events_apply(server_state_t *state, const server_event_t *events, size_t count) {
+    size_t unknown = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const server_event_t *event = &events[i];
+
+        switch (event->type) {
+            case SERVER_EVENT_DETECTION_STARTED:
+                state->total_detections = event->detection_data.detection_count;
+                state->object_currently_detected = event->object_detected;
+                state->current_sensor_state = event->sensor_state;
+                break;
+
+            case SERVER_EVENT_DETECTION_ENDED:
+                state->object_currently_detected = event->object_detected;
+                state->current_sensor_state = event->sensor_state;
+                break;
+
+            case SERVER_EVENT_PHOTO_TAKEN:
+                state->has_photo_available = true;
+                break;
+
+            default:
+                unknown++;
+                continue;
+        }
+        state->last_update_time = event->timestamp;
+    }
+
+    return unknown;
+}
+
+const char* server_event_json(const server_event_t *event, char *buf, size_t size) {
+    switch (event->type) {
+        case SERVER_EVENT_DETECTION_STARTED:
+            snprintf(buf, size, "{\"id\":%lu,\"ts\":%llu,\"detected\":%s,\"sensor_state\":%d,\"detections\":%lu}",
+                     (unsigned long)event->id, (unsigned long long)event->timestamp, event->object_detected ? "true" : "false",
+                     event->sensor_state, (unsigned long)event->detection_data.detection_count);
+            return "detection_started";
+
+        case SERVER_EVENT_DETECTION_ENDED:
+            snprintf(buf, size, "{\"id\":%lu,\"ts\":%llu,\"detected\":%s,\"sensor_state\":%d}",
+                     (unsigned long)event->id, (unsigned long long)event->timestamp, event->object_detected ? "true" : "false",
+                     event->sensor_state);
+            return "detection_ended";
+
+        case SERVER_EVENT_PHOTO_TAKEN:
+            snprintf(buf, size, "{\"id\":%lu,\"ts\":%llu,\"seq\":%lu,\"size\":%lu,\"reason\":\"%s\"}",
+                     (unsigned long)event->id, (unsigned long long)event->timestamp, (unsigned long)event->photo_data.seq,
+                     (unsigned long)event->photo_data.photo_size,
+                     camera_capture_reason_name((camera_capture_reason_t)event->reason));
+            return "photo_taken";
+
+        default:
+            return NULL;
+    }
+}
+
+server_events_stats_t server_events_get_stats(void) {
+    portENTER_CRITICAL(&stats_lock);
+    server_events_stats_t current = stats;
+    portEXIT_CRITICAL(&stats_lock);
+    return current;
+}
+
+void server_events_reset_stats(void) {
+    portENTER_CRITICAL(&stats_lock);
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&stats_lock);
+}
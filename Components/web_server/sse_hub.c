@@ -0,0 +1,127 @@
+// sse_hub.c - Responsabilidad única: repartir eventos serializados a los clientes de /events
+//
+// El evento se serializa una sola vez y se copia en la cola acotada de cada cliente; la
+// tarea del cliente la vacía a su ritmo. Publicar nunca espera a la red, así que un
+// cliente lento solo pierde sus eventos más antiguos (contados en dropped).
+#include "sse_hub.h"
+#include <stdio.h>
+#include <string.h>
+
+esp_err_t sse_hub_init(sse_hub_t *hub, const sse_hub_config_t *config) {
+    if (hub == NULL || config == NULL ||
+        config->max_clients == 0 || config->max_clients > SSE_HUB_MAX_CLIENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(hub, 0, sizeof(*hub));
+    hub->config = *config;
+    return ESP_OK;
+}
+
+sse_client_t* sse_hub_claim(sse_hub_t *hub) {
+    if (hub->active < hub->config.max_clients) {
+        for (int i = 0; i < SSE_HUB_MAX_CLIENTS; i++) {
+            sse_client_t *client = &hub->clients[i];
+            if (!client->in_use) {
+                memset(client, 0, sizeof(*client));
+                client->in_use = true;
+                client->id = ++hub->total;
+                hub->active++;
+                return client;
+            }
+        }
+    }
+
+    hub->rejected++;
+    return NULL;
+}
+
+void sse_hub_release(sse_hub_t *hub, sse_client_t *client) {
+    if (client == NULL || !client->in_use) {
+        return;
+    }
+    client->in_use = false;
+    client->owner = NULL;
+    client->count = 0;
+    hub->active--;
+}
+
+uint32_t sse_hub_publish(sse_hub_t *hub, const char *event, const char *data, uint64_t timestamp) {
+    sse_entry_t entry;
+    uint32_t id = hub->published + 1;
+
+    int len = snprintf(entry.text, sizeof(entry.text), "id: %lu\nevent: %s\ndata: %s\n\n",
+                       (unsigned long)id, event, data);
+    if (len < 0 || len >= (int)sizeof(entry.text)) {
+        hub->oversized++;
+        return 0;
+    }
+    entry.len = (uint16_t)len;
+    entry.timestamp = timestamp;
+    hub->published = id;
+
+    for (int i = 0; i < SSE_HUB_MAX_CLIENTS; i++) {
+        sse_client_t *client = &hub->clients[i];
+        if (!client->in_use) {
+            continue;
+        }
+        if (client->count == SSE_HUB_BACKLOG) {
+            // Cola llena: el más antiguo deja sitio al nuevo
+            client->head = (client->head + 1) % SSE_HUB_BACKLOG;
+            client->count--;
+            client->stats.dropped++;
+        }
+        uint8_t tail = (client->head + client->count) % SSE_HUB_BACKLOG;
+        memcpy(&client->backlog[tail], &entry, offsetof(sse_entry_t, text) + entry.len + 1);
+        client->count++;
+    }
+
+    return id;
+}
+
+bool sse_client_pop(sse_client_t *client, sse_entry_t *entry) {
+    if (client->count == 0) {
+        return false;
+    }
+
+    const sse_entry_t *head = &client->backlog[client->head];
+    memcpy(entry, head, offsetof(sse_entry_t, text) + head->len + 1);
+    client->head = (client->head + 1) % SSE_HUB_BACKLOG;
+    client->count--;
+    return true;
+}
+
+void sse_client_account(sse_client_t *client, uint32_t latency_us) {
+    client->stats.sent++;
+    client->stats.last_latency_us = latency_us;
+    if (latency_us > client->stats.max_latency_us) {
+        client->stats.max_latency_us = latency_us;
+    }
+}
+
+int sse_hub_stats_json(const sse_hub_t *hub, char *buf, size_t size) {
+    int len = snprintf(buf, size,
+        "{\"clients\":%u,\"max_clients\":%u,\"total\":%lu,\"rejected\":%lu,\"published\":%lu,"
+        "\"oversized\":%lu,\"per_client\":[",
+        hub->active, hub->config.max_clients, (unsigned long)hub->total,
+        (unsigned long)hub->rejected, (unsigned long)hub->published, (unsigned long)hub->oversized);
+    bool first = true;
+
+    for (int i = 0; i < SSE_HUB_MAX_CLIENTS; i++) {
+        const sse_client_t *client = &hub->clients[i];
+        if (!client->in_use) {
+            continue;
+        }
+        const sse_client_stats_t *stats = &client->stats;
+        len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0,
+            "%s{\"id\":%lu,\"sent\":%lu,\"dropped\":%lu,\"backlog\":%u,"
+            "\"last_latency_us\":%lu,\"max_latency_us\":%lu}",
+            first ? "" : ",", (unsigned long)client->id, (unsigned long)stats->sent,
+            (unsigned long)stats->dropped, client->count, (unsigned long)stats->last_latency_us,
+            (unsigned long)stats->max_latency_us);
+        first = false;
+    }
+
+    len += snprintf(buf + (len < (int)size ? len : (int)size), len < (int)size ? size - len : 0, "]}");
+    return len;
+}
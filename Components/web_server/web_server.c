@@ -2,9 +2,17 @@
 #include "cam_reader.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_random.h"
+#include "http_cache.h"
+#include "event_journal.h"
+#include "metrics.h"
+#include "seqlock.h"
+#include "esp_heap_caps.h"
+#include "lwip/sockets.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "WEB_SERVER";
@@ -13,20 +21,172 @@ static const char *TAG = "WEB_SERVER";
 static httpd_handle_t server_handle = NULL;
 static QueueHandle_t event_queue = NULL;
 static TaskHandle_t event_task_handle = NULL;
-static SemaphoreHandle_t state_mutex = NULL;
-static server_state_t server_state = {0};
+static server_state_t server_state = {0};        // Solo la escribe la tarea de eventos
+static seqlock_t state_lock = SEQLOCK_INIT();     // /status la lee sin esperar a la tarea
 static server_config_t server_config = SERVER_DEFAULT_CONFIG();
-static bool server_running = false;
+static volatile bool server_running = false;
+static volatile bool event_task_running = false; // La tarea de eventos lo borra al salir
+
+#define EVENT_TASK_STOP_WAIT_MS  2000  // Espera de la cola (1 s) + publicación del último lote
+
+// Clientes de /stream: el registro lo comparten el handler y las tareas de cada cliente
+static mjpeg_stream_t stream = {0};
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Contexto de la tarea de un cliente de /stream
+typedef struct {
+    httpd_req_t *req;             // Petición asíncrona (httpd_req_async_handler_begin)
+    mjpeg_client_t *client;       // Hueco en el registro
+} stream_client_ctx_t;
+
+#define STREAM_STOP_WAIT_MS   6000   // send_wait_timeout (5 s) + margen para el último envío
+
+// Clientes de /events: mutex y no spinlock porque la tarea de eventos notifica a las
+// tareas de los clientes con el registro tomado (así ninguna termina a mitad de aviso)
+static sse_hub_t events_hub = {0};
+static SemaphoreHandle_t events_mutex = NULL;
+
+// Contexto de la tarea de un cliente de /events
+typedef struct {
+    httpd_req_t *req;             // Petición asíncrona (httpd_req_async_handler_begin)
+    sse_client_t *client;         // Hueco en el registro
+} events_client_ctx_t;
+
+#define EVENTS_KEEPALIVE_MS   15000  // Comentario SSE sin eventos: detecta clientes caídos
+
+// Admisión por cliente: cubetas de tokens por dirección IP para /photo y /stream
+static rate_limit_t limiter = {0};
+static portMUX_TYPE limiter_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Índice del historial de fotos (/photos)
+#define PHOTOS_DEFAULT_LIMIT  20
+#define PHOTOS_JSON_SIZE      (128 + PHOTO_HISTORY_LIST_MAX * 160)  // Cabecera + entradas de 160 bytes como máximo
+#define PREROLL_JSON_SIZE     (64 + PREROLL_EPISODE_MAX * 128)      // Índice de /photo/preroll
+
+// Diario de eventos (/events/history)
+#define EVENTS_HISTORY_DEFAULT_LIMIT  32
+#define EVENTS_HISTORY_JSON_SIZE      (160 + EVENT_JOURNAL_QUERY_MAX * 192)  // Cabecera + eventos de 192 bytes como máximo
+#define EVENTS_HISTORY_BIN_SIZE       (sizeof(event_journal_bin_header_t) + EVENT_JOURNAL_QUERY_MAX * sizeof(server_event_t))
+
+// Interfaz web: ficheros de www/ comprimidos con gzip al compilar (ver CMakeLists.txt)
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
+extern const uint8_t app_js_gz_start[] asm("_binary_app_js_gz_start");
+extern const uint8_t app_js_gz_end[] asm("_binary_app_js_gz_end");
+extern const uint8_t style_css_gz_start[] asm("_binary_style_css_gz_start");
+extern const uint8_t style_css_gz_end[] asm("_binary_style_css_gz_end");
+
+// Recurso estático de la interfaz
+typedef struct {
+    const char *uri;
+    const char *type;
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *cache_control;
+    char etag[HTTP_ETAG_MAX_LEN];     // Hash del contenido (se calcula al registrar)
+} static_asset_t;
+
+// La página se revalida siempre (304 si no cambió); JS y CSS llevan el hash de su
+// contenido en la URL (?v=) y se guardan un año sin volver a preguntar
+static static_asset_t static_assets[] = {
+    { "/", "text/html", index_html_gz_start, index_html_gz_end, "no-cache" },
+    { "/app.js", "application/javascript", app_js_gz_start, app_js_gz_end, "public, max-age=31536000, immutable" },
+    { "/style.css", "text/css", style_css_gz_start, style_css_gz_end, "public, max-age=31536000, immutable" },
+};
+
+// Peticiones condicionales de /photo y /photo/thumb
+typedef struct {
+    uint32_t requests;            // Respuestas con frame (200 o 304)
+    uint32_t not_modified;        // Respondidas con 304 sin cuerpo
+    uint64_t bytes_saved;         // Bytes JPEG que no hubo que enviar
+} photo_cache_stats_t;
+
+static photo_cache_stats_t photo_cache_stats = {0};
+static portMUX_TYPE photo_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t etag_epoch = 0;   // Distinto en cada arranque: los seq se repiten tras reiniciar
+
+// Métricas de /metrics: duración de cada handler y del paso de eventos por la cola
+#define HTTP_LATENCY_NAME     "coop_http_request_duration_seconds"
+#define HTTP_LATENCY_HELP     "Duración de los handlers HTTP, envío de la respuesta incluido"
+#define HEAP_FREE_HELP        "Memoria libre por tipo"
+#define HEAP_MIN_FREE_HELP    "Mínimo de memoria libre desde el arranque por tipo"
+
+static metric_histogram_t asset_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"asset\"");
+static metric_histogram_t photo_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"photo\"");
+static metric_histogram_t thumb_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"thumb\"");
+static metric_histogram_t photos_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"photos\"");
+static metric_histogram_t photo_seq_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"photo_seq\"");
+static metric_histogram_t photo_meta_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"photo_meta\"");
+static metric_histogram_t preroll_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"photo_preroll\"");
+static metric_histogram_t status_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"status\"");
+static metric_histogram_t metrics_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"metrics\"");
+static metric_histogram_t events_history_latency = METRIC_HISTOGRAM_INIT(HTTP_LATENCY_NAME, HTTP_LATENCY_HELP, "handler=\"events_history\"");
+static metric_histogram_t event_delay = METRIC_HISTOGRAM_INIT("coop_server_event_delay_seconds",
+    "Desde que se genera un evento hasta que la tarea del servidor lo procesa", NULL);
+static metric_counter_t events_processed = METRIC_COUNTER_INIT("coop_server_events_processed_total",
+    "Eventos aplicados por la tarea del servidor", NULL);
+static metric_gauge_t event_batch_max = METRIC_GAUGE_INIT("coop_server_event_batch_max",
+    "Mayor número de eventos recogidos de la cola en un solo vaciado", NULL);
+static metric_gauge_t heap_internal_free = METRIC_GAUGE_INIT("coop_heap_free_bytes", HEAP_FREE_HELP, "type=\"internal\"");
+static metric_gauge_t heap_psram_free = METRIC_GAUGE_INIT("coop_heap_free_bytes", HEAP_FREE_HELP, "type=\"psram\"");
+static metric_gauge_t heap_internal_min = METRIC_GAUGE_INIT("coop_heap_min_free_bytes", HEAP_MIN_FREE_HELP, "type=\"internal\"");
+static metric_gauge_t heap_psram_min = METRIC_GAUGE_INIT("coop_heap_min_free_bytes", HEAP_MIN_FREE_HELP, "type=\"psram\"");
+static metric_counter_t photo_limited = METRIC_COUNTER_INIT("coop_http_rate_limited_total",
+    "Peticiones rechazadas con 503 por superar el ritmo de su dirección IP", "route=\"photo\"");
+static metric_counter_t stream_limited = METRIC_COUNTER_INIT("coop_http_rate_limited_total",
+    "Peticiones rechazadas con 503 por superar el ritmo de su dirección IP", "route=\"stream\"");
+static metric_counter_t history_limited = METRIC_COUNTER_INIT("coop_http_rate_limited_total",
+    "Peticiones rechazadas con 503 por superar el ritmo de su dirección IP", "route=\"history\"");
+static metric_gauge_t stream_clients_gauge = METRIC_GAUGE_INIT("coop_stream_clients", "Clientes conectados a /stream", NULL);
+static metric_gauge_t events_clients_gauge = METRIC_GAUGE_INIT("coop_events_clients", "Clientes conectados a /events", NULL);
+
+static metric_desc_t *server_metrics[] = {
+    &asset_latency.desc, &photo_latency.desc, &thumb_latency.desc, &photos_latency.desc,
+    &photo_seq_latency.desc, &photo_meta_latency.desc, &preroll_latency.desc,
+    &status_latency.desc, &metrics_latency.desc, &events_history_latency.desc, &event_delay.desc,
+    &events_processed.desc, &event_batch_max.desc, &photo_limited.desc, &stream_limited.desc,
+    &history_limited.desc,
+    &heap_internal_free.desc, &heap_psram_free.desc, &heap_internal_min.desc, &heap_psram_min.desc,
+    &stream_clients_gauge.desc, &events_clients_gauge.desc,
+};
 
 // Prototipos de funciones privadas
 static void event_processing_task(void *pvParameters);
-static void update_server_state(const server_event_t *event);
+static void update_server_state(const server_event_t *events, size_t count);
 static esp_err_t setup_http_handlers(void);
 
-// Handlers HTTP
-static esp_err_t index_handler(httpd_req_t *req);
+// Handlers HTTP (los *_respond son el cuerpo; el handler registrado mide su duración)
+static esp_err_t static_asset_handler(httpd_req_t *req);
+static esp_err_t static_asset_respond(httpd_req_t *req);
+static esp_err_t send_not_modified(httpd_req_t *req);
 static esp_err_t photo_handler(httpd_req_t *req);
+static esp_err_t photo_send(httpd_req_t *req);
+static esp_err_t photo_respond(httpd_req_t *req);
+static esp_err_t thumb_handler(httpd_req_t *req);
+static esp_err_t thumb_send(httpd_req_t *req);
+static esp_err_t thumb_respond(httpd_req_t *req);
+static esp_err_t photo_meta_handler(httpd_req_t *req);
+static esp_err_t photos_handler(httpd_req_t *req);
+static esp_err_t photos_respond(httpd_req_t *req);
+static esp_err_t photo_seq_handler(httpd_req_t *req);
+static esp_err_t photo_seq_send(httpd_req_t *req);
+static esp_err_t photo_seq_respond(httpd_req_t *req);
+static esp_err_t preroll_handler(httpd_req_t *req);
+static esp_err_t preroll_send(httpd_req_t *req);
+static esp_err_t preroll_respond(httpd_req_t *req);
+static esp_err_t photo_meta_respond(httpd_req_t *req);
 static esp_err_t status_handler(httpd_req_t *req);
+static esp_err_t status_respond(httpd_req_t *req);
+static esp_err_t metrics_handler(httpd_req_t *req);
+static esp_err_t metrics_respond(httpd_req_t *req);
+static esp_err_t stream_handler(httpd_req_t *req);
+static esp_err_t events_handler(httpd_req_t *req);
+static esp_err_t events_history_handler(httpd_req_t *req);
+static esp_err_t events_history_respond(httpd_req_t *req);
+static bool admit_client(httpd_req_t *req, rate_limit_class_t cls);
+static void refund_client(httpd_req_t *req, rate_limit_class_t cls);
+static void publish_server_events(const server_event_t *events, size_t count);
+static void wake_events_clients(void);
 
 // Implementación de funciones públicas
 esp_err_t web_server_init(void) {
@@ -46,29 +206,83 @@ esp_err_t web_server_init_with_config(const server_config_t *config) {
     
     ESP_LOGI(TAG, "Inicializando servidor web...");
     
+    mjpeg_stream_config_t stream_config = {
+        .max_clients = config->stream_max_clients,
+        .fps = config->stream_fps
+    };
+    if (mjpeg_stream_init(&stream, &stream_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de stream inválida: %u clientes, %u fps",
+                 config->stream_max_clients, config->stream_fps);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    sse_hub_config_t events_config = {
+        .max_clients = config->events_max_clients
+    };
+    if (sse_hub_init(&events_hub, &events_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de eventos inválida: %u clientes", config->events_max_clients);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    rate_limit_config_t limiter_config = {
+        .classes = {
+            [RATE_LIMIT_PHOTO] = { .burst = config->photo_burst, .per_minute = config->photo_per_minute },
+            [RATE_LIMIT_STREAM] = { .burst = config->stream_burst, .per_minute = config->stream_per_minute },
+            [RATE_LIMIT_HISTORY] = { .burst = config->history_burst, .per_minute = config->history_per_minute }
+        }
+    };
+    portENTER_CRITICAL(&limiter_lock);
+    esp_err_t limiter_ret = rate_limit_init(&limiter, &limiter_config);
+    portEXIT_CRITICAL(&limiter_lock);
+    if (limiter_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Configuración de admisión inválida: /photo %u+%u/min, /stream %u+%u/min, "
+                 "/photo/{seq} %u+%u/min", config->photo_burst, config->photo_per_minute,
+                 config->stream_burst, config->stream_per_minute, config->history_burst,
+                 config->history_per_minute);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     // Copiar configuración
     server_config = *config;
     
     // Crear cola de eventos
-    event_queue = xQueueCreate(20, sizeof(server_event_t));
+    event_queue = xQueueCreate(SERVER_EVENT_QUEUE_DEPTH, sizeof(server_event_t));
     if (event_queue == NULL) {
         ESP_LOGE(TAG, "Error creando cola de eventos");
         return ESP_ERR_NO_MEM;
     }
     
-    // Crear mutex para proteger estado
-    state_mutex = xSemaphoreCreateMutex();
-    if (state_mutex == NULL) {
-        ESP_LOGE(TAG, "Error creando mutex de estado");
+    events_mutex = xSemaphoreCreateMutex();
+    if (events_mutex == NULL) {
+        ESP_LOGE(TAG, "Error creando mutex de eventos");
         vQueueDelete(event_queue);
         event_queue = NULL;
         return ESP_ERR_NO_MEM;
     }
     
+    // Sin diario el servidor funciona igual: /events/history solo devuelve páginas vacías
+    event_journal_config_t journal_config = {
+        .capacity = config->journal_capacity
+    };
+    if (event_journal_init(&journal_config) != ESP_OK) {
+        ESP_LOGW(TAG, "Diario de eventos no disponible");
+    }
+    
+    etag_epoch = esp_random();
+    server_events_reset_stats();
+    
+    for (size_t i = 0; i < sizeof(server_metrics) / sizeof(server_metrics[0]); i++) {
+        if (metrics_register(server_metrics[i]) != ESP_OK) {
+            ESP_LOGW(TAG, "Registro de métricas lleno: %s sin exportar", server_metrics[i]->name);
+        }
+    }
+    
     // Inicializar estado del servidor
-    memset(&server_state, 0, sizeof(server_state));
-    server_state.initialized = true;
-    server_state.last_update_time = esp_timer_get_time();
+    server_state_t initial_state = {
+        .initialized = true,
+        .last_update_time = esp_timer_get_time()
+    };
+    seqlock_write(&state_lock, &server_state, &initial_state, sizeof(initial_state));
     
     ESP_LOGI(TAG, "Servidor web inicializado en puerto %d", server_config.port);
     return ESP_OK;
@@ -92,11 +306,32 @@ esp_err_t web_server_start(void) {
     config.server_port = server_config.port;
     config.max_uri_handlers = server_config.max_uri_handlers;
     config.max_resp_headers = server_config.max_resp_headers;
+    // /photo/{seq}: "/photo/*" se registra después de /photo/thumb, /photo/meta y /photo/preroll, que
+    // siguen siendo exactos y tienen prioridad (httpd prueba en orden de registro)
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    // Cada cliente de /stream y de /events retiene su socket: se reservan 4 más para el
+    // resto de peticiones (httpd usa 3 internos de CONFIG_LWIP_MAX_SOCKETS=16)
+    config.max_open_sockets = server_config.stream_max_clients + server_config.events_max_clients + 4;
+    // Con todos los sockets ocupados, una conexión nueva cierra la menos usada en vez de
+    // esperar: los keep-alive que un navegador deja abiertos no dejan fuera al resto
+    config.lru_purge_enable = true;
+    
+    // Pool para las respuestas largas: debe existir antes de recibir la primera petición
+    http_workers_config_t workers_config = HTTP_WORKERS_DEFAULT_CONFIG();
+    workers_config.worker_count = server_config.worker_count;
+    workers_config.queue_depth = server_config.worker_queue_depth;
+    workers_config.core_id = server_config.worker_core;
+    esp_err_t ret = http_workers_start(&workers_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error iniciando pool HTTP: %s", esp_err_to_name(ret));
+        return ret;
+    }
     
     // Iniciar servidor HTTP
-    esp_err_t ret = httpd_start(&server_handle, &config);
+    ret = httpd_start(&server_handle, &config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error iniciando servidor HTTP: %s", esp_err_to_name(ret));
+        http_workers_stop(STREAM_STOP_WAIT_MS);
         return ret;
     }
     
@@ -106,10 +341,13 @@ esp_err_t web_server_start(void) {
         ESP_LOGE(TAG, "Error configurando handlers HTTP");
         httpd_stop(server_handle);
         server_handle = NULL;
+        http_workers_stop(STREAM_STOP_WAIT_MS);
         return ret;
     }
     
-    // Crear tarea de procesamiento de eventos
+    // Crear tarea de procesamiento de eventos (server_running antes: la tarea sale al verlo false)
+    server_running = true;
+    event_task_running = true;
     BaseType_t task_ret = xTaskCreate(
         event_processing_task,
         "web_server_events",
@@ -121,12 +359,15 @@ esp_err_t web_server_start(void) {
     
     if (task_ret != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea de eventos");
+        server_running = false;
+        event_task_running = false;
+        event_task_handle = NULL;
         httpd_stop(server_handle);
         server_handle = NULL;
+        http_workers_stop(STREAM_STOP_WAIT_MS);
         return ESP_FAIL;
     }
     
-    server_running = true;
     ESP_LOGI(TAG, "Servidor web iniciado exitosamente");
     return ESP_OK;
 }
@@ -141,10 +382,48 @@ esp_err_t web_server_stop(void) {
     
     server_running = false;
     
-    // Detener tarea de eventos
-    if (event_task_handle != NULL) {
-        vTaskDelete(event_task_handle);
-        event_task_handle = NULL;
+    // Detener tarea de eventos: sale sola al ver server_running = false. Borrarla desde
+    // aquí podría dejar events_mutex tomado a mitad de publish_server_events(). El aviso
+    // al frente de la cola la despierta sin esperar al plazo de server_events_drain()
+    server_event_t wake = {0};
+    xQueueSendToFront(event_queue, &wake, 0);
+    uint32_t task_waited_ms = 0;
+    while (event_task_running && task_waited_ms < EVENT_TASK_STOP_WAIT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        task_waited_ms += 10;
+    }
+    if (event_task_running) {
+        ESP_LOGW(TAG, "Tarea de eventos activa al detener el servidor");
+    } else {
+        // El aviso (y lo que llegara tras él) no se publica al volver a arrancar
+        xQueueReset(event_queue);
+    }
+    event_task_handle = NULL;
+    
+    // Las tareas de /stream y /events ven server_running = false al terminar su envío
+    // en curso; deben completar su petición antes de que httpd libere las sesiones
+    wake_events_clients();
+    uint32_t waited_ms = 0;
+    while (waited_ms < STREAM_STOP_WAIT_MS) {
+        portENTER_CRITICAL(&stream_lock);
+        uint8_t active = stream.active;
+        portEXIT_CRITICAL(&stream_lock);
+        xSemaphoreTake(events_mutex, portMAX_DELAY);
+        active += events_hub.active;
+        xSemaphoreGive(events_mutex);
+        if (active == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+        waited_ms += 50;
+    }
+    if (waited_ms >= STREAM_STOP_WAIT_MS) {
+        ESP_LOGW(TAG, "Clientes de stream o eventos activos al detener el servidor");
+    }
+    
+    // Las fotos en cola o enviándose también retienen su sesión de httpd
+    if (http_workers_stop(STREAM_STOP_WAIT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "Envíos del pool HTTP activos al detener el servidor");
     }
     
     // Detener servidor HTTP
@@ -166,6 +445,10 @@ esp_err_t web_server_deinit(void) {
     
     // Detener servidor si está ejecutándose
     web_server_stop();
+    if (event_task_running) {
+        ESP_LOGE(TAG, "Tarea de eventos sin terminar: no se liberan la cola ni el mutex");
+        return ESP_ERR_INVALID_STATE;
+    }
     
     // Limpiar recursos
     if (event_queue != NULL) {
@@ -173,13 +456,16 @@ esp_err_t web_server_deinit(void) {
         event_queue = NULL;
     }
     
-    if (state_mutex != NULL) {
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
+    if (events_mutex != NULL) {
+        vSemaphoreDelete(events_mutex);
+        events_mutex = NULL;
     }
     
+    event_journal_deinit();
+    
     // Reset estado
-    memset(&server_state, 0, sizeof(server_state));
+    server_state_t empty_state = {0};
+    seqlock_write(&state_lock, &server_state, &empty_state, sizeof(empty_state));
     
     ESP_LOGI(TAG, "Servidor web desinicializado");
     return ESP_OK;
@@ -190,13 +476,10 @@ QueueHandle_t web_server_get_event_queue(void) {
 }
 
 server_state_t web_server_get_state(void) {
-    server_state_t state_copy = {0};
-    
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        state_copy = server_state;
-        xSemaphoreGive(state_mutex);
-    }
+    server_state_t state_copy;
     
+    // Sin espera: si coincide con una actualización se repite la copia
+    seqlock_read(&state_lock, &state_copy, &server_state, sizeof(state_copy));
     return state_copy;
 }
 
@@ -204,67 +487,92 @@ bool web_server_is_running(void) {
     return server_running;
 }
 
+void web_server_get_stream_stats(mjpeg_stream_t *copy) {
+    portENTER_CRITICAL(&stream_lock);
+    *copy = stream;
+    portEXIT_CRITICAL(&stream_lock);
+}
+
+uint8_t web_server_get_events_stats(sse_client_stats_t *stats, uint8_t max_clients) {
+    uint8_t count = 0;
+    
+    if (events_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    for (int i = 0; i < SSE_HUB_MAX_CLIENTS && count < max_clients; i++) {
+        if (events_hub.clients[i].in_use) {
+            stats[count++] = events_hub.clients[i].stats;
+        }
+    }
+    xSemaphoreGive(events_mutex);
+    return count;
+}
+
 // Funciones privadas
 static void event_processing_task(void *pvParameters) {
-    server_event_t event;
+    server_event_t batch[SERVER_EVENTS_BATCH_MAX];
     
     ESP_LOGI(TAG, "Tarea de procesamiento de eventos iniciada");
     
     while (server_running) {
-        if (xQueueReceive(event_queue, &event, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            ESP_LOGD(TAG, "Evento recibido: tipo=%d, timestamp=%llu", event.type, event.timestamp);
-            update_server_state(&event);
+        // Una ráfaga de detecciones se aplica y se publica de una vez
+        size_t count = server_events_drain(event_queue, batch, SERVER_EVENTS_BATCH_MAX, pdMS_TO_TICKS(1000));
+        if (count == 0 || !server_running) {
+            continue;
         }
+        
+        int64_t now = esp_timer_get_time();
+        for (size_t i = 0; i < count; i++) {
+            ESP_LOGD(TAG, "Evento recibido: tipo=%d, timestamp=%llu", batch[i].type, batch[i].timestamp);
+            metrics_histogram_observe(&event_delay, (uint32_t)(now - batch[i].timestamp));
+        }
+        metrics_counter_add(&events_processed, count);
+        metrics_gauge_set(&event_batch_max, server_events_get_stats().max_batch);
+        
+        update_server_state(batch, count);
+        publish_server_events(batch, count);
     }
     
     ESP_LOGI(TAG, "Tarea de procesamiento de eventos terminada");
+    event_task_running = false;
     vTaskDelete(NULL);
 }
 
-static void update_server_state(const server_event_t *event) {
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        // Actualizar timestamp
-        server_state.last_update_time = event->timestamp;
-        
-        switch (event->type) {
-            case SERVER_EVENT_DETECTION_STARTED:
-                server_state.total_detections = event->detection_data.detection_count;
-                server_state.object_currently_detected = event->object_detected;
-                server_state.current_sensor_state = event->sensor_state;
-                ESP_LOGI(TAG, "Estado actualizado: Nueva detección #%lu", server_state.total_detections);
-                break;
-                
-            case SERVER_EVENT_DETECTION_ENDED:
-                server_state.object_currently_detected = event->object_detected;
-                server_state.current_sensor_state = event->sensor_state;
-                ESP_LOGI(TAG, "Estado actualizado: Detección terminada");
-                break;
-                
-            case SERVER_EVENT_PHOTO_TAKEN:
-                server_state.has_photo_available = true;
-                ESP_LOGI(TAG, "Estado actualizado: Nueva foto disponible (%zu bytes)", event->photo_data.photo_size);
-                break;
-                
-            default:
-                ESP_LOGW(TAG, "Tipo de evento desconocido: %d", event->type);
-                break;
-        }
-        
-        xSemaphoreGive(state_mutex);
-    } else {
-        ESP_LOGE(TAG, "Error obteniendo mutex para actualizar estado");
+static void update_server_state(const server_event_t *events, size_t count) {
+    // Única escritora: aplica el lote sobre una copia y lo publica con una sola escritura
+    server_state_t next = server_state;
+    size_t unknown = server_events_apply(&next, events, count);
+    
+    if (unknown > 0) {
+        ESP_LOGW(TAG, "%zu eventos de tipo desconocido ignorados", unknown);
+    }
+    if (next.total_detections != server_state.total_detections) {
+        ESP_LOGI(TAG, "Estado actualizado: Nueva detección #%lu", next.total_detections);
+    } else if (next.object_currently_detected != server_state.object_currently_detected) {
+        ESP_LOGI(TAG, "Estado actualizado: Detección %s",
+                 next.object_currently_detected ? "en curso" : "terminada");
+    }
+    if (count > 1) {
+        ESP_LOGI(TAG, "Estado actualizado con un lote de %zu eventos", count);
     }
+    
+    seqlock_write(&state_lock, &server_state, &next, sizeof(next));
 }
 
 static esp_err_t setup_http_handlers(void) {
-    // Handler para página principal
-    httpd_uri_t index_uri = {
-        .uri = "/",
-        .method = HTTP_GET,
-        .handler = index_handler,
-        .user_ctx = NULL
-    };
-    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &index_uri));
+    // Handlers para la interfaz web (página principal, JS y CSS)
+    for (size_t i = 0; i < sizeof(static_assets) / sizeof(static_assets[0]); i++) {
+        static_asset_t *asset = &static_assets[i];
+        http_etag_format_hash(asset->etag, sizeof(asset->etag), asset->start, asset->end - asset->start);
+        httpd_uri_t asset_uri = {
+            .uri = asset->uri,
+            .method = HTTP_GET,
+            .handler = static_asset_handler,
+            .user_ctx = asset
+        };
+        ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &asset_uri));
+    }
     
     // Handler para fotos
     httpd_uri_t photo_uri = {
@@ -275,6 +583,51 @@ static esp_err_t setup_http_handlers(void) {
     };
     ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &photo_uri));
     
+    // Handler para miniaturas (escala 1/8 de la última foto)
+    httpd_uri_t thumb_uri = {
+        .uri = "/photo/thumb",
+        .method = HTTP_GET,
+        .handler = thumb_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &thumb_uri));
+    
+    // Handler para metadatos JSON de la última foto
+    httpd_uri_t photo_meta_uri = {
+        .uri = "/photo/meta",
+        .method = HTTP_GET,
+        .handler = photo_meta_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &photo_meta_uri));
+    
+    // Handler para el índice del historial de fotos (?since=&limit=)
+    httpd_uri_t photos_uri = {
+        .uri = "/photos",
+        .method = HTTP_GET,
+        .handler = photos_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &photos_uri));
+    
+    // Handler para los frames pre-disparo del último episodio (índice o ?index=)
+    httpd_uri_t preroll_uri = {
+        .uri = "/photo/preroll",
+        .method = HTTP_GET,
+        .handler = preroll_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &preroll_uri));
+    
+    // Handler para una foto del historial por secuencia (después de thumb, meta y preroll)
+    httpd_uri_t photo_seq_uri = {
+        .uri = "/photo/*",
+        .method = HTTP_GET,
+        .handler = photo_seq_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &photo_seq_uri));
+    
     // Handler para estado JSON
     httpd_uri_t status_uri = {
         .uri = "/status",
@@ -284,94 +637,285 @@ static esp_err_t setup_http_handlers(void) {
     };
     ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &status_uri));
     
+    // Handler para métricas en formato Prometheus
+    httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &metrics_uri));
+    
+    // Handler para el stream MJPEG (vista en vivo)
+    httpd_uri_t stream_uri = {
+        .uri = "/stream",
+        .method = HTTP_GET,
+        .handler = stream_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &stream_uri));
+    
+    // Handler para eventos en vivo (Server-Sent Events)
+    httpd_uri_t events_uri = {
+        .uri = "/events",
+        .method = HTTP_GET,
+        .handler = events_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &events_uri));
+    
+    // Handler para el diario de eventos (?after=&limit=&format=json|bin)
+    httpd_uri_t events_history_uri = {
+        .uri = "/events/history",
+        .method = HTTP_GET,
+        .handler = events_history_handler,
+        .user_ctx = NULL
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_handle, &events_history_uri));
+    
     ESP_LOGI(TAG, "Handlers HTTP registrados");
     return ESP_OK;
 }
 
 // Implementación de handlers HTTP
-static esp_err_t index_handler(httpd_req_t *req) {
-    server_state_t state = web_server_get_state();
+
+// Ejecuta el cuerpo de un handler y registra cuánto tardó (envío incluido)
+static esp_err_t timed_respond(httpd_req_t *req, esp_err_t (*respond)(httpd_req_t *req),
+                               metric_histogram_t *latency) {
+    uint64_t start = esp_timer_get_time();
+    esp_err_t ret = respond(req);
+    metrics_histogram_observe(latency, (uint32_t)(esp_timer_get_time() - start));
+    return ret;
+}
+
+static esp_err_t static_asset_handler(httpd_req_t *req) {
+    return timed_respond(req, static_asset_respond, &asset_latency);
+}
+
+static esp_err_t photo_meta_handler(httpd_req_t *req) {
+    return timed_respond(req, photo_meta_respond, &photo_meta_latency);
+}
+
+static esp_err_t photos_handler(httpd_req_t *req) {
+    return timed_respond(req, photos_respond, &photos_latency);
+}
+
+static esp_err_t status_handler(httpd_req_t *req) {
+    return timed_respond(req, status_respond, &status_latency);
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req) {
+    return timed_respond(req, metrics_respond, &metrics_latency);
+}
+
+static esp_err_t events_history_handler(httpd_req_t *req) {
+    return timed_respond(req, events_history_respond, &events_history_latency);
+}
+
+static esp_err_t static_asset_respond(httpd_req_t *req) {
+    const static_asset_t *asset = (const static_asset_t *)req->user_ctx;
+    char condition[96];
     
-    const char* html_template = 
-        "<!DOCTYPE html>"
-        "<html><head><title>ESP32-CAM Sensor Monitor</title>"
-        "<meta charset='utf-8'>"
-        "<style>"
-        "body { font-family: Arial; text-align: center; margin: 50px; background-color: #f5f5f5; }"
-        ".container { max-width: 800px; margin: 0 auto; background: white; padding: 30px; border-radius: 10px; box-shadow: 0 4px 6px rgba(0,0,0,0.1); }"
-        "h1 { color: #333; margin-bottom: 30px; }"
-        "img { max-width: 90%%; height: auto; border: 3px solid #333; border-radius: 8px; margin: 20px 0; }"
-        ".status { font-size: 18px; margin: 20px 0; padding: 15px; background: #f8f9fa; border-radius: 5px; }"
-        ".status p { margin: 10px 0; }"
-        ".status strong { color: #2c3e50; }"
-        ".detection-count { font-size: 24px; color: #27ae60; font-weight: bold; }"
-        ".photo-section { margin-top: 30px; }"
-        "</style>"
-        "<script>"
-        "function autoRefresh() {"
-        "  const img = document.getElementById('photo');"
-        "  const status = document.getElementById('detectionCount');"
-        "  "
-        "  // Actualizar foto"
-        "  img.src = '/photo?' + new Date().getTime();"
-        "  "
-        "  // Actualizar estado"
-        "  fetch('/status')"
-        "    .then(response => response.json())"
-        "    .then(data => {"
-        "      status.textContent = data.total_detections;"
-        "    })"
-        "    .catch(error => console.error('Error:', error));"
-        "}"
-        "setInterval(autoRefresh, 3000);" // Actualiza cada 3 segundos
-        "</script>"
-        "</head><body>"
-        "<div class='container'>"
-        "<h1>🔍 Monitor de Sensor E18-D80NK</h1>"
-        "<div class='status'>"
-        "<p><strong>Detecciones totales:</strong> <span id='detectionCount' class='detection-count'>%lu</span></p>"
-        "</div>"
-        "<div class='photo-section'>"
-        "<h2>📸 Última foto capturada:</h2>"
-        "<img id='photo' src='/photo' alt='%s' onerror=\"this.alt='No hay foto disponible'\">"
-        "</div>"
-        "</div>"
-        "</body></html>";
-    
-    // Preparar respuesta HTML con datos actuales
-    char* html_response = malloc(2048);
-    if (html_response == NULL) {
-        ESP_LOGE(TAG, "Error asignando memoria para HTML");
-        return ESP_ERR_NO_MEM;
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", condition, sizeof(condition)) == ESP_OK &&
+        http_etag_matches(condition, asset->etag)) {
+        return send_not_modified(req);
     }
     
-    snprintf(html_response, 2048, html_template, 
-             state.total_detections,
-             state.has_photo_available ? "Esperando carga de imagen..." : "No hay foto disponible aún");
+    // Directamente desde flash: sin heap ni copia
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)asset->start, asset->end - asset->start);
+}
+
+// Valores de las cabeceras de metadatos (httpd solo guarda el puntero hasta el envío)
+typedef struct {
+    char seq[12];
+    char timestamp[24];
+    char wall_time[24];
+    char reason[4];
+    char latency[12];
+    char episode[12];
+    char profile[64];
+} frame_meta_headers_t;
+
+// Añade los metadatos del frame como cabeceras X-* de la respuesta
+static void set_frame_meta_headers(httpd_req_t *req, const camera_frame_t *frame, frame_meta_headers_t *h) {
+    const camera_frame_meta_t *meta = &frame->meta;
     
-    httpd_resp_set_type(req, "text/html");
-    esp_err_t ret = httpd_resp_send(req, html_response, strlen(html_response));
+    snprintf(h->seq, sizeof(h->seq), "%lu", frame->seq);
+    snprintf(h->timestamp, sizeof(h->timestamp), "%llu", frame->timestamp);
+    snprintf(h->reason, sizeof(h->reason), "%u", meta->reason);
+    snprintf(h->latency, sizeof(h->latency), "%lu", meta->capture_latency_us);
+    snprintf(h->episode, sizeof(h->episode), "%lu", meta->episode_id);
+    snprintf(h->profile, sizeof(h->profile), "%s; aec=%u; agc=%u; ae=%d; q=%u",
+             meta->profile ? meta->profile : "-", meta->aec_value, meta->agc_gain,
+             meta->ae_level, meta->quality);
     
-    free(html_response);
-    return ret;
+    httpd_resp_set_hdr(req, "X-Frame-Seq", h->seq);
+    httpd_resp_set_hdr(req, "X-Frame-Timestamp", h->timestamp);
+    httpd_resp_set_hdr(req, "X-Capture-Reason", h->reason);
+    httpd_resp_set_hdr(req, "X-Capture-Latency-Us", h->latency);
+    httpd_resp_set_hdr(req, "X-Episode-Id", h->episode);
+    httpd_resp_set_hdr(req, "X-Sensor-Profile", h->profile);
+    if (meta->wall_time_ms != 0) {
+        snprintf(h->wall_time, sizeof(h->wall_time), "%lld", meta->wall_time_ms);
+        httpd_resp_set_hdr(req, "X-Capture-Time", h->wall_time);
+    }
 }
 
-static esp_err_t photo_handler(httpd_req_t *req) {
-    uint8_t* photo_buffer = NULL;
-    size_t photo_len = 0;
+// Valores de los validadores de caché (httpd solo guarda el puntero hasta el envío)
+typedef struct {
+    char etag[HTTP_ETAG_MAX_LEN];
+    char last_modified[HTTP_DATE_LEN];
+} cache_headers_t;
+
+// Añade ETag y Last-Modified del frame y comprueba si el cliente ya lo tiene
+// @return true si hay que responder 304 (el llamador envía la respuesta)
+static bool frame_not_modified(httpd_req_t *req, const camera_frame_t *frame, char variant,
+                               size_t body_len, cache_headers_t *h) {
+    char condition[96];
+    bool not_modified = false;
+    
+    http_etag_format(h->etag, sizeof(h->etag), etag_epoch, frame->seq, variant);
+    bool has_date = http_date_format(h->last_modified, sizeof(h->last_modified),
+                                     frame->meta.wall_time_ms) > 0;
     
-    // Obtener datos de la foto desde el componente de cámara
-    esp_err_t ret = camera_manager_get_photo_data(&photo_buffer, &photo_len);
+    // no-cache: el navegador guarda la foto pero la revalida en cada recarga
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", h->etag);
+    if (has_date) {
+        httpd_resp_set_hdr(req, "Last-Modified", h->last_modified);
+    }
+    
+    // If-None-Match manda sobre If-Modified-Since (RFC 9110); la fecha solo tiene
+    // resolución de segundos, así que se exige el mismo valor que se envió
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", condition, sizeof(condition)) == ESP_OK) {
+        not_modified = http_etag_matches(condition, h->etag);
+    } else if (has_date &&
+               httpd_req_get_hdr_value_str(req, "If-Modified-Since", condition, sizeof(condition)) == ESP_OK) {
+        not_modified = strcmp(condition, h->last_modified) == 0;
+    }
     
-    if (ret == ESP_OK && photo_buffer != NULL && photo_len > 0) {
-        // Configurar headers HTTP para evitar cache
+    portENTER_CRITICAL(&photo_cache_lock);
+    photo_cache_stats.requests++;
+    if (not_modified) {
+        photo_cache_stats.not_modified++;
+        photo_cache_stats.bytes_saved += body_len;
+    }
+    portEXIT_CRITICAL(&photo_cache_lock);
+    
+    return not_modified;
+}
+
+static esp_err_t send_not_modified(httpd_req_t *req) {
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
+}
+
+// Dirección del cliente como IPv6 (las IPv4 como ::ffff:a.b.c.d)
+static bool client_address(httpd_req_t *req, uint8_t *addr) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    
+    if (getpeername(httpd_req_to_sockfd(req), (struct sockaddr *)&peer, &peer_len) != 0) {
+        return false;
+    }
+    memset(addr, 0, RATE_LIMIT_ADDR_LEN);
+    if (peer.ss_family == AF_INET6) {
+        memcpy(addr, &((struct sockaddr_in6 *)&peer)->sin6_addr, RATE_LIMIT_ADDR_LEN);
+    } else if (peer.ss_family == AF_INET) {
+        addr[10] = 0xff;
+        addr[11] = 0xff;
+        memcpy(addr + 12, &((struct sockaddr_in *)&peer)->sin_addr, 4);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Admisión antes de cualquier trabajo: si la cubeta del cliente está vacía responde 503
+// con Retry-After desde httpd, sin pool, sin frame y sin reservar memoria, y cierra el
+// socket para que un cliente en bucle no retenga uno de los pocos que hay
+static bool admit_client(httpd_req_t *req, rate_limit_class_t cls) {
+    uint8_t addr[RATE_LIMIT_ADDR_LEN];
+    uint32_t retry_after_s = 0;
+    
+    if (!client_address(req, addr)) {
+        return true;
+    }
+    portENTER_CRITICAL(&limiter_lock);
+    bool allowed = rate_limit_allow(&limiter, addr, cls, esp_timer_get_time(), &retry_after_s);
+    portEXIT_CRITICAL(&limiter_lock);
+    if (allowed) {
+        return true;
+    }
+    
+    metrics_counter_add(cls == RATE_LIMIT_STREAM ? &stream_limited :
+                        cls == RATE_LIMIT_HISTORY ? &history_limited : &photo_limited, 1);
+    char retry_after[12];
+    snprintf(retry_after, sizeof(retry_after), "%lu", (unsigned long)retry_after_s);
+    const char* limited_msg = "Demasiadas peticiones desde esta dirección, reintentar más tarde";
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", retry_after);
+    httpd_resp_send(req, limited_msg, strlen(limited_msg));
+    httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+    return false;
+}
+
+// Un 304 no envía cuerpo: el token que cobró admit_client() vuelve a la cubeta
+static void refund_client(httpd_req_t *req, rate_limit_class_t cls) {
+    uint8_t addr[RATE_LIMIT_ADDR_LEN];
+    
+    if (!client_address(req, addr)) {
+        return;
+    }
+    portENTER_CRITICAL(&limiter_lock);
+    rate_limit_refund(&limiter, addr, cls);
+    portEXIT_CRITICAL(&limiter_lock);
+}
+
+static esp_err_t photo_handler(httpd_req_t *req) {
+    if (!admit_client(req, RATE_LIMIT_PHOTO)) {
+        return ESP_OK;
+    }
+    // El JPEG puede tardar segundos en llegar a un cliente lento: se envía desde el pool
+    return http_workers_submit(req, photo_send);
+}
+
+static esp_err_t photo_send(httpd_req_t *req) {
+    return timed_respond(req, photo_respond, &photo_latency);
+}
+
+static esp_err_t photo_respond(httpd_req_t *req) {
+    // Adquirir referencia al frame más reciente (sin copiar ni bloquear al productor)
+    camera_frame_t *frame = camera_frame_acquire();
+    
+    if (frame != NULL && frame->len > 0) {
+        frame_meta_headers_t headers;
+        cache_headers_t cache_headers;
+        
+        // El seq identifica la foto: si el cliente ya la tiene no se envía el JPEG
+        if (frame_not_modified(req, frame, '\0', frame->len, &cache_headers)) {
+            camera_frame_release(frame);
+            refund_client(req, RATE_LIMIT_PHOTO);
+            return send_not_modified(req);
+        }
+        
         httpd_resp_set_type(req, "image/jpeg");
-        httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
-        httpd_resp_set_hdr(req, "Pragma", "no-cache");
-        httpd_resp_set_hdr(req, "Expires", "0");
         
-        return httpd_resp_send(req, (const char*)photo_buffer, photo_len);
+        // Metadatos del mismo frame: sin llamadas extra al módulo de cámara
+        set_frame_meta_headers(req, frame, &headers);
+        
+        // El slot no se reutiliza hasta liberar la referencia
+        esp_err_t ret = httpd_resp_send(req, (const char*)frame->buf, frame->len);
+        camera_frame_release(frame);
+        return ret;
     } else {
+        camera_frame_release(frame);
+        
         // No hay foto disponible
         const char* no_photo_msg = "No hay foto disponible";
         httpd_resp_set_type(req, "text/plain");
@@ -380,18 +924,344 @@ static esp_err_t photo_handler(httpd_req_t *req) {
     }
 }
 
-static esp_err_t status_handler(httpd_req_t *req) {
+static esp_err_t thumb_handler(httpd_req_t *req) {
+    if (!admit_client(req, RATE_LIMIT_PHOTO)) {
+        return ESP_OK;
+    }
+    return http_workers_submit(req, thumb_send);
+}
+
+static esp_err_t thumb_send(httpd_req_t *req) {
+    return timed_respond(req, thumb_respond, &thumb_latency);
+}
+
+static esp_err_t thumb_respond(httpd_req_t *req) {
+    // La miniatura vive en el mismo slot que la foto: misma referencia, mismo frame
+    camera_frame_t *frame = camera_frame_acquire();
+    
+    if (frame != NULL && frame->thumb_len > 0) {
+        cache_headers_t cache_headers;
+        
+        if (frame_not_modified(req, frame, 't', frame->thumb_len, &cache_headers)) {
+            camera_frame_release(frame);
+            refund_client(req, RATE_LIMIT_PHOTO);
+            return send_not_modified(req);
+        }
+        
+        httpd_resp_set_type(req, "image/jpeg");
+        
+        esp_err_t ret = httpd_resp_send(req, (const char*)frame->thumb, frame->thumb_len);
+        camera_frame_release(frame);
+        return ret;
+    } else {
+        camera_frame_release(frame);
+        
+        const char* no_thumb_msg = "No hay miniatura disponible";
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "404 Not Found");
+        return httpd_resp_send(req, no_thumb_msg, strlen(no_thumb_msg));
+    }
+}
+
+static esp_err_t photo_meta_respond(httpd_req_t *req) {
+    camera_frame_t *frame = camera_frame_acquire();
+    
+    if (frame == NULL) {
+        const char* no_photo_msg = "{\"error\":\"No hay foto disponible\"}";
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_status(req, "404 Not Found");
+        return httpd_resp_send(req, no_photo_msg, strlen(no_photo_msg));
+    }
+    
+    char meta_json[640];
+    int len = camera_frame_meta_to_json(frame, meta_json, sizeof(meta_json));
+    camera_frame_release(frame);
+    
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    return httpd_resp_send(req, meta_json, len < (int)sizeof(meta_json) ? len : (int)sizeof(meta_json) - 1);
+}
+
+// Número decimal sin signo de 32 bits, completo (sin signo, espacios ni restos)
+static bool parse_u32(const char *text, uint32_t *value) {
+    char *end = NULL;
+    
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (*end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+static esp_err_t send_bad_request(httpd_req_t *req, const char *msg) {
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_status(req, "400 Bad Request");
+    return httpd_resp_send(req, msg, strlen(msg));
+}
+
+static esp_err_t photos_respond(httpd_req_t *req) {
+    char query[64];
+    char value[16];
+    uint32_t since = 0;
+    uint32_t limit = PHOTOS_DEFAULT_LIMIT;
+    
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK &&
+            !parse_u32(value, &since)) {
+            return send_bad_request(req, "since debe ser un número de secuencia");
+        }
+        if (httpd_query_key_value(query, "limit", value, sizeof(value)) == ESP_OK &&
+            (!parse_u32(value, &limit) || limit == 0)) {
+            return send_bad_request(req, "limit debe ser mayor que 0");
+        }
+    }
+    
+    // Página e índice JSON en el heap: no caben en la pila de httpd
+    const size_t size = PHOTOS_JSON_SIZE;
+    photo_history_page_t *page = malloc(sizeof(photo_history_page_t));
+    char *json = malloc(size);
+    if (page == NULL || json == NULL) {
+        free(page);
+        free(json);
+        ESP_LOGE(TAG, "Error asignando memoria para el índice de fotos");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    photo_history_list(since, limit, page);
+    int len = photo_history_page_json(page, json, size);
+    free(page);
+    
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    esp_err_t ret = httpd_resp_send(req, json, len < (int)size ? len : (int)size - 1);
+    free(json);
+    return ret;
+}
+
+static esp_err_t events_history_respond(httpd_req_t *req) {
+    char query[80];
+    char value[16];
+    uint32_t after = 0;
+    uint32_t limit = EVENTS_HISTORY_DEFAULT_LIMIT;
+    bool binary = false;
+    
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "after", value, sizeof(value)) == ESP_OK &&
+            !parse_u32(value, &after)) {
+            return send_bad_request(req, "after debe ser un id de evento");
+        }
+        if (httpd_query_key_value(query, "limit", value, sizeof(value)) == ESP_OK &&
+            (!parse_u32(value, &limit) || limit == 0)) {
+            return send_bad_request(req, "limit debe ser mayor que 0");
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            if (strcmp(value, "bin") == 0) {
+                binary = true;
+            } else if (strcmp(value, "json") != 0) {
+                return send_bad_request(req, "format debe ser json o bin");
+            }
+        }
+    }
+    
+    // Página y respuesta en el heap: no caben en la pila de httpd
+    const size_t size = binary ? EVENTS_HISTORY_BIN_SIZE : EVENTS_HISTORY_JSON_SIZE;
+    event_journal_page_t *page = malloc(sizeof(event_journal_page_t));
+    char *body = malloc(size);
+    if (page == NULL || body == NULL) {
+        free(page);
+        free(body);
+        ESP_LOGE(TAG, "Error asignando memoria para el diario de eventos");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    event_journal_read(after, limit, page);
+    int len;
+    if (binary) {
+        len = (int)event_journal_page_binary(page, (uint8_t *)body, size);
+        httpd_resp_set_type(req, EVENT_JOURNAL_CONTENT_TYPE_BIN);
+    } else {
+        len = event_journal_page_json(page, body, size);
+        if (len >= (int)size) {
+            len = (int)size - 1;
+        }
+        httpd_resp_set_type(req, "application/json");
+    }
+    free(page);
+    
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    esp_err_t ret = httpd_resp_send(req, body, len);
+    free(body);
+    return ret;
+}
+
+static esp_err_t photo_seq_handler(httpd_req_t *req) {
+    // Cubeta propia: ponerse al día con el historial no agota la de /photo
+    if (!admit_client(req, RATE_LIMIT_HISTORY)) {
+        return ESP_OK;
+    }
+    return http_workers_submit(req, photo_seq_send);
+}
+
+static esp_err_t photo_seq_send(httpd_req_t *req) {
+    return timed_respond(req, photo_seq_respond, &photo_seq_latency);
+}
+
+static esp_err_t photo_seq_respond(httpd_req_t *req) {
+    // "/photo/123" o "/photo/123?..." (la consulta no forma parte de la secuencia)
+    char seq_text[16];
+    const char *start = req->uri + strlen("/photo/");
+    size_t seq_len = strcspn(start, "?");
+    uint32_t seq = 0;
+    
+    camera_frame_t *frame = NULL;
+    if (seq_len < sizeof(seq_text)) {
+        memcpy(seq_text, start, seq_len);
+        seq_text[seq_len] = '\0';
+        if (parse_u32(seq_text, &seq)) {
+            frame = photo_history_acquire(seq);
+        }
+    }
+    
+    if (frame == NULL) {
+        const char* gone_msg = "Foto fuera del historial (consultar /photos)";
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "404 Not Found");
+        return httpd_resp_send(req, gone_msg, strlen(gone_msg));
+    }
+    
+    // Mismo ETag que /photo para ese seq: una foto ya descargada como la última no se repite
+    cache_headers_t cache_headers;
+    if (frame_not_modified(req, frame, '\0', frame->len, &cache_headers)) {
+        photo_history_release(frame);
+        refund_client(req, RATE_LIMIT_HISTORY);
+        return send_not_modified(req);
+    }
+    
+    frame_meta_headers_t headers;
+    httpd_resp_set_type(req, "image/jpeg");
+    set_frame_meta_headers(req, frame, &headers);
+    
+    // La entrada no se expulsa del historial hasta liberar la referencia
+    esp_err_t ret = httpd_resp_send(req, (const char*)frame->buf, frame->len);
+    photo_history_release(frame);
+    return ret;
+}
+
+static esp_err_t preroll_handler(httpd_req_t *req) {
+    if (!admit_client(req, RATE_LIMIT_PHOTO)) {
+        return ESP_OK;
+    }
+    return http_workers_submit(req, preroll_send);
+}
+
+static esp_err_t preroll_send(httpd_req_t *req) {
+    return timed_respond(req, preroll_respond, &preroll_latency);
+}
+
+static void release_preroll_frames(camera_frame_t **frames, size_t count, const camera_frame_t *keep) {
+    for (size_t i = 0; i < count; i++) {
+        if (frames[i] != keep) {
+            preroll_ring_release(frames[i]);
+        }
+    }
+}
+
+static esp_err_t preroll_respond(httpd_req_t *req) {
+    char query[48];
+    char value[16];
+    uint32_t episode = 0;
+    uint32_t index = 0;
+    bool want_frame = false;
+    
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "episode", value, sizeof(value)) == ESP_OK &&
+            !parse_u32(value, &episode)) {
+            return send_bad_request(req, "episode debe ser un número de episodio");
+        }
+        if (httpd_query_key_value(query, "index", value, sizeof(value)) == ESP_OK) {
+            if (!parse_u32(value, &index)) {
+                return send_bad_request(req, "index debe ser la posición del frame en el episodio");
+            }
+            want_frame = true;
+        }
+    }
+    
+    // Sin ?episode= el congelado ahora; uno anterior ya se ha reciclado
+    if (episode == 0) {
+        episode = preroll_ring_get_stats().frozen_episode;
+    }
+    camera_frame_t *frames[PREROLL_EPISODE_MAX];
+    size_t count = episode != 0 ? preroll_ring_acquire_episode(episode, frames, PREROLL_EPISODE_MAX) : 0;
+    if (count == 0 || (want_frame && index >= count)) {
+        release_preroll_frames(frames, count, NULL);
+        const char* gone_msg = "Sin frames pre-disparo de ese episodio";
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "404 Not Found");
+        return httpd_resp_send(req, gone_msg, strlen(gone_msg));
+    }
+    
+    if (!want_frame) {
+        char *json = malloc(PREROLL_JSON_SIZE);
+        if (json == NULL) {
+            release_preroll_frames(frames, count, NULL);
+            ESP_LOGE(TAG, "Error asignando memoria para el índice pre-disparo");
+            return ESP_ERR_NO_MEM;
+        }
+        int len = preroll_ring_episode_json(episode, frames, count, json, PREROLL_JSON_SIZE);
+        release_preroll_frames(frames, count, NULL);
+        
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        esp_err_t ret = httpd_resp_send(req, json, len < PREROLL_JSON_SIZE ? len : PREROLL_JSON_SIZE - 1);
+        free(json);
+        return ret;
+    }
+    
+    // Solo se retiene el frame pedido; el resto del episodio queda libre
+    camera_frame_t *frame = frames[index];
+    release_preroll_frames(frames, count, frame);
+    
+    // El anillo numera sus frames aparte del almacén: variante 'p' en el ETag
+    cache_headers_t cache_headers;
+    if (frame_not_modified(req, frame, 'p', frame->len, &cache_headers)) {
+        preroll_ring_release(frame);
+        refund_client(req, RATE_LIMIT_PHOTO);
+        return send_not_modified(req);
+    }
+    
+    frame_meta_headers_t headers;
+    httpd_resp_set_type(req, "image/jpeg");
+    set_frame_meta_headers(req, frame, &headers);
+    
+    // La entrada congelada no se recicla hasta liberar la referencia
+    esp_err_t ret = httpd_resp_send(req, (const char*)frame->buf, frame->len);
+    preroll_ring_release(frame);
+    return ret;
+}
+
+static esp_err_t status_respond(httpd_req_t *req) {
     server_state_t state = web_server_get_state();
     
-    char status_json[1024];
-    snprintf(status_json, sizeof(status_json),
+    // Los registros de /stream y /events crecen con los clientes: buffer dinámico
+    const size_t size = 4096;
+    char *status_json = malloc(size);
+    if (status_json == NULL) {
+        ESP_LOGE(TAG, "Error asignando memoria para estado");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    int len = snprintf(status_json, size,
         "{"
         "\"total_detections\":%lu,"
         "\"object_detected\":%s,"
         "\"sensor_state\":%d,"
         "\"has_photo\":%s,"
-        "\"last_update\":%llu"
-        "}",
+        "\"last_update\":%llu,"
+        "\"stream\":",
         state.total_detections,
         state.object_currently_detected ? "true" : "false",
         state.current_sensor_state,
@@ -399,6 +1269,407 @@ static esp_err_t status_handler(httpd_req_t *req) {
         state.last_update_time
     );
     
+    // Copia bajo el spinlock y formato fuera: snprintf no corre con las interrupciones enmascaradas
+    mjpeg_stream_t stream_copy;
+    web_server_get_stream_stats(&stream_copy);
+    if (len < (int)size) {
+        len += mjpeg_stream_stats_json(&stream_copy, status_json + len, size - len);
+    }
+    
+    portENTER_CRITICAL(&photo_cache_lock);
+    photo_cache_stats_t cache = photo_cache_stats;
+    portEXIT_CRITICAL(&photo_cache_lock);
+    if (len < (int)size) {
+        len += snprintf(status_json + len, size - len,
+                        ",\"photo_cache\":{\"requests\":%lu,\"not_modified\":%lu,\"bytes_saved\":%llu}",
+                        cache.requests, cache.not_modified, cache.bytes_saved);
+    }
+    if (len < (int)size) {
+        http_workers_stats_t workers;
+        http_workers_get_stats(&workers);
+        len += snprintf(status_json + len, size - len, ",\"workers\":");
+        if (len < (int)size) {
+            len += http_workers_stats_json(&workers, status_json + len, size - len);
+        }
+    }
+    if (len < (int)size) {
+        photo_history_stats_t history = photo_history_get_stats();
+        len += snprintf(status_json + len, size - len,
+                        ",\"history\":{\"count\":%lu,\"oldest\":%lu,\"latest\":%lu,\"bytes\":%zu,"
+                        "\"budget\":%zu,\"stored\":%lu,\"evicted\":%lu,\"dropped_busy\":%lu,"
+                        "\"dropped_too_large\":%lu,\"lookups\":%lu,\"misses\":%lu}",
+                        history.count, history.oldest_seq, history.latest_seq, history.bytes_used,
+                        history.memory_budget, history.stored, history.evicted, history.dropped_busy,
+                        history.dropped_too_large, history.lookups, history.misses);
+    }
+    if (len < (int)size) {
+        server_events_stats_t queue = server_events_get_stats();
+        len += snprintf(status_json + len, size - len,
+                        ",\"event_queue\":{\"posted\":%lu,\"dropped\":%lu,\"processed\":%lu,"
+                        "\"batches\":%lu,\"max_batch\":%lu}",
+                        queue.posted, queue.dropped, queue.processed, queue.batches, queue.max_batch);
+    }
+    if (len < (int)size) {
+        event_journal_stats_t journal = event_journal_get_stats();
+        len += snprintf(status_json + len, size - len,
+                        ",\"journal\":{\"capacity\":%zu,\"count\":%lu,\"oldest\":%lu,\"latest\":%lu,"
+                        "\"overwritten\":%lu,\"reads\":%lu}",
+                        journal.capacity, journal.count, journal.oldest_id, journal.latest_id,
+                        journal.overwritten, journal.reads);
+    }
+    if (len < (int)size) {
+        len += snprintf(status_json + len, size - len, ",\"rate_limit\":");
+    }
+    if (len < (int)size) {
+        // Igual que el stream: solo la copia de los contadores va bajo el spinlock
+        rate_limit_stats_t limits;
+        portENTER_CRITICAL(&limiter_lock);
+        rate_limit_get_stats(&limiter, &limits);
+        portEXIT_CRITICAL(&limiter_lock);
+        len += rate_limit_stats_json(&limits, status_json + len, size - len);
+    }
+    if (len < (int)size) {
+        len += snprintf(status_json + len, size - len, ",\"events\":");
+    }
+    if (len < (int)size) {
+        xSemaphoreTake(events_mutex, portMAX_DELAY);
+        len += sse_hub_stats_json(&events_hub, status_json + len, size - len);
+        xSemaphoreGive(events_mutex);
+    }
+    
+    if (len < (int)size - 1) {
+        status_json[len++] = '}';
+        status_json[len] = '\0';
+    }
+    
     httpd_resp_set_type(req, "application/json");
-    return httpd_resp_send(req, status_json, strlen(status_json));
-}
\ No newline at end of file
+    esp_err_t ret = httpd_resp_send(req, status_json, strlen(status_json));
+    free(status_json);
+    return ret;
+}
+
+// Cada bloque del registro sale como un fragmento HTTP
+static esp_err_t metrics_write_chunk(const char *text, size_t len, void *arg) {
+    return httpd_resp_send_chunk((httpd_req_t *)arg, text, len);
+}
+
+static esp_err_t metrics_respond(httpd_req_t *req) {
+    // Los indicadores se leen en el momento de la consulta
+    metrics_gauge_set(&heap_internal_free, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics_gauge_set(&heap_psram_free, heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    metrics_gauge_set(&heap_internal_min, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    metrics_gauge_set(&heap_psram_min, heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+    portENTER_CRITICAL(&stream_lock);
+    metrics_gauge_set(&stream_clients_gauge, stream.active);
+    portEXIT_CRITICAL(&stream_lock);
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    metrics_gauge_set(&events_clients_gauge, events_hub.active);
+    xSemaphoreGive(events_mutex);
+    
+    httpd_resp_set_type(req, METRICS_PROMETHEUS_CONTENT_TYPE);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    esp_err_t ret = metrics_export_prometheus(metrics_write_chunk, req);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Frames publicados por las dos fuentes del stream (avanza con cada frame nuevo)
+static uint32_t stream_published(void) {
+    return preroll_ring_get_stats().captured + frame_store_get_stats().published;
+}
+
+// Frame más reciente para el stream: el anillo de pre-disparo tiene la captura continua;
+// sin él (o si una foto es más nueva) se usa el almacén de fotos
+static camera_frame_t* stream_acquire_latest(bool *from_ring) {
+    camera_frame_t *ring = preroll_ring_acquire_latest();
+    camera_frame_t *photo = camera_frame_acquire();
+    
+    if (ring != NULL && (photo == NULL || ring->timestamp >= photo->timestamp)) {
+        camera_frame_release(photo);
+        *from_ring = true;
+        return ring;
+    }
+    
+    if (ring != NULL) {
+        preroll_ring_release(ring);
+    }
+    *from_ring = false;
+    return photo;
+}
+
+static void stream_release(camera_frame_t *frame, bool from_ring) {
+    if (from_ring) {
+        preroll_ring_release(frame);
+    } else {
+        camera_frame_release(frame);
+    }
+}
+
+// Envía una parte del multipart: cabecera, JPEG y fin de línea antes del siguiente delimitador
+static esp_err_t stream_send_frame(httpd_req_t *req, const camera_frame_t *frame) {
+    char part[MJPEG_STREAM_PART_HEADER_MAX];
+    int len = mjpeg_stream_part_header(part, sizeof(part), frame->len, frame->timestamp, frame->seq);
+    
+    esp_err_t ret = httpd_resp_send_chunk(req, part, len);
+    if (ret == ESP_OK) {
+        ret = httpd_resp_send_chunk(req, (const char*)frame->buf, frame->len);
+    }
+    if (ret == ESP_OK) {
+        ret = httpd_resp_send_chunk(req, "\r\n", 2);
+    }
+    return ret;
+}
+
+// Una tarea por cliente: el envío bloqueante de un cliente lento no frena a la cámara,
+// a los demás clientes ni al resto de handlers (httpd atiende un socket cada vez)
+static void stream_client_task(void *pvParameters) {
+    stream_client_ctx_t *ctx = (stream_client_ctx_t *)pvParameters;
+    uint32_t period_us = mjpeg_stream_period_us(&stream);
+    uint64_t last_timestamp = 0;
+    uint32_t client_id = ctx->client->id;
+    
+    while (server_running) {
+        uint64_t tick_start = esp_timer_get_time();
+        uint32_t published = stream_published();
+        
+        portENTER_CRITICAL(&stream_lock);
+        bool fresh = mjpeg_client_has_new(ctx->client, published);
+        portEXIT_CRITICAL(&stream_lock);
+        
+        if (fresh) {
+            bool from_ring = false;
+            camera_frame_t *frame = stream_acquire_latest(&from_ring);
+            
+            // El contador avanza también con frames que no se publican como "último"
+            // (p. ej. una foto más antigua que el anillo): solo se envía si es más nuevo
+            if (frame != NULL && frame->len > 0 && frame->timestamp > last_timestamp) {
+                size_t bytes = frame->len;
+                last_timestamp = frame->timestamp;
+                
+                esp_err_t ret = stream_send_frame(ctx->req, frame);
+                stream_release(frame, from_ring);
+                if (ret != ESP_OK) {
+                    break;
+                }
+                
+                uint32_t send_us = (uint32_t)(esp_timer_get_time() - tick_start);
+                portENTER_CRITICAL(&stream_lock);
+                mjpeg_client_account(ctx->client, published, period_us, bytes, send_us);
+                portEXIT_CRITICAL(&stream_lock);
+            } else if (frame != NULL) {
+                stream_release(frame, from_ring);
+            }
+        }
+        
+        // Siguiente periodo; si el envío ya lo agotó se cede la CPU un tick
+        uint64_t elapsed = esp_timer_get_time() - tick_start;
+        uint32_t wait_ms = elapsed < period_us ? (uint32_t)((period_us - elapsed) / 1000) : 0;
+        vTaskDelay(wait_ms > 0 ? pdMS_TO_TICKS(wait_ms) : 1);
+    }
+    
+    httpd_req_async_handler_complete(ctx->req);
+    
+    portENTER_CRITICAL(&stream_lock);
+    mjpeg_client_stats_t stats = ctx->client->stats;
+    mjpeg_stream_release(&stream, ctx->client);
+    portEXIT_CRITICAL(&stream_lock);
+    
+    ESP_LOGI(TAG, "📺 Cliente de stream #%lu desconectado: %lu enviados, %lu perdidos, %lu omitidos",
+             client_id, stats.sent, stats.dropped, stats.skipped);
+    free(ctx);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t stream_handler(httpd_req_t *req) {
+    if (!admit_client(req, RATE_LIMIT_STREAM)) {
+        return ESP_OK;
+    }
+    
+    // El id y la ocupación se copian aquí: tras crear la tarea el hueco puede liberarse ya
+    portENTER_CRITICAL(&stream_lock);
+    mjpeg_client_t *client = mjpeg_stream_claim(&stream, esp_timer_get_time());
+    uint32_t client_id = client != NULL ? client->id : 0;
+    uint8_t active = stream.active;
+    portEXIT_CRITICAL(&stream_lock);
+    
+    if (client == NULL) {
+        const char* busy_msg = "Stream ocupado, reintentar más tarde";
+        ESP_LOGW(TAG, "Cliente de stream rechazado: máximo de %u alcanzado", stream.config.max_clients);
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "5");
+        return httpd_resp_send(req, busy_msg, strlen(busy_msg));
+    }
+    
+    // La petición pasa a la tarea del cliente y httpd queda libre para los demás sockets
+    stream_client_ctx_t *ctx = malloc(sizeof(stream_client_ctx_t));
+    httpd_req_t *async_req = NULL;
+    if (ctx == NULL || httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        ESP_LOGE(TAG, "Error preparando petición asíncrona de stream");
+        free(ctx);
+        portENTER_CRITICAL(&stream_lock);
+        mjpeg_stream_release(&stream, client);
+        portEXIT_CRITICAL(&stream_lock);
+        return ESP_FAIL;
+    }
+    
+    ctx->req = async_req;
+    ctx->client = client;
+    httpd_resp_set_type(async_req, MJPEG_STREAM_CONTENT_TYPE);
+    httpd_resp_set_hdr(async_req, "Cache-Control", "no-cache, no-store, must-revalidate");
+    httpd_resp_set_hdr(async_req, "Pragma", "no-cache");
+    
+    if (xTaskCreate(stream_client_task, "mjpeg_stream", 4096, ctx, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de stream");
+        httpd_req_async_handler_complete(async_req);
+        free(ctx);
+        portENTER_CRITICAL(&stream_lock);
+        mjpeg_stream_release(&stream, client);
+        portEXIT_CRITICAL(&stream_lock);
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "📺 Cliente de stream #%lu conectado (%u/%u, %u fps)",
+             client_id, active, stream.config.max_clients, stream.config.fps);
+    return ESP_OK;
+}
+
+// Serializa un lote de eventos y lo reparte a los clientes de /events: el registro se
+// toma una vez y cada tarea de cliente se despierta una vez por lote
+static void publish_server_events(const server_event_t *events, size_t count) {
+    char data[160];
+    
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        const char *name = server_event_json(&events[i], data, sizeof(data));
+        if (name == NULL) {
+            continue;
+        }
+        if (sse_hub_publish(&events_hub, name, data, events[i].timestamp) == 0) {
+            ESP_LOGW(TAG, "Evento %s demasiado largo para /events", name);
+        }
+    }
+    xSemaphoreGive(events_mutex);
+    
+    wake_events_clients();
+}
+
+// Despierta a todas las tareas de /events (al detener el servidor)
+static void wake_events_clients(void) {
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    for (int i = 0; i < SSE_HUB_MAX_CLIENTS; i++) {
+        if (events_hub.clients[i].in_use && events_hub.clients[i].owner != NULL) {
+            xTaskNotifyGive((TaskHandle_t)events_hub.clients[i].owner);
+        }
+    }
+    xSemaphoreGive(events_mutex);
+}
+
+// Una tarea por cliente: duerme hasta que la tarea de eventos la notifica y vacía su
+// cola; sin eventos envía un comentario periódico para detectar clientes caídos
+static void events_client_task(void *pvParameters) {
+    events_client_ctx_t *ctx = (events_client_ctx_t *)pvParameters;
+    sse_entry_t entry;
+    uint32_t client_id;
+    esp_err_t ret;
+    
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    ctx->client->owner = xTaskGetCurrentTaskHandle();
+    client_id = ctx->client->id;
+    xSemaphoreGive(events_mutex);
+    
+    // Primer envío: cabeceras y reintento del navegador tras una desconexión
+    ret = httpd_resp_send_chunk(ctx->req, "retry: 3000\n\n", strlen("retry: 3000\n\n"));
+    
+    while (ret == ESP_OK && server_running) {
+        while (server_running) {
+            xSemaphoreTake(events_mutex, portMAX_DELAY);
+            bool pending = sse_client_pop(ctx->client, &entry);
+            xSemaphoreGive(events_mutex);
+            if (!pending) {
+                break;
+            }
+            
+            ret = httpd_resp_send_chunk(ctx->req, entry.text, entry.len);
+            if (ret != ESP_OK) {
+                break;
+            }
+            
+            uint64_t now = esp_timer_get_time();
+            uint32_t latency_us = now > entry.timestamp ? (uint32_t)(now - entry.timestamp) : 0;
+            xSemaphoreTake(events_mutex, portMAX_DELAY);
+            sse_client_account(ctx->client, latency_us);
+            xSemaphoreGive(events_mutex);
+        }
+        
+        if (ret != ESP_OK || !server_running) {
+            break;
+        }
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EVENTS_KEEPALIVE_MS)) == 0) {
+            ret = httpd_resp_send_chunk(ctx->req, ": ping\n\n", strlen(": ping\n\n"));
+        }
+    }
+    
+    httpd_req_async_handler_complete(ctx->req);
+    
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    sse_client_stats_t stats = ctx->client->stats;
+    sse_hub_release(&events_hub, ctx->client);
+    xSemaphoreGive(events_mutex);
+    
+    ESP_LOGI(TAG, "📡 Cliente de eventos #%lu desconectado: %lu enviados, %lu descartados",
+             client_id, stats.sent, stats.dropped);
+    free(ctx);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t events_handler(httpd_req_t *req) {
+    // El id se copia aquí: tras crear la tarea el hueco puede liberarse ya
+    xSemaphoreTake(events_mutex, portMAX_DELAY);
+    sse_client_t *client = sse_hub_claim(&events_hub);
+    uint32_t client_id = client != NULL ? client->id : 0;
+    uint8_t active = events_hub.active;
+    xSemaphoreGive(events_mutex);
+    
+    if (client == NULL) {
+        const char* busy_msg = "Eventos ocupados, reintentar más tarde";
+        ESP_LOGW(TAG, "Cliente de eventos rechazado: máximo de %u alcanzado", events_hub.config.max_clients);
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "5");
+        return httpd_resp_send(req, busy_msg, strlen(busy_msg));
+    }
+    
+    // La petición pasa a la tarea del cliente y httpd queda libre para los demás sockets
+    events_client_ctx_t *ctx = malloc(sizeof(events_client_ctx_t));
+    httpd_req_t *async_req = NULL;
+    if (ctx == NULL || httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        ESP_LOGE(TAG, "Error preparando petición asíncrona de eventos");
+        free(ctx);
+        xSemaphoreTake(events_mutex, portMAX_DELAY);
+        sse_hub_release(&events_hub, client);
+        xSemaphoreGive(events_mutex);
+        return ESP_FAIL;
+    }
+    
+    ctx->req = async_req;
+    ctx->client = client;
+    httpd_resp_set_type(async_req, SSE_CONTENT_TYPE);
+    httpd_resp_set_hdr(async_req, "Cache-Control", "no-cache");
+    
+    if (xTaskCreate(events_client_task, "sse_events", 3072, ctx, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de eventos");
+        httpd_req_async_handler_complete(async_req);
+        free(ctx);
+        xSemaphoreTake(events_mutex, portMAX_DELAY);
+        sse_hub_release(&events_hub, client);
+        xSemaphoreGive(events_mutex);
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "📡 Cliente de eventos #%lu conectado (%u/%u)",
+             client_id, active, events_hub.config.max_clients);
+    return ESP_OK;
+}
@@ -0,0 +1,64 @@
+// Monitor del gallinero: la foto llega por /stream y el estado por /events (SSE).
+// Solo se sondea si el navegador no soporta SSE o si el servidor está lleno (503).
+'use strict';
+
+let polling = false;
+let photoTag = '';
+
+function setDetections(count) {
+  document.getElementById('detectionCount').textContent = count;
+}
+
+// Petición condicional: 304 sin cuerpo si la foto no cambió
+function refreshPhoto() {
+  fetch('/photo', { cache: 'no-cache' })
+    .then(response => {
+      const tag = response.headers.get('ETag');
+      if (!response.ok || tag === photoTag) return;
+      photoTag = tag;
+      return response.blob().then(blob => {
+        const img = document.getElementById('photo');
+        if (img.src.startsWith('blob:')) URL.revokeObjectURL(img.src);
+        img.src = URL.createObjectURL(blob);
+      });
+    })
+    .catch(error => console.error('Error:', error));
+}
+
+// Stream lleno o no disponible: volver a /photo
+function streamFailed() {
+  const img = document.getElementById('photo');
+  if (polling) {
+    img.alt = 'No hay foto disponible';
+    return;
+  }
+  polling = true;
+  refreshPhoto();
+  setInterval(refreshPhoto, 3000);
+}
+
+function refreshStatus() {
+  fetch('/status')
+    .then(response => response.json())
+    .then(data => setDetections(data.total_detections))
+    .catch(error => console.error('Error:', error));
+}
+
+function watchEvents() {
+  if (!window.EventSource) {
+    setInterval(refreshStatus, 3000);
+    return;
+  }
+  const events = new EventSource('/events');
+  events.addEventListener('detection_started', e => setDetections(JSON.parse(e.data).detections));
+  events.onerror = () => {
+    if (events.readyState === EventSource.CLOSED) setInterval(refreshStatus, 3000);
+  };
+}
+
+// El error del stream puede llegar antes de que se ejecute este script
+const photo = document.getElementById('photo');
+photo.addEventListener('error', streamFailed);
+if (photo.complete && photo.naturalWidth === 0) streamFailed();
+refreshStatus();
+watchEvents();
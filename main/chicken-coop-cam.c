@@ -18,6 +18,14 @@ static const char *TAG = "MAIN_SYSTEM";
 static int64_t last_whatsapp_time = 0;
 #define WHATSAPP_COOLDOWN_MS 10000
 
+// Posición del gallinero para el amanecer/atardecer del planificador día/noche
+#ifndef CONFIG_COOP_LATITUDE
+#define CONFIG_COOP_LATITUDE 4.711f     // Bogotá
+#endif
+#ifndef CONFIG_COOP_LONGITUDE
+#define CONFIG_COOP_LONGITUDE -74.072f
+#endif
+
 // Callback para detección confirmada de movimiento
 static void on_motion_detected(void) {
     int64_t current_time = esp_timer_get_time() / 1000; // Convertir a ms
@@ -75,6 +83,30 @@ void app_main(void) {
     camera_manager_auto_optimize_lighting();
     vTaskDelay(pdMS_TO_TICKS(1000));
     
+    // Captura continua pre-disparo (opcional): conserva los segundos previos a la detección
+    camera_preroll_config_t preroll_config = CAMERA_PREROLL_DEFAULT_CONFIG();
+    if (camera_manager_preroll_start(&preroll_config) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Captura pre-disparo no disponible, continuando sin ella");
+    }
+    
+    // Mantener el tamaño de cada foto cerca del presupuesto (día y noche por igual)
+    rate_control_config_t rate_config = RATE_CONTROL_DEFAULT_CONFIG();
+    if (camera_manager_rate_control_start(&rate_config) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Control de tamaño JPEG no disponible, calidad fija");
+    }
+    
+    // No guardar fotos periódicas casi idénticas mientras la gallina sigue echada
+    frame_dedupe_config_t dedupe_config = FRAME_DEDUPE_DEFAULT_CONFIG();
+    if (camera_manager_dedupe_start(&dedupe_config) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Deduplicación no disponible, se guardan todas las fotos");
+    }
+    
+    // VGA en reposo (vista previa y pre-disparo), HD durante los episodios de detección
+    capture_tier_config_t tier_config = CAPTURE_TIER_DEFAULT_CONFIG();
+    if (camera_manager_capture_tier_start(&tier_config) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Modos de captura no disponibles, resolución fija");
+    }
+    
     // 3. Inicializar WiFi
     ESP_LOGI(TAG, "Conectando a WiFi...");
     if (wifi_init_sta() != ESP_OK) {
@@ -91,6 +123,15 @@ void app_main(void) {
     }
     ESP_LOGI(TAG, "✅ NTP sincronizado");
     
+    // 3.1.1. Con el reloj en hora, el perfil día/noche sigue a la escena y al sol
+    day_night_config_t day_night_config = DAY_NIGHT_DEFAULT_CONFIG();
+    day_night_config.latitude = CONFIG_COOP_LATITUDE;
+    day_night_config.longitude = CONFIG_COOP_LONGITUDE;
+    day_night_config.use_solar = true;
+    if (camera_manager_day_night_start(&day_night_config) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Planificador día/noche no disponible, se mantiene el perfil de arranque");
+    }
+    
     // 3.2. Inicializar cliente CallMeBot
     ESP_LOGI(TAG, "Inicializando cliente WhatsApp...");
     if (callmebot_init() != ESP_OK) {
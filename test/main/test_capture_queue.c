@@ -0,0 +1,201 @@
+#include "unity.h"
+#include "capture_queue.h"
+#include "cam_reader.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+
+static const char *TAG = "TEST_CAPTURE_QUEUE";
+
+#define BENCH_REQUESTS      40
+#define BENCH_MAX_GAP_MS    300
+
+void test_capture_queue_priority_and_coalescing(void) {
+    ESP_LOGI(TAG, "Testing capture queue ordering and coalescing");
+
+    capture_queue_entry_t batch[8];
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_init(4));
+
+    camera_capture_request_t periodic = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_PERIODIC);
+    periodic.priority = CAMERA_CAPTURE_PRIORITY_LOW;
+    camera_capture_request_t detection = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_DETECTION);
+    detection.priority = CAMERA_CAPTURE_PRIORITY_HIGH;
+    camera_capture_request_t web_vga = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_HTTP);
+    web_vga.frame_size = 8;
+
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&periodic, 100));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&web_vga, 200));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&detection, 300));
+
+    // La detección va primero y se lleva la periódica (misma configuración efectiva)
+    size_t count = capture_queue_pop_batch(11, 12, batch, 8);
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_DETECTION, batch[0].request.reason);
+    TEST_ASSERT_EQUAL(11, batch[0].request.frame_size);
+    TEST_ASSERT_EQUAL(12, batch[0].request.quality);
+    TEST_ASSERT_EQUAL(300, batch[0].submit_time);
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_PERIODIC, batch[1].request.reason);
+
+    // La solicitud VGA necesita su propio frame
+    count = capture_queue_pop_batch(11, 12, batch, 8);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(8, batch[0].request.frame_size);
+    TEST_ASSERT_EQUAL(0, capture_queue_pop_batch(11, 12, batch, 8));
+
+    // Cola llena
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&periodic, 400 + i));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, capture_queue_push(&detection, 500));
+    TEST_ASSERT_EQUAL(4, capture_queue_pop_batch(11, 12, batch, 8));
+
+    capture_queue_stats_t stats = capture_queue_get_stats();
+    TEST_ASSERT_EQUAL(7, stats.submitted);
+    TEST_ASSERT_EQUAL(1, stats.rejected);
+    TEST_ASSERT_EQUAL(4, stats.coalesced);
+    TEST_ASSERT_EQUAL(3, stats.batches);
+    TEST_ASSERT_EQUAL(0, stats.pending);
+
+    // Nombres de camera_manager_take_photo(): el pre-disparo y el texto libre son manuales
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_DETECTION, camera_capture_reason_from_name("detección inicial"));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_PERIODIC, camera_capture_reason_from_name("objeto permanece presente"));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_HTTP, camera_capture_reason_from_name("solicitud web"));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_MANUAL, camera_capture_reason_from_name("pre-disparo"));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_MANUAL, camera_capture_reason_from_name("prueba"));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_MANUAL, camera_capture_reason_from_name(NULL));
+
+    // Cerrada al terminar la tarea de captura: rechaza las nuevas y el último vaciado
+    // alcanza a todas las aceptadas antes
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&periodic, 600));
+    capture_queue_close();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, capture_queue_push(&detection, 700));
+    TEST_ASSERT_EQUAL(1, capture_queue_pop_batch(11, 12, batch, 8));
+    TEST_ASSERT_EQUAL(600, batch[0].submit_time);
+    TEST_ASSERT_EQUAL(0, capture_queue_get_stats().pending);
+
+    capture_queue_deinit();
+
+    // Una cola nueva vuelve a aceptar solicitudes
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_init(4));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&periodic, 800));
+    capture_queue_deinit();
+}
+
+void test_capture_queue_deadlines(void) {
+    ESP_LOGI(TAG, "Testing capture queue deadlines");
+
+    capture_queue_entry_t batch[4];
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_init(4));
+
+    camera_capture_request_t late = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_MANUAL);
+    late.deadline = 5000;
+    camera_capture_request_t urgent = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_MANUAL);
+    urgent.deadline = 2000;
+    urgent.frame_size = 5;
+    camera_capture_request_t relaxed = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_HTTP);
+    relaxed.frame_size = 6;
+
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&relaxed, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&late, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&urgent, 0));
+    TEST_ASSERT_EQUAL(2000, capture_queue_next_deadline());
+
+    // Misma prioridad: gana el plazo más cercano, sin plazo va al final
+    TEST_ASSERT_EQUAL(1, capture_queue_pop_batch(11, 12, batch, 4));
+    TEST_ASSERT_EQUAL(5, batch[0].request.frame_size);
+    TEST_ASSERT_EQUAL(5000, capture_queue_next_deadline());
+
+    TEST_ASSERT_EQUAL(0, capture_queue_take_expired(4999, batch, 4));
+    TEST_ASSERT_EQUAL(1, capture_queue_take_expired(5000, batch, 4));
+    TEST_ASSERT_EQUAL(5000, batch[0].request.deadline);
+    TEST_ASSERT_EQUAL(0, capture_queue_next_deadline());
+
+    TEST_ASSERT_EQUAL(1, capture_queue_pop_batch(11, 12, batch, 4));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_HTTP, batch[0].request.reason);
+    TEST_ASSERT_EQUAL(1, capture_queue_get_stats().expired);
+
+    // Una ráfaga no se agrupa detrás de una captura simple, pero sí al revés
+    camera_capture_request_t burst = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_DETECTION);
+    burst.burst_frames = 5;
+    camera_capture_request_t single = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_HTTP);
+    single.priority = CAMERA_CAPTURE_PRIORITY_HIGH;
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&burst, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&single, 0));
+    TEST_ASSERT_EQUAL(1, capture_queue_pop_batch(11, 12, batch, 4));
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_HTTP, batch[0].request.reason);
+    single.priority = CAMERA_CAPTURE_PRIORITY_LOW;
+    TEST_ASSERT_EQUAL(ESP_OK, capture_queue_push(&single, 0));
+    TEST_ASSERT_EQUAL(2, capture_queue_pop_batch(11, 12, batch, 4));
+    TEST_ASSERT_EQUAL(5, batch[0].request.burst_frames);
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_HTTP, batch[1].request.reason);
+
+    capture_queue_deinit();
+}
+
+// Resultados del benchmark (escritos desde la tarea de captura)
+static uint32_t bench_latency_us[BENCH_REQUESTS];
+static uint32_t bench_done = 0;
+static uint32_t bench_failed = 0;
+static SemaphoreHandle_t bench_sem = NULL;
+
+static void bench_done_cb(const camera_capture_result_t *result, void *arg) {
+    uint32_t index = (uint32_t)(uintptr_t)arg;
+    if (result->status == ESP_OK) {
+        bench_latency_us[index] = (uint32_t)(result->frame_time - result->request_time);
+    } else {
+        bench_latency_us[index] = UINT32_MAX;
+        bench_failed++;
+    }
+    bench_done++;
+    xSemaphoreGive(bench_sem);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void test_capture_latency_benchmark(void) {
+    ESP_LOGI(TAG, "Benchmark: request-to-frame latency with %d requests", BENCH_REQUESTS);
+
+    TEST_ASSERT_EQUAL(ESP_OK, camera_manager_init());
+    bench_sem = xSemaphoreCreateCounting(BENCH_REQUESTS, 0);
+    TEST_ASSERT_NOT_NULL(bench_sem);
+    bench_done = 0;
+    bench_failed = 0;
+
+    // Llegadas irregulares con prioridades mezcladas, como sensor + timer + web
+    for (uint32_t i = 0; i < BENCH_REQUESTS; i++) {
+        camera_capture_request_t request = CAMERA_CAPTURE_REQUEST_DEFAULT(CAMERA_CAPTURE_REASON_MANUAL);
+        request.priority = (camera_capture_priority_t)(esp_random() % 3);
+        request.done_cb = bench_done_cb;
+        request.done_arg = (void *)(uintptr_t)i;
+        TEST_ASSERT_EQUAL(ESP_OK, camera_manager_capture_async(&request));
+        vTaskDelay(pdMS_TO_TICKS(esp_random() % BENCH_MAX_GAP_MS));
+    }
+
+    for (int i = 0; i < BENCH_REQUESTS; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(bench_sem, pdMS_TO_TICKS(10000)));
+    }
+    vSemaphoreDelete(bench_sem);
+    bench_sem = NULL;
+
+    capture_queue_stats_t stats = camera_manager_get_capture_stats();
+    qsort(bench_latency_us, BENCH_REQUESTS, sizeof(uint32_t), compare_u32);
+    ESP_LOGI(TAG, "Latencia solicitud->frame: p50=%lu us p90=%lu us p99=%lu us max=%lu us",
+             bench_latency_us[BENCH_REQUESTS / 2],
+             bench_latency_us[BENCH_REQUESTS * 90 / 100],
+             bench_latency_us[BENCH_REQUESTS * 99 / 100],
+             bench_latency_us[BENCH_REQUESTS - 1]);
+    ESP_LOGI(TAG, "Capturas: %lu, agrupadas: %lu, fallidas: %lu",
+             stats.batches, stats.coalesced, bench_failed);
+
+    TEST_ASSERT_EQUAL(BENCH_REQUESTS, bench_done);
+    TEST_ASSERT_EQUAL(0, bench_failed);
+    TEST_ASSERT_EQUAL(BENCH_REQUESTS, stats.batches + stats.coalesced);
+}
@@ -0,0 +1,192 @@
+#include "unity.h"
+#include "capture_tier.h"
+#include "esp_log.h"
+
+static const char *TAG = "TEST_CAPTURE_TIER";
+
+#define FS_VGA      8
+#define FS_HD       11
+#define SECOND_US   1000000ULL
+
+// Corpus de test_jpeg_dc.c: 64x48 hace de resolución anterior y 128x64 de la nueva
+extern const uint8_t gray_422_start[] asm("_binary_gray_64x48_422_jpg_start");
+extern const uint8_t gray_422_end[] asm("_binary_gray_64x48_422_jpg_end");
+extern const uint8_t gradient_420_start[] asm("_binary_gradient_128x64_420_rst_jpg_start");
+extern const uint8_t gradient_420_end[] asm("_binary_gradient_128x64_420_rst_jpg_end");
+
+// Driver simulado: entrega una secuencia fija de frames y cuenta las devoluciones
+static const uint8_t *fake_bufs[8];
+static size_t fake_lens[8];
+static int fake_count;
+static int fake_next;
+static int fake_returned;
+
+static void fake_queue(const uint8_t *buf, size_t len) {
+    fake_bufs[fake_count] = buf;
+    fake_lens[fake_count] = len;
+    fake_count++;
+}
+
+static bool fake_get(capture_tier_frame_t *frame) {
+    if (fake_next >= fake_count) {
+        return false;
+    }
+    frame->buf = fake_bufs[fake_next];
+    frame->len = fake_lens[fake_next];
+    frame->handle = &fake_bufs[fake_next];
+    fake_next++;
+    return true;
+}
+
+static void fake_put(capture_tier_frame_t *frame) {
+    TEST_ASSERT_NOT_NULL(frame->handle);
+    fake_returned++;
+}
+
+static void fake_reset(void) {
+    fake_count = 0;
+    fake_next = 0;
+    fake_returned = 0;
+}
+
+void test_capture_tier_episode(void) {
+    ESP_LOGI(TAG, "Testing idle/active switching over a detection episode");
+
+    capture_tier_config_t config = CAPTURE_TIER_DEFAULT_CONFIG();
+    capture_tier_state_t state;
+    uint64_t now = 100 * SECOND_US;
+    TEST_ASSERT_EQUAL(ESP_OK, capture_tier_init(&state, &config, now));
+    TEST_ASSERT_EQUAL(CAPTURE_TIER_IDLE, state.stats.tier);
+    TEST_ASSERT_EQUAL(CAPTURE_TIER_IDLE, capture_tier_target(&state, now));
+    TEST_ASSERT_EQUAL(0, capture_tier_next_deadline(&state));
+
+    // Flanco del sensor: activo de inmediato, con la resolución y calidad del modo
+    capture_tier_activity(&state, now);
+    TEST_ASSERT_EQUAL(CAPTURE_TIER_ACTIVE, capture_tier_target(&state, now));
+    capture_tier_settings_t apply;
+    capture_tier_enter(&state, CAPTURE_TIER_ACTIVE, 12, now, &apply);
+    TEST_ASSERT_EQUAL(FS_HD, apply.frame_size);
+    TEST_ASSERT_EQUAL(12, apply.quality);
+    TEST_ASSERT_EQUAL(now + config.hold_ms * 1000ULL, capture_tier_next_deadline(&state));
+
+    // Fotos periódicas cada 2 s durante 30 s: sigue activo sin más cambios
+    for (int i = 0; i < 15; i++) {
+        now += 2 * SECOND_US;
+        capture_tier_activity(&state, now);
+        TEST_ASSERT_EQUAL(CAPTURE_TIER_ACTIVE, capture_tier_target(&state, now));
+    }
+    TEST_ASSERT_EQUAL(1, state.stats.switches_up);
+
+    // La gallina se va: activo hasta hold_ms después de la última foto
+    uint64_t last_activity = now;
+    now = last_activity + config.hold_ms * 1000ULL - 1;
+    TEST_ASSERT_EQUAL(CAPTURE_TIER_ACTIVE, capture_tier_target(&state, now));
+    now = last_activity + config.hold_ms * 1000ULL;
+    TEST_ASSERT_EQUAL(CAPTURE_TIER_IDLE, capture_tier_target(&state, now));
+
+    // El control de tamaño subió la calidad en HD: se guarda y se vuelve a la de reposo
+    capture_tier_enter(&state, CAPTURE_TIER_IDLE, 18, now, &apply);
+    TEST_ASSERT_EQUAL(FS_VGA, apply.frame_size);
+    TEST_ASSERT_EQUAL(12, apply.quality);
+    TEST_ASSERT_EQUAL(1, state.stats.switches_down);
+    TEST_ASSERT_EQUAL(0, capture_tier_next_deadline(&state));
+
+    // Siguiente episodio: HD retoma la calidad que había alcanzado
+    now += 60 * SECOND_US;
+    capture_tier_activity(&state, now);
+    capture_tier_enter(&state, CAPTURE_TIER_ACTIVE, 10, now, &apply);
+    TEST_ASSERT_EQUAL(FS_HD, apply.frame_size);
+    TEST_ASSERT_EQUAL(18, apply.quality);
+
+    // Entrar en el modo actual no cuenta como cambio
+    capture_tier_enter(&state, CAPTURE_TIER_ACTIVE, 18, now, &apply);
+    TEST_ASSERT_EQUAL(2, state.stats.switches_up);
+
+    // Tiempo en cada modo: 100 s desde el arranque hasta ahora
+    capture_tier_stats_t stats;
+    capture_tier_get_stats(&state, now + 5 * SECOND_US, &stats);
+    uint64_t active_us = 30 * SECOND_US + config.hold_ms * 1000ULL + 5 * SECOND_US;
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(active_us / 1000), (uint32_t)(stats.time_us[CAPTURE_TIER_ACTIVE] / 1000));
+    TEST_ASSERT_EQUAL_UINT32(60000, (uint32_t)(stats.time_us[CAPTURE_TIER_IDLE] / 1000));
+}
+
+void test_capture_tier_switch_stats(void) {
+    ESP_LOGI(TAG, "Testing resolution switch latency and flush accounting");
+
+    capture_tier_config_t config = CAPTURE_TIER_DEFAULT_CONFIG();
+    capture_tier_state_t state;
+    TEST_ASSERT_EQUAL(ESP_OK, capture_tier_init(&state, &config, 0));
+
+    capture_tier_record_switch(&state, 180000, 2, false);
+    capture_tier_record_switch(&state, 95000, 1, false);
+    capture_tier_record_switch(&state, 420000, config.max_flush_frames, true);
+    TEST_ASSERT_EQUAL(3, state.stats.size_switches);
+    TEST_ASSERT_EQUAL(3 + config.max_flush_frames, state.stats.flushed_frames);
+    TEST_ASSERT_EQUAL(1, state.stats.flush_timeouts);
+    TEST_ASSERT_EQUAL_UINT32(420000, state.stats.last_switch_us);
+    TEST_ASSERT_EQUAL_UINT32(420000, state.stats.max_switch_us);
+
+    // Configuraciones inválidas
+    config.hold_ms = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, capture_tier_init(&state, &config, 0));
+    config.hold_ms = 10000;
+    config.tiers[CAPTURE_TIER_IDLE].quality = 5;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, capture_tier_init(&state, &config, 0));
+    config.tiers[CAPTURE_TIER_IDLE].quality = 12;
+    config.tiers[CAPTURE_TIER_ACTIVE].frame_size = -1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, capture_tier_init(&state, &config, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, capture_tier_init(&state, NULL, 0));
+
+    TEST_ASSERT_EQUAL_STRING("reposo", capture_tier_name(CAPTURE_TIER_IDLE));
+    TEST_ASSERT_EQUAL_STRING("activo", capture_tier_name(CAPTURE_TIER_ACTIVE));
+}
+
+void test_capture_tier_flush_stale(void) {
+    ESP_LOGI(TAG, "Testing stale frame flush by JPEG SOF size");
+
+    capture_tier_config_t config = CAPTURE_TIER_DEFAULT_CONFIG();
+    capture_tier_state_t state;
+    TEST_ASSERT_EQUAL(ESP_OK, capture_tier_init(&state, &config, 0));
+    size_t old_len = gray_422_end - gray_422_start;
+    size_t new_len = gradient_420_end - gradient_420_start;
+    static const uint8_t garbage[] = { 0xFF, 0xD8, 0x00, 0x11, 0x22 };
+    bool fresh;
+
+    // Dos frames viejos y uno truncado se descartan; el nuevo termina la espera
+    fake_reset();
+    fake_queue(gray_422_start, old_len);
+    fake_queue(gray_422_start, old_len);
+    fake_queue(garbage, sizeof(garbage));
+    fake_queue(gradient_420_start, new_len);
+    fake_queue(gradient_420_start, new_len);
+    uint8_t flushed = capture_tier_flush(&state, fake_get, fake_put, 128, 64, &fresh);
+    TEST_ASSERT_TRUE(fresh);
+    TEST_ASSERT_EQUAL(3, flushed);
+    TEST_ASSERT_EQUAL(4, fake_next);
+    TEST_ASSERT_EQUAL(fake_next, fake_returned);
+
+    // Sin cambio de resolución real: se agota max_flush_frames
+    fake_reset();
+    for (int i = 0; i < 6; i++) {
+        fake_queue(gray_422_start, old_len);
+    }
+    flushed = capture_tier_flush(&state, fake_get, fake_put, 128, 64, &fresh);
+    TEST_ASSERT_FALSE(fresh);
+    TEST_ASSERT_EQUAL(config.max_flush_frames, flushed);
+    TEST_ASSERT_EQUAL(config.max_flush_frames, fake_returned);
+
+    // El driver deja de entregar frames: solo cuentan los descartados de verdad
+    fake_reset();
+    fake_queue(gray_422_start, old_len);
+    flushed = capture_tier_flush(&state, fake_get, fake_put, 128, 64, &fresh);
+    TEST_ASSERT_FALSE(fresh);
+    TEST_ASSERT_EQUAL(1, flushed);
+    TEST_ASSERT_EQUAL(1, fake_returned);
+
+    // Primer frame ya nuevo: nada descartado
+    fake_reset();
+    fake_queue(gradient_420_start, new_len);
+    flushed = capture_tier_flush(&state, fake_get, fake_put, 128, 64, &fresh);
+    TEST_ASSERT_TRUE(fresh);
+    TEST_ASSERT_EQUAL(0, flushed);
+}
@@ -0,0 +1,190 @@
+#include "unity.h"
+#include "day_night.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "TEST_DAY_NIGHT";
+
+// Traza de dos días del simulador de host (tools/day_night_sim): epoch_s,luma cada 2 minutos
+extern const char trace_start[] asm("_binary_coop_2days_csv_start");
+extern const char trace_end[] asm("_binary_coop_2days_csv_end");
+
+#define BOGOTA_LAT          4.711f
+#define BOGOTA_LON          -74.072f
+#define EQUINOX_2024_LOCAL  1710910800      // 2024-03-20 00:00 en Bogotá (UTC-5)
+#define SUNRISE_2024_03_20  1710932415      // 11:00:15 UTC (tablas publicadas)
+#define SUNSET_2024_03_20   1710976019      // 23:06:59 UTC
+
+// Perturbaciones de la traza que no deben cambiar el modo: [inicio, fin) en hora local
+static const struct {
+    int64_t start;
+    int64_t end;
+} disturbances[] = {
+    { EQUINOX_2024_LOCAL + 13 * 3600, EQUINOX_2024_LOCAL + 13 * 3600 + 1200 },         // Nubes
+    { EQUINOX_2024_LOCAL + 22 * 3600, EQUINOX_2024_LOCAL + 22 * 3600 + 240 },          // Linterna
+    { EQUINOX_2024_LOCAL + 26 * 3600, EQUINOX_2024_LOCAL + 26 * 3600 + 360 },          // Luz del galpón
+    { EQUINOX_2024_LOCAL + 39 * 3600, EQUINOX_2024_LOCAL + 39 * 3600 + 480 },          // Tormenta
+};
+
+static int64_t minutes_to_sun_event(const day_night_decision_t *decision, int64_t now) {
+    int64_t to_rise = llabs(now - decision->sunrise);
+    int64_t to_set = llabs(now - decision->sunset);
+    return (to_rise < to_set ? to_rise : to_set) / 60;
+}
+
+void test_day_night_solar_times(void) {
+    ESP_LOGI(TAG, "Testing sunrise and sunset against published tables");
+
+    int64_t sunrise, sunset;
+
+    // Bogotá, equinoccio: la mañana y la noche local pertenecen al mismo día solar
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_sun_times(BOGOTA_LAT, BOGOTA_LON, EQUINOX_2024_LOCAL + 7 * 3600,
+                                                  &sunrise, &sunset));
+    TEST_ASSERT_TRUE(llabs(sunrise - SUNRISE_2024_03_20) < 300);
+    TEST_ASSERT_TRUE(llabs(sunset - SUNSET_2024_03_20) < 300);
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_sun_times(BOGOTA_LAT, BOGOTA_LON, EQUINOX_2024_LOCAL + 21 * 3600,
+                                                  &sunrise, &sunset));
+    TEST_ASSERT_TRUE(llabs(sunrise - SUNRISE_2024_03_20) < 300);
+
+    // Madrid, solsticio de junio: 04:44 y 19:48 UTC
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_sun_times(40.417f, -3.704f, 1718971200, &sunrise, &sunset));
+    TEST_ASSERT_TRUE(llabs(sunrise - 1718945088) < 300);
+    TEST_ASSERT_TRUE(llabs(sunset - 1718999307) < 300);
+
+    // Noche polar en Svalbard: sin amanecer
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, day_night_sun_times(78.22f, 15.65f, 1703160000, &sunrise, &sunset));
+    TEST_ASSERT_EQUAL(0, sunrise);
+    TEST_ASSERT_EQUAL(0, sunset);
+}
+
+void test_day_night_trace_replay(void) {
+    ESP_LOGI(TAG, "Testing hysteresis over a two-day luma trace");
+
+    day_night_config_t config = DAY_NIGHT_DEFAULT_CONFIG();
+    config.latitude = BOGOTA_LAT;
+    config.longitude = BOGOTA_LON;
+    config.use_solar = true;
+    day_night_t dn;
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_init(&dn, &config));
+
+    // Reproducir como la tarea del firmware: evaluar cada eval_interval_s entre muestras
+    const char *p = trace_start;
+    int64_t next_eval = 0;
+    uint32_t changes = 0;
+    while (p < trace_end) {
+        char *line_end = NULL;
+        long long epoch = strtoll(p, &line_end, 10);
+        if (line_end != p && *line_end == ',') {
+            float luma = strtof(line_end + 1, NULL);
+            if (next_eval == 0) {
+                next_eval = epoch;
+            }
+            while (next_eval < epoch) {
+                day_night_decision_t decision;
+                if (day_night_evaluate(&dn, next_eval, &decision)) {
+                    changes++;
+                    ESP_LOGI(TAG, "%+lld h: %s (%s, fase %s, luma %.1f)",
+                             (long long)(next_eval - EQUINOX_2024_LOCAL) / 3600,
+                             day_night_mode_name(decision.mode), day_night_cause_name(decision.cause),
+                             day_night_phase_name(decision.phase), decision.luma);
+                    if (decision.cause != DAY_NIGHT_CAUSE_INITIAL) {
+                        // Los cambios ocurren junto al amanecer o al atardecer...
+                        TEST_ASSERT_EQUAL(DAY_NIGHT_CAUSE_LUMA, decision.cause);
+                        TEST_ASSERT_TRUE(minutes_to_sun_event(&decision, next_eval) < 60);
+                        // ...y nunca durante nubes, linternas o tormentas
+                        for (size_t i = 0; i < sizeof(disturbances) / sizeof(disturbances[0]); i++) {
+                            TEST_ASSERT_FALSE(next_eval >= disturbances[i].start &&
+                                              next_eval < disturbances[i].end + config.confirm_s);
+                        }
+                    }
+                }
+                next_eval += config.eval_interval_s;
+            }
+            day_night_add_luma(&dn, epoch, luma);
+        }
+        while (p < trace_end && *p != '\n') {
+            p++;
+        }
+        p++;
+    }
+
+    // Decisión inicial (noche a medianoche) + 2 amaneceres + 2 atardeceres
+    TEST_ASSERT_EQUAL(5, changes);
+    TEST_ASSERT_EQUAL(4, dn.stats.switches);
+    TEST_ASSERT_EQUAL(4, dn.stats.luma_switches);
+    TEST_ASSERT_EQUAL(DAY_NIGHT_NIGHT, dn.stats.mode);
+    TEST_ASSERT_TRUE(dn.stats.samples > 1400);
+}
+
+void test_day_night_dwell_and_solar_fallback(void) {
+    ESP_LOGI(TAG, "Testing confirm time, minimum dwell and stale-luma fallback");
+
+    day_night_config_t config = DAY_NIGHT_DEFAULT_CONFIG();
+    config.smoothing = 1.0f;      // Sin suavizado: cada muestra es la media
+    day_night_t dn;
+    day_night_decision_t decision;
+    int64_t t = 1000;
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_init(&dn, &config));
+
+    // Sin hora solar la primera decisión usa el centro de la banda
+    TEST_ASSERT_FALSE(day_night_evaluate(&dn, t, &decision));
+    day_night_add_luma(&dn, t, 150.0f);
+    TEST_ASSERT_TRUE(day_night_evaluate(&dn, t, &decision));
+    TEST_ASSERT_EQUAL(DAY_NIGHT_DAY, decision.mode);
+    TEST_ASSERT_EQUAL(DAY_NIGHT_CAUSE_INITIAL, decision.cause);
+
+    // Dentro de la banda de histéresis no hay cambio
+    day_night_add_luma(&dn, t += 60, 70.0f);
+    TEST_ASSERT_FALSE(day_night_evaluate(&dn, t, &decision));
+
+    // Oscuro, pero la condición debe mantenerse confirm_s y el día haber durado min_dwell_s
+    for (int i = 0; i < 20; i++) {
+        day_night_add_luma(&dn, t += 60, 20.0f);
+        TEST_ASSERT_FALSE(day_night_evaluate(&dn, t, &decision));
+    }
+    TEST_ASSERT_TRUE(dn.stats.dwell_blocked > 0);
+    while (t - 1000 < (int64_t)config.min_dwell_s) {
+        day_night_add_luma(&dn, t += 60, 20.0f);
+        day_night_evaluate(&dn, t, &decision);
+    }
+    TEST_ASSERT_EQUAL(DAY_NIGHT_NIGHT, dn.stats.mode);
+    TEST_ASSERT_EQUAL(1, dn.stats.switches);
+
+    // Un destello más corto que confirm_s no cuenta; una luz mantenida sí
+    t += config.min_dwell_s;
+    for (int i = 0; i < 5; i++) {
+        day_night_add_luma(&dn, t += 60, 200.0f);
+        TEST_ASSERT_FALSE(day_night_evaluate(&dn, t, &decision));
+    }
+    day_night_add_luma(&dn, t += 60, 20.0f);
+    TEST_ASSERT_FALSE(day_night_evaluate(&dn, t, &decision));
+    TEST_ASSERT_EQUAL(0, dn.pending_since);
+    for (int i = 0; i <= (int)(config.confirm_s / 60); i++) {
+        day_night_add_luma(&dn, t += 60, 200.0f);
+        day_night_evaluate(&dn, t, &decision);
+    }
+    TEST_ASSERT_EQUAL(DAY_NIGHT_DAY, dn.stats.mode);
+    TEST_ASSERT_EQUAL(2, dn.stats.switches);
+
+    // Sin muestras recientes manda la hora solar
+    config.latitude = BOGOTA_LAT;
+    config.longitude = BOGOTA_LON;
+    config.use_solar = true;
+    config.confirm_s = 0;
+    config.min_dwell_s = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, day_night_init(&dn, &config));
+    t = EQUINOX_2024_LOCAL + 3 * 3600;
+    day_night_add_luma(&dn, t, 10.0f);
+    TEST_ASSERT_TRUE(day_night_evaluate(&dn, t, &decision));
+    TEST_ASSERT_EQUAL(DAY_NIGHT_NIGHT, decision.mode);
+    TEST_ASSERT_EQUAL(SOLAR_PHASE_NIGHT, decision.phase);
+    TEST_ASSERT_TRUE(day_night_evaluate(&dn, EQUINOX_2024_LOCAL + 12 * 3600, &decision));
+    TEST_ASSERT_EQUAL(DAY_NIGHT_DAY, decision.mode);
+    TEST_ASSERT_EQUAL(DAY_NIGHT_CAUSE_SOLAR, decision.cause);
+    TEST_ASSERT_EQUAL(1, dn.stats.solar_switches);
+
+    // Configuración inválida
+    config.night_below = config.day_above;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, day_night_init(&dn, &config));
+}
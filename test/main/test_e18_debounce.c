@@ -0,0 +1,181 @@
+#include "unity.h"
+#include "e18_debounce.h"
+#include "esp_log.h"
+
+static const char *TAG = "TEST_E18_DEBOUNCE";
+
+#define MS          1000LL
+#define T0          (100 * 1000 * MS)   // Marcas de esp_timer lejos de 0
+#define MAX_EVENTS  16
+
+// Eventos generados al reproducir una secuencia de flancos
+typedef struct {
+    e18_debounce_event_t events[MAX_EVENTS];
+    int64_t at[MAX_EVENTS];
+    int count;
+} event_log_t;
+
+// Lo que hace la tarea de detección: resolver plazos hasta now
+static void advance_to(e18_debounce_t *state, int64_t now, event_log_t *log) {
+    e18_debounce_event_t event;
+    int64_t at;
+    while ((event = e18_debounce_advance(state, now, &at)) != E18_DEBOUNCE_NONE) {
+        TEST_ASSERT_LESS_THAN(MAX_EVENTS, log->count);
+        log->events[log->count] = event;
+        log->at[log->count] = at;
+        log->count++;
+    }
+}
+
+// Lo que hace la tarea de detección con cada flanco de la cola
+static void feed_edge(e18_debounce_t *state, int64_t timestamp, uint8_t level, event_log_t *log) {
+    e18_edge_t edge = { .timestamp = timestamp, .level = level };
+    advance_to(state, timestamp, log);
+    e18_debounce_edge(state, &edge);
+}
+
+void test_e18_debounce_confirm_and_release(void) {
+    ESP_LOGI(TAG, "Testing debounce and confirmation windows from edge timestamps");
+
+    e18_debounce_config_t config = E18_DEBOUNCE_DEFAULT_CONFIG();
+    e18_debounce_t state;
+    event_log_t log = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, e18_debounce_init(&state, NULL, E18_LEVEL_CLEAR, T0));
+    TEST_ASSERT_EQUAL(ESP_OK, e18_debounce_init(&state, &config, E18_LEVEL_CLEAR, T0));
+    TEST_ASSERT_EQUAL(E18_PHASE_CLEAR, state.phase);
+    TEST_ASSERT_EQUAL(0, e18_debounce_next_deadline(&state));
+
+    // Llega la gallina: el nivel es estable 50 ms después del flanco, no cuando se atiende
+    int64_t arrival = T0 + 5000 * MS;
+    feed_edge(&state, arrival, E18_LEVEL_OBJECT, &log);
+    TEST_ASSERT_EQUAL(0, log.count);
+    TEST_ASSERT_EQUAL(arrival + 50 * MS, e18_debounce_next_deadline(&state));
+    advance_to(&state, arrival + 50 * MS - 1, &log);
+    TEST_ASSERT_EQUAL(0, log.count);
+
+    // La tarea despierta tarde (200 ms): el inicio y la confirmación llevan su marca exacta
+    advance_to(&state, arrival + 200 * MS, &log);
+    TEST_ASSERT_EQUAL(1, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_ONSET, log.events[0]);
+    TEST_ASSERT_EQUAL(arrival + 50 * MS, log.at[0]);
+    TEST_ASSERT_EQUAL(E18_PHASE_CONFIRMING, state.phase);
+    TEST_ASSERT_EQUAL(arrival + 1050 * MS, e18_debounce_next_deadline(&state));
+
+    advance_to(&state, arrival + 1050 * MS, &log);
+    TEST_ASSERT_EQUAL(2, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_CONFIRMED, log.events[1]);
+    TEST_ASSERT_EQUAL(arrival + 1050 * MS, log.at[1]);
+    TEST_ASSERT_EQUAL(E18_PHASE_PRESENT, state.phase);
+    TEST_ASSERT_EQUAL(0, e18_debounce_next_deadline(&state));
+
+    // Un hueco de 20 ms en el haz (la gallina se mueve) no termina la detección
+    int64_t t = arrival + 10000 * MS;
+    feed_edge(&state, t, E18_LEVEL_CLEAR, &log);
+    feed_edge(&state, t + 20 * MS, E18_LEVEL_OBJECT, &log);
+    advance_to(&state, t + 5000 * MS, &log);
+    TEST_ASSERT_EQUAL(2, log.count);
+    TEST_ASSERT_EQUAL(1, state.stats.glitches);
+
+    // Se va: fin 50 ms después del flanco de salida
+    int64_t departure = t + 30000 * MS;
+    feed_edge(&state, departure, E18_LEVEL_CLEAR, &log);
+    advance_to(&state, departure + 60 * MS, &log);
+    TEST_ASSERT_EQUAL(3, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_RELEASED, log.events[2]);
+    TEST_ASSERT_EQUAL(departure + 50 * MS, log.at[2]);
+    TEST_ASSERT_EQUAL(E18_PHASE_CLEAR, state.phase);
+
+    // Sin timer hasta 10 s después: los dos eventos salen en orden y con su marca
+    int64_t second = departure + 60000 * MS;
+    feed_edge(&state, second, E18_LEVEL_OBJECT, &log);
+    advance_to(&state, second + 10000 * MS, &log);
+    TEST_ASSERT_EQUAL(5, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_ONSET, log.events[3]);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_CONFIRMED, log.events[4]);
+    TEST_ASSERT_EQUAL(second + 1050 * MS, log.at[4]);
+
+    TEST_ASSERT_EQUAL(2, state.stats.onsets);
+    TEST_ASSERT_EQUAL(2, state.stats.confirmed);
+    TEST_ASSERT_EQUAL(1, state.stats.released);
+    TEST_ASSERT_EQUAL(0, state.stats.false_alarms);
+    TEST_ASSERT_EQUAL_STRING("confirmada", e18_debounce_event_name(E18_DEBOUNCE_CONFIRMED));
+}
+
+void test_e18_debounce_bounce_and_false_alarm(void) {
+    ESP_LOGI(TAG, "Testing bouncing edges, false alarms and late edges");
+
+    e18_debounce_config_t config = E18_DEBOUNCE_DEFAULT_CONFIG();
+    e18_debounce_t state;
+    event_log_t log = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, e18_debounce_init(&state, &config, E18_LEVEL_CLEAR, T0));
+
+    // Rebotes: 6 cambios en 25 ms; la ventana cuenta desde el último flanco y cada vuelta
+    // al nivel estable anula el cambio pendiente
+    int64_t t = T0 + 1000 * MS;
+    for (int i = 0; i < 6; i++) {
+        feed_edge(&state, t + i * 5 * MS, (i % 2 == 0) ? E18_LEVEL_OBJECT : E18_LEVEL_CLEAR, &log);
+    }
+    int64_t settled = t + 30 * MS;
+    feed_edge(&state, settled, E18_LEVEL_OBJECT, &log);
+    TEST_ASSERT_EQUAL(0, log.count);
+    TEST_ASSERT_EQUAL(3, state.stats.glitches);
+    TEST_ASSERT_EQUAL(settled + 50 * MS, e18_debounce_next_deadline(&state));
+
+    // Dos flancos seguidos con el mismo nivel (rebote dentro de la ISR) no reinician la ventana
+    feed_edge(&state, settled + 10 * MS, E18_LEVEL_OBJECT, &log);
+    TEST_ASSERT_EQUAL(settled + 50 * MS, e18_debounce_next_deadline(&state));
+
+    advance_to(&state, settled + 50 * MS, &log);
+    TEST_ASSERT_EQUAL(1, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_ONSET, log.events[0]);
+
+    // Se va a los 500 ms, antes de confirmarse: falsa alarma al estabilizarse la salida
+    int64_t gone = settled + 500 * MS;
+    feed_edge(&state, gone, E18_LEVEL_CLEAR, &log);
+    TEST_ASSERT_EQUAL(gone + 50 * MS, e18_debounce_next_deadline(&state));
+    advance_to(&state, gone + 2000 * MS, &log);
+    TEST_ASSERT_EQUAL(2, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_FALSE_ALARM, log.events[1]);
+    TEST_ASSERT_EQUAL(gone + 50 * MS, log.at[1]);
+    TEST_ASSERT_EQUAL(E18_PHASE_CLEAR, state.phase);
+    TEST_ASSERT_EQUAL(0, e18_debounce_next_deadline(&state));
+
+    // La salida coincide con el plazo de confirmación: gana el cambio de nivel
+    int64_t third = gone + 10000 * MS;
+    feed_edge(&state, third, E18_LEVEL_OBJECT, &log);
+    feed_edge(&state, third + 1000 * MS, E18_LEVEL_CLEAR, &log);
+    advance_to(&state, third + 3000 * MS, &log);
+    TEST_ASSERT_EQUAL(4, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_ONSET, log.events[2]);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_FALSE_ALARM, log.events[3]);
+    TEST_ASSERT_EQUAL(third + 1050 * MS, log.at[3]);
+
+    // Un flanco con marca anterior a lo ya procesado se toma en el último instante
+    int64_t processed = state.now;
+    e18_edge_t late = { .timestamp = processed - 100 * MS, .level = E18_LEVEL_OBJECT };
+    e18_debounce_edge(&state, &late);
+    TEST_ASSERT_EQUAL(1, state.stats.late_edges);
+    TEST_ASSERT_EQUAL(processed + 50 * MS, e18_debounce_next_deadline(&state));
+
+    TEST_ASSERT_EQUAL(2, state.stats.false_alarms);
+    TEST_ASSERT_EQUAL(0, state.stats.confirmed);
+}
+
+void test_e18_debounce_object_at_boot(void) {
+    ESP_LOGI(TAG, "Testing an object already present at initialization");
+
+    e18_debounce_config_t config = { .debounce_ms = 20, .confirm_ms = 500 };
+    e18_debounce_t state;
+    event_log_t log = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, e18_debounce_init(&state, &config, E18_LEVEL_OBJECT, T0));
+
+    // Igual que un flanco en el arranque: plazos con la configuración dada
+    TEST_ASSERT_EQUAL(T0 + 20 * MS, e18_debounce_next_deadline(&state));
+    advance_to(&state, T0 + 520 * MS, &log);
+    TEST_ASSERT_EQUAL(2, log.count);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_ONSET, log.events[0]);
+    TEST_ASSERT_EQUAL(T0 + 20 * MS, log.at[0]);
+    TEST_ASSERT_EQUAL(E18_DEBOUNCE_CONFIRMED, log.events[1]);
+    TEST_ASSERT_EQUAL(T0 + 520 * MS, log.at[1]);
+    TEST_ASSERT_EQUAL(T0, state.onset);
+}
@@ -0,0 +1,200 @@
+#include "unity.h"
+#include "event_journal.h"
+#include "server_events.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "TEST_EVENT_JOURNAL";
+
+#define TEST_APPENDERS      4
+#define TEST_APPENDS        1000    // Por tarea
+
+static SemaphoreHandle_t done_sem = NULL;
+
+static server_event_t detection_event(uint32_t count) {
+    server_event_t event = {
+        .type = SERVER_EVENT_DETECTION_STARTED,
+        .timestamp = 1000ULL * count,
+        .object_detected = true,
+        .sensor_state = 0
+    };
+    event.detection_data.detection_count = count;
+    return event;
+}
+
+static void append_range(uint32_t first, uint32_t last) {
+    for (uint32_t i = first; i <= last; i++) {
+        server_event_t event = detection_event(i);
+        TEST_ASSERT_EQUAL(i, event_journal_append(&event));
+        TEST_ASSERT_EQUAL(i, event.id);
+    }
+}
+
+void test_event_journal_ranges(void) {
+    ESP_LOGI(TAG, "Testing event journal range queries, eviction and formats");
+
+    event_journal_config_t config = EVENT_JOURNAL_DEFAULT_CONFIG();
+    config.capacity = 8;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, event_journal_init(NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, event_journal_init(&config));
+
+    event_journal_page_t *page = malloc(sizeof(event_journal_page_t));
+    TEST_ASSERT_NOT_NULL(page);
+
+    // Vacío: página sin eventos
+    TEST_ASSERT_EQUAL(0, event_journal_read(0, 10, page));
+    TEST_ASSERT_EQUAL(0, page->latest_id);
+    TEST_ASSERT_FALSE(page->more);
+
+    // Rangos por id: after es exclusivo y more indica que quedan posteriores
+    append_range(1, 5);
+    TEST_ASSERT_EQUAL(3, event_journal_read(0, 3, page));
+    TEST_ASSERT_EQUAL(1, page->events[0].id);
+    TEST_ASSERT_EQUAL(3, page->events[2].detection_data.detection_count);
+    TEST_ASSERT_TRUE(page->more);
+    TEST_ASSERT_EQUAL(0, page->lost);
+    TEST_ASSERT_EQUAL(2, event_journal_read(3, 10, page));
+    TEST_ASSERT_EQUAL(4, page->events[0].id);
+    TEST_ASSERT_FALSE(page->more);
+    TEST_ASSERT_EQUAL(0, event_journal_read(5, 10, page));
+    TEST_ASSERT_EQUAL(0, event_journal_read(UINT32_MAX, 10, page));
+
+    // Lleno: se sobrescriben los más antiguos y quien se quedó atrás sabe cuántos perdió
+    append_range(6, 12);
+    TEST_ASSERT_EQUAL(3, event_journal_read(2, 3, page));
+    TEST_ASSERT_EQUAL(5, page->oldest_id);
+    TEST_ASSERT_EQUAL(12, page->latest_id);
+    TEST_ASSERT_EQUAL(2, page->lost);
+    TEST_ASSERT_EQUAL(5, page->events[0].id);
+    TEST_ASSERT_EQUAL(7, page->events[2].id);
+    TEST_ASSERT_TRUE(page->more);
+
+    // El límite se recorta a EVENT_JOURNAL_QUERY_MAX
+    TEST_ASSERT_EQUAL(8, event_journal_read(0, 1000, page));
+    TEST_ASSERT_EQUAL(12, page->events[7].id);
+
+    event_journal_stats_t stats = event_journal_get_stats();
+    TEST_ASSERT_EQUAL(12, stats.appended);
+    TEST_ASSERT_EQUAL(4, stats.overwritten);
+    TEST_ASSERT_EQUAL(8, stats.count);
+    TEST_ASSERT_EQUAL(5, stats.oldest_id);
+    TEST_ASSERT_EQUAL(12, stats.latest_id);
+    TEST_ASSERT_EQUAL(8, stats.capacity);
+
+    // JSON: next es el after de la siguiente consulta y cada evento lleva los datos de /events
+    char json[512];
+    TEST_ASSERT_EQUAL(1, event_journal_read(11, 1, page));
+    int len = event_journal_page_json(page, json, sizeof(json));
+    TEST_ASSERT_TRUE(len < (int)sizeof(json));
+    TEST_ASSERT_EQUAL_STRING("{\"after\":11,\"oldest\":5,\"latest\":12,\"next\":12,\"more\":false,\"lost\":0,"
+                             "\"events\":[{\"event\":\"detection_started\",\"data\":{\"id\":12,\"ts\":12000,"
+                             "\"detected\":true,\"sensor_state\":0,\"detections\":12}}]}", json);
+    TEST_ASSERT_EQUAL(0, event_journal_read(12, 1, page));
+    event_journal_page_json(page, json, sizeof(json));
+    TEST_ASSERT_EQUAL_STRING("{\"after\":12,\"oldest\":5,\"latest\":12,\"next\":12,\"more\":false,\"lost\":0,"
+                             "\"events\":[]}", json);
+
+    // Binario: cabecera de 24 bytes y registros tal cual
+    uint8_t bin[sizeof(event_journal_bin_header_t) + 2 * sizeof(server_event_t)];
+    TEST_ASSERT_EQUAL(2, event_journal_read(9, 2, page));
+    TEST_ASSERT_EQUAL(0, event_journal_page_binary(page, bin, sizeof(bin) - 1));
+    TEST_ASSERT_EQUAL(sizeof(bin), event_journal_page_binary(page, bin, sizeof(bin)));
+    event_journal_bin_header_t header;
+    memcpy(&header, bin, sizeof(header));
+    TEST_ASSERT_EQUAL_MEMORY(EVENT_JOURNAL_BIN_MAGIC, header.magic, 4);
+    TEST_ASSERT_EQUAL(sizeof(server_event_t), header.record_size);
+    TEST_ASSERT_EQUAL(2, header.count);
+    TEST_ASSERT_EQUAL(12, header.latest_id);
+    TEST_ASSERT_EQUAL(1, header.more);
+    server_event_t record;
+    memcpy(&record, bin + sizeof(header) + sizeof(server_event_t), sizeof(record));
+    TEST_ASSERT_EQUAL(11, record.id);
+    TEST_ASSERT_EQUAL(11000, (int)record.timestamp);
+
+    // server_events_post() anota antes de encolar, también lo que la cola descarta
+    QueueHandle_t queue = xQueueCreate(1, sizeof(server_event_t));
+    TEST_ASSERT_NOT_NULL(queue);
+    server_event_t event = detection_event(50);
+    TEST_ASSERT_EQUAL(ESP_OK, server_events_post(queue, &event));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, server_events_post(queue, &event));
+    server_event_t queued;
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &queued, 0));
+    TEST_ASSERT_EQUAL(13, queued.id);
+    TEST_ASSERT_EQUAL(14, event_journal_get_stats().latest_id);
+    vQueueDelete(queue);
+
+    // Sin diario no se asignan ids
+    event_journal_deinit();
+    TEST_ASSERT_EQUAL(0, event_journal_append(&event));
+    TEST_ASSERT_EQUAL(0, event_journal_read(0, 10, page));
+    free(page);
+}
+
+static void appender_task(void *arg) {
+    uint32_t task_id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t n = 0; n < TEST_APPENDS; n++) {
+        server_event_t event = detection_event((task_id << 16) | n);
+        event_journal_append(&event);
+        if ((n % 64) == 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+void test_event_journal_concurrent_appends(void) {
+    ESP_LOGI(TAG, "Testing event journal with %d tasks x %d appends", TEST_APPENDERS, TEST_APPENDS);
+
+    event_journal_config_t config = { .capacity = TEST_APPENDERS * TEST_APPENDS };
+    TEST_ASSERT_EQUAL(ESP_OK, event_journal_init(&config));
+    done_sem = xSemaphoreCreateCounting(TEST_APPENDERS, 0);
+    TEST_ASSERT_NOT_NULL(done_sem);
+
+    for (uint32_t i = 0; i < TEST_APPENDERS; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(appender_task, "ej_append", 3072,
+                                                          (void *)(uintptr_t)i, 5, NULL,
+                                                          i % portNUM_PROCESSORS));
+    }
+    for (int i = 0; i < TEST_APPENDERS; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done_sem, pdMS_TO_TICKS(60000)));
+    }
+    vSemaphoreDelete(done_sem);
+    done_sem = NULL;
+
+    // Recorrido completo por páginas: ids consecutivos y el orden de cada tarea respetado
+    event_journal_page_t *page = malloc(sizeof(event_journal_page_t));
+    TEST_ASSERT_NOT_NULL(page);
+    uint32_t next_n[TEST_APPENDERS] = {0};
+    uint32_t after = 0;
+    uint32_t pages = 0;
+    do {
+        event_journal_read(after, EVENT_JOURNAL_QUERY_MAX, page);
+        for (size_t i = 0; i < page->count; i++) {
+            const server_event_t *event = &page->events[i];
+            uint32_t task_id = event->detection_data.detection_count >> 16;
+            TEST_ASSERT_EQUAL(after + 1, event->id);
+            TEST_ASSERT_TRUE(task_id < TEST_APPENDERS);
+            TEST_ASSERT_EQUAL(next_n[task_id], event->detection_data.detection_count & 0xFFFF);
+            next_n[task_id]++;
+            after = event->id;
+        }
+        pages++;
+    } while (page->more);
+    free(page);
+
+    ESP_LOGI(TAG, "%lu eventos leídos en %lu páginas", after, pages);
+    TEST_ASSERT_EQUAL(TEST_APPENDERS * TEST_APPENDS, after);
+    for (int i = 0; i < TEST_APPENDERS; i++) {
+        TEST_ASSERT_EQUAL(TEST_APPENDS, next_n[i]);
+    }
+    TEST_ASSERT_EQUAL(0, event_journal_get_stats().overwritten);
+
+    event_journal_deinit();
+}
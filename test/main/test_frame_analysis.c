@@ -0,0 +1,83 @@
+#include "unity.h"
+#include "frame_analysis.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "TEST_FRAME_ANALYSIS";
+
+// Ráfaga de 640x360 embebida: la misma gallina con desenfoque decreciente y un frame oscuro
+extern const uint8_t burst_blur24_start[] asm("_binary_burst_0_blur24_jpg_start");
+extern const uint8_t burst_blur24_end[] asm("_binary_burst_0_blur24_jpg_end");
+extern const uint8_t burst_blur12_start[] asm("_binary_burst_1_blur12_jpg_start");
+extern const uint8_t burst_blur12_end[] asm("_binary_burst_1_blur12_jpg_end");
+extern const uint8_t burst_sharp_start[] asm("_binary_burst_2_sharp_jpg_start");
+extern const uint8_t burst_sharp_end[] asm("_binary_burst_2_sharp_jpg_end");
+extern const uint8_t burst_dark_start[] asm("_binary_burst_3_dark_jpg_start");
+extern const uint8_t burst_dark_end[] asm("_binary_burst_3_dark_jpg_end");
+
+#define BURST_MAP_SIZE  (80 * 45)
+
+static uint8_t burst_map[BURST_MAP_SIZE];
+
+static frame_quality_t score_frame(const uint8_t *start, const uint8_t *end) {
+    frame_quality_t quality;
+    int64_t t0 = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, frame_analysis_score_jpeg(start, end - start, burst_map,
+                                                        sizeof(burst_map), &quality));
+    ESP_LOGI(TAG, "%zu bytes: nitidez=%.3f detalle=%.3f exposición=%.2f media=%d (%lld us)",
+             (size_t)(end - start), quality.sharpness, quality.detail, quality.exposure, quality.mean,
+             esp_timer_get_time() - t0);
+    return quality;
+}
+
+void test_frame_analysis_uniform_map(void) {
+    ESP_LOGI(TAG, "Testing frame scoring on flat and saturated maps");
+
+    uint8_t map[16 * 8];
+    frame_quality_t quality;
+
+    memset(map, FRAME_ANALYSIS_TARGET_LUMA, sizeof(map));
+    frame_analysis_score_map(map, 16, 8, &quality);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, quality.sharpness);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, quality.detail);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, quality.exposure);
+    TEST_ASSERT_EQUAL(FRAME_ANALYSIS_TARGET_LUMA, quality.mean);
+
+    // Mitad quemada: la exposición cae a la mitad por saturación más la distancia de la media
+    memset(map + sizeof(map) / 2, 255, sizeof(map) / 2);
+    frame_analysis_score_map(map, 16, 8, &quality);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, quality.clipped);
+    TEST_ASSERT_TRUE(quality.exposure < 0.5f);
+    TEST_ASSERT_TRUE(quality.sharpness > 0.0f);
+
+    // Mapas demasiado pequeños para el laplaciano
+    frame_analysis_score_map(map, 2, 2, &quality);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, quality.sharpness);
+}
+
+void test_frame_analysis_burst_ranking(void) {
+    ESP_LOGI(TAG, "Testing burst ranking by sharpness and exposure");
+
+    frame_quality_t blur24 = score_frame(burst_blur24_start, burst_blur24_end);
+    frame_quality_t blur12 = score_frame(burst_blur12_start, burst_blur12_end);
+    frame_quality_t sharp = score_frame(burst_sharp_start, burst_sharp_end);
+    frame_quality_t dark = score_frame(burst_dark_start, burst_dark_end);
+
+    // Menos desenfoque por movimiento = más nitidez
+    TEST_ASSERT_TRUE(blur12.sharpness > blur24.sharpness);
+    TEST_ASSERT_TRUE(sharp.sharpness > blur12.sharpness);
+
+    // La energía AC ve lo que el mapa 1/8 casi no distingue: el nítido queda claramente arriba
+    TEST_ASSERT_TRUE(blur12.detail > blur24.detail);
+    TEST_ASSERT_TRUE(sharp.detail > blur12.detail);
+    TEST_ASSERT_TRUE(sharp.sharpness > 1.2f * blur24.sharpness);
+
+    // El frame subexpuesto pierde aunque sea nítido
+    TEST_ASSERT_TRUE(dark.exposure < sharp.exposure);
+    TEST_ASSERT_TRUE(sharp.score > dark.score);
+    TEST_ASSERT_TRUE(sharp.score > blur24.score);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, frame_analysis_score_jpeg(burst_sharp_start,
+                      burst_sharp_end - burst_sharp_start, burst_map, 16, &dark));
+}
@@ -0,0 +1,200 @@
+#include "unity.h"
+#include "frame_dedupe.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TEST_FRAME_DEDUPE";
+
+// Mapa DC de un frame 320x240 (escala 1/8)
+#define MAP_W   40
+#define MAP_H   30
+
+static uint8_t map_a[MAP_W * MAP_H];
+static uint8_t map_b[MAP_W * MAP_H];
+
+// Escena del nido: pared lisa, paja más clara abajo y un bebedero oscuro
+static void draw_scene(uint8_t *map, int offset) {
+    for (int y = 0; y < MAP_H; y++) {
+        for (int x = 0; x < MAP_W; x++) {
+            int v = 90 + offset;
+            if (y >= 20) {
+                v += 50;
+            }
+            if (x >= 30 && x < 36 && y >= 4 && y < 12) {
+                v = 30 + offset;
+            }
+            map[y * MAP_W + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+        }
+    }
+}
+
+// Gallina: mancha oscura de 16x12 con esquina superior izquierda en (x, y)
+static void draw_hen(uint8_t *map, int x0, int y0, uint8_t value) {
+    for (int y = y0; y < y0 + 12 && y < MAP_H; y++) {
+        for (int x = x0; x < x0 + 16 && x < MAP_W; x++) {
+            map[y * MAP_W + x] = value;
+        }
+    }
+}
+
+// Ruido uniforme de ±amplitude niveles en el mapa DC (ganancia nocturna ya promediada en 8x8)
+static void add_noise(uint8_t *map, int amplitude, uint32_t seed) {
+    for (int i = 0; i < MAP_W * MAP_H; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int v = map[i] + (int)((seed >> 16) % (2 * amplitude + 1)) - amplitude;
+        map[i] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+}
+
+static uint8_t map_distance(void) {
+    frame_hash_t a, b;
+    frame_hash_map(map_a, MAP_W, MAP_H, &a);
+    frame_hash_map(map_b, MAP_W, MAP_H, &b);
+    return frame_hash_distance(&a, &b);
+}
+
+void test_frame_hash_same_scene(void) {
+    ESP_LOGI(TAG, "Testing hash stability for an unchanged scene");
+
+    frame_dedupe_config_t config = FRAME_DEDUPE_DEFAULT_CONFIG();
+
+    // Mismo frame: distancia 0 y un hash con información
+    draw_scene(map_a, 0);
+    draw_hen(map_a, 12, 12, 25);
+    memcpy(map_b, map_a, sizeof(map_b));
+    frame_hash_t hash;
+    frame_hash_map(map_a, MAP_W, MAP_H, &hash);
+    TEST_ASSERT_TRUE(hash.brighter != 0 || hash.darker != 0);
+    TEST_ASSERT_EQUAL(0, map_distance());
+
+    // Cambio uniforme de exposición: las diferencias entre celdas no cambian
+    draw_scene(map_b, 25);
+    draw_hen(map_b, 12, 12, 25 + 25);
+    TEST_ASSERT_EQUAL(0, map_distance());
+
+    // Ruido de ganancia en ambos frames: la zona muerta lo absorbe en la pared lisa
+    for (uint32_t seed = 1; seed <= 8; seed++) {
+        draw_scene(map_a, 0);
+        draw_hen(map_a, 12, 12, 25);
+        draw_scene(map_b, 0);
+        draw_hen(map_b, 12, 12, 25);
+        add_noise(map_a, 3, seed);
+        add_noise(map_b, 3, seed * 7919);
+        uint8_t d = map_distance();
+        ESP_LOGI(TAG, "Ruido ±3, semilla %lu: distancia %u", seed, d);
+        TEST_ASSERT_TRUE(d < config.threshold);
+    }
+
+    // Mapa vacío: hash a cero
+    frame_hash_map(NULL, 0, 0, &hash);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(hash.brighter | hash.darker));
+}
+
+void test_frame_hash_detects_change(void) {
+    ESP_LOGI(TAG, "Testing hash distance for real scene changes");
+
+    frame_dedupe_config_t config = FRAME_DEDUPE_DEFAULT_CONFIG();
+
+    // La gallina se desplaza casi medio encuadre
+    draw_scene(map_a, 0);
+    draw_hen(map_a, 2, 10, 25);
+    draw_scene(map_b, 0);
+    draw_hen(map_b, 20, 10, 25);
+    uint8_t moved = map_distance();
+    ESP_LOGI(TAG, "Gallina desplazada: distancia %u", moved);
+    TEST_ASSERT_TRUE(moved >= config.threshold);
+
+    // La gallina se va del nido
+    draw_scene(map_b, 0);
+    uint8_t left = map_distance();
+    ESP_LOGI(TAG, "Nido vacío: distancia %u", left);
+    TEST_ASSERT_TRUE(left >= config.threshold);
+
+    // Una gallina clara en el nido vacío: cuentan los bordes más claros y los más oscuros
+    draw_scene(map_a, 0);
+    draw_scene(map_b, 0);
+    draw_hen(map_b, 12, 16, 230);
+    uint8_t bright = map_distance();
+    ESP_LOGI(TAG, "Gallina clara: distancia %u", bright);
+    TEST_ASSERT_TRUE(bright >= config.threshold);
+}
+
+// Hash con los primeros n bits de brighter invertidos respecto a base
+static frame_hash_t flip_bits(const frame_hash_t *base, int n) {
+    frame_hash_t hash = *base;
+    hash.brighter ^= n >= 64 ? ~0ULL : (1ULL << n) - 1;
+    return hash;
+}
+
+void test_frame_dedupe_decisions(void) {
+    ESP_LOGI(TAG, "Testing duplicate decisions, reference and max gap");
+
+    frame_dedupe_config_t config = FRAME_DEDUPE_DEFAULT_CONFIG();
+    frame_dedupe_t dedupe;
+    config.threshold = FRAME_HASH_MAX_DISTANCE + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, frame_dedupe_init(&dedupe, &config));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, frame_dedupe_init(&dedupe, NULL));
+
+    config.threshold = 8;
+    config.max_gap_ms = 10000;
+    TEST_ASSERT_EQUAL(ESP_OK, frame_dedupe_init(&dedupe, &config));
+    TEST_ASSERT_EQUAL(FRAME_HASH_NONE, dedupe.stats.last_distance);
+
+    frame_hash_t base = { .brighter = 0x00FF00FF00FF00FFULL, .darker = 0x0F000F000F000F00ULL };
+    uint8_t distance = 0;
+    uint64_t t = 0;
+
+    // Sin referencia el primer frame siempre se conserva
+    TEST_ASSERT_FALSE(frame_dedupe_check(&dedupe, &base, t, 1000, &distance));
+    TEST_ASSERT_EQUAL(FRAME_HASH_NONE, distance);
+
+    // Por debajo del umbral: duplicado, y sus bytes cuentan como ahorro
+    frame_hash_t near = flip_bits(&base, 5);
+    t += 2000000;
+    TEST_ASSERT_TRUE(frame_dedupe_check(&dedupe, &near, t, 1000, &distance));
+    TEST_ASSERT_EQUAL(5, distance);
+
+    // Deriva lenta: el duplicado no movió la referencia, así que 10 bits superan el umbral
+    frame_hash_t drift = flip_bits(&base, 10);
+    TEST_ASSERT_EQUAL(5, frame_hash_distance(&drift, &near));
+    t += 2000000;
+    TEST_ASSERT_FALSE(frame_dedupe_check(&dedupe, &drift, t, 1000, &distance));
+    TEST_ASSERT_EQUAL(10, distance);
+
+    // Exactamente en el umbral se conserva
+    frame_hash_t edge = flip_bits(&drift, 8);
+    t += 2000000;
+    TEST_ASSERT_FALSE(frame_dedupe_check(&dedupe, &edge, t, 1000, NULL));
+
+    // Escena estática: duplicados hasta que vence max_gap_ms, entonces uno forzado
+    uint32_t duplicates = 0;
+    uint64_t reference_time = t;
+    for (int i = 0; i < 10; i++) {
+        t += 2000000;
+        bool duplicate = frame_dedupe_check(&dedupe, &edge, t, 1000, NULL);
+        if (t - reference_time < 10000000) {
+            TEST_ASSERT_TRUE(duplicate);
+            duplicates++;
+        } else {
+            TEST_ASSERT_FALSE(duplicate);
+            reference_time = t;
+        }
+    }
+    TEST_ASSERT_EQUAL(2, dedupe.stats.forced);
+    TEST_ASSERT_EQUAL(1 + duplicates, dedupe.stats.duplicates);
+    TEST_ASSERT_EQUAL_UINT32((1 + duplicates) * 1000, (uint32_t)dedupe.stats.bytes_saved);
+    TEST_ASSERT_EQUAL(dedupe.stats.hashed, dedupe.stats.kept + dedupe.stats.duplicates);
+
+    // Un frame publicado por otra vía (detección) pasa a ser la referencia
+    frame_dedupe_keep(&dedupe, &base, t);
+    t += 2000000;
+    TEST_ASSERT_TRUE(frame_dedupe_check(&dedupe, &near, t, 1000, &distance));
+    TEST_ASSERT_EQUAL(5, distance);
+
+    // max_gap_ms = 0: nunca se fuerza un frame
+    config.max_gap_ms = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, frame_dedupe_init(&dedupe, &config));
+    TEST_ASSERT_FALSE(frame_dedupe_check(&dedupe, &base, 0, 1000, NULL));
+    TEST_ASSERT_TRUE(frame_dedupe_check(&dedupe, &base, 3600ULL * 1000000, 1000, NULL));
+    TEST_ASSERT_EQUAL(0, dedupe.stats.forced);
+}
@@ -0,0 +1,223 @@
+#include "unity.h"
+#include "frame_store.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "TEST_FRAME_STORE";
+
+#define TEST_SLOT_SIZE      4096
+#define TEST_READERS        4
+#define TEST_WRITES         5000
+
+static volatile bool writer_done = false;
+static uint32_t reader_errors = 0;
+static uint32_t reader_reads = 0;
+static SemaphoreHandle_t done_sem = NULL;
+
+// Fuente de frames falsa: cabecera con el número de frame y relleno derivado
+static size_t fake_frame_fill(uint8_t *buf, uint32_t tag) {
+    size_t len = 512 + (tag * 37) % (TEST_SLOT_SIZE - 512);
+    memcpy(buf, &tag, sizeof(tag));
+    memset(buf + sizeof(tag), (uint8_t)(tag * 13), len - sizeof(tag));
+    return len;
+}
+
+static bool fake_frame_valid(const camera_frame_t *frame) {
+    uint32_t tag;
+    memcpy(&tag, frame->buf, sizeof(tag));
+    if (tag != frame->seq || frame->meta.episode_id != tag) {
+        return false;   // Los metadatos viajan con los datos del mismo slot
+    }
+    for (size_t i = sizeof(tag); i < frame->len; i++) {
+        if (frame->buf[i] != (uint8_t)(tag * 13)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void fake_writer_task(void *arg) {
+    uint32_t tag = 1;
+    uint8_t *data = NULL;
+
+    while (tag <= TEST_WRITES) {
+        // Reservar con el tamaño máximo y ajustar tras rellenar
+        camera_frame_t *frame = frame_store_begin_write(TEST_SLOT_SIZE, &data);
+        if (frame == NULL) {
+            vTaskDelay(1);
+            continue;
+        }
+        frame->len = fake_frame_fill(data, tag);
+        frame->timestamp = tag;
+        frame->meta.episode_id = tag;
+        frame_store_commit(frame);
+        tag++;
+        if ((tag % 64) == 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    writer_done = true;
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void reader_task(void *arg) {
+    uint32_t last_seq = 0;
+
+    while (!writer_done) {
+        camera_frame_t *frame = camera_frame_acquire();
+        if (frame == NULL) {
+            vTaskDelay(1);
+            continue;
+        }
+        if (!fake_frame_valid(frame) || frame->seq < last_seq) {
+            __atomic_fetch_add(&reader_errors, 1, __ATOMIC_RELAXED);
+        }
+        last_seq = frame->seq;
+        __atomic_fetch_add(&reader_reads, 1, __ATOMIC_RELAXED);
+        camera_frame_release(frame);
+        taskYIELD();
+    }
+
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+void test_frame_store_acquire_release(void) {
+    ESP_LOGI(TAG, "Testing frame store acquire/release");
+
+    frame_store_config_t config = { .slot_count = 2, .slot_size = TEST_SLOT_SIZE };
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_init(&config));
+    TEST_ASSERT_NULL(camera_frame_acquire());
+    TEST_ASSERT_FALSE(frame_store_has_frame());
+
+    uint8_t *data = NULL;
+    camera_frame_t *frame = frame_store_begin_write(TEST_SLOT_SIZE + 1, &data);
+    TEST_ASSERT_NULL(frame);
+
+    frame = frame_store_begin_write(TEST_SLOT_SIZE, &data);
+    TEST_ASSERT_NOT_NULL(frame);
+    frame->len = fake_frame_fill(data, 1);
+    frame->meta.episode_id = 1;
+    frame->meta.capture_latency_us = 1500;
+    TEST_ASSERT_EQUAL(1, frame_store_commit(frame));
+
+    // Un lector retiene el frame 1 mientras llegan nuevas capturas
+    camera_frame_t *held = camera_frame_acquire();
+    TEST_ASSERT_NOT_NULL(held);
+    TEST_ASSERT_EQUAL(1, held->seq);
+    TEST_ASSERT_EQUAL(1500, held->meta.capture_latency_us);
+
+    frame = frame_store_begin_write(TEST_SLOT_SIZE, &data);
+    TEST_ASSERT_NOT_NULL(frame);
+    frame->len = fake_frame_fill(data, 2);
+    frame->meta.episode_id = 2;
+    TEST_ASSERT_EQUAL(2, frame_store_commit(frame));
+
+    // Sin slot libre: el 1 tiene lector y el 2 es el más reciente
+    TEST_ASSERT_NULL(frame_store_begin_write(16, &data));
+    TEST_ASSERT_TRUE(fake_frame_valid(held));
+
+    // El slot del frame 1 se reutiliza con los metadatos a cero
+    camera_frame_release(held);
+    frame = frame_store_begin_write(TEST_SLOT_SIZE, &data);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL(0, frame->meta.episode_id);
+    TEST_ASSERT_EQUAL(0, frame->meta.capture_latency_us);
+    frame_store_abort(frame);
+
+    frame_store_stats_t stats = frame_store_get_stats();
+    TEST_ASSERT_EQUAL(2, stats.published);
+    TEST_ASSERT_EQUAL(1, stats.dropped_too_large);
+    TEST_ASSERT_EQUAL(1, stats.dropped_no_slot);
+    TEST_ASSERT_EQUAL(0, stats.slots_in_use);
+
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_deinit());
+}
+
+void test_frame_store_concurrent_readers_writer(void) {
+    ESP_LOGI(TAG, "Testing frame store with %d readers and %d writes", TEST_READERS, TEST_WRITES);
+
+    // Cada lector retiene como máximo un slot, más el último publicado y el escritor
+    frame_store_config_t config = { .slot_count = TEST_READERS + 2, .slot_size = TEST_SLOT_SIZE };
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_init(&config));
+
+    writer_done = false;
+    reader_errors = 0;
+    reader_reads = 0;
+    done_sem = xSemaphoreCreateCounting(TEST_READERS + 1, 0);
+    TEST_ASSERT_NOT_NULL(done_sem);
+
+    for (int i = 0; i < TEST_READERS; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(reader_task, "fs_reader", 3072,
+                                                          NULL, 5, NULL, i % portNUM_PROCESSORS));
+    }
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(fake_writer_task, "fs_writer", 3072,
+                                                      NULL, 5, NULL, 0));
+
+    for (int i = 0; i < TEST_READERS + 1; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done_sem, pdMS_TO_TICKS(60000)));
+    }
+    vSemaphoreDelete(done_sem);
+    done_sem = NULL;
+
+    frame_store_stats_t stats = frame_store_get_stats();
+    ESP_LOGI(TAG, "Lecturas: %lu, publicados: %lu, errores: %lu",
+             reader_reads, stats.published, reader_errors);
+
+    TEST_ASSERT_EQUAL(0, reader_errors);
+    TEST_ASSERT_EQUAL(TEST_WRITES, stats.published);
+    TEST_ASSERT_EQUAL(0, stats.dropped_no_slot);
+    TEST_ASSERT_EQUAL(0, stats.slots_in_use);
+    TEST_ASSERT_GREATER_THAN(0, reader_reads);
+
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_deinit());
+}
+
+static void late_release_task(void *arg) {
+    vTaskDelay(pdMS_TO_TICKS(100));
+    camera_frame_release((camera_frame_t *)arg);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+void test_frame_store_deinit_waits_for_readers(void) {
+    ESP_LOGI(TAG, "Testing frame store deinit with frames still acquired");
+
+    frame_store_config_t config = { .slot_count = 2, .slot_size = TEST_SLOT_SIZE };
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_init(&config));
+
+    uint8_t *data = NULL;
+    camera_frame_t *frame = frame_store_begin_write(TEST_SLOT_SIZE, &data);
+    TEST_ASSERT_NOT_NULL(frame);
+    frame->len = fake_frame_fill(data, 1);
+    frame->meta.episode_id = 1;
+    frame_store_commit(frame);
+
+    // Un lector que no suelta el frame: el almacén no se libera y sigue operativo
+    camera_frame_t *held = camera_frame_acquire();
+    TEST_ASSERT_NOT_NULL(held);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, frame_store_deinit());
+    TEST_ASSERT_TRUE(fake_frame_valid(held));
+    camera_frame_t *again = camera_frame_acquire();
+    TEST_ASSERT_NOT_NULL(again);
+    camera_frame_release(again);
+
+    // Un lector que suelta el frame durante la espera: el deinit termina sin error
+    done_sem = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(done_sem);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(late_release_task, "fs_release", 2048, held, 5, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_deinit());
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done_sem, pdMS_TO_TICKS(1000)));
+    vSemaphoreDelete(done_sem);
+    done_sem = NULL;
+
+    // Cerrado: ni lectores ni escritores
+    TEST_ASSERT_NULL(camera_frame_acquire());
+    TEST_ASSERT_NULL(frame_store_begin_write(16, &data));
+    TEST_ASSERT_EQUAL(ESP_OK, frame_store_deinit());
+}
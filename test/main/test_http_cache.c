@@ -0,0 +1,65 @@
+#include "unity.h"
+#include "http_cache.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TEST_HTTP_CACHE";
+
+void test_http_etag_matching(void) {
+    ESP_LOGI(TAG, "Testing ETag generation and If-None-Match matching");
+
+    char etag[HTTP_ETAG_MAX_LEN];
+    char thumb[HTTP_ETAG_MAX_LEN];
+    char other[HTTP_ETAG_MAX_LEN];
+
+    // Máximo epoch y seq: cabe en el buffer
+    int len = http_etag_format(etag, sizeof(etag), 0xFFFFFFFFu, 0xFFFFFFFFu, 't');
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(etag));
+
+    http_etag_format(etag, sizeof(etag), 0x1a2b3c4d, 42, '\0');
+    http_etag_format(thumb, sizeof(thumb), 0x1a2b3c4d, 42, 't');
+    http_etag_format(other, sizeof(other), 0x5e6f7a8b, 42, '\0');
+    TEST_ASSERT_EQUAL_STRING("\"1a2b3c4d-42\"", etag);
+    TEST_ASSERT_EQUAL_STRING("\"1a2b3c4d-42t\"", thumb);
+
+    // Coincidencia exacta, débil, en lista y comodín
+    TEST_ASSERT_TRUE(http_etag_matches("\"1a2b3c4d-42\"", etag));
+    TEST_ASSERT_TRUE(http_etag_matches("W/\"1a2b3c4d-42\"", etag));
+    TEST_ASSERT_TRUE(http_etag_matches("\"1a2b3c4d-41\", \"1a2b3c4d-42\"", etag));
+    TEST_ASSERT_TRUE(http_etag_matches("*", etag));
+
+    // Otra foto, otra representación u otro arranque con el mismo seq: se envía entera
+    TEST_ASSERT_FALSE(http_etag_matches("\"1a2b3c4d-43\"", etag));
+    TEST_ASSERT_FALSE(http_etag_matches("\"1a2b3c4d-4\"", etag));
+    TEST_ASSERT_FALSE(http_etag_matches(thumb, etag));
+    TEST_ASSERT_FALSE(http_etag_matches(other, etag));
+    TEST_ASSERT_FALSE(http_etag_matches("1a2b3c4d-42", etag));
+    TEST_ASSERT_FALSE(http_etag_matches("", etag));
+    TEST_ASSERT_FALSE(http_etag_matches(NULL, etag));
+
+    // Comas dentro de una etiqueta no parten la lista
+    TEST_ASSERT_FALSE(http_etag_matches("\"a,\"1a2b3c4d-42\"\"", etag));
+
+    // ETag de contenido (recursos estáticos): FNV-1a de 32 bits
+    http_etag_format_hash(etag, sizeof(etag), "a", 1);
+    TEST_ASSERT_EQUAL_STRING("\"e40c292c\"", etag);
+    http_etag_format_hash(other, sizeof(other), "b", 1);
+    TEST_ASSERT_FALSE(http_etag_matches(other, etag));
+}
+
+void test_http_date_format(void) {
+    ESP_LOGI(TAG, "Testing Last-Modified date formatting");
+
+    char date[HTTP_DATE_LEN];
+
+    // Ejemplo de RFC 9110
+    TEST_ASSERT_EQUAL(29, http_date_format(date, sizeof(date), 784111777000LL));
+    TEST_ASSERT_EQUAL_STRING("Sun, 06 Nov 1994 08:49:37 GMT", date);
+
+    // Los milisegundos se truncan: misma fecha en todo el segundo
+    http_date_format(date, sizeof(date), 1760000000999LL);
+    TEST_ASSERT_EQUAL_STRING("Thu, 09 Oct 2025 08:53:20 GMT", date);
+
+    // Reloj sin sincronizar: sin fecha
+    TEST_ASSERT_EQUAL(0, http_date_format(date, sizeof(date), 0));
+}
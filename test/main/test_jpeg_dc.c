@@ -0,0 +1,141 @@
+#include "unity.h"
+#include "jpeg_dc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+
+static const char *TAG = "TEST_JPEG_DC";
+
+// Corpus embebido en el binario (ver EMBED_FILES en CMakeLists.txt)
+extern const uint8_t gray_422_start[] asm("_binary_gray_64x48_422_jpg_start");
+extern const uint8_t gray_422_end[] asm("_binary_gray_64x48_422_jpg_end");
+extern const uint8_t gradient_420_start[] asm("_binary_gradient_128x64_420_rst_jpg_start");
+extern const uint8_t gradient_420_end[] asm("_binary_gradient_128x64_420_rst_jpg_end");
+extern const uint8_t luma_gray_start[] asm("_binary_luma_41x23_gray_jpg_start");
+extern const uint8_t luma_gray_end[] asm("_binary_luma_41x23_gray_jpg_end");
+extern const uint8_t progressive_start[] asm("_binary_progressive_32x32_jpg_start");
+extern const uint8_t progressive_end[] asm("_binary_progressive_32x32_jpg_end");
+extern const uint8_t scene_hd_start[] asm("_binary_scene_hd_night_422_jpg_start");
+extern const uint8_t scene_hd_end[] asm("_binary_scene_hd_night_422_jpg_end");
+
+#define TEST_MAP_MAX    (160 * 90)
+
+static uint8_t luma_map[TEST_MAP_MAX];
+static jpeg_luma_stats_t luma_stats;
+
+void test_jpeg_dc_uniform_frames(void) {
+    ESP_LOGI(TAG, "Testing DC luma map on uniform frames");
+
+    jpeg_dc_info_t info;
+
+    // Gris uniforme con submuestreo 4:2:2 (formato del OV2640)
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(gray_422_start, gray_422_end - gray_422_start,
+                                               luma_map, sizeof(luma_map), &info));
+    TEST_ASSERT_EQUAL(64, info.width);
+    TEST_ASSERT_EQUAL(48, info.height);
+    TEST_ASSERT_EQUAL(8, info.map_width);
+    TEST_ASSERT_EQUAL(6, info.map_height);
+    TEST_ASSERT_EQUAL(3, info.components);
+    TEST_ASSERT_EQUAL(2, info.h_samp);
+    TEST_ASSERT_EQUAL(1, info.v_samp);
+    for (size_t i = 0; i < 8 * 6; i++) {
+        TEST_ASSERT_EQUAL(100, luma_map[i]);
+    }
+
+    // Bloques planos: sin energía AC
+    jpeg_ac_energy_t ac;
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map_ac(gray_422_start, gray_422_end - gray_422_start,
+                                                  luma_map, sizeof(luma_map), NULL, &ac));
+    TEST_ASSERT_EQUAL(8 * 6, ac.blocks);
+    TEST_ASSERT_EQUAL(0, ac.sum);
+
+    // Escala de grises con dimensiones que no son múltiplo de 8
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(luma_gray_start, luma_gray_end - luma_gray_start,
+                                               luma_map, sizeof(luma_map), &info));
+    TEST_ASSERT_EQUAL(1, info.components);
+    TEST_ASSERT_EQUAL(6, info.map_width);
+    TEST_ASSERT_EQUAL(3, info.map_height);
+
+    jpeg_luma_stats_compute(luma_map, 6 * 3, &luma_stats);
+    TEST_ASSERT_EQUAL(18, luma_stats.count);
+    TEST_ASSERT_EQUAL(18, luma_stats.histogram[200]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 200.0f, luma_stats.mean);
+    TEST_ASSERT_EQUAL(200, jpeg_luma_stats_percentile(&luma_stats, 10));
+    TEST_ASSERT_EQUAL(200, jpeg_luma_stats_percentile(&luma_stats, 90));
+}
+
+void test_jpeg_dc_gradient_restart_markers(void) {
+    ESP_LOGI(TAG, "Testing DC luma map with 4:2:0 and restart markers");
+
+    jpeg_dc_info_t info;
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(gradient_420_start, gradient_420_end - gradient_420_start,
+                                               luma_map, sizeof(luma_map), &info));
+    TEST_ASSERT_EQUAL(16, info.map_width);
+    TEST_ASSERT_EQUAL(8, info.map_height);
+    TEST_ASSERT_EQUAL(2, info.v_samp);
+    TEST_ASSERT_NOT_EQUAL(0, info.restart_interval);
+
+    // Degradado horizontal: cada columna de bloques vale 16 * x + 7 en todas las filas
+    for (size_t y = 0; y < info.map_height; y++) {
+        for (size_t x = 0; x < info.map_width; x++) {
+            TEST_ASSERT_UINT8_WITHIN(1, 16 * x + 7, luma_map[y * info.map_width + x]);
+        }
+    }
+
+    jpeg_luma_stats_compute(luma_map, 16 * 8, &luma_stats);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 127.0f, luma_stats.mean);
+    TEST_ASSERT_UINT8_WITHIN(16, 23, jpeg_luma_stats_percentile(&luma_stats, 10));
+    TEST_ASSERT_UINT8_WITHIN(16, 119, jpeg_luma_stats_percentile(&luma_stats, 50));
+    TEST_ASSERT_UINT8_WITHIN(16, 231, jpeg_luma_stats_percentile(&luma_stats, 90));
+
+    // Cada bloque es una rampa de 16 niveles en 8 píxeles (0, 2, ..., 14): varianza interna 21
+    jpeg_ac_energy_t ac;
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map_ac(gradient_420_start, gradient_420_end - gradient_420_start,
+                                                  luma_map, sizeof(luma_map), &info, &ac));
+    TEST_ASSERT_EQUAL(16 * 8, ac.blocks);
+    TEST_ASSERT_INT_WITHIN(4, 21, (int)(ac.sum / ac.blocks));
+    for (size_t x = 0; x < info.map_width; x++) {
+        TEST_ASSERT_UINT8_WITHIN(1, 16 * x + 7, luma_map[x]);
+    }
+}
+
+void test_jpeg_dc_rejects_invalid(void) {
+    ESP_LOGI(TAG, "Testing DC decoder error handling");
+
+    jpeg_dc_info_t info;
+    size_t gray_len = gray_422_end - gray_422_start;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED,
+                      jpeg_dc_luma_map(progressive_start, progressive_end - progressive_start,
+                                       luma_map, sizeof(luma_map), &info));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE,
+                      jpeg_dc_luma_map(gray_422_start, gray_len, luma_map, 8, &info));
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, jpeg_dc_luma_map(gray_422_start, 100, luma_map, sizeof(luma_map), &info));
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, jpeg_dc_get_info(gray_422_start + 2, gray_len - 2, &info));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, jpeg_dc_get_info(NULL, 0, &info));
+}
+
+void test_jpeg_dc_hd_frame_timing(void) {
+    ESP_LOGI(TAG, "Testing DC luma map on a 1280x720 night frame");
+
+    jpeg_dc_info_t info;
+    size_t len = scene_hd_end - scene_hd_start;
+
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(scene_hd_start, len, luma_map, sizeof(luma_map), &info));
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    TEST_ASSERT_EQUAL(160, info.map_width);
+    TEST_ASSERT_EQUAL(90, info.map_height);
+
+    jpeg_luma_stats_compute(luma_map, 160 * 90, &luma_stats);
+    ESP_LOGI(TAG, "%zu bytes analizados en %lld us: media=%.1f p10=%d p50=%d p90=%d",
+             len, elapsed, luma_stats.mean,
+             jpeg_luma_stats_percentile(&luma_stats, 10),
+             jpeg_luma_stats_percentile(&luma_stats, 50),
+             jpeg_luma_stats_percentile(&luma_stats, 90));
+
+    // Valor de referencia obtenido con la escala 1/8 de libjpeg
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 48.41f, luma_stats.mean);
+    TEST_ASSERT_LESS_THAN(80, (int)luma_stats.mean);
+}
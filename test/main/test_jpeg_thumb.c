@@ -0,0 +1,115 @@
+#include "unity.h"
+#include "jpeg_thumb.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+
+static const char *TAG = "TEST_JPEG_THUMB";
+
+// Mismo corpus que test_jpeg_dc.c
+extern const uint8_t gray_422_start[] asm("_binary_gray_64x48_422_jpg_start");
+extern const uint8_t gray_422_end[] asm("_binary_gray_64x48_422_jpg_end");
+extern const uint8_t gradient_420_start[] asm("_binary_gradient_128x64_420_rst_jpg_start");
+extern const uint8_t gradient_420_end[] asm("_binary_gradient_128x64_420_rst_jpg_end");
+extern const uint8_t luma_gray_start[] asm("_binary_luma_41x23_gray_jpg_start");
+extern const uint8_t luma_gray_end[] asm("_binary_luma_41x23_gray_jpg_end");
+extern const uint8_t progressive_start[] asm("_binary_progressive_32x32_jpg_start");
+extern const uint8_t progressive_end[] asm("_binary_progressive_32x32_jpg_end");
+extern const uint8_t scene_hd_start[] asm("_binary_scene_hd_night_422_jpg_start");
+extern const uint8_t scene_hd_end[] asm("_binary_scene_hd_night_422_jpg_end");
+
+#define THUMB_BUF_SIZE  (16 * 1024)
+#define SOURCE_MAP_MAX  (160 * 90)
+
+static uint8_t thumb_buf[THUMB_BUF_SIZE];
+static uint8_t source_map[SOURCE_MAP_MAX];
+static uint8_t thumb_map[20 * 12];
+
+void test_jpeg_thumb_layout_and_errors(void) {
+    ESP_LOGI(TAG, "Testing 1/8 thumbnail layout and error handling");
+
+    jpeg_dc_info_t info;
+    size_t len = 0;
+
+    // 4:2:2 uniforme: la miniatura conserva submuestreo y el nivel de gris
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_thumb_encode(gray_422_start, gray_422_end - gray_422_start,
+                                                JPEG_THUMB_DEFAULT_QUALITY, thumb_buf, sizeof(thumb_buf), &len));
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(thumb_buf, len, thumb_map, sizeof(thumb_map), &info));
+    TEST_ASSERT_EQUAL(8, info.width);
+    TEST_ASSERT_EQUAL(6, info.height);
+    TEST_ASSERT_EQUAL(3, info.components);
+    TEST_ASSERT_EQUAL(2, info.h_samp);
+    TEST_ASSERT_EQUAL(1, info.v_samp);
+    TEST_ASSERT_UINT8_WITHIN(1, 100, thumb_map[0]);
+
+    // Escala de grises con bordes parciales: ceil(41 / 8) x ceil(23 / 8)
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_thumb_encode(luma_gray_start, luma_gray_end - luma_gray_start,
+                                                JPEG_THUMB_DEFAULT_QUALITY, thumb_buf, sizeof(thumb_buf), &len));
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_get_info(thumb_buf, len, &info));
+    TEST_ASSERT_EQUAL(6, info.width);
+    TEST_ASSERT_EQUAL(3, info.height);
+    TEST_ASSERT_EQUAL(1, info.components);
+
+    // 4:2:0 con marcadores de reinicio en el original
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_thumb_encode(gradient_420_start, gradient_420_end - gradient_420_start,
+                                                JPEG_THUMB_DEFAULT_QUALITY, thumb_buf, sizeof(thumb_buf), &len));
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_get_info(thumb_buf, len, &info));
+    TEST_ASSERT_EQUAL(16, info.width);
+    TEST_ASSERT_EQUAL(8, info.height);
+    TEST_ASSERT_EQUAL(2, info.h_samp);
+    TEST_ASSERT_EQUAL(2, info.v_samp);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, jpeg_thumb_encode(progressive_start, progressive_end - progressive_start,
+                                                               JPEG_THUMB_DEFAULT_QUALITY, thumb_buf,
+                                                               sizeof(thumb_buf), &len));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, jpeg_thumb_encode(gray_422_start, gray_422_end - gray_422_start,
+                                                              JPEG_THUMB_DEFAULT_QUALITY, thumb_buf, 64, &len));
+    TEST_ASSERT_EQUAL(0, len);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, jpeg_thumb_encode(NULL, 0, JPEG_THUMB_DEFAULT_QUALITY,
+                                                             thumb_buf, sizeof(thumb_buf), &len));
+}
+
+void test_jpeg_thumb_hd_frame(void) {
+    ESP_LOGI(TAG, "Testing thumbnail of a 1280x720 night frame");
+
+    jpeg_dc_info_t info;
+    size_t src_len = scene_hd_end - scene_hd_start;
+    size_t len = 0;
+
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_thumb_encode(scene_hd_start, src_len, JPEG_THUMB_DEFAULT_QUALITY,
+                                                thumb_buf, sizeof(thumb_buf), &len));
+    int64_t elapsed = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "Miniatura de %zu bytes -> %zu bytes (1/%zu) en %lld us",
+             src_len, len, src_len / len, elapsed);
+
+    TEST_ASSERT_LESS_THAN(50000, (int)elapsed);
+    TEST_ASSERT_TRUE(len * 18 < src_len);     // Objetivo ~20x (19.6x con el corpus)
+
+    // El mapa 1/8 de la miniatura debe coincidir con el mapa 1/64 del original
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(thumb_buf, len, thumb_map, sizeof(thumb_map), &info));
+    TEST_ASSERT_EQUAL(160, info.width);
+    TEST_ASSERT_EQUAL(90, info.height);
+    TEST_ASSERT_EQUAL(ESP_OK, jpeg_dc_luma_map(scene_hd_start, src_len, source_map, sizeof(source_map), NULL));
+
+    int worst = 0;
+    for (int by = 0; by < info.map_height; by++) {
+        for (int bx = 0; bx < info.map_width; bx++) {
+            int sum = 0;
+            int count = 0;
+            for (int y = by * 8; y < by * 8 + 8; y++) {
+                int sy = y < 90 ? y : 89;     // La miniatura replica la última fila
+                for (int x = bx * 8; x < bx * 8 + 8; x++) {
+                    sum += source_map[sy * 160 + x];
+                    count++;
+                }
+            }
+            int diff = abs(thumb_map[by * info.map_width + bx] - (sum + count / 2) / count);
+            if (diff > worst) {
+                worst = diff;
+            }
+        }
+    }
+    ESP_LOGI(TAG, "Diferencia máxima de luminancia por bloque: %d", worst);
+    TEST_ASSERT_LESS_OR_EQUAL(4, worst);
+}
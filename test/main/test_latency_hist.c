@@ -0,0 +1,51 @@
+#include "unity.h"
+#include "latency_hist.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TEST_LATENCY_HIST";
+
+void test_latency_hist_percentiles(void) {
+    ESP_LOGI(TAG, "Testing bucket bounds and percentile estimates");
+
+    latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+    TEST_ASSERT_EQUAL_UINT32(0, latency_hist_percentile(&hist, 99));
+
+    // Límites: 64 us, 128 us... y el último cubo sin límite
+    TEST_ASSERT_EQUAL_UINT32(64, latency_hist_bucket_le(0));
+    TEST_ASSERT_EQUAL_UINT32(128, latency_hist_bucket_le(1));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, latency_hist_bucket_le(LATENCY_HIST_BUCKETS - 1));
+
+    // Los límites son inclusivos
+    latency_hist_record(&hist, 64);
+    latency_hist_record(&hist, 65);
+    TEST_ASSERT_EQUAL(1, hist.buckets[0]);
+    TEST_ASSERT_EQUAL(1, hist.buckets[1]);
+
+    // 98 peticiones rápidas (~1 ms) y dos muy lentas: la mediana no se mueve y el p99
+    // las refleja
+    memset(&hist, 0, sizeof(hist));
+    for (int i = 0; i < 98; i++) {
+        latency_hist_record(&hist, 900 + i);
+    }
+    latency_hist_record(&hist, 250000);
+    latency_hist_record(&hist, 3000000);
+
+    TEST_ASSERT_EQUAL(100, hist.count);
+    TEST_ASSERT_EQUAL_UINT32(3000000, hist.max_us);
+    TEST_ASSERT_EQUAL_UINT32(3000000, hist.last_us);
+    TEST_ASSERT_EQUAL_UINT32(1024, latency_hist_percentile(&hist, 50));
+    TEST_ASSERT_EQUAL_UINT32(262144, latency_hist_percentile(&hist, 99));
+    TEST_ASSERT_EQUAL_UINT32(3000000, latency_hist_percentile(&hist, 100));
+
+    // El percentil nunca supera el máximo observado
+    memset(&hist, 0, sizeof(hist));
+    latency_hist_record(&hist, 700);
+    TEST_ASSERT_EQUAL_UINT32(700, latency_hist_percentile(&hist, 50));
+
+    // Más allá del último límite todo cae en el cubo abierto
+    latency_hist_record(&hist, UINT32_MAX);
+    TEST_ASSERT_EQUAL(1, hist.buckets[LATENCY_HIST_BUCKETS - 1]);
+    TEST_ASSERT_TRUE(hist.sum_us > UINT32_MAX);
+}
@@ -6,8 +6,60 @@
 void test_sensor_e18_init(void);
 void test_sensor_e18_config(void);
 void test_sensor_e18_gpio_operations(void);
+void test_e18_debounce_confirm_and_release(void);
+void test_e18_debounce_bounce_and_false_alarm(void);
+void test_e18_debounce_object_at_boot(void);
 void test_cam_reader_init(void);
 void test_cam_reader_config(void);
+void test_frame_store_acquire_release(void);
+void test_frame_store_concurrent_readers_writer(void);
+void test_frame_store_deinit_waits_for_readers(void);
+void test_preroll_ring_wraparound_and_budget(void);
+void test_preroll_ring_freeze_and_refcounts(void);
+void test_preroll_ring_consecutive_episodes(void);
+void test_photo_history_index_and_eviction(void);
+void test_photo_history_reader_blocks_eviction(void);
+void test_seqlock_snapshot_api(void);
+void test_seqlock_concurrent_readers_writers(void);
+void test_server_events_apply_and_json(void);
+void test_server_events_batch_throughput(void);
+void test_event_journal_ranges(void);
+void test_event_journal_concurrent_appends(void);
+void test_rate_limit_token_bucket(void);
+void test_rate_limit_lru_and_json(void);
+void test_jpeg_dc_uniform_frames(void);
+void test_jpeg_dc_gradient_restart_markers(void);
+void test_jpeg_dc_rejects_invalid(void);
+void test_jpeg_dc_hd_frame_timing(void);
+void test_jpeg_thumb_layout_and_errors(void);
+void test_jpeg_thumb_hd_frame(void);
+void test_capture_queue_priority_and_coalescing(void);
+void test_capture_queue_deadlines(void);
+void test_capture_latency_benchmark(void);
+void test_frame_analysis_uniform_map(void);
+void test_frame_analysis_burst_ranking(void);
+void test_rate_control_day_night_convergence(void);
+void test_rate_control_limits_and_steps(void);
+void test_sensor_profile_diffed_switches(void);
+void test_sensor_profile_validation(void);
+void test_day_night_solar_times(void);
+void test_day_night_trace_replay(void);
+void test_day_night_dwell_and_solar_fallback(void);
+void test_frame_hash_same_scene(void);
+void test_frame_hash_detects_change(void);
+void test_frame_dedupe_decisions(void);
+void test_capture_tier_episode(void);
+void test_capture_tier_switch_stats(void);
+void test_capture_tier_flush_stale(void);
+void test_mjpeg_stream_clients(void);
+void test_mjpeg_stream_slow_client(void);
+void test_sse_hub_fanout(void);
+void test_sse_hub_slow_client(void);
+void test_http_etag_matching(void);
+void test_http_date_format(void);
+void test_latency_hist_percentiles(void);
+void test_metrics_prometheus_export(void);
+void test_metrics_record_cost(void);
 
 void app_main(void)
 {
@@ -28,9 +80,105 @@ void app_main(void)
     RUN_TEST(test_sensor_e18_config);
     RUN_TEST(test_sensor_e18_gpio_operations);
     
+    // E18 debounce state machine tests
+    RUN_TEST(test_e18_debounce_confirm_and_release);
+    RUN_TEST(test_e18_debounce_bounce_and_false_alarm);
+    RUN_TEST(test_e18_debounce_object_at_boot);
+    
     // Camera reader tests
     RUN_TEST(test_cam_reader_init);
     RUN_TEST(test_cam_reader_config);
     
+    // Frame store tests
+    RUN_TEST(test_frame_store_acquire_release);
+    RUN_TEST(test_frame_store_concurrent_readers_writer);
+    RUN_TEST(test_frame_store_deinit_waits_for_readers);
+    
+    // Pre-trigger ring tests
+    RUN_TEST(test_preroll_ring_wraparound_and_budget);
+    RUN_TEST(test_preroll_ring_freeze_and_refcounts);
+    RUN_TEST(test_preroll_ring_consecutive_episodes);
+    
+    // Photo history tests
+    RUN_TEST(test_photo_history_index_and_eviction);
+    RUN_TEST(test_photo_history_reader_blocks_eviction);
+    
+    // Seqlock tests
+    RUN_TEST(test_seqlock_snapshot_api);
+    RUN_TEST(test_seqlock_concurrent_readers_writers);
+    
+    // Server event queue tests
+    RUN_TEST(test_server_events_apply_and_json);
+    RUN_TEST(test_server_events_batch_throughput);
+    
+    // Event journal tests
+    RUN_TEST(test_event_journal_ranges);
+    RUN_TEST(test_event_journal_concurrent_appends);
+    
+    // Rate limiting tests
+    RUN_TEST(test_rate_limit_token_bucket);
+    RUN_TEST(test_rate_limit_lru_and_json);
+    
+    // JPEG DC luma estimator tests
+    RUN_TEST(test_jpeg_dc_uniform_frames);
+    RUN_TEST(test_jpeg_dc_gradient_restart_markers);
+    RUN_TEST(test_jpeg_dc_rejects_invalid);
+    RUN_TEST(test_jpeg_dc_hd_frame_timing);
+    
+    // DCT-domain thumbnail tests
+    RUN_TEST(test_jpeg_thumb_layout_and_errors);
+    RUN_TEST(test_jpeg_thumb_hd_frame);
+    
+    // Capture service tests
+    RUN_TEST(test_capture_queue_priority_and_coalescing);
+    RUN_TEST(test_capture_queue_deadlines);
+    RUN_TEST(test_capture_latency_benchmark);
+    
+    // Burst scoring tests
+    RUN_TEST(test_frame_analysis_uniform_map);
+    RUN_TEST(test_frame_analysis_burst_ranking);
+    
+    // JPEG size controller tests
+    RUN_TEST(test_rate_control_day_night_convergence);
+    RUN_TEST(test_rate_control_limits_and_steps);
+    
+    // Sensor profile tests
+    RUN_TEST(test_sensor_profile_diffed_switches);
+    RUN_TEST(test_sensor_profile_validation);
+    
+    // Day/night scheduler tests
+    RUN_TEST(test_day_night_solar_times);
+    RUN_TEST(test_day_night_trace_replay);
+    RUN_TEST(test_day_night_dwell_and_solar_fallback);
+    
+    // Perceptual dedupe tests
+    RUN_TEST(test_frame_hash_same_scene);
+    RUN_TEST(test_frame_hash_detects_change);
+    RUN_TEST(test_frame_dedupe_decisions);
+    
+    // Capture tier tests
+    RUN_TEST(test_capture_tier_episode);
+    RUN_TEST(test_capture_tier_switch_stats);
+    RUN_TEST(test_capture_tier_flush_stale);
+    
+    // MJPEG stream tests
+    RUN_TEST(test_mjpeg_stream_clients);
+    RUN_TEST(test_mjpeg_stream_slow_client);
+    
+    // Server-Sent Events tests
+    RUN_TEST(test_sse_hub_fanout);
+    RUN_TEST(test_sse_hub_slow_client);
+    
+    // HTTP cache validator tests
+    RUN_TEST(test_http_etag_matching);
+    RUN_TEST(test_http_date_format);
+    
+    // Latency histogram tests
+    RUN_TEST(test_latency_hist_percentiles);
+    
+    // Metrics registry tests
+    RUN_TEST(test_metrics_prometheus_export);
+    RUN_TEST(test_metrics_record_cost);
+    
     UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "unity.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "TEST_METRICS";
+
+static metric_counter_t test_requests = METRIC_COUNTER_INIT("test_requests_total", "Peticiones de prueba", NULL);
+static metric_gauge_t test_free = METRIC_GAUGE_INIT("test_free_bytes", "Memoria libre", "type=\"internal\"");
+static metric_histogram_t test_photo = METRIC_HISTOGRAM_INIT("test_duration_seconds", "Duración", "handler=\"photo\"");
+static metric_counter_t test_other = METRIC_COUNTER_INIT("test_other_total", "Otro contador", NULL);
+static metric_histogram_t test_status = METRIC_HISTOGRAM_INIT("test_duration_seconds", "Duración", "handler=\"status\"");
+
+// Acumula el texto exportado contando las llamadas
+typedef struct {
+    char text[4096];
+    size_t len;
+    int writes;
+    size_t max_write;
+} export_capture_t;
+
+static esp_err_t capture_write(const char *text, size_t len, void *arg) {
+    export_capture_t *capture = arg;
+    if (capture->len + len < sizeof(capture->text)) {
+        memcpy(capture->text + capture->len, text, len);
+        capture->len += len;
+        capture->text[capture->len] = '\0';
+    }
+    capture->writes++;
+    if (len > capture->max_write) {
+        capture->max_write = len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t failing_write(const char *text, size_t len, void *arg) {
+    (*(int *)arg)++;
+    return ESP_FAIL;
+}
+
+void test_metrics_prometheus_export(void) {
+    ESP_LOGI(TAG, "Testing Prometheus text export of counters, gauges and histograms");
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, metrics_register(NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_requests.desc));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_free.desc));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_photo.desc));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_other.desc));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_status.desc));
+    // Registrar dos veces no duplica la serie
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_register(&test_requests.desc));
+
+    uint64_t base = metrics_counter_read(&test_requests);
+    metrics_counter_add(&test_requests, 3);
+    metrics_counter_add(&test_requests, 4);
+    TEST_ASSERT_EQUAL(base + 7, metrics_counter_read(&test_requests));
+    metrics_gauge_set(&test_free, 123456);
+
+    // Límites inclusivos: 64 us en el primer cubo, 65 us en el segundo
+    metric_histogram_snapshot_t before;
+    metrics_histogram_read(&test_photo, &before);
+    metrics_histogram_observe(&test_photo, 64);
+    metrics_histogram_observe(&test_photo, 65);
+    metrics_histogram_observe(&test_photo, 60000000);
+    metric_histogram_snapshot_t after;
+    metrics_histogram_read(&test_photo, &after);
+    TEST_ASSERT_EQUAL(before.count + 3, after.count);
+    TEST_ASSERT_EQUAL(before.buckets[0] + 1, after.buckets[0]);
+    TEST_ASSERT_EQUAL(before.buckets[1] + 1, after.buckets[1]);
+    TEST_ASSERT_EQUAL(before.buckets[METRICS_HIST_BUCKETS - 1] + 1, after.buckets[METRICS_HIST_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL(UINT32_MAX, metrics_histogram_bucket_le(METRICS_HIST_BUCKETS - 1));
+
+    static export_capture_t capture;
+    memset(&capture, 0, sizeof(capture));
+    TEST_ASSERT_EQUAL(ESP_OK, metrics_export_prometheus(capture_write, &capture));
+    ESP_LOGI(TAG, "%zu bytes in %d writes", capture.len, capture.writes);
+    TEST_ASSERT_TRUE(capture.writes >= 2);
+    TEST_ASSERT_TRUE(capture.max_write <= METRICS_EXPORT_CHUNK);
+
+    TEST_ASSERT_NOT_NULL(strstr(capture.text, "# TYPE test_requests_total counter\ntest_requests_total "));
+    TEST_ASSERT_NOT_NULL(strstr(capture.text, "test_free_bytes{type=\"internal\"} 123456\n"));
+    TEST_ASSERT_NOT_NULL(strstr(capture.text, "test_duration_seconds_bucket{handler=\"photo\",le=\"0.000064\"} "));
+    TEST_ASSERT_NOT_NULL(strstr(capture.text, "test_duration_seconds_bucket{handler=\"photo\",le=\"+Inf\"} "));
+    TEST_ASSERT_NOT_NULL(strstr(capture.text, "test_duration_seconds_sum{handler=\"photo\"} "));
+
+    // Las dos series del histograma van juntas bajo un único HELP/TYPE, antes de test_other_total
+    const char *type = strstr(capture.text, "# TYPE test_duration_seconds histogram\n");
+    TEST_ASSERT_NOT_NULL(type);
+    TEST_ASSERT_NULL(strstr(type + 1, "# TYPE test_duration_seconds"));
+    const char *status = strstr(capture.text, "test_duration_seconds_count{handler=\"status\"} 0\n");
+    const char *other = strstr(capture.text, "# TYPE test_other_total counter");
+    TEST_ASSERT_NOT_NULL(status);
+    TEST_ASSERT_NOT_NULL(other);
+    TEST_ASSERT_TRUE(status < other);
+
+    // El primer error de escritura detiene la exportación
+    int calls = 0;
+    TEST_ASSERT_EQUAL(ESP_FAIL, metrics_export_prometheus(failing_write, &calls));
+    TEST_ASSERT_EQUAL(1, calls);
+}
+
+void test_metrics_record_cost(void) {
+    ESP_LOGI(TAG, "Testing that recording a sample costs well under a microsecond");
+
+    static metric_histogram_t cost_hist = METRIC_HISTOGRAM_INIT("test_cost_seconds", "Coste", NULL);
+    static metric_counter_t cost_counter = METRIC_COUNTER_INIT("test_cost_total", "Coste", NULL);
+    const int samples = 100000;
+
+    uint64_t start = esp_timer_get_time();
+    for (int i = 0; i < samples; i++) {
+        metrics_histogram_observe(&cost_hist, (uint32_t)i * 7);
+    }
+    uint64_t hist_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < samples; i++) {
+        metrics_counter_add(&cost_counter, 1);
+    }
+    uint64_t counter_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "observe: %llu ns, counter_add: %llu ns per call",
+             hist_us * 1000 / samples, counter_us * 1000 / samples);
+    TEST_ASSERT_EQUAL(samples, (int)metrics_counter_read(&cost_counter));
+    metric_histogram_snapshot_t snapshot;
+    metrics_histogram_read(&cost_hist, &snapshot);
+    TEST_ASSERT_EQUAL(samples, (int)snapshot.count);
+
+    // Presupuesto: 500 ns por muestra (la mitad de un microsegundo)
+    TEST_ASSERT_TRUE(hist_us * 1000 / samples < 500);
+    TEST_ASSERT_TRUE(counter_us * 1000 / samples < 500);
+}
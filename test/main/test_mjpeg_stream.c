@@ -0,0 +1,111 @@
+#include "unity.h"
+#include "mjpeg_stream.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "TEST_MJPEG_STREAM";
+
+void test_mjpeg_stream_clients(void) {
+    ESP_LOGI(TAG, "Testing stream client slots and rejection");
+
+    mjpeg_stream_config_t config = MJPEG_STREAM_DEFAULT_CONFIG();
+    mjpeg_stream_t stream;
+
+    // Configuraciones inválidas
+    config.max_clients = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, mjpeg_stream_init(&stream, &config));
+    config.max_clients = MJPEG_STREAM_MAX_CLIENTS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, mjpeg_stream_init(&stream, &config));
+    config.max_clients = 2;
+    config.fps = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, mjpeg_stream_init(&stream, &config));
+    config.fps = 5;
+    TEST_ASSERT_EQUAL(ESP_OK, mjpeg_stream_init(&stream, &config));
+    TEST_ASSERT_EQUAL_UINT32(200000, mjpeg_stream_period_us(&stream));
+
+    // Dos huecos: el tercero se rechaza
+    mjpeg_client_t *a = mjpeg_stream_claim(&stream, 1000);
+    mjpeg_client_t *b = mjpeg_stream_claim(&stream, 2000);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NULL(mjpeg_stream_claim(&stream, 3000));
+    TEST_ASSERT_EQUAL(2, stream.active);
+    TEST_ASSERT_EQUAL(1, stream.rejected);
+
+    // Al liberar uno entra otro con identificador nuevo y contadores a cero
+    mjpeg_client_account(a, 1, 200000, 5000, 1000);
+    mjpeg_stream_release(&stream, a);
+    mjpeg_stream_release(&stream, a);
+    TEST_ASSERT_EQUAL(1, stream.active);
+    mjpeg_client_t *c = mjpeg_stream_claim(&stream, 4000);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL(3, c->id);
+    TEST_ASSERT_EQUAL(0, c->stats.sent);
+    TEST_ASSERT_EQUAL(3, stream.total);
+
+    // Cabecera de parte: delimitador, tipo y longitud exacta
+    char part[MJPEG_STREAM_PART_HEADER_MAX];
+    int len = mjpeg_stream_part_header(part, sizeof(part), 12345, 987654321ULL, 42);
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(part));
+    TEST_ASSERT_EQUAL(0, strncmp(part, "--" MJPEG_STREAM_BOUNDARY "\r\n", strlen(MJPEG_STREAM_BOUNDARY) + 4));
+    TEST_ASSERT_NOT_NULL(strstr(part, "Content-Length: 12345\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(part, "X-Frame-Seq: 42\r\n"));
+    TEST_ASSERT_EQUAL(0, strcmp(part + len - 4, "\r\n\r\n"));
+}
+
+void test_mjpeg_stream_slow_client(void) {
+    ESP_LOGI(TAG, "Testing sent, dropped and skipped frame accounting");
+
+    mjpeg_stream_config_t config = MJPEG_STREAM_DEFAULT_CONFIG();
+    mjpeg_stream_t stream;
+    TEST_ASSERT_EQUAL(ESP_OK, mjpeg_stream_init(&stream, &config));
+    uint32_t period = mjpeg_stream_period_us(&stream);
+
+    mjpeg_client_t *fast = mjpeg_stream_claim(&stream, 0);
+    mjpeg_client_t *slow = mjpeg_stream_claim(&stream, 0);
+    TEST_ASSERT_FALSE(mjpeg_client_has_new(fast, 0));
+    TEST_ASSERT_TRUE(mjpeg_client_has_new(fast, 1));
+
+    // La cámara publica a 15 fps y el stream va a 5: el cliente rápido omite 2 de cada 3
+    uint32_t published = 0;
+    for (int i = 0; i < 10; i++) {
+        published += 3;
+        TEST_ASSERT_TRUE(mjpeg_client_has_new(fast, published));
+        mjpeg_client_account(fast, published, period, 20000, 30000);
+        TEST_ASSERT_FALSE(mjpeg_client_has_new(fast, published));
+    }
+    TEST_ASSERT_EQUAL(10, fast->stats.sent);
+    TEST_ASSERT_EQUAL(18, fast->stats.skipped);
+    TEST_ASSERT_EQUAL(0, fast->stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(200000, (uint32_t)fast->stats.bytes);
+
+    // El cliente lento tarda 1 s por frame: lo publicado mientras tanto se pierde
+    mjpeg_client_account(slow, 3, period, 20000, 1000000);
+    mjpeg_client_account(slow, 18, period, 20000, 1000000);
+    mjpeg_client_account(slow, 33, period, 20000, 150000);
+    mjpeg_client_account(slow, 36, period, 20000, 150000);
+    TEST_ASSERT_EQUAL(4, slow->stats.sent);
+    TEST_ASSERT_EQUAL(28, slow->stats.dropped);
+    TEST_ASSERT_EQUAL(2, slow->stats.skipped);
+    TEST_ASSERT_EQUAL_UINT32(1000000, slow->stats.max_send_us);
+    TEST_ASSERT_EQUAL_UINT32(150000, slow->stats.last_send_us);
+
+    // El contador de publicados da la vuelta sin contar frames de más
+    fast->last_published = 0xFFFFFFFEu;
+    mjpeg_client_account(fast, 1, period, 20000, 30000);
+    TEST_ASSERT_EQUAL(20, fast->stats.skipped);
+
+    // JSON con los contadores por cliente
+    char json[512];
+    int len = mjpeg_stream_stats_json(&stream, json, sizeof(json));
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(json));
+    ESP_LOGI(TAG, "%s", json);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"clients\":2"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"id\":2,\"sent\":4,\"dropped\":28,\"skipped\":2"));
+
+    // Buffer pequeño: devuelve la longitud necesaria sin desbordar
+    char small[16];
+    TEST_ASSERT_EQUAL(len, mjpeg_stream_stats_json(&stream, small, sizeof(small)));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+}
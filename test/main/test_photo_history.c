@@ -0,0 +1,178 @@
+#include "unity.h"
+#include "photo_history.h"
+#include "capture_queue.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "TEST_PHOTO_HISTORY";
+
+#define TEST_BUDGET         10000
+#define TEST_ENTRIES        8
+
+static uint8_t source[TEST_BUDGET];
+
+// Frame publicado falso: contenido derivado de la secuencia para detectar solapes
+static camera_frame_t fake_frame(uint32_t seq, size_t len) {
+    memset(source, (uint8_t)(seq * 7 + 1), len);
+    camera_frame_t frame = {
+        .buf = source,
+        .len = len,
+        .seq = seq,
+        .timestamp = seq * 1000ULL,
+        .width = 1280,
+        .height = 720
+    };
+    frame.meta.reason = CAMERA_CAPTURE_REASON_DETECTION;
+    frame.meta.episode_id = seq / 10;
+    return frame;
+}
+
+static bool history_frame_intact(uint32_t seq) {
+    camera_frame_t *frame = photo_history_acquire(seq);
+    if (frame == NULL || frame->seq != seq) {
+        photo_history_release(frame);
+        return false;
+    }
+    bool intact = true;
+    for (size_t i = 0; i < frame->len; i++) {
+        if (frame->buf[i] != (uint8_t)(seq * 7 + 1)) {
+            intact = false;
+            break;
+        }
+    }
+    photo_history_release(frame);
+    return intact;
+}
+
+void test_photo_history_index_and_eviction(void) {
+    ESP_LOGI(TAG, "Testing photo history index queries, lookups and eviction");
+
+    photo_history_config_t config = { .memory_budget = TEST_BUDGET, .max_entries = TEST_ENTRIES };
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_init(&config));
+
+    // Tres fotos de 3000 bytes caben; la cuarta da la vuelta y expulsa la primera
+    for (uint32_t seq = 1; seq <= 4; seq++) {
+        camera_frame_t frame = fake_frame(seq, 3000);
+        TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+    }
+    photo_history_stats_t stats = photo_history_get_stats();
+    TEST_ASSERT_EQUAL(3, stats.count);
+    TEST_ASSERT_EQUAL(1, stats.evicted);
+    TEST_ASSERT_EQUAL(2, stats.oldest_seq);
+    TEST_ASSERT_EQUAL(4, stats.latest_seq);
+    TEST_ASSERT_NULL(photo_history_acquire(1));
+    TEST_ASSERT_TRUE(history_frame_intact(2));
+    TEST_ASSERT_TRUE(history_frame_intact(4));
+
+    // Secuencias repetidas o fuera de orden y fotos mayores que el anillo se rechazan
+    camera_frame_t old = fake_frame(4, 100);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, photo_history_append(&old));
+    camera_frame_t huge = fake_frame(5, TEST_BUDGET + 1);
+    huge.len = TEST_BUDGET + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, photo_history_append(&huge));
+
+    // Con huecos en la secuencia (duplicados descartados) since cae entre dos entradas
+    for (uint32_t seq = 10; seq <= 40; seq += 3) {
+        camera_frame_t frame = fake_frame(seq, 200);
+        TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+    }
+    stats = photo_history_get_stats();
+    TEST_ASSERT_EQUAL(TEST_ENTRIES, stats.count);
+    TEST_ASSERT_EQUAL(19, stats.oldest_seq);
+
+    static photo_history_page_t page;
+    TEST_ASSERT_EQUAL(3, photo_history_list(20, 3, &page));
+    TEST_ASSERT_EQUAL(22, page.entries[0].seq);
+    TEST_ASSERT_EQUAL(28, page.entries[2].seq);
+    TEST_ASSERT_EQUAL(200, page.entries[0].len);
+    TEST_ASSERT_EQUAL(CAMERA_CAPTURE_REASON_DETECTION, page.entries[0].reason);
+    TEST_ASSERT_TRUE(page.more);
+    TEST_ASSERT_EQUAL(19, page.oldest_seq);
+    TEST_ASSERT_EQUAL(40, page.latest_seq);
+
+    // Continuar desde "next" hasta agotar el índice
+    TEST_ASSERT_EQUAL(4, photo_history_list(28, PHOTO_HISTORY_LIST_MAX, &page));
+    TEST_ASSERT_EQUAL(40, page.entries[3].seq);
+    TEST_ASSERT_FALSE(page.more);
+    TEST_ASSERT_EQUAL(0, photo_history_list(40, 10, &page));
+    TEST_ASSERT_EQUAL(0, photo_history_list(UINT32_MAX, 10, &page));
+
+    char json[1024];
+    photo_history_list(34, 10, &page);
+    int len = photo_history_page_json(&page, json, sizeof(json));
+    ESP_LOGI(TAG, "%s", json);
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(json));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"next\":40,\"more\":false"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"seq\":37,\"ts\":37000,\"time\":0,\"reason\":\"detección inicial\",\"size\":200,"));
+
+    // Tamaños aleatorios: ninguna foto retenida puede pisar a otra
+    srand(19);
+    uint32_t seq = 100;
+    for (int i = 0; i < 2000; i++, seq++) {
+        camera_frame_t frame = fake_frame(seq, 1 + rand() % 4000);
+        TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+        stats = photo_history_get_stats();
+        TEST_ASSERT_TRUE(stats.bytes_used <= TEST_BUDGET);
+        photo_history_list(0, PHOTO_HISTORY_LIST_MAX, &page);
+        TEST_ASSERT_EQUAL(stats.count, page.count);
+        for (size_t k = 0; k < page.count; k++) {
+            TEST_ASSERT_TRUE(history_frame_intact(page.entries[k].seq));
+        }
+    }
+    stats = photo_history_get_stats();
+    ESP_LOGI(TAG, "%lu stored, %lu evicted, %lu lookups, %lu misses",
+             stats.stored, stats.evicted, stats.lookups, stats.misses);
+    TEST_ASSERT_EQUAL(0, stats.dropped_busy);
+
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_deinit());
+}
+
+void test_photo_history_reader_blocks_eviction(void) {
+    ESP_LOGI(TAG, "Testing that a photo being sent is never evicted");
+
+    photo_history_config_t config = { .memory_budget = TEST_BUDGET, .max_entries = TEST_ENTRIES };
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_init(&config));
+
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        camera_frame_t frame = fake_frame(seq, 3000);
+        TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+    }
+
+    // Un cliente lento está descargando la más antigua: la foto nueva se descarta entera
+    camera_frame_t *sending = photo_history_acquire(1);
+    TEST_ASSERT_NOT_NULL(sending);
+    camera_frame_t frame = fake_frame(4, 3000);
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, photo_history_append(&frame));
+    photo_history_stats_t stats = photo_history_get_stats();
+    TEST_ASSERT_EQUAL(1, stats.dropped_busy);
+    TEST_ASSERT_EQUAL(3, stats.count);
+    TEST_ASSERT_EQUAL(0, stats.evicted);
+    TEST_ASSERT_TRUE(history_frame_intact(1));
+
+    // Una foto que cabe sin expulsar no depende del lector
+    frame = fake_frame(5, 500);
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+
+    photo_history_release(sending);
+    frame = fake_frame(6, 3000);
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_append(&frame));
+    TEST_ASSERT_NULL(photo_history_acquire(1));
+    TEST_ASSERT_TRUE(history_frame_intact(5));
+    TEST_ASSERT_TRUE(history_frame_intact(6));
+
+    // Con una foto en envío el historial no se libera y sigue sirviendo
+    sending = photo_history_acquire(5);
+    TEST_ASSERT_NOT_NULL(sending);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, photo_history_deinit());
+    TEST_ASSERT_TRUE(history_frame_intact(6));
+    photo_history_release(sending);
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_deinit());
+    TEST_ASSERT_NULL(photo_history_acquire(6));
+
+    // Sin presupuesto el historial queda desactivado
+    config.memory_budget = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, photo_history_init(&config));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, photo_history_append(&frame));
+    TEST_ASSERT_NULL(photo_history_acquire(6));
+}
@@ -0,0 +1,192 @@
+#include "unity.h"
+#include "preroll_ring.h"
+#include "cam_reader.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "TEST_PREROLL_RING";
+
+#define TEST_ENTRIES        4
+#define TEST_ENTRY_SIZE     2048
+
+// Escribe un frame falso con contenido derivado de su marca de tiempo
+static bool write_frame(uint64_t timestamp, size_t len) {
+    uint8_t *data = NULL;
+    camera_frame_t *frame = preroll_ring_begin_write(len, &data);
+    if (frame == NULL) {
+        return false;
+    }
+    memset(data, (uint8_t)(timestamp * 3 + 1), len);
+    frame->timestamp = timestamp;
+    frame->width = 640;
+    frame->height = 480;
+    preroll_ring_commit(frame);
+    return true;
+}
+
+static bool frame_intact(const camera_frame_t *frame) {
+    for (size_t i = 0; i < frame->len; i++) {
+        if (frame->buf[i] != (uint8_t)(frame->timestamp * 3 + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_preroll_ring_wraparound_and_budget(void) {
+    ESP_LOGI(TAG, "Testing pre-trigger ring wraparound, entry budget and readers");
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, preroll_ring_init(1, TEST_ENTRY_SIZE));
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_init(TEST_ENTRIES, TEST_ENTRY_SIZE));
+    TEST_ASSERT_NULL(preroll_ring_acquire_latest());
+
+    // Un frame mayor que la entrada se descarta sin tocar el anillo
+    uint8_t *data = NULL;
+    TEST_ASSERT_NULL(preroll_ring_begin_write(TEST_ENTRY_SIZE + 1, &data));
+    TEST_ASSERT_EQUAL(1, preroll_ring_get_stats().dropped);
+
+    // Diez frames en cuatro entradas: el anillo da la vuelta y retiene los cuatro últimos
+    for (uint64_t t = 1; t <= 10; t++) {
+        TEST_ASSERT_TRUE(write_frame(t, 256 + t * 100));
+    }
+    preroll_ring_stats_t stats = preroll_ring_get_stats();
+    TEST_ASSERT_EQUAL(10, stats.captured);
+    TEST_ASSERT_EQUAL(TEST_ENTRIES, stats.entry_count);
+
+    camera_frame_t *latest = preroll_ring_acquire_latest();
+    TEST_ASSERT_NOT_NULL(latest);
+    TEST_ASSERT_EQUAL(10, latest->seq);
+    TEST_ASSERT_EQUAL(10, latest->timestamp);
+    TEST_ASSERT_EQUAL(256 + 1000, latest->len);
+
+    // Un lector retiene el frame 10: las escrituras siguientes reciclan las otras tres
+    // entradas (la cuarta pisa la 11, no la retenida aunque sea más antigua)
+    for (uint64_t t = 11; t <= 13; t++) {
+        TEST_ASSERT_TRUE(write_frame(t, 512));
+    }
+    TEST_ASSERT_TRUE(write_frame(14, 512));
+    TEST_ASSERT_EQUAL(10, latest->seq);
+    TEST_ASSERT_TRUE(frame_intact(latest));
+    preroll_ring_release(latest);
+
+    // Liberado: vuelve a reciclarse como la más antigua
+    TEST_ASSERT_TRUE(write_frame(15, 512));
+    latest = preroll_ring_acquire_latest();
+    TEST_ASSERT_NOT_NULL(latest);
+    TEST_ASSERT_EQUAL(15, latest->timestamp);
+    preroll_ring_release(latest);
+
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_deinit());
+    TEST_ASSERT_NULL(preroll_ring_acquire_latest());
+    TEST_ASSERT_NULL(preroll_ring_begin_write(16, &data));
+}
+
+void test_preroll_ring_freeze_and_refcounts(void) {
+    ESP_LOGI(TAG, "Testing pre-trigger episode freeze, unfreeze and references");
+
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_init(TEST_ENTRIES, TEST_ENTRY_SIZE));
+    for (uint64_t t = 100; t <= 400; t += 100) {
+        TEST_ASSERT_TRUE(write_frame(t, 300));
+    }
+
+    // Congelar los frames desde t = 200: tres frames, el de t = 100 sigue reciclable
+    TEST_ASSERT_EQUAL(0, preroll_ring_freeze(0, 200, 400));
+    TEST_ASSERT_EQUAL(3, preroll_ring_freeze(7, 200, 400));
+    preroll_ring_stats_t stats = preroll_ring_get_stats();
+    TEST_ASSERT_EQUAL(3, stats.frozen);
+    TEST_ASSERT_EQUAL(7, stats.frozen_episode);
+
+    // Con tres entradas congeladas solo queda una para la captura continua
+    TEST_ASSERT_TRUE(write_frame(500, 300));
+    TEST_ASSERT_TRUE(write_frame(600, 300));
+
+    camera_frame_t *frames[PREROLL_EPISODE_MAX];
+    size_t count = preroll_ring_acquire_episode(7, frames, PREROLL_EPISODE_MAX);
+    TEST_ASSERT_EQUAL(3, count);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(200 + i * 100, frames[i]->timestamp);
+        TEST_ASSERT_EQUAL(7, frames[i]->meta.episode_id);
+        TEST_ASSERT_TRUE(frame_intact(frames[i]));
+    }
+    TEST_ASSERT_EQUAL(0, preroll_ring_acquire_episode(8, frames + count, PREROLL_EPISODE_MAX));
+
+    // Índice para /photo/preroll
+    char json[512];
+    int len = preroll_ring_episode_json(7, frames, count, json, sizeof(json));
+    TEST_ASSERT_LESS_THAN((int)sizeof(json), len);
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"episode\":7,\"count\":3,\"frames\":[{\"index\":0,"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"ts\":400,"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"w\":640,\"h\":480}]}"));
+
+    // El episodio siguiente descongela el 7: sus entradas retenidas no se reciclan
+    // hasta que el lector las suelta
+    TEST_ASSERT_EQUAL(1, preroll_ring_freeze(8, 600, 600));
+    TEST_ASSERT_EQUAL(0, preroll_ring_acquire_episode(7, frames + count, PREROLL_EPISODE_MAX));
+    TEST_ASSERT_FALSE(write_frame(700, 300));
+    TEST_ASSERT_EQUAL(200, frames[0]->timestamp);
+    TEST_ASSERT_TRUE(frame_intact(frames[0]));
+
+    // Con un frame retenido el anillo no se libera y sigue operativo
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, preroll_ring_deinit());
+    TEST_ASSERT_TRUE(frame_intact(frames[2]));
+
+    for (size_t i = 0; i < count; i++) {
+        preroll_ring_release(frames[i]);
+    }
+    TEST_ASSERT_TRUE(write_frame(700, 300));
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_deinit());
+    TEST_ASSERT_EQUAL(0, preroll_ring_freeze(9, 0, 0));
+}
+
+void test_preroll_ring_consecutive_episodes(void) {
+    ESP_LOGI(TAG, "Testing two consecutive episodes at the default ring sizing");
+
+    // La configuración por defecto cubre dos ventanas; la de 8 entradas de 128 KB no
+    camera_preroll_config_t config = CAMERA_PREROLL_DEFAULT_CONFIG();
+    size_t count = config.memory_budget / config.max_frame_size;
+    size_t window = config.preroll_ms / config.frame_interval_ms + 1;
+    size_t needed = preroll_ring_entries_needed(config.preroll_ms, config.frame_interval_ms);
+    TEST_ASSERT_TRUE(count >= needed);
+    TEST_ASSERT_TRUE((1024 * 1024) / (128 * 1024) < needed);
+    TEST_ASSERT_EQUAL(0, preroll_ring_entries_needed(config.preroll_ms, 0));
+
+    uint64_t interval = (uint64_t)config.frame_interval_ms * 1000;
+    uint64_t span = (uint64_t)config.preroll_ms * 1000;
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_init(count, TEST_ENTRY_SIZE));
+
+    // Captura continua con un cliente de /stream que retiene siempre el último frame
+    camera_frame_t *stream = NULL;
+    camera_frame_t *frames[PREROLL_EPISODE_MAX];
+    uint64_t t = 0;
+    for (uint32_t episode = 1; episode <= 2; episode++) {
+        uint64_t onset = 0;
+        for (size_t k = 1; k <= 22; k++) {
+            t += interval;
+            TEST_ASSERT_TRUE(write_frame(t, 300));
+            preroll_ring_release(stream);
+            stream = preroll_ring_acquire_latest();
+            TEST_ASSERT_NOT_NULL(stream);
+
+            // Flanco en el frame 20; los dos siguientes llegan durante la confirmación
+            if (k == 20) {
+                onset = t;
+            }
+        }
+
+        // Cada episodio congela la ventana completa y consecutiva hasta el flanco, también
+        // el segundo con el primero todavía congelado
+        TEST_ASSERT_EQUAL(window, preroll_ring_freeze(episode, onset - span, onset));
+        size_t frozen = preroll_ring_acquire_episode(episode, frames, PREROLL_EPISODE_MAX);
+        TEST_ASSERT_EQUAL(window, frozen);
+        for (size_t i = 0; i < frozen; i++) {
+            TEST_ASSERT_EQUAL(onset - span + i * interval, frames[i]->timestamp);
+            TEST_ASSERT_TRUE(frame_intact(frames[i]));
+            preroll_ring_release(frames[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, preroll_ring_get_stats().dropped);
+
+    preroll_ring_release(stream);
+    TEST_ASSERT_EQUAL(ESP_OK, preroll_ring_deinit());
+}
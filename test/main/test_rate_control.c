@@ -0,0 +1,138 @@
+#include "unity.h"
+#include "rate_control.h"
+#include "esp_log.h"
+#include <math.h>
+
+static const char *TAG = "TEST_RATE_CONTROL";
+
+#define FRAME_INTERVAL_US   500000
+#define FS_SVGA             9
+#define FS_HD               11
+
+// Modelo de cámara: tamaño = base * exp(-(calidad - 10) / 17), escalado por píxeles
+typedef struct {
+    rate_control_t rc;
+    float base;
+    int16_t quality;
+    int16_t frame_size;
+    int16_t pipeline_quality;     // Configuración del frame que ya está en el buffer
+    int16_t pipeline_frame_size;
+    uint64_t now;
+    uint32_t noise_state;
+    uint32_t changes;
+} camera_model_t;
+
+static void model_init(camera_model_t *model, float base, int16_t quality) {
+    model->base = base;
+    model->quality = model->pipeline_quality = quality;
+    model->frame_size = model->pipeline_frame_size = FS_HD;
+    model->now = 0;
+    model->noise_state = 1;
+    model->changes = 0;
+}
+
+static size_t model_step(camera_model_t *model, float noise_pct) {
+    model->noise_state = model->noise_state * 1664525u + 1013904223u;
+    float noise = ((model->noise_state >> 8) / 16777216.0f * 2.0f - 1.0f) * noise_pct / 100.0f;
+    float scale = model->pipeline_frame_size == FS_HD ? 1.0f : (800.0f * 600.0f) / (1280.0f * 720.0f);
+    size_t size = (size_t)(model->base * scale * expf(-(model->pipeline_quality - 10) / 17.0f) * (1.0f + noise));
+
+    model->now += FRAME_INTERVAL_US;
+    rate_control_sample_t sample = {
+        .size = size,
+        .timestamp = model->now,
+        .quality = model->quality,
+        .frame_size = model->frame_size,
+    };
+    rate_control_decision_t decision;
+    rate_control_update(&model->rc, &sample, &decision);
+
+    model->pipeline_quality = model->quality;
+    model->pipeline_frame_size = model->frame_size;
+    if (decision.changed) {
+        model->quality = decision.quality;
+        model->frame_size = decision.frame_size;
+        model->changes++;
+    }
+    return size;
+}
+
+void test_rate_control_day_night_convergence(void) {
+    ESP_LOGI(TAG, "Testing JPEG size controller across a day/night transition");
+
+    static camera_model_t model;
+    rate_control_config_t config = RATE_CONTROL_DEFAULT_CONFIG();
+    TEST_ASSERT_EQUAL(ESP_OK, rate_control_init(&model.rc, &config));
+
+    // Día: ~94 KB a calidad 10, el objetivo de 48 KB queda hacia calidad 21
+    model_init(&model, 94000.0f, 12);
+    size_t size = 0;
+    for (int i = 0; i < 30; i++) {
+        size = model_step(&model, 5.0f);
+    }
+    uint32_t day_changes = model.changes;
+    ESP_LOGI(TAG, "Día: calidad %d, %zu bytes tras %lu ajustes", model.quality, size, day_changes);
+    TEST_ASSERT_TRUE(model.quality > 15 && model.quality < 28);
+    TEST_ASSERT_TRUE(fabsf(logf((float)model.rc.stats.average_size / config.target_bytes)) < logf(1.15f));
+    TEST_ASSERT_LESS_OR_EQUAL(4, day_changes);
+
+    // Con ruido del 5% y la banda muerta del 15% no debe oscilar
+    for (int i = 0; i < 40; i++) {
+        model_step(&model, 5.0f);
+    }
+    TEST_ASSERT_EQUAL(day_changes, model.changes);
+
+    // Noche: frames 2.5 veces más grandes, la calidad sube hasta recuperar el presupuesto
+    model.base = 233000.0f;
+    for (int i = 0; i < 30; i++) {
+        size = model_step(&model, 8.0f);
+    }
+    ESP_LOGI(TAG, "Noche: calidad %d, %zu bytes, %lu ajustes en total", model.quality, size, model.changes);
+    TEST_ASSERT_TRUE(model.quality > 30);
+    TEST_ASSERT_TRUE(fabsf(logf((float)model.rc.stats.average_size / config.target_bytes)) < logf(1.15f));
+    TEST_ASSERT_LESS_OR_EQUAL(day_changes + 4, model.changes);
+    TEST_ASSERT_EQUAL(model.changes, model.rc.stats.quality_changes);
+}
+
+void test_rate_control_limits_and_steps(void) {
+    ESP_LOGI(TAG, "Testing hard limit, resolution steps and bytes-per-second budget");
+
+    static camera_model_t model;
+    rate_control_config_t config = RATE_CONTROL_DEFAULT_CONFIG();
+    config.max_quality = 30;
+    config.step_count = 2;
+    config.steps[0] = (rate_control_step_t){ FS_SVGA, 800 * 600 };
+    config.steps[1] = (rate_control_step_t){ FS_HD, 1280 * 720 };
+    TEST_ASSERT_EQUAL(ESP_OK, rate_control_init(&model.rc, &config));
+
+    // Un frame por encima del límite duro fuerza el paso máximo de inmediato
+    model_init(&model, 400000.0f, 10);
+    model_step(&model, 0);
+    TEST_ASSERT_EQUAL(1, model.rc.stats.hard_limit_hits);
+    TEST_ASSERT_EQUAL(10 + config.max_step, model.quality);
+
+    // Con la calidad en el tope, el controlador baja de HD a SVGA
+    for (int i = 0; i < 20; i++) {
+        model_step(&model, 0);
+    }
+    TEST_ASSERT_EQUAL(FS_SVGA, model.frame_size);
+    TEST_ASSERT_EQUAL(1, model.rc.stats.frame_size_changes);
+
+    // Objetivo por segundo: 20 KB/s a 2 frames/s son 10 KB por frame
+    config = (rate_control_config_t)RATE_CONTROL_DEFAULT_CONFIG();
+    config.target_bytes = 0;
+    config.target_bytes_per_sec = 20000;
+    TEST_ASSERT_EQUAL(ESP_OK, rate_control_init(&model.rc, &config));
+    model_init(&model, 40000.0f, 12);
+    for (int i = 0; i < 3; i++) {
+        model_step(&model, 0);
+    }
+    TEST_ASSERT_UINT_WITHIN(10, 10000, model.rc.stats.budget);
+
+    // Configuraciones inválidas
+    config.target_bytes_per_sec = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, rate_control_init(&model.rc, &config));
+    config = (rate_control_config_t)RATE_CONTROL_DEFAULT_CONFIG();
+    config.min_quality = 50;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, rate_control_init(&model.rc, &config));
+}
@@ -0,0 +1,167 @@
+#include "unity.h"
+#include "rate_limit.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TEST_RATE_LIMIT";
+
+#define SECOND_US   1000000ULL
+
+// Dirección IPv4 a.b.c.d como ::ffff:a.b.c.d
+static void ipv4(uint8_t *addr, uint8_t last) {
+    memset(addr, 0, RATE_LIMIT_ADDR_LEN);
+    addr[10] = 0xff;
+    addr[11] = 0xff;
+    addr[12] = 192;
+    addr[13] = 168;
+    addr[14] = 1;
+    addr[15] = last;
+}
+
+void test_rate_limit_token_bucket(void) {
+    ESP_LOGI(TAG, "Testing per-client token bucket burst, refill and Retry-After");
+
+    rate_limit_t limiter;
+    rate_limit_config_t config = RATE_LIMIT_DEFAULT_CONFIG();
+    config.classes[RATE_LIMIT_PHOTO].per_minute = 0;
+    config.classes[RATE_LIMIT_PHOTO].burst = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, rate_limit_init(&limiter, &config));
+    config.classes[RATE_LIMIT_PHOTO].per_minute = 60;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, rate_limit_init(&limiter, &config));
+    config.classes[RATE_LIMIT_PHOTO].burst = RATE_LIMIT_MAX_BURST + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, rate_limit_init(&limiter, &config));
+    config.classes[RATE_LIMIT_PHOTO].burst = 3;
+    config.classes[RATE_LIMIT_STREAM].burst = 1;
+    config.classes[RATE_LIMIT_STREAM].per_minute = 6;
+    TEST_ASSERT_EQUAL(ESP_OK, rate_limit_init(&limiter, &config));
+
+    uint8_t addr[RATE_LIMIT_ADDR_LEN];
+    uint32_t retry_after = 0;
+    uint64_t now = 5 * SECOND_US;
+    ipv4(addr, 20);
+
+    // Ráfaga admitida y después 503 con el tiempo hasta el siguiente token
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, &retry_after));
+    }
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, &retry_after));
+    TEST_ASSERT_EQUAL(1, retry_after);
+
+    // Cada ruta tiene su cubeta: 6 por minuto es un token cada 10 s
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_STREAM, now, NULL));
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_STREAM, now, &retry_after));
+    TEST_ASSERT_EQUAL(10, retry_after);
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_STREAM, now + 4 * SECOND_US, &retry_after));
+    TEST_ASSERT_EQUAL(6, retry_after);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_STREAM, now + 10 * SECOND_US, NULL));
+
+    // Consultas cada milisegundo: la recarga no pierde las fracciones y el token llega a 1 s justo
+    uint64_t t = now;
+    while (!rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, t, NULL)) {
+        t += 1000;
+    }
+    TEST_ASSERT_EQUAL(SECOND_US, t - now);
+
+    // Tras mucho tiempo sin pedir nada la cubeta está llena, pero no por encima de la ráfaga
+    now += 3600 * SECOND_US;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, NULL));
+    }
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, NULL));
+
+    // Otra dirección no se ve afectada
+    uint8_t other[RATE_LIMIT_ADDR_LEN];
+    ipv4(other, 21);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, other, RATE_LIMIT_PHOTO, now, NULL));
+
+    // Un 304 devuelve su token, sin pasar nunca de la ráfaga
+    rate_limit_refund(&limiter, addr, RATE_LIMIT_PHOTO);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, NULL));
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, NULL));
+    rate_limit_refund(&limiter, other, RATE_LIMIT_PHOTO);
+    rate_limit_refund(&limiter, other, RATE_LIMIT_PHOTO);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, other, RATE_LIMIT_PHOTO, now, NULL));
+    }
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, other, RATE_LIMIT_PHOTO, now, NULL));
+    TEST_ASSERT_EQUAL(3, limiter.stats[RATE_LIMIT_PHOTO].refunded);
+
+    // Una dirección que no está en la tabla no recibe nada ni ocupa hueco
+    uint8_t unknown[RATE_LIMIT_ADDR_LEN];
+    ipv4(unknown, 99);
+    rate_limit_refund(&limiter, unknown, RATE_LIMIT_PHOTO);
+    TEST_ASSERT_EQUAL(3, limiter.stats[RATE_LIMIT_PHOTO].refunded);
+
+    // El historial tiene su cubeta: con /photo agotado se pueden leer 60 seguidas
+    for (int i = 0; i < 60; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_HISTORY, now, NULL));
+    }
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_HISTORY, now, &retry_after));
+    TEST_ASSERT_EQUAL(1, retry_after);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_HISTORY, now + SECOND_US / 5, NULL));
+    TEST_ASSERT_EQUAL_STRING("history", rate_limit_class_name(RATE_LIMIT_HISTORY));
+
+    TEST_ASSERT_EQUAL(3 + 1 + 3 + 1 + 1 + 3, limiter.stats[RATE_LIMIT_PHOTO].allowed);
+    TEST_ASSERT_EQUAL(2, limiter.stats[RATE_LIMIT_STREAM].allowed);
+    TEST_ASSERT_EQUAL(2, limiter.stats[RATE_LIMIT_STREAM].rejected);
+    TEST_ASSERT_EQUAL(2, limiter.active);
+
+    // Ruta sin límite: siempre se admite y no ocupa huecos
+    config.classes[RATE_LIMIT_PHOTO].per_minute = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, rate_limit_init(&limiter, &config));
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now, NULL));
+    }
+    TEST_ASSERT_EQUAL(0, limiter.active);
+}
+
+void test_rate_limit_lru_and_json(void) {
+    ESP_LOGI(TAG, "Testing rate limiter LRU eviction and status JSON");
+
+    rate_limit_t limiter;
+    rate_limit_config_t config = {
+        .classes = {
+            [RATE_LIMIT_PHOTO] = { .burst = 1, .per_minute = 1 },
+            [RATE_LIMIT_STREAM] = { .burst = 2, .per_minute = 0 }
+        }
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, rate_limit_init(&limiter, &config));
+
+    // Tabla llena: cada dirección gasta su único token
+    uint8_t addr[RATE_LIMIT_ADDR_LEN];
+    for (int i = 0; i < RATE_LIMIT_MAX_CLIENTS; i++) {
+        ipv4(addr, i);
+        TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, (uint64_t)(i + 1) * 1000, NULL));
+    }
+    TEST_ASSERT_EQUAL(RATE_LIMIT_MAX_CLIENTS, limiter.active);
+
+    // La primera vuelve a pedir: sigue vacía y pasa a ser la más reciente
+    ipv4(addr, 0);
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, 100000, NULL));
+
+    // Una dirección nueva ocupa el hueco de la menos reciente (la 1), no el de la 0
+    ipv4(addr, 200);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, 200000, NULL));
+    TEST_ASSERT_EQUAL(1, limiter.evicted);
+    TEST_ASSERT_EQUAL(RATE_LIMIT_MAX_CLIENTS, limiter.active);
+    ipv4(addr, 0);
+    TEST_ASSERT_FALSE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, 300000, NULL));
+    ipv4(addr, 1);
+    TEST_ASSERT_TRUE(rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, 400000, NULL));
+    TEST_ASSERT_EQUAL(2, limiter.evicted);
+
+    char json[384];
+    rate_limit_stats_t stats;
+    rate_limit_get_stats(&limiter, &stats);
+    int len = rate_limit_stats_json(&stats, json, sizeof(json));
+    TEST_ASSERT_TRUE(len < (int)sizeof(json));
+    TEST_ASSERT_EQUAL_STRING("{\"clients\":16,\"evicted\":2,"
+                             "\"photo\":{\"burst\":1,\"per_minute\":1,\"allowed\":18,\"rejected\":2,\"refunded\":0},"
+                             "\"stream\":{\"burst\":2,\"per_minute\":0,\"allowed\":0,\"rejected\":0,\"refunded\":0},"
+                             "\"history\":{\"burst\":0,\"per_minute\":0,\"allowed\":0,\"rejected\":0,\"refunded\":0}}",
+                             json);
+    TEST_ASSERT_EQUAL_STRING("stream", rate_limit_class_name(RATE_LIMIT_STREAM));
+
+    // Buffer corto: devuelve la longitud necesaria como snprintf
+    TEST_ASSERT_EQUAL(len, rate_limit_stats_json(&stats, json, 16));
+}
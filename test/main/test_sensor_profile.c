@@ -0,0 +1,136 @@
+#include "unity.h"
+#include "sensor_profile.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TEST_SENSOR_PROFILE";
+
+// Sensor simulado: registra las escrituras y puede rechazar un registro
+typedef struct {
+    int16_t values[SENSOR_REG_COUNT];
+    uint32_t writes;
+    int reject;               // Registro que el sensor rechaza (-1 = ninguno)
+} fake_sensor_t;
+
+static int fake_write(void *ctx, sensor_reg_t reg, int16_t value) {
+    fake_sensor_t *sensor = ctx;
+    if ((int)reg == sensor->reject) {
+        return -1;
+    }
+    sensor->values[reg] = value;
+    sensor->writes++;
+    return 0;
+}
+
+static const sensor_reg_value_t night_entries[] = {
+    SENSOR_PROFILE_ENTRY(BRIGHTNESS, 2),
+    SENSOR_PROFILE_ENTRY(CONTRAST, 1),
+    SENSOR_PROFILE_ENTRY(AE_LEVEL, 2),
+    SENSOR_PROFILE_ENTRY(AEC_VALUE, 800),
+    SENSOR_PROFILE_ENTRY(AGC_GAIN, 20),
+    SENSOR_PROFILE_ENTRY(GAINCEILING, 5),
+    SENSOR_PROFILE_ENTRY(LENC, 1),
+    SENSOR_PROFILE_ENTRY(DCW, 1),
+};
+
+static const sensor_reg_value_t day_entries[] = {
+    SENSOR_PROFILE_ENTRY(BRIGHTNESS, -1),
+    SENSOR_PROFILE_ENTRY(CONTRAST, 0),
+    SENSOR_PROFILE_ENTRY(AE_LEVEL, -2),
+    SENSOR_PROFILE_ENTRY(AEC_VALUE, 150),
+    SENSOR_PROFILE_ENTRY(AGC_GAIN, 2),
+    SENSOR_PROFILE_ENTRY(GAINCEILING, 1),
+    SENSOR_PROFILE_ENTRY(LENC, 1),
+    SENSOR_PROFILE_ENTRY(DCW, 1),
+};
+
+static const sensor_profile_t night = SENSOR_PROFILE_DEFINE("nocturno", night_entries);
+static const sensor_profile_t day = SENSOR_PROFILE_DEFINE("diurno", day_entries);
+
+void test_sensor_profile_diffed_switches(void) {
+    ESP_LOGI(TAG, "Testing profile switches write only changed registers");
+
+    sensor_profile_state_t state;
+    fake_sensor_t sensor = { .reject = -1 };
+    sensor_profile_state_init(&state);
+
+    // Estado desconocido: el primer perfil se escribe completo
+    TEST_ASSERT_EQUAL(night.count, sensor_profile_diff(&state, &night, NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_apply(&state, &night, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(night.count, sensor.writes);
+    TEST_ASSERT_EQUAL(800, sensor.values[SENSOR_REG_AEC_VALUE]);
+
+    // Mismo perfil otra vez: ninguna escritura
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_apply(&state, &night, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(night.count, sensor.writes);
+    TEST_ASSERT_EQUAL(0, state.stats.last_written);
+
+    // Día: LENC y DCW coinciden, se escriben los otros 6 en el orden del perfil
+    sensor_reg_value_t writes[SENSOR_REG_COUNT];
+    TEST_ASSERT_EQUAL(6, sensor_profile_diff(&state, &day, writes, SENSOR_REG_COUNT));
+    TEST_ASSERT_EQUAL(SENSOR_REG_BRIGHTNESS, writes[0].reg);
+    TEST_ASSERT_EQUAL(-1, writes[0].value);
+    TEST_ASSERT_EQUAL(SENSOR_REG_GAINCEILING, writes[5].reg);
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_apply(&state, &day, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(night.count + 6, sensor.writes);
+    TEST_ASSERT_EQUAL(-2, sensor.values[SENSOR_REG_AE_LEVEL]);
+
+    // Un ajuste individual entra en el estado: volver de noche lo reescribe, repetirlo no
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_set(&state, SENSOR_REG_LENC, 0, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_set(&state, SENSOR_REG_LENC, 0, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(night.count + 7, sensor.writes);
+    TEST_ASSERT_EQUAL(7, sensor_profile_diff(&state, &night, NULL, 0));
+
+    // Un registro rechazado queda desconocido y se reintenta en el siguiente cambio
+    sensor.reject = SENSOR_REG_AGC_GAIN;
+    TEST_ASSERT_EQUAL(ESP_FAIL, sensor_profile_apply(&state, &night, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(1, state.stats.write_errors);
+    sensor.reject = -1;
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_apply(&state, &night, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(1, state.stats.last_written);
+    TEST_ASSERT_EQUAL(20, sensor.values[SENSOR_REG_AGC_GAIN]);
+
+    ESP_LOGI(TAG, "%lu cambios: %lu escrituras, %lu evitadas, máximo %lu us",
+             state.stats.switches, state.stats.registers_written,
+             state.stats.registers_skipped, state.stats.max_switch_us);
+    TEST_ASSERT_EQUAL(5, state.stats.switches);
+    TEST_ASSERT_TRUE(state.stats.registers_skipped > state.stats.registers_written / 2);
+    TEST_ASSERT_EQUAL_STRING("nocturno", state.stats.active);
+}
+
+void test_sensor_profile_validation(void) {
+    ESP_LOGI(TAG, "Testing load-time profile validation");
+
+    sensor_profile_state_t state;
+    fake_sensor_t sensor = { .reject = -1 };
+    sensor_profile_state_init(&state);
+
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_validate(&night));
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_validate(&day));
+
+    // Los valores del antiguo perfil diurno (brillo -8, contraste -10) se rechazan
+    sensor_reg_value_t entries[] = {
+        { SENSOR_REG_BRIGHTNESS, -8 },
+        { SENSOR_REG_CONTRAST, -10 },
+    };
+    sensor_profile_t runtime = { "runtime", entries, 2 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_validate(&runtime));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_apply(&state, &runtime, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(0, sensor.writes);
+
+    // Registro repetido o inexistente
+    entries[0] = (sensor_reg_value_t){ SENSOR_REG_CONTRAST, 1 };
+    entries[1] = (sensor_reg_value_t){ SENSOR_REG_CONTRAST, 0 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_validate(&runtime));
+    entries[1] = (sensor_reg_value_t){ SENSOR_REG_COUNT, 0 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_validate(&runtime));
+
+    // Límites de rango y ajustes individuales
+    entries[0] = (sensor_reg_value_t){ SENSOR_REG_AEC_VALUE, 1200 };
+    entries[1] = (sensor_reg_value_t){ SENSOR_REG_WB_MODE, 4 };
+    TEST_ASSERT_EQUAL(ESP_OK, sensor_profile_validate(&runtime));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_set(&state, SENSOR_REG_AGC_GAIN, 31, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_set(&state, SENSOR_REG_AE_LEVEL, -10, fake_write, &sensor));
+    TEST_ASSERT_EQUAL(0, sensor.writes);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sensor_profile_validate(NULL));
+}
@@ -0,0 +1,140 @@
+#include "unity.h"
+#include "seqlock.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "TEST_SEQLOCK";
+
+#define TEST_WORDS          14
+#define TEST_READERS        3
+#define TEST_WRITERS        2
+#define TEST_WRITES         20000   // Por escritor
+
+// Instantánea con invariante: todas las palabras derivan de version y check las suma
+typedef struct {
+    uint32_t version;
+    uint32_t words[TEST_WORDS];
+    uint64_t check;
+} test_snapshot_t;
+
+static test_snapshot_t shared = {0};
+static seqlock_t shared_lock = SEQLOCK_INIT();
+static volatile int writers_running = 0;
+static uint32_t torn_reads = 0;
+static uint32_t total_reads = 0;
+static uint32_t total_retries = 0;
+static SemaphoreHandle_t done_sem = NULL;
+
+static bool snapshot_consistent(const test_snapshot_t *s) {
+    uint64_t sum = s->version;
+    for (int i = 0; i < TEST_WORDS; i++) {
+        if (s->words[i] != s->version * (uint32_t)(i + 3)) {
+            return false;
+        }
+        sum += s->words[i];
+    }
+    return sum == s->check;
+}
+
+static void writer_task(void *arg) {
+    for (int n = 0; n < TEST_WRITES; n++) {
+        // Modificación en el sitio: los dos escritores se serializan en la sección crítica
+        seqlock_write_begin(&shared_lock);
+        uint32_t version = shared.version + 1;
+        uint64_t sum = version;
+        shared.version = version;
+        for (int i = 0; i < TEST_WORDS; i++) {
+            shared.words[i] = version * (uint32_t)(i + 3);
+            sum += shared.words[i];
+        }
+        shared.check = sum;
+        seqlock_write_end(&shared_lock);
+        if ((n % 256) == 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    __atomic_fetch_sub(&writers_running, 1, __ATOMIC_RELEASE);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void reader_task(void *arg) {
+    uint32_t last_version = 0;
+
+    while (__atomic_load_n(&writers_running, __ATOMIC_ACQUIRE) > 0) {
+        test_snapshot_t copy;
+        uint32_t retries = seqlock_read(&shared_lock, &copy, &shared, sizeof(copy));
+        if (!snapshot_consistent(&copy) || copy.version < last_version) {
+            __atomic_fetch_add(&torn_reads, 1, __ATOMIC_RELAXED);
+        }
+        last_version = copy.version;
+        __atomic_fetch_add(&total_reads, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&total_retries, retries, __ATOMIC_RELAXED);
+    }
+
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+void test_seqlock_snapshot_api(void) {
+    ESP_LOGI(TAG, "Testing seqlock whole-struct write and read");
+
+    seqlock_t lock = SEQLOCK_INIT();
+    test_snapshot_t value = { .version = 7, .check = 42 };
+    test_snapshot_t stored = {0};
+    test_snapshot_t copy;
+
+    seqlock_write(&lock, &stored, &value, sizeof(value));
+    TEST_ASSERT_EQUAL(2, lock.seq);
+    TEST_ASSERT_EQUAL(0, seqlock_read(&lock, &copy, &stored, sizeof(copy)));
+    TEST_ASSERT_EQUAL(7, copy.version);
+    TEST_ASSERT_EQUAL(42, (int)copy.check);
+
+    // Una escritura entre begin y retry invalida la lectura
+    uint32_t seq = seqlock_read_begin(&lock);
+    TEST_ASSERT_FALSE(seqlock_read_retry(&lock, seq));
+    seqlock_write_begin(&lock);
+    stored.version = 8;
+    seqlock_write_end(&lock);
+    TEST_ASSERT_TRUE(seqlock_read_retry(&lock, seq));
+}
+
+void test_seqlock_concurrent_readers_writers(void) {
+    ESP_LOGI(TAG, "Testing seqlock with %d readers and %d writers x %d writes",
+             TEST_READERS, TEST_WRITERS, TEST_WRITES);
+
+    memset(&shared, 0, sizeof(shared));
+    torn_reads = 0;
+    total_reads = 0;
+    total_retries = 0;
+    writers_running = TEST_WRITERS;
+    done_sem = xSemaphoreCreateCounting(TEST_READERS + TEST_WRITERS, 0);
+    TEST_ASSERT_NOT_NULL(done_sem);
+
+    for (int i = 0; i < TEST_READERS; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(reader_task, "sl_reader", 3072,
+                                                          NULL, 5, NULL, i % portNUM_PROCESSORS));
+    }
+    for (int i = 0; i < TEST_WRITERS; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(writer_task, "sl_writer", 3072,
+                                                          NULL, 5, NULL, i % portNUM_PROCESSORS));
+    }
+
+    for (int i = 0; i < TEST_READERS + TEST_WRITERS; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done_sem, pdMS_TO_TICKS(60000)));
+    }
+    vSemaphoreDelete(done_sem);
+    done_sem = NULL;
+
+    ESP_LOGI(TAG, "Lecturas: %lu, repetidas: %lu, incoherentes: %lu",
+             total_reads, total_retries, torn_reads);
+
+    TEST_ASSERT_EQUAL(0, torn_reads);
+    TEST_ASSERT_EQUAL(TEST_WRITERS * TEST_WRITES, shared.version);
+    TEST_ASSERT_TRUE(snapshot_consistent(&shared));
+    TEST_ASSERT_GREATER_THAN(0, total_reads);
+}
@@ -0,0 +1,197 @@
+#include "unity.h"
+#include "server_events.h"
+#include "capture_queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "TEST_SERVER_EVENTS";
+
+#define TEST_ROUNDS         500     // Colas llenas vaciadas por modo en la medida de rendimiento
+#define TEST_PRODUCED       20000   // Eventos de la prueba concurrente
+
+static QueueHandle_t queue = NULL;
+static volatile bool producer_done = false;
+static uint32_t producer_failed = 0;
+
+static server_event_t detection_event(uint32_t count, bool started) {
+    server_event_t event = {
+        .type = started ? SERVER_EVENT_DETECTION_STARTED : SERVER_EVENT_DETECTION_ENDED,
+        .timestamp = 1000ULL * count,
+        .object_detected = started,
+        .sensor_state = started ? 0 : 1
+    };
+    event.detection_data.detection_count = count;
+    return event;
+}
+
+static server_event_t photo_event(uint32_t seq) {
+    server_event_t event = {
+        .type = SERVER_EVENT_PHOTO_TAKEN,
+        .timestamp = 1000ULL * seq + 500,
+        .reason = CAMERA_CAPTURE_REASON_DETECTION,
+        .sensor_state = -1
+    };
+    event.photo_data.seq = seq;
+    event.photo_data.photo_size = 61440;
+    return event;
+}
+
+// Lo que hace la tarea del servidor con cada vaciado: aplicar al estado y serializar
+// cada evento con el registro de /events tomado una vez
+static size_t consume(server_event_t *batch, size_t max, server_state_t *state, SemaphoreHandle_t mutex) {
+    char data[160];
+    size_t count = server_events_drain(queue, batch, max, 0);
+
+    if (count > 0) {
+        server_events_apply(state, batch, count);
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        for (size_t i = 0; i < count; i++) {
+            server_event_json(&batch[i], data, sizeof(data));
+        }
+        xSemaphoreGive(mutex);
+    }
+    return count;
+}
+
+void test_server_events_apply_and_json(void) {
+    ESP_LOGI(TAG, "Testing compact server events, batch apply and JSON");
+
+    TEST_ASSERT_TRUE(sizeof(server_event_t) <= 24);
+
+    // Un lote se aplica en orden: el último evento de cada campo gana
+    server_event_t batch[] = {
+        detection_event(7, true),
+        photo_event(41),
+        detection_event(7, false),
+        detection_event(8, true),
+        { .type = 99, .timestamp = 99999 },
+    };
+    server_state_t state = { .initialized = true };
+    TEST_ASSERT_EQUAL(1, server_events_apply(&state, batch, 5));
+    TEST_ASSERT_EQUAL(8, state.total_detections);
+    TEST_ASSERT_TRUE(state.object_currently_detected);
+    TEST_ASSERT_EQUAL(0, state.current_sensor_state);
+    TEST_ASSERT_TRUE(state.has_photo_available);
+    TEST_ASSERT_EQUAL(8000, (int)state.last_update_time);
+
+    // La razón viaja como código y se traduce solo al serializar
+    char json[160];
+    TEST_ASSERT_EQUAL_STRING("photo_taken", server_event_json(&batch[1], json, sizeof(json)));
+    TEST_ASSERT_EQUAL_STRING("{\"id\":0,\"ts\":41500,\"seq\":41,\"size\":61440,\"reason\":\"detección inicial\"}", json);
+    TEST_ASSERT_EQUAL_STRING("detection_started", server_event_json(&batch[3], json, sizeof(json)));
+    TEST_ASSERT_EQUAL_STRING("{\"id\":0,\"ts\":8000,\"detected\":true,\"sensor_state\":0,\"detections\":8}", json);
+    TEST_ASSERT_EQUAL_STRING("detection_ended", server_event_json(&batch[2], json, sizeof(json)));
+    TEST_ASSERT_NULL(server_event_json(&batch[4], json, sizeof(json)));
+
+    // Con la cola llena el productor no espera: descarta y cuenta
+    queue = xQueueCreate(4, sizeof(server_event_t));
+    TEST_ASSERT_NOT_NULL(queue);
+    server_events_reset_stats();
+    for (uint32_t i = 1; i <= 6; i++) {
+        server_event_t event = photo_event(i);
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = server_events_post(queue, &event);
+        TEST_ASSERT_TRUE(esp_timer_get_time() - start < 1000);
+        TEST_ASSERT_EQUAL(i <= 4 ? ESP_OK : ESP_ERR_TIMEOUT, err);
+    }
+
+    // Un vaciado se lleva todo lo pendiente hasta la capacidad del lote
+    server_event_t drained[SERVER_EVENTS_BATCH_MAX];
+    TEST_ASSERT_EQUAL(3, server_events_drain(queue, drained, 3, 0));
+    TEST_ASSERT_EQUAL(1, drained[0].photo_data.seq);
+    TEST_ASSERT_EQUAL(1, server_events_drain(queue, drained, SERVER_EVENTS_BATCH_MAX, 0));
+    TEST_ASSERT_EQUAL(4, drained[0].photo_data.seq);
+    TEST_ASSERT_EQUAL(0, server_events_drain(queue, drained, SERVER_EVENTS_BATCH_MAX, 0));
+
+    server_events_stats_t stats = server_events_get_stats();
+    TEST_ASSERT_EQUAL(4, stats.posted);
+    TEST_ASSERT_EQUAL(2, stats.dropped);
+    TEST_ASSERT_EQUAL(4, stats.processed);
+    TEST_ASSERT_EQUAL(2, stats.batches);
+    TEST_ASSERT_EQUAL(3, stats.max_batch);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, server_events_post(NULL, &batch[0]));
+
+    vQueueDelete(queue);
+    queue = NULL;
+}
+
+static void producer_task(void *arg) {
+    for (uint32_t i = 1; i <= TEST_PRODUCED; i++) {
+        server_event_t event = (i % 3 == 0) ? photo_event(i) : detection_event(i, (i % 3) == 1);
+        if (server_events_post(queue, &event) != ESP_OK) {
+            producer_failed++;
+        }
+        if ((i % 64) == 0) {
+            vTaskDelay(1);
+        }
+    }
+    producer_done = true;
+    vTaskDelete(NULL);
+}
+
+void test_server_events_batch_throughput(void) {
+    ESP_LOGI(TAG, "Testing server event drain throughput, batched vs one at a time");
+
+    server_event_t batch[SERVER_EVENTS_BATCH_MAX];
+    server_state_t state = {0};
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    queue = xQueueCreate(SERVER_EVENT_QUEUE_DEPTH, sizeof(server_event_t));
+    TEST_ASSERT_NOT_NULL(mutex);
+    TEST_ASSERT_NOT_NULL(queue);
+
+    // Cola llena (una ráfaga) vaciada por lotes y de uno en uno, como la tarea anterior
+    const size_t modes[] = { SERVER_EVENTS_BATCH_MAX, 1 };
+    double events_per_s[2];
+    for (int m = 0; m < 2; m++) {
+        uint32_t processed = 0;
+        uint32_t drains = 0;
+        int64_t busy_us = 0;
+        for (int round = 0; round < TEST_ROUNDS; round++) {
+            for (uint32_t i = 0; i < SERVER_EVENT_QUEUE_DEPTH; i++) {
+                server_event_t event = photo_event(i);
+                TEST_ASSERT_EQUAL(ESP_OK, server_events_post(queue, &event));
+            }
+            int64_t start = esp_timer_get_time();
+            size_t count;
+            while ((count = consume(batch, modes[m], &state, mutex)) > 0) {
+                processed += count;
+                drains++;
+            }
+            busy_us += esp_timer_get_time() - start;
+        }
+        TEST_ASSERT_EQUAL(TEST_ROUNDS * SERVER_EVENT_QUEUE_DEPTH, processed);
+        TEST_ASSERT_EQUAL(processed / modes[m], drains);
+        events_per_s[m] = processed * 1e6 / (double)(busy_us > 0 ? busy_us : 1);
+        ESP_LOGI(TAG, "Lote de %u: %.0f eventos/s", (unsigned)modes[m], events_per_s[m]);
+    }
+    ESP_LOGI(TAG, "Ganancia por lotes: x%.2f", events_per_s[0] / events_per_s[1]);
+
+    // Productor en el otro núcleo sin esperar: todo lo encolado se aplica exactamente una vez
+    server_events_reset_stats();
+    producer_done = false;
+    producer_failed = 0;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(producer_task, "ev_producer", 3072, NULL, 5, NULL,
+                                                      portNUM_PROCESSORS - 1));
+    uint32_t processed = 0;
+    while (!producer_done || uxQueueMessagesWaiting(queue) > 0) {
+        size_t count = consume(batch, SERVER_EVENTS_BATCH_MAX, &state, mutex);
+        processed += count;
+        if (count == 0) {
+            vTaskDelay(1);
+        }
+    }
+    server_events_stats_t stats = server_events_get_stats();
+    ESP_LOGI(TAG, "%lu encolados, %lu descartados, %lu lotes (máximo %lu)",
+             stats.posted, stats.dropped, stats.batches, stats.max_batch);
+    TEST_ASSERT_EQUAL(TEST_PRODUCED, stats.posted + stats.dropped);
+    TEST_ASSERT_EQUAL(producer_failed, stats.dropped);
+    TEST_ASSERT_EQUAL(stats.posted, processed);
+
+    vQueueDelete(queue);
+    queue = NULL;
+    vSemaphoreDelete(mutex);
+}
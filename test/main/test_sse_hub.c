@@ -0,0 +1,107 @@
+#include "unity.h"
+#include "sse_hub.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "TEST_SSE_HUB";
+
+static sse_hub_t hub;
+
+void test_sse_hub_fanout(void) {
+    ESP_LOGI(TAG, "Testing event fan-out to every client in order");
+
+    sse_hub_config_t config = SSE_HUB_DEFAULT_CONFIG();
+    config.max_clients = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sse_hub_init(&hub, &config));
+    config.max_clients = SSE_HUB_MAX_CLIENTS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sse_hub_init(&hub, &config));
+    config.max_clients = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, sse_hub_init(&hub, &config));
+
+    // Sin clientes el evento se serializa igual y consume id
+    TEST_ASSERT_EQUAL(1, sse_hub_publish(&hub, "photo_taken", "{\"size\":1}", 100));
+
+    sse_client_t *a = sse_hub_claim(&hub);
+    sse_client_t *b = sse_hub_claim(&hub);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NULL(sse_hub_claim(&hub));
+    TEST_ASSERT_EQUAL(1, hub.rejected);
+
+    TEST_ASSERT_EQUAL(2, sse_hub_publish(&hub, "detection_started", "{\"detections\":7}", 200));
+    TEST_ASSERT_EQUAL(3, sse_hub_publish(&hub, "detection_ended", "{\"detected\":false}", 300));
+
+    // Ambos clientes reciben los dos eventos, en orden y con formato SSE
+    sse_client_t *clients[] = { a, b };
+    for (int i = 0; i < 2; i++) {
+        sse_entry_t entry;
+        TEST_ASSERT_TRUE(sse_client_pop(clients[i], &entry));
+        TEST_ASSERT_EQUAL_STRING("id: 2\nevent: detection_started\ndata: {\"detections\":7}\n\n", entry.text);
+        TEST_ASSERT_EQUAL(strlen(entry.text), entry.len);
+        TEST_ASSERT_EQUAL_UINT32(200, (uint32_t)entry.timestamp);
+        sse_client_account(clients[i], 1500);
+        TEST_ASSERT_TRUE(sse_client_pop(clients[i], &entry));
+        TEST_ASSERT_NOT_NULL(strstr(entry.text, "event: detection_ended\n"));
+        sse_client_account(clients[i], 800);
+        TEST_ASSERT_FALSE(sse_client_pop(clients[i], &entry));
+    }
+    TEST_ASSERT_EQUAL(2, a->stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(800, a->stats.last_latency_us);
+    TEST_ASSERT_EQUAL_UINT32(1500, a->stats.max_latency_us);
+
+    // Un cliente que se va no recibe más y su hueco queda libre con la cola vacía
+    sse_hub_release(&hub, a);
+    sse_hub_publish(&hub, "photo_taken", "{\"size\":2}", 400);
+    TEST_ASSERT_EQUAL(1, b->count);
+    sse_client_t *c = sse_hub_claim(&hub);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL(0, c->count);
+    TEST_ASSERT_EQUAL(3, c->id);
+
+    // Evento demasiado largo: se rechaza sin consumir id
+    char big[SSE_EVENT_MAX_LEN];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    TEST_ASSERT_EQUAL(0, sse_hub_publish(&hub, "photo_taken", big, 500));
+    TEST_ASSERT_EQUAL(1, hub.oversized);
+    TEST_ASSERT_EQUAL(4, hub.published);
+}
+
+void test_sse_hub_slow_client(void) {
+    ESP_LOGI(TAG, "Testing bounded backlog and drop accounting for a slow client");
+
+    sse_hub_config_t config = SSE_HUB_DEFAULT_CONFIG();
+    TEST_ASSERT_EQUAL(ESP_OK, sse_hub_init(&hub, &config));
+    sse_client_t *fast = sse_hub_claim(&hub);
+    sse_client_t *slow = sse_hub_claim(&hub);
+    sse_entry_t entry;
+
+    // El rápido vacía su cola tras cada evento; el lento no lee nada
+    for (int i = 1; i <= SSE_HUB_BACKLOG + 5; i++) {
+        char data[32];
+        snprintf(data, sizeof(data), "{\"n\":%d}", i);
+        sse_hub_publish(&hub, "detection_started", data, i);
+        TEST_ASSERT_TRUE(sse_client_pop(fast, &entry));
+        sse_client_account(fast, 10);
+    }
+    TEST_ASSERT_EQUAL(SSE_HUB_BACKLOG + 5, fast->stats.sent);
+    TEST_ASSERT_EQUAL(0, fast->stats.dropped);
+
+    // El lento conserva los SSE_HUB_BACKLOG más recientes y cuenta el resto
+    TEST_ASSERT_EQUAL(SSE_HUB_BACKLOG, slow->count);
+    TEST_ASSERT_EQUAL(5, slow->stats.dropped);
+    TEST_ASSERT_TRUE(sse_client_pop(slow, &entry));
+    TEST_ASSERT_NOT_NULL(strstr(entry.text, "id: 6\n"));
+    unsigned long last_id = 0;
+    while (sse_client_pop(slow, &entry)) {
+        sscanf(entry.text, "id: %lu", &last_id);
+    }
+    TEST_ASSERT_EQUAL(SSE_HUB_BACKLOG + 5, (int)last_id);
+
+    char json[512];
+    int len = sse_hub_stats_json(&hub, json, sizeof(json));
+    ESP_LOGI(TAG, "%s", json);
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(json));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"id\":2,\"sent\":0,\"dropped\":5,\"backlog\":0"));
+}
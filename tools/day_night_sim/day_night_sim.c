@@ -0,0 +1,142 @@
+// day_night_sim.c - Reproducción de host del planificador día/noche sobre una traza de luminancia
+//
+// Uso: day_night_sim [opciones] traza.csv
+//   -a lat       Latitud en grados (norte positivo); con -o activa la hora solar
+//   -o lon       Longitud en grados (este positivo)
+//   -n luma      Umbral para pasar a noche (night_below)
+//   -d luma      Umbral para pasar a día (day_above)
+//   -b luma      Sesgo solar de los umbrales
+//   -c s         Tiempo de confirmación
+//   -w s         Permanencia mínima en un modo
+//   -z h         Desfase horario para mostrar horas locales (por defecto 0 = UTC)
+//   -v           Traza por evaluación
+//
+// La traza tiene una muestra por línea: epoch_s,luma (las líneas con # se ignoran).
+// Entre muestras se evalúa cada eval_interval_s, como la tarea del firmware.
+#include "day_night.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int zone_hours = 0;
+
+static const char *format_time(int64_t epoch, char *buf, size_t len) {
+    time_t t = (time_t)(epoch + zone_hours * 3600);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, len, "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+static void evaluate(day_night_t *dn, int64_t now, bool verbose) {
+    day_night_decision_t decision;
+    char when[32];
+    char event[48];
+
+    if (day_night_evaluate(dn, now, &decision)) {
+        const char *label = "";
+        int64_t nearest = 0;
+        if (decision.sunrise != 0) {
+            int64_t to_rise = now - decision.sunrise;
+            int64_t to_set = now - decision.sunset;
+            nearest = llabs(to_rise) < llabs(to_set) ? to_rise : to_set;
+            label = llabs(to_rise) < llabs(to_set) ? "amanecer" : "atardecer";
+        }
+        printf("%s  -> %-6s causa=%-10s fase=%-11s luma=%5.1f", format_time(now, when, sizeof(when)),
+               day_night_mode_name(decision.mode), day_night_cause_name(decision.cause),
+               day_night_phase_name(decision.phase), decision.luma);
+        if (decision.sunrise != 0) {
+            snprintf(event, sizeof(event), "%+lld min del %s", (long long)(nearest / 60), label);
+            printf("  (%s)", event);
+        }
+        printf("\n");
+    } else if (verbose) {
+        printf("%s     %-6s fase=%-11s luma=%5.1f\n", format_time(now, when, sizeof(when)),
+               day_night_mode_name(decision.mode), day_night_phase_name(decision.phase), decision.luma);
+    }
+}
+
+int main(int argc, char **argv) {
+    day_night_config_t config = DAY_NIGHT_DEFAULT_CONFIG();
+    bool verbose = false;
+    bool have_lat = false;
+    bool have_lon = false;
+    int opt = 1;
+
+    for (; opt < argc && argv[opt][0] == '-' && argv[opt][1] != '\0' && argv[opt][2] == '\0'; opt++) {
+        char flag = argv[opt][1];
+        if (flag == 'v') {
+            verbose = true;
+            continue;
+        }
+        if (opt + 1 >= argc) {
+            break;
+        }
+        const char *value = argv[++opt];
+        switch (flag) {
+            case 'a': config.latitude = atof(value); have_lat = true; break;
+            case 'o': config.longitude = atof(value); have_lon = true; break;
+            case 'n': config.night_below = atoi(value); break;
+            case 'd': config.day_above = atoi(value); break;
+            case 'b': config.solar_bias = atoi(value); break;
+            case 'c': config.confirm_s = atoi(value); break;
+            case 'w': config.min_dwell_s = atoi(value); break;
+            case 'z': zone_hours = atoi(value); break;
+            default: opt = argc; break;
+        }
+    }
+    if (opt != argc - 1) {
+        fprintf(stderr, "Uso: %s [-a lat -o lon] [-n luma] [-d luma] [-b luma] [-c s] [-w s] [-z h] [-v] traza.csv\n",
+                argv[0]);
+        return 2;
+    }
+    config.use_solar = have_lat && have_lon;
+
+    day_night_t dn;
+    if (day_night_init(&dn, &config) != ESP_OK) {
+        fprintf(stderr, "Configuración inválida\n");
+        return 1;
+    }
+
+    FILE *f = fopen(argv[opt], "r");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", argv[opt]);
+        return 1;
+    }
+
+    char line[128];
+    int64_t next_eval = 0;
+    int64_t first = 0;
+    int64_t last = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        long long epoch = 0;
+        float luma = 0;
+        if (sscanf(line, "%lld,%f", &epoch, &luma) != 2) {
+            continue;
+        }
+        if (first == 0) {
+            first = epoch;
+            next_eval = epoch;
+        }
+        while (next_eval < epoch) {
+            evaluate(&dn, next_eval, verbose);
+            next_eval += config.eval_interval_s;
+        }
+        day_night_add_luma(&dn, epoch, luma);
+        last = epoch;
+    }
+    fclose(f);
+    evaluate(&dn, last, verbose);
+
+    printf("\n%lld h de traza, %lu muestras, %lu evaluaciones: %lu cambios (%lu por luminancia, "
+           "%lu por hora solar), %lu retenidos por permanencia mínima\n",
+           (long long)(last - first) / 3600, (unsigned long)dn.stats.samples,
+           (unsigned long)dn.stats.evaluations, (unsigned long)dn.stats.switches,
+           (unsigned long)dn.stats.luma_switches, (unsigned long)dn.stats.solar_switches,
+           (unsigned long)dn.stats.dwell_blocked);
+    return 0;
+}
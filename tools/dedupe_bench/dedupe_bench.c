@@ -0,0 +1,254 @@
+// dedupe_bench.c - Benchmark de host del hash perceptual y la deduplicación de fotos periódicas
+//
+// Uso: dedupe_bench [opciones] secuencia/ [secuencia/ ...]
+//   -t bits      Umbral de Hamming (por defecto el de FRAME_DEDUPE_DEFAULT_CONFIG)
+//   -g s         Conservar al menos un frame cada s segundos (0 = nunca)
+//   -i ms        Intervalo entre fotos periódicas (por defecto 2000, como sensorE18)
+//   -n iter      Repeticiones para medir tiempos (mediana)
+//   -v           Distancia y decisión por frame
+//
+// Cada secuencia es un directorio con JPEGs que se reproducen en orden alfabético,
+// como fotos periódicas consecutivas.
+#include "jpeg_dc.h"
+#include "frame_dedupe.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FRAMES  1024
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    char name[64];
+} frame_file_t;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static int compare_name(const void *a, const void *b) {
+    return strcmp(((const frame_file_t *)a)->name, ((const frame_file_t *)b)->name);
+}
+
+// Nombre del directorio sin la ruta ni la barra final
+static void sequence_label(const char *dir, char *label, size_t size) {
+    snprintf(label, size, "%s", dir);
+    size_t n = strlen(label);
+    while (n > 1 && label[n - 1] == '/') {
+        label[--n] = '\0';
+    }
+    const char *slash = strrchr(label, '/');
+    if (slash != NULL) {
+        memmove(label, slash + 1, strlen(slash + 1) + 1);
+    }
+}
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    if (data && fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return data;
+}
+
+static size_t load_sequence(const char *dir, frame_file_t *frames, size_t max) {
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        return 0;
+    }
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && count < max) {
+        size_t n = strlen(entry->d_name);
+        if (n < 5 || n >= sizeof(frames[0].name) || strcmp(entry->d_name + n - 4, ".jpg") != 0) {
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        frames[count].data = read_file(path, &frames[count].len);
+        if (frames[count].data != NULL) {
+            strcpy(frames[count].name, entry->d_name);
+            count++;
+        }
+    }
+    closedir(d);
+    qsort(frames, count, sizeof(frames[0]), compare_name);
+    return count;
+}
+
+// Mapa DC + hash de un frame; devuelve la mediana de iterations repeticiones
+static int hash_frame(const frame_file_t *frame, int iterations, frame_hash_t *hash,
+                      double *decode_us, double *hash_us) {
+    jpeg_dc_info_t info;
+    if (jpeg_dc_get_info(frame->data, frame->len, &info) != ESP_OK) {
+        return -1;
+    }
+    size_t map_size = (size_t)info.map_width * info.map_height;
+    uint8_t *map = malloc(map_size);
+    double *decode = malloc(sizeof(double) * iterations);
+    double *only_hash = malloc(sizeof(double) * iterations);
+    int ret = -1;
+
+    if (map && decode && only_hash) {
+        ret = 0;
+        for (int i = 0; i < iterations && ret == 0; i++) {
+            double t0 = now_us();
+            if (jpeg_dc_luma_map(frame->data, frame->len, map, map_size, &info) != ESP_OK) {
+                ret = -1;
+                break;
+            }
+            double t1 = now_us();
+            frame_hash_map(map, info.map_width, info.map_height, hash);
+            double t2 = now_us();
+            decode[i] = t1 - t0;
+            only_hash[i] = t2 - t1;
+        }
+        if (ret == 0) {
+            qsort(decode, iterations, sizeof(double), compare_double);
+            qsort(only_hash, iterations, sizeof(double), compare_double);
+            *decode_us = decode[iterations / 2];
+            *hash_us = only_hash[iterations / 2];
+        }
+    }
+    free(map);
+    free(decode);
+    free(only_hash);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    frame_dedupe_config_t config = FRAME_DEDUPE_DEFAULT_CONFIG();
+    uint32_t interval_ms = 2000;
+    int iterations = 20;
+    int verbose = 0;
+    int opt = 1;
+
+    for (; opt < argc && argv[opt][0] == '-' && argv[opt][1] != '\0' && argv[opt][2] == '\0'; opt++) {
+        char flag = argv[opt][1];
+        if (flag == 'v') {
+            verbose = 1;
+            continue;
+        }
+        if (opt + 1 >= argc) {
+            break;
+        }
+        const char *value = argv[++opt];
+        switch (flag) {
+            case 't': config.threshold = (uint8_t)atoi(value); break;
+            case 'g': config.max_gap_ms = (uint32_t)atoi(value) * 1000; break;
+            case 'i': interval_ms = (uint32_t)atoi(value); break;
+            case 'n': iterations = atoi(value) > 0 ? atoi(value) : 1; break;
+            default: opt = argc + 1; break;
+        }
+    }
+    if (opt >= argc) {
+        fprintf(stderr, "Uso: %s [-t bits] [-g s] [-i ms] [-n iter] [-v] secuencia/ [secuencia/ ...]\n", argv[0]);
+        return 2;
+    }
+
+    static frame_file_t frames[MAX_FRAMES];
+    uint32_t total_frames = 0, total_kept = 0;
+    uint64_t total_bytes = 0, total_saved = 0;
+    double total_decode = 0, total_hash = 0;
+
+    printf("Umbral %u bits, máximo %lu s entre frames conservados, fotos cada %lu ms\n\n",
+           config.threshold, (unsigned long)(config.max_gap_ms / 1000), (unsigned long)interval_ms);
+    printf("%-24s %6s %6s %6s %8s %10s %10s %10s\n", "secuencia", "frames", "cons.", "dup.",
+           "ahorro", "DC+hash", "solo hash", "frames/s");
+
+    for (int s = opt; s < argc; s++) {
+        char label[64];
+        sequence_label(argv[s], label, sizeof(label));
+        size_t count = load_sequence(argv[s], frames, MAX_FRAMES);
+        if (count == 0) {
+            printf("%-24s (sin JPEGs)\n", label);
+            continue;
+        }
+
+        frame_dedupe_t dedupe;
+        if (frame_dedupe_init(&dedupe, &config) != ESP_OK) {
+            fprintf(stderr, "Configuración inválida\n");
+            return 1;
+        }
+
+        uint64_t bytes = 0;
+        double decode_sum = 0, hash_sum = 0;
+        uint32_t valid = 0;
+        for (size_t i = 0; i < count; i++) {
+            frame_hash_t hash = {0};
+            double decode_us, hash_us;
+            if (hash_frame(&frames[i], iterations, &hash, &decode_us, &hash_us) != 0) {
+                printf("  %s: no es un JPEG baseline válido, omitido\n", frames[i].name);
+                continue;
+            }
+            valid++;
+            decode_sum += decode_us;
+            hash_sum += hash_us;
+            bytes += frames[i].len;
+
+            uint8_t distance;
+            uint64_t timestamp = (uint64_t)i * interval_ms * 1000;
+            bool duplicate = frame_dedupe_check(&dedupe, &hash, timestamp, frames[i].len, &distance);
+            if (verbose) {
+                if (distance == FRAME_HASH_NONE) {
+                    printf("  %s  %016llx%016llx  distancia  -  conservado\n", frames[i].name,
+                           (unsigned long long)hash.brighter, (unsigned long long)hash.darker);
+                } else {
+                    printf("  %s  %016llx%016llx  distancia %2u  %s\n", frames[i].name,
+                           (unsigned long long)hash.brighter, (unsigned long long)hash.darker,
+                           distance, duplicate ? "duplicado" : "conservado");
+                }
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            free(frames[i].data);
+        }
+        if (valid == 0) {
+            continue;
+        }
+
+        const frame_dedupe_stats_t *st = &dedupe.stats;
+        double decode_avg = decode_sum / valid;
+        double hash_avg = hash_sum / valid;
+        printf("%-24s %6lu %6lu %6lu %7.1f%% %8.0f us %8.2f us %10.0f\n", label,
+               (unsigned long)valid, (unsigned long)st->kept, (unsigned long)st->duplicates,
+               bytes ? 100.0 * st->bytes_saved / bytes : 0.0, decode_avg + hash_avg, hash_avg,
+               1e6 / (decode_avg + hash_avg));
+
+        total_frames += valid;
+        total_kept += st->kept;
+        total_bytes += bytes;
+        total_saved += st->bytes_saved;
+        total_decode += decode_sum;
+        total_hash += hash_sum;
+    }
+
+    if (total_frames > 0) {
+        printf("\nTotal: %lu frames, %lu conservados (1 de cada %.1f), %.1f%% de bytes evitados, "
+               "%.0f frames/s de DC+hash\n", (unsigned long)total_frames, (unsigned long)total_kept,
+               total_kept ? (double)total_frames / total_kept : 0.0,
+               total_bytes ? 100.0 * total_saved / total_bytes : 0.0,
+               1e6 * total_frames / (total_decode + total_hash));
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// e18_debounce_sim.c - Reproducción de host del antirrebote del E18-D80NK sobre una traza de flancos
+//
+// Uso: e18_debounce_sim [opciones] traza.csv
+//   -d ms        Antirrebote (debounce_ms)
+//   -c ms        Confirmación (confirm_ms)
+//   -l nivel     Nivel del pin al arrancar (0 = objeto, 1 = sin objeto; por defecto 1)
+//   -v           Una línea por flanco
+//
+// La traza tiene un flanco por línea: t_ms,nivel (las líneas con # se ignoran; t_ms admite
+// decimales, resolución de microsegundos). Antes de cada flanco se resuelven los plazos
+// hasta su marca, como la tarea de detección del firmware cuando vence su timer.
+#include "e18_debounce.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MS  1000LL
+
+// Latencia desde el flanco que inició la presencia hasta la confirmación
+typedef struct {
+    uint32_t count;
+    int64_t min_us;
+    int64_t max_us;
+    int64_t sum_us;
+} latency_t;
+
+static void print_time(int64_t us) {
+    printf("%10.3f s", us / 1e6);
+}
+
+// Resuelve los plazos hasta now e imprime cada evento
+static void advance_to(e18_debounce_t *state, int64_t now, latency_t *latency) {
+    e18_debounce_event_t event;
+    int64_t at;
+    while ((event = e18_debounce_advance(state, now, &at)) != E18_DEBOUNCE_NONE) {
+        print_time(at);
+        if (event == E18_DEBOUNCE_ONSET) {
+            printf("  %s\n", e18_debounce_event_name(event));
+            continue;
+        }
+        printf("  %-12s", e18_debounce_event_name(event));
+        if (event == E18_DEBOUNCE_CONFIRMED) {
+            int64_t delay = at - state->onset;
+            if (latency->count == 0 || delay < latency->min_us) {
+                latency->min_us = delay;
+            }
+            if (delay > latency->max_us) {
+                latency->max_us = delay;
+            }
+            latency->sum_us += delay;
+            latency->count++;
+            printf("  latencia=%lld ms desde el flanco", (long long)(delay / MS));
+        } else {
+            printf("  presencia=%lld ms", (long long)((at - state->onset) / MS));
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    e18_debounce_config_t config = E18_DEBOUNCE_DEFAULT_CONFIG();
+    uint8_t initial_level = E18_LEVEL_CLEAR;
+    bool verbose = false;
+    int opt = 1;
+
+    for (; opt < argc && argv[opt][0] == '-' && argv[opt][1] != '\0' && argv[opt][2] == '\0'; opt++) {
+        char flag = argv[opt][1];
+        if (flag == 'v') {
+            verbose = true;
+            continue;
+        }
+        if (opt + 1 >= argc) {
+            break;
+        }
+        const char *value = argv[++opt];
+        switch (flag) {
+            case 'd': config.debounce_ms = (uint32_t)atoi(value); break;
+            case 'c': config.confirm_ms = (uint32_t)atoi(value); break;
+            case 'l': initial_level = (uint8_t)atoi(value); break;
+            default: opt = argc; break;
+        }
+    }
+    if (opt != argc - 1) {
+        fprintf(stderr, "Uso: %s [-d ms] [-c ms] [-l nivel] [-v] traza.csv\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[opt], "r");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", argv[opt]);
+        return 1;
+    }
+
+    e18_debounce_t state;
+    if (e18_debounce_init(&state, &config, initial_level, 0) != ESP_OK) {
+        fprintf(stderr, "Configuración inválida\n");
+        fclose(f);
+        return 1;
+    }
+
+    latency_t latency = { 0 };
+    char line[128];
+    int64_t last = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        double t_ms = 0;
+        int level = 0;
+        if (sscanf(line, "%lf,%d", &t_ms, &level) != 2) {
+            continue;
+        }
+        e18_edge_t edge = {
+            .timestamp = (int64_t)(t_ms * MS + 0.5),
+            .level = (uint8_t)level,
+        };
+        advance_to(&state, edge.timestamp, &latency);
+        if (verbose) {
+            print_time(edge.timestamp);
+            printf("    flanco %s\n", edge.level == E18_LEVEL_OBJECT ? "objeto" : "libre");
+        }
+        e18_debounce_edge(&state, &edge);
+        last = edge.timestamp;
+    }
+    fclose(f);
+
+    // Tras el último flanco solo quedan plazos: se resuelven todos
+    int64_t deadline;
+    while ((deadline = e18_debounce_next_deadline(&state)) != 0) {
+        advance_to(&state, deadline, &latency);
+    }
+    if (state.now > last) {
+        last = state.now;
+    }
+
+    const e18_debounce_stats_t *stats = &state.stats;
+    printf("\n%.1f s de traza, %lu flancos (%lu rebotes, %lu fuera de orden): %lu objetos, "
+           "%lu confirmadas, %lu falsas alarmas, %lu retirados\n",
+           last / 1e6, (unsigned long)stats->edges, (unsigned long)stats->glitches,
+           (unsigned long)stats->late_edges, (unsigned long)stats->onsets,
+           (unsigned long)stats->confirmed, (unsigned long)stats->false_alarms,
+           (unsigned long)stats->released);
+    if (latency.count > 0) {
+        printf("Latencia de confirmación: min %lld ms, media %lld ms, max %lld ms (debounce_ms + confirm_ms = %lu)\n",
+               (long long)(latency.min_us / MS), (long long)(latency.sum_us / latency.count / MS),
+               (long long)(latency.max_us / MS), (unsigned long)(config.debounce_ms + config.confirm_ms));
+    }
+    return 0;
+}
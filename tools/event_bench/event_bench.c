@@ -0,0 +1,312 @@
+// event_bench.c - Rendimiento de host (eventos/s) de la cola de eventos del servidor web
+//
+// Uso: event_bench [opciones]
+//   -p n     Hilos productores (por defecto 2: sensor y cámara)
+//   -n n     Eventos por productor (por defecto 500000)
+//   -b n     Eventos por vaciado de la cola (por defecto SERVER_EVENTS_BATCH_MAX; 1 = de uno en uno)
+//   -t ms    Espera de los productores con la cola llena (por defecto 0; 100 = envío bloqueante anterior)
+//   -k n     Eventos por ráfaga de cada productor (por defecto 8)
+//   -g us    Pausa entre ráfagas (por defecto 0: saturación)
+//   -c n     Clientes de /events despertados tras cada publicación (por defecto 3)
+//   -j n     Capacidad del diario de /events/history (por defecto 512; 0 = sin diario)
+//
+// El consumidor hace lo mismo que event_processing_task(): vaciar la cola, aplicar el lote
+// sobre una copia del estado, publicarla con el seqlock y serializar cada evento con el
+// registro de /events tomado una vez por lote, y despertar a los hilos de los clientes de
+// /events (que, como events_client_task(), toman el registro para leer). Primero mide su capacidad en un solo hilo
+// (cola llena vaciada por lotes y de uno en uno) y después la prueba con productores
+// concurrentes. Termina con código 1 si algún evento encolado no se aplicó exactamente
+// una vez o si el diario no anotó todos los enviados, también los descartados.
+#include "server_events.h"
+#include "event_journal.h"
+#include "seqlock.h"
+#include "capture_queue.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PRODUCERS   8
+#define MAX_CLIENTS     4       // SSE_HUB_MAX_CLIENTS
+#define CAPACITY_ROUNDS 20000   // Colas llenas vaciadas en la medida de capacidad
+
+// Resultado de cada productor
+typedef struct {
+    int id;
+    uint64_t posted;
+    uint64_t dropped;
+    uint64_t max_stall_ns;        // Mayor tiempo dentro de una llamada de envío
+} producer_result_t;
+
+static QueueHandle_t queue = NULL;
+static server_state_t server_state = {0};
+static seqlock_t state_lock = SEQLOCK_INIT();
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t events_cond = PTHREAD_COND_INITIALIZER;
+static uint64_t published = 0;            // Publicaciones (protegido por events_mutex)
+static int clients_stop = 0;
+static long events_per_producer = 500000;
+static int batch_max = SERVER_EVENTS_BATCH_MAX;
+static int send_timeout_ms = 0;
+static int burst = 8;
+static int gap_us = 0;
+static volatile int producers_running = 0;
+static uint64_t client_wakeups = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Mezcla de la tarea del sensor y de la cámara: detección, foto, fin de detección
+static server_event_t make_event(int producer, uint32_t n) {
+    server_event_t event = {
+        .timestamp = now_ns() / 1000,
+        .sensor_state = -1
+    };
+    switch (n % 3) {
+        case 0:
+            event.type = SERVER_EVENT_DETECTION_STARTED;
+            event.object_detected = true;
+            event.sensor_state = 0;
+            event.detection_data.detection_count = n;
+            break;
+        case 1:
+            event.type = SERVER_EVENT_PHOTO_TAKEN;
+            event.reason = CAMERA_CAPTURE_REASON_DETECTION;
+            event.photo_data.seq = n;
+            event.photo_data.photo_size = 60000 + producer;
+            break;
+        default:
+            event.type = SERVER_EVENT_DETECTION_ENDED;
+            event.sensor_state = 1;
+            event.detection_data.detection_count = n;
+            break;
+    }
+    return event;
+}
+
+static void *producer_thread(void *arg) {
+    producer_result_t *result = arg;
+
+    for (long n = 0; n < events_per_producer; n++) {
+        server_event_t event = make_event(result->id, (uint32_t)n);
+        uint64_t start = now_ns();
+        int ok;
+        if (send_timeout_ms == 0) {
+            ok = server_events_post(queue, &event) == ESP_OK;
+        } else {
+            ok = xQueueSend(queue, &event, pdMS_TO_TICKS(send_timeout_ms)) == pdTRUE;
+        }
+        uint64_t stall = now_ns() - start;
+        if (stall > result->max_stall_ns) {
+            result->max_stall_ns = stall;
+        }
+        if (ok) {
+            result->posted++;
+        } else {
+            result->dropped++;
+        }
+        if (gap_us > 0 && (n % burst) == burst - 1) {
+            usleep(gap_us);
+        }
+    }
+
+    __atomic_fetch_sub(&producers_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Cliente de /events: duerme hasta que se publica algo y lo lee con el registro tomado
+static void *client_thread(void *arg) {
+    uint64_t seen = 0;
+    (void)arg;
+
+    pthread_mutex_lock(&events_mutex);
+    while (!clients_stop) {
+        while (published == seen && !clients_stop) {
+            pthread_cond_wait(&events_cond, &events_mutex);
+        }
+        seen = published;
+        client_wakeups++;
+    }
+    pthread_mutex_unlock(&events_mutex);
+    return NULL;
+}
+
+// Un vaciado completo de la tarea del servidor; devuelve los eventos aplicados
+static size_t consume_batch(server_event_t *batch, size_t max, TickType_t wait) {
+    char data[160];
+    size_t count = server_events_drain(queue, batch, max, wait);
+
+    if (count > 0) {
+        server_state_t next = server_state;
+        server_events_apply(&next, batch, count);
+        seqlock_write(&state_lock, &server_state, &next, sizeof(next));
+
+        pthread_mutex_lock(&events_mutex);
+        for (size_t i = 0; i < count; i++) {
+            server_event_json(&batch[i], data, sizeof(data));
+        }
+        published++;
+        pthread_cond_broadcast(&events_cond);
+        pthread_mutex_unlock(&events_mutex);
+    }
+    return count;
+}
+
+static uint64_t consume_all(void) {
+    server_event_t batch[SERVER_EVENTS_BATCH_MAX];
+    uint64_t processed = 0;
+
+    for (;;) {
+        int running = __atomic_load_n(&producers_running, __ATOMIC_ACQUIRE);
+        size_t count = consume_batch(batch, batch_max, pdMS_TO_TICKS(1));
+        if (count == 0 && running == 0) {
+            return processed;
+        }
+        processed += count;
+    }
+}
+
+// Capacidad del consumidor: se llena la cola (una ráfaga) y se mide solo el vaciado
+static double measure_capacity(size_t max) {
+    server_event_t batch[SERVER_EVENTS_BATCH_MAX];
+    uint64_t busy_ns = 0;
+    uint64_t processed = 0;
+
+    for (int round = 0; round < CAPACITY_ROUNDS; round++) {
+        for (uint32_t n = 0; n < SERVER_EVENT_QUEUE_DEPTH; n++) {
+            server_event_t event = make_event(0, n);
+            server_events_post(queue, &event);
+        }
+        uint64_t start = now_ns();
+        size_t count;
+        while ((count = consume_batch(batch, max, 0)) > 0) {
+            processed += count;
+        }
+        busy_ns += now_ns() - start;
+    }
+    return processed * 1e9 / (double)busy_ns;
+}
+
+int main(int argc, char **argv) {
+    int producers = 2;
+    int clients = 3;
+    long journal_capacity = 512;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:n:b:t:k:g:c:j:")) != -1) {
+        switch (opt) {
+            case 'p': producers = atoi(optarg); break;
+            case 'n': events_per_producer = atol(optarg); break;
+            case 'b': batch_max = atoi(optarg); break;
+            case 't': send_timeout_ms = atoi(optarg); break;
+            case 'k': burst = atoi(optarg); break;
+            case 'g': gap_us = atoi(optarg); break;
+            case 'c': clients = atoi(optarg); break;
+            case 'j': journal_capacity = atol(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-p productores] [-n eventos] [-b lote] [-t espera_ms] "
+                        "[-k ráfaga] [-g pausa_us] [-c clientes] [-j diario]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (producers < 1 || producers > MAX_PRODUCERS || events_per_producer < 1 ||
+        batch_max < 1 || batch_max > SERVER_EVENTS_BATCH_MAX || send_timeout_ms < 0 ||
+        burst < 1 || gap_us < 0 || clients < 0 || clients > MAX_CLIENTS || journal_capacity < 0) {
+        fprintf(stderr, "Configuración inválida (1-%d productores, lote 1-%d, 0-%d clientes)\n",
+                MAX_PRODUCERS, SERVER_EVENTS_BATCH_MAX, MAX_CLIENTS);
+        return 1;
+    }
+
+    printf("event_bench: %d productores x %ld eventos, lote %d, cola %d, espera %d ms, "
+           "ráfaga %d, pausa %d us, %d clientes, diario %ld, registro %zu bytes\n",
+           producers, events_per_producer, batch_max, SERVER_EVENT_QUEUE_DEPTH, send_timeout_ms,
+           burst, gap_us, clients, journal_capacity, sizeof(server_event_t));
+    fflush(stdout);
+
+    event_journal_config_t journal_config = { .capacity = (size_t)journal_capacity };
+    if (event_journal_init(&journal_config) != ESP_OK) {
+        fprintf(stderr, "Error reservando el diario\n");
+        return 1;
+    }
+
+    queue = xQueueCreate(SERVER_EVENT_QUEUE_DEPTH, sizeof(server_event_t));
+    if (queue == NULL) {
+        fprintf(stderr, "Error creando la cola\n");
+        return 1;
+    }
+
+    pthread_t client_tids[MAX_CLIENTS];
+    for (int i = 0; i < clients; i++) {
+        pthread_create(&client_tids[i], NULL, client_thread, NULL);
+    }
+
+    double batched = measure_capacity(batch_max);
+    double single = measure_capacity(1);
+    printf("capacidad: %.2f M eventos/s con lotes de %d, %.2f M eventos/s de uno en uno (x%.2f)\n",
+           batched / 1e6, batch_max, single / 1e6, batched / single);
+    server_events_reset_stats();
+    pthread_mutex_lock(&events_mutex);
+    client_wakeups = 0;
+    pthread_mutex_unlock(&events_mutex);
+
+    uint32_t journal_before = event_journal_get_stats().appended;
+    pthread_t tids[MAX_PRODUCERS];
+    producer_result_t results[MAX_PRODUCERS];
+    memset(results, 0, sizeof(results));
+
+    uint64_t start = now_ns();
+    producers_running = producers;
+    for (int i = 0; i < producers; i++) {
+        results[i].id = i;
+        pthread_create(&tids[i], NULL, producer_thread, &results[i]);
+    }
+    uint64_t processed = consume_all();
+    for (int i = 0; i < producers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    producer_result_t total = {0};
+    for (int i = 0; i < producers; i++) {
+        total.posted += results[i].posted;
+        total.dropped += results[i].dropped;
+        if (results[i].max_stall_ns > total.max_stall_ns) {
+            total.max_stall_ns = results[i].max_stall_ns;
+        }
+    }
+    server_events_stats_t stats = server_events_get_stats();
+    uint64_t sent = total.posted + total.dropped;
+
+    printf("%.2f s: %.2f M eventos/s aplicados, %.1f%% descartados, lote medio %.1f (máximo %lu)\n",
+           elapsed, processed / elapsed / 1e6, 100.0 * total.dropped / sent,
+           stats.batches ? (double)stats.processed / stats.batches : 0.0, (unsigned long)stats.max_batch);
+    pthread_mutex_lock(&events_mutex);
+    printf("productores: espera máxima en el envío %.1f us; %llu despertares de clientes\n",
+           total.max_stall_ns / 1e3, (unsigned long long)client_wakeups);
+    clients_stop = 1;
+    pthread_cond_broadcast(&events_cond);
+    pthread_mutex_unlock(&events_mutex);
+    for (int i = 0; i < clients; i++) {
+        pthread_join(client_tids[i], NULL);
+    }
+
+    // Con -t los productores envían directamente a la cola, sin pasar por el diario
+    event_journal_stats_t journal = event_journal_get_stats();
+    uint64_t journaled = journal.appended - journal_before;
+    uint64_t expected = (journal_capacity > 0 && send_timeout_ms == 0) ? sent : 0;
+    printf("diario: %llu anotados, %lu retenidos (ids %lu-%lu), %lu sobrescritos\n",
+           (unsigned long long)journaled, (unsigned long)journal.count,
+           (unsigned long)journal.oldest_id, (unsigned long)journal.latest_id,
+           (unsigned long)journal.overwritten);
+
+    int failed = processed != total.posted || journaled != expected;
+    printf("%s\n", failed ? "FALLO" : "OK");
+    event_journal_deinit();
+    vQueueDelete(queue);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+// esp_heap_caps.h - Sustituto mínimo para el host: las reservas con capacidades van a calloc
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+
+#define heap_caps_calloc(n, size, caps)  calloc((n), (size))
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,10 @@
+// esp_log.h - Sustituto mínimo para el host: los logs de los componentes se descartan
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#define ESP_LOGE(tag, ...)  do { (void)(tag); } while (0)
+#define ESP_LOGW(tag, ...)  do { (void)(tag); } while (0)
+#define ESP_LOGI(tag, ...)  do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, ...)  do { (void)(tag); } while (0)
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,174 @@
+// frame_bench.c - Benchmark de host: mapa DC de luminancia, puntuación de ráfagas y miniaturas
+//
+// Uso: frame_bench [-n iteraciones] archivo.jpg [archivo.jpg ...]
+// Mide el tiempo de jpeg_dc_luma_map_ac() + frame_analysis_score_map_ac() y de
+// jpeg_thumb_encode() por archivo, y ordena los archivos por puntuación, como
+// haría la ráfaga de cam_reader.
+#include "jpeg_dc.h"
+#include "jpeg_thumb.h"
+#include "frame_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    const char *path;
+    uint8_t *data;
+    size_t len;
+    jpeg_dc_info_t info;
+    frame_quality_t quality;
+    double median_us;
+    double min_us;
+    size_t thumb_len;
+    double thumb_us;          // Mediana de jpeg_thumb_encode()
+} bench_item_t;
+
+#define THUMB_CAPACITY  (64 * 1024)
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_score_desc(const void *a, const void *b) {
+    const bench_item_t *x = a;
+    const bench_item_t *y = b;
+    return (x->quality.score < y->quality.score) - (x->quality.score > y->quality.score);
+}
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = size > 0 ? malloc(size) : NULL;
+    if (data != NULL && fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = data ? (size_t)size : 0;
+    return data;
+}
+
+static int bench_file(bench_item_t *item, int iterations) {
+    if (jpeg_dc_get_info(item->data, item->len, &item->info) != ESP_OK) {
+        return -1;
+    }
+
+    size_t map_size = (size_t)item->info.map_width * item->info.map_height;
+    uint8_t *map = malloc(map_size);
+    uint8_t *thumb = malloc(THUMB_CAPACITY);
+    double *times = malloc(sizeof(double) * iterations);
+    if (map == NULL || thumb == NULL || times == NULL) {
+        free(map);
+        free(thumb);
+        free(times);
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < iterations; i++) {
+        double start = now_us();
+        jpeg_ac_energy_t ac;
+        if (jpeg_dc_luma_map_ac(item->data, item->len, map, map_size, NULL, &ac) != ESP_OK) {
+            ret = -1;
+            break;
+        }
+        frame_analysis_score_map_ac(map, item->info.map_width, item->info.map_height, &ac, &item->quality);
+        times[i] = now_us() - start;
+    }
+
+    if (ret == 0) {
+        qsort(times, iterations, sizeof(double), compare_double);
+        item->median_us = times[iterations / 2];
+        item->min_us = times[0];
+
+        for (int i = 0; i < iterations; i++) {
+            double start = now_us();
+            if (jpeg_thumb_encode(item->data, item->len, JPEG_THUMB_DEFAULT_QUALITY,
+                                  thumb, THUMB_CAPACITY, &item->thumb_len) != ESP_OK) {
+                item->thumb_len = 0;
+                break;
+            }
+            times[i] = now_us() - start;
+        }
+        if (item->thumb_len > 0) {
+            qsort(times, iterations, sizeof(double), compare_double);
+            item->thumb_us = times[iterations / 2];
+        }
+    }
+
+    free(map);
+    free(thumb);
+    free(times);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 50;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        iterations = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc || iterations <= 0) {
+        fprintf(stderr, "Uso: %s [-n iteraciones] archivo.jpg [archivo.jpg ...]\n", argv[0]);
+        return 2;
+    }
+
+    size_t count = 0;
+    bench_item_t *items = calloc(argc - first, sizeof(bench_item_t));
+    if (items == NULL) {
+        return 1;
+    }
+
+    printf("%-32s %8s %10s %6s %9s %8s %10s %10s %10s %10s %9s %6s %10s\n", "archivo", "bytes", "resolución",
+           "media", "nitidez", "detalle", "exposición", "puntuación", "med (us)", "min (us)",
+           "miniatura", "ratio", "mini (us)");
+
+    for (int i = first; i < argc; i++) {
+        bench_item_t *item = &items[count];
+        item->path = argv[i];
+        item->data = read_file(argv[i], &item->len);
+        if (item->data == NULL || bench_file(item, iterations) != 0) {
+            printf("%-32s (no es un JPEG baseline válido, omitido)\n", argv[i]);
+            free(item->data);
+            continue;
+        }
+
+        char res[16];
+        snprintf(res, sizeof(res), "%ux%u", item->info.width, item->info.height);
+        const char *name = strrchr(item->path, '/');
+        printf("%-32s %8zu %10s %6u %9.4f %8.4f %10.3f %10.4f %10.1f %10.1f %9zu %6.1f %10.1f\n",
+               name ? name + 1 : item->path, item->len, res, item->quality.mean,
+               item->quality.sharpness, item->quality.detail, item->quality.exposure, item->quality.score,
+               item->median_us, item->min_us, item->thumb_len,
+               item->thumb_len ? (double)item->len / item->thumb_len : 0.0, item->thumb_us);
+        count++;
+    }
+
+    // Orden que aplicaría la ráfaga (solo tiene sentido entre frames de la misma escena)
+    qsort(items, count, sizeof(bench_item_t), compare_score_desc);
+    printf("\nRanking por puntuación:\n");
+    for (size_t i = 0; i < count; i++) {
+        const char *name = strrchr(items[i].path, '/');
+        printf("  %2zu. %s (%.4f)\n", i + 1, name ? name + 1 : items[i].path, items[i].quality.score);
+        free(items[i].data);
+    }
+
+    free(items);
+    return 0;
+}
@@ -0,0 +1,237 @@
+// frame_store_stress.c - Prueba de host del almacén de frames con una fuente de frames falsa
+//
+// Uso: frame_store_stress [opciones]
+//   -r n         Hilos lectores (por defecto 4)
+//   -n n         Frames que publica la fuente (por defecto 200000)
+//   -s n         Slots del almacén (por defecto lectores + 2: uno por lector, el último
+//                publicado y el que se escribe)
+//   -t us        Tiempo máximo que un lector retiene cada frame (por defecto 200)
+//
+// La fuente falsa escribe frames de tamaño variable cuyo contenido deriva del número de
+// frame; los lectores adquieren el más reciente, lo validan, lo retienen un tiempo
+// aleatorio (como un cliente de /stream enviándolo) y lo validan de nuevo antes de
+// soltarlo: si el escritor reutilizara un slot con lectores, la segunda comprobación falla.
+// Al final comprueba que frame_store_deinit() se niega a liberar con un frame adquirido y
+// espera al lector que lo suelta. Termina con código 1 si algo falla.
+#include "frame_store.h"
+#include "freertos/FreeRTOS.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SLOT_SIZE       8192
+#define MIN_FRAME       512
+#define MAX_THREADS     32
+
+// Resultado de cada lector
+typedef struct {
+    unsigned seed;
+    uint64_t reads;
+    uint64_t empty;
+    uint64_t corrupt;       // Contenido incoherente al adquirir
+    uint64_t overwritten;   // Contenido cambiado mientras se retenía
+    uint64_t backwards;     // Secuencia hacia atrás
+} reader_result_t;
+
+static long frames = 200000;
+static int hold_us = 200;
+static volatile int source_running = 0;
+static uint64_t source_retries = 0;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Fuente de frames falsa: cabecera con el número de frame y relleno derivado
+static size_t fake_frame_fill(uint8_t *buf, uint32_t tag) {
+    size_t len = MIN_FRAME + (tag * 37u) % (SLOT_SIZE - MIN_FRAME);
+    memcpy(buf, &tag, sizeof(tag));
+    for (size_t i = sizeof(tag); i < len; i++) {
+        buf[i] = (uint8_t)(tag * 13u + i);
+    }
+    return len;
+}
+
+static int fake_frame_valid(const camera_frame_t *frame) {
+    uint32_t tag;
+    memcpy(&tag, frame->buf, sizeof(tag));
+    if (tag != frame->seq || frame->meta.episode_id != tag || frame->timestamp != tag ||
+        frame->len != MIN_FRAME + (tag * 37u) % (SLOT_SIZE - MIN_FRAME)) {
+        return 0;
+    }
+    for (size_t i = sizeof(tag); i < frame->len; i++) {
+        if (frame->buf[i] != (uint8_t)(tag * 13u + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *source_thread(void *arg) {
+    (void)arg;
+    uint32_t tag = 1;
+    uint8_t *data = NULL;
+
+    while (tag <= (uint32_t)frames) {
+        camera_frame_t *frame = frame_store_begin_write(SLOT_SIZE, &data);
+        if (frame == NULL) {
+            source_retries++;
+            sched_yield();
+            continue;
+        }
+        frame->len = fake_frame_fill(data, tag);
+        frame->timestamp = tag;
+        frame->meta.episode_id = tag;
+        frame_store_commit(frame);
+        tag++;
+    }
+
+    __atomic_store_n(&source_running, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    reader_result_t *result = arg;
+    uint32_t last_seq = 0;
+
+    while (__atomic_load_n(&source_running, __ATOMIC_ACQUIRE)) {
+        camera_frame_t *frame = camera_frame_acquire();
+        if (frame == NULL) {
+            result->empty++;
+            sched_yield();
+            continue;
+        }
+        if (!fake_frame_valid(frame)) {
+            result->corrupt++;
+        } else {
+            if (frame->seq < last_seq) {
+                result->backwards++;
+            }
+            if (hold_us > 0) {
+                usleep(rand_r(&result->seed) % (hold_us + 1));
+            }
+            if (!fake_frame_valid(frame)) {
+                result->overwritten++;
+            }
+        }
+        last_seq = frame->seq;
+        result->reads++;
+        camera_frame_release(frame);
+    }
+    return NULL;
+}
+
+static void *late_release_thread(void *arg) {
+    usleep(100 * 1000);
+    camera_frame_release(arg);
+    return NULL;
+}
+
+// El deinit no libera memoria con lectores y espera a los que terminan a tiempo
+static int check_deinit(void) {
+    int failed = 0;
+    camera_frame_t *held = camera_frame_acquire();
+    if (held == NULL) {
+        printf("deinit: no hay frame que retener\n");
+        return 1;
+    }
+
+    double start = now_s();
+    esp_err_t err = frame_store_deinit();
+    printf("deinit con un lector que no suelta: %s tras %.2f s\n", esp_err_to_name(err), now_s() - start);
+    failed |= err != ESP_ERR_INVALID_STATE || !fake_frame_valid(held);
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, late_release_thread, held);
+    start = now_s();
+    err = frame_store_deinit();
+    printf("deinit con un lector que suelta a los 100 ms: %s tras %.2f s\n", esp_err_to_name(err), now_s() - start);
+    pthread_join(tid, NULL);
+    failed |= err != ESP_OK;
+
+    uint8_t *data = NULL;
+    failed |= camera_frame_acquire() != NULL || frame_store_begin_write(16, &data) != NULL;
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    int readers = 4;
+    int slots = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:s:t:")) != -1) {
+        switch (opt) {
+            case 'r': readers = atoi(optarg); break;
+            case 'n': frames = atol(optarg); break;
+            case 's': slots = atoi(optarg); break;
+            case 't': hold_us = atoi(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-r lectores] [-n frames] [-s slots] [-t us]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (slots == 0) {
+        slots = readers + 2;
+    }
+    if (readers < 1 || readers + 1 > MAX_THREADS || frames < 1 || slots < 2 || hold_us < 0) {
+        fprintf(stderr, "Configuración inválida (1-%d lectores, 2 o más slots)\n", MAX_THREADS - 1);
+        return 1;
+    }
+
+    printf("frame_store_stress: %d lectores, %ld frames, %d slots de %d bytes, retención hasta %d us\n",
+           readers, frames, slots, SLOT_SIZE, hold_us);
+    fflush(stdout);
+
+    frame_store_config_t config = { .slot_count = slots, .slot_size = SLOT_SIZE };
+    if (frame_store_init(&config) != ESP_OK) {
+        return 1;
+    }
+
+    pthread_t tids[MAX_THREADS];
+    reader_result_t results[MAX_THREADS];
+    memset(results, 0, sizeof(results));
+
+    double start = now_s();
+    source_running = 1;
+    for (int i = 0; i < readers; i++) {
+        results[i].seed = (unsigned)i + 1;
+        pthread_create(&tids[i], NULL, reader_thread, &results[i]);
+    }
+    pthread_create(&tids[readers], NULL, source_thread, NULL);
+    for (int i = 0; i <= readers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double elapsed = now_s() - start;
+
+    reader_result_t total = {0};
+    for (int i = 0; i < readers; i++) {
+        total.reads += results[i].reads;
+        total.empty += results[i].empty;
+        total.corrupt += results[i].corrupt;
+        total.overwritten += results[i].overwritten;
+        total.backwards += results[i].backwards;
+    }
+    frame_store_stats_t stats = frame_store_get_stats();
+
+    printf("%.2f s: %.0f frames/s, %.0f lecturas/s (%llu lecturas, %llu sin frame)\n",
+           elapsed, frames / elapsed, total.reads / elapsed,
+           (unsigned long long)total.reads, (unsigned long long)total.empty);
+    printf("publicados: %lu, sin slot: %lu (reintentos de la fuente: %llu), slots en uso: %lu\n",
+           (unsigned long)stats.published, (unsigned long)stats.dropped_no_slot,
+           (unsigned long long)source_retries, (unsigned long)stats.slots_in_use);
+    printf("incoherentes: %llu, sobrescritos con lector: %llu, secuencia hacia atrás: %llu\n",
+           (unsigned long long)total.corrupt, (unsigned long long)total.overwritten,
+           (unsigned long long)total.backwards);
+
+    int failed = (long)stats.published != frames || stats.slots_in_use != 0 ||
+                 total.corrupt > 0 || total.overwritten > 0 || total.backwards > 0;
+    failed |= check_deinit();
+
+    printf("%s\n", failed ? "FALLO" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#!/bin/sh
+# bench.sh - Rendimiento de los handlers de web_server.c en el host con varias mezclas
+#
+# Uso: bench.sh build/http_bench
+# Variables: CONNECTIONS (conexiones de http_load), DURATION (s medidos por mezcla),
+# WORKERS, QUEUE, FPS, PHOTO (bytes), PORT, LIMITS (1 = admisión del firmware)
+set -e
+
+BUILD=${1:?uso: bench.sh build/http_bench}
+CONNECTIONS=${CONNECTIONS:-8}
+DURATION=${DURATION:-10}
+WORKERS=${WORKERS:-2}
+QUEUE=${QUEUE:-8}
+FPS=${FPS:-5}
+PHOTO=${PHOTO:-100000}
+PORT=${PORT:-8080}
+LIMITS=${LIMITS:-0}
+OUT=$(mktemp -d)
+
+flags=""
+[ "$LIMITS" = 1 ] && flags="-l"
+
+# Cinco mezclas con un segundo de calentamiento cada una, más margen para arrancar
+"$BUILD/http_bench" -p "$PORT" -w "$WORKERS" -q "$QUEUE" -f "$FPS" -s "$PHOTO" $flags \
+    -d $((5 * (DURATION + 1) + 3)) > "$OUT/server.log" &
+server=$!
+sleep 1
+
+load() {
+    "$BUILD/http_load" -p "$PORT" -c "$CONNECTIONS" -d "$DURATION" "$@"
+    echo
+}
+
+load -m "/status"
+load -m "/photo"
+load -m "/photo=50,/status=25,/photo/thumb=10,/photos=5,/photo/meta=5,/metrics=5"
+load -e -m "/photo=60,/status=30,/photo/thumb=10"
+load -k -m "/status=50,/photo=50"
+
+kill -TERM "$server" 2>/dev/null || true
+wait "$server" || true
+cat "$OUT/server.log"
+rm -rf "$OUT"
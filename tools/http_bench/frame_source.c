@@ -0,0 +1,241 @@
+// frame_source.c - Responsabilidad única: publicar frames sintéticos como lo hace cam_reader
+//
+// Sustituye a la cámara y a cam_reader.c (que necesita el driver): escribe en el almacén
+// de frames, copia cada foto al historial y avisa al servidor con photo_taken, en el mismo
+// orden que capture_and_store(). Cada foto pasa también por el anillo pre-disparo, que se
+// congela al empezar un episodio como hace sensorE18 (/photo/preroll). Los JPEG son un patrón pseudoaleatorio entre SOI y EOI:
+// los handlers solo envían bytes, no los decodifican.
+#include "frame_source.h"
+#include "cam_reader.h"
+#include "server_events.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "FRAME_SOURCE";
+
+static frame_source_config_t source_config;
+static QueueHandle_t event_queue = NULL;
+static TaskHandle_t source_task_handle = NULL;
+static uint8_t *pattern = NULL;               // Contenido de partida de todos los JPEG
+static volatile uint32_t published = 0;
+static uint32_t episode_id = 0;
+static uint32_t detections = 0;
+
+#define PREROLL_WINDOW_US   (3 * 1000 * 1000)     // preroll_ms por defecto del firmware
+
+static void post_event(server_event_t *event) {
+    if (event_queue != NULL && server_events_post(event_queue, event) != ESP_OK) {
+        ESP_LOGW(TAG, "Cola del servidor llena: evento %u descartado", event->type);
+    }
+}
+
+// Inicio y fin de episodio como los enviaría sensorE18
+static void post_detection(bool started) {
+    server_event_t event = {
+        .type = started ? SERVER_EVENT_DETECTION_STARTED : SERVER_EVENT_DETECTION_ENDED,
+        .timestamp = esp_timer_get_time(),
+        .object_detected = started,
+        .sensor_state = started ? 0 : 1
+    };
+    event.detection_data.detection_count = detections;
+    post_event(&event);
+    if (started) {
+        int64_t now = esp_timer_get_time();
+        preroll_ring_freeze(detections, now > PREROLL_WINDOW_US ? now - PREROLL_WINDOW_US : 0, now);
+    }
+}
+
+// Copia al anillo pre-disparo (sin anillo o sin entrada libre no hace nada)
+static void preroll_copy(const camera_frame_t *photo) {
+    uint8_t *data = NULL;
+    camera_frame_t *frame = preroll_ring_begin_write(photo->len, &data);
+    if (frame == NULL) {
+        return;
+    }
+    memcpy(data, photo->buf, photo->len);
+    frame->timestamp = photo->timestamp;
+    frame->width = photo->width;
+    frame->height = photo->height;
+    frame->meta = photo->meta;
+    frame->meta.episode_id = 0;
+    preroll_ring_commit(frame);
+}
+
+static void publish_frame(void) {
+    uint32_t n = published;
+    // Tamaño entre el 90 % y el 110 % del configurado: las fotos reales no miden lo mismo
+    size_t len = source_config.frame_size - source_config.frame_size / 10 +
+                 (size_t)(((uint64_t)n * 2654435761u) % (source_config.frame_size / 5 + 1));
+    uint8_t *data = NULL;
+
+    camera_frame_t *frame = frame_store_begin_write(len, &data);
+    if (frame == NULL) {
+        ESP_LOGW(TAG, "Sin slot libre para la foto sintética (%zu bytes)", len);
+        return;
+    }
+
+    memcpy(data, pattern, len);
+    data[0] = 0xFF;
+    data[1] = 0xD8;
+    memcpy(data + 2, &n, sizeof(n));
+    data[len - 2] = 0xFF;
+    data[len - 1] = 0xD9;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    frame->timestamp = esp_timer_get_time();
+    frame->width = 1280;
+    frame->height = 720;
+    camera_frame_meta_t *meta = &frame->meta;
+    memset(meta, 0, sizeof(*meta));
+    meta->wall_time_ms = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+    meta->profile = "day";
+    meta->episode_id = episode_id;
+    meta->capture_latency_us = 95000;
+    meta->aec_value = 300;
+    meta->agc_gain = 4;
+    meta->quality = 12;
+    meta->frame_size = FRAMESIZE_HD;
+    meta->reason = episode_id != 0 ? CAMERA_CAPTURE_REASON_PERIODIC : CAMERA_CAPTURE_REASON_MANUAL;
+    meta->hash_distance = FRAME_HASH_NONE;
+
+    size_t thumb_capacity = 0;
+    uint8_t *thumb = frame_store_thumb_buffer(frame, &thumb_capacity);
+    if (thumb != NULL && source_config.thumb_size > 0) {
+        size_t thumb_len = source_config.thumb_size < thumb_capacity ? source_config.thumb_size : thumb_capacity;
+        memcpy(thumb, pattern + len / 2, thumb_len);
+        frame->thumb_len = thumb_len;
+    }
+
+    // Tras el commit el slot pertenece al almacén: se copia al historial con una referencia
+    uint32_t seq = frame_store_commit(frame);
+    camera_frame_t *latest = camera_frame_acquire();
+    if (latest != NULL && latest->seq == seq) {
+        photo_history_append(latest);
+        preroll_copy(latest);
+    }
+    camera_frame_release(latest);
+    published = n + 1;
+
+    server_event_t event = {
+        .type = SERVER_EVENT_PHOTO_TAKEN,
+        .timestamp = esp_timer_get_time(),
+        .reason = (uint8_t)(episode_id != 0 ? CAMERA_CAPTURE_REASON_PERIODIC : CAMERA_CAPTURE_REASON_MANUAL),
+        .object_detected = false,
+        .sensor_state = -1
+    };
+    event.photo_data.photo_size = len;
+    event.photo_data.seq = seq;
+    post_event(&event);
+}
+
+static void source_task(void *pvParameters) {
+    (void)pvParameters;
+    uint32_t period_ms = 1000 / source_config.fps;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(period_ms));
+
+        // Episodios de detección: empieza uno, source_config.episode_frames fotos, termina
+        uint32_t n = published;
+        if (source_config.episode_frames > 0 && n % source_config.episode_frames == 0) {
+            if (episode_id != 0) {
+                post_detection(false);
+                episode_id = 0;
+            } else {
+                detections++;
+                episode_id = detections;
+                post_detection(true);
+            }
+        }
+        publish_frame();
+    }
+}
+
+esp_err_t frame_source_start(const frame_source_config_t *config, QueueHandle_t server_queue) {
+    if (config == NULL || config->frame_size < 64 || config->fps > 50) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    source_config = *config;
+    event_queue = server_queue;
+
+    // Patrón para la foto más grande posible (110 %) y semilla fija: ejecuciones repetibles
+    size_t pattern_size = config->frame_size + config->frame_size / 10 + 1;
+    pattern = malloc(pattern_size);
+    if (pattern == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < pattern_size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        pattern[i] = (uint8_t)x;
+    }
+
+    publish_frame();
+    if (config->fps > 0 &&
+        xTaskCreate(source_task, "frame_source", 4096, NULL, 5, &source_task_handle) != pdPASS) {
+        free(pattern);
+        pattern = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void frame_source_stop(void) {
+    if (source_task_handle != NULL) {
+        vTaskDelete(source_task_handle);
+        source_task_handle = NULL;
+    }
+}
+
+uint32_t frame_source_published(void) {
+    return published;
+}
+
+// Mismo formato que camera_frame_meta_to_json() de cam_reader.c (ese fichero no compila
+// sin el driver de la cámara); /photo/meta lo usa tal cual
+int camera_frame_meta_to_json(const camera_frame_t *frame, char *buf, size_t size) {
+    const camera_frame_meta_t *meta = &frame->meta;
+
+    return snprintf(buf, size,
+        "{"
+        "\"seq\":%lu,"
+        "\"size\":%u,"
+        "\"width\":%u,"
+        "\"height\":%u,"
+        "\"timestamp_us\":%llu,"
+        "\"wall_time_ms\":%lld,"
+        "\"reason\":\"%s\","
+        "\"reason_id\":%u,"
+        "\"episode_id\":%lu,"
+        "\"capture_latency_us\":%lu,"
+        "\"burst_frames\":%u,"
+        "\"profile\":\"%s\","
+        "\"aec_value\":%u,"
+        "\"agc_gain\":%u,"
+        "\"ae_level\":%d,"
+        "\"gainceiling\":%u,"
+        "\"quality\":%u,"
+        "\"frame_size\":%u,"
+        "\"phash\":\"%016llx%016llx\","
+        "\"hash_distance\":%d,"
+        "\"duplicate\":%s"
+        "}",
+        (unsigned long)frame->seq, (unsigned)frame->len, frame->width, frame->height,
+        (unsigned long long)frame->timestamp, (long long)meta->wall_time_ms,
+        camera_capture_reason_name((camera_capture_reason_t)meta->reason),
+        meta->reason, (unsigned long)meta->episode_id, (unsigned long)meta->capture_latency_us,
+        meta->burst_frames, meta->profile ? meta->profile : "", meta->aec_value, meta->agc_gain,
+        meta->ae_level, meta->gainceiling, meta->quality, meta->frame_size,
+        (unsigned long long)meta->phash.brighter, (unsigned long long)meta->phash.darker,
+        meta->hash_distance == FRAME_HASH_NONE ? -1 : meta->hash_distance,
+        meta->duplicate ? "true" : "false");
+}
@@ -0,0 +1,48 @@
+// frame_source.h - Fuente de frames sintéticos para ejecutar web_server en el host
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Configuración de la fuente
+typedef struct {
+    uint8_t fps;                  // Fotos publicadas por segundo (0 = solo la primera)
+    size_t frame_size;            // Bytes de cada JPEG (varía ±10 % entre fotos)
+    size_t thumb_size;            // Bytes de la miniatura (0 = sin miniatura)
+    uint8_t episode_frames;       // Fotos por episodio de detección (0 = sin eventos del sensor)
+} frame_source_config_t;
+
+// Un JPEG HD típico de la cámara a 5 fps; un episodio cada 10 fotos
+#define FRAME_SOURCE_DEFAULT_CONFIG() { \
+    .fps = 5, \
+    .frame_size = 100000, \
+    .thumb_size = 3000, \
+    .episode_frames = 10 \
+}
+
+/**
+ * @brief Publica la primera foto y arranca la tarea que publica las siguientes
+ * @note Como cam_reader: almacén de frames, historial y evento photo_taken en la cola
+ *       del servidor; frame_store y photo_history deben estar inicializados
+ * @param config Configuración de la fuente
+ * @param server_queue Cola de eventos del servidor (NULL = sin eventos)
+ * @return ESP_OK si exitoso, ESP_ERR_INVALID_ARG o ESP_ERR_NO_MEM
+ */
+esp_err_t frame_source_start(const frame_source_config_t *config, QueueHandle_t server_queue);
+
+/**
+ * @brief Detiene la tarea de la fuente
+ */
+void frame_source_stop(void);
+
+/**
+ * @brief Fotos publicadas desde el arranque
+ * @return Número de fotos
+ */
+uint32_t frame_source_published(void);
+
+#endif // FRAME_SOURCE_H
@@ -0,0 +1,26 @@
+// esp_heap_caps.h - Sustituto para el host: las reservas con capacidades van a malloc y la
+// memoria libre se informa como 0 (no tiene sentido en un proceso de Linux)
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#define heap_caps_malloc(size, caps)        malloc(size)
+#define heap_caps_calloc(n, size, caps)     calloc((n), (size))
+
+static inline size_t heap_caps_get_free_size(unsigned int caps) {
+    (void)caps;
+    return 0;
+}
+
+static inline size_t heap_caps_get_minimum_free_size(unsigned int caps) {
+    (void)caps;
+    return 0;
+}
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,731 @@
+// esp_http_server_host.c - Responsabilidad única: la API de esp_http_server sobre sockets POSIX
+//
+// Mismo modelo de tareas que httpd: un hilo hace select() sobre el socket de escucha y
+// los de las sesiones, lee la petición y ejecuta el handler en ese mismo hilo. Una
+// sesión con una petición asíncrona en curso no se lee ni se cierra hasta que su tarea
+// llama a httpd_req_async_handler_complete(). Solo este hilo cierra sockets: las demás
+// tareas marcan la sesión y lo despiertan por una tubería.
+//
+// Diferencia deliberada con lwIP: los sockets llevan TCP_NODELAY y cada envío sale en una
+// sola llamada (cabecera y cuerpo juntos), para que Nagle y el ACK retardado de Linux no
+// añadan 40 ms a las respuestas por fragmentos y se mida el trabajo de los handlers.
+#include "esp_http_server.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define SESSION_BUF_SIZE    (HTTPD_MAX_URI_LEN + HTTPD_MAX_REQ_HDR_LEN + 32)
+#define RESP_HEAD_SIZE      1024
+
+// Socket abierto
+typedef struct {
+    int fd;                       // -1 = hueco libre
+    bool busy;                    // Petición asíncrona en curso: no se lee ni se cierra
+    bool close_requested;         // Cerrar en cuanto quede libre
+    uint64_t lru;                 // Última petición (reloj del servidor)
+    size_t buf_len;               // Bytes recibidos sin procesar
+    char buf[SESSION_BUF_SIZE];
+} host_sess_t;
+
+typedef struct {
+    httpd_config_t config;
+    int listen_fd;
+    int wake[2];                  // Tubería para despertar al select()
+    pthread_t thread;
+    volatile bool running;
+    pthread_mutex_t lock;         // busy y close_requested de las sesiones
+    host_sess_t *sessions;        // max_open_sockets huecos
+    httpd_uri_t *handlers;        // En orden de registro
+    size_t handler_count;
+    uint64_t lru_clock;
+} host_server_t;
+
+typedef struct {
+    const char *field;
+    const char *value;
+} resp_hdr_t;
+
+// Estado privado de una petición (req->aux); la copia asíncrona lleva el suyo
+typedef struct {
+    host_server_t *server;
+    host_sess_t *sess;
+    int fd;
+    bool keep_alive;
+    bool headers_sent;            // Respuesta por fragmentos empezada
+    bool failed;                  // Un envío falló: la sesión se cierra
+    const char *status;
+    const char *type;
+    char headers[HTTPD_MAX_REQ_HDR_LEN + 1];  // Líneas de cabecera de la petición
+    size_t resp_hdr_count;
+    resp_hdr_t resp_hdrs[];       // max_resp_headers
+} req_aux_t;
+
+static size_t aux_size(const host_server_t *server) {
+    return sizeof(req_aux_t) + server->config.max_resp_headers * sizeof(resp_hdr_t);
+}
+
+static void wake_server(host_server_t *server) {
+    char byte = 1;
+    ssize_t ignored = write(server->wake[1], &byte, 1);
+    (void)ignored;
+}
+
+// Envía todo el vector; false si el cliente se fue o se agotó send_wait_timeout
+static bool send_all(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        while (iovcnt > 0 && (size_t)sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+// Línea de estado y cabeceras; length_line es Content-Length o Transfer-Encoding
+static int format_head(req_aux_t *aux, char *head, const char *length_line) {
+    int len = snprintf(head, RESP_HEAD_SIZE, "HTTP/1.1 %s\r\nContent-Type: %s\r\n%s",
+                       aux->status, aux->type, length_line);
+    for (size_t i = 0; i < aux->resp_hdr_count && len < RESP_HEAD_SIZE; i++) {
+        len += snprintf(head + len, RESP_HEAD_SIZE - len, "%s: %s\r\n",
+                        aux->resp_hdrs[i].field, aux->resp_hdrs[i].value);
+    }
+    if (len < RESP_HEAD_SIZE) {
+        len += snprintf(head + len, RESP_HEAD_SIZE - len, "\r\n");
+    }
+    return len < RESP_HEAD_SIZE ? len : -1;
+}
+
+// Respuesta de error del propio servidor (sin handler)
+static void send_error(int fd, const char *status, const char *msg) {
+    char head[RESP_HEAD_SIZE];
+    int len = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: text/html\r\n"
+                       "Content-Length: %zu\r\n\r\n%s", status, strlen(msg), msg);
+    struct iovec iov = { .iov_base = head, .iov_len = len };
+    send_all(fd, &iov, 1);
+}
+
+// Solo desde el hilo del servidor (o al parar), con la sesión libre
+static void close_session(host_sess_t *sess) {
+    close(sess->fd);
+    sess->fd = -1;
+    sess->busy = false;
+    sess->close_requested = false;
+    sess->buf_len = 0;
+}
+
+static void request_close(host_server_t *server, host_sess_t *sess) {
+    pthread_mutex_lock(&server->lock);
+    sess->close_requested = true;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static size_t open_sessions(const host_server_t *server) {
+    size_t open = 0;
+    for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->sessions[i].fd >= 0) {
+            open++;
+        }
+    }
+    return open;
+}
+
+static void accept_session(host_server_t *server) {
+    int fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    host_sess_t *slot = NULL;
+    host_sess_t *oldest = NULL;
+    for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+        host_sess_t *sess = &server->sessions[i];
+        if (sess->fd < 0) {
+            if (slot == NULL) {
+                slot = sess;
+            }
+        } else if (!sess->busy && (oldest == NULL || sess->lru < oldest->lru)) {
+            oldest = sess;
+        }
+    }
+    // Lleno: con lru_purge_enable se cierra la sesión menos usada (nunca una asíncrona)
+    if (slot == NULL && server->config.lru_purge_enable && oldest != NULL) {
+        close_session(oldest);
+        slot = oldest;
+    }
+    if (slot == NULL) {
+        pthread_mutex_unlock(&server->lock);
+        close(fd);
+        return;
+    }
+    slot->fd = fd;
+    slot->lru = ++server->lru_clock;
+    pthread_mutex_unlock(&server->lock);
+
+    struct timeval timeout = { .tv_sec = server->config.send_wait_timeout };
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static bool uri_matches(const host_server_t *server, const char *uri_template, const char *uri, size_t len) {
+    if (server->config.uri_match_fn != NULL) {
+        return server->config.uri_match_fn(uri_template, uri, len);
+    }
+    return strlen(uri_template) == len && strncmp(uri_template, uri, len) == 0;
+}
+
+// Cabecera de la petición (sin distinguir mayúsculas); devuelve el valor y su longitud
+static const char* find_header(const char *headers, const char *field, size_t *value_len) {
+    size_t field_len = strlen(field);
+    const char *line = headers;
+
+    while (*line != '\0') {
+        const char *eol = strstr(line, "\r\n");
+        if (eol == NULL) {
+            eol = line + strlen(line);
+        }
+        if ((size_t)(eol - line) > field_len && line[field_len] == ':' &&
+            strncasecmp(line, field, field_len) == 0) {
+            const char *value = line + field_len + 1;
+            while (value < eol && (*value == ' ' || *value == '\t')) {
+                value++;
+            }
+            *value_len = eol - value;
+            return value;
+        }
+        line = *eol != '\0' ? eol + 2 : eol;
+    }
+    return NULL;
+}
+
+// Procesa una petición completa del buffer; false si no hay ninguna completa
+static bool process_request(host_server_t *server, host_sess_t *sess) {
+    char *end = NULL;
+    for (size_t i = 0; i + 4 <= sess->buf_len; i++) {
+        if (memcmp(sess->buf + i, "\r\n\r\n", 4) == 0) {
+            end = sess->buf + i;
+            break;
+        }
+    }
+    if (end == NULL) {
+        if (sess->buf_len == sizeof(sess->buf)) {
+            send_error(sess->fd, "431 Request Header Fields Too Large", "Header fields are too long");
+            request_close(server, sess);
+        }
+        return false;
+    }
+    *end = '\0';
+
+    // Línea de petición: MÉTODO URI VERSIÓN
+    char method[8];
+    char version[16];
+    char *line_end = strstr(sess->buf, "\r\n");
+    char *headers = line_end != NULL ? line_end + 2 : end;
+    if (line_end != NULL) {
+        *line_end = '\0';
+    }
+    char *uri_start = strchr(sess->buf, ' ');
+    char *uri_end = uri_start != NULL ? strchr(uri_start + 1, ' ') : NULL;
+    size_t consumed = end + 4 - sess->buf;
+
+    req_aux_t *aux = calloc(1, aux_size(server));
+    if (aux == NULL || uri_start == NULL || uri_end == NULL ||
+        (size_t)(uri_start - sess->buf) >= sizeof(method) ||
+        (size_t)(uri_end - uri_start - 1) > HTTPD_MAX_URI_LEN ||
+        strlen(uri_end + 1) >= sizeof(version) || strlen(headers) > HTTPD_MAX_REQ_HDR_LEN) {
+        free(aux);
+        send_error(sess->fd, "400 Bad Request", "Bad request syntax");
+        request_close(server, sess);
+        return false;
+    }
+
+    httpd_req_t req = { .handle = server, .aux = aux };
+    memcpy(method, sess->buf, uri_start - sess->buf);
+    method[uri_start - sess->buf] = '\0';
+    memcpy(req.uri, uri_start + 1, uri_end - uri_start - 1);
+    req.uri[uri_end - uri_start - 1] = '\0';
+    strcpy(version, uri_end + 1);
+    strcpy(aux->headers, headers);
+
+    aux->server = server;
+    aux->sess = sess;
+    aux->fd = sess->fd;
+    aux->status = "200 OK";
+    aux->type = "text/html";
+
+    // HTTP/1.1 mantiene la conexión salvo "Connection: close"; HTTP/1.0 solo con keep-alive
+    size_t value_len = 0;
+    const char *connection = find_header(aux->headers, "Connection", &value_len);
+    if (strcmp(version, "HTTP/1.1") == 0) {
+        aux->keep_alive = connection == NULL || strncasecmp(connection, "close", value_len) != 0;
+    } else {
+        aux->keep_alive = connection != NULL && strncasecmp(connection, "keep-alive", value_len) == 0;
+    }
+
+    memmove(sess->buf, sess->buf + consumed, sess->buf_len - consumed);
+    sess->buf_len -= consumed;
+
+    // Solo GET sin cuerpo: cualquier otra cosa dejaría bytes sin leer en la sesión
+    const char *length = find_header(aux->headers, "Content-Length", &value_len);
+    if (strcmp(method, "GET") != 0 || (length != NULL && atoi(length) != 0)) {
+        free(aux);
+        send_error(sess->fd, "405 Method Not Allowed", "Request method is not supported");
+        request_close(server, sess);
+        return false;
+    }
+    req.method = HTTP_GET;
+
+    const httpd_uri_t *handler = NULL;
+    size_t match_len = strcspn(req.uri, "?");
+    for (size_t i = 0; i < server->handler_count; i++) {
+        if (server->handlers[i].method == HTTP_GET &&
+            uri_matches(server, server->handlers[i].uri, req.uri, match_len)) {
+            handler = &server->handlers[i];
+            break;
+        }
+    }
+    if (handler == NULL) {
+        free(aux);
+        send_error(sess->fd, "404 Not Found", "Nothing matches the given URI");
+        return true;
+    }
+
+    sess->lru = ++server->lru_clock;
+    req.user_ctx = handler->user_ctx;
+    esp_err_t ret = handler->handler(&req);
+
+    // Como httpd: un handler que falla cierra la sesión
+    if (ret != ESP_OK || aux->failed || !aux->keep_alive) {
+        request_close(server, sess);
+    }
+    free(aux);
+    return true;
+}
+
+static void* server_task(void *arg) {
+    host_server_t *server = (host_server_t *)arg;
+
+    while (server->running) {
+        fd_set readable;
+        int max_fd = server->wake[0];
+        FD_ZERO(&readable);
+        FD_SET(server->wake[0], &readable);
+
+        pthread_mutex_lock(&server->lock);
+        for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+            host_sess_t *sess = &server->sessions[i];
+            if (sess->fd < 0 || sess->busy) {
+                continue;
+            }
+            if (sess->close_requested) {
+                close_session(sess);
+                continue;
+            }
+            FD_SET(sess->fd, &readable);
+            if (sess->fd > max_fd) {
+                max_fd = sess->fd;
+            }
+        }
+        // Lleno y sin purga: las conexiones nuevas esperan en la cola de listen()
+        if (server->config.lru_purge_enable || open_sessions(server) < server->config.max_open_sockets) {
+            FD_SET(server->listen_fd, &readable);
+            if (server->listen_fd > max_fd) {
+                max_fd = server->listen_fd;
+            }
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        if (select(max_fd + 1, &readable, NULL, NULL, NULL) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (FD_ISSET(server->wake[0], &readable)) {
+            char drain[64];
+            while (read(server->wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (!server->running) {
+            break;
+        }
+        if (FD_ISSET(server->listen_fd, &readable)) {
+            accept_session(server);
+        }
+
+        for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+            host_sess_t *sess = &server->sessions[i];
+            if (sess->fd < 0 || !FD_ISSET(sess->fd, &readable)) {
+                continue;
+            }
+            ssize_t received = recv(sess->fd, sess->buf + sess->buf_len, sizeof(sess->buf) - sess->buf_len, 0);
+            if (received <= 0) {
+                pthread_mutex_lock(&server->lock);
+                close_session(sess);
+                pthread_mutex_unlock(&server->lock);
+                continue;
+            }
+            sess->buf_len += received;
+
+            // Peticiones encadenadas: hasta que una pase al pool o pida cerrar
+            bool idle = true;
+            while (idle && process_request(server, sess)) {
+                pthread_mutex_lock(&server->lock);
+                idle = !sess->busy && !sess->close_requested;
+                pthread_mutex_unlock(&server->lock);
+            }
+        }
+    }
+    return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+    if (handle == NULL || config == NULL || config->max_open_sockets == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_server_t *server = calloc(1, sizeof(host_server_t));
+    if (server == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    server->config = *config;
+    server->sessions = calloc(config->max_open_sockets, sizeof(host_sess_t));
+    server->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    if (server->sessions == NULL || server->handlers == NULL) {
+        free(server->sessions);
+        free(server->handlers);
+        free(server);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    for (uint16_t i = 0; i < config->max_open_sockets; i++) {
+        server->sessions[i].fd = -1;
+    }
+    pthread_mutex_init(&server->lock, NULL);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(config->server_port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+    int one = 1;
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0 ||
+        setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, config->backlog_conn) != 0 || pipe(server->wake) != 0) {
+        perror("httpd_start");
+        if (server->listen_fd >= 0) {
+            close(server->listen_fd);
+        }
+        free(server->sessions);
+        free(server->handlers);
+        free(server);
+        return ESP_FAIL;
+    }
+    fcntl(server->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server->wake[1], F_SETFL, O_NONBLOCK);
+
+    server->running = true;
+    if (pthread_create(&server->thread, NULL, server_task, server) != 0) {
+        close(server->listen_fd);
+        close(server->wake[0]);
+        close(server->wake[1]);
+        free(server->sessions);
+        free(server->handlers);
+        free(server);
+        return ESP_ERR_HTTPD_TASK;
+    }
+
+    *handle = server;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+    host_server_t *server = (host_server_t *)handle;
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    server->running = false;
+    wake_server(server);
+    pthread_join(server->thread, NULL);
+
+    for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->sessions[i].fd >= 0) {
+            close_session(&server->sessions[i]);
+        }
+    }
+    close(server->listen_fd);
+    close(server->wake[0]);
+    close(server->wake[1]);
+    pthread_mutex_destroy(&server->lock);
+    free(server->sessions);
+    free(server->handlers);
+    free(server);
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) {
+    host_server_t *server = (host_server_t *)handle;
+    if (server == NULL || uri_handler == NULL || uri_handler->uri == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < server->handler_count; i++) {
+        if (server->handlers[i].method == uri_handler->method &&
+            strcmp(server->handlers[i].uri, uri_handler->uri) == 0) {
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (server->handler_count >= server->config.max_uri_handlers) {
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    server->handlers[server->handler_count++] = *uri_handler;
+    return ESP_OK;
+}
+
+// Misma semántica que httpd: "*" final acepta cualquier resto y "?" final hace opcional
+// el carácter anterior ("/photo/*" coincide con "/photo/123" pero no con "/photo")
+bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match, size_t match_upto) {
+    size_t tpl_len = strlen(uri_template);
+    char last = tpl_len > 0 ? uri_template[tpl_len - 1] : '\0';
+    char prev = tpl_len > 1 ? uri_template[tpl_len - 2] : '\0';
+    bool asterisk = last == '*' || (prev == '*' && last == '?');
+    bool quest = last == '?' || (prev == '?' && last == '*');
+    size_t special = (asterisk ? 1 : 0) + (quest ? 2 : 0);
+
+    if (tpl_len < special) {
+        return false;
+    }
+    size_t exact = tpl_len - special;
+    if (match_upto < exact) {
+        return false;
+    }
+    if (!quest) {
+        if (!asterisk && match_upto != exact) {
+            return false;
+        }
+        return strncmp(uri_template, uri_to_match, exact) == 0;
+    }
+    if (match_upto > exact && uri_template[exact] != uri_to_match[exact]) {
+        return false;
+    }
+    if (strncmp(uri_template, uri_to_match, exact) != 0) {
+        return false;
+    }
+    return asterisk || match_upto <= exact + 1;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status) {
+    ((req_aux_t *)req->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type) {
+    ((req_aux_t *)req->aux)->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value) {
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    if (aux->resp_hdr_count >= aux->server->config.max_resp_headers) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    aux->resp_hdrs[aux->resp_hdr_count].field = field;
+    aux->resp_hdrs[aux->resp_hdr_count].value = value;
+    aux->resp_hdr_count++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len) {
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    char head[RESP_HEAD_SIZE];
+    char length_line[48];
+
+    if (buf == NULL) {
+        buf_len = 0;
+    } else if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+    snprintf(length_line, sizeof(length_line), "Content-Length: %zd\r\n", buf_len);
+    int head_len = format_head(aux, head, length_line);
+    if (head_len < 0) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+
+    struct iovec iov[2] = {
+        { .iov_base = head, .iov_len = head_len },
+        { .iov_base = (void *)buf, .iov_len = buf_len }
+    };
+    if (!send_all(aux->fd, iov, buf_len > 0 ? 2 : 1)) {
+        aux->failed = true;
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len) {
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    char head[RESP_HEAD_SIZE];
+    char size_line[16];
+    struct iovec iov[4];
+    int iovcnt = 0;
+
+    if (buf == NULL) {
+        buf_len = 0;
+    } else if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+    if (!aux->headers_sent) {
+        int head_len = format_head(aux, head, "Transfer-Encoding: chunked\r\n");
+        if (head_len < 0) {
+            return ESP_ERR_HTTPD_RESP_HDR;
+        }
+        iov[iovcnt++] = (struct iovec){ .iov_base = head, .iov_len = head_len };
+        aux->headers_sent = true;
+    }
+
+    // Un fragmento vacío es el final de la respuesta
+    int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", buf_len);
+    iov[iovcnt++] = (struct iovec){ .iov_base = size_line, .iov_len = size_len };
+    if (buf_len > 0) {
+        iov[iovcnt++] = (struct iovec){ .iov_base = (void *)buf, .iov_len = buf_len };
+    }
+    iov[iovcnt++] = (struct iovec){ .iov_base = "\r\n", .iov_len = 2 };
+
+    if (!send_all(aux->fd, iov, iovcnt)) {
+        aux->failed = true;
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+// Copia acotada como httpd: trunca y lo indica con ESP_ERR_HTTPD_RESULT_TRUNC
+static esp_err_t copy_value(char *dst, size_t dst_size, const char *src, size_t len) {
+    if (dst_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t copy = len < dst_size ? len : dst_size - 1;
+    memcpy(dst, src, copy);
+    dst[copy] = '\0';
+    return copy < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size) {
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    size_t value_len = 0;
+    const char *value = find_header(aux->headers, field, &value_len);
+    if (value == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return copy_value(val, val_size, value, value_len);
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t buf_len) {
+    const char *query = strchr(req->uri, '?');
+    if (query == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return copy_value(buf, buf_len, query + 1, strlen(query + 1));
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size) {
+    size_t key_len = strlen(key);
+    const char *pair = qry;
+
+    while (pair != NULL && *pair != '\0') {
+        const char *next = strchr(pair, '&');
+        size_t pair_len = next != NULL ? (size_t)(next - pair) : strlen(pair);
+        if (pair_len > key_len && pair[key_len] == '=' && strncmp(pair, key, key_len) == 0) {
+            return copy_value(val, val_size, pair + key_len + 1, pair_len - key_len - 1);
+        }
+        pair = next != NULL ? next + 1 : NULL;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *req, httpd_req_t **out) {
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    size_t size = aux_size(aux->server);
+    httpd_req_t *copy = malloc(sizeof(httpd_req_t));
+    req_aux_t *aux_copy = malloc(size);
+
+    if (out == NULL || copy == NULL || aux_copy == NULL) {
+        free(copy);
+        free(aux_copy);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    *copy = *req;
+    memcpy(aux_copy, aux, size);
+    copy->aux = aux_copy;
+
+    pthread_mutex_lock(&aux->server->lock);
+    aux->sess->busy = true;
+    pthread_mutex_unlock(&aux->server->lock);
+    *out = copy;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *req) {
+    if (req == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    req_aux_t *aux = (req_aux_t *)req->aux;
+    host_server_t *server = aux->server;
+
+    pthread_mutex_lock(&server->lock);
+    aux->sess->busy = false;
+    if (aux->failed || !aux->keep_alive) {
+        aux->sess->close_requested = true;
+    }
+    pthread_mutex_unlock(&server->lock);
+    wake_server(server);
+
+    free(aux);
+    free(req);
+    return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *req) {
+    return req != NULL ? ((req_aux_t *)req->aux)->fd : -1;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd) {
+    host_server_t *server = (host_server_t *)handle;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    pthread_mutex_lock(&server->lock);
+    for (uint16_t i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->sessions[i].fd == sockfd) {
+            server->sessions[i].close_requested = true;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+    wake_server(server);
+    return ret;
+}
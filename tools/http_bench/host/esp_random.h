@@ -0,0 +1,12 @@
+// esp_random.h - Sustituto para el host (solo se usa para la época de los ETag)
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static inline uint32_t esp_random(void) {
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+#endif // HOST_ESP_RANDOM_H
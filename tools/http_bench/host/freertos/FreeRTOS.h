@@ -0,0 +1,65 @@
+// FreeRTOS.h - Sustituto para ejecutar web_server en el host (Linux) sobre pthreads
+// Un tick es un milisegundo (el firmware usa 100 Hz: las esperas cortas son más finas aquí).
+// portMUX es un spinlock; como no hay interrupciones que enmascarar, el enmascarado de
+// metrics.c toma un spinlock global y todas las tareas escriben la copia del núcleo 0
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <sched.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define portNUM_PROCESSORS      2
+#define tskNO_AFFINITY          0x7FFFFFFF
+
+typedef struct {
+    volatile int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+static inline void portENTER_CRITICAL(portMUX_TYPE *mux) {
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+        // Quien lo tiene puede haber perdido la CPU: cederla en vez de girar sin fin
+        while (__atomic_load_n(&mux->locked, __ATOMIC_RELAXED)) {
+            sched_yield();
+        }
+    }
+}
+
+static inline void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+
+// Enmascarar interrupciones: en el host, un spinlock global (ver freertos_host.c)
+extern portMUX_TYPE host_interrupt_mask;
+
+static inline UBaseType_t portSET_INTERRUPT_MASK_FROM_ISR(void) {
+    portENTER_CRITICAL(&host_interrupt_mask);
+    return 0;
+}
+
+static inline void portCLEAR_INTERRUPT_MASK_FROM_ISR(UBaseType_t mask) {
+    (void)mask;
+    portEXIT_CRITICAL(&host_interrupt_mask);
+}
+
+static inline BaseType_t xPortGetCoreID(void) {
+    return 0;
+}
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,36 @@
+// task.h - Tareas de FreeRTOS para el host: un hilo por tarea y notificaciones con
+// mutex y variable de condición
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task host_task_t;
+typedef host_task_t *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+/**
+ * @brief Crea un hilo que ejecuta fn(arg); la pila, la prioridad y el núcleo se ignoran
+ * @return pdPASS si exitoso, pdFAIL si no se pudo crear el hilo
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id);
+
+#define xTaskCreate(fn, name, stack_size, arg, priority, handle) \
+    xTaskCreatePinnedToCore((fn), (name), (stack_size), (arg), (priority), (handle), tskNO_AFFINITY)
+
+/**
+ * @brief Termina la tarea actual (NULL) o cancela otra en su siguiente espera
+ */
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,360 @@
+// freertos_host.c - Responsabilidad única: tareas, colas y semáforos de FreeRTOS sobre pthreads
+//
+// Lo justo para que web_server.c, http_workers.c y server_events.c se ejecuten sin cambios.
+// Las esperas con tiempo usan CLOCK_MONOTONIC. Borrar otra tarea la cancela en su
+// siguiente espera; los manejadores de limpieza sueltan el mutex que la espera retenía.
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+portMUX_TYPE host_interrupt_mask = portMUX_INITIALIZER_UNLOCKED;
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t mutex;
+    pthread_cond_t notified;
+    uint32_t notify_count;
+};
+
+struct host_queue {
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+struct host_semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t available;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+static __thread host_task_t *current_task = NULL;
+
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_after(struct timespec *deadline, TickType_t ticks) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / 1000;
+    deadline->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// Espera a la condición con el mutex tomado; false si se agotaron los ticks
+static bool wait_for(pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks,
+                     const struct timespec *deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+static void unlock_mutex(void *mutex) {
+    pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+// Tareas
+
+static host_task_t* task_alloc(void) {
+    host_task_t *task = calloc(1, sizeof(host_task_t));
+    if (task != NULL) {
+        pthread_mutex_init(&task->mutex, NULL);
+        cond_init(&task->notified);
+    }
+    return task;
+}
+
+static void* task_entry(void *arg) {
+    host_task_t *task = (host_task_t *)arg;
+    current_task = task;
+    task->fn(task->arg);
+    // Una tarea de FreeRTOS no debe volver de su función; por si acaso, se borra igual
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id) {
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core_id;
+
+    host_task_t *task = task_alloc();
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    // El handle se publica antes de que la tarea empiece, como en FreeRTOS
+    if (handle != NULL) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        if (handle != NULL) {
+            *handle = NULL;
+        }
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        // Nadie conserva el handle de una tarea que se borra a sí misma (web_server.c
+        // suelta el registro del cliente antes): se puede liberar
+        host_task_t *self = current_task;
+        current_task = NULL;
+        free(self);
+        pthread_exit(NULL);
+    }
+    // El descriptor de la cancelada no se libera: el hilo aún puede estar saliendo
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec delay = {
+        .tv_sec = ticks / 1000,
+        .tv_nsec = (long)(ticks % 1000) * 1000000L
+    };
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // Hilos que no creó xTaskCreate (main, httpd): descriptor al primer uso
+    if (current_task == NULL) {
+        current_task = task_alloc();
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->mutex);
+    task->notify_count++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->mutex);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    host_task_t *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&task->mutex);
+    pthread_cleanup_push(unlock_mutex, &task->mutex);
+    while (task->notify_count == 0) {
+        if (!wait_for(&task->notified, &task->mutex, ticks, &deadline)) {
+            break;
+        }
+    }
+    pthread_cleanup_pop(0);
+    uint32_t value = task->notify_count;
+    if (value > 0) {
+        task->notify_count = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->mutex);
+    return value;
+}
+
+// Colas
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    host_queue_t *queue = calloc(1, sizeof(host_queue_t));
+    if (queue == NULL) {
+        return NULL;
+    }
+    queue->items = calloc(length, item_size);
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->mutex, NULL);
+    cond_init(&queue->not_empty);
+    cond_init(&queue->not_full);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->items);
+    free(queue);
+}
+
+// Inserta al final o, con front, delante del primero pendiente
+static BaseType_t queue_put(QueueHandle_t queue, const void *item, TickType_t ticks, bool front) {
+    struct timespec deadline;
+    BaseType_t ret = pdTRUE;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(unlock_mutex, &queue->mutex);
+    while (queue->count == queue->length) {
+        if (!wait_for(&queue->not_full, &queue->mutex, ticks, &deadline)) {
+            ret = pdFALSE;
+            break;
+        }
+    }
+    if (ret == pdTRUE) {
+        UBaseType_t index;
+        if (front) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            index = queue->head;
+        } else {
+            index = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(queue->items + (size_t)index * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_signal(&queue->not_empty);
+    }
+    pthread_cleanup_pop(1);
+    return ret;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    struct timespec deadline;
+    BaseType_t ret = pdTRUE;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(unlock_mutex, &queue->mutex);
+    while (queue->count == 0) {
+        if (!wait_for(&queue->not_empty, &queue->mutex, ticks, &deadline)) {
+            ret = pdFALSE;
+            break;
+        }
+    }
+    if (ret == pdTRUE) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_cleanup_pop(1);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return spaces;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdPASS;
+}
+
+// Semáforos
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    host_semaphore_t *semaphore = calloc(1, sizeof(host_semaphore_t));
+    if (semaphore == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    cond_init(&semaphore->available);
+    semaphore->count = initial_count;
+    semaphore->max_count = max_count;
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    pthread_mutex_destroy(&semaphore->mutex);
+    pthread_cond_destroy(&semaphore->available);
+    free(semaphore);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    struct timespec deadline;
+    BaseType_t ret = pdTRUE;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&semaphore->mutex);
+    pthread_cleanup_push(unlock_mutex, &semaphore->mutex);
+    while (semaphore->count == 0) {
+        if (!wait_for(&semaphore->available, &semaphore->mutex, ticks, &deadline)) {
+            ret = pdFALSE;
+            break;
+        }
+    }
+    if (ret == pdTRUE) {
+        semaphore->count--;
+    }
+    pthread_cleanup_pop(1);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&semaphore->mutex);
+    if (semaphore->count < semaphore->max_count) {
+        semaphore->count++;
+        pthread_cond_signal(&semaphore->available);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+    return ret;
+}
@@ -0,0 +1,5 @@
+// sdkconfig.h - Sustituto para el host: sin PSRAM (CONFIG_SPIRAM sin definir)
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#endif // HOST_SDKCONFIG_H
@@ -0,0 +1,110 @@
+// http_bench.c - Servidor web del firmware ejecutado en el host (Linux) con frames sintéticos
+//
+// Compila web_server.c y sus módulos sin cambios sobre host/ (httpd sobre sockets POSIX,
+// FreeRTOS sobre pthreads) y publica fotos con frame_source.c. http_load.c genera la carga.
+//
+// Uso: http_bench [-p puerto] [-w tareas] [-q cola] [-f fps] [-s bytes] [-t bytes] [-l] [-d s]
+#include "web_server.h"
+#include "cam_reader.h"
+#include "frame_source.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-p puerto] [-w tareas] [-q cola] [-f fps] [-s bytes] [-t bytes] [-l] [-d s]\n"
+            "  -p  Puerto (8080)\n"
+            "  -w  worker_count del pool HTTP (2; 0 = handlers en el hilo de httpd)\n"
+            "  -q  worker_queue_depth (8)\n"
+            "  -f  Fotos sintéticas por segundo (5; 0 = una sola)\n"
+            "  -s  Bytes de cada foto (100000)\n"
+            "  -t  Bytes de la miniatura (3000)\n"
+            "  -l  Admisión por IP con los valores del firmware (por defecto sin límite:\n"
+            "      toda la carga llega desde 127.0.0.1)\n"
+            "  -d  Segundos hasta terminar (0 = Ctrl+C)\n", prog);
+}
+
+int main(int argc, char **argv) {
+    server_config_t config = SERVER_DEFAULT_CONFIG();
+    frame_source_config_t source = FRAME_SOURCE_DEFAULT_CONFIG();
+    bool limits = false;
+    unsigned duration_s = 0;
+    int opt;
+
+    config.port = 8080;
+    while ((opt = getopt(argc, argv, "p:w:q:f:s:t:ld:")) != -1) {
+        switch (opt) {
+        case 'p': config.port = (uint16_t)atoi(optarg); break;
+        case 'w': config.worker_count = (uint8_t)atoi(optarg); break;
+        case 'q': config.worker_queue_depth = (uint8_t)atoi(optarg); break;
+        case 'f': source.fps = (uint8_t)atoi(optarg); break;
+        case 's': source.frame_size = (size_t)atol(optarg); break;
+        case 't': source.thumb_size = (size_t)atol(optarg); break;
+        case 'l': limits = true; break;
+        case 'd': duration_s = (unsigned)atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (!limits) {
+        config.photo_per_minute = 0;
+        config.stream_per_minute = 0;
+        config.history_per_minute = 0;
+    }
+
+    // Las señales se esperan en main: los hilos que se creen después las tienen bloqueadas
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    // Almacén e historial como en el firmware; los slots admiten la foto más grande (110 %)
+    frame_store_config_t store = FRAME_STORE_DEFAULT_CONFIG();
+    store.slot_size = source.frame_size + source.frame_size / 10 + 1;
+    photo_history_config_t history = PHOTO_HISTORY_DEFAULT_CONFIG();
+    if (frame_store_init(&store) != ESP_OK || photo_history_init(&history) != ESP_OK ||
+        preroll_ring_init(8, store.slot_size) != ESP_OK) {
+        fprintf(stderr, "Error inicializando el almacén de frames, el historial o el anillo\n");
+        return 1;
+    }
+
+    if (web_server_init_with_config(&config) != ESP_OK || web_server_start() != ESP_OK) {
+        fprintf(stderr, "Error iniciando el servidor web en el puerto %u\n", config.port);
+        return 1;
+    }
+    if (frame_source_start(&source, web_server_get_event_queue()) != ESP_OK) {
+        fprintf(stderr, "Error iniciando la fuente de frames\n");
+        return 1;
+    }
+
+    printf("http_bench: puerto %u, pool x%u (cola %u), %u fps de %zu B, admisión %s\n",
+           config.port, config.worker_count, config.worker_queue_depth, source.fps,
+           source.frame_size, limits ? "del firmware" : "sin límite");
+    fflush(stdout);
+
+    if (duration_s > 0) {
+        struct timespec timeout = { .tv_sec = duration_s };
+        sigtimedwait(&signals, NULL, &timeout);
+    } else {
+        int sig;
+        sigwait(&signals, &sig);
+    }
+
+    frame_source_stop();
+    http_workers_stats_t workers;
+    http_workers_get_stats(&workers);
+    char json[512];
+    http_workers_stats_json(&workers, json, sizeof(json));
+    printf("http_bench: %lu fotos publicadas, pool %s\n", (unsigned long)frame_source_published(), json);
+
+    web_server_deinit();
+    preroll_ring_deinit();
+    photo_history_deinit();
+    frame_store_deinit();
+    return 0;
+}
@@ -0,0 +1,578 @@
+// http_load.c - Generador de carga HTTP con latencia por ruta (p50/p95/p99)
+//
+// Uso: http_load [opciones]
+//   -h host      Dirección del servidor (por defecto 127.0.0.1)
+//   -p puerto    Puerto TCP (por defecto 8080)
+//   -c n         Conexiones simultáneas, un hilo cada una (por defecto 8)
+//   -d s         Segundos medidos (por defecto 10)
+//   -w s         Segundos de calentamiento que no se cuentan (por defecto 1)
+//   -m mezcla    Rutas y pesos: "/photo=60,/status=30,/photo/thumb=10" (por defecto /status)
+//   -k           Sin keep-alive: una conexión por petición (Connection: close)
+//   -e           Peticiones condicionales: If-None-Match con el último ETag de cada ruta
+//   -j           Añadir una línea JSON con el resumen
+//
+// Cada hilo trabaja en bucle cerrado: elige una ruta según los pesos, envía el GET y lee la
+// respuesta completa (Content-Length o chunked) antes de la siguiente. La latencia va desde
+// el envío (o el connect() si la conexión es nueva) hasta el último byte del cuerpo. Si una
+// conexión reutilizada se cierra sin responder (el servidor la purgó), la petición se repite
+// una vez en una conexión nueva. /stream y /events no terminan: no sirven en la mezcla.
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_ROUTES          16
+#define MAX_CONNECTIONS     256
+#define RECV_TIMEOUT_S      10
+#define BUF_SIZE            16384
+#define ETAG_SIZE           64
+
+typedef struct {
+    char path[128];
+    unsigned weight;
+} route_t;
+
+// Una petición medida (status 0 = error de red o respuesta mal formada)
+typedef struct {
+    uint8_t route;
+    uint16_t status;
+    uint32_t latency_us;
+    uint32_t bytes;
+} sample_t;
+
+// Conexión con buffer de lectura
+typedef struct {
+    int fd;
+    char buf[BUF_SIZE];
+    size_t pos;
+    size_t len;
+} conn_t;
+
+typedef struct {
+    pthread_t thread;
+    uint32_t seed;
+    sample_t *samples;
+    size_t count;
+    size_t capacity;
+    char etags[MAX_ROUTES][ETAG_SIZE];
+    conn_t conn;
+} client_t;
+
+static route_t routes[MAX_ROUTES];
+static int route_count = 0;
+static unsigned weight_total = 0;
+static struct sockaddr_storage server_addr;
+static socklen_t server_addr_len;
+static char host_header[128];
+static bool keep_alive = true;
+static bool conditional = false;
+static uint64_t measure_start_us;
+static uint64_t measure_end_us;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// "/photo=60,/status=30": pesos enteros, 1 si se omite
+static bool parse_mix(const char *mix) {
+    char copy[1024];
+    snprintf(copy, sizeof(copy), "%s", mix);
+
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        if (route_count == MAX_ROUTES || item[0] != '/') {
+            return false;
+        }
+        route_t *route = &routes[route_count++];
+        char *eq = strchr(item, '=');
+        route->weight = 1;
+        if (eq != NULL) {
+            *eq = '\0';
+            route->weight = (unsigned)atoi(eq + 1);
+        }
+        snprintf(route->path, sizeof(route->path), "%s", item);
+        weight_total += route->weight;
+    }
+    return route_count > 0 && weight_total > 0;
+}
+
+static int pick_route(client_t *client) {
+    unsigned r = next_random(&client->seed) % weight_total;
+    for (int i = 0; i < route_count; i++) {
+        if (r < routes[i].weight) {
+            return i;
+        }
+        r -= routes[i].weight;
+    }
+    return route_count - 1;
+}
+
+// Conexión
+
+static void conn_close(conn_t *conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    conn->pos = 0;
+    conn->len = 0;
+}
+
+static bool conn_open(conn_t *conn) {
+    conn->fd = socket(server_addr.ss_family, SOCK_STREAM, 0);
+    if (conn->fd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = { .tv_sec = RECV_TIMEOUT_S };
+    setsockopt(conn->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(conn->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(conn->fd, (struct sockaddr *)&server_addr, server_addr_len) != 0) {
+        conn_close(conn);
+        return false;
+    }
+    conn->pos = 0;
+    conn->len = 0;
+    return true;
+}
+
+// Lee más datos al buffer; > 0 si hay datos nuevos, 0 si el servidor cerró, < 0 si error
+static ssize_t conn_fill(conn_t *conn) {
+    if (conn->pos > 0) {
+        memmove(conn->buf, conn->buf + conn->pos, conn->len - conn->pos);
+        conn->len -= conn->pos;
+        conn->pos = 0;
+    }
+    if (conn->len == sizeof(conn->buf)) {
+        return -1;
+    }
+    ssize_t n;
+    do {
+        n = recv(conn->fd, conn->buf + conn->len, sizeof(conn->buf) - conn->len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0) {
+        conn->len += (size_t)n;
+    }
+    return n;
+}
+
+// Una línea sin CRLF en line; false si la conexión se cierra antes o la línea no cabe
+static bool conn_read_line(conn_t *conn, char *line, size_t size, bool *got_bytes) {
+    for (;;) {
+        char *start = conn->buf + conn->pos;
+        char *nl = memchr(start, '\n', conn->len - conn->pos);
+        if (nl != NULL) {
+            size_t n = (size_t)(nl - start);
+            if (n > 0 && start[n - 1] == '\r') {
+                n--;
+            }
+            if (n >= size) {
+                return false;
+            }
+            memcpy(line, start, n);
+            line[n] = '\0';
+            conn->pos += (size_t)(nl - start) + 1;
+            return true;
+        }
+        if (conn_fill(conn) <= 0) {
+            return false;
+        }
+        if (got_bytes != NULL) {
+            *got_bytes = true;
+        }
+    }
+}
+
+// Descarta n bytes del cuerpo
+static bool conn_skip(conn_t *conn, size_t n) {
+    while (n > 0) {
+        size_t avail = conn->len - conn->pos;
+        if (avail == 0) {
+            conn->pos = 0;
+            conn->len = 0;
+            if (conn_fill(conn) <= 0) {
+                return false;
+            }
+            continue;
+        }
+        size_t take = avail < n ? avail : n;
+        conn->pos += take;
+        n -= take;
+    }
+    return true;
+}
+
+// Respuesta
+
+typedef struct {
+    int status;
+    bool close;
+    size_t bytes;
+    char etag[ETAG_SIZE];
+} response_t;
+
+static bool read_chunked(conn_t *conn, response_t *resp) {
+    char line[128];
+    for (;;) {
+        if (!conn_read_line(conn, line, sizeof(line), NULL)) {
+            return false;
+        }
+        size_t size = (size_t)strtoul(line, NULL, 16);
+        if (size == 0) {
+            // Trailers (ninguno) y la línea vacía final
+            do {
+                if (!conn_read_line(conn, line, sizeof(line), NULL)) {
+                    return false;
+                }
+            } while (line[0] != '\0');
+            return true;
+        }
+        if (!conn_skip(conn, size) || !conn_read_line(conn, line, sizeof(line), NULL)) {
+            return false;
+        }
+        resp->bytes += size;
+    }
+}
+
+// Lee cabeceras y cuerpo; *got_bytes indica si llegó algo (para reintentar si no)
+static bool read_response(conn_t *conn, response_t *resp, bool *got_bytes) {
+    char line[1024];
+    long content_length = -1;
+    bool chunked = false;
+
+    memset(resp, 0, sizeof(*resp));
+    *got_bytes = conn->len > conn->pos;
+    if (!conn_read_line(conn, line, sizeof(line), got_bytes) ||
+        sscanf(line, "HTTP/1.%*d %d", &resp->status) != 1) {
+        return false;
+    }
+    for (;;) {
+        if (!conn_read_line(conn, line, sizeof(line), NULL)) {
+            return false;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        char *value = strchr(line, ':');
+        if (value == NULL) {
+            return false;
+        }
+        *value++ = '\0';
+        while (*value == ' ') {
+            value++;
+        }
+        if (strcasecmp(line, "Content-Length") == 0) {
+            content_length = atol(value);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            chunked = strcasecmp(value, "chunked") == 0;
+        } else if (strcasecmp(line, "Connection") == 0) {
+            resp->close = strcasecmp(value, "close") == 0;
+        } else if (strcasecmp(line, "ETag") == 0) {
+            snprintf(resp->etag, sizeof(resp->etag), "%s", value);
+        }
+    }
+
+    if (chunked) {
+        return read_chunked(conn, resp);
+    }
+    if (content_length >= 0) {
+        resp->bytes = (size_t)content_length;
+        return conn_skip(conn, (size_t)content_length);
+    }
+    // Sin longitud: el cuerpo termina al cerrar la conexión
+    resp->close = true;
+    ssize_t n;
+    conn->pos = conn->len;
+    while ((n = conn_fill(conn)) > 0) {
+        resp->bytes += (size_t)n;
+        conn->pos = conn->len;
+    }
+    return n == 0;
+}
+
+static bool send_request(client_t *client, int route) {
+    char request[512];
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\n%s",
+                       routes[route].path, host_header, keep_alive ? "" : "Connection: close\r\n");
+    if (conditional && client->etags[route][0] != '\0') {
+        len += snprintf(request + len, sizeof(request) - (size_t)len, "If-None-Match: %s\r\n",
+                        client->etags[route]);
+    }
+    len += snprintf(request + len, sizeof(request) - (size_t)len, "\r\n");
+    return send(client->conn.fd, request, (size_t)len, MSG_NOSIGNAL) == len;
+}
+
+// Una petición completa: status HTTP, o 0 si falló
+static int do_request(client_t *client, int route, size_t *bytes) {
+    response_t resp;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = client->conn.fd >= 0;
+        if (!reused && !conn_open(&client->conn)) {
+            return 0;
+        }
+        bool got_bytes = false;
+        if (send_request(client, route) && read_response(&client->conn, &resp, &got_bytes)) {
+            if (resp.close || !keep_alive) {
+                conn_close(&client->conn);
+            }
+            if (resp.status == 200 && resp.etag[0] != '\0') {
+                memcpy(client->etags[route], resp.etag, ETAG_SIZE);
+            }
+            *bytes = resp.bytes;
+            return resp.status;
+        }
+        conn_close(&client->conn);
+        // Solo se repite si la conexión reutilizada se cerró sin responder nada
+        if (!reused || got_bytes) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+static void record(client_t *client, int route, int status, uint64_t latency_us, size_t bytes) {
+    if (client->count == client->capacity) {
+        size_t capacity = client->capacity ? client->capacity * 2 : 4096;
+        sample_t *samples = realloc(client->samples, capacity * sizeof(sample_t));
+        if (samples == NULL) {
+            return;
+        }
+        client->samples = samples;
+        client->capacity = capacity;
+    }
+    client->samples[client->count++] = (sample_t){
+        .route = (uint8_t)route,
+        .status = (uint16_t)status,
+        .latency_us = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us,
+        .bytes = bytes > UINT32_MAX ? UINT32_MAX : (uint32_t)bytes
+    };
+}
+
+static void* client_thread(void *arg) {
+    client_t *client = (client_t *)arg;
+
+    for (;;) {
+        uint64_t start = now_us();
+        if (start >= measure_end_us) {
+            break;
+        }
+        int route = pick_route(client);
+        size_t bytes = 0;
+        int status = do_request(client, route, &bytes);
+        uint64_t end = now_us();
+        if (start >= measure_start_us && end <= measure_end_us) {
+            record(client, route, status, end - start, bytes);
+        }
+        if (status == 0) {
+            // Sin servidor no tiene sentido girar a toda velocidad
+            usleep(10000);
+        }
+    }
+    conn_close(&client->conn);
+    return NULL;
+}
+
+// Informe
+
+typedef struct {
+    size_t requests;
+    size_t ok;
+    size_t not_modified;
+    size_t unavailable;
+    size_t other;
+    size_t errors;
+    uint64_t bytes;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+} route_stats_t;
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango más cercano sobre las latencias ordenadas
+static uint32_t percentile(const uint32_t *sorted, size_t n, unsigned p) {
+    size_t rank = (n * p + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Estadísticas de una ruta (route < 0 = todas)
+static void route_stats(const client_t *clients, int connections, int route, route_stats_t *stats) {
+    size_t total = 0;
+    memset(stats, 0, sizeof(*stats));
+    for (int c = 0; c < connections; c++) {
+        total += clients[c].count;
+    }
+    uint32_t *latencies = malloc((total ? total : 1) * sizeof(uint32_t));
+    if (latencies == NULL) {
+        return;
+    }
+    size_t n = 0;
+    for (int c = 0; c < connections; c++) {
+        for (size_t i = 0; i < clients[c].count; i++) {
+            const sample_t *s = &clients[c].samples[i];
+            if (route >= 0 && s->route != route) {
+                continue;
+            }
+            stats->requests++;
+            switch (s->status) {
+            case 0: stats->errors++; continue;
+            case 200: stats->ok++; break;
+            case 304: stats->not_modified++; break;
+            case 503: stats->unavailable++; break;
+            default: stats->other++; break;
+            }
+            stats->bytes += s->bytes;
+            latencies[n++] = s->latency_us;
+        }
+    }
+    if (n > 0) {
+        qsort(latencies, n, sizeof(uint32_t), compare_u32);
+        stats->p50 = percentile(latencies, n, 50);
+        stats->p95 = percentile(latencies, n, 95);
+        stats->p99 = percentile(latencies, n, 99);
+        stats->max = latencies[n - 1];
+    }
+    free(latencies);
+}
+
+static void print_row(const char *name, const route_stats_t *s, double seconds) {
+    printf("%-16s %8zu %9.1f %7zu %6zu %6zu %6zu %6zu %8.2f %9.2f %9.2f %9.2f %9.2f\n",
+           name, s->requests, s->requests / seconds, s->ok, s->not_modified, s->unavailable,
+           s->other, s->errors, s->bytes / seconds / 1e6, s->p50 / 1000.0, s->p95 / 1000.0,
+           s->p99 / 1000.0, s->max / 1000.0);
+}
+
+static void print_json(const char *name, const route_stats_t *s, double seconds, bool last) {
+    printf("{\"route\":\"%s\",\"requests\":%zu,\"rps\":%.1f,\"ok\":%zu,\"not_modified\":%zu,"
+           "\"unavailable\":%zu,\"other\":%zu,\"errors\":%zu,\"mbps\":%.2f,"
+           "\"p50_us\":%u,\"p95_us\":%u,\"p99_us\":%u,\"max_us\":%u}%s",
+           name, s->requests, s->requests / seconds, s->ok, s->not_modified, s->unavailable,
+           s->other, s->errors, s->bytes / seconds / 1e6, s->p50, s->p95, s->p99, s->max,
+           last ? "" : ",");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [-h host] [-p puerto] [-c conexiones] [-d s] [-w s] [-m mezcla] [-k] [-e] [-j]\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *host = "127.0.0.1";
+    const char *port = "8080";
+    const char *mix = "/status";
+    int connections = 8;
+    unsigned duration_s = 10;
+    unsigned warmup_s = 1;
+    bool json = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h:p:c:d:w:m:kej")) != -1) {
+        switch (opt) {
+        case 'h': host = optarg; break;
+        case 'p': port = optarg; break;
+        case 'c': connections = atoi(optarg); break;
+        case 'd': duration_s = (unsigned)atoi(optarg); break;
+        case 'w': warmup_s = (unsigned)atoi(optarg); break;
+        case 'm': mix = optarg; break;
+        case 'k': keep_alive = false; break;
+        case 'e': conditional = true; break;
+        case 'j': json = true; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (connections < 1 || connections > MAX_CONNECTIONS || duration_s == 0 || !parse_mix(mix)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addr = NULL;
+    if (getaddrinfo(host, port, &hints, &addr) != 0 || addr == NULL) {
+        fprintf(stderr, "No se resuelve %s:%s\n", host, port);
+        return 1;
+    }
+    memcpy(&server_addr, addr->ai_addr, addr->ai_addrlen);
+    server_addr_len = addr->ai_addrlen;
+    freeaddrinfo(addr);
+    snprintf(host_header, sizeof(host_header), "%s:%s", host, port);
+
+    client_t *clients = calloc((size_t)connections, sizeof(client_t));
+    if (clients == NULL) {
+        return 1;
+    }
+    measure_start_us = now_us() + (uint64_t)warmup_s * 1000000;
+    measure_end_us = measure_start_us + (uint64_t)duration_s * 1000000;
+    for (int c = 0; c < connections; c++) {
+        clients[c].seed = 0x9E3779B9u * (uint32_t)(c + 1);
+        clients[c].conn.fd = -1;
+        if (pthread_create(&clients[c].thread, NULL, client_thread, &clients[c]) != 0) {
+            fprintf(stderr, "No se pudo crear el hilo %d\n", c);
+            return 1;
+        }
+    }
+    for (int c = 0; c < connections; c++) {
+        pthread_join(clients[c].thread, NULL);
+    }
+
+    double seconds = duration_s;
+    route_stats_t stats[MAX_ROUTES + 1];
+    for (int r = 0; r < route_count; r++) {
+        route_stats(clients, connections, r, &stats[r]);
+    }
+    route_stats(clients, connections, -1, &stats[route_count]);
+
+    printf("== %d conexiones%s%s, %us (+%us de calentamiento), mezcla %s\n", connections,
+           keep_alive ? " keep-alive" : " sin keep-alive", conditional ? ", If-None-Match" : "",
+           duration_s, warmup_s, mix);
+    printf("%-16s %8s %9s %7s %6s %6s %6s %6s %8s %9s %9s %9s %9s\n", "ruta", "peticion", "req/s",
+           "200", "304", "503", "otros", "error", "MB/s", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (int r = 0; r < route_count; r++) {
+        print_row(routes[r].path, &stats[r], seconds);
+    }
+    if (route_count > 1) {
+        print_row("total", &stats[route_count], seconds);
+    }
+    if (json) {
+        printf("{\"connections\":%d,\"duration_s\":%u,\"keep_alive\":%s,\"conditional\":%s,\"routes\":[",
+               connections, duration_s, keep_alive ? "true" : "false", conditional ? "true" : "false");
+        for (int r = 0; r < route_count; r++) {
+            print_json(routes[r].path, &stats[r], seconds, false);
+        }
+        print_json("total", &stats[route_count], seconds, true);
+        printf("]}\n");
+    }
+
+    for (int c = 0; c < connections; c++) {
+        free(clients[c].samples);
+    }
+    free(clients);
+    return 0;
+}
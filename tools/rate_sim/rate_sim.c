@@ -0,0 +1,256 @@
+// rate_sim.c - Simulación de host del controlador de tamaño JPEG (rate_control)
+//
+// Uso: rate_sim [opciones] curvas.csv
+//   -t bytes     Objetivo de bytes por frame (por defecto el de RATE_CONTROL_DEFAULT_CONFIG)
+//   -r bytes/s   Objetivo de bytes por segundo (0 = desactivado)
+//   -i ms        Intervalo entre frames (por defecto 500 ms)
+//   -d pct       Banda muerta (histéresis) en porcentaje
+//   -g ganancia  Unidades de calidad por unidad de error logarítmico
+//   -q calidad   Calidad inicial (por defecto 12, la de CAMERA_DEFAULT_CONFIG)
+//   -l           Permitir bajar/subir resolución (VGA, SVGA, HD)
+//   -v           Traza por frame
+//
+// Reproduce las curvas tamaño-calidad de cada escena: el tamaño de cada frame se
+// interpola en escala logarítmica entre las calidades medidas y se le añade ruido.
+// Como en la cámara, un cambio de calidad solo afecta a los frames siguientes al
+// que ya estaba en el buffer del driver.
+#include "rate_control.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_POINTS      16
+#define MAX_SEGMENTS    32
+#define PIPELINE_FRAMES 1      // Frames ya capturados con la configuración anterior
+
+// Valores de framesize_t usados por la escalera de resoluciones
+#define FS_VGA  8
+#define FS_SVGA 9
+#define FS_HD   11
+
+typedef struct {
+    char name[32];
+    int frames;
+    float noise_pct;
+    float sizes[MAX_POINTS];
+} segment_t;
+
+typedef struct {
+    int qualities[MAX_POINTS];
+    int point_count;
+    segment_t segments[MAX_SEGMENTS];
+    int segment_count;
+} curves_t;
+
+static uint32_t rng_state = 12345;
+
+static float noise_uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+static int load_curves(const char *path, curves_t *curves) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char line[512];
+    bool header = false;
+    memset(curves, 0, sizeof(*curves));
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        char *save = NULL;
+        char *tok = strtok_r(line, ",\n", &save);
+        if (!header) {
+            // escena,frames,ruido_pct,q1,q2,...
+            strtok_r(NULL, ",\n", &save);
+            strtok_r(NULL, ",\n", &save);
+            while ((tok = strtok_r(NULL, ",\n", &save)) && curves->point_count < MAX_POINTS) {
+                curves->qualities[curves->point_count++] = atoi(tok);
+            }
+            header = true;
+            continue;
+        }
+        if (curves->segment_count == MAX_SEGMENTS) {
+            break;
+        }
+        segment_t *seg = &curves->segments[curves->segment_count];
+        snprintf(seg->name, sizeof(seg->name), "%s", tok);
+        seg->frames = atoi(strtok_r(NULL, ",\n", &save));
+        seg->noise_pct = atof(strtok_r(NULL, ",\n", &save));
+        for (int i = 0; i < curves->point_count; i++) {
+            tok = strtok_r(NULL, ",\n", &save);
+            if (tok == NULL) {
+                fclose(f);
+                return -1;
+            }
+            seg->sizes[i] = atof(tok);
+        }
+        curves->segment_count++;
+    }
+    fclose(f);
+    return curves->point_count >= 2 && curves->segment_count > 0 ? 0 : -1;
+}
+
+// Tamaño para una calidad: interpolación lineal del logaritmo entre puntos medidos
+static float size_at(const curves_t *curves, const segment_t *seg, int quality) {
+    int n = curves->point_count;
+    if (quality <= curves->qualities[0]) {
+        return seg->sizes[0];
+    }
+    if (quality >= curves->qualities[n - 1]) {
+        return seg->sizes[n - 1];
+    }
+    int i = 1;
+    while (curves->qualities[i] < quality) {
+        i++;
+    }
+    float t = (float)(quality - curves->qualities[i - 1]) / (curves->qualities[i] - curves->qualities[i - 1]);
+    return expf(logf(seg->sizes[i - 1]) * (1 - t) + logf(seg->sizes[i]) * t);
+}
+
+static uint32_t step_pixels(const rate_control_config_t *config, int16_t frame_size) {
+    for (int i = 0; i < config->step_count; i++) {
+        if (config->steps[i].frame_size == frame_size) {
+            return config->steps[i].pixels;
+        }
+    }
+    return 1280 * 720;
+}
+
+int main(int argc, char **argv) {
+    rate_control_config_t config = RATE_CONTROL_DEFAULT_CONFIG();
+    int interval_ms = 500;
+    int quality = 12;
+    bool verbose = false;
+    int opt = 1;
+
+    for (; opt < argc && argv[opt][0] == '-'; opt++) {
+        char flag = argv[opt][1];
+        if (flag == 'v') {
+            verbose = true;
+            continue;
+        }
+        if (flag == 'l') {
+            config.step_count = 3;
+            config.steps[0] = (rate_control_step_t){ FS_VGA, 640 * 480 };
+            config.steps[1] = (rate_control_step_t){ FS_SVGA, 800 * 600 };
+            config.steps[2] = (rate_control_step_t){ FS_HD, 1280 * 720 };
+            continue;
+        }
+        if (opt + 1 >= argc) {
+            break;
+        }
+        const char *value = argv[++opt];
+        switch (flag) {
+            case 't': config.target_bytes = atoi(value); break;
+            case 'r': config.target_bytes_per_sec = atoi(value); break;
+            case 'i': interval_ms = atoi(value); break;
+            case 'd': config.deadband_pct = atoi(value); break;
+            case 'g': config.gain = atof(value); break;
+            case 'q': quality = atoi(value); break;
+            default: opt = argc; break;
+        }
+    }
+    if (opt != argc - 1) {
+        fprintf(stderr, "Uso: %s [-t bytes] [-r bytes/s] [-i ms] [-d pct] [-g ganancia] [-q calidad] "
+                "[-l] [-v] curvas.csv\n", argv[0]);
+        return 2;
+    }
+
+    static curves_t curves;
+    if (load_curves(argv[opt], &curves) != 0) {
+        fprintf(stderr, "No se pudieron leer las curvas de %s\n", argv[opt]);
+        return 1;
+    }
+
+    rate_control_t rc;
+    if (rate_control_init(&rc, &config) != ESP_OK) {
+        fprintf(stderr, "Configuración inválida\n");
+        return 1;
+    }
+
+    // Configuración aplicada en la cámara y la de los frames que aún están en el pipeline
+    int16_t frame_size = FS_HD;
+    int16_t pipeline_quality[PIPELINE_FRAMES + 1];
+    int16_t pipeline_size[PIPELINE_FRAMES + 1];
+    for (int i = 0; i <= PIPELINE_FRAMES; i++) {
+        pipeline_quality[i] = (int16_t)quality;
+        pipeline_size[i] = frame_size;
+    }
+
+    uint64_t now = 0;
+    printf("%-12s %6s %10s %10s %8s %8s %8s %8s\n", "escena", "frames", "media (B)", "error med",
+           "exceso", "cambios", "calidad", "resoluc.");
+
+    double total_bytes = 0;
+    uint32_t total_frames = 0;
+    for (int s = 0; s < curves.segment_count; s++) {
+        const segment_t *seg = &curves.segments[s];
+        double seg_bytes = 0;
+        double seg_error = 0;
+        uint32_t over = 0;
+        uint32_t changes = rc.stats.quality_changes + rc.stats.frame_size_changes;
+
+        for (int n = 0; n < seg->frames; n++) {
+            now += (uint64_t)interval_ms * 1000;
+
+            // El frame sale con la configuración más antigua del pipeline
+            int16_t q_used = pipeline_quality[0];
+            float scale = (float)step_pixels(&config, pipeline_size[0]) / (1280 * 720);
+            float size = size_at(&curves, seg, q_used) * scale * (1.0f + seg->noise_pct / 100.0f * noise_uniform());
+
+            rate_control_sample_t sample = {
+                .size = (size_t)size,
+                .timestamp = now,
+                .quality = (int16_t)quality,
+                .frame_size = frame_size,
+            };
+            rate_control_decision_t decision;
+            rate_control_update(&rc, &sample, &decision);
+
+            if (decision.budget > 0) {
+                seg_error += fabs(size - decision.budget) / decision.budget;
+                if (size > decision.budget * (1.0f + config.deadband_pct / 100.0f)) {
+                    over++;
+                }
+            }
+            seg_bytes += size;
+
+            if (verbose) {
+                printf("  %-10s t=%7.1fs q=%2d fs=%2d %7.0f B presupuesto=%6lu%s\n", seg->name, now / 1e6,
+                       q_used, pipeline_size[0], size, (unsigned long)decision.budget,
+                       decision.changed ? " -> ajuste" : "");
+            }
+
+            if (decision.changed) {
+                quality = decision.quality;
+                frame_size = decision.frame_size;
+            }
+            for (int i = 0; i < PIPELINE_FRAMES; i++) {
+                pipeline_quality[i] = pipeline_quality[i + 1];
+                pipeline_size[i] = pipeline_size[i + 1];
+            }
+            pipeline_quality[PIPELINE_FRAMES] = (int16_t)quality;
+            pipeline_size[PIPELINE_FRAMES] = frame_size;
+        }
+
+        total_bytes += seg_bytes;
+        total_frames += seg->frames;
+        printf("%-12s %6d %10.0f %9.1f%% %8lu %8lu %8d %8d\n", seg->name, seg->frames,
+               seg_bytes / seg->frames, 100.0 * seg_error / seg->frames, (unsigned long)over,
+               (unsigned long)(rc.stats.quality_changes + rc.stats.frame_size_changes - changes),
+               quality, frame_size);
+    }
+
+    printf("\nTotal: %lu frames, media %.0f B/frame (%.0f B/s), presupuesto %lu B, "
+           "límite duro superado %lu veces\n",
+           (unsigned long)total_frames, total_bytes / total_frames,
+           total_bytes / total_frames * 1000.0 / interval_ms, (unsigned long)rc.stats.budget,
+           (unsigned long)rc.stats.hard_limit_hits);
+    return 0;
+}
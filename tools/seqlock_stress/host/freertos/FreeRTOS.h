@@ -0,0 +1,23 @@
+// FreeRTOS.h - Sustituto mínimo para compilar seqlock en el host (Linux)
+// portMUX es un spinlock; en el host no hay interrupciones que enmascarar
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+typedef struct {
+    volatile int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+static inline void portENTER_CRITICAL(portMUX_TYPE *mux) {
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&mux->locked, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static inline void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,220 @@
+// seqlock_stress.c - Prueba de estrés de host del seqlock con hilos de pthreads
+//
+// Uso: seqlock_stress [opciones]
+//   -r n         Hilos lectores (por defecto 4)
+//   -w n         Hilos escritores (por defecto 2; se serializan en la sección crítica)
+//   -n n         Escrituras por escritor (por defecto 2000000)
+//   -s palabras  Tamaño de la instantánea en palabras de 32 bits (por defecto 16, 2-64)
+//   -m modo      seqlock (por defecto), mutex (pthread_mutex como el state_mutex anterior)
+//                o none (copia sin protección: debe detectar lecturas incoherentes)
+//
+// Cada escritura rellena la instantánea con valores derivados de una versión creciente y
+// una suma de control; cada lectura comprueba la suma y que la versión no retrocede.
+// Termina con código 1 si algún lector vio una instantánea incoherente (salvo -m none).
+#include "seqlock.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_WORDS       64
+#define MAX_THREADS     32
+
+typedef enum {
+    MODE_SEQLOCK,
+    MODE_MUTEX,
+    MODE_NONE
+} stress_mode_t;
+
+typedef struct {
+    uint32_t version;
+    uint32_t words[MAX_WORDS];
+    uint64_t check;
+} snapshot_t;
+
+// Resultado de cada lector
+typedef struct {
+    uint64_t reads;
+    uint64_t retries;
+    uint64_t torn;
+    uint64_t backwards;
+} reader_result_t;
+
+static snapshot_t shared;
+static seqlock_t shared_lock = SEQLOCK_INIT();
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static stress_mode_t mode = MODE_SEQLOCK;
+static int words = 16;
+static long writes_per_writer = 2000000;
+static volatile int writers_running = 0;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill_snapshot(volatile snapshot_t *s, uint32_t version) {
+    uint64_t sum = version;
+    s->version = version;
+    for (int i = 0; i < words; i++) {
+        uint32_t value = version * 2654435761u + (uint32_t)i;
+        s->words[i] = value;
+        sum += value;
+    }
+    s->check = sum;
+}
+
+static int snapshot_consistent(const snapshot_t *s) {
+    uint64_t sum = s->version;
+    for (int i = 0; i < words; i++) {
+        if (s->words[i] != s->version * 2654435761u + (uint32_t)i) {
+            return 0;
+        }
+        sum += s->words[i];
+    }
+    return sum == s->check;
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+
+    for (long n = 0; n < writes_per_writer; n++) {
+        switch (mode) {
+            case MODE_SEQLOCK:
+                seqlock_write_begin(&shared_lock);
+                fill_snapshot(&shared, shared.version + 1);
+                seqlock_write_end(&shared_lock);
+                break;
+            case MODE_MUTEX:
+                pthread_mutex_lock(&shared_mutex);
+                fill_snapshot(&shared, shared.version + 1);
+                pthread_mutex_unlock(&shared_mutex);
+                break;
+            case MODE_NONE:
+                // Los escritores se serializan igualmente: solo los lectores van sin protección
+                portENTER_CRITICAL(&shared_lock.writer);
+                fill_snapshot((volatile snapshot_t *)&shared, shared.version + 1);
+                portEXIT_CRITICAL(&shared_lock.writer);
+                break;
+        }
+    }
+
+    __atomic_fetch_sub(&writers_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    reader_result_t *result = arg;
+    uint32_t last_version = 0;
+    snapshot_t copy;
+
+    while (__atomic_load_n(&writers_running, __ATOMIC_ACQUIRE) > 0) {
+        switch (mode) {
+            case MODE_SEQLOCK:
+                result->retries += seqlock_read(&shared_lock, &copy, &shared, sizeof(copy));
+                break;
+            case MODE_MUTEX:
+                pthread_mutex_lock(&shared_mutex);
+                memcpy(&copy, &shared, sizeof(copy));
+                pthread_mutex_unlock(&shared_mutex);
+                break;
+            case MODE_NONE:
+                memcpy(&copy, (const void *)&shared, sizeof(copy));
+                break;
+        }
+        if (!snapshot_consistent(&copy)) {
+            result->torn++;
+        } else if (copy.version < last_version) {
+            result->backwards++;
+        }
+        last_version = copy.version;
+        result->reads++;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int readers = 4;
+    int writers = 2;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:w:n:s:m:")) != -1) {
+        switch (opt) {
+            case 'r': readers = atoi(optarg); break;
+            case 'w': writers = atoi(optarg); break;
+            case 'n': writes_per_writer = atol(optarg); break;
+            case 's': words = atoi(optarg); break;
+            case 'm':
+                if (strcmp(optarg, "seqlock") == 0) {
+                    mode = MODE_SEQLOCK;
+                } else if (strcmp(optarg, "mutex") == 0) {
+                    mode = MODE_MUTEX;
+                } else if (strcmp(optarg, "none") == 0) {
+                    mode = MODE_NONE;
+                } else {
+                    fprintf(stderr, "Modo desconocido: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "uso: %s [-r lectores] [-w escritores] [-n escrituras] [-s palabras] "
+                        "[-m seqlock|mutex|none]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (readers < 1 || writers < 1 || readers + writers > MAX_THREADS ||
+        writes_per_writer < 1 || words < 2 || words > MAX_WORDS) {
+        fprintf(stderr, "Configuración inválida (1-%d hilos, 2-%d palabras)\n", MAX_THREADS, MAX_WORDS);
+        return 1;
+    }
+
+    static const char *mode_names[] = { "seqlock", "mutex", "none" };
+    printf("seqlock_stress: %s, %d lectores, %d escritores x %ld escrituras, %d palabras\n",
+           mode_names[mode], readers, writers, writes_per_writer, words);
+    fflush(stdout);
+
+    fill_snapshot(&shared, 0);
+    pthread_t tids[MAX_THREADS];
+    reader_result_t results[MAX_THREADS];
+    memset(results, 0, sizeof(results));
+
+    double start = now_s();
+    writers_running = writers;
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&tids[i], NULL, reader_thread, &results[i]);
+    }
+    for (int i = 0; i < writers; i++) {
+        pthread_create(&tids[readers + i], NULL, writer_thread, NULL);
+    }
+    for (int i = 0; i < readers + writers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double elapsed = now_s() - start;
+
+    reader_result_t total = {0};
+    for (int i = 0; i < readers; i++) {
+        total.reads += results[i].reads;
+        total.retries += results[i].retries;
+        total.torn += results[i].torn;
+        total.backwards += results[i].backwards;
+    }
+    long expected = writers * writes_per_writer;
+
+    printf("%.2f s: %.1f M escrituras/s, %.1f M lecturas/s (%llu lecturas)\n",
+           elapsed, expected / elapsed / 1e6, total.reads / elapsed / 1e6,
+           (unsigned long long)total.reads);
+    printf("repetidas: %llu (%.3f%%), incoherentes: %llu, versión hacia atrás: %llu\n",
+           (unsigned long long)total.retries,
+           total.reads ? 100.0 * total.retries / total.reads : 0.0,
+           (unsigned long long)total.torn, (unsigned long long)total.backwards);
+
+    int failed = (long)shared.version != expected || !snapshot_consistent(&shared);
+    if (mode != MODE_NONE) {
+        failed |= total.torn > 0 || total.backwards > 0;
+    }
+    printf("%s\n", failed ? "FALLO" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+# load_test.sh - Carga de /stream con clientes curl rápidos, lentos y sobrantes
+#
+# Uso: load_test.sh ruta/a/stream_bench [secuencia/]
+# Variables: FAST (clientes curl), SLOW (slow_client.py a SLOW_RATE bytes/s), EXTRA (por encima
+# de max_clients: deben recibir 503), DURATION (s), FPS, SOURCE_FPS, PORT
+set -e
+
+BIN=${1:?uso: load_test.sh stream_bench [secuencia/]}
+SEQ=${2:-$(dirname "$0")/../dedupe_bench/sequences/nest_day}
+FAST=${FAST:-24}
+SLOW=${SLOW:-8}
+EXTRA=${EXTRA:-4}
+DURATION=${DURATION:-20}
+FPS=${FPS:-5}
+SOURCE_FPS=${SOURCE_FPS:-15}
+SLOW_RATE=${SLOW_RATE:-8000}
+PORT=${PORT:-8080}
+URL=http://127.0.0.1:$PORT
+OUT=$(mktemp -d)
+
+"$BIN" -p "$PORT" -c $((FAST + SLOW)) -f "$FPS" -s "$SOURCE_FPS" -t $((DURATION + 4)) "$SEQ" > "$OUT/server.log" &
+SERVER=$!
+sleep 1
+
+i=0
+while [ $i -lt "$FAST" ]; do
+    curl -s -N --max-time "$DURATION" -o "$OUT/fast_$i.mjpeg" "$URL/stream" &
+    i=$((i + 1))
+done
+i=0
+while [ $i -lt "$SLOW" ]; do
+    python3 "$(dirname "$0")/slow_client.py" "$URL/stream" "$SLOW_RATE" "$DURATION" > "$OUT/slow_$i.txt" &
+    i=$((i + 1))
+done
+sleep 2
+
+i=0
+while [ $i -lt "$EXTRA" ]; do
+    curl -s -o /dev/null -w "%{http_code}\n" "$URL/stream" >> "$OUT/extra.txt"
+    i=$((i + 1))
+done
+
+sleep $((DURATION - 4))
+curl -s "$URL/stats" > "$OUT/stats.json"
+wait $(jobs -p | grep -v "^$SERVER$") 2>/dev/null || true
+wait "$SERVER" || true
+
+# Frames recibidos por cliente: delimitadores del multipart en la salida de curl
+count_frames() {
+    for f in "$@"; do
+        grep -a -c "^--coopframe" "$f" || true
+    done
+}
+
+summary() {
+    label=$1
+    sort -n | awk -v label="$label" -v d="$DURATION" '
+        { v[NR] = $1; s += $1 }
+        END { if (NR) printf "%-8s %3d clientes  frames/cliente min %4d  mediana %4d  max %4d  (%.2f fps medios)\n",
+                             label, NR, v[1], v[int((NR + 1) / 2)], v[NR], s / NR / d }'
+}
+
+echo "== $FAST rápidos + $SLOW lentos ($SLOW_RATE B/s) durante ${DURATION}s, stream a $FPS fps, fuente a $SOURCE_FPS fps"
+count_frames "$OUT"/fast_*.mjpeg | summary rapidos
+[ "$SLOW" -gt 0 ] && cat "$OUT"/slow_*.txt | summary lentos
+echo "sobrantes: $(sort "$OUT/extra.txt" 2>/dev/null | uniq -c | awk '{printf "%s x HTTP %s  ", $1, $2}')"
+tail -n 1 "$OUT/server.log"
+echo "/stats a los $((DURATION - 2))s:"
+cat "$OUT/stats.json"
+echo
+rm -rf "$OUT"
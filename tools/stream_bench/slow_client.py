@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+# slow_client.py - Cliente de /stream que lee a ritmo limitado con un buffer de recepción pequeño
+#
+# Uso: slow_client.py URL bytes_por_segundo duración_s
+#
+# Con curl --limit-rate en loopback los frames se acumulan en el buffer de recepción del
+# cliente (el kernel lo amplía a cientos de KB) y el servidor nunca ve al cliente lento.
+# En una red real el cuello de botella es el enlace y el retraso llega al emisor; aquí se
+# reproduce con SO_RCVBUF pequeño. Imprime los frames recibidos.
+import socket
+import sys
+import time
+from urllib.parse import urlparse
+
+url = urlparse(sys.argv[1])
+rate = int(sys.argv[2])
+duration = float(sys.argv[3])
+
+sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+sock.connect((url.hostname, url.port or 80))
+sock.sendall(f"GET {url.path} HTTP/1.1\r\nHost: {url.hostname}\r\n\r\n".encode())
+
+boundary = b"\n--coopframe\r\n"
+frames = 0
+tail = b"\n"
+start = time.monotonic()
+chunk = max(rate // 20, 1)
+
+while time.monotonic() - start < duration:
+    data = sock.recv(chunk)
+    if not data:
+        break
+    window = tail + data
+    frames += window.count(boundary)
+    tail = window[-(len(boundary) - 1):]
+    time.sleep(len(data) / rate)
+
+sock.close()
+print(frames)
@@ -0,0 +1,367 @@
+// stream_bench.c - Servidor MJPEG de host para probar /stream con carga real
+//
+// Uso: stream_bench [opciones] secuencia/
+//   -p puerto    Puerto TCP (por defecto 8080)
+//   -c n         Clientes simultáneos (stream_max_clients)
+//   -f fps       Frames por segundo por cliente (stream_fps)
+//   -s fps       Frames por segundo de la fuente falsa (la cámara)
+//   -b bytes     SO_SNDBUF de cada socket (por defecto 5744, el TCP_SND_BUF de lwIP)
+//   -t s         Terminar tras s segundos (0 = hasta Ctrl+C)
+//
+// Reproduce el bucle de stream_client_task() de web_server.c sobre sockets POSIX: un
+// hilo por cliente, el registro de mjpeg_stream.c bajo un mutex y una fuente que publica
+// los JPEGs de la secuencia en bucle. GET /stats devuelve el JSON de /status ("stream")
+// más los contadores de la fuente.
+#include "mjpeg_stream.h"
+#include <dirent.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_FRAMES          1024
+#define SEND_TIMEOUT_S      5       // send_wait_timeout de HTTPD_DEFAULT_CONFIG
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    char name[64];
+} frame_file_t;
+
+// Fuente falsa: siempre un único "último frame", como frame_store / preroll_ring
+typedef struct {
+    pthread_mutex_t lock;
+    const frame_file_t *latest;
+    uint32_t seq;
+    uint64_t timestamp;
+    uint32_t published;
+    uint32_t late_us_max;   // Retraso máximo de una publicación respecto a su instante
+} frame_source_t;
+
+static frame_file_t frames[MAX_FRAMES];
+static size_t frame_count = 0;
+static frame_source_t source = { .lock = PTHREAD_MUTEX_INITIALIZER };
+static mjpeg_stream_t stream;
+static pthread_mutex_t stream_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile sig_atomic_t running = 1;
+static int source_fps = 15;
+static int sndbuf = 5744;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(uint64_t us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static int compare_name(const void *a, const void *b) {
+    return strcmp(((const frame_file_t *)a)->name, ((const frame_file_t *)b)->name);
+}
+
+static int load_sequence(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        return -1;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && frame_count < MAX_FRAMES) {
+        size_t n = strlen(entry->d_name);
+        if (n < 4 || strcmp(entry->d_name + n - 4, ".jpg") != 0) {
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) {
+            continue;
+        }
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        frame_file_t *frame = &frames[frame_count];
+        frame->data = malloc(len);
+        if (frame->data != NULL && fread(frame->data, 1, len, f) == (size_t)len) {
+            frame->len = len;
+            snprintf(frame->name, sizeof(frame->name), "%s", entry->d_name);
+            frame_count++;
+        } else {
+            free(frame->data);
+        }
+        fclose(f);
+    }
+    closedir(d);
+    qsort(frames, frame_count, sizeof(frame_file_t), compare_name);
+    return frame_count > 0 ? 0 : -1;
+}
+
+// La cámara: publica a ritmo fijo sin esperar nunca a los clientes
+static void *source_thread(void *arg) {
+    (void)arg;
+    uint64_t period = 1000000 / source_fps;
+    uint64_t next = now_us();
+    size_t index = 0;
+
+    while (running) {
+        uint64_t t = now_us();
+        uint32_t late = t > next ? (uint32_t)(t - next) : 0;
+
+        pthread_mutex_lock(&source.lock);
+        source.latest = &frames[index];
+        source.seq++;
+        source.timestamp = t;
+        source.published++;
+        if (late > source.late_us_max) {
+            source.late_us_max = late;
+        }
+        pthread_mutex_unlock(&source.lock);
+
+        index = (index + 1) % frame_count;
+        next += period;
+        t = now_us();
+        if (next > t) {
+            sleep_us(next - t);
+        }
+    }
+    return NULL;
+}
+
+static int send_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Equivalente a httpd_resp_send_chunk(): codificación chunked de HTTP/1.1
+static int send_chunk(int fd, const void *buf, size_t len) {
+    char size_line[16];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+    if (send_all(fd, size_line, n) != 0 || send_all(fd, buf, len) != 0) {
+        return -1;
+    }
+    return send_all(fd, "\r\n", 2);
+}
+
+static void send_response(int fd, const char *status, const char *type, const char *extra, const char *body) {
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%sConnection: close\r\n\r\n",
+                     status, type, strlen(body), extra);
+    if (send_all(fd, header, n) == 0) {
+        send_all(fd, body, strlen(body));
+    }
+}
+
+static void serve_stats(int fd) {
+    static char json[64 * 1024];
+    int len = snprintf(json, sizeof(json), "{\"source\":{");
+
+    pthread_mutex_lock(&source.lock);
+    len += snprintf(json + len, sizeof(json) - len, "\"published\":%lu,\"fps\":%d,\"late_us_max\":%lu},\"stream\":",
+                    (unsigned long)source.published, source_fps, (unsigned long)source.late_us_max);
+    pthread_mutex_unlock(&source.lock);
+
+    pthread_mutex_lock(&stream_lock);
+    len += mjpeg_stream_stats_json(&stream, json + len, sizeof(json) - len);
+    pthread_mutex_unlock(&stream_lock);
+
+    if (len < (int)sizeof(json) - 1) {
+        json[len++] = '}';
+        json[len] = '\0';
+    }
+    send_response(fd, "200 OK", "application/json", "", json);
+}
+
+// Bucle de stream_client_task() con la fuente falsa
+static void serve_stream(int fd) {
+    pthread_mutex_lock(&stream_lock);
+    mjpeg_client_t *client = mjpeg_stream_claim(&stream, now_us());
+    uint32_t period_us = mjpeg_stream_period_us(&stream);
+    pthread_mutex_unlock(&stream_lock);
+
+    if (client == NULL) {
+        send_response(fd, "503 Service Unavailable", "text/plain", "Retry-After: 5\r\n",
+                      "Stream ocupado, reintentar más tarde");
+        return;
+    }
+
+    const char *header =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: " MJPEG_STREAM_CONTENT_TYPE "\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+        "\r\n";
+    uint64_t last_timestamp = 0;
+    int ok = send_all(fd, header, strlen(header)) == 0;
+
+    while (ok && running) {
+        uint64_t tick_start = now_us();
+
+        pthread_mutex_lock(&source.lock);
+        uint32_t published = source.published;
+        const frame_file_t *frame = source.latest;
+        uint32_t seq = source.seq;
+        uint64_t timestamp = source.timestamp;
+        pthread_mutex_unlock(&source.lock);
+
+        pthread_mutex_lock(&stream_lock);
+        bool fresh = mjpeg_client_has_new(client, published);
+        pthread_mutex_unlock(&stream_lock);
+
+        if (fresh && frame != NULL && timestamp > last_timestamp) {
+            char part[MJPEG_STREAM_PART_HEADER_MAX];
+            int len = mjpeg_stream_part_header(part, sizeof(part), frame->len, timestamp, seq);
+            last_timestamp = timestamp;
+
+            ok = send_chunk(fd, part, len) == 0 &&
+                 send_chunk(fd, frame->data, frame->len) == 0 &&
+                 send_chunk(fd, "\r\n", 2) == 0;
+            if (!ok) {
+                break;
+            }
+
+            uint32_t send_us = (uint32_t)(now_us() - tick_start);
+            pthread_mutex_lock(&stream_lock);
+            mjpeg_client_account(client, published, period_us, frame->len, send_us);
+            pthread_mutex_unlock(&stream_lock);
+        }
+
+        uint64_t elapsed = now_us() - tick_start;
+        sleep_us(elapsed < period_us ? period_us - elapsed : 1000);
+    }
+
+    pthread_mutex_lock(&stream_lock);
+    mjpeg_client_t copy = *client;
+    mjpeg_stream_release(&stream, client);
+    pthread_mutex_unlock(&stream_lock);
+
+    printf("cliente #%lu: %lu enviados, %lu perdidos, %lu omitidos, envío máx. %lu us\n",
+           (unsigned long)copy.id, (unsigned long)copy.stats.sent, (unsigned long)copy.stats.dropped,
+           (unsigned long)copy.stats.skipped, (unsigned long)copy.stats.max_send_us);
+}
+
+static void *connection_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char request[1024];
+    ssize_t n = recv(fd, request, sizeof(request) - 1, 0);
+
+    if (n > 0) {
+        request[n] = '\0';
+        if (strncmp(request, "GET /stream ", 12) == 0) {
+            serve_stream(fd);
+        } else if (strncmp(request, "GET /stats ", 11) == 0) {
+            serve_stats(fd);
+        } else {
+            send_response(fd, "404 Not Found", "text/plain", "", "No encontrado");
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+int main(int argc, char **argv) {
+    mjpeg_stream_config_t config = MJPEG_STREAM_DEFAULT_CONFIG();
+    int port = 8080;
+    int duration_s = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:c:f:s:b:t:")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'c': config.max_clients = (uint8_t)atoi(optarg); break;
+            case 'f': config.fps = (uint8_t)atoi(optarg); break;
+            case 's': source_fps = atoi(optarg); break;
+            case 'b': sndbuf = atoi(optarg); break;
+            case 't': duration_s = atoi(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-p puerto] [-c clientes] [-f fps] [-s fps_fuente] [-b sndbuf] [-t s] secuencia/\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc || load_sequence(argv[optind]) != 0) {
+        fprintf(stderr, "Sin JPEGs en la secuencia\n");
+        return 1;
+    }
+    if (source_fps <= 0 || mjpeg_stream_init(&stream, &config) != ESP_OK) {
+        fprintf(stderr, "Configuración inválida (1-%d clientes, 1-%d fps)\n",
+                MJPEG_STREAM_MAX_CLIENTS, MJPEG_STREAM_MAX_FPS);
+        return 1;
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 64) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGALRM, &sa, NULL);
+    if (duration_s > 0) {
+        alarm(duration_s);
+    }
+
+    pthread_t source_tid;
+    pthread_create(&source_tid, NULL, source_thread, NULL);
+    printf("stream_bench: %zu frames, fuente %d fps, %u clientes a %u fps, puerto %d\n",
+           frame_count, source_fps, config.max_clients, config.fps, port);
+    fflush(stdout);
+
+    while (running) {
+        int fd = accept(server, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        struct timeval timeout = { .tv_sec = SEND_TIMEOUT_S };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, connection_thread, (void *)(intptr_t)fd) == 0) {
+            pthread_detach(tid);
+        } else {
+            close(fd);
+        }
+    }
+
+    pthread_join(source_tid, NULL);
+    close(server);
+
+    // Dar tiempo a los hilos de cliente para ver running = 0 e imprimir sus contadores
+    sleep_us(2 * 1000000);
+    pthread_mutex_lock(&source.lock);
+    printf("fuente: %lu frames publicados, retraso máximo %lu us\n",
+           (unsigned long)source.published, (unsigned long)source.late_us_max);
+    pthread_mutex_unlock(&source.lock);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# admission_clients.py - Clientes legítimos y abusivos a la vez contra /photo
+#
+# Uso: admission_clients.py URL duración_s legítimos recargas ociosos
+#
+# Cada grupo sale de su propia dirección de loopback (127.0.0.0/8 entera es local en
+# Linux), como dispositivos distintos de la red del gallinero:
+# - legítimos: uno por dirección (127.0.0.10, .11...), piden /photo cada 3 s como app.js;
+# - recargas: hilos desde 127.0.0.2 que piden /photo sin pausa e ignoran Retry-After;
+# - ociosos: sockets desde 127.0.0.3 que se conectan y no envían nada (pestañas con
+#   keep-alive); si el servidor los cierra se vuelven a abrir.
+# Imprime una línea por grupo: peticiones, 200, 503, sin respuesta y, para los legítimos,
+# latencia p50/p99 de las respuestas 200 en ms.
+import socket
+import sys
+import threading
+import time
+from urllib.parse import urlparse
+
+url = urlparse(sys.argv[1])
+duration = float(sys.argv[2])
+honest = int(sys.argv[3])
+reloaders = int(sys.argv[4])
+idle = int(sys.argv[5])
+
+INTERVAL = 3.0
+TIMEOUT = 10.0
+server = (url.hostname, url.port or 80)
+start = time.monotonic()
+lock = threading.Lock()
+results = {"legítimos": [0, 0, 0, 0], "recargas": [0, 0, 0, 0]}
+latencies = []
+
+
+def running():
+    return time.monotonic() - start < duration
+
+
+def fetch(source):
+    """GET /photo desde source; devuelve (código, segundos) o (None, segundos)."""
+    t0 = time.monotonic()
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.settimeout(TIMEOUT)
+    try:
+        sock.bind((source, 0))
+        sock.connect(server)
+        sock.sendall(f"GET {url.path} HTTP/1.1\r\nHost: {url.hostname}\r\n\r\n".encode())
+        data = sock.recv(4096)
+        code = int(data.split(b" ", 2)[1]) if data.startswith(b"HTTP/1.1 ") else None
+        while data:
+            data = sock.recv(65536)
+        return code, time.monotonic() - t0
+    except (OSError, ValueError):
+        return None, time.monotonic() - t0
+    finally:
+        sock.close()
+
+
+def account(group, code, elapsed):
+    with lock:
+        counts = results[group]
+        counts[0] += 1
+        if code == 200:
+            counts[1] += 1
+            if group == "legítimos":
+                latencies.append(elapsed * 1000)
+        elif code == 503:
+            counts[2] += 1
+        else:
+            counts[3] += 1
+
+
+def honest_client(i):
+    source = f"127.0.0.{10 + i}"
+    time.sleep(INTERVAL * i / max(honest, 1))
+    while running():
+        code, elapsed = fetch(source)
+        account("legítimos", code, elapsed)
+        if elapsed < INTERVAL:
+            time.sleep(INTERVAL - elapsed)
+
+
+def reload_client():
+    while running():
+        code, elapsed = fetch("127.0.0.2")
+        account("recargas", code, elapsed)
+
+
+def idle_client():
+    sockets = []
+    while running():
+        # Reabrir los que el servidor haya cerrado
+        alive = []
+        for sock in sockets:
+            try:
+                sock.setblocking(False)
+                if sock.recv(1) == b"":
+                    sock.close()
+                    continue
+            except BlockingIOError:
+                pass
+            except OSError:
+                sock.close()
+                continue
+            alive.append(sock)
+        sockets = alive
+        while len(sockets) < idle:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            sock.settimeout(1.0)
+            try:
+                sock.bind(("127.0.0.3", 0))
+                sock.connect(server)
+                sockets.append(sock)
+            except OSError:
+                sock.close()
+                break
+        time.sleep(0.1)
+    for sock in sockets:
+        sock.close()
+
+
+threads = [threading.Thread(target=honest_client, args=(i,)) for i in range(honest)]
+threads += [threading.Thread(target=reload_client) for _ in range(reloaders)]
+if idle > 0:
+    threads.append(threading.Thread(target=idle_client))
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+
+latencies.sort()
+
+
+def percentile(p):
+    if not latencies:
+        return 0.0
+    return latencies[min(len(latencies) - 1, (len(latencies) * p + 99) // 100 - 1)]
+
+
+for group, (total, ok, busy, failed) in results.items():
+    line = f"{group:<10} {total:5d} peticiones {ok:5d} x 200 {busy:5d} x 503 {failed:4d} sin respuesta"
+    if group == "legítimos":
+        line += f"   p50 {percentile(50):8.2f} ms  p99 {percentile(99):8.2f} ms"
+    print(line)
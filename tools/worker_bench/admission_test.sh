@@ -0,0 +1,43 @@
+#!/bin/sh
+# admission_test.sh - /photo para clientes legítimos con un cliente en bucle y sockets ociosos
+#
+# Uso: admission_test.sh ruta/a/worker_bench
+# Variables: HONEST (clientes legítimos), RELOAD (hilos en bucle desde una misma IP), IDLE
+# (sockets ociosos), SOCKETS (max_open_sockets), RATE (ráfaga:por_minuto de /photo por IP),
+# WORKERS, QUEUE, PHOTO (bytes), DURATION (s), PORT
+set -e
+
+BIN=${1:?uso: admission_test.sh worker_bench}
+HONEST=${HONEST:-6}
+RELOAD=${RELOAD:-8}
+IDLE=${IDLE:-12}
+SOCKETS=${SOCKETS:-10}
+RATE=${RATE:-10:60}
+WORKERS=${WORKERS:-2}
+QUEUE=${QUEUE:-8}
+PHOTO=${PHOTO:-100000}
+DURATION=${DURATION:-30}
+PORT=${PORT:-8080}
+URL=http://127.0.0.1:$PORT
+DIR=$(dirname "$0")
+OUT=$(mktemp -d)
+
+run() {
+    name=$1
+    shift
+    "$BIN" -p "$PORT" -w "$WORKERS" -q "$QUEUE" -s "$PHOTO" -m "$SOCKETS" -t $((DURATION + 3)) "$@" \
+        > "$OUT/server.log" &
+    server=$!
+    sleep 1
+
+    echo "-- $name"
+    python3 "$DIR/admission_clients.py" "$URL/photo" "$DURATION" "$HONEST" "$RELOAD" "$IDLE"
+    wait "$server" || true
+    tail -n 2 "$OUT/server.log"
+}
+
+echo "== $HONEST clientes legítimos (/photo cada 3 s), $RELOAD hilos en bucle y $IDLE sockets ociosos," \
+     "$SOCKETS sockets, pool x$WORKERS, ${DURATION}s"
+run "sin admisión"
+run "con admisión (LRU, $RATE por IP)" -l -r "$RATE"
+rm -rf "$OUT"
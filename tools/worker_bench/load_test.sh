@@ -0,0 +1,52 @@
+#!/bin/sh
+# load_test.sh - Latencia de /status con descargas lentas de /photo, sin pool y con pool
+#
+# Uso: load_test.sh ruta/a/worker_bench
+# Variables: SLOW (descargas lentas simultáneas a SLOW_RATE bytes/s), WORKERS (tareas del
+# pool en la segunda pasada), QUEUE, PHOTO (bytes), DURATION (s), INTERVAL (ms entre
+# sondas de /status), PORT
+set -e
+
+BIN=${1:?uso: load_test.sh worker_bench}
+SLOW=${SLOW:-3}
+SLOW_RATE=${SLOW_RATE:-25000}
+WORKERS=${WORKERS:-2}
+QUEUE=${QUEUE:-8}
+PHOTO=${PHOTO:-100000}
+DURATION=${DURATION:-30}
+INTERVAL=${INTERVAL:-100}
+PORT=${PORT:-8080}
+URL=http://127.0.0.1:$PORT
+DIR=$(dirname "$0")
+OUT=$(mktemp -d)
+
+run() {
+    workers=$1
+    "$BIN" -p "$PORT" -w "$workers" -q "$QUEUE" -s "$PHOTO" -t $((DURATION + 3)) > "$OUT/server_$workers.log" &
+    server=$!
+    sleep 1
+
+    i=0
+    while [ $i -lt "$SLOW" ]; do
+        python3 "$DIR/slow_photo.py" "$URL/photo" "$SLOW_RATE" "$DURATION" > "$OUT/slow_${workers}_$i.txt" &
+        i=$((i + 1))
+    done
+    sleep 1
+    python3 "$DIR/status_probe.py" "$URL/status" "$INTERVAL" $((DURATION - 2)) > "$OUT/probe_$workers.txt"
+    curl -s "$URL/status" > "$OUT/status_$workers.json" || true
+    wait $(jobs -p | grep -v "^$server$") 2>/dev/null || true
+    wait "$server" || true
+
+    read -r n p50 p99 max < "$OUT/probe_$workers.txt"
+    photos=$(cat "$OUT"/slow_${workers}_*.txt | awk '{ c += $1; b += $2 } END { printf "%d fotos, %d x 503", c, b }')
+    printf "%-10s /status: %4d muestras  p50 %8s ms  p99 %8s ms  max %8s ms   /photo: %s\n" \
+           "$2" "$n" "$p50" "$p99" "$max" "$photos"
+}
+
+echo "== $SLOW descargas de /photo ($PHOTO B a $SLOW_RATE B/s) durante ${DURATION}s, /status cada ${INTERVAL} ms"
+run 0 "sin pool"
+run "$WORKERS" "pool x$WORKERS"
+echo "/status con pool:"
+cat "$OUT/status_$WORKERS.json"
+echo
+rm -rf "$OUT"
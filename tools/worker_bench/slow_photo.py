@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+# slow_photo.py - Descarga /photo en bucle a ritmo limitado con un buffer de recepción pequeño
+#
+# Uso: slow_photo.py URL bytes_por_segundo duración_s
+#
+# Como en tools/stream_bench/slow_client.py, SO_RCVBUF de 4 KB hace que el retraso del
+# cliente llegue al emisor (en loopback el kernel absorbería la foto entera). Imprime las
+# descargas completas y las respuestas 503.
+import socket
+import sys
+import time
+from urllib.parse import urlparse
+
+url = urlparse(sys.argv[1])
+rate = int(sys.argv[2])
+duration = float(sys.argv[3])
+
+chunk = max(rate // 20, 1)
+start = time.monotonic()
+completed = 0
+busy = 0
+
+while time.monotonic() - start < duration:
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    sock.connect((url.hostname, url.port or 80))
+    sock.sendall(f"GET {url.path} HTTP/1.1\r\nHost: {url.hostname}\r\n\r\n".encode())
+
+    first = sock.recv(chunk)
+    if first.startswith(b"HTTP/1.1 503"):
+        busy += 1
+        sock.close()
+        time.sleep(2)
+        continue
+    data = first
+    while data and time.monotonic() - start < duration:
+        time.sleep(len(data) / rate)
+        data = sock.recv(chunk)
+    if not data:
+        completed += 1
+    sock.close()
+
+print(completed, busy)
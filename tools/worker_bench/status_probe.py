@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# status_probe.py - Mide la latencia de GET /status a intervalos fijos
+#
+# Uso: status_probe.py URL intervalo_ms duración_s
+#
+# Cada muestra va desde connect() hasta recibir la respuesta completa (el servidor cierra
+# la conexión). Imprime: muestras, p50, p99 y máximo en milisegundos.
+import socket
+import sys
+import time
+from urllib.parse import urlparse
+
+url = urlparse(sys.argv[1])
+interval = float(sys.argv[2]) / 1000
+duration = float(sys.argv[3])
+
+samples = []
+start = time.monotonic()
+
+while time.monotonic() - start < duration:
+    t0 = time.monotonic()
+    sock = socket.create_connection((url.hostname, url.port or 80), timeout=30)
+    sock.sendall(f"GET {url.path} HTTP/1.1\r\nHost: {url.hostname}\r\n\r\n".encode())
+    while sock.recv(4096):
+        pass
+    sock.close()
+    elapsed = time.monotonic() - t0
+    samples.append(elapsed * 1000)
+    if elapsed < interval:
+        time.sleep(interval - elapsed)
+
+samples.sort()
+
+
+def percentile(p):
+    return samples[min(len(samples) - 1, (len(samples) * p + 99) // 100 - 1)]
+
+
+print(f"{len(samples)} {percentile(50):.2f} {percentile(99):.2f} {samples[-1]:.2f}")
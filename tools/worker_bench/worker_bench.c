@@ -0,0 +1,444 @@
+// worker_bench.c - Servidor HTTP de host con el modelo de tareas de web_server.c
+//
+// Uso: worker_bench [opciones]
+//   -p puerto    Puerto TCP (por defecto 8080)
+//   -w n         Tareas del pool (worker_count; 0 = /photo se envía en el bucle de httpd)
+//   -q n         Peticiones en espera antes de responder 503 (worker_queue_depth)
+//   -s bytes     Tamaño de la foto (por defecto 100000, un JPEG HD típico)
+//   -b bytes     SO_SNDBUF de cada socket (por defecto 5744, el TCP_SND_BUF de lwIP)
+//   -t s         Terminar tras s segundos (0 = hasta Ctrl+C)
+//   -m n         Sockets abiertos como máximo (max_open_sockets; 0 = sin límite)
+//   -l           Con -m lleno, cerrar el socket menos reciente al aceptar (lru_purge_enable)
+//   -r b:n       Admisión por IP de /photo: ráfaga b y n por minuto (photo_burst/photo_per_minute)
+//
+// Un único hilo hace de tarea de httpd: select() sobre los sockets, lee la petición y
+// ejecuta el handler. /status se responde siempre ahí; /photo se envía ahí mismo (-w 0)
+// o se pasa a la cola de un pool de hilos que repite http_workers.c (-w N): el socket
+// sale del select() mientras el pool lo tiene, como con httpd_req_async_handler_begin().
+// GET /status devuelve los contadores del pool con el formato de "workers" en /status.
+//
+// Con -m, como httpd, el bucle deja de aceptar conexiones mientras haya tantos sockets
+// abiertos (esperando petición o en el pool); con -l acepta igualmente y cierra el que
+// lleva más tiempo esperando petición. Con -r, /photo pasa antes por rate_limit.c con la
+// dirección del cliente y, sin token, recibe 503 con Retry-After sin llegar al pool.
+#include "latency_hist.h"
+#include "rate_limit.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_WORKERS         4       // HTTP_WORKERS_MAX
+#define MAX_QUEUE           32
+#define SEND_TIMEOUT_S      5       // send_wait_timeout de HTTPD_DEFAULT_CONFIG
+
+// Petición encolada: el socket ya no lo vigila el bucle de httpd
+typedef struct {
+    int fd;
+    uint64_t queued_at;
+} work_item_t;
+
+// Pool con las mismas métricas que http_workers_stats_t
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    work_item_t items[MAX_QUEUE];
+    int head;
+    int count;
+    int depth;
+    int workers;
+    int busy;
+    int max_queued;
+    uint32_t submitted;
+    uint32_t rejected;
+    uint32_t completed;
+    uint32_t failed;
+    latency_hist_t wait;
+    latency_hist_t service;
+} work_pool_t;
+
+static work_pool_t pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .ready = PTHREAD_COND_INITIALIZER };
+static volatile sig_atomic_t running = 1;
+static uint8_t *photo = NULL;
+static size_t photo_len = 100000;
+static int sndbuf = 5744;
+
+// Admisión (sockets y cubetas por IP): solo la usa el bucle de httpd
+typedef struct {
+    int fd;
+    uint64_t since;                   // Aceptado (los sockets atienden una sola petición)
+} pending_socket_t;
+
+static int max_sockets = 0;
+static bool lru_purge = false;
+static bool limiter_enabled = false;
+static rate_limit_t limiter;
+static uint32_t purged = 0;
+static int open_sockets = 0;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int send_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int send_response(int fd, const char *status, const char *type, const char *extra,
+                         const void *body, size_t len) {
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%sConnection: close\r\n\r\n",
+                     status, type, len, extra);
+    if (send_all(fd, header, n) != 0) {
+        return -1;
+    }
+    return send_all(fd, body, len);
+}
+
+// Sockets en manos del pool (en cola o enviándose)
+static int pool_sockets(void) {
+    pthread_mutex_lock(&pool.lock);
+    int held = pool.count + pool.busy;
+    pthread_mutex_unlock(&pool.lock);
+    return held;
+}
+
+// admit_client() de web_server.c: dirección como IPv6 y 503 sin tocar el pool
+static bool admit_client(int fd) {
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+    uint8_t addr[RATE_LIMIT_ADDR_LEN] = {0};
+    uint32_t retry_after_s = 0;
+
+    if (!limiter_enabled || getpeername(fd, (struct sockaddr *)&peer, &peer_len) != 0) {
+        return true;
+    }
+    addr[10] = 0xff;
+    addr[11] = 0xff;
+    memcpy(addr + 12, &peer.sin_addr, 4);
+    if (rate_limit_allow(&limiter, addr, RATE_LIMIT_PHOTO, now_us(), &retry_after_s)) {
+        return true;
+    }
+
+    char retry_after[32];
+    snprintf(retry_after, sizeof(retry_after), "Retry-After: %u\r\n", retry_after_s);
+    const char *limited_msg = "Demasiadas peticiones desde esta dirección, reintentar más tarde";
+    send_response(fd, "503 Service Unavailable", "text/plain", retry_after, limited_msg, strlen(limited_msg));
+    close(fd);
+    return false;
+}
+
+// Handler de /photo: el envío bloqueante que motiva el pool
+static int photo_send(int fd) {
+    return send_response(fd, "200 OK", "image/jpeg", "Cache-Control: no-cache\r\n", photo, photo_len);
+}
+
+static void status_send(int fd) {
+    char json[1024];
+
+    pthread_mutex_lock(&pool.lock);
+    int len = snprintf(json, sizeof(json),
+        "{\"workers\":{\"workers\":%d,\"busy\":%d,\"queued\":%d,\"max_queued\":%d,"
+        "\"submitted\":%u,\"rejected\":%u,\"completed\":%u,\"failed\":%u,"
+        "\"wait_p50_us\":%u,\"wait_p99_us\":%u,\"wait_max_us\":%u,"
+        "\"service_p50_us\":%u,\"service_p99_us\":%u,\"service_max_us\":%u}}",
+        pool.workers, pool.busy, pool.count, pool.max_queued,
+        pool.submitted, pool.rejected, pool.completed, pool.failed,
+        latency_hist_percentile(&pool.wait, 50), latency_hist_percentile(&pool.wait, 99),
+        pool.wait.max_us,
+        latency_hist_percentile(&pool.service, 50), latency_hist_percentile(&pool.service, 99),
+        pool.service.max_us);
+    pthread_mutex_unlock(&pool.lock);
+
+    // Mismos objetos que "rate_limit" en /status; "sockets" solo existe aquí
+    json[--len] = '\0';
+    len += snprintf(json + len, sizeof(json) - len, ",\"rate_limit\":");
+    rate_limit_stats_t limits;
+    rate_limit_get_stats(&limiter, &limits);
+    len += rate_limit_stats_json(&limits, json + len, sizeof(json) - len);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"sockets\":{\"open\":%d,\"max\":%d,\"purged\":%u}}",
+                    open_sockets, max_sockets, purged);
+
+    send_response(fd, "200 OK", "application/json", "", json, len);
+}
+
+// Bucle de worker_task() de http_workers.c
+static void *worker_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&pool.lock);
+    while (running) {
+        if (pool.count == 0) {
+            pthread_cond_wait(&pool.ready, &pool.lock);
+            continue;
+        }
+        work_item_t item = pool.items[pool.head];
+        pool.head = (pool.head + 1) % MAX_QUEUE;
+        pool.count--;
+        pool.busy++;
+        uint64_t start = now_us();
+        latency_hist_record(&pool.wait, (uint32_t)(start - item.queued_at));
+        pthread_mutex_unlock(&pool.lock);
+
+        int ret = photo_send(item.fd);
+        close(item.fd);
+
+        uint32_t service_us = (uint32_t)(now_us() - start);
+        pthread_mutex_lock(&pool.lock);
+        pool.busy--;
+        pool.completed++;
+        if (ret != 0) {
+            pool.failed++;
+        }
+        latency_hist_record(&pool.service, service_us);
+    }
+    pool.workers--;
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// http_workers_submit(): sin pool se envía en el bucle; con la cola llena, 503
+static void photo_handler(int fd) {
+    if (!admit_client(fd)) {
+        return;
+    }
+    if (pool.workers == 0) {
+        photo_send(fd);
+        close(fd);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    if (pool.count == pool.depth) {
+        pool.rejected++;
+        pthread_mutex_unlock(&pool.lock);
+        const char *busy_msg = "Servidor ocupado, reintentar en unos segundos";
+        send_response(fd, "503 Service Unavailable", "text/plain", "Retry-After: 2\r\n",
+                      busy_msg, strlen(busy_msg));
+        close(fd);
+        return;
+    }
+    pool.items[(pool.head + pool.count) % MAX_QUEUE] = (work_item_t){ .fd = fd, .queued_at = now_us() };
+    pool.count++;
+    pool.submitted++;
+    if (pool.count > pool.max_queued) {
+        pool.max_queued = pool.count;
+    }
+    pthread_cond_signal(&pool.ready);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void handle_request(int fd) {
+    char request[1024];
+    ssize_t n = recv(fd, request, sizeof(request) - 1, 0);
+
+    if (n <= 0) {
+        close(fd);
+        return;
+    }
+    request[n] = '\0';
+    if (strncmp(request, "GET /photo ", 11) == 0) {
+        photo_handler(fd);
+        return;
+    }
+    if (strncmp(request, "GET /status ", 12) == 0) {
+        status_send(fd);
+    } else {
+        const char *msg = "No encontrado";
+        send_response(fd, "404 Not Found", "text/plain", "", msg, strlen(msg));
+    }
+    close(fd);
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+int main(int argc, char **argv) {
+    int port = 8080;
+    int workers = 2;
+    int duration_s = 0;
+    int photo_burst = 0;
+    int photo_per_minute = 0;
+    int opt;
+
+    pool.depth = 8;
+    while ((opt = getopt(argc, argv, "p:w:q:s:b:t:m:lr:")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'w': workers = atoi(optarg); break;
+            case 'q': pool.depth = atoi(optarg); break;
+            case 's': photo_len = (size_t)atol(optarg); break;
+            case 'b': sndbuf = atoi(optarg); break;
+            case 't': duration_s = atoi(optarg); break;
+            case 'm': max_sockets = atoi(optarg); break;
+            case 'l': lru_purge = true; break;
+            case 'r':
+                if (sscanf(optarg, "%d:%d", &photo_burst, &photo_per_minute) != 2) {
+                    photo_burst = -1;
+                }
+                break;
+            default:
+                fprintf(stderr, "uso: %s [-p puerto] [-w tareas] [-q cola] [-s bytes] [-b sndbuf] [-t s] "
+                        "[-m sockets] [-l] [-r ráfaga:por_minuto]\n", argv[0]);
+                return 1;
+        }
+    }
+    rate_limit_config_t limiter_config = {
+        .classes = {
+            [RATE_LIMIT_PHOTO] = { .burst = (uint8_t)photo_burst, .per_minute = (uint16_t)photo_per_minute }
+        }
+    };
+    if (workers < 0 || workers > MAX_WORKERS || pool.depth < 1 || pool.depth > MAX_QUEUE || photo_len == 0 ||
+        max_sockets < 0 || max_sockets >= FD_SETSIZE || photo_burst < 0 || photo_per_minute < 0 ||
+        photo_per_minute > UINT16_MAX || rate_limit_init(&limiter, &limiter_config) != ESP_OK) {
+        fprintf(stderr, "Configuración inválida (0-%d tareas, cola 1-%d, ráfaga 1-%d)\n",
+                MAX_WORKERS, MAX_QUEUE, RATE_LIMIT_MAX_BURST);
+        return 1;
+    }
+    limiter_enabled = photo_per_minute > 0;
+
+    // Contenido irrelevante: solo cuenta el tamaño
+    photo = malloc(photo_len);
+    if (photo == NULL) {
+        return 1;
+    }
+    for (size_t i = 0; i < photo_len; i++) {
+        photo[i] = (uint8_t)(i * 31);
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 64) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGALRM, &sa, NULL);
+    if (duration_s > 0) {
+        alarm(duration_s);
+    }
+
+    pthread_t tids[MAX_WORKERS];
+    pool.workers = workers;
+    for (int i = 0; i < workers; i++) {
+        pthread_create(&tids[i], NULL, worker_thread, NULL);
+    }
+    printf("worker_bench: foto de %zu bytes, %d tareas, cola de %d, puerto %d, "
+           "%d sockets%s, /photo %d+%d/min por IP\n",
+           photo_len, workers, pool.depth, port, max_sockets, lru_purge ? " (LRU)" : "",
+           photo_burst, photo_per_minute);
+    fflush(stdout);
+
+    // Bucle de httpd: sockets con petición pendiente en un select()
+    pending_socket_t pending[FD_SETSIZE];
+    int pending_count = 0;
+
+    while (running) {
+        // Sin hueco, httpd no acepta; con LRU acepta si hay un socket esperando que cerrar
+        open_sockets = pending_count + pool_sockets();
+        bool full = max_sockets > 0 && open_sockets >= max_sockets;
+        bool accepting = !full || (lru_purge && pending_count > 0);
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        int max_fd = -1;
+        if (accepting) {
+            FD_SET(server, &readable);
+            max_fd = server;
+        }
+        for (int i = 0; i < pending_count; i++) {
+            FD_SET(pending[i].fd, &readable);
+            if (pending[i].fd > max_fd) {
+                max_fd = pending[i].fd;
+            }
+        }
+
+        // Sin aceptar, se vuelve a mirar pronto si el pool ha liberado algún socket
+        struct timeval tick = { .tv_sec = 0, .tv_usec = accepting ? 200000 : 20000 };
+        if (select(max_fd + 1, &readable, NULL, NULL, &tick) <= 0) {
+            continue;
+        }
+
+        if (accepting && FD_ISSET(server, &readable)) {
+            int fd = accept(server, NULL, NULL);
+            if (fd >= 0 && full) {
+                int oldest = 0;
+                for (int i = 1; i < pending_count; i++) {
+                    if (pending[i].since < pending[oldest].since) {
+                        oldest = i;
+                    }
+                }
+                close(pending[oldest].fd);
+                pending[oldest] = pending[--pending_count];
+                purged++;
+            }
+            if (fd >= 0 && fd < FD_SETSIZE && pending_count < FD_SETSIZE) {
+                struct timeval timeout = { .tv_sec = SEND_TIMEOUT_S };
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                pending[pending_count++] = (pending_socket_t){ .fd = fd, .since = now_us() };
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        for (int i = 0; i < pending_count; ) {
+            if (FD_ISSET(pending[i].fd, &readable)) {
+                int fd = pending[i].fd;
+                pending[i] = pending[--pending_count];
+                handle_request(fd);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pthread_cond_broadcast(&pool.ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < workers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    close(server);
+
+    printf("pool: %u encoladas, %u rechazadas, %u completadas, espera p99 %u us, servicio p99 %u us\n",
+           pool.submitted, pool.rejected, pool.completed,
+           latency_hist_percentile(&pool.wait, 99), latency_hist_percentile(&pool.service, 99));
+    printf("admisión: %u admitidas, %u rechazadas por IP, %u sockets purgados\n",
+           limiter.stats[RATE_LIMIT_PHOTO].allowed, limiter.stats[RATE_LIMIT_PHOTO].rejected, purged);
+    free(photo);
+    return 0;
+}